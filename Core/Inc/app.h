@@ -0,0 +1,31 @@
+#ifndef APP_H
+#define APP_H
+
+#include <stdint.h>
+
+/*
+ * 心率血氧应用: 传感器读取、算法处理、OLED 显示与串口日志
+ *
+ * 只依赖平台抽象层（platform.h），同一份代码既运行在 STM32 上（main.c 在 CubeMX
+ * 初始化后调用），也可在 Linux 上由模拟外设驱动（host/apps/firmware_sim.c）。
+ *     App_Init();
+ *     while (1) { App_Loop(); }
+ */
+
+// 应用当前的输出（供主机模拟检查结果）
+typedef struct {
+    float heart_rate;               // 最近一次计算的心率
+    float displayed_hr;             // 屏幕显示的心率（方法1为显示平滑后的值）
+    float spo2;                     // 最近一次计算的血氧
+    uint8_t hr_valid;
+    uint8_t spo2_valid;
+    uint32_t samples;               // 已处理的传感器样本数
+    uint32_t lost_samples;          // FIFO溢出丢失的样本数
+    uint32_t updates;               // 心率/血氧计算次数（每250个样本一次）
+} App_Status_t;
+
+void App_Init(void);
+void App_Loop(void);
+void App_GetStatus(App_Status_t *status);
+
+#endif // APP_H
@@ -0,0 +1,28 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+/*
+ * 轻量级整数/定点数格式化（替代 printf/sprintf 的 %f）
+ *
+ * 所有函数把结果写到 dst 并以 '\0' 结尾，返回指向结尾 '\0' 的指针，
+ * 便于链式拼接:
+ *     char *p = fmt_str(buf, "HR:");
+ *     p = fmt_fixed(p, heart_rate, 0, 0, ' ');
+ * width 为最小字段宽度（右对齐，0表示不填充），pad 为填充字符（' ' 或 '0'）。
+ * 使用 '0' 填充时负号位于填充字符之前，与 printf 的 "%05d" 行为一致。
+ * 调用者负责保证 dst 空间足够（整数最多11字符 + width）。
+ */
+#define FMT_MAX_DECIMALS    4      // 定点/浮点格式化支持的最大小数位数
+#define FMT_PLACEHOLDER     "--"   // fmt_fixed 遇到 NaN/无穷大/超出范围时的输出
+
+char *fmt_str(char *dst, const char *s);
+char *fmt_char(char *dst, char c);
+char *fmt_u32(char *dst, uint32_t value, uint8_t width, char pad);
+char *fmt_i32(char *dst, int32_t value, uint8_t width, char pad);
+char *fmt_hex(char *dst, uint32_t value, uint8_t digits);
+char *fmt_q16(char *dst, int32_t q16, uint8_t decimals, uint8_t width, char pad);
+char *fmt_fixed(char *dst, float value, uint8_t decimals, uint8_t width, char pad);
+
+#endif // FMT_H
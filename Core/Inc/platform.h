@@ -0,0 +1,54 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+
+/*
+ * 平台抽象层: 应用（app.c）和外设驱动（lib/oled）只通过这里访问硬件
+ *
+ *   - STM32 后端: Core/Src/platform_stm32.c，基于 HAL（TIM2 微秒延时、TIM3 时间基准、
+ *     I2C1 硬件I2C、USART2、PA10/PA11 软件I2C、PB1 外部中断）
+ *   - Linux 后端: host/src/platform_linux.c，虚拟时间 + 模拟外设（软件I2C引脚上的
+ *     I2C 从机解码、硬件I2C设备、串口输出到 stdout），不等待真实时间，可比实时快得多
+ *
+ * 接口保持与 HAL 调用一一对应的粒度，不做缓冲或调度，STM32 上的行为与时序不变。
+ */
+
+// 应用使用的引脚
+typedef enum {
+    PLATFORM_PIN_I2C_SCL = 0,       // 软件I2C SCL（开漏）
+    PLATFORM_PIN_I2C_SDA,           // 软件I2C SDA（开漏，写1即释放，读到的是总线电平）
+    PLATFORM_PIN_SENSOR_INT,        // MAX30102 INT（低有效，下降沿外部中断）
+    PLATFORM_PIN_COUNT
+} Platform_Pin_t;
+
+typedef void (*Platform_IrqHandler_t)(void);
+
+void Platform_Init(void);
+
+// 时间基准与延时
+uint32_t Platform_GetTickMs(void);
+uint64_t Platform_GetUs(void);
+void Platform_DelayMs(uint32_t ms);
+void Platform_DelayUs(uint16_t us);
+
+// GPIO 与外部中断
+void Platform_GPIO_Write(Platform_Pin_t pin, uint8_t level);
+uint8_t Platform_GPIO_Read(Platform_Pin_t pin);
+void Platform_EXTI_SetHandler(Platform_Pin_t pin, Platform_IrqHandler_t handler);
+
+// 临界区（软件I2C传输期间屏蔽中断）
+void Platform_EnterCritical(void);
+void Platform_ExitCritical(void);
+
+// 硬件I2C（OLED），7位地址
+uint8_t Platform_I2C_Write(uint8_t slave_addr, const uint8_t *data, uint16_t len, uint32_t timeout_ms);
+
+// 串口（日志与遥测帧）
+void Platform_UART_Write(const uint8_t *data, uint16_t len);
+uint8_t Platform_UART_ReadByte(uint8_t *byte);
+
+// 不可恢复的错误: 停机
+void Platform_Halt(void);
+
+#endif // PLATFORM_H
@@ -0,0 +1,75 @@
+#ifndef PPG_ADAPTIVE_H
+#define PPG_ADAPTIVE_H
+
+#include <stdint.h>
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+
+/*
+ * 自适应算法选择: 按信号质量在方法1和DPT之间切换心率引擎（设备与网关共用）
+ *
+ * 方法1每个样本都运行（廉价，并提供信号质量SQI），默认由它给出心率。
+ * DPT 每样本的代价高得多，只在方法1不可靠时才值得: 平时它只作影子
+ * （DPT_ProcessShadow: 滤波+缓冲区，不做变换），缓冲区始终是满的。
+ *
+ * 每次显示更新（250个样本）调用 PPG_Adaptive_Update:
+ *   - 升级到DPT（影子缓冲区已满时）:
+ *       连续 PPG_ADAPTIVE_ESCALATE_UPDATES 次信号有噪声: SQI 为差，或方法1本次
+ *       原始心率与中位数相差超过 PPG_ADAPTIVE_DISAGREE_BPM（逐拍间隔不一致）；
+ *       或连续 PPG_ADAPTIVE_INVALID_UPDATES 次方法1没有有效心率（心率过低时
+ *       1.6秒缓冲区内峰值不足，或刚开始测量）。单次无效很常见，不计入噪声。
+ *     DPT_Resume 后变换直接在已有缓冲区上重启，下一次更新即有DPT结果，
+ *     没有10秒的缓冲等待。
+ *   - 降级回方法1: 方法1连续干净（SQI 为好、没有逐拍不一致、已有心率）
+ *     PPG_ADAPTIVE_RECOVER_UPDATES 次，且其平滑心率与DPT相差不超过
+ *     PPG_ADAPTIVE_AGREE_BPM（DPT无效时不比较）；或连续干净
+ *     PPG_ADAPTIVE_RECOVER_ALONE_UPDATES 次——DPT的限幅在长时间噪声后
+ *     可能停在错误的心率上，不能让它把流永远留在DPT。
+ * 升级比降级快，两者之间留有迟滞，避免在边界上来回切换。
+ *
+ * 负载: may_escalate 由调用方清零时（如网关工作线程超出时间预算）不升级，
+ * 计入 held；条件仍满足时，一旦允许即升级。血氧始终取方法1。
+ */
+
+#define PPG_ADAPTIVE_METHOD1            0
+#define PPG_ADAPTIVE_DPT                1
+#define PPG_ADAPTIVE_ENGINES            2
+
+#define PPG_ADAPTIVE_ESCALATE_UPDATES   2       // 连续几次更新有噪声才升级（5秒）
+#define PPG_ADAPTIVE_INVALID_UPDATES    4       // 连续几次更新方法1无效才升级（10秒）
+#define PPG_ADAPTIVE_RECOVER_UPDATES    4       // 连续几次更新干净且与DPT一致才降级（10秒）
+#define PPG_ADAPTIVE_RECOVER_ALONE_UPDATES 12   // 连续几次更新干净即降级，不论DPT（30秒）
+#define PPG_ADAPTIVE_DISAGREE_BPM       10.0f   // 方法1原始心率与中位数之差（bpm）
+#define PPG_ADAPTIVE_AGREE_BPM          5.0f    // 降级时方法1与DPT心率之差（bpm）
+
+typedef struct {
+    uint8_t engine;                     // 当前心率引擎 PPG_ADAPTIVE_*
+    uint8_t may_escalate;               // 0: 负载过高，暂不升级
+    uint8_t noisy_votes;                // 连续有噪声的更新次数
+    uint8_t invalid_votes;              // 连续方法1无效的更新次数
+    uint8_t recover_votes;              // 方法1连续干净的更新次数
+    uint32_t samples[PPG_ADAPTIVE_ENGINES]; // 各引擎处理的样本数
+    uint32_t escalations;
+    uint32_t deescalations;
+    uint32_t held;                      // 因负载未升级的更新次数
+} PPG_Adaptive_t;
+
+void PPG_Adaptive_Init(PPG_Adaptive_t *a);
+
+/**
+ * @brief 每个样本调用一次（方法1自身的处理由调用方完成）
+ * @details DPT 为当前引擎时 DPT_Process，否则 DPT_ProcessShadow
+ */
+void PPG_Adaptive_Process(PPG_Adaptive_t *a, DPT_State_t *dpt, uint32_t raw_red, uint32_t raw_ir);
+
+/**
+ * @brief 每次显示更新、HR_Calculate 之后调用，可能切换引擎
+ * @return 本次更新起使用的心率引擎
+ */
+uint8_t PPG_Adaptive_Update(PPG_Adaptive_t *a, HR_State_t *hr, DPT_State_t *dpt);
+
+static inline uint8_t PPG_Adaptive_GetEngine(const PPG_Adaptive_t *a) {
+    return a->engine;
+}
+
+#endif // PPG_ADAPTIVE_H
@@ -2,12 +2,16 @@
 #define PPG_ALGORITHM_H
 
 #include <stdint.h>
+#include "ppg_params.h"
 
 // 心率计算配置
+#define HR_SAMPLE_RATE_HZ   100.0f // 标称采样率，实际值由 HR_SetSampleRate 更新
 #define HR_BUFFER_SIZE      160    // 心率计算缓冲区大小（160个样本 = 1.6秒@100Hz，进一步减少内存）
 #define MIN_PEAK_DISTANCE   40     // 峰值之间最小距离（样本数），对应最大心率150bpm
 #define MAX_PEAK_DISTANCE   160    // 峰值之间最大距离（样本数），对应最小心率37.5bpm
-#define PEAK_THRESHOLD      0.5f   // 峰值检测阈值系数（相对于标准差）
+#define PEAK_THRESHOLD_GOOD 0.4f   // 峰值检测阈值系数（均值 + 系数 x 标准差），信号质量好
+#define PEAK_THRESHOLD      0.5f   // 信号质量中等
+#define PEAK_THRESHOLD_POOR 0.6f   // 信号质量差
 
 // 信号质量评估参数
 #define MIN_AC_DC_RATIO     0.01f  // 最小AC/DC比值，用于信号质量评估
@@ -20,6 +24,10 @@
 #define MAX_HR_CHANGE      6.0f    // 单次最大心率变化（bpm），防止突变
 #define INVALID_RESET_THRESHOLD 2 // 无效信号重置阈值（连续无效次数）
 
+// 显示平滑参数（OLED显示值，每次 HR_Calculate 之后更新）
+#define DISPLAY_EMA_ALPHA    0.1f  // 显示值EMA平滑系数
+#define DISPLAY_HR_THRESHOLD 2.0f  // 心率与显示值相差超过该值（bpm）才更新显示
+
 // 心率计算状态结构体
 typedef struct {
     float buffer[HR_BUFFER_SIZE];       // AC信号缓冲区
@@ -46,9 +54,17 @@ typedef struct {
     uint8_t hr_history_count;
 
     float last_hr;                       // 上次计算的心率
+    float raw_hr;                        // 最近一次由峰值间隔换算的心率（中位数滤波前）
+    float median_hr;                     // 最近一次中位数滤波后的心率
+    float limited_hr;                    // 最近一次变化率限制后的心率（EMA输入）
     float ema_hr;                        // EMA平滑后的心率
     uint8_t hr_valid;                    // 心率是否有效
     uint8_t stable_count;                // 稳定计数器
+
+    float sample_rate_hz;                // 实际采样率（样本间隔 -> 心率的换算）
+#ifdef PPG_TUNABLE_PARAMS
+    PPG_Params_t params;                 // 调参常量（ppg_params.h）
+#endif
 } HR_State_t;
 
 // 血氧计算状态结构体
@@ -68,6 +84,11 @@ float HR_Calculate(HR_State_t *hr_state);
 uint8_t HR_IsValid(HR_State_t *hr_state);
 uint8_t HR_GetSignalQuality(HR_State_t *hr_state);
 void HR_Reset(HR_State_t *hr_state);
+void HR_SetSampleRate(HR_State_t *hr_state, float sample_rate_hz);
+float HR_DisplaySmooth(float displayed_hr, float heart_rate);
+#ifdef PPG_TUNABLE_PARAMS
+void HR_SetParams(HR_State_t *hr_state, const PPG_Params_t *params);
+#endif
 
 void SpO2_Init(SpO2_State_t *spo2_state);
 float SpO2_Calculate(SpO2_State_t *spo2_state, float red_ac_rms, float red_dc,
@@ -17,11 +17,12 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "ppg_params.h"
 
 /* ==================== Configuration Parameters ==================== */
 
 // Sampling parameters
-#define DPT_SAMPLE_RATE_HZ      100         // 100 Hz sampling rate
+#define DPT_SAMPLE_RATE_HZ      100         // 100 Hz nominal sampling rate (see DPT_SetSampleRate)
 #define DPT_SAMPLE_PERIOD_MS    10          // 10 ms per sample
 
 // Period range (in samples)
@@ -39,6 +40,9 @@ extern "C" {
 #define DPT_HR_EMA_ALPHA        0.15f       // EMA smoothing coefficient for HR
 #define DPT_MAX_HR_CHANGE       8.0f        // Maximum HR change per update (bpm)
 
+// Peak detection
+#define DPT_MIN_PEAK_MAGNITUDE  0.5f        // Minimum spectrum peak (lowered after normalization)
+
 /* ==================== Data Structures ==================== */
 
 /**
@@ -86,6 +90,12 @@ typedef struct {
     float heart_rate;           // Current heart rate (bpm)
     float spo2;                 // Current SpO2 (%)
     uint16_t peak_period;       // Peak period in samples
+    float sample_rate_hz;       // Measured sensor sample rate used to convert periods to bpm
+
+    // Intermediate HR of the last accepted update, one per smoothing stage
+    float raw_hr;               // From peak_period, before the median filter
+    float median_hr;            // After the median filter
+    float limited_hr;           // After rate limiting (EMA input)
 
     // EMA and stability
     float ema_hr;               // EMA smoothed heart rate
@@ -104,6 +114,9 @@ typedef struct {
     bool hr_valid;
     bool spo2_valid;
 
+#ifdef PPG_TUNABLE_PARAMS
+    PPG_Params_t params;        // Tuning constants (ppg_params.h)
+#endif
 } DPT_State_t;
 
 /* ==================== Function Prototypes ==================== */
@@ -122,6 +135,45 @@ void DPT_Init(DPT_State_t *state);
  */
 void DPT_Process(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir);
 
+/**
+ * @brief Shadow step: filter one sample and buffer it, without the transform
+ * @details Keeps a DPT that is not needed right now warm at a fraction of the
+ *          cost of DPT_Process: the IIR filters track the signal and the
+ *          buffer keeps filling, so DPT_Resume can take over at once instead
+ *          of after 10 s of buffering. The results are invalid until then.
+ * @param state Pointer to DPT state structure
+ * @param raw_red Raw red LED ADC value
+ * @param raw_ir Raw infrared LED ADC value
+ */
+void DPT_ProcessShadow(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir);
+
+/**
+ * @brief Switch from DPT_ProcessShadow back to DPT_Process
+ * @details Clears the spectra and the heart rate / SpO2 smoothing; with the
+ *          buffer already full the transform restarts on it at the next
+ *          DPT_Process, as a freshly filled one does. Filters, buffer,
+ *          sample rate and parameters are kept.
+ * @param state Pointer to DPT state structure
+ */
+void DPT_Resume(DPT_State_t *state);
+
+/**
+ * @brief Check whether the sample buffers are full (the transform can run)
+ * @param state Pointer to DPT state structure
+ * @return true if full, false otherwise
+ */
+bool DPT_IsBufferFull(const DPT_State_t *state);
+
+/**
+ * @brief Set the measured sensor sample rate
+ * @details The MAX30102 oscillator is only accurate to about +/-1%, so the
+ *          nominal 100 Hz gives a proportional heart rate error. Non-positive
+ *          values are ignored.
+ * @param state Pointer to DPT state structure
+ * @param sample_rate_hz Sample rate in Hz
+ */
+void DPT_SetSampleRate(DPT_State_t *state, float sample_rate_hz);
+
 /**
  * @brief Get calculated heart rate
  * @param state Pointer to DPT state structure
@@ -165,6 +217,15 @@ const float* DPT_GetSpectrum(const DPT_State_t *state, uint8_t channel);
  */
 uint16_t DPT_GetPeakPeriod(const DPT_State_t *state);
 
+#ifdef PPG_TUNABLE_PARAMS
+/**
+ * @brief Replace the tuning constants (host parameter sweeps, see ppg_params.h)
+ * @param state Pointer to DPT state structure (after DPT_Init)
+ * @param params Parameters to use
+ */
+void DPT_SetParams(DPT_State_t *state, const PPG_Params_t *params);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,87 @@
+#ifndef PPG_CODEC_H
+#define PPG_CODEC_H
+
+#include <stdint.h>
+#include "telemetry.h"
+
+/*
+ * 原始PPG无损压缩（红光/红外两通道，18位样本）
+ *
+ * 每个块最多 PPG_CODEC_BLOCK_SIZE 个样本对，按字节对齐、自定界:
+ *   块头 17 bit: KEY(1) COUNT-1(4) | RED: ORDER-1(1) K(5) | IR: ORDER-1(1) K(5)
+ *   KEY=1 时: RED首样本(18) IR首样本(18) 原样写入，预测器历史由其重置
+ *   随后先红光、后红外，依次写入各样本预测残差的 Rice 码
+ * 预测器: 一阶 x[n-1] 或二阶 2x[n-1]-x[n-2]，按块、按通道择优；
+ * 残差先 zigzag 映射为无符号数，再用自适应参数 K 做 Rice 编码。
+ * 商 >= PPG_CODEC_RICE_ESCAPE 时写 ESCAPE 个 1 后跟 PPG_CODEC_RAW_BITS 位原值。
+ */
+#define PPG_CODEC_BLOCK_SIZE        16     // 每块样本对数
+#define PPG_CODEC_SAMPLE_BITS       18     // MAX30102 ADC 位数
+#define PPG_CODEC_SAMPLE_MASK       0x3FFFFu
+#define PPG_CODEC_MAX_K             19     // Rice 参数上限
+#define PPG_CODEC_RICE_ESCAPE       16     // 商达到该值即转义
+#define PPG_CODEC_RAW_BITS          20     // 转义时残差原值位数（二阶残差 zigzag 后 < 2^20）
+#define PPG_CODEC_KEYFRAME_INTERVAL 32     // 每隔多少块插入一个关键块（约5秒@100Hz）
+
+// 最坏情况下一个块的字节数
+#define PPG_CODEC_MAX_BLOCK_BYTES \
+    ((17 + 2 * PPG_CODEC_SAMPLE_BITS + \
+      2 * PPG_CODEC_BLOCK_SIZE * (PPG_CODEC_RICE_ESCAPE + PPG_CODEC_RAW_BITS) + 7) / 8)
+
+// 遥测帧载荷: FIRST_INDEX(4, LE) BLOCK_COUNT(1) BLOCK...
+#define PPG_CAPTURE_FRAME_HEADER    5
+#define PPG_CAPTURE_BLOCKS_PER_FRAME 8     // 每帧块数（128个样本对 = 1.28秒@100Hz）
+
+// 单通道预测器历史
+typedef struct {
+    int32_t h1;                         // x[n-1]
+    int32_t h2;                         // x[n-2]
+} PPG_CodecChannel_t;
+
+// 编码器状态
+typedef struct {
+    uint32_t red[PPG_CODEC_BLOCK_SIZE]; // 待编码的红光样本
+    uint32_t ir[PPG_CODEC_BLOCK_SIZE];  // 待编码的红外样本
+    uint8_t count;                      // 当前块已缓存样本数
+    uint8_t force_key;                  // 下一个块强制为关键块
+    uint16_t blocks_since_key;          // 距上一个关键块的块数
+    PPG_CodecChannel_t ch[2];           // 0=红光, 1=红外
+} PPG_Encoder_t;
+
+// 解码器状态
+typedef struct {
+    PPG_CodecChannel_t ch[2];
+    uint8_t synced;                     // 已收到关键块，可以解码差分块
+} PPG_Decoder_t;
+
+// 采集模式: 编码器 + 遥测帧打包
+typedef struct {
+    PPG_Encoder_t enc;
+    uint8_t frame[TLM_MAX_PAYLOAD];     // 当前帧载荷
+    uint16_t frame_len;                 // 当前帧已写入字节数
+    uint8_t frame_blocks;               // 当前帧已写入块数
+    uint32_t sample_index;              // 下一个样本的全局序号
+    uint32_t frame_first_index;         // 当前帧第一个样本的序号
+
+    // 统计
+    uint32_t bytes_out;                 // 已发送的载荷字节数
+    uint32_t samples_out;               // 已发送的样本对数
+} PPG_Capture_t;
+
+// 编码器
+void PPG_Encoder_Init(PPG_Encoder_t *enc);
+uint8_t PPG_Encoder_Push(PPG_Encoder_t *enc, uint32_t red, uint32_t ir);
+uint16_t PPG_Encoder_Flush(PPG_Encoder_t *enc, uint8_t *out, uint16_t capacity);
+void PPG_Encoder_ForceKeyframe(PPG_Encoder_t *enc);
+
+// 解码器
+void PPG_Decoder_Init(PPG_Decoder_t *dec);
+int16_t PPG_Decoder_DecodeBlock(PPG_Decoder_t *dec, const uint8_t *in, uint16_t len,
+                                uint32_t *red, uint32_t *ir, uint8_t *count);
+
+// 采集模式（通过 telemetry 发送 TLM_TYPE_RAW_PPG 帧）
+void PPG_Capture_Init(PPG_Capture_t *cap);
+void PPG_Capture_Push(PPG_Capture_t *cap, uint32_t red, uint32_t ir);
+void PPG_Capture_Flush(PPG_Capture_t *cap);
+
+#endif // PPG_CODEC_H
@@ -0,0 +1,47 @@
+#ifndef PPG_PARAMS_H
+#define PPG_PARAMS_H
+
+#include <stdint.h>
+
+/*
+ * 算法调参常量（运行时参数结构体）
+ *
+ * 心率算法中手工整定的常量（ppg_algorithm.h / ppg_algorithm_v2.h 中的宏）
+ * 在算法代码里统一通过 PPG_PARAM 读取：
+ *     float alpha = PPG_PARAM(hr_state, hr_ema_alpha, HR_EMA_ALPHA);
+ *
+ * 固件构建（未定义 PPG_TUNABLE_PARAMS）时 PPG_PARAM 直接展开为宏常量，
+ * 状态结构体中没有参数字段，生成的代码与使用字面常量完全相同。
+ * 主机调参工具（host/apps/ppg_sweep）定义 PPG_TUNABLE_PARAMS 编译算法源文件，
+ * 此时参数保存在 HR_State_t / DPT_State_t 中（按值，状态块仍可直接复制），
+ * Init 时取默认值，HR_SetParams / DPT_SetParams 替换为候选值。
+ * 搜索得到的参数写回对应的宏即可用于固件。
+ */
+
+typedef struct {
+    // 方法1（ppg_algorithm.c）
+    float peak_threshold_good;          // 信号质量好时的峰值阈值系数（PEAK_THRESHOLD_GOOD）
+    float peak_threshold;               // 信号质量中等（PEAK_THRESHOLD）
+    float peak_threshold_poor;          // 信号质量差（PEAK_THRESHOLD_POOR）
+    float hr_ema_alpha;                 // HR_EMA_ALPHA
+    float max_hr_change;                // MAX_HR_CHANGE
+    uint8_t invalid_reset_threshold;    // INVALID_RESET_THRESHOLD
+    // 方法2（ppg_algorithm_v2.c）
+    float dpt_hr_ema_alpha;             // DPT_HR_EMA_ALPHA
+    float dpt_max_hr_change;            // DPT_MAX_HR_CHANGE
+    float dpt_min_peak_magnitude;       // DPT_MIN_PEAK_MAGNITUDE
+} PPG_Params_t;
+
+// 与宏常量一致的默认值（需先包含 ppg_algorithm.h 和 ppg_algorithm_v2.h）
+#define PPG_PARAMS_DEFAULT { \
+    PEAK_THRESHOLD_GOOD, PEAK_THRESHOLD, PEAK_THRESHOLD_POOR, \
+    HR_EMA_ALPHA, MAX_HR_CHANGE, INVALID_RESET_THRESHOLD, \
+    DPT_HR_EMA_ALPHA, DPT_MAX_HR_CHANGE, DPT_MIN_PEAK_MAGNITUDE }
+
+#ifdef PPG_TUNABLE_PARAMS
+#define PPG_PARAM(state, field, constant)   ((state)->params.field)
+#else
+#define PPG_PARAM(state, field, constant)   (constant)
+#endif
+
+#endif // PPG_PARAMS_H
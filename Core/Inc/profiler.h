@@ -0,0 +1,103 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+/*
+ * 基于 DWT CYCCNT 的分阶段周期计数器
+ *
+ * 用法:
+ *     PROF_BEGIN(PROF_STAGE_FILTER);
+ *     ac_ir = PPG_Filter_Process(&ir_filter, raw_ir);
+ *     PROF_END(PROF_STAGE_FILTER);
+ * 每个阶段累计调用次数、总周期、最小/最大值和粗粒度直方图，
+ * PROF_POLL() 每隔 PROF_REPORT_INTERVAL_MS 通过遥测帧 (TLM_TYPE_PROFILE)
+ * 发送一次报告并清零统计，主机端用 host/apps/prof_report 查看。
+ *
+ * 未定义 PROFILER_ENABLED（或为0）时所有宏展开为空，不占用任何代码和RAM。
+ * 固件构建时通过 CMake 选项 -DENABLE_PROFILER=ON 打开。
+ */
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+// 被测阶段（新增阶段时同步更新 profiler.c 中的名称表）
+typedef enum {
+    PROF_STAGE_FIFO_READ = 0,           // MAX30102_ReadFifo
+    PROF_STAGE_FILTER,                  // PPG_Filter_Process（红光+红外）
+    PROF_STAGE_HR_ADD,                  // HR_AddSample
+    PROF_STAGE_HR_CALC,                 // HR_Calculate
+    PROF_STAGE_SPO2_CALC,               // SpO2_Calculate
+    PROF_STAGE_DPT_PROCESS,             // DPT_Process
+    PROF_STAGE_OLED_REFRESH,            // OLED_Refresh
+    PROF_STAGE_LOOP,                    // 主循环一次迭代
+    PROF_STAGE_COUNT
+} PROF_Stage_t;
+
+#define PROF_HIST_BINS              8      // 直方图: <256, <1K, <4K, <16K, <64K, <256K, <1M, >=1M 周期
+#define PROF_REPORT_INTERVAL_MS     5000   // 报告周期
+#define PROF_REPORT_VERSION         1
+
+// 报告帧载荷: VERSION(1) CPU_HZ(4) INTERVAL_MS(4) STAGES(1) 然后每个阶段:
+//   ID(1) COUNT(4) TOTAL(4) MIN(4) MAX(4) HIST(2 x PROF_HIST_BINS)
+#define PROF_REPORT_HEADER          10
+#define PROF_REPORT_STAGE_SIZE      (17 + 2 * PROF_HIST_BINS)
+#define PROF_STAGES_PER_FRAME       4      // 每帧最多携带的阶段数（受 TLM_MAX_PAYLOAD 限制）
+
+// 单阶段统计
+typedef struct {
+    uint32_t count;                     // 调用次数
+    uint32_t total;                     // 总周期数（报告周期内）
+    uint32_t min;                       // 最小周期数
+    uint32_t max;                       // 最大周期数
+    uint16_t hist[PROF_HIST_BINS];      // 周期数分布（饱和计数）
+} PROF_StageStats_t;
+
+// 解码后的报告（主机端使用）
+typedef struct {
+    uint32_t cpu_hz;
+    uint32_t interval_ms;
+    uint8_t stage_count;
+    uint8_t stage_id[PROF_STAGE_COUNT];
+    PROF_StageStats_t stages[PROF_STAGE_COUNT];
+} PROF_Report_t;
+
+#if PROFILER_ENABLED
+
+#ifdef PROFILER_HOST
+// 主机测试: 由测试程序提供周期计数源
+uint32_t PROF_HostCycles(void);
+#define PROF_NOW()                  PROF_HostCycles()
+#else
+#include "stm32f1xx.h"
+#define PROF_NOW()                  (DWT->CYCCNT)
+#endif
+
+#define PROF_INIT()                 PROF_Init()
+#define PROF_BEGIN(stage)           uint32_t prof_start_##stage = PROF_NOW()
+#define PROF_END(stage)             PROF_Record((stage), PROF_NOW() - prof_start_##stage)
+#define PROF_POLL(now_ms)           PROF_Poll(now_ms)
+
+void PROF_Init(void);
+void PROF_Record(PROF_Stage_t stage, uint32_t cycles);
+void PROF_Reset(void);
+void PROF_Poll(uint32_t now_ms);
+uint8_t PROF_Report(void);
+const PROF_StageStats_t *PROF_GetStats(PROF_Stage_t stage);
+uint32_t PROF_GetOverhead(void);
+
+#else
+
+#define PROF_INIT()                 do { } while (0)
+#define PROF_BEGIN(stage)           do { } while (0)
+#define PROF_END(stage)             do { } while (0)
+#define PROF_POLL(now_ms)           do { } while (0)
+
+#endif // PROFILER_ENABLED
+
+// 报告解码与阶段名称（主机端使用，不依赖 PROFILER_ENABLED）
+uint8_t PROF_DecodeReport(const uint8_t *payload, uint16_t len, PROF_Report_t *report);
+const char *PROF_StageName(uint8_t stage);
+uint8_t PROF_HistBin(uint32_t cycles);
+
+#endif // PROFILER_H
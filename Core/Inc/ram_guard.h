@@ -0,0 +1,41 @@
+#ifndef RAM_GUARD_H
+#define RAM_GUARD_H
+
+#include <stdint.h>
+
+/*
+ * RAM 预算监控: 栈填充 + 高水位查询 + 栈底保护字
+ *
+ * 栈区为链接脚本保留的 [_estack - _Min_Stack_Size, _estack)。
+ * 上电后 RamGuard_Init() 在栈区最低处写入 RAM_GUARD_CANARY_WORDS 个保护字，
+ * 其余未使用部分填充 RAM_GUARD_PAINT。之后：
+ *   - RamGuard_StackPeak(): 从栈底向上找到第一个被改写的字，得到运行以来的栈使用峰值
+ *   - RamGuard_CanaryIntact(): 保护字被改写说明栈已超出保留大小（即将破坏堆/.bss），
+ *     主循环每次迭代检查一次
+ *
+ * 算法状态（DPT_State_t 约13KB、滤波器、HR_State_t 等）用 RAM_STATIC 放入
+ * .bss.ram_static 段（链接脚本将其排在 .bss 开头并导出 _sram_static/_eram_static），
+ * 而不是 main() 的栈上：状态变大时链接阶段就会报 RAM 不足，构建后的
+ * map 报告（scripts/map_report.py）也能按模块列出占用，而不是运行时栈溢出进 HardFault。
+ */
+
+#define RAM_GUARD_PAINT             0xA5A5A5A5u // 未使用栈的填充图案
+#define RAM_GUARD_CANARY            0x5AFE57ACu // 栈底保护字
+#define RAM_GUARD_CANARY_WORDS      8           // 保护字数量（32字节，容忍小幅越界写也能发现）
+#define RAM_GUARD_SP_MARGIN_WORDS   16          // 填充时在当前SP下方保留的字数（填充函数自身的栈帧）
+#define RAM_GUARD_REPORT_MS         10000       // 主循环输出栈峰值的间隔
+
+// 显式静态段: 状态变量放入 .bss（启动时清零），在 map 文件中单独列出
+#define RAM_STATIC __attribute__((section(".bss.ram_static")))
+
+void RamGuard_Setup(uint32_t *stack_bottom, uint32_t *stack_top, uint32_t *paint_end);
+
+#ifndef RAM_GUARD_HOST
+void RamGuard_Init(void);
+#endif
+
+uint8_t RamGuard_CanaryIntact(void);
+uint32_t RamGuard_StackPeak(void);
+uint32_t RamGuard_StackSize(void);
+
+#endif // RAM_GUARD_H
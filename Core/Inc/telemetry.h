@@ -0,0 +1,59 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/*
+ * 二进制遥测帧格式（小端）:
+ *   SYNC0(0xA5) SYNC1(0x5A) TYPE(1) SEQ(1) LEN(2) PAYLOAD(LEN) CRC16(2)
+ * CRC16-CCITT (poly 0x1021, init 0xFFFF) 覆盖 TYPE..PAYLOAD。
+ * 帧可以与 printf 文本混在同一串口上，接收端靠同步字 + CRC 重新同步。
+ */
+#define TLM_SYNC0               0xA5
+#define TLM_SYNC1               0x5A
+#define TLM_HEADER_SIZE         6      // SYNC0 SYNC1 TYPE SEQ LEN_L LEN_H
+#define TLM_CRC_SIZE            2
+#define TLM_MAX_PAYLOAD         256    // 单帧最大载荷（字节）
+#define TLM_FRAME_OVERHEAD      (TLM_HEADER_SIZE + TLM_CRC_SIZE)
+
+// 帧类型
+typedef enum {
+    TLM_TYPE_RAW_PPG = 0x01,           // 无损压缩的原始红光/红外样本（ppg_codec）
+    TLM_TYPE_TREND_LOG = 0x02,         // Flash趋势记录页数据（trend_log）
+    TLM_TYPE_PROFILE = 0x03,           // 分阶段周期统计报告（profiler）
+    TLM_TYPE_TRACE = 0x04,             // 事件追踪缓冲区导出（trace）
+} TLM_FrameType_t;
+
+// 底层发送函数（例如 HAL_UART_Transmit 的包装）
+typedef void (*TLM_TxFunc_t)(const uint8_t *data, uint16_t len);
+
+// 接收端增量解析器状态
+typedef struct {
+    uint8_t  state;                    // 解析状态机
+    uint8_t  type;                     // 当前帧类型
+    uint8_t  seq;                      // 当前帧序号
+    uint16_t len;                      // 当前帧载荷长度
+    uint16_t pos;                      // 已接收载荷字节数
+    uint16_t crc;                      // 运行中的CRC
+    uint8_t  crc_rx[TLM_CRC_SIZE];     // 接收到的CRC字节
+    uint8_t  payload[TLM_MAX_PAYLOAD]; // 载荷缓冲区
+
+    // 统计
+    uint32_t frames_ok;                // CRC正确的帧数
+    uint32_t crc_errors;               // CRC错误的帧数
+    uint32_t bytes_skipped;            // 同步过程中丢弃的字节数
+} TLM_Parser_t;
+
+// 发送端
+void TLM_Init(TLM_TxFunc_t tx);
+uint8_t TLM_Send(uint8_t type, const uint8_t *payload, uint16_t len);
+
+// 接收端（主机或设备均可使用）
+void TLM_Parser_Init(TLM_Parser_t *parser);
+uint8_t TLM_Parser_Feed(TLM_Parser_t *parser, uint8_t byte);
+uint8_t TLM_Parser_Idle(const TLM_Parser_t *parser);
+
+// 工具函数
+uint16_t TLM_CRC16(uint16_t crc, const uint8_t *data, uint16_t len);
+
+#endif // TELEMETRY_H
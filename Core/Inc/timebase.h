@@ -0,0 +1,63 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+/*
+ * 64位单调微秒时间基准 + 传感器采样率在线估计
+ *
+ * 时间基准: TIM3 以 1MHz 自由计数（16位），更新中断累加溢出次数，
+ *   组合为 64 位微秒时间。TIM2 仍专用于 delay_us()（每次调用都会清零计数器，
+ *   不能兼作时钟）；DWT CYCCNT 会被 profiler 清零，也不用作时间基准。
+ *
+ * 采样时钟: MAX30102 内部振荡器有约 ±1% 的偏差，实际采样率并不精确等于 100Hz。
+ *   每次突发读取 FIFO 时记录到达时间和样本数，在较长窗口（SAMPLE_CLOCK_WINDOW_US）
+ *   内用 样本数/经过时间 估计实际采样率，窗口越长，主循环延迟抖动的影响越小。
+ *   每个样本的时间戳由突发到达时间向前按估计的采样周期推算。
+ */
+
+#define TIMEBASE_TICKS_PER_OVERFLOW     65536u      // TIM3 16位计数，1us/计数
+
+#define SAMPLE_CLOCK_NOMINAL_HZ         100.0f      // 配置的采样率（SPO2_SR=100Hz）
+#define SAMPLE_CLOCK_MAX_DEVIATION      0.05f       // 超出标称值 ±5% 的估计视为无效
+#define SAMPLE_CLOCK_WINDOW_US          30000000u   // 估计窗口 30秒（延迟抖动100ms时误差约0.3%）
+#define SAMPLE_CLOCK_EMA_ALPHA          0.5f        // 窗口估计值之间的平滑系数
+
+// 采样时钟估计状态
+typedef struct {
+    uint64_t window_start_us;           // 当前窗口起点（某次突发的到达时间）
+    uint32_t window_samples;            // 窗口起点之后到达的样本数（含溢出丢失的）
+    uint64_t last_sample_us;            // 最近一个样本的时间戳（保证单调）
+    float rate_hz;                      // 估计的采样率
+    float period_us;                    // 估计的采样周期
+    uint8_t started;                    // 已收到第一次突发
+    uint8_t valid;                      // 至少完成一个有效窗口
+} SampleClock_t;
+
+/**
+ * @brief 由溢出计数和计数器值组合64位时间
+ * @param overflows 已计入的溢出次数
+ * @param count 计数器当前值
+ * @param overflow_pending 读取时溢出标志已置位但中断尚未处理
+ */
+static inline uint64_t Timebase_Compose(uint32_t overflows, uint16_t count, uint8_t overflow_pending) {
+    // 标志已置位且计数值较小: 计数器在读取前已回绕，需补上这次溢出
+    if (overflow_pending && count < TIMEBASE_TICKS_PER_OVERFLOW / 2) {
+        overflows++;
+    }
+    return ((uint64_t)overflows << 16) | count;
+}
+
+#ifndef TIMEBASE_HOST
+void Timebase_Init(void);
+uint64_t Timebase_GetUs(void);
+void Timebase_OverflowISR(void);
+#endif
+
+void SampleClock_Init(SampleClock_t *clk);
+uint8_t SampleClock_AddBurst(SampleClock_t *clk, uint64_t arrival_us, uint8_t count, uint8_t lost);
+uint64_t SampleClock_SampleTime(SampleClock_t *clk, uint64_t arrival_us, uint8_t count, uint8_t index);
+float SampleClock_GetRate(const SampleClock_t *clk);
+uint8_t SampleClock_IsValid(const SampleClock_t *clk);
+
+#endif // TIMEBASE_H
@@ -0,0 +1,147 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/*
+ * RAM事件追踪环形缓冲区
+ *
+ * 每条记录为 时间戳(DWT CYCCNT) + 事件ID + 32位参数，写满后覆盖最旧的记录。
+ * 记录操作是头文件中的内联函数（关中断写12字节，约20个周期），可在中断中使用。
+ *     TRACE_EVENT(TRACE_EV_HR_UPDATE, (uint32_t)(heart_rate * 10.0f));
+ * Trace_Dump() 通过遥测帧 (TLM_TYPE_TRACE) 按时间顺序导出缓冲区，触发方式:
+ *   - 串口收到字符 'T'（按需）
+ *   - 主循环单次迭代超过 TRACE_STALL_MS（卡顿）
+ *   - HardFault（导出后冻结缓冲区）
+ * 主机端用 host/apps/trace_export 转换为 Chrome/Perfetto 的 trace JSON。
+ *
+ * 未定义 TRACE_ENABLED（或为0）时 TRACE_EVENT 展开为空，不占用任何代码和RAM。
+ * 固件构建时通过 CMake 选项 -DENABLE_TRACE=ON 打开。
+ */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE           64      // 记录条数（2的幂），每条12字节
+#endif
+#define TRACE_STALL_MS              100     // 主循环卡顿阈值
+
+#if (TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) != 0
+#error "TRACE_BUFFER_SIZE must be a power of two"
+#endif
+
+// 事件ID（新增事件时同步更新 trace.c 中的名称/类型表）
+typedef enum {
+    TRACE_EV_NONE = 0,
+    TRACE_EV_FIFO_READ_BEGIN,       // 读取传感器FIFO开始
+    TRACE_EV_FIFO_READ_END,         // 读取结束，arg=读出的样本数
+    TRACE_EV_OVERRUN,               // 传感器FIFO溢出，arg=丢失的样本数
+    TRACE_EV_SENSOR_IRQ,            // MAX30102中断引脚触发
+    TRACE_EV_BEAT,                  // 检测到心跳峰值，arg=峰值在心率缓冲区中的位置
+    TRACE_EV_HR_UPDATE,             // 心率更新，arg=心率x10
+    TRACE_EV_SPO2_UPDATE,           // 血氧更新，arg=血氧x10
+    TRACE_EV_OLED_FRAME_BEGIN,      // OLED绘制+刷新开始
+    TRACE_EV_OLED_FRAME_END,        // OLED绘制+刷新结束
+    TRACE_EV_OLED_PAGE,             // OLED一页(128字节)已发送，arg=页号
+    TRACE_EV_AGC_STEP,              // LED电流调整，arg=(红光<<8)|红外 电流寄存器值
+    TRACE_EV_STALL,                 // 主循环卡顿，arg=本次迭代耗时(ms)
+    TRACE_EV_FAULT,                 // 异常，arg=TRACE_REASON_*
+    TRACE_EV_MARK,                  // 通用标记，arg自定义
+    TRACE_EV_COUNT
+} Trace_EventId_t;
+
+// 导出原因
+#define TRACE_REASON_REQUEST        0       // 按需（串口命令）
+#define TRACE_REASON_STALL          1       // 主循环卡顿
+#define TRACE_REASON_HARDFAULT      2       // HardFault
+#define TRACE_REASON_STACK          3       // 栈底保护字被改写（ram_guard.h）
+
+// 导出帧载荷: VERSION(1) REASON(1) DUMP_ID(2) CPU_HZ(4) TOTAL(2) FIRST(2) WRITTEN(4)
+//   然后每条记录: TIMESTAMP(4) ID(1) ARG(4)，按时间顺序，FIRST为本帧首条记录的序号
+#define TRACE_DUMP_VERSION          1
+#define TRACE_DUMP_HEADER           16
+#define TRACE_WIRE_RECORD_SIZE      9
+#define TRACE_RECORDS_PER_FRAME     24      // 16 + 24*9 = 232 字节 <= TLM_MAX_PAYLOAD
+
+// 缓冲区中的一条记录
+typedef struct {
+    uint32_t timestamp;             // DWT CYCCNT
+    uint32_t arg;
+    uint8_t id;                     // Trace_EventId_t
+} Trace_Record_t;
+
+typedef struct {
+    Trace_Record_t records[TRACE_BUFFER_SIZE];
+    volatile uint32_t written;      // 累计写入的记录数（head = written % SIZE）
+    volatile uint8_t frozen;        // 置位后不再记录（导出期间、异常导出后保留现场）
+} Trace_Buffer_t;
+
+// 解码后的一帧导出数据（主机端使用）
+typedef struct {
+    uint8_t reason;
+    uint16_t dump_id;
+    uint32_t cpu_hz;
+    uint16_t total;                 // 本次导出的记录总数
+    uint16_t first;                 // 本帧首条记录序号
+    uint32_t written;               // 导出时累计写入的记录数（大于total说明有覆盖）
+    uint8_t count;                  // 本帧记录数
+    Trace_Record_t records[TRACE_RECORDS_PER_FRAME];
+} Trace_DumpFrame_t;
+
+#if TRACE_ENABLED
+
+#ifdef TRACE_HOST
+// 主机测试: 由测试程序提供时间戳
+uint32_t Trace_HostCycles(void);
+#define TRACE_NOW()                 Trace_HostCycles()
+#define TRACE_IRQ_SAVE()            0u
+#define TRACE_IRQ_RESTORE(state)    ((void)(state))
+#else
+#include "stm32f1xx.h"
+#define TRACE_NOW()                 (DWT->CYCCNT)
+#define TRACE_IRQ_SAVE()            trace_irq_save()
+#define TRACE_IRQ_RESTORE(state)    __set_PRIMASK(state)
+
+static inline uint32_t trace_irq_save(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+#endif
+
+extern Trace_Buffer_t trace_buffer;
+
+/**
+ * @brief 记录一条事件（可在中断中调用）
+ */
+static inline void Trace_Record(uint8_t id, uint32_t arg) {
+    uint32_t irq = TRACE_IRQ_SAVE();
+    if (!trace_buffer.frozen) {
+        Trace_Record_t *r = &trace_buffer.records[trace_buffer.written & (TRACE_BUFFER_SIZE - 1)];
+        r->timestamp = TRACE_NOW();
+        r->arg = arg;
+        r->id = id;
+        trace_buffer.written++;
+    }
+    TRACE_IRQ_RESTORE(irq);
+}
+
+#define TRACE_EVENT(id, arg)        Trace_Record((uint8_t)(id), (uint32_t)(arg))
+
+void Trace_Init(void);
+uint8_t Trace_Dump(uint8_t reason);
+void Trace_Fault(uint8_t reason);
+
+#else
+
+#define TRACE_EVENT(id, arg)        do { } while (0)
+
+#endif // TRACE_ENABLED
+
+// 导出帧解码与事件名称（主机端使用，不依赖 TRACE_ENABLED）
+uint8_t Trace_DecodeFrame(const uint8_t *payload, uint16_t len, Trace_DumpFrame_t *frame);
+const char *Trace_EventName(uint8_t id);
+char Trace_EventPhase(uint8_t id);
+
+#endif // TRACE_H
@@ -0,0 +1,109 @@
+#ifndef TREND_LOG_H
+#define TREND_LOG_H
+
+#include <stdint.h>
+
+/*
+ * 片内Flash趋势记录（每秒一条: 心率、血氧、信号质量、标志、时间差）
+ *
+ * 存储区被划分为若干页，按页循环写入（日志结构），写满一页后擦除下一页
+ * （最旧的数据）继续写，所有页的擦除次数保持一致（磨损均衡）。
+ *
+ * 页格式（半字小端）:
+ *   +0  MAGIC  0x4C54 ("TL")，页头其余字段写完后最后写入（页头提交标志）
+ *   +2  STATE  0xFFFF=写入中, 0x0000=已写满（页提交标志）
+ *   +4  SEQ    页序号（32位，全局递增，用于确定新旧顺序）
+ *   +8  SESSION 上电会话号（每次上电+1）
+ *   +10 CHECK  ~(SEQ_L ^ SEQ_H ^ SESSION ^ T0_L ^ T0_H)，检测擦除中断留下的残页
+ *   +12 T0     本页基准时间（会话内秒数，32位）
+ *   +16 记录区，遇到 0xFFFF 即结束
+ *
+ * 记录格式（变长，1或2个半字）:
+ *   短记录: 0 | FLAGS(3) | SQI(2) | dSpO2(4, 有符号) | dHR(6, 有符号)
+ *           相对上一条记录，时间差固定为1秒
+ *   完整记录: 1 | SpO2(7, 0-100) | HR(8)  随后  0 | FLAGS(3) | SQI(2) | DT(10)
+ *           第二个半字的最高位为0，作为记录提交标志；只写入了第一个
+ *           半字的记录（掉电）在读出时被识别为残缺记录并丢弃
+ * 每页第一条记录总是完整记录，因此任意一页都可以单独解码。
+ */
+#define TREND_LOG_MAGIC             0x4C54
+#define TREND_LOG_STATE_OPEN        0xFFFF
+#define TREND_LOG_STATE_CLOSED      0x0000
+#define TREND_LOG_HEADER_SIZE       16
+#define TREND_LOG_MAX_DT            1023   // 完整记录可表示的最大时间差（秒），更长的间隔另起一页
+
+// 记录标志位
+#define TREND_FLAG_NO_FINGER        0x01   // 未检测到手指
+#define TREND_FLAG_HR_VALID         0x02   // 心率有效
+#define TREND_FLAG_SPO2_VALID       0x04   // 血氧有效
+
+// 遥测读出帧载荷: SEQ(4) OFFSET(2) TOTAL(2) DATA...
+#define TREND_LOG_DUMP_HEADER       8
+#define TREND_LOG_DUMP_CHUNK        128    // 每帧携带的页数据字节数
+
+// Flash后端（STM32片内Flash或主机模拟器）
+typedef struct {
+    uint32_t base;                      // 存储区起始地址（页对齐）
+    uint16_t page_size;                 // 页大小（字节）
+    uint16_t page_count;                // 页数
+    void *ctx;                          // 后端私有数据
+    uint8_t (*erase_page)(void *ctx, uint32_t addr);                // 0: 成功
+    uint8_t (*program_halfword)(void *ctx, uint32_t addr, uint16_t data); // 0: 成功
+    void (*read)(void *ctx, uint32_t addr, void *dst, uint16_t len);
+} TrendLog_Flash_t;
+
+// 解码出的记录
+typedef struct {
+    uint16_t session;                   // 会话号
+    uint32_t time;                      // 会话内时间（秒）
+    uint8_t hr;                         // 心率（BPM）
+    uint8_t spo2;                       // 血氧（%）
+    uint8_t sqi;                        // 信号质量 0-3
+    uint8_t flags;                      // TREND_FLAG_*
+} TrendLog_Record_t;
+
+// 页解码结果
+typedef struct {
+    uint32_t seq;                       // 页序号
+    uint16_t session;                   // 会话号
+    uint16_t records;                   // 有效记录数
+    uint16_t used;                      // 已使用字节数（含页头）
+    uint8_t closed;                     // 页已写满
+    uint8_t torn;                       // 末尾有残缺记录（写入时掉电）
+    uint8_t corrupt;                    // 记录区格式错误，提前结束
+} TrendLog_PageInfo_t;
+
+typedef void (*TrendLog_RecordCb_t)(const TrendLog_Record_t *rec, void *ctx);
+
+// 记录器状态
+typedef struct {
+    const TrendLog_Flash_t *flash;
+    uint32_t next_seq;                  // 下一个新页的序号
+    uint16_t session;                   // 当前会话号
+    uint16_t page;                      // 当前写入页
+    uint16_t offset;                    // 当前页写入偏移（字节）
+    uint8_t page_open;                  // 当前页已打开
+    uint32_t t0;                        // 当前页基准时间
+    uint32_t last_time;                 // 上一条记录的时间
+    uint8_t last_hr;                    // 上一条记录的心率
+    uint8_t last_spo2;                  // 上一条记录的血氧
+
+    // 统计
+    uint32_t records;                   // 本次上电写入的记录数
+    uint16_t erases;                    // 本次上电擦除的页数
+    uint16_t errors;                    // Flash操作失败次数
+} TrendLog_t;
+
+// 记录器（设备端）
+uint8_t TrendLog_Mount(TrendLog_t *log, const TrendLog_Flash_t *flash);
+uint8_t TrendLog_Append(TrendLog_t *log, uint32_t time, uint8_t hr, uint8_t spo2,
+                        uint8_t sqi, uint8_t flags);
+uint8_t TrendLog_Format(TrendLog_t *log);
+uint8_t TrendLog_Dump(TrendLog_t *log);
+uint32_t TrendLog_Capacity(const TrendLog_Flash_t *flash);
+
+// 页解码（设备与主机共用）
+uint8_t TrendLog_DecodePage(const uint8_t *data, uint16_t len, TrendLog_PageInfo_t *info,
+                            TrendLog_RecordCb_t cb, void *ctx);
+
+#endif // TREND_LOG_H
@@ -0,0 +1,13 @@
+#ifndef TREND_LOG_FLASH_H
+#define TREND_LOG_FLASH_H
+
+#include "trend_log.h"
+
+/*
+ * STM32F1 片内Flash后端
+ * 存储区由链接脚本中的 TRENDLOG 区域（_trend_log_start/_trend_log_end）保留，
+ * 应用代码不会被链接到该区域。
+ */
+void TrendLog_FlashSTM32_Init(TrendLog_Flash_t *flash);
+
+#endif // TREND_LOG_FLASH_H
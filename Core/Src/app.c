@@ -0,0 +1,767 @@
+#include "app.h"
+#include "platform.h"
+#include <stdio.h>
+#include <string.h>
+#include "../../lib/oled/inc/oled.h"
+#include "../../lib/oled/inc/max30102.h"
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include "ppg_adaptive.h"
+#include "telemetry.h"
+#include "ppg_codec.h"
+#include "fmt.h"
+#include "trend_log.h"
+#include "trend_log_flash.h"
+#include "profiler.h"
+#include "trace.h"
+#include "timebase.h"
+#include "ram_guard.h"
+
+/*****************************************************************************
+ * 算法方法选择
+ * 取消注释其中一行来选择使用的算法（主机构建可用 -D 指定）：
+ * - USE_ALGORITHM_METHOD1: 时域峰值检测算法 (默认)
+ *   特点：快速响应(~5秒)，低内存(~2KB)，适合实时监测
+ * - USE_ALGORITHM_METHOD2: 频域DPT变换算法
+ *   特点：高精度(~10秒)，中等内存(~8KB)，基于ADI论文，抗噪声强
+ * - USE_ALGORITHM_ADAPTIVE: 方法1为主，信号差时心率切换到DPT（ppg_adaptive.h）
+ *   特点：DPT平时只作影子（滤波+缓冲区），只在需要时做变换；内存为两者之和
+ *****************************************************************************/
+#if defined(USE_ALGORITHM_ADAPTIVE) && !defined(USE_ALGORITHM_METHOD1)
+#define USE_ALGORITHM_METHOD1       // 自适应以方法1为基础（血氧始终取方法1）
+#endif
+
+#if !defined(USE_ALGORITHM_METHOD1) && !defined(USE_ALGORITHM_METHOD2)
+#define USE_ALGORITHM_METHOD1       // 方法1: 时域峰值检测 (默认)
+// #define USE_ALGORITHM_METHOD2    // 方法2: 频域DPT变换
+#endif
+
+// 确保只选择了一种方法
+#if defined(USE_ALGORITHM_METHOD1) && defined(USE_ALGORITHM_METHOD2)
+    #error "Error: Cannot use both methods simultaneously. Please comment out one."
+#endif
+
+/*****************************************************************************
+ * 原始数据采集模式（可选，与算法选择相互独立）
+ * - USE_RAW_CAPTURE: 将全速率原始红光/红外样本经差分+Rice无损压缩后，
+ *   以二进制遥测帧(TLM_TYPE_RAW_PPG)从UART2输出，可与文本日志共用串口。
+ *   主机端使用 host/apps/ppg_capture_decode 还原为 CSV。
+ *****************************************************************************/
+// #define USE_RAW_CAPTURE
+
+/*****************************************************************************
+ * 趋势记录模式（可选，仅 STM32）
+ * - USE_TREND_LOG: 每秒把心率/血氧/信号质量写入片内Flash保留区
+ *   （链接脚本 TRENDLOG 区域，16KB约可循环保存2小时），
+ *   上电时先通过遥测帧(TLM_TYPE_TREND_LOG)导出全部历史记录，
+ *   主机端使用 host/apps/trend_log_decode 还原为 CSV。
+ *****************************************************************************/
+// #define USE_TREND_LOG
+
+// 波形显示宏定义
+#define WAVE_WIDTH  128       // 波形宽度（屏幕宽度）
+#define WAVE_HEIGHT 40        // 波形高度
+#define WAVE_Y_OFFSET 24      // 波形Y轴偏移（数值显示下方）
+#define WAVE_SAMPLE_INTERVAL 2   // 每2个样本取一个点显示
+
+// 全局中断标志位
+volatile uint8_t max30102_interrupt_flag = 0;
+
+/**************************************************************************
+ * 算法状态（静态变量，RAM 占用在链接时确定）
+ **************************************************************************/
+#ifdef USE_ALGORITHM_METHOD1
+// 方法1: 时域峰值检测算法
+static PPG_FilterState_t red_filter RAM_STATIC;
+static PPG_FilterState_t ir_filter RAM_STATIC;
+static HR_State_t hr_state RAM_STATIC;
+static SpO2_State_t spo2_state RAM_STATIC;
+static float displayed_hr;      // 方法1特有的显示平滑（参数见 ppg_algorithm.h）
+#endif
+
+#ifdef USE_ALGORITHM_METHOD2
+// 方法2: 频域DPT变换算法（DPT_State_t 约13KB，必须为静态变量）
+static DPT_State_t dpt_state RAM_STATIC;
+#endif
+
+#ifdef USE_ALGORITHM_ADAPTIVE
+// 自适应: 方法1之外的影子DPT（同样约13KB）与引擎选择器
+static DPT_State_t dpt_state RAM_STATIC;
+static PPG_Adaptive_t adaptive;
+#endif
+
+// FIFO突发读取: 每次读出全部新样本再逐个处理，样本时间戳由突发到达时间推算
+static uint32_t burst_red[MAX30102_FIFO_DEPTH] RAM_STATIC;
+static uint32_t burst_ir[MAX30102_FIFO_DEPTH] RAM_STATIC;
+static uint8_t burst_count;
+static uint8_t burst_pos;
+static uint64_t burst_time_us;
+static uint64_t sample_time_us;        // 当前样本的时间戳（由突发到达时间推算）
+static SampleClock_t sample_clock;     // 实际采样率估计（传感器振荡器偏差约±1%）
+
+// 计算相关变量
+static uint16_t sample_counter;        // 采样计数器
+static float heart_rate;
+static float spo2;
+static float displayed_spo2;           // 血氧显示平滑
+static uint32_t total_samples;
+static uint32_t total_lost;
+static uint32_t total_updates;
+
+// 波形显示相关变量
+static float wave_buffer[WAVE_WIDTH] RAM_STATIC; // 波形缓冲区
+static uint8_t wave_index;             // 当前波形索引
+static uint8_t wave_sample_counter;    // 波形采样计数器
+
+static uint32_t ram_report_tick;
+#if TRACE_ENABLED
+static uint32_t trace_loop_tick;
+#endif
+
+#ifdef USE_RAW_CAPTURE
+// 原始数据采集状态（静态分配，避免占用栈）
+static PPG_Capture_t raw_capture;
+#endif
+
+#ifdef USE_TREND_LOG
+// 趋势记录器状态
+static TrendLog_Flash_t trend_flash;
+static TrendLog_t trend_log;
+static uint64_t trend_next_us;          // 下一条记录的样本时间
+static uint32_t trend_seconds;
+#endif
+
+/**
+  * @brief  输出一行 "<prefix><value><suffix>" 日志（value保留1位小数）
+  * @note   使用 fmt_fixed 代替 printf("%.1f")，无需链接 printf 浮点支持
+  */
+static void log_value(const char *prefix, float value, const char *suffix)
+{
+    char line[64];
+    char *p = fmt_str(line, prefix);
+    p = fmt_fixed(p, value, 1, 0, ' ');
+    fmt_str(p, suffix);
+    printf("%s", line);
+}
+
+#if defined(USE_ALGORITHM_METHOD2) || defined(USE_ALGORITHM_ADAPTIVE)
+/**
+  * @brief  输出DPT心率日志（方法2，及自适应切换到DPT时）
+  */
+static void log_dpt_hr(void)
+{
+    if (DPT_IsHeartRateValid(&dpt_state)) {
+        uint16_t peak_period = DPT_GetPeakPeriod(&dpt_state);
+        char suffix[48];                // 20 + 最多5位周期 + 18 + '\0' = 44
+        char *p = fmt_str(suffix, " BPM | Peak Period: ");
+        p = fmt_u32(p, peak_period, 0, ' ');
+        fmt_str(p, " samples (Valid)\r\n");
+        log_value("[Method2] HR: ", heart_rate, suffix);
+    } else {
+        log_value("[Method2] HR: ", heart_rate, " BPM (Acquiring...)\r\n");
+    }
+}
+#endif
+
+#ifdef USE_ALGORITHM_METHOD1
+/**
+  * @brief  当前心率是否有效（自适应时取当前引擎的）
+  */
+static uint8_t hr_shown_valid(void)
+{
+#ifdef USE_ALGORITHM_ADAPTIVE
+    if (PPG_Adaptive_GetEngine(&adaptive) == PPG_ADAPTIVE_DPT) {
+        return DPT_IsHeartRateValid(&dpt_state);
+    }
+#endif
+    return HR_IsValid(&hr_state);
+}
+#endif
+
+#if defined(USE_RAW_CAPTURE) || defined(USE_TREND_LOG) || PROFILER_ENABLED || TRACE_ENABLED
+/**
+  * @brief  遥测帧发送函数（阻塞式UART发送）
+  */
+static void telemetry_uart_tx(const uint8_t *data, uint16_t len)
+{
+    Platform_UART_Write(data, len);
+}
+#endif
+
+#if TRACE_ENABLED
+/**
+  * @brief  串口命令: 收到 'T' 时导出事件追踪缓冲区
+  */
+static void trace_poll_request(void)
+{
+    uint8_t cmd;
+    if (Platform_UART_ReadByte(&cmd) && cmd == 'T') {
+        Trace_Dump(TRACE_REASON_REQUEST);
+    }
+}
+#endif
+
+/**
+  * @brief  MAX30102 中断引脚（下降沿）处理函数
+  */
+static void sensor_irq_handler(void)
+{
+    max30102_interrupt_flag = 1;
+    TRACE_EVENT(TRACE_EV_SENSOR_IRQ, 0);
+}
+
+/**
+  * @brief  外设与算法初始化（STM32 上需先完成 CubeMX 外设初始化）
+  */
+void App_Init(void)
+{
+    Platform_Init();
+    Platform_EXTI_SetHandler(PLATFORM_PIN_SENSOR_INT, sensor_irq_handler);
+
+#if TRACE_ENABLED
+    // 事件追踪（仅在 -DENABLE_TRACE=ON 时编译），尽早初始化以记录OLED/传感器的初始化过程
+    Trace_Init();
+#endif
+
+    /*******************************oled init********************************************/
+    // 刚上电时STM32比OLED启动快，因此需要等待一段时间再初始化OLED
+    Platform_DelayMs(20);
+    // 初始化OLED
+    OLED_Init();
+    // 设置OLED显示模式：正常/反色
+    OLED_SetColorMode(OLED_COLOR_NORMAL);
+    // 设置OLED显示方向：0°/180°
+    OLED_SetOrientation(OLED_Orientation_0);
+    // 清空显示缓冲区
+    OLED_ClearBuffer();
+    // 将缓存内容更新到屏幕显示
+    OLED_Refresh();
+    /***********************************************************************************/
+
+    printf("OLED Init Ok\r\n");
+
+    /*******************************soft i2c********************************************/
+    Soft_I2C_Init(); // 总线置为空闲（微秒延时定时器已由 Platform_Init 启动）
+    /***********************************************************************************/
+
+    printf("MAX30102 Test Program\r\n");
+
+    // 测试通信
+    uint8_t part_id = MAX30102_ReadPartID();
+    printf("MAX30102 Part ID: 0x%02X\r\n", part_id);
+    if (part_id != 0x15) {
+        printf("Error: MAX30102 not found!\r\n");
+        Platform_Halt();
+    }
+
+    // 初始化MAX30102
+    if (MAX30102_Init() != 0) {
+        printf("MAX30102 Init Failed!\r\n");
+        Platform_Halt();
+    } else {
+        printf("MAX30102 Init Success!\r\n");
+    }
+
+    /**************************************************************************
+     * 算法初始化 - 根据宏定义选择不同的算法
+     **************************************************************************/
+
+#ifdef USE_ALGORITHM_METHOD1
+    printf("\r\n========================================\r\n");
+    printf("  Algorithm: Method 1 - Time Domain Peak Detection\r\n");
+    printf("  Features: Fast response (~5s), Low memory (~2KB)\r\n");
+#ifdef USE_ALGORITHM_ADAPTIVE
+    printf("  Adaptive: DPT heart rate while the signal is poor\r\n");
+#endif
+    printf("========================================\r\n\r\n");
+
+    PPG_Filter_Init(&red_filter);
+    PPG_Filter_Init(&ir_filter);
+    HR_Init(&hr_state);
+    SpO2_Init(&spo2_state);
+    displayed_hr = 0.0f;
+#endif
+
+#ifdef USE_ALGORITHM_ADAPTIVE
+    DPT_Init(&dpt_state);
+    PPG_Adaptive_Init(&adaptive);
+#endif
+
+#ifdef USE_ALGORITHM_METHOD2
+    printf("\r\n========================================\r\n");
+    printf("  Algorithm: Method 2 - DPT Frequency Domain\r\n");
+    printf("  Features: High precision (~10s), Based on ADI paper\r\n");
+    printf("  Buffer: %d samples (10 seconds)\r\n", DPT_BUFFER_SIZE);
+    printf("  Period range: %d-%d samples (%d-%d bpm)\r\n",
+           DPT_MIN_PERIOD, DPT_MAX_PERIOD,
+           (int)(6000.0f / DPT_MAX_PERIOD), (int)(6000.0f / DPT_MIN_PERIOD));
+    printf("========================================\r\n\r\n");
+
+    DPT_Init(&dpt_state);
+#endif
+
+    burst_count = 0;
+    burst_pos = 0;
+    burst_time_us = 0;
+    sample_time_us = 0;
+    SampleClock_Init(&sample_clock);
+
+    sample_counter = 0;
+    heart_rate = 0.0f;
+    spo2 = 0.0f;
+    displayed_spo2 = 0.0f;
+    total_samples = 0;
+    total_lost = 0;
+    total_updates = 0;
+
+    // 初始化波形缓冲区
+    for (uint16_t i = 0; i < WAVE_WIDTH; i++) {
+        wave_buffer[i] = 0.0f;
+    }
+    wave_index = 0;
+    wave_sample_counter = 0;
+
+#if defined(USE_RAW_CAPTURE) || defined(USE_TREND_LOG) || PROFILER_ENABLED || TRACE_ENABLED
+    TLM_Init(telemetry_uart_tx);
+#endif
+
+#ifdef USE_TREND_LOG
+    // 挂载趋势记录区并导出历史记录（新会话从新页开始写，不会覆盖刚导出的内容）
+    TrendLog_FlashSTM32_Init(&trend_flash);
+    TrendLog_Mount(&trend_log, &trend_flash);
+    printf("Trend log: %d pages, session %d, dumping history...\r\n",
+           trend_flash.page_count, trend_log.session);
+    TrendLog_Dump(&trend_log);
+    trend_next_us = Platform_GetUs() + 1000000u;
+    trend_seconds = 0;
+#endif
+
+#ifdef USE_RAW_CAPTURE
+    PPG_Capture_Init(&raw_capture);
+    printf("Raw capture enabled: %d samples/block, %d blocks/frame\r\n",
+           PPG_CODEC_BLOCK_SIZE, PPG_CAPTURE_BLOCKS_PER_FRAME);
+#endif
+
+    // 分阶段周期统计（仅在 -DENABLE_PROFILER=ON 时编译）
+    PROF_INIT();
+
+#if TRACE_ENABLED
+    trace_loop_tick = Platform_GetTickMs();
+#endif
+
+    ram_report_tick = Platform_GetTickMs();
+    printf("Stack: %lu bytes reserved, %lu used during init\r\n",
+           (unsigned long)RamGuard_StackSize(), (unsigned long)RamGuard_StackPeak());
+
+    printf("Starting PPG signal processing...\r\n");
+}
+
+/**
+  * @brief  OLED显示更新 - 两种方法共用
+  */
+static void update_display(void)
+{
+    TRACE_EVENT(TRACE_EV_OLED_FRAME_BEGIN, 0);
+    OLED_ClearBuffer();
+
+    // 1. 显示数值（顶部一行，数值右对齐3位，避免位数变化时布局跳动）
+    OLED_PrintString(0, 0, "HR:", 12, OLED_COLOR_NORMAL);
+#ifdef USE_ALGORITHM_METHOD1
+    if (hr_shown_valid() && displayed_hr > 0.0f) {
+        OLED_PrintFixed(18, 0, displayed_hr, 0, 3, 12, OLED_COLOR_NORMAL);
+    } else {
+        OLED_PrintString(18, 0, " --", 12, OLED_COLOR_NORMAL);
+    }
+#endif
+#ifdef USE_ALGORITHM_METHOD2
+    if (DPT_IsHeartRateValid(&dpt_state) && heart_rate > 0.0f) {
+        OLED_PrintFixed(18, 0, heart_rate, 0, 3, 12, OLED_COLOR_NORMAL);
+    } else {
+        OLED_PrintString(18, 0, " --", 12, OLED_COLOR_NORMAL);
+    }
+#endif
+
+    OLED_PrintString(64, 0, "SpO2:", 12, OLED_COLOR_NORMAL);
+#ifdef USE_ALGORITHM_METHOD1
+    if (SpO2_IsValid(&spo2_state) && displayed_spo2 > 0.0f) {
+        OLED_PrintFixed(94, 0, displayed_spo2, 0, 3, 12, OLED_COLOR_NORMAL);
+        OLED_PrintString(112, 0, "%", 12, OLED_COLOR_NORMAL);
+    } else {
+        OLED_PrintString(94, 0, " --", 12, OLED_COLOR_NORMAL);
+    }
+#endif
+#ifdef USE_ALGORITHM_METHOD2
+    if (DPT_IsSpO2Valid(&dpt_state) && displayed_spo2 > 0.0f) {
+        OLED_PrintFixed(94, 0, displayed_spo2, 0, 3, 12, OLED_COLOR_NORMAL);
+        OLED_PrintString(112, 0, "%", 12, OLED_COLOR_NORMAL);
+    } else {
+        OLED_PrintString(94, 0, " --", 12, OLED_COLOR_NORMAL);
+    }
+#endif
+
+    // 2. 绘制波形边框
+    OLED_DrawRectangle(0, WAVE_Y_OFFSET - 1, WAVE_WIDTH - 1, WAVE_Y_OFFSET + WAVE_HEIGHT - 1, OLED_COLOR_NORMAL);
+
+    // 3. 找到波形的最大值和最小值（用于归一化）
+    float wave_min = wave_buffer[0];
+    float wave_max = wave_buffer[0];
+    for (uint8_t i = 1; i < WAVE_WIDTH; i++) {
+        if (wave_buffer[i] < wave_min) wave_min = wave_buffer[i];
+        if (wave_buffer[i] > wave_max) wave_max = wave_buffer[i];
+    }
+
+    // 4. 绘制波形
+    float wave_range = wave_max - wave_min;
+    if (wave_range > 1.0f) { // 确保有足够的信号幅度
+        for (uint8_t x = 0; x < WAVE_WIDTH - 1; x++) {
+            // 归一化到波形高度范围
+            uint8_t y1 = WAVE_Y_OFFSET + WAVE_HEIGHT - 1 -
+                         (uint8_t)((wave_buffer[x] - wave_min) / wave_range * (WAVE_HEIGHT - 2));
+            uint8_t y2 = WAVE_Y_OFFSET + WAVE_HEIGHT - 1 -
+                         (uint8_t)((wave_buffer[x + 1] - wave_min) / wave_range * (WAVE_HEIGHT - 2));
+
+            // 限制Y坐标范围
+            if (y1 < WAVE_Y_OFFSET) y1 = WAVE_Y_OFFSET;
+            if (y1 >= WAVE_Y_OFFSET + WAVE_HEIGHT) y1 = WAVE_Y_OFFSET + WAVE_HEIGHT - 1;
+            if (y2 < WAVE_Y_OFFSET) y2 = WAVE_Y_OFFSET;
+            if (y2 >= WAVE_Y_OFFSET + WAVE_HEIGHT) y2 = WAVE_Y_OFFSET + WAVE_HEIGHT - 1;
+
+            // 画线连接两个点
+            OLED_DrawLine(x, y1, x + 1, y2, OLED_COLOR_NORMAL);
+        }
+    }
+
+    // 5. 在当前采样位置绘制游标（竖线）
+    uint8_t cursor_x = wave_index;
+    if (cursor_x < WAVE_WIDTH) {
+        OLED_DrawLine(cursor_x, WAVE_Y_OFFSET, cursor_x, WAVE_Y_OFFSET + WAVE_HEIGHT - 1, OLED_COLOR_REVERSED);
+    }
+
+    PROF_BEGIN(PROF_STAGE_OLED_REFRESH);
+    OLED_Refresh();
+    PROF_END(PROF_STAGE_OLED_REFRESH);
+    TRACE_EVENT(TRACE_EV_OLED_FRAME_END, 0);
+}
+
+/**
+  * @brief  主循环一次迭代: 处理一个样本（FIFO为空时只轮询一次FIFO指针）
+  */
+void App_Loop(void)
+{
+    // 上一次突发的样本处理完后，读取FIFO中的全部新样本（没有新样本时继续轮询）
+    if (burst_pos >= burst_count) {
+        uint8_t lost;
+        uint8_t available = MAX30102_GetFifoCount(&lost);
+        if (lost != 0) {
+            TRACE_EVENT(TRACE_EV_OVERRUN, lost);
+            total_lost += lost;
+        }
+        if (available == 0) {
+            return;
+        }
+        // 指针读取时刻即最新样本的到达时间（读取数据本身需要若干毫秒）
+        burst_time_us = Platform_GetUs();
+
+        TRACE_EVENT(TRACE_EV_FIFO_READ_BEGIN, available);
+        PROF_BEGIN(PROF_STAGE_FIFO_READ);
+        burst_count = MAX30102_ReadFifoBurst(burst_red, burst_ir, available);
+        PROF_END(PROF_STAGE_FIFO_READ);
+        TRACE_EVENT(TRACE_EV_FIFO_READ_END, burst_count);
+        burst_pos = 0;
+        if (burst_count == 0) {
+            return;
+        }
+
+        // 每个估计窗口结束时更新心率换算用的采样率
+        if (SampleClock_AddBurst(&sample_clock, burst_time_us, burst_count, lost)) {
+            float rate = SampleClock_GetRate(&sample_clock);
+#ifdef USE_ALGORITHM_METHOD1
+            HR_SetSampleRate(&hr_state, rate);
+#endif
+#if defined(USE_ALGORITHM_METHOD2) || defined(USE_ALGORITHM_ADAPTIVE)
+            DPT_SetSampleRate(&dpt_state, rate);
+#endif
+            log_value("[Clock] Sample rate: ", rate, " Hz\r\n");
+        }
+    }
+
+    PROF_BEGIN(PROF_STAGE_LOOP);
+
+    // 取出下一个样本
+    uint32_t raw_red = burst_red[burst_pos];
+    uint32_t raw_ir = burst_ir[burst_pos];
+    sample_time_us = SampleClock_SampleTime(&sample_clock, burst_time_us, burst_count, burst_pos);
+    burst_pos++;
+    total_samples++;
+
+#ifdef USE_RAW_CAPTURE
+    // 采集全部原始样本（不受手指检测阈值影响，便于离线分析）
+    PPG_Capture_Push(&raw_capture, raw_red, raw_ir);
+#endif
+
+#ifdef USE_TREND_LOG
+    // 按样本时间每秒写入一条趋势记录（数值取最近一次的计算结果），
+    // 不受主循环延迟和突发读取的影响
+    if (sample_time_us >= trend_next_us) {
+        uint8_t trend_flags = 0;
+        uint8_t trend_sqi = 0;
+        trend_next_us += 1000000u;
+        trend_seconds++;
+
+        if (raw_red <= 100000 || raw_ir <= 100000) {
+            trend_flags |= TREND_FLAG_NO_FINGER;
+        }
+#ifdef USE_ALGORITHM_METHOD1
+        if (hr_shown_valid()) trend_flags |= TREND_FLAG_HR_VALID;
+        if (SpO2_IsValid(&spo2_state)) trend_flags |= TREND_FLAG_SPO2_VALID;
+        trend_sqi = HR_GetSignalQuality(&hr_state);
+#endif
+#ifdef USE_ALGORITHM_METHOD2
+        if (DPT_IsHeartRateValid(&dpt_state)) trend_flags |= TREND_FLAG_HR_VALID;
+        if (DPT_IsSpO2Valid(&dpt_state)) trend_flags |= TREND_FLAG_SPO2_VALID;
+        trend_sqi = DPT_IsHeartRateValid(&dpt_state) ? 2 : 0;
+#endif
+        TrendLog_Append(&trend_log, trend_seconds,
+                        (heart_rate > 0.0f && heart_rate < 255.0f) ? (uint8_t)(heart_rate + 0.5f) : 0,
+                        (spo2 > 0.0f && spo2 <= 100.0f) ? (uint8_t)(spo2 + 0.5f) : 0,
+                        trend_sqi, trend_flags);
+    }
+#endif
+
+    // 检查信号强度（确保手指放好）
+    if (raw_red > 100000 && raw_ir > 100000) {
+
+/**************************************************************************
+ * 算法处理 - 根据宏定义选择不同的算法
+ **************************************************************************/
+
+#ifdef USE_ALGORITHM_METHOD1
+        // ========== 方法1: 时域峰值检测算法 ==========
+
+        // 1. 滤波处理（红光通道只需更新 AC RMS / DC 供血氧计算）
+        PROF_BEGIN(PROF_STAGE_FILTER);
+        PPG_Filter_Process(&red_filter, raw_red);
+        float ac_ir = PPG_Filter_Process(&ir_filter, raw_ir);
+        PROF_END(PROF_STAGE_FILTER);
+
+        // 2. 添加IR信号到心率缓冲区（优化内存使用）
+        float ir_dc = PPG_Filter_GetDC(&ir_filter);
+        PROF_BEGIN(PROF_STAGE_HR_ADD);
+        HR_AddSample(&hr_state, ac_ir, ir_dc);
+        PROF_END(PROF_STAGE_HR_ADD);
+
+#ifdef USE_ALGORITHM_ADAPTIVE
+        // 2.1 DPT: 为当前引擎时完整变换，否则只作影子（滤波+缓冲区）
+        PROF_BEGIN(PROF_STAGE_DPT_PROCESS);
+        PPG_Adaptive_Process(&adaptive, &dpt_state, raw_red, raw_ir);
+        PROF_END(PROF_STAGE_DPT_PROCESS);
+#endif
+
+        // 2.2 更新波形显示（降采样）
+        wave_sample_counter++;
+        if (wave_sample_counter >= WAVE_SAMPLE_INTERVAL) {
+            wave_sample_counter = 0;
+            wave_buffer[wave_index] = ac_ir;
+            wave_index = (wave_index + 1) % WAVE_WIDTH;
+        }
+
+        // 3. 每250个样本（2.5秒@100Hz）计算一次心率和血氧并更新显示
+        sample_counter++;
+        if (sample_counter >= 250) {
+            sample_counter = 0;
+            total_updates++;
+
+            // 计算心率
+            PROF_BEGIN(PROF_STAGE_HR_CALC);
+            heart_rate = HR_Calculate(&hr_state);
+            PROF_END(PROF_STAGE_HR_CALC);
+#ifdef USE_ALGORITHM_ADAPTIVE
+            // 方法1不可靠时心率改取DPT（可能在此切换引擎）
+            if (PPG_Adaptive_Update(&adaptive, &hr_state, &dpt_state) == PPG_ADAPTIVE_DPT) {
+                heart_rate = DPT_GetHeartRate(&dpt_state);
+            }
+#endif
+            TRACE_EVENT(TRACE_EV_HR_UPDATE, (uint32_t)(heart_rate * 10.0f));
+
+            // 获取AC RMS和DC值
+            float red_ac_rms = PPG_Filter_GetACRMS(&red_filter);
+            float red_dc = PPG_Filter_GetDC(&red_filter);
+            float ir_ac_rms = PPG_Filter_GetACRMS(&ir_filter);
+            ir_dc = PPG_Filter_GetDC(&ir_filter);
+
+            // 计算血氧
+            PROF_BEGIN(PROF_STAGE_SPO2_CALC);
+            spo2 = SpO2_Calculate(&spo2_state, red_ac_rms, red_dc, ir_ac_rms, ir_dc);
+            PROF_END(PROF_STAGE_SPO2_CALC);
+            TRACE_EVENT(TRACE_EV_SPO2_UPDATE, (uint32_t)(spo2 * 10.0f));
+
+            // === 显示平滑处理 ===
+            // 1. 心率显示平滑
+            if (hr_shown_valid()) {
+                displayed_hr = HR_DisplaySmooth(displayed_hr, heart_rate);
+            }
+
+            // 2. 血氧显示平滑
+            if (SpO2_IsValid(&spo2_state)) {
+                if (displayed_spo2 == 0.0f) {
+                    displayed_spo2 = spo2;
+                } else {
+                    displayed_spo2 = DISPLAY_EMA_ALPHA * spo2 +
+                                    (1.0f - DISPLAY_EMA_ALPHA) * displayed_spo2;
+                }
+            }
+
+            // 输出结果
+#ifdef USE_ALGORITHM_ADAPTIVE
+            if (PPG_Adaptive_GetEngine(&adaptive) == PPG_ADAPTIVE_DPT) {
+                log_dpt_hr();
+            } else if (HR_IsValid(&hr_state)) {
+#else
+            if (HR_IsValid(&hr_state)) {
+#endif
+                log_value("[Method1] HR: ", heart_rate, " BPM (Valid)\r\n");
+            } else {
+                log_value("[Method1] HR: ", heart_rate, " BPM (Acquiring...)\r\n");
+            }
+
+            if (SpO2_IsValid(&spo2_state)) {
+                log_value("[Method1] SpO2: ", spo2, " %\r\n");
+            } else {
+                printf("[Method1] SpO2: --\r\n");
+            }
+
+#ifdef USE_ALGORITHM_ADAPTIVE
+            uint32_t m1_samples = adaptive.samples[PPG_ADAPTIVE_METHOD1];
+            uint32_t all_samples = m1_samples + adaptive.samples[PPG_ADAPTIVE_DPT];
+            log_value(PPG_Adaptive_GetEngine(&adaptive) == PPG_ADAPTIVE_DPT ?
+                      "[Adaptive] Engine: DPT | Method1 samples: " : "[Adaptive] Engine: Method1 | Method1 samples: ",
+                      all_samples ? 100.0f * (float)m1_samples / (float)all_samples : 0.0f, " %\r\n");
+#endif
+
+            update_display();
+        }
+#endif
+
+#ifdef USE_ALGORITHM_METHOD2
+        // ========== 方法2: 频域DPT变换算法 ==========
+
+        // 1. DPT处理（内部包含IIR滤波和变换）
+        PROF_BEGIN(PROF_STAGE_DPT_PROCESS);
+        DPT_Process(&dpt_state, raw_red, raw_ir);
+        PROF_END(PROF_STAGE_DPT_PROCESS);
+
+        // 2. 更新波形显示（使用IR的AC信号）
+        // 注意：DPT内部已经提取了AC信号，这里我们简化处理
+        wave_sample_counter++;
+        if (wave_sample_counter >= WAVE_SAMPLE_INTERVAL) {
+            wave_sample_counter = 0;
+            // 使用原始信号的相对变化作为波形（简化）
+            static uint32_t last_ir = 0;
+            if (last_ir > 0) {
+                wave_buffer[wave_index] = (float)((int32_t)raw_ir - (int32_t)last_ir);
+            }
+            last_ir = raw_ir;
+            wave_index = (wave_index + 1) % WAVE_WIDTH;
+        }
+
+        // 3. 每250个样本（2.5秒@100Hz）更新显示
+        sample_counter++;
+        if (sample_counter >= 250) {
+            sample_counter = 0;
+            total_updates++;
+
+            // 获取心率和血氧
+            heart_rate = DPT_GetHeartRate(&dpt_state);
+            spo2 = DPT_GetSpO2(&dpt_state);
+            TRACE_EVENT(TRACE_EV_HR_UPDATE, (uint32_t)(heart_rate * 10.0f));
+            TRACE_EVENT(TRACE_EV_SPO2_UPDATE, (uint32_t)(spo2 * 10.0f));
+
+            // 血氧显示平滑
+            if (DPT_IsSpO2Valid(&dpt_state)) {
+                if (displayed_spo2 == 0.0f) {
+                    displayed_spo2 = spo2;
+                } else {
+                    displayed_spo2 = 0.15f * spo2 + 0.85f * displayed_spo2;
+                }
+            }
+
+            // 输出结果
+            log_dpt_hr();
+
+            if (DPT_IsSpO2Valid(&dpt_state)) {
+                log_value("[Method2] SpO2: ", spo2, " %\r\n");
+            } else {
+                printf("[Method2] SpO2: --\r\n");
+            }
+
+            update_display();
+        }
+#endif
+
+    } else {
+        // 信号太弱，提示用户
+        if (sample_counter == 0) {  // 避免频繁打印
+            printf("Signal weak - Please place finger properly\r\n");
+
+            // 显示提示信息
+            OLED_ClearBuffer();
+            OLED_PrintChinese(10, 20, "Please place", 12, OLED_COLOR_NORMAL);
+            OLED_PrintChinese(10, 36, "finger on", 12, OLED_COLOR_NORMAL);
+            OLED_PrintChinese(10, 52, "sensor", 12, OLED_COLOR_NORMAL);
+            OLED_Refresh();
+        }
+        sample_counter = (sample_counter + 1) % 100;  // 每秒显示一次
+    }
+
+    PROF_END(PROF_STAGE_LOOP);
+    PROF_POLL(Platform_GetTickMs());
+
+#if TRACE_ENABLED
+    // 单次迭代超过阈值视为卡顿，自动导出卡顿前的事件
+    uint32_t trace_now = Platform_GetTickMs();
+    if (trace_now - trace_loop_tick > TRACE_STALL_MS) {
+        TRACE_EVENT(TRACE_EV_STALL, trace_now - trace_loop_tick);
+        Trace_Dump(TRACE_REASON_STALL);
+    }
+    trace_poll_request();
+    trace_loop_tick = Platform_GetTickMs();     // 不把导出本身的耗时算入下一次迭代
+#endif
+
+    // 栈底保护字每次迭代检查：被改写说明栈已超出保留大小，.bss/堆可能已被破坏，立即停机
+    if (!RamGuard_CanaryIntact()) {
+        printf("[RAM] Stack overflow: guard words overwritten\r\n");
+#if TRACE_ENABLED
+        Trace_Fault(TRACE_REASON_STACK);
+#endif
+        Platform_Halt();
+    }
+    if (Platform_GetTickMs() - ram_report_tick >= RAM_GUARD_REPORT_MS) {
+        ram_report_tick = Platform_GetTickMs();
+        printf("[RAM] Stack peak: %lu / %lu bytes\r\n",
+               (unsigned long)RamGuard_StackPeak(), (unsigned long)RamGuard_StackSize());
+    }
+}
+
+/**
+  * @brief  应用当前的输出
+  */
+void App_GetStatus(App_Status_t *status)
+{
+    memset(status, 0, sizeof(App_Status_t));
+    status->heart_rate = heart_rate;
+    status->spo2 = spo2;
+#ifdef USE_ALGORITHM_METHOD1
+    status->displayed_hr = displayed_hr;
+    status->hr_valid = hr_shown_valid();
+    status->spo2_valid = SpO2_IsValid(&spo2_state);
+#endif
+#ifdef USE_ALGORITHM_METHOD2
+    status->displayed_hr = heart_rate;
+    status->hr_valid = DPT_IsHeartRateValid(&dpt_state);
+    status->spo2_valid = DPT_IsSpO2Valid(&dpt_state);
+#endif
+    status->samples = total_samples;
+    status->lost_samples = total_lost;
+    status->updates = total_updates;
+}
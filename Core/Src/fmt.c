@@ -0,0 +1,187 @@
+#include "fmt.h"
+#include <math.h>
+
+static const uint32_t pow10_table[FMT_MAX_DECIMALS + 1] = { 1u, 10u, 100u, 1000u, 10000u };
+
+/**
+ * @brief 把无符号数的十进制数字逆序写入临时缓冲区
+ * @return 数字个数
+ */
+static uint8_t utoa_rev(uint32_t value, char *tmp) {
+    uint8_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10u);
+        value /= 10u;
+    } while (value != 0);
+    return n;
+}
+
+/**
+ * @brief 按宽度与填充规则输出 [符号][整数部分][.小数部分]
+ * @param dst 输出缓冲区
+ * @param negative 是否输出负号
+ * @param int_part 整数部分
+ * @param frac_part 小数部分（已按 decimals 缩放）
+ * @param decimals 小数位数（0表示无小数点）
+ * @param width 最小字段宽度
+ * @param pad 填充字符
+ */
+static char *emit_number(char *dst, uint8_t negative, uint32_t int_part, uint32_t frac_part,
+                         uint8_t decimals, uint8_t width, char pad) {
+    char tmp[10];
+    uint8_t n = utoa_rev(int_part, tmp);
+    uint8_t len = (uint8_t)(n + negative + (decimals ? decimals + 1 : 0));
+
+    if (negative && pad == '0') {
+        *dst++ = '-';
+    }
+    while (len < width) {
+        *dst++ = pad;
+        len++;
+    }
+    if (negative && pad != '0') {
+        *dst++ = '-';
+    }
+    while (n > 0) {
+        *dst++ = tmp[--n];
+    }
+    if (decimals) {
+        *dst++ = '.';
+        for (uint8_t i = decimals; i > 0; i--) {
+            dst[i - 1] = (char)('0' + frac_part % 10u);
+            frac_part /= 10u;
+        }
+        dst += decimals;
+    }
+    *dst = '\0';
+    return dst;
+}
+
+/**
+ * @brief 追加字符串
+ * @param dst 输出缓冲区
+ * @param s 源字符串
+ * @return 指向结尾'\0'的指针
+ */
+char *fmt_str(char *dst, const char *s) {
+    while (*s != '\0') {
+        *dst++ = *s++;
+    }
+    *dst = '\0';
+    return dst;
+}
+
+/**
+ * @brief 追加单个字符
+ */
+char *fmt_char(char *dst, char c) {
+    *dst++ = c;
+    *dst = '\0';
+    return dst;
+}
+
+/**
+ * @brief 格式化无符号整数（等价于 "%*u" / "%0*u"）
+ * @param dst 输出缓冲区
+ * @param value 数值
+ * @param width 最小字段宽度
+ * @param pad 填充字符
+ * @return 指向结尾'\0'的指针
+ */
+char *fmt_u32(char *dst, uint32_t value, uint8_t width, char pad) {
+    return emit_number(dst, 0, value, 0, 0, width, pad);
+}
+
+/**
+ * @brief 格式化有符号整数（等价于 "%*d" / "%0*d"）
+ */
+char *fmt_i32(char *dst, int32_t value, uint8_t width, char pad) {
+    uint8_t negative = (value < 0) ? 1 : 0;
+    uint32_t magnitude = negative ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    return emit_number(dst, negative, magnitude, 0, 0, width, pad);
+}
+
+/**
+ * @brief 格式化为固定位数的大写十六进制（等价于 "%0*X"）
+ * @param dst 输出缓冲区
+ * @param value 数值
+ * @param digits 位数（1-8）
+ * @return 指向结尾'\0'的指针
+ */
+char *fmt_hex(char *dst, uint32_t value, uint8_t digits) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    if (digits > 8) digits = 8;
+    for (uint8_t i = digits; i > 0; i--) {
+        dst[i - 1] = hex_digits[value & 0xFu];
+        value >>= 4;
+    }
+    dst += digits;
+    *dst = '\0';
+    return dst;
+}
+
+/**
+ * @brief 格式化Q16.16定点数（四舍五入到 decimals 位小数）
+ * @param dst 输出缓冲区
+ * @param q16 Q16.16定点数
+ * @param decimals 小数位数（0-4）
+ * @param width 最小字段宽度（含符号和小数点）
+ * @param pad 填充字符
+ * @return 指向结尾'\0'的指针
+ */
+char *fmt_q16(char *dst, int32_t q16, uint8_t decimals, uint8_t width, char pad) {
+    if (decimals > FMT_MAX_DECIMALS) decimals = FMT_MAX_DECIMALS;
+
+    uint8_t negative = (q16 < 0) ? 1 : 0;
+    uint32_t magnitude = negative ? (uint32_t)0 - (uint32_t)q16 : (uint32_t)q16;
+    uint32_t int_part = magnitude >> 16;
+    uint32_t scale = pow10_table[decimals];
+
+    // 小数部分: frac/65536 * 10^d，四舍五入；65535*10^4 < 2^32 不会溢出
+    uint32_t frac_part = ((magnitude & 0xFFFFu) * scale + 0x8000u) >> 16;
+    if (frac_part >= scale) {
+        frac_part -= scale;
+        int_part++;
+    }
+    if (int_part == 0 && frac_part == 0) {
+        negative = 0;   // 避免输出 "-0.0"
+    }
+    return emit_number(dst, negative, int_part, frac_part, decimals, width, pad);
+}
+
+/**
+ * @brief 格式化浮点数为定点十进制（等价于 "%*.*f"，无需链接 printf 浮点支持）
+ * @param dst 输出缓冲区
+ * @param value 数值（NaN、无穷大或 |value| * 10^decimals >= 2^31 时输出 FMT_PLACEHOLDER）
+ * @param decimals 小数位数（0-4）
+ * @param width 最小字段宽度（含符号和小数点）
+ * @param pad 填充字符
+ * @return 指向结尾'\0'的指针
+ */
+char *fmt_fixed(char *dst, float value, uint8_t decimals, uint8_t width, char pad) {
+    if (decimals > FMT_MAX_DECIMALS) decimals = FMT_MAX_DECIMALS;
+
+    uint8_t negative = (value < 0.0f) ? 1 : 0;
+    float magnitude = negative ? -value : value;
+    uint32_t scale = pow10_table[decimals];
+
+    // 只做一次浮点乘法和一次浮点转整数，其余全部为整数运算
+    float scaled = magnitude * (float)scale + 0.5f;
+    if (!isfinite(value) || scaled >= 2147483648.0f) {
+        // 转换为整数是未定义行为: 输出占位符（按宽度右对齐）
+        uint8_t len = (uint8_t)(sizeof(FMT_PLACEHOLDER) - 1);
+        while (len < width) {
+            *dst++ = ' ';
+            len++;
+        }
+        return fmt_str(dst, FMT_PLACEHOLDER);
+    }
+    uint32_t fixed = (uint32_t)scaled;
+
+    uint32_t int_part = fixed / scale;
+    uint32_t frac_part = fixed - int_part * scale;
+    if (fixed == 0) {
+        negative = 0;
+    }
+    return emit_number(dst, negative, int_part, frac_part, decimals, width, pad);
+}
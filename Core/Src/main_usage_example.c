@@ -27,10 +27,8 @@
     HR_State_t hr_state;
     SpO2_State_t spo2_state;
 
-    // Display smoothing for Method 1
+    // Display smoothing for Method 1 (DISPLAY_* parameters in ppg_algorithm.h)
     float displayed_hr = 0.0f;
-    #define DISPLAY_EMA_ALPHA 0.1f
-    #define DISPLAY_HR_THRESHOLD 2.0f
 #endif
 
 #ifdef USE_METHOD_2
@@ -87,15 +85,7 @@ void Algorithm_ProcessSample(uint32_t raw_red, uint32_t raw_ir)
 
     // Apply display smoothing
     if (HR_IsValid(&hr_state)) {
-        if (displayed_hr == 0.0f) {
-            displayed_hr = heart_rate;
-        } else {
-            float hr_diff = fabsf(heart_rate - displayed_hr);
-            if (hr_diff > DISPLAY_HR_THRESHOLD) {
-                displayed_hr = DISPLAY_EMA_ALPHA * heart_rate +
-                              (1.0f - DISPLAY_EMA_ALPHA) * displayed_hr;
-            }
-        }
+        displayed_hr = HR_DisplaySmooth(displayed_hr, heart_rate);
     }
 #endif
 
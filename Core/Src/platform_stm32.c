@@ -0,0 +1,129 @@
+#include "platform.h"
+#include "main.h"
+#include "i2c.h"
+#include "tim.h"
+#include "usart.h"
+#include "timebase.h"
+
+// 引脚映射（与 CubeMX 配置 gpio.c 一致）
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t pin;
+} PinMap_t;
+
+static const PinMap_t pin_map[PLATFORM_PIN_COUNT] = {
+    { softiic_scl_GPIO_Port, softiic_scl_Pin },     // PLATFORM_PIN_I2C_SCL
+    { softiic_sda_GPIO_Port, softiic_sda_Pin },     // PLATFORM_PIN_I2C_SDA
+    { GPIOB, GPIO_PIN_1 },                          // PLATFORM_PIN_SENSOR_INT (EXTI1)
+};
+
+static Platform_IrqHandler_t exti_handlers[PLATFORM_PIN_COUNT];
+
+/**
+ * @brief 启动平台使用的定时器（需先完成 CubeMX 外设初始化）
+ * @note TIM2 专用于 Platform_DelayUs，TIM3 为64位微秒时间基准
+ */
+void Platform_Init(void) {
+    HAL_TIM_Base_Start(&htim2);
+    Timebase_Init();
+}
+
+uint32_t Platform_GetTickMs(void) {
+    return HAL_GetTick();
+}
+
+uint64_t Platform_GetUs(void) {
+    return Timebase_GetUs();
+}
+
+void Platform_DelayMs(uint32_t ms) {
+    HAL_Delay(ms);
+}
+
+/**
+ * @brief 微秒级忙等待延时（基于TIM2，最大65535us）
+ */
+void Platform_DelayUs(uint16_t us) {
+    __HAL_TIM_SET_COUNTER(&htim2, 0);
+    while (__HAL_TIM_GET_COUNTER(&htim2) < us);
+}
+
+void Platform_GPIO_Write(Platform_Pin_t pin, uint8_t level) {
+    HAL_GPIO_WritePin(pin_map[pin].port, pin_map[pin].pin, level ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+uint8_t Platform_GPIO_Read(Platform_Pin_t pin) {
+    return (HAL_GPIO_ReadPin(pin_map[pin].port, pin_map[pin].pin) == GPIO_PIN_SET) ? 1 : 0;
+}
+
+/**
+ * @brief 设置引脚的外部中断处理函数（中断线已由 CubeMX 配置并使能）
+ */
+void Platform_EXTI_SetHandler(Platform_Pin_t pin, Platform_IrqHandler_t handler) {
+    exti_handlers[pin] = handler;
+}
+
+void Platform_EnterCritical(void) {
+    __disable_irq();
+}
+
+void Platform_ExitCritical(void) {
+    __enable_irq();
+}
+
+/**
+ * @brief 硬件I2C1发送
+ * @return 0: 成功, 1: 失败（无应答或超时）
+ */
+uint8_t Platform_I2C_Write(uint8_t slave_addr, const uint8_t *data, uint16_t len, uint32_t timeout_ms) {
+    return (HAL_I2C_Master_Transmit(&hi2c1, (uint16_t)(slave_addr << 1), (uint8_t *)data, len, timeout_ms) == HAL_OK) ? 0 : 1;
+}
+
+/**
+ * @brief USART2 阻塞发送
+ */
+void Platform_UART_Write(const uint8_t *data, uint16_t len) {
+    HAL_UART_Transmit(&huart2, (uint8_t *)data, len, 0xFFFF);
+}
+
+/**
+ * @brief 轮询读取一个接收字节（RXNE，不占用接收中断）
+ * @return 1: 读到字节, 0: 无数据
+ */
+uint8_t Platform_UART_ReadByte(uint8_t *byte) {
+    if (!__HAL_UART_GET_FLAG(&huart2, UART_FLAG_RXNE)) {
+        return 0;
+    }
+    *byte = (uint8_t)(huart2.Instance->DR & 0xFF);
+    return 1;
+}
+
+void Platform_Halt(void) {
+    Error_Handler();
+}
+
+// printf 重定向到 USART2
+int __io_putchar(int ch) {
+    HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, 0xFFFF);
+    return ch;
+}
+
+/**
+ * @brief  外部中断回调: 按引脚分发到 Platform_EXTI_SetHandler 设置的处理函数
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    for (uint8_t i = 0; i < PLATFORM_PIN_COUNT; i++) {
+        if (pin_map[i].pin == GPIO_Pin && exti_handlers[i] != 0) {
+            exti_handlers[i]();
+        }
+    }
+}
+
+/**
+ * @brief  定时器更新中断回调: TIM3 溢出计数（64位微秒时间基准）
+ */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    if (htim->Instance == TIM3) {
+        Timebase_OverflowISR();
+    }
+}
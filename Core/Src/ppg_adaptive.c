@@ -0,0 +1,74 @@
+#include "ppg_adaptive.h"
+#include <string.h>
+#include <math.h>
+
+void PPG_Adaptive_Init(PPG_Adaptive_t *a) {
+    memset(a, 0, sizeof(PPG_Adaptive_t));
+    a->engine = PPG_ADAPTIVE_METHOD1;
+    a->may_escalate = 1;
+}
+
+void PPG_Adaptive_Process(PPG_Adaptive_t *a, DPT_State_t *dpt, uint32_t raw_red, uint32_t raw_ir) {
+    if (a->engine == PPG_ADAPTIVE_DPT) {
+        DPT_Process(dpt, raw_red, raw_ir);
+    } else {
+        DPT_ProcessShadow(dpt, raw_red, raw_ir);
+    }
+    a->samples[a->engine]++;
+}
+
+// 方法1本次原始心率与中位数不一致
+static uint8_t method1_disagrees(const HR_State_t *hr) {
+    return hr->raw_hr > 0.0f && hr->median_hr > 0.0f &&
+           fabsf(hr->raw_hr - hr->median_hr) > PPG_ADAPTIVE_DISAGREE_BPM;
+}
+
+// 方法1本次更新干净
+static uint8_t method1_clean(HR_State_t *hr) {
+    return HR_GetSignalQuality(hr) == 2 && !method1_disagrees(hr) && hr->ema_hr > 0.0f;
+}
+
+// 方法1与DPT一致（DPT无效时视为一致）
+static uint8_t method1_agrees(const HR_State_t *hr, const DPT_State_t *dpt) {
+    return !DPT_IsHeartRateValid(dpt) ||
+           fabsf(hr->ema_hr - DPT_GetHeartRate(dpt)) <= PPG_ADAPTIVE_AGREE_BPM;
+}
+
+// 连续计数，到上限为止
+static uint8_t vote(uint8_t votes, uint8_t yes, uint8_t limit) {
+    if (!yes) {
+        return 0;
+    }
+    return votes < limit ? votes + 1 : votes;
+}
+
+uint8_t PPG_Adaptive_Update(PPG_Adaptive_t *a, HR_State_t *hr, DPT_State_t *dpt) {
+    if (a->engine == PPG_ADAPTIVE_METHOD1) {
+        a->noisy_votes = vote(a->noisy_votes, HR_GetSignalQuality(hr) == 0 || method1_disagrees(hr),
+                              PPG_ADAPTIVE_ESCALATE_UPDATES);
+        a->invalid_votes = vote(a->invalid_votes, !HR_IsValid(hr), PPG_ADAPTIVE_INVALID_UPDATES);
+        // 条件持续满足时保持计数，影子缓冲区满或负载允许时立即升级
+        if ((a->noisy_votes >= PPG_ADAPTIVE_ESCALATE_UPDATES || a->invalid_votes >= PPG_ADAPTIVE_INVALID_UPDATES) &&
+            DPT_IsBufferFull(dpt)) {
+            if (a->may_escalate) {
+                DPT_Resume(dpt);
+                a->engine = PPG_ADAPTIVE_DPT;
+                a->noisy_votes = 0;
+                a->invalid_votes = 0;
+                a->recover_votes = 0;
+                a->escalations++;
+            } else {
+                a->held++;
+            }
+        }
+    } else {
+        a->recover_votes = vote(a->recover_votes, method1_clean(hr), PPG_ADAPTIVE_RECOVER_ALONE_UPDATES);
+        if ((a->recover_votes >= PPG_ADAPTIVE_RECOVER_UPDATES && method1_agrees(hr, dpt)) ||
+            a->recover_votes >= PPG_ADAPTIVE_RECOVER_ALONE_UPDATES) {
+            a->engine = PPG_ADAPTIVE_METHOD1;
+            a->recover_votes = 0;
+            a->deescalations++;
+        }
+    }
+    return a->engine;
+}
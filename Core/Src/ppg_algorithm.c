@@ -1,4 +1,8 @@
 #include "ppg_algorithm.h"
+#ifdef PPG_TUNABLE_PARAMS
+#include "ppg_algorithm_v2.h"  // PPG_PARAMS_DEFAULT
+#endif
+#include "trace.h"
 #include <string.h>
 #include <math.h>
 
@@ -11,6 +15,19 @@ static int compare_float(const void *a, const void *b) {
     return (fa > fb) - (fa < fb);
 }
 
+/**
+ * @brief 按时间顺序读取心率缓冲区（index=0 为最旧的样本）
+ * @note 缓冲区是环形的，写指针处新旧数据相接，直接按数组下标查找峰值会在接缝处
+ *       产生错误的峰值和间隔
+ */
+static inline float hr_sample(const HR_State_t *hr_state, uint16_t index) {
+    uint16_t pos = hr_state->buffer_index + index;
+    if (pos >= HR_BUFFER_SIZE) {
+        pos -= HR_BUFFER_SIZE;
+    }
+    return hr_state->buffer[pos];
+}
+
 /**
  * @brief 计算数组的中位数
  */
@@ -70,8 +87,36 @@ void HR_Init(HR_State_t *hr_state) {
     hr_state->ac_dc_ratio = 0.0f;
     hr_state->signal_quality = 0;
     hr_state->consecutive_invalid = 0;
+
+    hr_state->sample_rate_hz = HR_SAMPLE_RATE_HZ;
+
+#ifdef PPG_TUNABLE_PARAMS
+    hr_state->params = (PPG_Params_t)PPG_PARAMS_DEFAULT;
+#endif
 }
 
+/**
+ * @brief 设置实际采样率（传感器振荡器偏差约±1%，由采样时钟估计得到）
+ * @param hr_state 心率状态指针
+ * @param sample_rate_hz 采样率 (Hz)，非正值被忽略
+ */
+void HR_SetSampleRate(HR_State_t *hr_state, float sample_rate_hz) {
+    if (sample_rate_hz > 0.0f) {
+        hr_state->sample_rate_hz = sample_rate_hz;
+    }
+}
+
+#ifdef PPG_TUNABLE_PARAMS
+/**
+ * @brief 替换调参常量（主机参数搜索，见 ppg_params.h）
+ * @param hr_state 心率状态指针（HR_Init 之后）
+ * @param params 参数
+ */
+void HR_SetParams(HR_State_t *hr_state, const PPG_Params_t *params) {
+    hr_state->params = *params;
+}
+#endif
+
 /**
  * @brief 添加AC样本到心率缓冲区（增量更新统计）
  * @param hr_state 心率状态指针
@@ -219,7 +264,7 @@ float HR_Calculate(HR_State_t *hr_state) {
     // 如果信号质量差，增加无效计数
     if (hr_state->signal_quality == 0) {
         hr_state->consecutive_invalid++;
-        if (hr_state->consecutive_invalid >= INVALID_RESET_THRESHOLD) {
+        if (hr_state->consecutive_invalid >= PPG_PARAM(hr_state, invalid_reset_threshold, INVALID_RESET_THRESHOLD)) {
             HR_Reset(hr_state);
         }
         hr_state->hr_valid = 0;
@@ -229,8 +274,9 @@ float HR_Calculate(HR_State_t *hr_state) {
     }
 
     // 3. 自适应阈值（根据信号质量调整）
-    float threshold_multiplier = (hr_state->signal_quality == 2) ? 0.4f : 
-                               (hr_state->signal_quality == 1) ? 0.5f : 0.6f;
+    float threshold_multiplier = (hr_state->signal_quality == 2) ? PPG_PARAM(hr_state, peak_threshold_good, PEAK_THRESHOLD_GOOD) :
+                               (hr_state->signal_quality == 1) ? PPG_PARAM(hr_state, peak_threshold, PEAK_THRESHOLD) :
+                               PPG_PARAM(hr_state, peak_threshold_poor, PEAK_THRESHOLD_POOR);
     float threshold = mean + threshold_multiplier * std_dev;
 
     // 4. 查找峰值（使用更严格的条件）
@@ -246,23 +292,25 @@ float HR_Calculate(HR_State_t *hr_state) {
     // 查找所有峰值，同时计算峰峰值幅度
     for (uint16_t i = 3; i < HR_BUFFER_SIZE - 3; i++) {
         // 跟踪最小最大值
-        if (hr_state->buffer[i] < min_val) min_val = hr_state->buffer[i];
-        if (hr_state->buffer[i] > max_val) max_val = hr_state->buffer[i];
+        float value = hr_sample(hr_state, i);
+        if (value < min_val) min_val = value;
+        if (value > max_val) max_val = value;
         
         // 检查是否是局部最大值（使用更大的窗口：前后各3个样本）
-        if (hr_state->buffer[i] > hr_state->buffer[i - 1] &&
-            hr_state->buffer[i] > hr_state->buffer[i - 2] &&
-            hr_state->buffer[i] > hr_state->buffer[i - 3] &&
-            hr_state->buffer[i] > hr_state->buffer[i + 1] &&
-            hr_state->buffer[i] > hr_state->buffer[i + 2] &&
-            hr_state->buffer[i] > hr_state->buffer[i + 3] &&
-            hr_state->buffer[i] > threshold) {
+        if (value > hr_sample(hr_state, i - 1) &&
+            value > hr_sample(hr_state, i - 2) &&
+            value > hr_sample(hr_state, i - 3) &&
+            value > hr_sample(hr_state, i + 1) &&
+            value > hr_sample(hr_state, i + 2) &&
+            value > hr_sample(hr_state, i + 3) &&
+            value > threshold) {
 
             // 检查与上一个峰值的距离
             if (peak_count == 0 || (i - peaks[peak_count - 1].index) >= MIN_PEAK_DISTANCE) {
                 peaks[peak_count].index = i;
-                peaks[peak_count].value = hr_state->buffer[i];
+                peaks[peak_count].value = value;
                 peak_count++;
+                TRACE_EVENT(TRACE_EV_BEAT, i);
                 if (peak_count >= 20) break;
             }
         }
@@ -274,7 +322,7 @@ float HR_Calculate(HR_State_t *hr_state) {
     // 如果峰值太少，无法计算心率
     if (peak_count < 2) {
         hr_state->consecutive_invalid++;
-        if (hr_state->consecutive_invalid >= INVALID_RESET_THRESHOLD) {
+        if (hr_state->consecutive_invalid >= PPG_PARAM(hr_state, invalid_reset_threshold, INVALID_RESET_THRESHOLD)) {
             HR_Reset(hr_state);
         }
         hr_state->hr_valid = 0;
@@ -297,7 +345,7 @@ float HR_Calculate(HR_State_t *hr_state) {
 
     if (valid_interval_count < 2) {
         hr_state->consecutive_invalid++;
-        if (hr_state->consecutive_invalid >= INVALID_RESET_THRESHOLD) {
+        if (hr_state->consecutive_invalid >= PPG_PARAM(hr_state, invalid_reset_threshold, INVALID_RESET_THRESHOLD)) {
             HR_Reset(hr_state);
         }
         hr_state->hr_valid = 0;
@@ -341,13 +389,14 @@ float HR_Calculate(HR_State_t *hr_state) {
     }
 
     // 7. 计算心率 (BPM)
-    // 心率 = 60 / (间隔时间) = 60 / (median_interval / 100) = 6000 / median_interval
-    float hr = 6000.0f / median_interval;
+    // 心率 = 60 / (间隔时间) = 60 / (median_interval / fs) = 60 * fs / median_interval
+    float hr = 60.0f * hr_state->sample_rate_hz / median_interval;
+    hr_state->raw_hr = hr;
 
     // 8. 合理性检查
     if (hr < 30.0f || hr > 180.0f) {
         hr_state->consecutive_invalid++;
-        if (hr_state->consecutive_invalid >= INVALID_RESET_THRESHOLD) {
+        if (hr_state->consecutive_invalid >= PPG_PARAM(hr_state, invalid_reset_threshold, INVALID_RESET_THRESHOLD)) {
             HR_Reset(hr_state);
         }
         hr_state->hr_valid = 0;
@@ -363,17 +412,20 @@ float HR_Calculate(HR_State_t *hr_state) {
 
     // 计算中位数滤波后的心率
     float filtered_hr = median_filter(hr_state->hr_history, hr_state->hr_history_count);
+    hr_state->median_hr = filtered_hr;
 
     // 10. 变化率限制（防止突变）
     if (hr_state->ema_hr > 0.0f) {
         float diff = filtered_hr - hr_state->ema_hr;
         // 限制单次变化幅度
-        if (diff > MAX_HR_CHANGE) {
-            filtered_hr = hr_state->ema_hr + MAX_HR_CHANGE;
-        } else if (diff < -MAX_HR_CHANGE) {
-            filtered_hr = hr_state->ema_hr - MAX_HR_CHANGE;
+        float max_change = PPG_PARAM(hr_state, max_hr_change, MAX_HR_CHANGE);
+        if (diff > max_change) {
+            filtered_hr = hr_state->ema_hr + max_change;
+        } else if (diff < -max_change) {
+            filtered_hr = hr_state->ema_hr - max_change;
         }
     }
+    hr_state->limited_hr = filtered_hr;
 
     // 11. EMA平滑（指数移动平均）
     if (hr_state->ema_hr == 0.0f) {
@@ -381,7 +433,8 @@ float HR_Calculate(HR_State_t *hr_state) {
         hr_state->ema_hr = filtered_hr;
     } else {
         // EMA公式: EMA(t) = alpha * value(t) + (1-alpha) * EMA(t-1)
-        hr_state->ema_hr = HR_EMA_ALPHA * filtered_hr + (1.0f - HR_EMA_ALPHA) * hr_state->ema_hr;
+        float alpha = PPG_PARAM(hr_state, hr_ema_alpha, HR_EMA_ALPHA);
+        hr_state->ema_hr = alpha * filtered_hr + (1.0f - alpha) * hr_state->ema_hr;
     }
 
     // 12. 稳定性检查（需要连续几次稳定的测量）
@@ -414,6 +467,23 @@ uint8_t HR_IsValid(HR_State_t *hr_state) {
     return hr_state->hr_valid;
 }
 
+/**
+ * @brief 显示值平滑（只在心率有效时调用）
+ * @param displayed_hr 当前显示的心率，0表示尚未显示
+ * @param heart_rate HR_Calculate 的输出
+ * @return 新的显示心率
+ * @note 与显示值相差不超过 DISPLAY_HR_THRESHOLD 时保持不变，避免数字来回跳动
+ */
+float HR_DisplaySmooth(float displayed_hr, float heart_rate) {
+    if (displayed_hr == 0.0f) {
+        return heart_rate;
+    }
+    if (fabsf(heart_rate - displayed_hr) > DISPLAY_HR_THRESHOLD) {
+        return DISPLAY_EMA_ALPHA * heart_rate + (1.0f - DISPLAY_EMA_ALPHA) * displayed_hr;
+    }
+    return displayed_hr;
+}
+
 /**
  * @brief 初始化血氧状态
  * @param spo2_state 血氧状态指针
@@ -8,6 +8,9 @@
  */
 
 #include "ppg_algorithm_v2.h"
+#ifdef PPG_TUNABLE_PARAMS
+#include "ppg_algorithm.h"            // PPG_PARAMS_DEFAULT
+#endif
 #include <math.h>
 #include <string.h>
 
@@ -31,17 +34,17 @@
 #define MIN_HEART_RATE          30.0f
 #define MAX_HEART_RATE          150.0f
 #define MIN_DC_VALUE            10000       // Minimum DC for valid signal (raised for MAX30102)
-#define MIN_PEAK_MAGNITUDE      0.5f        // Minimum spectrum peak (lowered after normalization)
 
 /* ==================== Private Function Prototypes ==================== */
 
 static void iir_filter_init(DPT_IIR_State_t *filter);
 static void iir_filter_process(DPT_IIR_State_t *filter, int32_t raw_value);
 static void dpt_transform_init(DPT_Transform_t *dpt);
+static uint16_t dpt_buffer_write(DPT_Transform_t *dpt, int32_t ac_value);
 static void dpt_transform_process(DPT_Transform_t *dpt, int32_t ac_value,
                                   const float *cos_basis, const float *sin_basis);
 static void compute_magnitude_spectrum(DPT_Transform_t *dpt);
-static uint16_t find_peak_period(const DPT_Transform_t *dpt);
+static uint16_t find_peak_period(const DPT_Transform_t *dpt, float min_magnitude);
 static float smooth_array(const float *data, uint8_t size);
 static float median_filter(float *data, uint8_t size);
 static void precompute_basis_functions(DPT_State_t *state);
@@ -73,10 +76,35 @@ void DPT_Init(DPT_State_t *state)
     state->heart_rate = 0.0f;
     state->spo2 = 0.0f;
     state->peak_period = 0;
+    state->sample_rate_hz = (float)DPT_SAMPLE_RATE_HZ;
     state->hr_valid = false;
     state->spo2_valid = false;
+
+#ifdef PPG_TUNABLE_PARAMS
+    state->params = (PPG_Params_t)PPG_PARAMS_DEFAULT;
+#endif
+}
+
+/**
+ * @brief Set the measured sensor sample rate
+ */
+void DPT_SetSampleRate(DPT_State_t *state, float sample_rate_hz)
+{
+    if (state == NULL || sample_rate_hz <= 0.0f) return;
+    state->sample_rate_hz = sample_rate_hz;
 }
 
+#ifdef PPG_TUNABLE_PARAMS
+/**
+ * @brief Replace the tuning constants
+ */
+void DPT_SetParams(DPT_State_t *state, const PPG_Params_t *params)
+{
+    if (state == NULL || params == NULL) return;
+    state->params = *params;
+}
+#endif
+
 /**
  * @brief Process one sample of red and IR data
  */
@@ -106,12 +134,13 @@ void DPT_Process(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir)
     compute_magnitude_spectrum(&state->ir_dpt);
 
     // Step 5: Find peak period in IR spectrum (dominant signal)
-    state->peak_period = find_peak_period(&state->ir_dpt);
+    state->peak_period = find_peak_period(&state->ir_dpt,
+                                          PPG_PARAM(state, dpt_min_peak_magnitude, DPT_MIN_PEAK_MAGNITUDE));
 
     // Step 6: Calculate heart rate from peak period with enhanced smoothing
-    // HR (bpm) = 6000 / peak_period (in 10ms intervals)
+    // HR (bpm) = 60 * fs / peak_period (peak_period in samples)
     if (state->peak_period > 0) {
-        float raw_hr = 6000.0f / (float)state->peak_period;
+        float raw_hr = 60.0f * state->sample_rate_hz / (float)state->peak_period;
 
         // Validate raw heart rate range
         if (raw_hr >= MIN_HEART_RATE && raw_hr <= MAX_HEART_RATE) {
@@ -122,16 +151,20 @@ void DPT_Process(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir)
 
             // 2. Apply median filter (7-point)
             float median_hr = median_filter(state->hr_median_buffer, DPT_MEDIAN_SIZE);
+            state->raw_hr = raw_hr;
+            state->median_hr = median_hr;
 
             // 3. Rate limiting: prevent large jumps
             if (state->last_valid_hr > 0.0f) {
                 float hr_diff = median_hr - state->last_valid_hr;
-                if (hr_diff > DPT_MAX_HR_CHANGE) {
-                    median_hr = state->last_valid_hr + DPT_MAX_HR_CHANGE;
-                } else if (hr_diff < -DPT_MAX_HR_CHANGE) {
-                    median_hr = state->last_valid_hr - DPT_MAX_HR_CHANGE;
+                float max_change = PPG_PARAM(state, dpt_max_hr_change, DPT_MAX_HR_CHANGE);
+                if (hr_diff > max_change) {
+                    median_hr = state->last_valid_hr + max_change;
+                } else if (hr_diff < -max_change) {
+                    median_hr = state->last_valid_hr - max_change;
                 }
             }
+            state->limited_hr = median_hr;
 
             // 4. EMA smoothing
             if (state->ema_hr == 0.0f) {
@@ -139,8 +172,8 @@ void DPT_Process(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir)
                 state->ema_hr = median_hr;
             } else {
                 // Apply EMA: alpha * new + (1-alpha) * old
-                state->ema_hr = DPT_HR_EMA_ALPHA * median_hr +
-                               (1.0f - DPT_HR_EMA_ALPHA) * state->ema_hr;
+                float alpha = PPG_PARAM(state, dpt_hr_ema_alpha, DPT_HR_EMA_ALPHA);
+                state->ema_hr = alpha * median_hr + (1.0f - alpha) * state->ema_hr;
             }
 
             // 5. Update final heart rate
@@ -206,6 +239,65 @@ void DPT_Process(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir)
     }
 }
 
+/**
+ * @brief Keep the state warm without running the transform
+ */
+void DPT_ProcessShadow(DPT_State_t *state, uint32_t raw_red, uint32_t raw_ir)
+{
+    if (state == NULL) return;
+
+    iir_filter_process(&state->red_filter, (int32_t)raw_red);
+    iir_filter_process(&state->ir_filter, (int32_t)raw_ir);
+    dpt_buffer_write(&state->red_dpt, state->red_filter.ac_value);
+    dpt_buffer_write(&state->ir_dpt, state->ir_filter.ac_value);
+
+    // Results stop being current
+    state->hr_valid = false;
+    state->spo2_valid = false;
+}
+
+/**
+ * @brief Restart the transform and the result smoothing on the buffered samples
+ */
+void DPT_Resume(DPT_State_t *state)
+{
+    if (state == NULL) return;
+
+    DPT_Transform_t *dpt[2] = { &state->red_dpt, &state->ir_dpt };
+    for (uint8_t ch = 0; ch < 2; ch++) {
+        memset(dpt[ch]->real, 0, sizeof(dpt[ch]->real));
+        memset(dpt[ch]->imag, 0, sizeof(dpt[ch]->imag));
+        memset(dpt[ch]->magnitude, 0, sizeof(dpt[ch]->magnitude));
+    }
+
+    state->heart_rate = 0.0f;
+    state->spo2 = 0.0f;
+    state->peak_period = 0;
+    state->raw_hr = 0.0f;
+    state->median_hr = 0.0f;
+    state->limited_hr = 0.0f;
+    state->ema_hr = 0.0f;
+    state->last_valid_hr = 0.0f;
+    state->stable_count = 0;
+    memset(state->r_history, 0, sizeof(state->r_history));
+    state->r_index = 0;
+    memset(state->hr_history, 0, sizeof(state->hr_history));
+    state->hr_index = 0;
+    memset(state->hr_median_buffer, 0, sizeof(state->hr_median_buffer));
+    state->hr_median_index = 0;
+    state->hr_valid = false;
+    state->spo2_valid = false;
+}
+
+/**
+ * @brief Check whether the sample buffers are full
+ */
+bool DPT_IsBufferFull(const DPT_State_t *state)
+{
+    if (state == NULL) return false;
+    return state->red_dpt.buffer_full && state->ir_dpt.buffer_full;
+}
+
 /**
  * @brief Get calculated heart rate
  */
@@ -332,15 +424,11 @@ static void precompute_basis_functions(DPT_State_t *state)
 }
 
 /**
- * @brief Process one sample through DPT transform
- * @details Implements sliding DPT: T_new = e^(-j*2*pi/period) * (T_old - x_old + x_new)
+ * @brief Add a sample to the circular buffer
+ * @return Buffer position the sample was written to
  */
-static void dpt_transform_process(DPT_Transform_t *dpt, int32_t ac_value,
-                                  const float *cos_basis, const float *sin_basis)
+static uint16_t dpt_buffer_write(DPT_Transform_t *dpt, int32_t ac_value)
 {
-    if (dpt == NULL || cos_basis == NULL || sin_basis == NULL) return;
-
-    // Add new sample to circular buffer
     dpt->recursive_buffer[dpt->buffer_index] = ac_value;
     uint16_t current_idx = dpt->buffer_index;
     dpt->buffer_index = (dpt->buffer_index + 1) % DPT_BUFFER_SIZE;
@@ -350,6 +438,19 @@ static void dpt_transform_process(DPT_Transform_t *dpt, int32_t ac_value,
     if (dpt->sample_count >= DPT_BUFFER_SIZE) {
         dpt->buffer_full = true;
     }
+    return current_idx;
+}
+
+/**
+ * @brief Process one sample through DPT transform
+ * @details Implements sliding DPT: T_new = e^(-j*2*pi/period) * (T_old - x_old + x_new)
+ */
+static void dpt_transform_process(DPT_Transform_t *dpt, int32_t ac_value,
+                                  const float *cos_basis, const float *sin_basis)
+{
+    if (dpt == NULL || cos_basis == NULL || sin_basis == NULL) return;
+
+    uint16_t current_idx = dpt_buffer_write(dpt, ac_value);
 
     // Only perform DPT when buffer has enough data
     if (!dpt->buffer_full) return;
@@ -413,7 +514,7 @@ static void compute_magnitude_spectrum(DPT_Transform_t *dpt)
  * @brief Find peak period in magnitude spectrum
  * @return Peak period in samples (0 if no valid peak found)
  */
-static uint16_t find_peak_period(const DPT_Transform_t *dpt)
+static uint16_t find_peak_period(const DPT_Transform_t *dpt, float min_magnitude)
 {
     if (dpt == NULL) return 0;
 
@@ -429,7 +530,7 @@ static uint16_t find_peak_period(const DPT_Transform_t *dpt)
     }
 
     // Validate peak
-    if (max_magnitude < MIN_PEAK_MAGNITUDE) {
+    if (max_magnitude < min_magnitude) {
         return 0;
     }
 
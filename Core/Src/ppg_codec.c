@@ -0,0 +1,414 @@
+#include "ppg_codec.h"
+#include <string.h>
+
+// 按位写入器（高位在前）
+typedef struct {
+    uint8_t *buf;
+    uint16_t capacity;
+    uint32_t bit_pos;
+    uint8_t overflow;
+} BitWriter_t;
+
+// 按位读取器（高位在前）
+typedef struct {
+    const uint8_t *buf;
+    uint16_t len;
+    uint32_t bit_pos;
+    uint8_t underflow;
+} BitReader_t;
+
+static void bw_put(BitWriter_t *bw, uint32_t value, uint8_t bits) {
+    while (bits > 0) {
+        bits--;
+        uint32_t byte_idx = bw->bit_pos >> 3;
+        if (byte_idx >= bw->capacity) {
+            bw->overflow = 1;
+            return;
+        }
+        uint8_t mask = (uint8_t)(0x80u >> (bw->bit_pos & 7u));
+        if ((bw->bit_pos & 7u) == 0) {
+            bw->buf[byte_idx] = 0;
+        }
+        if ((value >> bits) & 1u) {
+            bw->buf[byte_idx] |= mask;
+        }
+        bw->bit_pos++;
+    }
+}
+
+static void bw_put_ones(BitWriter_t *bw, uint8_t count) {
+    while (count > 0) {
+        uint8_t n = (count > 24) ? 24 : count;
+        bw_put(bw, (1u << n) - 1u, n);
+        count -= n;
+    }
+}
+
+static uint32_t br_get(BitReader_t *br, uint8_t bits) {
+    uint32_t value = 0;
+    while (bits > 0) {
+        bits--;
+        uint32_t byte_idx = br->bit_pos >> 3;
+        if (byte_idx >= br->len) {
+            br->underflow = 1;
+            return 0;
+        }
+        value = (value << 1) | ((br->buf[byte_idx] >> (7u - (br->bit_pos & 7u))) & 1u);
+        br->bit_pos++;
+    }
+    return value;
+}
+
+static uint32_t zigzag_encode(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1u);
+}
+
+static int32_t predict(const PPG_CodecChannel_t *ch, uint8_t order) {
+    return (order == 2) ? (2 * ch->h1 - ch->h2) : ch->h1;
+}
+
+/**
+ * @brief 计算一组残差在参数k下的Rice码总位数
+ */
+static uint32_t rice_cost(const uint32_t *u, uint8_t n, uint8_t k) {
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint32_t q = u[i] >> k;
+        if (q >= PPG_CODEC_RICE_ESCAPE) {
+            bits += PPG_CODEC_RICE_ESCAPE + PPG_CODEC_RAW_BITS;
+        } else {
+            bits += q + 1u + k;
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief 为一组残差选择最优Rice参数
+ * @details 先由均值估计 k0 ≈ log2(mean)，再在 k0-2..k0+1 范围内精确比较
+ */
+static uint8_t rice_select_k(const uint32_t *u, uint8_t n, uint32_t *best_bits) {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        sum += u[i];
+    }
+    uint32_t mean = (n > 0) ? sum / n : 0;
+
+    uint8_t k0 = 0;
+    while (k0 < PPG_CODEC_MAX_K && (mean >> k0) > 1u) {
+        k0++;
+    }
+
+    uint8_t k_lo = (k0 >= 2) ? (uint8_t)(k0 - 2) : 0;
+    uint8_t k_hi = (k0 + 1 <= PPG_CODEC_MAX_K) ? (uint8_t)(k0 + 1) : PPG_CODEC_MAX_K;
+
+    uint8_t best_k = k_lo;
+    uint32_t best = 0xFFFFFFFFu;
+    for (uint8_t k = k_lo; k <= k_hi; k++) {
+        uint32_t bits = rice_cost(u, n, k);
+        if (bits < best) {
+            best = bits;
+            best_k = k;
+        }
+    }
+    *best_bits = best;
+    return best_k;
+}
+
+/**
+ * @brief 计算通道残差（从 start 开始），不修改通道历史
+ */
+static void compute_residuals(const PPG_CodecChannel_t *ch_in, const uint32_t *x,
+                              uint8_t start, uint8_t n, uint8_t order, uint32_t *u) {
+    PPG_CodecChannel_t ch = *ch_in;
+    for (uint8_t i = start; i < n; i++) {
+        int32_t xi = (int32_t)x[i];
+        u[i - start] = zigzag_encode(xi - predict(&ch, order));
+        ch.h2 = ch.h1;
+        ch.h1 = xi;
+    }
+}
+
+/**
+ * @brief 初始化编码器
+ * @param enc 编码器状态指针
+ */
+void PPG_Encoder_Init(PPG_Encoder_t *enc) {
+    memset(enc, 0, sizeof(PPG_Encoder_t));
+    enc->force_key = 1;
+}
+
+/**
+ * @brief 下一个块强制编码为关键块（例如新帧丢失后重新同步）
+ * @param enc 编码器状态指针
+ */
+void PPG_Encoder_ForceKeyframe(PPG_Encoder_t *enc) {
+    enc->force_key = 1;
+}
+
+/**
+ * @brief 缓存一个样本对
+ * @param enc 编码器状态指针
+ * @param red 红光原始值（18位）
+ * @param ir 红外原始值（18位）
+ * @return 1: 块已满，应调用 PPG_Encoder_Flush, 0: 未满
+ */
+uint8_t PPG_Encoder_Push(PPG_Encoder_t *enc, uint32_t red, uint32_t ir) {
+    if (enc->count < PPG_CODEC_BLOCK_SIZE) {
+        enc->red[enc->count] = red & PPG_CODEC_SAMPLE_MASK;
+        enc->ir[enc->count] = ir & PPG_CODEC_SAMPLE_MASK;
+        enc->count++;
+    }
+    return (enc->count >= PPG_CODEC_BLOCK_SIZE) ? 1 : 0;
+}
+
+/**
+ * @brief 把已缓存的样本编码为一个块
+ * @param enc 编码器状态指针
+ * @param out 输出缓冲区
+ * @param capacity 输出缓冲区大小（建议 >= PPG_CODEC_MAX_BLOCK_BYTES）
+ * @return 写入的字节数，0 表示无样本或缓冲区不足
+ */
+uint16_t PPG_Encoder_Flush(PPG_Encoder_t *enc, uint8_t *out, uint16_t capacity) {
+    if (enc->count == 0) {
+        return 0;
+    }
+
+    uint8_t key = enc->force_key || (enc->blocks_since_key >= PPG_CODEC_KEYFRAME_INTERVAL);
+    uint8_t start = key ? 1 : 0;
+    const uint32_t *data[2] = { enc->red, enc->ir };
+
+    // 关键块: 首样本原样写入，预测器历史以首样本重置
+    PPG_CodecChannel_t hist[2];
+    for (uint8_t c = 0; c < 2; c++) {
+        hist[c] = enc->ch[c];
+        if (key) {
+            hist[c].h1 = (int32_t)data[c][0];
+            hist[c].h2 = (int32_t)data[c][0];
+        }
+    }
+
+    // 为每个通道选择预测阶数和Rice参数
+    uint32_t u[2][PPG_CODEC_BLOCK_SIZE];
+    uint8_t order[2], k[2];
+    uint8_t n = (uint8_t)(enc->count - start);
+    for (uint8_t c = 0; c < 2; c++) {
+        uint32_t u2[PPG_CODEC_BLOCK_SIZE];
+        uint32_t bits1, bits2;
+        compute_residuals(&hist[c], data[c], start, enc->count, 1, u[c]);
+        compute_residuals(&hist[c], data[c], start, enc->count, 2, u2);
+        uint8_t k1 = rice_select_k(u[c], n, &bits1);
+        uint8_t k2 = rice_select_k(u2, n, &bits2);
+        if (bits2 < bits1) {
+            order[c] = 2;
+            k[c] = k2;
+            memcpy(u[c], u2, sizeof(u2));
+        } else {
+            order[c] = 1;
+            k[c] = k1;
+        }
+    }
+
+    BitWriter_t bw = { out, capacity, 0, 0 };
+    bw_put(&bw, key, 1);
+    bw_put(&bw, (uint32_t)(enc->count - 1), 4);
+    for (uint8_t c = 0; c < 2; c++) {
+        bw_put(&bw, (uint32_t)(order[c] - 1), 1);
+        bw_put(&bw, k[c], 5);
+    }
+    if (key) {
+        bw_put(&bw, data[0][0], PPG_CODEC_SAMPLE_BITS);
+        bw_put(&bw, data[1][0], PPG_CODEC_SAMPLE_BITS);
+    }
+    for (uint8_t c = 0; c < 2; c++) {
+        for (uint8_t i = 0; i < n; i++) {
+            uint32_t q = u[c][i] >> k[c];
+            if (q >= PPG_CODEC_RICE_ESCAPE) {
+                bw_put_ones(&bw, PPG_CODEC_RICE_ESCAPE);
+                bw_put(&bw, u[c][i], PPG_CODEC_RAW_BITS);
+            } else {
+                bw_put_ones(&bw, (uint8_t)q);
+                bw_put(&bw, 0, 1);
+                bw_put(&bw, u[c][i] & ((1u << k[c]) - 1u), k[c]);
+            }
+        }
+    }
+
+    if (bw.overflow) {
+        return 0;
+    }
+
+    // 提交: 更新预测器历史
+    for (uint8_t c = 0; c < 2; c++) {
+        enc->ch[c].h1 = (int32_t)data[c][enc->count - 1];
+        enc->ch[c].h2 = (enc->count >= 2) ? (int32_t)data[c][enc->count - 2] : hist[c].h1;
+    }
+    enc->blocks_since_key = key ? 1 : (uint16_t)(enc->blocks_since_key + 1);
+    enc->force_key = 0;
+    enc->count = 0;
+
+    return (uint16_t)((bw.bit_pos + 7u) >> 3);
+}
+
+/**
+ * @brief 初始化解码器
+ * @param dec 解码器状态指针
+ */
+void PPG_Decoder_Init(PPG_Decoder_t *dec) {
+    memset(dec, 0, sizeof(PPG_Decoder_t));
+}
+
+/**
+ * @brief 解码一个块
+ * @param dec 解码器状态指针
+ * @param in 输入数据（块起始处）
+ * @param len 可用字节数
+ * @param red 输出红光样本（至少 PPG_CODEC_BLOCK_SIZE 个）
+ * @param ir 输出红外样本（至少 PPG_CODEC_BLOCK_SIZE 个）
+ * @param count 输出该块的样本对数
+ * @return 消耗的字节数; -1: 数据截断
+ * @note 返回后仅当 dec->synced 为1时输出样本有效；丢帧后需等到下一个关键块
+ */
+int16_t PPG_Decoder_DecodeBlock(PPG_Decoder_t *dec, const uint8_t *in, uint16_t len,
+                                uint32_t *red, uint32_t *ir, uint8_t *count) {
+    BitReader_t br = { in, len, 0, 0 };
+    uint32_t *data[2] = { red, ir };
+    uint8_t order[2], k[2];
+
+    uint8_t key = (uint8_t)br_get(&br, 1);
+    uint8_t n_total = (uint8_t)(br_get(&br, 4) + 1);
+    for (uint8_t c = 0; c < 2; c++) {
+        order[c] = (uint8_t)(br_get(&br, 1) + 1);
+        k[c] = (uint8_t)br_get(&br, 5);
+    }
+
+    PPG_CodecChannel_t hist[2] = { dec->ch[0], dec->ch[1] };
+    uint8_t start = 0;
+    if (key) {
+        for (uint8_t c = 0; c < 2; c++) {
+            data[c][0] = br_get(&br, PPG_CODEC_SAMPLE_BITS);
+            hist[c].h1 = (int32_t)data[c][0];
+            hist[c].h2 = (int32_t)data[c][0];
+        }
+        start = 1;
+    }
+
+    for (uint8_t c = 0; c < 2; c++) {
+        for (uint8_t i = start; i < n_total; i++) {
+            uint32_t q = 0;
+            while (q < PPG_CODEC_RICE_ESCAPE && br_get(&br, 1) == 1u) {
+                q++;
+                if (br.underflow) break;
+            }
+            uint32_t u;
+            if (q >= PPG_CODEC_RICE_ESCAPE) {
+                u = br_get(&br, PPG_CODEC_RAW_BITS);
+            } else {
+                u = (q << k[c]) | br_get(&br, k[c]);
+            }
+            int32_t x = predict(&hist[c], order[c]) + zigzag_decode(u);
+            data[c][i] = (uint32_t)x & PPG_CODEC_SAMPLE_MASK;
+            hist[c].h2 = hist[c].h1;
+            hist[c].h1 = x;
+        }
+    }
+
+    if (br.underflow) {
+        return -1;
+    }
+
+    *count = n_total;
+    if (key || dec->synced) {
+        dec->ch[0] = hist[0];
+        dec->ch[1] = hist[1];
+        dec->synced = 1;
+    }
+    return (int16_t)((br.bit_pos + 7u) >> 3);
+}
+
+/**
+ * @brief 初始化采集模式
+ * @param cap 采集状态指针
+ */
+void PPG_Capture_Init(PPG_Capture_t *cap) {
+    memset(cap, 0, sizeof(PPG_Capture_t));
+    PPG_Encoder_Init(&cap->enc);
+}
+
+/**
+ * @brief 发送当前帧（若非空）
+ */
+static void capture_send_frame(PPG_Capture_t *cap) {
+    if (cap->frame_blocks == 0) {
+        return;
+    }
+    cap->frame[0] = (uint8_t)(cap->frame_first_index & 0xFF);
+    cap->frame[1] = (uint8_t)((cap->frame_first_index >> 8) & 0xFF);
+    cap->frame[2] = (uint8_t)((cap->frame_first_index >> 16) & 0xFF);
+    cap->frame[3] = (uint8_t)((cap->frame_first_index >> 24) & 0xFF);
+    cap->frame[4] = cap->frame_blocks;
+
+    if (TLM_Send(TLM_TYPE_RAW_PPG, cap->frame, cap->frame_len) != 0) {
+        // 帧丢失后下一块必须是关键块，接收端才能重新同步
+        PPG_Encoder_ForceKeyframe(&cap->enc);
+    } else {
+        cap->bytes_out += cap->frame_len;
+    }
+    cap->frame_blocks = 0;
+    cap->frame_len = PPG_CAPTURE_FRAME_HEADER;
+}
+
+/**
+ * @brief 编码当前块并写入帧，必要时发送
+ */
+static void capture_encode_block(PPG_Capture_t *cap) {
+    uint8_t block[PPG_CODEC_MAX_BLOCK_BYTES];
+    uint8_t n = cap->enc.count;
+    uint16_t bytes = PPG_Encoder_Flush(&cap->enc, block, sizeof(block));
+    if (bytes == 0) {
+        return;
+    }
+
+    if (cap->frame_blocks == 0) {
+        cap->frame_len = PPG_CAPTURE_FRAME_HEADER;
+        cap->frame_first_index = cap->sample_index - n;
+    } else if (cap->frame_len + bytes > TLM_MAX_PAYLOAD) {
+        capture_send_frame(cap);
+        cap->frame_first_index = cap->sample_index - n;
+    }
+
+    memcpy(&cap->frame[cap->frame_len], block, bytes);
+    cap->frame_len += bytes;
+    cap->frame_blocks++;
+    cap->samples_out += n;
+
+    if (cap->frame_blocks >= PPG_CAPTURE_BLOCKS_PER_FRAME) {
+        capture_send_frame(cap);
+    }
+}
+
+/**
+ * @brief 采集一个样本对，块满时编码、帧满时发送
+ * @param cap 采集状态指针
+ * @param red 红光原始值
+ * @param ir 红外原始值
+ */
+void PPG_Capture_Push(PPG_Capture_t *cap, uint32_t red, uint32_t ir) {
+    cap->sample_index++;
+    if (PPG_Encoder_Push(&cap->enc, red, ir)) {
+        capture_encode_block(cap);
+    }
+}
+
+/**
+ * @brief 编码并发送所有缓存数据（停止采集时调用）
+ * @param cap 采集状态指针
+ */
+void PPG_Capture_Flush(PPG_Capture_t *cap) {
+    capture_encode_block(cap);
+    capture_send_frame(cap);
+}
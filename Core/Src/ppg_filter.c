@@ -78,7 +78,8 @@ static float detrend_signal(PPG_FilterState_t *filter, float value) {
     }
 
     // 计算移动平均（基线）
-    uint16_t count = filter->detrend_filled ? DETREND_WINDOW_SIZE : filter->detrend_index;
+    uint16_t count = filter->detrend_index;
+    if (filter->detrend_filled) count = DETREND_WINDOW_SIZE;
     if (count == 0) count = 1;  // 防止除零
 
     float baseline = filter->detrend_sum / count;
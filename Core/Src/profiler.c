@@ -0,0 +1,224 @@
+#include "profiler.h"
+#include <string.h>
+
+static const char *const stage_names[PROF_STAGE_COUNT] = {
+    "fifo_read",
+    "filter",
+    "hr_add",
+    "hr_calc",
+    "spo2_calc",
+    "dpt_process",
+    "oled_refresh",
+    "loop",
+};
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 周期数对应的直方图区间（按4倍递增: <256, <1K, ... , >=1M）
+ */
+uint8_t PROF_HistBin(uint32_t cycles) {
+    if (cycles < 256u) {
+        return 0;
+    }
+    uint8_t log2 = (uint8_t)(31 - __builtin_clz(cycles));   // Cortex-M3 上为单条 CLZ 指令
+    uint8_t bin = (uint8_t)((log2 - 8) / 2 + 1);
+    return (bin >= PROF_HIST_BINS) ? (uint8_t)(PROF_HIST_BINS - 1) : bin;
+}
+
+/**
+ * @brief 阶段名称
+ */
+const char *PROF_StageName(uint8_t stage) {
+    return (stage < PROF_STAGE_COUNT) ? stage_names[stage] : "unknown";
+}
+
+/**
+ * @brief 解码一帧 TLM_TYPE_PROFILE 报告
+ * @return 0: 成功, 1: 格式错误或版本不符
+ */
+uint8_t PROF_DecodeReport(const uint8_t *payload, uint16_t len, PROF_Report_t *report) {
+    memset(report, 0, sizeof(PROF_Report_t));
+    if (len < PROF_REPORT_HEADER || payload[0] != PROF_REPORT_VERSION) {
+        return 1;
+    }
+    report->cpu_hz = rd32(&payload[1]);
+    report->interval_ms = rd32(&payload[5]);
+    uint8_t stages = payload[9];
+    if (stages > PROF_STAGE_COUNT || len != PROF_REPORT_HEADER + stages * PROF_REPORT_STAGE_SIZE) {
+        return 1;
+    }
+
+    const uint8_t *p = &payload[PROF_REPORT_HEADER];
+    for (uint8_t i = 0; i < stages; i++, p += PROF_REPORT_STAGE_SIZE) {
+        PROF_StageStats_t *s = &report->stages[i];
+        report->stage_id[i] = p[0];
+        s->count = rd32(&p[1]);
+        s->total = rd32(&p[5]);
+        s->min = rd32(&p[9]);
+        s->max = rd32(&p[13]);
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+            s->hist[b] = (uint16_t)(p[17 + 2 * b] | (p[18 + 2 * b] << 8));
+        }
+    }
+    report->stage_count = stages;
+    return 0;
+}
+
+#if PROFILER_ENABLED
+
+#include "telemetry.h"
+
+static PROF_StageStats_t prof_stats[PROF_STAGE_COUNT];
+static uint32_t prof_overhead = 0;      // 一对空的 BEGIN/END 本身的周期数
+static uint32_t prof_last_report_ms = 0;
+static uint32_t prof_interval_ms = PROF_REPORT_INTERVAL_MS;   // 本次报告覆盖的时间
+
+static void wr32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 清零全部统计
+ */
+void PROF_Reset(void) {
+    memset(prof_stats, 0, sizeof(prof_stats));
+    for (uint8_t i = 0; i < PROF_STAGE_COUNT; i++) {
+        prof_stats[i].min = 0xFFFFFFFFu;
+    }
+}
+
+/**
+ * @brief 使能 DWT 周期计数器并标定测量开销
+ */
+void PROF_Init(void) {
+#ifndef PROFILER_HOST
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    // 取多次空测量的最小值作为固定开销，之后从每次测量中扣除
+    prof_overhead = 0;
+    uint32_t best = 0xFFFFFFFFu;
+    for (uint8_t i = 0; i < 16; i++) {
+        uint32_t t0 = PROF_NOW();
+        uint32_t t1 = PROF_NOW();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
+    }
+    prof_overhead = best;
+    PROF_Reset();
+}
+
+/**
+ * @brief 记录一次测量
+ * @param stage 阶段
+ * @param cycles 测得的周期数（含测量开销）
+ */
+void PROF_Record(PROF_Stage_t stage, uint32_t cycles) {
+    if ((uint32_t)stage >= PROF_STAGE_COUNT) {
+        return;
+    }
+    PROF_StageStats_t *s = &prof_stats[stage];
+    cycles = (cycles > prof_overhead) ? cycles - prof_overhead : 0;
+
+    s->count++;
+    s->total += cycles;
+    if (cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+    uint8_t bin = PROF_HistBin(cycles);
+    if (s->hist[bin] != 0xFFFF) {
+        s->hist[bin]++;
+    }
+}
+
+/**
+ * @brief 发送一帧报告
+ */
+static uint8_t send_report(uint8_t *frame, uint8_t stages, uint16_t len) {
+    frame[0] = PROF_REPORT_VERSION;
+#ifdef PROFILER_HOST
+    wr32(&frame[1], 72000000u);
+#else
+    wr32(&frame[1], SystemCoreClock);
+#endif
+    wr32(&frame[5], prof_interval_ms);
+    frame[9] = stages;
+    return TLM_Send(TLM_TYPE_PROFILE, frame, len);
+}
+
+/**
+ * @brief 通过遥测帧发送当前统计（只包含有调用记录的阶段）
+ * @note 阶段较多时拆成多帧，每帧都带完整的报告头，可以单独解码
+ * @return 0: 成功, 1: 发送失败
+ */
+uint8_t PROF_Report(void) {
+    uint8_t frame[PROF_REPORT_HEADER + PROF_STAGES_PER_FRAME * PROF_REPORT_STAGE_SIZE];
+    uint8_t stages = 0;
+    uint8_t err = 0;
+    uint8_t *p = &frame[PROF_REPORT_HEADER];
+
+    for (uint8_t i = 0; i < PROF_STAGE_COUNT; i++) {
+        const PROF_StageStats_t *s = &prof_stats[i];
+        if (s->count == 0) {
+            continue;
+        }
+        p[0] = i;
+        wr32(&p[1], s->count);
+        wr32(&p[5], s->total);
+        wr32(&p[9], s->min);
+        wr32(&p[13], s->max);
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+            p[17 + 2 * b] = (uint8_t)s->hist[b];
+            p[18 + 2 * b] = (uint8_t)(s->hist[b] >> 8);
+        }
+        p += PROF_REPORT_STAGE_SIZE;
+        stages++;
+
+        if (stages == PROF_STAGES_PER_FRAME) {
+            err |= send_report(frame, stages, (uint16_t)(p - frame));
+            stages = 0;
+            p = &frame[PROF_REPORT_HEADER];
+        }
+    }
+    if (stages > 0) {
+        err |= send_report(frame, stages, (uint16_t)(p - frame));
+    }
+    return err;
+}
+
+/**
+ * @brief 主循环中调用，到达报告周期时发送报告并清零统计
+ * @param now_ms 当前时间（毫秒，例如 HAL_GetTick()）
+ */
+void PROF_Poll(uint32_t now_ms) {
+    if (now_ms - prof_last_report_ms >= PROF_REPORT_INTERVAL_MS) {
+        prof_interval_ms = now_ms - prof_last_report_ms;
+        prof_last_report_ms = now_ms;
+        PROF_Report();
+        PROF_Reset();
+    }
+}
+
+/**
+ * @brief 获取阶段统计（调试/测试用）
+ */
+const PROF_StageStats_t *PROF_GetStats(PROF_Stage_t stage) {
+    return &prof_stats[stage];
+}
+
+/**
+ * @brief 获取标定得到的测量开销（周期）
+ */
+uint32_t PROF_GetOverhead(void) {
+    return prof_overhead;
+}
+
+#endif // PROFILER_ENABLED
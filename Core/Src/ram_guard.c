@@ -0,0 +1,87 @@
+#include "ram_guard.h"
+
+#ifndef RAM_GUARD_HOST
+#include "stm32f1xx.h"
+#endif
+
+static uint32_t *guard_bottom = 0;
+static uint32_t *guard_top = 0;
+
+/**
+ * @brief 设置栈区并填充（主机测试直接调用，固件由 RamGuard_Init 调用）
+ * @param stack_bottom 栈区最低地址（保护字位置）
+ * @param stack_top 栈区最高地址（不含）
+ * @param paint_end 填充到此地址为止（不含），即当前SP下方
+ */
+void RamGuard_Setup(uint32_t *stack_bottom, uint32_t *stack_top, uint32_t *paint_end) {
+    guard_bottom = stack_bottom;
+    guard_top = stack_top;
+
+    uint32_t *p = stack_bottom;
+    for (uint32_t i = 0; i < RAM_GUARD_CANARY_WORDS; i++) {
+        *p++ = RAM_GUARD_CANARY;
+    }
+    // volatile: 防止编译器把填充循环替换为 memset（memset 本身也要用栈）
+    volatile uint32_t *v = p;
+    while (v < paint_end) {
+        *v++ = RAM_GUARD_PAINT;
+    }
+}
+
+#ifndef RAM_GUARD_HOST
+
+/**
+ * @brief 按链接脚本符号设置栈区并填充，应在 main() 开头尽早调用
+ */
+void RamGuard_Init(void) {
+    extern uint32_t _estack;            // 链接脚本: RAM 末尾
+    extern uint32_t _Min_Stack_Size;    // 链接脚本: 保留的栈大小（符号地址即数值）
+    uint32_t *top = &_estack;
+    uint32_t *bottom = (uint32_t *)((uintptr_t)&_estack - (uintptr_t)&_Min_Stack_Size);
+    uint32_t *paint_end = (uint32_t *)(uintptr_t)__get_MSP() - RAM_GUARD_SP_MARGIN_WORDS;
+    RamGuard_Setup(bottom, top, paint_end);
+}
+
+#endif // RAM_GUARD_HOST
+
+/**
+ * @brief 栈底保护字是否完好
+ * @return 1: 完好（或尚未初始化）, 0: 已被改写，栈超出了保留大小
+ */
+uint8_t RamGuard_CanaryIntact(void) {
+    if (guard_bottom == 0) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < RAM_GUARD_CANARY_WORDS; i++) {
+        if (guard_bottom[i] != RAM_GUARD_CANARY) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 运行以来的栈使用峰值（字节）
+ * @note 从保护字之后向上扫描第一个不等于填充图案的字；
+ *       保护字被改写时返回整个栈区大小
+ */
+uint32_t RamGuard_StackPeak(void) {
+    if (guard_bottom == 0) {
+        return 0;
+    }
+    if (!RamGuard_CanaryIntact()) {
+        return RamGuard_StackSize();
+    }
+    const uint32_t *p = guard_bottom + RAM_GUARD_CANARY_WORDS;
+    while (p < guard_top && *p == RAM_GUARD_PAINT) {
+        p++;
+    }
+    return (uint32_t)(guard_top - p) * sizeof(uint32_t);
+}
+
+/**
+ * @brief 保留的栈区大小（字节，含保护字）
+ */
+uint32_t RamGuard_StackSize(void) {
+    return (uint32_t)(guard_top - guard_bottom) * sizeof(uint32_t);
+}
@@ -0,0 +1,190 @@
+#include "telemetry.h"
+#include <string.h>
+
+// 解析状态
+enum {
+    PARSE_SYNC0 = 0,
+    PARSE_SYNC1,
+    PARSE_TYPE,
+    PARSE_SEQ,
+    PARSE_LEN_L,
+    PARSE_LEN_H,
+    PARSE_PAYLOAD,
+    PARSE_CRC_L,
+    PARSE_CRC_H
+};
+
+static TLM_TxFunc_t tlm_tx = NULL;
+static uint8_t tlm_seq = 0;
+
+/**
+ * @brief CRC16-CCITT（多项式0x1021），可分段累加
+ * @param crc 初始值（首段传 0xFFFF）
+ * @param data 数据指针
+ * @param len 数据长度
+ * @return 更新后的CRC
+ */
+uint16_t TLM_CRC16(uint16_t crc, const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            if (crc & 0x8000) {
+                crc = (uint16_t)((crc << 1) ^ 0x1021);
+            } else {
+                crc = (uint16_t)(crc << 1);
+            }
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief 初始化遥测发送端
+ * @param tx 底层发送函数
+ */
+void TLM_Init(TLM_TxFunc_t tx) {
+    tlm_tx = tx;
+    tlm_seq = 0;
+}
+
+/**
+ * @brief 打包并发送一帧
+ * @param type 帧类型 (TLM_FrameType_t)
+ * @param payload 载荷
+ * @param len 载荷长度（不超过 TLM_MAX_PAYLOAD）
+ * @return 0: 成功, 1: 失败（未初始化或载荷过长）
+ */
+uint8_t TLM_Send(uint8_t type, const uint8_t *payload, uint16_t len) {
+    if (tlm_tx == NULL || len > TLM_MAX_PAYLOAD) {
+        return 1;
+    }
+
+    uint8_t header[TLM_HEADER_SIZE];
+    header[0] = TLM_SYNC0;
+    header[1] = TLM_SYNC1;
+    header[2] = type;
+    header[3] = tlm_seq++;
+    header[4] = (uint8_t)(len & 0xFF);
+    header[5] = (uint8_t)(len >> 8);
+
+    uint16_t crc = TLM_CRC16(0xFFFF, &header[2], TLM_HEADER_SIZE - 2);
+    crc = TLM_CRC16(crc, payload, len);
+
+    uint8_t trailer[TLM_CRC_SIZE];
+    trailer[0] = (uint8_t)(crc & 0xFF);
+    trailer[1] = (uint8_t)(crc >> 8);
+
+    tlm_tx(header, TLM_HEADER_SIZE);
+    if (len > 0) {
+        tlm_tx(payload, len);
+    }
+    tlm_tx(trailer, TLM_CRC_SIZE);
+    return 0;
+}
+
+/**
+ * @brief 初始化接收解析器
+ * @param parser 解析器状态指针
+ */
+void TLM_Parser_Init(TLM_Parser_t *parser) {
+    memset(parser, 0, sizeof(TLM_Parser_t));
+    parser->state = PARSE_SYNC0;
+}
+
+/**
+ * @brief 解析器是否处于帧间（等待 SYNC0）
+ * @param parser 解析器状态指针
+ * @return 1: 帧间，此时非 SYNC0 字节是混在串口上的文本, 0: 正在接收一帧
+ */
+uint8_t TLM_Parser_Idle(const TLM_Parser_t *parser) {
+    return parser->state == PARSE_SYNC0;
+}
+
+/**
+ * @brief 向解析器喂入一个字节
+ * @param parser 解析器状态指针
+ * @param byte 接收到的字节
+ * @return 1: 收到一帧完整且CRC正确的数据（type/seq/len/payload有效）, 0: 其他
+ */
+uint8_t TLM_Parser_Feed(TLM_Parser_t *parser, uint8_t byte) {
+    switch (parser->state) {
+    case PARSE_SYNC0:
+        if (byte == TLM_SYNC0) {
+            parser->state = PARSE_SYNC1;
+        } else {
+            parser->bytes_skipped++;
+        }
+        break;
+
+    case PARSE_SYNC1:
+        if (byte == TLM_SYNC1) {
+            parser->state = PARSE_TYPE;
+            parser->crc = 0xFFFF;
+        } else if (byte != TLM_SYNC0) {
+            parser->bytes_skipped += 2;
+            parser->state = PARSE_SYNC0;
+        } else {
+            parser->bytes_skipped++;   // 连续的0xA5，保持等待SYNC1
+        }
+        break;
+
+    case PARSE_TYPE:
+        parser->type = byte;
+        parser->crc = TLM_CRC16(parser->crc, &byte, 1);
+        parser->state = PARSE_SEQ;
+        break;
+
+    case PARSE_SEQ:
+        parser->seq = byte;
+        parser->crc = TLM_CRC16(parser->crc, &byte, 1);
+        parser->state = PARSE_LEN_L;
+        break;
+
+    case PARSE_LEN_L:
+        parser->len = byte;
+        parser->crc = TLM_CRC16(parser->crc, &byte, 1);
+        parser->state = PARSE_LEN_H;
+        break;
+
+    case PARSE_LEN_H:
+        parser->len |= (uint16_t)byte << 8;
+        parser->crc = TLM_CRC16(parser->crc, &byte, 1);
+        parser->pos = 0;
+        if (parser->len > TLM_MAX_PAYLOAD) {
+            // 长度非法，视为误同步
+            parser->bytes_skipped += TLM_HEADER_SIZE;
+            parser->state = PARSE_SYNC0;
+        } else {
+            parser->state = (parser->len > 0) ? PARSE_PAYLOAD : PARSE_CRC_L;
+        }
+        break;
+
+    case PARSE_PAYLOAD:
+        parser->payload[parser->pos++] = byte;
+        if (parser->pos >= parser->len) {
+            parser->crc = TLM_CRC16(parser->crc, parser->payload, parser->len);
+            parser->state = PARSE_CRC_L;
+        }
+        break;
+
+    case PARSE_CRC_L:
+        parser->crc_rx[0] = byte;
+        parser->state = PARSE_CRC_H;
+        break;
+
+    case PARSE_CRC_H:
+        parser->crc_rx[1] = byte;
+        parser->state = PARSE_SYNC0;
+        if (parser->crc == (uint16_t)(parser->crc_rx[0] | ((uint16_t)parser->crc_rx[1] << 8))) {
+            parser->frames_ok++;
+            return 1;
+        }
+        parser->crc_errors++;
+        break;
+
+    default:
+        parser->state = PARSE_SYNC0;
+        break;
+    }
+    return 0;
+}
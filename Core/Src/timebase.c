@@ -0,0 +1,114 @@
+#include "timebase.h"
+#include <string.h>
+#include <math.h>
+
+#ifndef TIMEBASE_HOST
+
+#include "tim.h"
+
+static volatile uint32_t timebase_overflows = 0;
+
+/**
+ * @brief 启动 TIM3 自由计数（需先调用 MX_TIM3_Init）
+ */
+void Timebase_Init(void) {
+    timebase_overflows = 0;
+    __HAL_TIM_SET_COUNTER(&htim3, 0);
+    __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+    HAL_TIM_Base_Start_IT(&htim3);
+}
+
+/**
+ * @brief TIM3 更新中断中调用（每65.536ms一次）
+ */
+void Timebase_OverflowISR(void) {
+    timebase_overflows++;
+}
+
+/**
+ * @brief 读取64位微秒时间（可在中断中调用）
+ */
+uint64_t Timebase_GetUs(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t overflows = timebase_overflows;
+    uint16_t count = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+    uint8_t pending = (__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) != RESET) ? 1 : 0;
+    __set_PRIMASK(primask);
+    return Timebase_Compose(overflows, count, pending);
+}
+
+#endif // TIMEBASE_HOST
+
+/**
+ * @brief 初始化采样时钟估计，初始采样率为标称值
+ */
+void SampleClock_Init(SampleClock_t *clk) {
+    memset(clk, 0, sizeof(SampleClock_t));
+    clk->rate_hz = SAMPLE_CLOCK_NOMINAL_HZ;
+    clk->period_us = 1000000.0f / SAMPLE_CLOCK_NOMINAL_HZ;
+}
+
+/**
+ * @brief 记录一次 FIFO 突发读取
+ * @param arrival_us 读取FIFO指针的时间（近似为突发中最新样本的产生时间）
+ * @param count 本次读取的样本数
+ * @param lost 读取前因 FIFO 溢出丢失的样本数
+ * @return 1: 本次完成一个窗口并更新了采样率估计, 0: 未更新
+ */
+uint8_t SampleClock_AddBurst(SampleClock_t *clk, uint64_t arrival_us, uint8_t count, uint8_t lost) {
+    if (!clk->started) {
+        // 第一次突发的样本产生于窗口起点之前，不计入
+        clk->window_start_us = arrival_us;
+        clk->window_samples = 0;
+        clk->started = 1;
+        return 0;
+    }
+
+    clk->window_samples += (uint32_t)count + lost;
+    uint64_t elapsed = arrival_us - clk->window_start_us;
+    if (elapsed < SAMPLE_CLOCK_WINDOW_US) {
+        return 0;
+    }
+
+    uint8_t updated = 0;
+    float measured = (float)clk->window_samples * 1000000.0f / (float)elapsed;
+    if (fabsf(measured - SAMPLE_CLOCK_NOMINAL_HZ) <= SAMPLE_CLOCK_NOMINAL_HZ * SAMPLE_CLOCK_MAX_DEVIATION) {
+        if (clk->valid) {
+            clk->rate_hz += SAMPLE_CLOCK_EMA_ALPHA * (measured - clk->rate_hz);
+        } else {
+            clk->rate_hz = measured;
+            clk->valid = 1;
+        }
+        clk->period_us = 1000000.0f / clk->rate_hz;
+        updated = 1;
+    }
+    clk->window_start_us = arrival_us;
+    clk->window_samples = 0;
+    return updated;
+}
+
+/**
+ * @brief 计算突发中第 index 个样本（0为最旧）的时间戳
+ * @note 按估计的采样周期从到达时间向前推算，并保证时间戳严格递增
+ */
+uint64_t SampleClock_SampleTime(SampleClock_t *clk, uint64_t arrival_us, uint8_t count, uint8_t index) {
+    uint64_t back = (uint64_t)((float)(count - 1u - index) * clk->period_us);
+    uint64_t t = (arrival_us > back) ? arrival_us - back : 0;
+    if (t <= clk->last_sample_us && clk->last_sample_us != 0) {
+        t = clk->last_sample_us + 1;
+    }
+    clk->last_sample_us = t;
+    return t;
+}
+
+/**
+ * @brief 估计的采样率 (Hz)，尚无有效估计时返回标称值
+ */
+float SampleClock_GetRate(const SampleClock_t *clk) {
+    return clk->rate_hz;
+}
+
+uint8_t SampleClock_IsValid(const SampleClock_t *clk) {
+    return clk->valid;
+}
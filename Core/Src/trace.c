@@ -0,0 +1,180 @@
+#include "trace.h"
+#include <string.h>
+
+// 事件名称与时间线类型（'B' 区间开始, 'E' 区间结束, 'i' 瞬时事件）
+static const char *const event_names[TRACE_EV_COUNT] = {
+    "none",
+    "fifo_read",
+    "fifo_read",
+    "overrun",
+    "sensor_irq",
+    "beat",
+    "hr_update",
+    "spo2_update",
+    "oled_frame",
+    "oled_frame",
+    "oled_page",
+    "agc_step",
+    "stall",
+    "fault",
+    "mark",
+};
+
+static const char event_phases[TRACE_EV_COUNT] = {
+    'i', 'B', 'E', 'i', 'i', 'i', 'i', 'i', 'B', 'E', 'i', 'i', 'i', 'i', 'i',
+};
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 事件名称（区间事件的开始/结束同名）
+ */
+const char *Trace_EventName(uint8_t id) {
+    return (id < TRACE_EV_COUNT) ? event_names[id] : "unknown";
+}
+
+/**
+ * @brief 事件在时间线上的类型: 'B' 开始, 'E' 结束, 'i' 瞬时
+ */
+char Trace_EventPhase(uint8_t id) {
+    return (id < TRACE_EV_COUNT) ? event_phases[id] : 'i';
+}
+
+/**
+ * @brief 解码一帧 TLM_TYPE_TRACE 导出数据
+ * @return 0: 成功, 1: 格式错误或版本不符
+ */
+uint8_t Trace_DecodeFrame(const uint8_t *payload, uint16_t len, Trace_DumpFrame_t *frame) {
+    memset(frame, 0, sizeof(Trace_DumpFrame_t));
+    if (len < TRACE_DUMP_HEADER || payload[0] != TRACE_DUMP_VERSION) {
+        return 1;
+    }
+    uint16_t count = (uint16_t)((len - TRACE_DUMP_HEADER) / TRACE_WIRE_RECORD_SIZE);
+    if (count > TRACE_RECORDS_PER_FRAME ||
+        len != TRACE_DUMP_HEADER + count * TRACE_WIRE_RECORD_SIZE) {
+        return 1;
+    }
+    frame->reason = payload[1];
+    frame->dump_id = (uint16_t)(payload[2] | (payload[3] << 8));
+    frame->cpu_hz = rd32(&payload[4]);
+    frame->total = (uint16_t)(payload[8] | (payload[9] << 8));
+    frame->first = (uint16_t)(payload[10] | (payload[11] << 8));
+    frame->written = rd32(&payload[12]);
+    if (frame->first + count > frame->total) {
+        return 1;
+    }
+
+    const uint8_t *p = &payload[TRACE_DUMP_HEADER];
+    for (uint16_t i = 0; i < count; i++, p += TRACE_WIRE_RECORD_SIZE) {
+        frame->records[i].timestamp = rd32(&p[0]);
+        frame->records[i].id = p[4];
+        frame->records[i].arg = rd32(&p[5]);
+    }
+    frame->count = (uint8_t)count;
+    return 0;
+}
+
+#if TRACE_ENABLED
+
+#include "telemetry.h"
+
+Trace_Buffer_t trace_buffer;
+static uint16_t trace_dump_id = 0;
+
+static void wr32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief 清空缓冲区并使能 DWT 周期计数器作为时间戳
+ */
+void Trace_Init(void) {
+#ifndef TRACE_HOST
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    memset(&trace_buffer, 0, sizeof(trace_buffer));
+}
+
+/**
+ * @brief 发送一帧导出数据
+ */
+static uint8_t send_frame(uint8_t *frame, uint8_t reason, uint16_t total, uint16_t first,
+                          uint32_t written, uint8_t count) {
+    frame[0] = TRACE_DUMP_VERSION;
+    frame[1] = reason;
+    frame[2] = (uint8_t)trace_dump_id;
+    frame[3] = (uint8_t)(trace_dump_id >> 8);
+#ifdef TRACE_HOST
+    wr32(&frame[4], 72000000u);
+#else
+    wr32(&frame[4], SystemCoreClock);
+#endif
+    frame[8] = (uint8_t)total;
+    frame[9] = (uint8_t)(total >> 8);
+    frame[10] = (uint8_t)first;
+    frame[11] = (uint8_t)(first >> 8);
+    wr32(&frame[12], written);
+    return TLM_Send(TLM_TYPE_TRACE, frame,
+                    (uint16_t)(TRACE_DUMP_HEADER + count * TRACE_WIRE_RECORD_SIZE));
+}
+
+/**
+ * @brief 按时间顺序通过遥测帧导出缓冲区中的全部记录
+ * @note 导出期间暂停记录（发送耗时较长），期间产生的事件被丢弃
+ * @param reason TRACE_REASON_*
+ * @return 0: 成功, 1: 发送失败
+ */
+uint8_t Trace_Dump(uint8_t reason) {
+    uint8_t frame[TRACE_DUMP_HEADER + TRACE_RECORDS_PER_FRAME * TRACE_WIRE_RECORD_SIZE];
+    uint8_t was_frozen = trace_buffer.frozen;
+    trace_buffer.frozen = 1;
+
+    uint32_t written = trace_buffer.written;
+    uint16_t total = (written < TRACE_BUFFER_SIZE) ? (uint16_t)written : TRACE_BUFFER_SIZE;
+    uint32_t start = written - total;
+    uint8_t err = 0;
+    uint8_t count = 0;
+    uint16_t first = 0;
+    uint8_t *p = &frame[TRACE_DUMP_HEADER];
+
+    for (uint16_t i = 0; i < total; i++) {
+        const Trace_Record_t *r = &trace_buffer.records[(start + i) & (TRACE_BUFFER_SIZE - 1)];
+        wr32(&p[0], r->timestamp);
+        p[4] = r->id;
+        wr32(&p[5], r->arg);
+        p += TRACE_WIRE_RECORD_SIZE;
+        count++;
+
+        if (count == TRACE_RECORDS_PER_FRAME || i + 1 == total) {
+            err |= send_frame(frame, reason, total, first, written, count);
+            first = (uint16_t)(i + 1);
+            count = 0;
+            p = &frame[TRACE_DUMP_HEADER];
+        }
+    }
+    if (total == 0) {
+        err |= send_frame(frame, reason, 0, 0, written, 0);     // 空缓冲区也回应一帧
+    }
+
+    trace_dump_id++;
+    trace_buffer.frozen = was_frozen;
+    return err;
+}
+
+/**
+ * @brief 异常处理中调用: 记录异常事件、导出并冻结缓冲区
+ * @param reason TRACE_REASON_*
+ */
+void Trace_Fault(uint8_t reason) {
+    Trace_Record(TRACE_EV_FAULT, reason);
+    Trace_Dump(reason);
+    trace_buffer.frozen = 1;
+}
+
+#endif // TRACE_ENABLED
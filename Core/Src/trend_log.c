@@ -0,0 +1,388 @@
+#include "trend_log.h"
+#include "telemetry.h"
+#include <string.h>
+
+// 页头字段偏移
+#define HDR_MAGIC       0
+#define HDR_STATE       2
+#define HDR_SEQ         4
+#define HDR_SESSION     8
+#define HDR_CHECK       10
+#define HDR_T0          12
+
+#define SHORT_DHR_MIN   (-32)
+#define SHORT_DHR_MAX   31
+#define SHORT_DSPO2_MIN (-8)
+#define SHORT_DSPO2_MAX 7
+
+typedef struct {
+    uint32_t seq;
+    uint16_t session;
+    uint32_t t0;
+    uint16_t state;
+} PageHeader_t;
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)rd16(p) | ((uint32_t)rd16(p + 2) << 16);
+}
+
+static uint16_t header_check(uint32_t seq, uint16_t session, uint32_t t0) {
+    return (uint16_t)~((seq & 0xFFFF) ^ (seq >> 16) ^ session ^ (t0 & 0xFFFF) ^ (t0 >> 16));
+}
+
+/**
+ * @brief 解析并校验页头
+ * @return 1: 页头有效, 0: 无效（空页、残页或其他数据）
+ */
+static uint8_t parse_header(const uint8_t *raw, PageHeader_t *hdr) {
+    if (rd16(&raw[HDR_MAGIC]) != TREND_LOG_MAGIC) {
+        return 0;
+    }
+    hdr->state = rd16(&raw[HDR_STATE]);
+    hdr->seq = rd32(&raw[HDR_SEQ]);
+    hdr->session = rd16(&raw[HDR_SESSION]);
+    hdr->t0 = rd32(&raw[HDR_T0]);
+    return rd16(&raw[HDR_CHECK]) == header_check(hdr->seq, hdr->session, hdr->t0);
+}
+
+static uint32_t page_addr(const TrendLog_t *log, uint16_t page) {
+    return log->flash->base + (uint32_t)page * log->flash->page_size;
+}
+
+static uint8_t read_header(const TrendLog_t *log, uint16_t page, PageHeader_t *hdr) {
+    uint8_t raw[TREND_LOG_HEADER_SIZE];
+    log->flash->read(log->flash->ctx, page_addr(log, page), raw, sizeof(raw));
+    return parse_header(raw, hdr);
+}
+
+static uint8_t program(TrendLog_t *log, uint32_t addr, uint16_t data) {
+    if (log->flash->program_halfword(log->flash->ctx, addr, data) != 0) {
+        log->errors++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 标记当前页已写满（页提交标志）
+ */
+static void close_page(TrendLog_t *log) {
+    if (log->page_open) {
+        program(log, page_addr(log, log->page) + HDR_STATE, TREND_LOG_STATE_CLOSED);
+        log->page_open = 0;
+    }
+}
+
+/**
+ * @brief 擦除下一页并写入页头
+ * @note 先写其余字段，最后写MAGIC；中途掉电的页头因MAGIC缺失被视为空页
+ * @return 0: 成功, 1: 失败
+ */
+static uint8_t open_page(TrendLog_t *log, uint32_t t0) {
+    close_page(log);
+
+    // 按页号循环使用，所有页依次擦除，磨损均匀
+    log->page = (uint16_t)((log->page + 1) % log->flash->page_count);
+    uint32_t addr = page_addr(log, log->page);
+
+    if (log->flash->erase_page(log->flash->ctx, addr) != 0) {
+        log->errors++;
+        return 1;
+    }
+    log->erases++;
+
+    uint32_t seq = log->next_seq++;
+    if (program(log, addr + HDR_SEQ, (uint16_t)(seq & 0xFFFF)) ||
+        program(log, addr + HDR_SEQ + 2, (uint16_t)(seq >> 16)) ||
+        program(log, addr + HDR_SESSION, log->session) ||
+        program(log, addr + HDR_CHECK, header_check(seq, log->session, t0)) ||
+        program(log, addr + HDR_T0, (uint16_t)(t0 & 0xFFFF)) ||
+        program(log, addr + HDR_T0 + 2, (uint16_t)(t0 >> 16)) ||
+        program(log, addr + HDR_MAGIC, TREND_LOG_MAGIC)) {
+        return 1;
+    }
+
+    log->page_open = 1;
+    log->offset = TREND_LOG_HEADER_SIZE;
+    log->t0 = t0;
+    log->last_time = t0;
+    return 0;
+}
+
+/**
+ * @brief 挂载记录区：扫描页头，找到最新页，开始新的会话
+ * @param log 记录器状态
+ * @param flash Flash后端
+ * @return 0: 成功, 1: 存储区配置无效
+ * @note 新会话总是从新页开始，上次掉电时未写完的页不再追加
+ */
+uint8_t TrendLog_Mount(TrendLog_t *log, const TrendLog_Flash_t *flash) {
+    memset(log, 0, sizeof(TrendLog_t));
+    log->flash = flash;
+    if (flash->page_count < 2 || flash->page_size <= TREND_LOG_HEADER_SIZE) {
+        return 1;
+    }
+
+    uint8_t found = 0;
+    PageHeader_t newest = { 0 };
+    for (uint16_t p = 0; p < flash->page_count; p++) {
+        PageHeader_t hdr;
+        if (read_header(log, p, &hdr) && (!found || hdr.seq > newest.seq)) {
+            newest = hdr;
+            log->page = p;
+            found = 1;
+        }
+    }
+
+    if (found) {
+        log->next_seq = newest.seq + 1;
+        log->session = (uint16_t)(newest.session + 1);
+    } else {
+        log->page = (uint16_t)(flash->page_count - 1);   // 下一页为第0页
+        log->next_seq = 1;
+        log->session = 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 追加一条趋势记录
+ * @param log 记录器状态
+ * @param time 会话内时间（秒，单调递增）
+ * @param hr 心率（BPM）
+ * @param spo2 血氧（%，0-100）
+ * @param sqi 信号质量 0-3
+ * @param flags TREND_FLAG_*
+ * @return 0: 成功, 1: Flash操作失败（下一条记录会另起一页）
+ */
+uint8_t TrendLog_Append(TrendLog_t *log, uint32_t time, uint8_t hr, uint8_t spo2,
+                        uint8_t sqi, uint8_t flags) {
+    if (spo2 > 100) spo2 = 100;     // 同时保证完整记录的首半字不会等于擦除值 0xFFFF
+    if (sqi > 3) sqi = 3;
+    flags &= 0x07;
+
+    // 时间倒退或间隔过长时另起一页，以页头时间戳为新的基准
+    if (!log->page_open || time < log->last_time || time - log->last_time > TREND_LOG_MAX_DT) {
+        if (open_page(log, time) != 0) {
+            close_page(log);
+            return 1;
+        }
+    }
+
+    uint32_t dt = time - log->last_time;
+    int16_t d_hr = (int16_t)hr - (int16_t)log->last_hr;
+    int16_t d_spo2 = (int16_t)spo2 - (int16_t)log->last_spo2;
+    uint8_t first = (log->offset == TREND_LOG_HEADER_SIZE);
+    uint8_t use_short = !first && dt == 1 &&
+                        d_hr >= SHORT_DHR_MIN && d_hr <= SHORT_DHR_MAX &&
+                        d_spo2 >= SHORT_DSPO2_MIN && d_spo2 <= SHORT_DSPO2_MAX;
+    uint16_t needed = use_short ? 2 : 4;
+
+    if (log->offset + needed > log->flash->page_size) {
+        if (open_page(log, time) != 0) {
+            close_page(log);
+            return 1;
+        }
+        dt = 0;
+        use_short = 0;
+    }
+
+    uint32_t addr = page_addr(log, log->page) + log->offset;
+    uint16_t tail = (uint16_t)(((uint16_t)flags << 12) | ((uint16_t)sqi << 10));
+    uint8_t err;
+    if (use_short) {
+        err = program(log, addr, (uint16_t)(tail | ((uint16_t)(d_spo2 & 0x0F) << 6) | (uint16_t)(d_hr & 0x3F)));
+        log->offset += 2;
+    } else {
+        // 先写数值半字，再写带提交标志（最高位0）的时间半字
+        err = program(log, addr, (uint16_t)(0x8000 | ((uint16_t)spo2 << 8) | hr));
+        if (!err) {
+            err = program(log, addr + 2, (uint16_t)(tail | (uint16_t)dt));
+        }
+        log->offset += 4;
+    }
+    if (err) {
+        close_page(log);
+        return 1;
+    }
+
+    log->last_time = time;
+    log->last_hr = hr;
+    log->last_spo2 = spo2;
+    log->records++;
+    return 0;
+}
+
+/**
+ * @brief 擦除全部记录
+ * @return 0: 成功, 1: 擦除失败
+ */
+uint8_t TrendLog_Format(TrendLog_t *log) {
+    const TrendLog_Flash_t *flash = log->flash;
+    uint8_t err = 0;
+    for (uint16_t p = 0; p < flash->page_count; p++) {
+        if (flash->erase_page(flash->ctx, page_addr(log, p)) != 0) {
+            log->errors++;
+            err = 1;
+        }
+    }
+    TrendLog_Mount(log, flash);
+    return err;
+}
+
+/**
+ * @brief 计算页内已使用字节数（遇到擦除状态的半字为止）
+ */
+static uint16_t page_used(const TrendLog_t *log, uint16_t page) {
+    uint32_t addr = page_addr(log, page);
+    uint16_t pos = TREND_LOG_HEADER_SIZE;
+    while (pos + 2 <= log->flash->page_size) {
+        uint8_t hw[2];
+        log->flash->read(log->flash->ctx, addr + pos, hw, 2);
+        if (rd16(hw) == 0xFFFF) {
+            break;
+        }
+        pos += 2;
+    }
+    return pos;
+}
+
+/**
+ * @brief 通过遥测链路按时间顺序导出全部有效页
+ * @details 每页拆成若干 TLM_TYPE_TREND_LOG 帧，载荷为
+ *          SEQ(4) OFFSET(2) TOTAL(2) DATA，主机按 SEQ 拼回整页后用
+ *          TrendLog_DecodePage 解码
+ * @return 0: 成功, 1: 发送失败
+ */
+uint8_t TrendLog_Dump(TrendLog_t *log) {
+    const TrendLog_Flash_t *flash = log->flash;
+    uint8_t frame[TREND_LOG_DUMP_HEADER + TREND_LOG_DUMP_CHUNK];
+    uint32_t last_seq = 0;
+    uint8_t have_last = 0;
+
+    for (;;) {
+        // 选出序号大于上一页的最旧一页（页数很少，直接线性查找）
+        PageHeader_t best = { 0 };
+        uint16_t best_page = 0;
+        uint8_t found = 0;
+        for (uint16_t p = 0; p < flash->page_count; p++) {
+            PageHeader_t hdr;
+            if (read_header(log, p, &hdr) && (!have_last || hdr.seq > last_seq) &&
+                (!found || hdr.seq < best.seq)) {
+                best = hdr;
+                best_page = p;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return 0;
+        }
+        last_seq = best.seq;
+        have_last = 1;
+
+        uint16_t total = page_used(log, best_page);
+        for (uint16_t offset = 0; offset < total; offset += TREND_LOG_DUMP_CHUNK) {
+            uint16_t n = (uint16_t)(total - offset);
+            if (n > TREND_LOG_DUMP_CHUNK) n = TREND_LOG_DUMP_CHUNK;
+
+            frame[0] = (uint8_t)best.seq;
+            frame[1] = (uint8_t)(best.seq >> 8);
+            frame[2] = (uint8_t)(best.seq >> 16);
+            frame[3] = (uint8_t)(best.seq >> 24);
+            frame[4] = (uint8_t)offset;
+            frame[5] = (uint8_t)(offset >> 8);
+            frame[6] = (uint8_t)total;
+            frame[7] = (uint8_t)(total >> 8);
+            flash->read(flash->ctx, page_addr(log, best_page) + offset,
+                        &frame[TREND_LOG_DUMP_HEADER], n);
+            if (TLM_Send(TLM_TYPE_TREND_LOG, frame, (uint16_t)(TREND_LOG_DUMP_HEADER + n)) != 0) {
+                return 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 存储区至少能保留的记录条数（按全部为短记录、擦除一页后计算）
+ */
+uint32_t TrendLog_Capacity(const TrendLog_Flash_t *flash) {
+    return (uint32_t)(flash->page_count - 1) * ((flash->page_size - TREND_LOG_HEADER_SIZE) / 2);
+}
+
+/**
+ * @brief 解码一页数据
+ * @param data 页数据（从页头开始）
+ * @param len 数据长度（可以小于页大小）
+ * @param info 输出页信息
+ * @param cb 每条有效记录的回调（可为NULL）
+ * @param ctx 回调参数
+ * @return 0: 成功, 1: 页头无效
+ */
+uint8_t TrendLog_DecodePage(const uint8_t *data, uint16_t len, TrendLog_PageInfo_t *info,
+                            TrendLog_RecordCb_t cb, void *ctx) {
+    PageHeader_t hdr;
+    memset(info, 0, sizeof(TrendLog_PageInfo_t));
+    if (len < TREND_LOG_HEADER_SIZE || !parse_header(data, &hdr)) {
+        return 1;
+    }
+    info->seq = hdr.seq;
+    info->session = hdr.session;
+    info->closed = (hdr.state == TREND_LOG_STATE_CLOSED);
+
+    TrendLog_Record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.session = hdr.session;
+    rec.time = hdr.t0;
+
+    uint16_t pos = TREND_LOG_HEADER_SIZE;
+    while (pos + 2 <= len) {
+        uint16_t hw0 = rd16(&data[pos]);
+        if (hw0 == 0xFFFF) {
+            break;
+        }
+
+        if ((hw0 & 0x8000) == 0) {
+            // 短记录: 相对上一条记录
+            if (info->records == 0) {
+                info->corrupt = 1;
+                break;
+            }
+            int8_t d_hr = (int8_t)(((hw0 & 0x3F) ^ 0x20) - 0x20);
+            int8_t d_spo2 = (int8_t)((((hw0 >> 6) & 0x0F) ^ 0x08) - 0x08);
+            rec.hr = (uint8_t)(rec.hr + d_hr);
+            rec.spo2 = (uint8_t)(rec.spo2 + d_spo2);
+            rec.sqi = (uint8_t)((hw0 >> 10) & 0x03);
+            rec.flags = (uint8_t)((hw0 >> 12) & 0x07);
+            rec.time += 1;
+            pos += 2;
+        } else {
+            // 完整记录: 缺少提交半字即为残缺记录
+            if (pos + 4 > len || rd16(&data[pos + 2]) == 0xFFFF) {
+                info->torn = 1;
+                break;
+            }
+            uint16_t hw1 = rd16(&data[pos + 2]);
+            if (hw1 & 0x8000) {
+                info->corrupt = 1;
+                break;
+            }
+            rec.hr = (uint8_t)(hw0 & 0xFF);
+            rec.spo2 = (uint8_t)((hw0 >> 8) & 0x7F);
+            rec.sqi = (uint8_t)((hw1 >> 10) & 0x03);
+            rec.flags = (uint8_t)((hw1 >> 12) & 0x07);
+            rec.time += hw1 & 0x03FF;
+            pos += 4;
+        }
+
+        info->records++;
+        if (cb != NULL) {
+            cb(&rec, ctx);
+        }
+    }
+    info->used = pos;
+    return 0;
+}
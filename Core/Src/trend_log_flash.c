@@ -0,0 +1,57 @@
+#include "trend_log_flash.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+// 链接脚本中定义的趋势记录区
+extern uint32_t _trend_log_start;
+extern uint32_t _trend_log_end;
+
+/**
+ * @brief 擦除一页
+ * @note 擦除期间CPU从Flash取指会被挂起约20ms，MAX30102的FIFO可缓存32个样本，不会丢数
+ */
+static uint8_t stm32_erase_page(void *ctx, uint32_t addr) {
+    FLASH_EraseInitTypeDef erase;
+    uint32_t page_error = 0;
+    (void)ctx;
+
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.Banks = FLASH_BANK_1;
+    erase.PageAddress = addr;
+    erase.NbPages = 1;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? 0 : 1;
+}
+
+static uint8_t stm32_program_halfword(void *ctx, uint32_t addr, uint16_t data) {
+    (void)ctx;
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr, data);
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? 0 : 1;
+}
+
+static void stm32_read(void *ctx, uint32_t addr, void *dst, uint16_t len) {
+    (void)ctx;
+    memcpy(dst, (const void *)addr, len);
+}
+
+/**
+ * @brief 初始化片内Flash后端
+ * @param flash 后端描述（需在记录器使用期间保持有效）
+ */
+void TrendLog_FlashSTM32_Init(TrendLog_Flash_t *flash) {
+    uint32_t start = (uint32_t)&_trend_log_start;
+    uint32_t end = (uint32_t)&_trend_log_end;
+
+    flash->base = start;
+    flash->page_size = FLASH_PAGE_SIZE;
+    flash->page_count = (uint16_t)((end - start) / FLASH_PAGE_SIZE);
+    flash->ctx = NULL;
+    flash->erase_page = stm32_erase_page;
+    flash->program_halfword = stm32_program_halfword;
+    flash->read = stm32_read;
+}
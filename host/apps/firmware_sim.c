@@ -0,0 +1,222 @@
+/**
+ * @file firmware_sim.c
+ * @brief The complete firmware application (app.c) on Linux, driven by simulated peripherals
+ * @details Links app.c, the lib/oled drivers and the algorithm sources against
+ *          the Linux platform backend: the MAX30102 driver talks bit-banged I2C
+ *          to a simulated sensor, the OLED driver writes to a simulated SH1106
+ *          and the UART log goes to stdout. Time is virtual, so a run covers
+ *          -t seconds of firmware time as fast as the host allows, which makes
+ *          it usable for soak tests and profiling in CI.
+ *
+ *          The sensor sees a synthetic PPG (-H bpm, red/IR modulation ratio -R)
+ *          or replays a recording (-i: ppg_capture_decode CSV at 100 Hz, or a
+ *          .ppgrec container at its recorded rate); its
+ *          INT pin drives the EXTI line. With -e the final state is checked:
+ *          heart rate valid and within +-tol bpm of -H (the expected rate of
+ *          the recording with -i), SpO2 valid, no FIFO overflow, display
+ *          refreshed.
+ *
+ * Usage: firmware_sim [-t seconds] [-H bpm] [-R ratio] [-n noise] [-i capture.csv|.ppgrec]
+ *                     [-e tol_bpm] [-p frame.pbm] [-q]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "app.h"
+#include "platform_sim.h"
+#include "ppg_rec.h"
+#include "max30102_sim.h"
+#include "oled_sim.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IR_DC           120000.0
+#define RED_DC          110000.0
+#define IR_AC           3000.0
+
+typedef struct {
+    double hr_bpm;
+    double ratio;               // (red AC/DC) / (IR AC/DC)
+    double noise;               // peak-to-peak ADC counts
+    uint32_t lcg;
+} Signal_t;
+
+static double noise(Signal_t *sig) {
+    sig->lcg = sig->lcg * 1664525u + 1013904223u;
+    return (double)(sig->lcg >> 8) / 16777216.0 - 0.5;
+}
+
+static void signal_source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    Signal_t *sig = (Signal_t *)ctx;
+    double phase = 2.0 * M_PI * sig->hr_bpm / 60.0 * (double)t_us * 1e-6;
+    double pulse = sin(phase) + 0.3 * sin(2.0 * phase + 0.8);
+    double red_ac = IR_AC / IR_DC * sig->ratio * RED_DC;
+    *ir = (uint32_t)(IR_DC + IR_AC * pulse + sig->noise * noise(sig));
+    *red = (uint32_t)(RED_DC + red_ac * pulse + sig->noise * noise(sig));
+}
+
+static void int_to_exti(void *ctx, uint8_t level) {
+    (void)ctx;
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, level);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// -i input: a recording container (every stored sample) or a CSV capture
+static int load_input(MAX30102Sim_Recording_t *rec, const char *path) {
+    if (!PPGRec_IsRecording(path)) {
+        return MAX30102Sim_LoadCsv(rec, path, 100);
+    }
+    PPGRec_Reader_t r;
+    memset(rec, 0, sizeof(MAX30102Sim_Recording_t));
+    if (PPGRec_Open(&r, path) != 0 || r.total_samples == 0 || r.total_samples > UINT32_MAX) {
+        return -1;
+    }
+    rec->red = (uint32_t *)malloc(r.total_samples * sizeof(uint32_t));
+    rec->ir = (uint32_t *)malloc(r.total_samples * sizeof(uint32_t));
+    if (rec->red != NULL && rec->ir != NULL) {
+        rec->count = PPGRec_Read(&r, 0, (uint32_t)r.total_samples, rec->red, rec->ir);
+    }
+    rec->rate_hz = (uint32_t)(r.header->sample_rate_hz + 0.5f);
+    PPGRec_Close(&r);
+    if (rec->count == 0) {
+        MAX30102Sim_FreeRecording(rec);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    double duration_s = 60.0;
+    double tolerance = -1.0;
+    const char *pbm_path = NULL;
+    const char *input_path = NULL;
+    int quiet = 0;
+    Signal_t sig = { 72.0, 0.5, 20.0, 1u };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            duration_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            sig.hr_bpm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            sig.ratio = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            sig.noise = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pbm_path = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-t seconds] [-H bpm] [-R ratio] [-n noise] [-i capture.csv|.ppgrec] "
+                            "[-e tol_bpm] [-p frame.pbm] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static MAX30102Sim_t sensor;
+    static OLEDSim_t oled;
+    MAX30102Sim_Recording_t rec;
+    if (input_path != NULL && load_input(&rec, input_path) != 0) {
+        fprintf(stderr, "%s: no samples\n", input_path);
+        return 1;
+    }
+    PlatformSim_Reset();
+    if (input_path != NULL) {
+        MAX30102Sim_Init(&sensor, MAX30102Sim_RecordingSource, &rec);
+    } else {
+        MAX30102Sim_Init(&sensor, signal_source, &sig);
+    }
+    MAX30102Sim_SetIntPin(&sensor, int_to_exti, NULL);
+    OLEDSim_Init(&oled);
+    PlatformSim_Attach(PLATFORM_SIM_SOFT_I2C, &sensor.device);
+    PlatformSim_Attach(PLATFORM_SIM_HW_I2C, &oled.device);
+
+    // -q: the firmware's UART log (printf) goes to /dev/null, the summary to the real stdout
+    int saved_stdout = -1;
+    if (quiet) {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (saved_stdout < 0 || null_fd < 0) {
+            perror("/dev/null");
+            return 1;
+        }
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+
+    double wall_start = now_s();
+    uint64_t end_us = (uint64_t)(duration_s * 1e6);
+    uint64_t loops = 0;
+    App_Init();
+    while (PlatformSim_GetUs() < end_us) {
+        App_Loop();
+        loops++;
+    }
+    double wall = now_s() - wall_start;
+
+    if (quiet) {
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    App_Status_t status;
+    App_GetStatus(&status);
+    const I2CSim_Bus_t *soft = PlatformSim_GetBus(PLATFORM_SIM_SOFT_I2C);
+    const I2CSim_Bus_t *hw = PlatformSim_GetBus(PLATFORM_SIM_HW_I2C);
+    double sim_s = (double)PlatformSim_GetUs() / 1e6;
+
+    printf("\n=== Firmware Simulation ===\n");
+    printf("Firmware time:  %.1f s in %.3f s wall (%.0fx real time)\n",
+           sim_s, wall, wall > 0.0 ? sim_s / wall : 0.0);
+    printf("Main loop:      %llu iterations\n", (unsigned long long)loops);
+    printf("Samples:        %u processed, %u produced, %u lost, %u saturated\n",
+           status.samples, sensor.samples, sensor.lost, sensor.saturated);
+    printf("Sensor INT:     %u interrupts\n", sensor.interrupts);
+    printf("Soft I2C:       %u transfers, %u bytes, %u NACKs\n", soft->transfers, soft->bytes, soft->nacks);
+    printf("OLED:           %u frames, %u bytes\n", oled.frames, hw->bytes);
+    if (input_path != NULL) {
+        printf("Input:          %s (%u samples)\n", input_path, rec.count);
+    } else {
+        printf("Input:          synthetic, %.1f bpm, R %.2f\n", sig.hr_bpm, sig.ratio);
+    }
+    printf("Heart rate:     %.1f bpm (displayed %.1f, %s)\n",
+           status.heart_rate, status.displayed_hr, status.hr_valid ? "valid" : "not valid");
+    printf("SpO2:           %.1f %% (%s)\n", status.spo2, status.spo2_valid ? "valid" : "not valid");
+
+    if (pbm_path != NULL && OLEDSim_WritePBM(&oled, pbm_path) != 0) {
+        perror(pbm_path);
+        return 1;
+    }
+
+    if (tolerance >= 0.0) {
+        int ok = status.hr_valid && fabs(status.displayed_hr - sig.hr_bpm) <= tolerance &&
+                 status.spo2_valid && status.lost_samples == 0 && oled.frames > 0;
+        if (!ok) {
+            printf("Firmware simulation FAILED\n");
+            return 1;
+        }
+        printf("Firmware simulation passed\n");
+    }
+    if (input_path != NULL) {
+        MAX30102Sim_FreeRecording(&rec);
+    }
+    return 0;
+}
@@ -0,0 +1,459 @@
+/**
+ * @file hr_latency.c
+ * @brief Step and ramp response of the heart-rate pipeline, per smoothing stage
+ * @details Feeds a synthetic PPG whose heart rate changes from -a to -b bpm
+ *          (a step, and a linear ramp over -r seconds) through Method 1 and
+ *          Method 2 with the same call pattern as main.c: filter, HR_AddSample
+ *          and DPT_Process every sample, HR_Calculate and the display update
+ *          every 250 samples. The output of every stage (raw interval / period
+ *          estimate, median, rate limit, EMA, displayed value) is recorded and
+ *          reported as:
+ *
+ *            t50, t90  time from the start of the change until the stage has
+ *                      covered 50% / 90% of its own change
+ *            settle    time from the start of the change until the stage stays
+ *                      within +-settle_bpm of its final value
+ *
+ *          Levels are each stage's own mean before the change and over the
+ *          last 20 s, so a stage that reads a few bpm off still gets correct
+ *          timings ("gain" shows how much of the true change it reports).
+ *          Stage times include the sample's FIFO dwell (-f); the display row
+ *          also includes the OLED frame transfer (-o). With -B, the times are
+ *          checked against a budget file ("method stage scenario metric max_s"
+ *          per line) so the smoothing parameters can be tuned against it.
+ *
+ * Usage: hr_latency [-m 1|2] [-a from_bpm] [-b to_bpm] [-r ramp_s]
+ *                   [-f fifo_ms] [-o oled_ms] [-t settle_bpm]
+ *                   [-c out.csv] [-B budget.txt]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SAMPLE_RATE_HZ      100
+#define CALC_INTERVAL       250             // main.c: HR update and display every 2.5 s
+#define PRE_SECONDS         40.0            // before the change: DPT buffer fill and settling
+#define POST_SECONDS        120.0           // after the change (display EMA is slow)
+#define LEVEL_SECONDS       10.0            // level before the change: mean over this window
+#define FINAL_SECONDS       20.0            // level after the change: mean over the last 20 s
+#define MAX_POINTS          24576           // >= (PRE + POST + ramp) seconds * 100 Hz
+#define MIN_GAIN            0.25            // below this a stage is reported as not responding
+
+typedef enum {
+    STAGE_INPUT = 0,
+    STAGE_RAW,
+    STAGE_MEDIAN,
+    STAGE_LIMIT,
+    STAGE_EMA,
+    STAGE_DISPLAY,
+    STAGE_COUNT
+} Stage_t;
+
+static const char *const stage_names[STAGE_COUNT] = {
+    "input", "raw", "median", "limit", "ema", "display",
+};
+
+typedef enum {
+    SCENARIO_STEP = 0,
+    SCENARIO_RAMP,
+    SCENARIO_COUNT
+} Scenario_t;
+
+static const char *const scenario_names[SCENARIO_COUNT] = { "step", "ramp" };
+
+typedef struct {
+    int method;                 // 1 or 2
+    double from_bpm;
+    double to_bpm;
+    double ramp_s;
+    double fifo_ms;
+    double oled_ms;
+    double settle_bpm;
+} Config_t;
+
+typedef struct {
+    int count;
+    float t[MAX_POINTS];        // seconds, relative to the start of the change
+    float v[MAX_POINTS];
+} Series_t;
+
+typedef struct {
+    int responded;
+    double before;
+    double after;
+    double gain;
+    double t50;                 // < 0: never reached
+    double t90;
+    double settle;
+} Result_t;
+
+static Series_t series[STAGE_COUNT];
+static Result_t results[3][SCENARIO_COUNT][STAGE_COUNT];   // [method][scenario][stage]
+static FILE *csv_out = NULL;
+
+static uint32_t lcg_state = 1u;
+
+static double noise(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (double)(lcg_state >> 8) / 16777216.0 - 0.5;
+}
+
+static double true_hr(const Config_t *cfg, Scenario_t scenario, double t) {
+    if (t < 0.0) {
+        return cfg->from_bpm;
+    }
+    if (scenario == SCENARIO_RAMP && t < cfg->ramp_s) {
+        return cfg->from_bpm + (cfg->to_bpm - cfg->from_bpm) * t / cfg->ramp_s;
+    }
+    return cfg->to_bpm;
+}
+
+static void record(Stage_t stage, double t, float value) {
+    Series_t *s = &series[stage];
+    if (s->count < MAX_POINTS) {
+        s->t[s->count] = (float)t;
+        s->v[s->count] = value;
+        s->count++;
+    }
+}
+
+/**
+ * Run one method over one scenario and fill series[] with the stage outputs.
+ * Times are relative to the start of the change and include the fixed delays.
+ */
+static void simulate(const Config_t *cfg, Scenario_t scenario) {
+    static PPG_FilterState_t ir_filter;
+    static HR_State_t hr_state;
+    static DPT_State_t dpt_state;
+    const double fs = SAMPLE_RATE_HZ;
+    const double fifo_s = cfg->fifo_ms / 1000.0;
+    const double display_s = fifo_s + cfg->oled_ms / 1000.0;
+    const double duration = PRE_SECONDS + POST_SECONDS + (scenario == SCENARIO_RAMP ? cfg->ramp_s : 0.0);
+    const uint32_t n = (uint32_t)(duration * fs);
+
+    memset(series, 0, sizeof(series));
+    lcg_state = 1u;
+    PPG_Filter_Init(&ir_filter);
+    HR_Init(&hr_state);
+    DPT_Init(&dpt_state);
+
+    float displayed_hr = 0.0f;
+    double phase = 0.0;
+    uint32_t sample_counter = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        // Photon time of this sample, relative to the change
+        double t = (double)i / fs - PRE_SECONDS;
+        double hr = true_hr(cfg, scenario, t);
+        phase += 2.0 * M_PI * hr / 60.0 / fs;
+        double pulse = sin(phase) + 0.3 * sin(2.0 * phase + 0.8);
+        uint32_t raw_ir = (uint32_t)(120000.0 + 3000.0 * pulse + 20.0 * noise());
+        uint32_t raw_red = (uint32_t)(90000.0 + 1500.0 * pulse + 20.0 * noise());
+        record(STAGE_INPUT, t, (float)hr);
+
+        if (cfg->method == 1) {
+            float ac_ir = PPG_Filter_Process(&ir_filter, raw_ir);
+            HR_AddSample(&hr_state, ac_ir, PPG_Filter_GetDC(&ir_filter));
+        } else {
+            DPT_Process(&dpt_state, raw_red, raw_ir);
+            // The DPT stages update every sample once the 10 s buffer is full
+            if (dpt_state.heart_rate > 0.0f) {
+                record(STAGE_RAW, t + fifo_s, dpt_state.raw_hr);
+                record(STAGE_MEDIAN, t + fifo_s, dpt_state.median_hr);
+                record(STAGE_LIMIT, t + fifo_s, dpt_state.limited_hr);
+                record(STAGE_EMA, t + fifo_s, dpt_state.heart_rate);
+            }
+        }
+
+        if (++sample_counter < CALC_INTERVAL) {
+            continue;
+        }
+        sample_counter = 0;
+
+        if (cfg->method == 1) {
+            float heart_rate = HR_Calculate(&hr_state);
+            if (hr_state.ema_hr > 0.0f) {
+                record(STAGE_RAW, t + fifo_s, hr_state.raw_hr);
+                record(STAGE_MEDIAN, t + fifo_s, hr_state.median_hr);
+                record(STAGE_LIMIT, t + fifo_s, hr_state.limited_hr);
+                record(STAGE_EMA, t + fifo_s, heart_rate);
+            }
+            if (HR_IsValid(&hr_state)) {
+                displayed_hr = HR_DisplaySmooth(displayed_hr, heart_rate);
+            }
+            if (HR_IsValid(&hr_state) && displayed_hr > 0.0f) {
+                record(STAGE_DISPLAY, t + display_s, displayed_hr);
+            }
+        } else if (DPT_IsHeartRateValid(&dpt_state) && dpt_state.heart_rate > 0.0f) {
+            // main.c shows the DPT heart rate directly
+            record(STAGE_DISPLAY, t + display_s, DPT_GetHeartRate(&dpt_state));
+        }
+    }
+}
+
+static double window_mean(const Series_t *s, double from, double to, int *found) {
+    double sum = 0.0;
+    int count = 0;
+    for (int i = 0; i < s->count; i++) {
+        if (s->t[i] >= from && s->t[i] < to) {
+            sum += s->v[i];
+            count++;
+        }
+    }
+    *found = (count > 0);
+    return count ? sum / count : 0.0;
+}
+
+static Result_t analyse(const Series_t *s, double end_t, double settle_bpm) {
+    Result_t r;
+    int have_before, have_after;
+    memset(&r, 0, sizeof(r));
+    r.t50 = r.t90 = r.settle = -1.0;
+
+    r.before = window_mean(s, -LEVEL_SECONDS, 0.0, &have_before);
+    r.after = window_mean(s, end_t - FINAL_SECONDS, end_t + 1.0, &have_after);
+    if (!have_before || !have_after) {
+        return r;
+    }
+    double delta = r.after - r.before;
+    r.responded = 1;
+
+    int first = -1;
+    int last_outside = -1;
+    for (int i = 0; i < s->count; i++) {
+        if (s->t[i] < 0.0) {
+            continue;
+        }
+        if (first < 0) first = i;
+        double progress = (delta != 0.0) ? (s->v[i] - r.before) / delta : 0.0;
+        if (r.t50 < 0.0 && progress >= 0.5) r.t50 = s->t[i];
+        if (r.t90 < 0.0 && progress >= 0.9) r.t90 = s->t[i];
+        if (fabs(s->v[i] - r.after) > settle_bpm) {
+            last_outside = i;
+        }
+    }
+    // Settled at the first output after the last one outside the band
+    int settled = (last_outside < 0) ? first : last_outside + 1;
+    if (settled >= 0 && settled < s->count) {
+        r.settle = s->t[settled];
+    }
+    return r;
+}
+
+static void print_time(double t) {
+    if (t < 0.0) {
+        printf("  %8s", "--");
+    } else {
+        printf("  %8.2f", t);
+    }
+}
+
+static void run(const Config_t *cfg, Scenario_t scenario) {
+    double true_delta = cfg->to_bpm - cfg->from_bpm;
+    double end_t = POST_SECONDS + (scenario == SCENARIO_RAMP ? cfg->ramp_s : 0.0);
+
+    simulate(cfg, scenario);
+
+    printf("=== Method %d, %s %.0f -> %.0f bpm", cfg->method, scenario_names[scenario],
+           cfg->from_bpm, cfg->to_bpm);
+    if (scenario == SCENARIO_RAMP) {
+        printf(" over %.0f s", cfg->ramp_s);
+    }
+    printf(" ===\n");
+    printf("  %-8s  %8s  %8s  %6s  %8s  %8s  %8s\n",
+           "stage", "before", "after", "gain", "t50 s", "t90 s", "settle s");
+
+    for (int st = 0; st < STAGE_COUNT; st++) {
+        Result_t r = analyse(&series[st], end_t, cfg->settle_bpm);
+        r.gain = (true_delta != 0.0) ? (r.after - r.before) / true_delta : 0.0;
+        if (r.responded && fabs(r.gain) < MIN_GAIN) {
+            r.responded = 0;
+        }
+        results[cfg->method][scenario][st] = r;
+
+        printf("  %-8s", stage_names[st]);
+        if (series[st].count == 0) {
+            printf("  (no output)\n");
+            continue;
+        }
+        printf("  %8.1f  %8.1f  %6.2f", r.before, r.after, r.gain);
+        if (!r.responded) {
+            printf("  (does not follow the change)\n");
+            continue;
+        }
+        print_time(r.t50);
+        print_time(r.t90);
+        print_time(r.settle);
+        printf("\n");
+
+        if (csv_out != NULL) {
+            for (int i = 0; i < series[st].count; i++) {
+                fprintf(csv_out, "%d,%s,%s,%.3f,%.2f\n", cfg->method, scenario_names[scenario],
+                        stage_names[st], series[st].t[i], series[st].v[i]);
+            }
+        }
+    }
+    printf("\n");
+}
+
+static int find_index(const char *const *names, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Compare stage times with a budget file
+ * @return number of entries over budget, -1 if the file cannot be read or is invalid
+ */
+static int check_budget(const char *path, int methods_run) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char line[160];
+    int over = 0;
+    int entries = 0;
+    printf("Latency budget (%s):\n", path);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char method_name[8], stage_name[16], scenario_name[16], metric[16];
+        double budget;
+        if (line[0] == '#' ||
+            sscanf(line, "%7s %15s %15s %15s %lf", method_name, stage_name, scenario_name, metric, &budget) != 5) {
+            continue;
+        }
+        int method = (strcmp(method_name, "m1") == 0) ? 1 : (strcmp(method_name, "m2") == 0) ? 2 : 0;
+        int stage = find_index(stage_names, STAGE_COUNT, stage_name);
+        int scenario = find_index(scenario_names, SCENARIO_COUNT, scenario_name);
+        if (method == 0 || stage < 0 || scenario < 0) {
+            fprintf(stderr, "%s: unknown entry: %s", path, line);
+            fclose(f);
+            return -1;
+        }
+        if (!(methods_run & (1 << method))) {
+            continue;
+        }
+
+        const Result_t *r = &results[method][scenario][stage];
+        double actual = -1.0;
+        if (r->responded) {
+            actual = (strcmp(metric, "t50") == 0) ? r->t50 :
+                     (strcmp(metric, "t90") == 0) ? r->t90 :
+                     (strcmp(metric, "settle") == 0) ? r->settle : -2.0;
+        }
+        if (actual < -1.5) {
+            fprintf(stderr, "%s: unknown metric '%s'\n", path, metric);
+            fclose(f);
+            return -1;
+        }
+        // A stage that never gets there is over any budget
+        int exceeded = (actual < 0.0) || (actual > budget);
+        over += exceeded;
+        entries++;
+        printf("  %s %-8s %-5s %-7s", method_name, stage_name, scenario_name, metric);
+        if (actual < 0.0) {
+            printf(" %8s / %6.1f s OVER BUDGET\n", "never", budget);
+        } else {
+            printf(" %8.2f / %6.1f s %s\n", actual, budget, exceeded ? "OVER BUDGET" : "ok");
+        }
+    }
+    fclose(f);
+    return (entries > 0) ? over : -1;
+}
+
+int main(int argc, char **argv) {
+    Config_t cfg;
+    const char *csv_path = NULL;
+    const char *budget_path = NULL;
+    int only_method = 0;
+
+    cfg.method = 1;
+    cfg.from_bpm = 90.0;
+    cfg.to_bpm = 100.0;
+    cfg.ramp_s = 20.0;
+    cfg.fifo_ms = 5.0;          // half a sample period: the loop polls the FIFO continuously
+    cfg.oled_ms = 25.0;         // 1 KB frame over 400 kHz I2C
+    cfg.settle_bpm = 3.0;       // just above DISPLAY_HR_THRESHOLD
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            only_method = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            cfg.from_bpm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            cfg.to_bpm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            cfg.ramp_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            cfg.fifo_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            cfg.oled_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            cfg.settle_bpm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            budget_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-m 1|2] [-a from_bpm] [-b to_bpm] [-r ramp_s] "
+                            "[-f fifo_ms] [-o oled_ms] [-t settle_bpm] [-c out.csv] [-B budget.txt]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if ((only_method != 0 && only_method != 1 && only_method != 2) ||
+        cfg.from_bpm == cfg.to_bpm || cfg.ramp_s <= 0.0 || cfg.settle_bpm <= 0.0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    if (csv_path != NULL) {
+        csv_out = fopen(csv_path, "w");
+        if (csv_out == NULL) {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(csv_out, "method,scenario,stage,t_s,hr_bpm\n");
+    }
+
+    printf("Fixed delays: FIFO dwell %.1f ms, OLED frame %.1f ms; settle band +-%.1f bpm\n\n",
+           cfg.fifo_ms, cfg.oled_ms, cfg.settle_bpm);
+
+    int methods_run = 0;
+    for (int method = 1; method <= 2; method++) {
+        if (only_method != 0 && method != only_method) {
+            continue;
+        }
+        cfg.method = method;
+        methods_run |= 1 << method;
+        for (int sc = 0; sc < SCENARIO_COUNT; sc++) {
+            run(&cfg, (Scenario_t)sc);
+        }
+    }
+    if (csv_out != NULL) {
+        fclose(csv_out);
+    }
+
+    if (budget_path != NULL) {
+        int over = check_budget(budget_path, methods_run);
+        if (over != 0) {
+            printf("\n%s\n", (over > 0) ? "=== Latency budget exceeded ===" : "=== Budget check failed ===");
+            return 1;
+        }
+        printf("\n=== All stages within latency budget ===\n");
+    }
+    return 0;
+}
@@ -0,0 +1,344 @@
+/**
+ * @file op_count_report.cpp
+ * @brief Estimated Cortex-M3 cost of each DSP stage, from host operation counts
+ * @details Runs the filter, Method 1 and Method 2 (DPT) code on a fixed
+ *          synthetic PPG signal with the same call pattern as main.c (filters,
+ *          HR_AddSample and DPT_Process every sample, HR_Calculate and
+ *          SpO2_Calculate every 250 samples). The algorithm sources are
+ *          compiled with op_count.h, so every soft-float and <stdint.h>
+ *          integer operation is counted; the counts are weighted with the
+ *          cycle cost table to estimate cycles per call, cycles per sample and
+ *          CPU load at 72 MHz / 100 Hz.
+ *
+ *          The counts are exact and machine independent, so a budget file
+ *          (-B, "stage max_cycles_per_call" per line) turns this into a cost
+ *          regression check that needs no hardware. With a profiler capture
+ *          (-P, the CSV of `prof_report -c`) the estimate is set against the
+ *          cycles measured on the board, which shows how much the uncounted
+ *          work (branches, loop overhead, plain int counters) adds per stage.
+ *
+ * Usage: op_count_report [-c] [-s seconds] [-k costs.txt] [-B budget.txt] [-P prof.csv]
+ */
+
+// The algorithm API as the counted sources see it (same layout, same symbols)
+#define OP_COUNT_INTEGERS
+#include "op_count.h"
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+
+// The harness itself counts nothing of its own integer work
+#undef uint8_t
+#undef int8_t
+#undef uint16_t
+#undef int16_t
+#undef uint32_t
+#undef int32_t
+
+#define SAMPLE_RATE_HZ      100
+#define CPU_HZ              72000000.0
+#define CALC_INTERVAL       250             // main.c: HR/SpO2 every 2.5 s
+#define WARMUP_SECONDS      12              // DPT needs 10 s of buffer before full cost
+#define DEFAULT_SECONDS     60
+#define SIGNAL_HR_HZ        2.0
+
+typedef enum {
+    STAGE_FILTER = 0,
+    STAGE_HR_ADD,
+    STAGE_HR_CALC,
+    STAGE_SPO2_CALC,
+    STAGE_DPT_PROCESS,
+    STAGE_COUNT
+} Stage_t;
+
+// Same names as the on-target profiler (profiler.c) so the two can be compared
+static const char *const stage_names[STAGE_COUNT] = {
+    "filter", "hr_add", "hr_calc", "spo2_calc", "dpt_process",
+};
+
+typedef struct {
+    uint32_t calls;
+    OpCounts_t ops;
+} StageTotals_t;
+
+static StageTotals_t totals[STAGE_COUNT];
+static OpCounts_t stage_start;
+
+static void stage_begin(void) {
+    stage_start = op_counts;
+}
+
+static void stage_end(Stage_t stage, int counted) {
+    if (!counted) {
+        return;
+    }
+    OpCounts_t delta;
+    Op_Diff(&op_counts, &stage_start, &delta);
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        totals[stage].ops.n[k] += delta.n[k];
+    }
+    totals[stage].calls++;
+}
+
+// Deterministic PPG with respiration baseline and noise, computed in double so
+// signal generation is not counted. 120 bpm puts three beats into the 1.6 s
+// HR_Calculate window, so its full peak/interval path is exercised.
+static void make_sample(uint32_t i, uint32_t *red, uint32_t *ir) {
+    static uint32_t lcg = 12345u;
+    double t = (double)i / SAMPLE_RATE_HZ;
+    double pulse = sin(2.0 * M_PI * SIGNAL_HR_HZ * t) + 0.3 * sin(4.0 * M_PI * SIGNAL_HR_HZ * t + 0.8);
+    double resp = sin(2.0 * M_PI * 0.25 * t);
+    lcg = lcg * 1664525u + 1013904223u;
+    double noise = (double)((lcg >> 8) & 0xFFFF) / 65535.0 - 0.5;
+    *ir = (uint32_t)(120000.0 + 3000.0 * pulse + 400.0 * resp + 60.0 * noise);
+    *red = (uint32_t)(90000.0 + 1500.0 * pulse + 300.0 * resp + 60.0 * noise);
+}
+
+static void run_pipeline(uint32_t seconds) {
+    static PPG_FilterState_t red_filter, ir_filter;
+    static HR_State_t hr_state;
+    static SpO2_State_t spo2_state;
+    static DPT_State_t dpt_state;
+
+    PPG_Filter_Init(&red_filter);
+    PPG_Filter_Init(&ir_filter);
+    HR_Init(&hr_state);
+    SpO2_Init(&spo2_state);
+    DPT_Init(&dpt_state);
+
+    uint32_t samples = (WARMUP_SECONDS + seconds) * SAMPLE_RATE_HZ;
+    for (uint32_t i = 0; i < samples; i++) {
+        int counted = i >= WARMUP_SECONDS * SAMPLE_RATE_HZ;
+        uint32_t raw_red, raw_ir;
+        make_sample(i, &raw_red, &raw_ir);
+
+        // Method 1
+        stage_begin();
+        float ac_red = PPG_Filter_Process(&red_filter, raw_red);
+        float ac_ir = PPG_Filter_Process(&ir_filter, raw_ir);
+        stage_end(STAGE_FILTER, counted);
+        (void)ac_red;
+
+        stage_begin();
+        HR_AddSample(&hr_state, ac_ir, PPG_Filter_GetDC(&ir_filter));
+        stage_end(STAGE_HR_ADD, counted);
+
+        if ((i + 1) % CALC_INTERVAL == 0) {
+            stage_begin();
+            HR_Calculate(&hr_state);
+            stage_end(STAGE_HR_CALC, counted);
+
+            stage_begin();
+            SpO2_Calculate(&spo2_state, PPG_Filter_GetACRMS(&red_filter), PPG_Filter_GetDC(&red_filter),
+                           PPG_Filter_GetACRMS(&ir_filter), PPG_Filter_GetDC(&ir_filter));
+            stage_end(STAGE_SPO2_CALC, counted);
+        }
+
+        // Method 2
+        stage_begin();
+        DPT_Process(&dpt_state, raw_red, raw_ir);
+        stage_end(STAGE_DPT_PROCESS, counted);
+    }
+}
+
+static double cycles_per_call(Stage_t s) {
+    return totals[s].calls ? Op_Cycles(&totals[s].ops) / totals[s].calls : 0.0;
+}
+
+static void print_table(uint32_t samples) {
+    printf("Estimated Cortex-M3 cost (%u samples, %.0f MHz, %d Hz)\n\n", samples, CPU_HZ / 1e6, SAMPLE_RATE_HZ);
+    printf("  %-12s %7s %11s %11s %7s |", "stage", "calls", "cyc/call", "cyc/sample", "cpu");
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        printf(" %7s", Op_Name((OpKind_t)k));
+    }
+    printf("\n");
+
+    double method_cycles[2] = { 0.0, 0.0 };
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const StageTotals_t *t = &totals[s];
+        double per_sample = Op_Cycles(&t->ops) / samples;
+        method_cycles[s == STAGE_DPT_PROCESS] += per_sample;
+        printf("  %-12s %7u %11.0f %11.0f %6.2f%% |", stage_names[s], t->calls, cycles_per_call((Stage_t)s),
+               per_sample, 100.0 * per_sample * SAMPLE_RATE_HZ / CPU_HZ);
+        for (int k = 0; k < OP_KIND_COUNT; k++) {
+            printf(" %7.1f", t->calls ? (double)t->ops.n[k] / t->calls : 0.0);
+        }
+        printf("\n");
+    }
+    printf("  (op columns: operations per call)\n\n");
+    printf("  Method 1 total: %.0f cycles/sample, %.2f%% CPU\n", method_cycles[0],
+           100.0 * method_cycles[0] * SAMPLE_RATE_HZ / CPU_HZ);
+    printf("  Method 2 total: %.0f cycles/sample, %.2f%% CPU\n", method_cycles[1],
+           100.0 * method_cycles[1] * SAMPLE_RATE_HZ / CPU_HZ);
+}
+
+static void print_csv(uint32_t samples) {
+    printf("stage,calls,cycles_per_call,cycles_per_sample");
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        printf(",%s_per_call", Op_Name((OpKind_t)k));
+    }
+    printf("\n");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const StageTotals_t *t = &totals[s];
+        printf("%s,%u,%.1f,%.1f", stage_names[s], t->calls, cycles_per_call((Stage_t)s),
+               Op_Cycles(&t->ops) / samples);
+        for (int k = 0; k < OP_KIND_COUNT; k++) {
+            printf(",%.2f", t->calls ? (double)t->ops.n[k] / t->calls : 0.0);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Compare cycles per call with a budget file
+ * @return number of stages over budget, -1 if the file cannot be read
+ */
+static int check_budget(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    int over = 0;
+    char line[128];
+    printf("\nBudget %s:\n", path);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[32];
+        double budget;
+        if (line[0] == '#' || sscanf(line, "%31s %lf", name, &budget) != 2) {
+            continue;
+        }
+        int s = 0;
+        while (s < STAGE_COUNT && strcmp(name, stage_names[s]) != 0) {
+            s++;
+        }
+        if (s == STAGE_COUNT) {
+            fprintf(stderr, "%s: unknown stage '%s'\n", path, name);
+            over++;
+            continue;
+        }
+        double actual = cycles_per_call((Stage_t)s);
+        int exceeded = actual > budget;
+        over += exceeded;
+        printf("  %-12s %11.0f / %11.0f cycles %s\n", name, actual, budget, exceeded ? "OVER BUDGET" : "ok");
+    }
+    fclose(f);
+    return over;
+}
+
+/**
+ * @brief Compare the estimate with cycles measured by the on-target profiler
+ * @details Reads `prof_report -c` output and sums calls and cycles per stage
+ *          over all reports. Stages this program does not run (fifo_read,
+ *          oled_refresh, loop) are skipped. The scale printed last is the
+ *          least-squares factor on the whole cost table that best fits the
+ *          measurements; the remainder per stage is what the counted
+ *          operations do not explain.
+ * @return 0 on success, -1 if the file cannot be read or has no common stage
+ */
+static int compare_profile(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    double calls[STAGE_COUNT] = { 0 };
+    double measured[STAGE_COUNT] = { 0 };
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned report, interval_ms, count;
+        double total;
+        char name[32];
+        // report,stage,interval_ms,calls,total,...; the header line does not parse
+        if (sscanf(line, "%u,%31[^,],%u,%u,%lf", &report, name, &interval_ms, &count, &total) != 5) {
+            continue;
+        }
+        int s = 0;
+        while (s < STAGE_COUNT && strcmp(name, stage_names[s]) != 0) {
+            s++;
+        }
+        if (s < STAGE_COUNT) {
+            calls[s] += count;
+            measured[s] += total;
+        }
+    }
+    fclose(f);
+
+    printf("\nMeasured %s:\n", path);
+    printf("  %-12s %11s %11s %7s %11s\n", "stage", "measured", "estimated", "ratio", "uncounted");
+    double cross = 0.0, square = 0.0;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        double estimated = cycles_per_call((Stage_t)s);
+        if (calls[s] == 0.0 || estimated <= 0.0) {
+            continue;
+        }
+        double actual = measured[s] / calls[s];
+        printf("  %-12s %11.0f %11.0f %7.2f %11.0f\n", stage_names[s], actual, estimated, actual / estimated,
+               actual - estimated);
+        cross += actual * estimated;
+        square += estimated * estimated;
+    }
+    if (square == 0.0) {
+        fprintf(stderr, "%s: no stage in common with the estimate\n", path);
+        return -1;
+    }
+    printf("  best fit: cost table x %.2f\n", cross / square);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *cost_path = NULL;
+    const char *budget_path = NULL;
+    const char *profile_path = NULL;
+    long seconds = DEFAULT_SECONDS;
+    int csv = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            csv = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seconds = strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            cost_path = argv[++i];
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            budget_path = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-c] [-s seconds] [-k costs.txt] [-B budget.txt] [-P prof.csv]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (seconds < 1 || seconds > 3600) {
+        fprintf(stderr, "invalid duration %ld\n", seconds);
+        return 2;
+    }
+    if (cost_path != NULL && Op_LoadCostTable(cost_path) != 0) {
+        fprintf(stderr, "cannot load cost table %s\n", cost_path);
+        return 1;
+    }
+
+    Op_Reset();
+    run_pipeline((uint32_t)seconds);
+
+    uint32_t samples = (uint32_t)seconds * SAMPLE_RATE_HZ;
+    if (csv) {
+        print_csv(samples);
+    } else {
+        print_table(samples);
+    }
+    if (profile_path != NULL && compare_profile(profile_path) != 0) {
+        return 1;
+    }
+
+    if (budget_path != NULL) {
+        int over = check_budget(budget_path);
+        if (over != 0) {
+            printf("\n%s\n", (over > 0) ? "=== Cost budget exceeded ===" : "=== Budget check failed ===");
+            return 1;
+        }
+        printf("\n=== All stages within budget ===\n");
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file ppg_capture_decode.c
+ * @brief Host decoder for the raw-PPG capture stream (USE_RAW_CAPTURE firmware mode)
+ * @details Reads the UART byte stream (binary telemetry frames, possibly mixed
+ *          with printf text), decodes TLM_TYPE_RAW_PPG frames and writes
+ *          "index,red,ir" CSV. Lost or corrupt frames show up as index gaps.
+ *
+ *          With an output name ending in .ppgrec it writes a recording
+ *          container (ppg_rec.h) instead: compressed chunks, lost samples as
+ *          gaps between chunks, -D device id and -r sample rate in the header.
+ *
+ * Usage: ppg_capture_decode [-o out.csv|out.ppgrec] [-D device_id] [-r rate_hz] [-q] [capture.bin]
+ *        (reads stdin when no input file is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+#include "ppg_codec.h"
+#include "ppg_rec.h"
+
+typedef struct {
+    PPG_Decoder_t dec;
+    uint32_t expected_index;    // index of the next sample we expect
+    uint8_t have_index;
+    FILE *out;
+    PPGRec_Writer_t *rec;       // .ppgrec output
+
+    uint64_t samples_decoded;
+    uint64_t samples_lost;
+    uint64_t payload_bytes;
+} DecodeContext_t;
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void handle_raw_ppg(DecodeContext_t *ctx, const uint8_t *payload, uint16_t len) {
+    if (len < PPG_CAPTURE_FRAME_HEADER) {
+        return;
+    }
+    uint32_t index = read_le32(payload);
+    uint8_t blocks = payload[4];
+
+    if (ctx->have_index && index != ctx->expected_index) {
+        // Gap in the stream: predictor history is gone until the next keyframe
+        if (index > ctx->expected_index) {
+            ctx->samples_lost += index - ctx->expected_index;
+        }
+        PPG_Decoder_Init(&ctx->dec);
+    }
+    ctx->have_index = 1;
+    ctx->payload_bytes += len;
+
+    uint16_t pos = PPG_CAPTURE_FRAME_HEADER;
+    for (uint8_t b = 0; b < blocks; b++) {
+        uint32_t red[PPG_CODEC_BLOCK_SIZE], ir[PPG_CODEC_BLOCK_SIZE];
+        uint8_t count = 0;
+        int16_t used = PPG_Decoder_DecodeBlock(&ctx->dec, &payload[pos], (uint16_t)(len - pos),
+                                               red, ir, &count);
+        if (used < 0) {
+            fprintf(stderr, "warning: truncated block at sample %u\n", index);
+            PPG_Decoder_Init(&ctx->dec);
+            break;
+        }
+        pos = (uint16_t)(pos + used);
+
+        if (ctx->dec.synced) {
+            for (uint8_t i = 0; i < count; i++) {
+                if (ctx->out != NULL) {
+                    fprintf(ctx->out, "%u,%u,%u\n", index + i, red[i], ir[i]);
+                }
+                if (ctx->rec != NULL) {
+                    // A gap ends the chunk; an index going backwards (device reset) is appended as is
+                    if (index + i > ctx->rec->next_sample) {
+                        PPGRec_Gap(ctx->rec, index + i);
+                    }
+                    PPGRec_Append(ctx->rec, red[i], ir[i], NULL);
+                }
+            }
+            ctx->samples_decoded += count;
+        } else {
+            ctx->samples_lost += count;
+        }
+        index += count;
+    }
+    ctx->expected_index = index;
+}
+
+int main(int argc, char **argv) {
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+    const char *device_id = "";
+    float rate_hz = 100.0f;
+    int quiet = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            device_id = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate_hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "usage: %s [-o out.csv|out.ppgrec] [-D device_id] [-r rate_hz] [-q] [capture.bin]\n",
+                    argv[0]);
+            return 2;
+        } else {
+            in_path = argv[i];
+        }
+    }
+
+    FILE *in = (in_path != NULL) ? fopen(in_path, "rb") : stdin;
+    if (in == NULL) {
+        perror(in_path);
+        return 1;
+    }
+
+    DecodeContext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    PPG_Decoder_Init(&ctx.dec);
+    ctx.out = quiet ? NULL : stdout;
+    static PPGRec_Writer_t writer;
+    size_t out_len = (out_path != NULL) ? strlen(out_path) : 0;
+    if (out_len > 7 && strcmp(out_path + out_len - 7, ".ppgrec") == 0) {
+        PPGRec_Header_t header;
+        PPGRec_DefaultHeader(&header, rate_hz);
+        snprintf(header.device_id, sizeof(header.device_id), "%s", device_id);
+        if (rate_hz <= 0.0f || PPGRec_Create(&writer, out_path, &header) != 0) {
+            perror(out_path);
+            return 1;
+        }
+        ctx.rec = &writer;
+        ctx.out = NULL;
+    } else if (out_path != NULL) {
+        ctx.out = fopen(out_path, "w");
+        if (ctx.out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+    if (ctx.out != NULL) {
+        fprintf(ctx.out, "index,red,ir\n");
+    }
+
+    static TLM_Parser_t parser;
+    TLM_Parser_Init(&parser);
+
+    uint64_t bytes_in = 0;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        bytes_in += n;
+        for (size_t i = 0; i < n; i++) {
+            if (TLM_Parser_Feed(&parser, buf[i]) && parser.type == TLM_TYPE_RAW_PPG) {
+                handle_raw_ppg(&ctx, parser.payload, parser.len);
+            }
+        }
+    }
+
+    if (in != stdin) fclose(in);
+    if (ctx.out != NULL && ctx.out != stdout) fclose(ctx.out);
+    if (ctx.rec != NULL) {
+        uint32_t chunks = writer.chunk_count + (writer.count > 0);
+        if (PPGRec_Finish(&writer) != 0) {
+            perror(out_path);
+            return 1;
+        }
+        fprintf(stderr, "recording: %s, %u chunks\n", out_path, chunks);
+    }
+
+    double packed_bytes = (double)ctx.samples_decoded * 2.0 * PPG_CODEC_SAMPLE_BITS / 8.0;
+    double fifo_bytes = (double)ctx.samples_decoded * 2.0 * 3.0;
+    fprintf(stderr, "frames: %u ok, %u crc errors, %u bytes skipped\n",
+            parser.frames_ok, parser.crc_errors, parser.bytes_skipped);
+    fprintf(stderr, "samples: %llu decoded, %llu lost\n",
+            (unsigned long long)ctx.samples_decoded, (unsigned long long)ctx.samples_lost);
+    if (ctx.payload_bytes > 0) {
+        fprintf(stderr, "bytes: %llu in, %llu payload, %.2f bits/sample/channel\n",
+                (unsigned long long)bytes_in, (unsigned long long)ctx.payload_bytes,
+                ctx.samples_decoded ? (double)bytes_in * 8.0 / (2.0 * ctx.samples_decoded) : 0.0);
+        fprintf(stderr, "ratio: %.2fx vs packed 18-bit, %.2fx vs 3-byte FIFO samples\n",
+                packed_bytes / (double)bytes_in, fifo_bytes / (double)bytes_in);
+    }
+    return 0;
+}
@@ -0,0 +1,502 @@
+/**
+ * @file ppg_gateway.c
+ * @brief Gateway daemon and benchmark: -n device streams through the gateway engine
+ * @details Runs the gateway (ppg_gateway.h) with -n streams, each through
+ *          the variants in -v (comma separated, default m1,m2) on -j worker
+ *          threads (default: one per CPU, pinned unless -A) with a -T ms tick.
+ *          -u serves the socket API (gateway_api.h) at the given path.
+ *
+ *          The devices are played by the synthesiser: -P patients of -W
+ *          seconds from seed -s are generated once, and device d replays
+ *          patient d mod P from its own offset, looping. -f feeder threads
+ *          wake every -F ms and push each of their devices the samples due
+ *          by then at -r Hz (every device on its own phase), stamped with
+ *          the time of the push - the moment a network gateway would have
+ *          received them.
+ *
+ *          Runs -t seconds (0: until SIGINT / SIGTERM), printing a status
+ *          line every -i seconds unless -q, then reports throughput, worker
+ *          utilisation, the latency distribution (arrival to published:
+ *          aggregate p50 / p99 / max, and the median and worst of the
+ *          per-stream p99), the workers' last-level cache misses per sample
+ *          where the hardware counter is available, and the capacity the
+ *          measured cost per sample extrapolates to. Method 2 only starts transforming once its 10 s
+ *          buffer is full, so the cost per sample of a timed run is taken
+ *          over its second half. "Gateway passed" when every pushed sample was
+ *          processed and no ring or event was dropped.
+ *
+ * Usage: ppg_gateway [-n streams] [-v m1,m2] [-j workers] [-T tick_ms] [-t seconds] [-u socket]
+ *                    [-P patients] [-W seconds] [-s seed] [-r rate_hz] [-f feeders] [-F period_ms]
+ *                    [-i interval_s] [-C checkpoint] [-K checkpoint_ms] [-E load] [-A] [-B] [-M] [-S] [-q]
+ *
+ *          -B filters the Method 1 front ends of each worker's streams together
+ *          (filter_batch.h), with the best SIMD kernel of the machine.
+ *
+ *          -C keeps the streams' algorithm states in a checkpoint file, every
+ *          stream rewritten at least every -K ms (default 1000) and all at
+ *          exit; started again with the same file and configuration, the
+ *          gateway resumes every stream where it was instead of re-warming it.
+ *
+ *          -M runs the feeders as processes, the way acquisition processes
+ *          would: each writes its devices' samples straight into their rings
+ *          in a shared-memory segment (shm_ring.h) the gateway reads in place.
+ *
+ *          -S keeps each stream's variant states in one block (the layout
+ *          before the state pools, no prefetch): the "before" of a run with
+ *          the same arguments.
+ *
+ *          -v ad runs the adaptive variant (Method 1, DPT on poor signals);
+ *          the report gives the share of samples each engine took. -E holds
+ *          its escalations while a worker's tick takes more than that
+ *          fraction of the tick (e.g. 0.5).
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include "ppg_gateway.h"
+#include "gateway_api.h"
+#include "ppg_score.h"
+
+#define MAX_FEEDERS     64
+
+typedef struct {
+    PPGGateway_t *gw;
+    ShmRing_Seg_t *ingest;          // -M: the devices' rings, written by a process
+    const PPGScore_Record_t *patients;
+    uint32_t patient_count;
+    uint32_t first;                 // devices first .. first + count - 1
+    uint32_t count;
+    float rate_hz;
+    uint64_t period_ns;
+    uint64_t start_ns;
+    _Atomic int *stop;
+    pthread_t thread;
+    pid_t pid;
+    uint64_t pushed;
+} Feeder_t;
+
+// Shared with feeder processes: the stop flag and their counts
+typedef struct {
+    _Atomic int stop;
+    Feeder_t feeder[MAX_FEEDERS];
+} Feeders_t;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static void sleep_until(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0 && !interrupted) {
+    }
+}
+
+static void *feeder_main(void *arg) {
+    Feeder_t *f = (Feeder_t *)arg;
+    uint64_t *sent = (uint64_t *)calloc(f->count, sizeof(uint64_t));
+    uint32_t *offset = (uint32_t *)malloc(f->count * sizeof(uint32_t));
+    uint64_t *phase = (uint64_t *)malloc(f->count * sizeof(uint64_t));
+    if (sent == NULL || offset == NULL || phase == NULL) {
+        free(sent);
+        free(offset);
+        free(phase);
+        return NULL;
+    }
+    uint64_t sample_ns = (uint64_t)(1e9 / f->rate_hz);
+    for (uint32_t i = 0; i < f->count; i++) {
+        uint32_t d = f->first + i;
+        const PPGScore_Record_t *rec = &f->patients[d % f->patient_count];
+        offset[i] = (uint32_t)(((uint64_t)d * 7919u) % rec->count);
+        phase[i] = ((uint64_t)d * 2654435761u) % sample_ns;
+    }
+
+    uint64_t next = f->start_ns;
+    while (!atomic_load(f->stop)) {
+        next += f->period_ns;
+        sleep_until(next);
+        uint64_t now = PPGGateway_NowNs();
+        uint64_t elapsed = now - f->start_ns;
+        for (uint32_t i = 0; i < f->count; i++) {
+            uint32_t d = f->first + i;
+            const PPGScore_Record_t *rec = &f->patients[d % f->patient_count];
+            uint64_t due = (elapsed + phase[i]) / sample_ns;
+            if (f->ingest != NULL && sent[i] < due) {
+                // In place: reserve the batch, fill it, commit it; a full ring drops the rest
+                ShmRing_t *r = ShmRing_Get(f->ingest, d);
+                uint32_t pos;
+                uint32_t n = ShmRing_Reserve(r, (uint32_t)(due - sent[i]), &pos);
+                for (uint32_t j = 0; j < n; j++) {
+                    uint32_t k = (uint32_t)((offset[i] + sent[i] + j) % rec->count);
+                    ShmRing_Frame_t *fr = ShmRing_Frame(r, pos + j);
+                    fr->red = rec->red[k];
+                    fr->ir = rec->ir[k];
+                    fr->t_ns = now;
+                }
+                if (n > 0) {
+                    ShmRing_Commit(r, pos, n);
+                }
+                ShmRing_AddDropped(r, due - sent[i] - n);
+                f->pushed += due - sent[i];
+                sent[i] = due;
+            }
+            for (; sent[i] < due; sent[i]++) {
+                uint32_t k = (uint32_t)((offset[i] + sent[i]) % rec->count);
+                PPGGateway_Push(f->gw, d, rec->red[k], rec->ir[k], now);
+                f->pushed++;
+            }
+        }
+    }
+    free(sent);
+    free(offset);
+    free(phase);
+    return NULL;
+}
+
+static int parse_variants(const char *list, PPGGateway_Config_t *cfg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", list);
+    cfg->variant_count = 0;
+    for (char *save = NULL, *name = strtok_r(buf, ",", &save); name != NULL;
+         name = strtok_r(NULL, ",", &save)) {
+        const PPGVariant_t *v = PPGVariant_Find(name);
+        if (v == NULL || cfg->variant_count == PPG_GATEWAY_MAX_VARIANTS) {
+            return -1;
+        }
+        cfg->variants[cfg->variant_count++] = v;
+    }
+    return cfg->variant_count ? 0 : -1;
+}
+
+// Without the socket API nobody takes the result events: discard them
+static void drain_events(PPGGateway_t *gw) {
+    static PPGGateway_Event_t events[1024];
+    while (PPGGateway_PollEvents(gw, events, 1024) > 0) {
+    }
+}
+
+#define MS(ns)  ((double)(ns) / 1e6)
+#define US(ns)  ((double)(ns) / 1e3)
+
+int main(int argc, char **argv) {
+    uint32_t streams = 1000;
+    const char *variant_list = "m1,m2";
+    uint32_t workers = 0;
+    double tick_ms = 100.0;
+    double seconds = 30.0;
+    const char *socket_path = NULL;
+    int patient_count = 16;
+    double patient_s = 300.0;
+    uint64_t seed = 1;
+    float rate_hz = 100.0f;
+    int feeders = 1;
+    double feed_ms = 10.0;
+    double interval_s = 5.0;
+    int pin = 1;
+    int filter_batch = 0;
+    int processes = 0;
+    int state_arena = 0;
+    const char *checkpoint_path = NULL;
+    uint32_t checkpoint_ms = 1000;
+    float escalation_load = 0.0f;
+    int quiet = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            streams = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            variant_list = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            workers = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            tick_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            patient_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            patient_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate_hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            feeders = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            feed_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "-K") == 0 && i + 1 < argc) {
+            checkpoint_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-E") == 0 && i + 1 < argc) {
+            escalation_load = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-A") == 0) {
+            pin = 0;
+        } else if (strcmp(argv[i], "-B") == 0) {
+            filter_batch = 1;
+        } else if (strcmp(argv[i], "-M") == 0) {
+            processes = 1;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            state_arena = 1;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-n streams] [-v m1,m2] [-j workers] [-T tick_ms] [-t seconds] "
+                            "[-u socket] [-P patients] [-W seconds] [-s seed] [-r rate_hz] [-f feeders] "
+                            "[-F period_ms] [-i interval_s] [-C checkpoint] [-K checkpoint_ms] [-E load] [-A] [-B] "
+                            "[-M] [-S] [-q]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    PPGGateway_Config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    if (parse_variants(variant_list, &cfg) != 0) {
+        fprintf(stderr, "unknown variant in '%s'\n", variant_list);
+        return 2;
+    }
+    if (streams == 0 || tick_ms <= 0.0 || seconds < 0.0 || patient_count < 1 || patient_s <= 0.0 ||
+        rate_hz <= 0.0f || feeders < 1 || feeders > MAX_FEEDERS || feed_ms <= 0.0 || escalation_load < 0.0f) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+    if ((uint32_t)feeders > streams) {
+        feeders = (int)streams;
+    }
+    cfg.streams = streams;
+    cfg.workers = workers;
+    cfg.sample_rate_hz = rate_hz;
+    cfg.tick_us = (uint32_t)(tick_ms * 1000.0);
+    cfg.pin = (uint8_t)pin;
+    cfg.filter_batch = (uint8_t)filter_batch;
+    cfg.state_arena = (uint8_t)state_arena;
+    cfg.escalation_load = escalation_load;
+    cfg.checkpoint_path = checkpoint_path;
+    cfg.checkpoint_interval_ms = checkpoint_ms;
+    ShmRing_Seg_t ingest;
+    if (processes) {
+        if (ShmRing_Create(&ingest, streams, PPG_GATEWAY_RING_SAMPLES, 0) != 0) {
+            fprintf(stderr, "cannot create the shared-memory rings\n");
+            return 1;
+        }
+        cfg.ingest = &ingest;
+    }
+
+    // The devices' signals
+    PPGScore_Record_t *patients = (PPGScore_Record_t *)calloc((size_t)patient_count, sizeof(PPGScore_Record_t));
+    if (patients == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int p = 0; p < patient_count; p++) {
+        if (PPGScore_SynthesisePatient(&patients[p], seed + (uint64_t)p, patient_s) != 0) {
+            fprintf(stderr, "cannot synthesise the patients\n");
+            return 1;
+        }
+    }
+
+    PPGGateway_t *gw = PPGGateway_Create(&cfg);
+    if (gw == NULL || PPGGateway_Start(gw) != 0) {
+        fprintf(stderr, "cannot start the gateway\n");
+        return 1;
+    }
+    const PPGGateway_Config_t *run = PPGGateway_GetConfig(gw);
+    // Streams resumed from the checkpoint carry their earlier samples
+    PPGGateway_Stats_t resumed;
+    PPGGateway_GetStats(gw, &resumed);
+    GatewayApi_t *api = NULL;
+    if (socket_path != NULL && (api = GatewayApi_Start(gw, socket_path)) == NULL) {
+        fprintf(stderr, "%s: cannot serve the socket API\n", socket_path);
+        PPGGateway_Destroy(gw);
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    char names[32] = "";
+    for (uint32_t v = 0; v < run->variant_count; v++) {
+        strcat(names, v ? "+" : "");
+        strcat(names, run->variants[v]->name);
+    }
+    printf("Gateway: %u streams x %s at %.0f Hz, %u workers%s, tick %.0f ms%s%s%s\n", streams, names, rate_hz,
+           run->workers, pin ? " (pinned)" : "", tick_ms, socket_path ? ", socket " : "",
+           socket_path ? socket_path : "", processes ? ", feeder processes over shared memory" : "");
+    if (checkpoint_path != NULL) {
+        printf("  checkpoint %s: %u streams resumed (%llu samples), %u cold\n", checkpoint_path,
+               resumed.restored, (unsigned long long)resumed.samples, streams - resumed.restored);
+    }
+    fflush(stdout);
+
+    Feeders_t *shared = (Feeders_t *)mmap(NULL, sizeof(Feeders_t), PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    Feeder_t *feeder = shared->feeder;
+    uint64_t start_ns = PPGGateway_NowNs();
+    for (int k = 0; k < feeders; k++) {
+        Feeder_t *f = &feeder[k];
+        memset(f, 0, sizeof(Feeder_t));
+        f->gw = gw;
+        f->ingest = processes ? &ingest : NULL;
+        f->patients = patients;
+        f->patient_count = (uint32_t)patient_count;
+        f->first = (uint32_t)((uint64_t)streams * (uint32_t)k / (uint32_t)feeders);
+        f->count = (uint32_t)((uint64_t)streams * (uint32_t)(k + 1) / (uint32_t)feeders) - f->first;
+        f->rate_hz = rate_hz;
+        f->period_ns = (uint64_t)(feed_ms * 1e6);
+        f->start_ns = start_ns;
+        f->stop = &shared->stop;
+        if (processes) {
+            // f is shared: only the parent stores the pid, or the child's 0 may land after it
+            pid_t pid = fork();
+            if (pid == 0) {
+                // Stopped by the gateway (or its death), not by the terminal
+                signal(SIGINT, SIG_IGN);
+                signal(SIGTERM, SIG_DFL);
+                prctl(PR_SET_PDEATHSIG, SIGTERM);
+                feeder_main(f);
+                _exit(0);
+            }
+            if (pid < 0) {
+                fprintf(stderr, "cannot start the feeders\n");
+                return 1;
+            }
+            f->pid = pid;
+        } else if (pthread_create(&f->thread, NULL, feeder_main, f) != 0) {
+            fprintf(stderr, "cannot start the feeders\n");
+            return 1;
+        }
+    }
+
+    // Run, with a status line now and then
+    uint64_t end_ns = start_ns + (uint64_t)(seconds * 1e9);
+    uint64_t next_status = start_ns + (uint64_t)(interval_s * 1e9);
+    uint64_t half_ns = start_ns + (uint64_t)(seconds * 0.5e9);
+    PPGGateway_Stats_t half;
+    int have_half = 0;
+    while (!interrupted) {
+        uint64_t now = PPGGateway_NowNs();
+        if (seconds > 0.0 && now >= end_ns) {
+            break;
+        }
+        uint64_t wake = now + 100000000ull;
+        if (seconds > 0.0 && wake > end_ns) wake = end_ns;
+        sleep_until(wake);
+        if (api == NULL) {
+            drain_events(gw);
+        }
+        if (seconds > 0.0 && !have_half && PPGGateway_NowNs() >= half_ns) {
+            PPGGateway_GetStats(gw, &half);
+            have_half = 1;
+        }
+        if (!quiet && interval_s > 0.0 && PPGGateway_NowNs() >= next_status) {
+            PPGGateway_Stats_t s;
+            PPGGateway_GetStats(gw, &s);
+            printf("  %6.1f s: %llu samples, %.1f%% busy, p99 %.1f ms, worst stream p99 %.1f ms, "
+                   "%llu dropped\n", s.wall_s, (unsigned long long)s.samples, 100.0 * s.utilisation,
+                   MS(s.latency_p99_ns), MS(s.stream_p99_max_ns), (unsigned long long)s.dropped);
+            fflush(stdout);
+            next_status += (uint64_t)(interval_s * 1e9);
+        }
+    }
+
+    // Stop the devices, let the workers drain what is queued, then stop
+    atomic_store(&shared->stop, 1);
+    uint64_t pushed = 0;
+    for (int k = 0; k < feeders; k++) {
+        if (processes) {
+            waitpid(feeder[k].pid, NULL, 0);
+        } else {
+            pthread_join(feeder[k].thread, NULL);
+        }
+        pushed += feeder[k].pushed;
+    }
+    sleep_until(PPGGateway_NowNs() + 3ull * run->tick_us * 1000ull);
+    GatewayApi_Stats_t api_stats;
+    if (api != NULL) {
+        GatewayApi_GetStats(api, &api_stats);
+        GatewayApi_Stop(api);
+    }
+    PPGGateway_Stop(gw);
+    if (api == NULL) {
+        drain_events(gw);
+    }
+
+    PPGGateway_Stats_t s;
+    PPGGateway_GetStats(gw, &s);
+    // Steady state: Method 2 only starts transforming once its 10 s buffer is full
+    uint64_t processed = s.samples - resumed.samples;
+    double us_per_sample = processed ? s.busy_s * 1e6 / (double)processed : 0.0;
+    double llc_per_sample = processed ? (double)s.llc_misses / (double)processed : 0.0;
+    if (have_half && s.samples > half.samples) {
+        us_per_sample = (s.busy_s - half.busy_s) * 1e6 / (double)(s.samples - half.samples);
+        llc_per_sample = (double)(s.llc_misses - half.llc_misses) / (double)(s.samples - half.samples);
+    }
+    double per_worker = us_per_sample > 0.0 ? 1e6 / (us_per_sample * rate_hz) : 0.0;
+    printf("  samples: %llu pushed, %llu processed, %llu dropped; %llu events (%llu dropped)\n",
+           (unsigned long long)pushed, (unsigned long long)processed, (unsigned long long)s.dropped,
+           (unsigned long long)s.events, (unsigned long long)s.events_dropped);
+    printf("  workers: %.1f%% busy, %llu ticks, %llu overruns; %.2f us per sample (all variants%s)\n",
+           100.0 * s.utilisation, (unsigned long long)s.ticks, (unsigned long long)s.overruns, us_per_sample,
+           have_half ? ", second half" : "");
+    printf("  latency (arrival -> published): p50 %.1f ms, p99 %.1f ms, max %.1f ms; service p99 %.1f us\n",
+           MS(s.latency_p50_ns), MS(s.latency_p99_ns), MS(s.latency_max_ns), US(s.service_p99_ns));
+    printf("  per-stream p99: median %.1f ms, worst %.1f ms (stream %u)\n",
+           MS(s.stream_p99_median_ns), MS(s.stream_p99_max_ns), s.stream_p99_max_id);
+    if (s.llc_counted) {
+        printf("  cache: %s; %.2f LLC misses per sample%s\n",
+               state_arena ? "state arena" : "pooled states, prefetched", llc_per_sample,
+               have_half ? " (second half)" : "");
+    } else {
+        printf("  cache: %s; LLC misses not counted (no hardware counter)\n",
+               state_arena ? "state arena" : "pooled states, prefetched");
+    }
+    uint64_t engine_total = s.engine_samples[PPG_ADAPTIVE_METHOD1] + s.engine_samples[PPG_ADAPTIVE_DPT];
+    if (engine_total > 0) {
+        printf("  adaptive: %.1f%% of samples on Method 1, %.1f%% on DPT; %llu escalations, %llu back, "
+               "%llu held by load\n", 100.0 * s.engine_samples[PPG_ADAPTIVE_METHOD1] / engine_total,
+               100.0 * s.engine_samples[PPG_ADAPTIVE_DPT] / engine_total, (unsigned long long)s.escalations,
+               (unsigned long long)s.deescalations, (unsigned long long)s.escalations_held);
+    }
+    printf("  capacity: ~%.0f streams at %.0f Hz on %u workers (%.0f per worker)\n",
+           per_worker * run->workers, rate_hz, run->workers, per_worker);
+    if (checkpoint_path != NULL) {
+        printf("  checkpoint: %llu stream snapshots written, %llu failed\n",
+               (unsigned long long)s.checkpoints, (unsigned long long)s.checkpoint_errors);
+    }
+    if (api != NULL) {
+        printf("  socket: %llu connections, %llu commands, %llu events sent (%llu dropped)\n",
+               (unsigned long long)api_stats.connections, (unsigned long long)api_stats.commands,
+               (unsigned long long)api_stats.events_sent, (unsigned long long)api_stats.events_dropped);
+    }
+    int ok = (processed == pushed && s.dropped == 0 && s.events_dropped == 0 && processed > 0 &&
+              s.checkpoint_errors == 0);
+    printf(ok ? "Gateway passed\n" : "Gateway FAILED\n");
+
+    PPGGateway_Destroy(gw);
+    munmap(shared, sizeof(Feeders_t));
+    if (processes) {
+        ShmRing_Detach(&ingest);
+    }
+    for (int p = 0; p < patient_count; p++) {
+        PPGScore_FreeRecord(&patients[p]);
+    }
+    free(patients);
+    return ok ? 0 : 1;
+}
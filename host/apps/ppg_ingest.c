@@ -0,0 +1,500 @@
+/**
+ * @file ppg_ingest.c
+ * @brief Serial ingestion benchmark: -n emulated devices on ptys into the gateway
+ * @details Every device gets a pty: the ingestion layer (serial_ingest.h)
+ *          reads the terminal side as it would a serial port, and -d device
+ *          simulator processes write the other side with what the firmware
+ *          sends in raw-capture mode (serial_device.h): compressed capture
+ *          frames and the result lines of both methods every 250 samples.
+ *          The samples are the synthesiser's: -P patients of -W seconds from
+ *          seed -s, device d replaying patient d mod P from its own offset,
+ *          with the patient's reference heart rate and SpO2 as the reported
+ *          results. Each simulator wakes every -F ms and sends each of its
+ *          devices the samples due by then at -r Hz times -x (faster than
+ *          real time with -x > 1), from a 16 KB transmit buffer per device.
+ *
+ *          The decoded samples go through the gateway (ppg_gateway.h, the
+ *          variants of -v on -j workers, -T ms tick) reading the rings in
+ *          place, or with -G nowhere: a thread empties the rings, to measure
+ *          the ingestion alone. Runs -t seconds, then the devices send the
+ *          rest of their data and hang up; reports the ingestion's throughput
+ *          (bytes, samples, reads per second, its thread's busy time) and the
+ *          gateway's, and "Ingest passed" when every sample sent was decoded
+ *          (and processed) with nothing lost, corrupted or overflowing.
+ *
+ * Usage: ppg_ingest [-n devices] [-d simulators] [-x speed] [-t seconds] [-v m1,m2] [-j workers]
+ *                   [-T tick_ms] [-P patients] [-W seconds] [-s seed] [-r rate_hz] [-F period_ms]
+ *                   [-G] [-q]
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include "serial_ingest.h"
+#include "serial_device.h"
+#include "ppg_gateway.h"
+#include "ppg_score.h"
+
+#define MAX_SIMULATORS  64
+#define DEVICE_TX_BYTES (16 * 1024)
+#define REPORT_SAMPLES  250
+#define FINISH_S        10.0        // for the devices' last bytes and the pipelines to drain
+
+typedef struct {
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t stalls;                // writes that would have blocked
+    uint64_t overflow;              // bytes lost from full transmit buffers
+    _Atomic int finished;           // everything written
+} Simulator_t;
+
+// Shared with the simulator processes
+typedef struct {
+    _Atomic int go;
+    _Atomic int stop;
+    _Atomic int release;            // the host has read everything: hang up
+    uint64_t start_ns;
+    Simulator_t sim[MAX_SIMULATORS];
+} Shared_t;
+
+typedef struct {
+    const PPGScore_Record_t *patients;
+    uint32_t patient_count;
+    float rate_hz;
+    double speed;
+    uint64_t period_ns;
+} Bench_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+    }
+}
+
+// Write what the device has pending; 1 when it is all out
+static int device_write(Simulator_t *sim, SerialDevice_t *dev, int fd) {
+    while (dev->len > 0) {
+        ssize_t w = write(fd, dev->out, dev->len);
+        if (w < 0) {
+            sim->stalls += (errno == EAGAIN);
+            return 0;
+        }
+        sim->bytes += (uint64_t)w;
+        SerialDevice_Consume(dev, (size_t)w);
+    }
+    return 1;
+}
+
+// Sample k of a device's patient, and every REPORT_SAMPLES its results
+static void device_sample(SerialDevice_t *dev, const PPGScore_Record_t *rec, uint32_t k) {
+    SerialDevice_Push(dev, rec->red[k], rec->ir[k]);
+    if (dev->samples % REPORT_SAMPLES == 0) {
+        float hr = rec->ref_hr[k], spo2 = rec->ref_spo2 ? rec->ref_spo2[k] : 0.0f;
+        SerialDevice_Report(dev, 1, hr > 0.0f ? hr : 0.0f, hr > 0.0f, spo2, spo2 > 0.0f);
+        SerialDevice_Report(dev, 2, hr > 0.0f ? hr : 0.0f, hr > 0.0f, spo2, spo2 > 0.0f);
+    }
+}
+
+static int simulator_main(const Bench_t *b, Shared_t *sh, Simulator_t *sim, const int *master, uint32_t first,
+                          uint32_t count) {
+    SerialDevice_t *dev = (SerialDevice_t *)calloc(count, sizeof(SerialDevice_t));
+    uint8_t *tx = (uint8_t *)malloc((size_t)count * DEVICE_TX_BYTES);
+    uint32_t *offset = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint64_t *phase = (uint64_t *)malloc(count * sizeof(uint64_t));
+    if (dev == NULL || tx == NULL || offset == NULL || phase == NULL) {
+        return 1;
+    }
+    uint64_t sample_ns = (uint64_t)(1e9 / (b->rate_hz * b->speed));
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t d = first + i;
+        const PPGScore_Record_t *rec = &b->patients[d % b->patient_count];
+        SerialDevice_Init(&dev[i], &tx[(size_t)i * DEVICE_TX_BYTES], DEVICE_TX_BYTES);
+        offset[i] = (uint32_t)(((uint64_t)d * 7919u) % rec->count);
+        phase[i] = ((uint64_t)d * 2654435761u) % sample_ns;
+        fcntl(master[d], F_SETFL, fcntl(master[d], F_GETFL, 0) | O_NONBLOCK);
+    }
+    while (!atomic_load(&sh->go)) {
+        usleep(1000);
+    }
+
+    uint64_t next = sh->start_ns;
+    while (!atomic_load(&sh->stop)) {
+        next += b->period_ns;
+        sleep_until(next);
+        uint64_t elapsed = now_ns() - sh->start_ns;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t d = first + i;
+            const PPGScore_Record_t *rec = &b->patients[d % b->patient_count];
+            uint64_t due = (elapsed + phase[i]) / sample_ns;
+            for (; dev[i].samples < due;) {
+                device_sample(&dev[i], rec, (uint32_t)((offset[i] + dev[i].samples) % rec->count));
+            }
+            device_write(sim, &dev[i], master[first + i]);
+        }
+    }
+
+    // The rest of the samples, then wait until the host has read them before hanging up
+    int pending = 1;
+    uint64_t deadline = now_ns() + (uint64_t)(FINISH_S * 1e9);
+    for (uint32_t i = 0; i < count; i++) {
+        SerialDevice_Flush(&dev[i]);
+    }
+    while (pending && now_ns() < deadline) {
+        pending = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            pending |= !device_write(sim, &dev[i], master[first + i]);
+        }
+        if (pending) {
+            usleep(1000);
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        sim->samples += dev[i].samples;
+        sim->overflow += dev[i].overflow;
+    }
+    atomic_store(&sim->finished, 1);
+    while (!atomic_load(&sh->release)) {
+        usleep(1000);
+    }
+    return pending;
+}
+
+// -G: nobody processes the samples, only takes them off the rings
+typedef struct {
+    ShmRing_Seg_t *seg;
+    _Atomic int stop;
+    _Atomic uint64_t taken;
+} Drain_t;
+
+static void *drain_main(void *arg) {
+    Drain_t *dr = (Drain_t *)arg;
+    while (!atomic_load(&dr->stop)) {
+        for (uint32_t i = 0; i < dr->seg->rings; i++) {
+            ShmRing_t *r = ShmRing_Get(dr->seg, i);
+            uint32_t pos;
+            uint32_t n = ShmRing_Peek(r, &pos);
+            ShmRing_Release(r, pos + n);
+            atomic_fetch_add_explicit(&dr->taken, n, memory_order_relaxed);
+        }
+        usleep(1000);
+    }
+    return NULL;
+}
+
+static int parse_variants(const char *list, PPGGateway_Config_t *cfg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", list);
+    cfg->variant_count = 0;
+    for (char *save = NULL, *name = strtok_r(buf, ",", &save); name != NULL;
+         name = strtok_r(NULL, ",", &save)) {
+        const PPGVariant_t *v = PPGVariant_Find(name);
+        if (v == NULL || cfg->variant_count == PPG_GATEWAY_MAX_VARIANTS) {
+            return -1;
+        }
+        cfg->variants[cfg->variant_count++] = v;
+    }
+    return cfg->variant_count ? 0 : -1;
+}
+
+static void drain_events(PPGGateway_t *gw) {
+    static PPGGateway_Event_t events[1024];
+    while (PPGGateway_PollEvents(gw, events, 1024) > 0) {
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t devices = 1000;
+    int simulators = 1;
+    double speed = 1.0;
+    double seconds = 10.0;
+    const char *variant_list = "m1,m2";
+    uint32_t workers = 0;
+    double tick_ms = 100.0;
+    int patient_count = 16;
+    double patient_s = 300.0;
+    uint64_t seed = 1;
+    float rate_hz = 100.0f;
+    double period_ms = 10.0;
+    int no_gateway = 0;
+    int quiet = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            devices = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            simulators = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            variant_list = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            workers = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            tick_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            patient_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            patient_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate_hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            period_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-G") == 0) {
+            no_gateway = 1;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-n devices] [-d simulators] [-x speed] [-t seconds] [-v m1,m2] "
+                            "[-j workers] [-T tick_ms] [-P patients] [-W seconds] [-s seed] [-r rate_hz] "
+                            "[-F period_ms] [-G] [-q]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    PPGGateway_Config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    if (parse_variants(variant_list, &cfg) != 0) {
+        fprintf(stderr, "unknown variant in '%s'\n", variant_list);
+        return 2;
+    }
+    if (devices == 0 || simulators < 1 || simulators > MAX_SIMULATORS || speed <= 0.0 || seconds <= 0.0 ||
+        tick_ms <= 0.0 || patient_count < 1 || patient_s <= 0.0 || rate_hz <= 0.0f || period_ms <= 0.0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+    if ((uint32_t)simulators > devices) {
+        simulators = (int)devices;
+    }
+
+    // Two descriptors per device, and the rest
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    PPGScore_Record_t *patients = (PPGScore_Record_t *)calloc((size_t)patient_count, sizeof(PPGScore_Record_t));
+    int *master = (int *)malloc(devices * sizeof(int));
+    Shared_t *sh = (Shared_t *)mmap(NULL, sizeof(Shared_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                                    -1, 0);
+    if (patients == NULL || master == NULL || sh == MAP_FAILED) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int p = 0; p < patient_count; p++) {
+        if (PPGScore_SynthesisePatient(&patients[p], seed + (uint64_t)p, patient_s) != 0) {
+            fprintf(stderr, "cannot synthesise the patients\n");
+            return 1;
+        }
+    }
+
+    // The links
+    ShmRing_Seg_t seg;
+    if (ShmRing_Create(&seg, devices, PPG_GATEWAY_RING_SAMPLES, 0) != 0) {
+        fprintf(stderr, "cannot create the rings\n");
+        return 1;
+    }
+    SerialIngest_Config_t icfg = { devices, &seg };
+    SerialIngest_t *in = SerialIngest_Create(&icfg);
+    if (in == NULL) {
+        fprintf(stderr, "cannot create the ingestion\n");
+        return 1;
+    }
+    for (uint32_t d = 0; d < devices; d++) {
+        int slave = -1;
+        master[d] = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (master[d] < 0 || grantpt(master[d]) != 0 || unlockpt(master[d]) != 0 ||
+            (slave = open(ptsname(master[d]), O_RDWR | O_NOCTTY | O_CLOEXEC)) < 0 ||
+            SerialIngest_Add(in, slave) < 0) {
+            fprintf(stderr, "device %u: cannot open a pty (%s)\n", d, strerror(errno));
+            return 1;
+        }
+    }
+
+    // The simulators, forked before any thread starts
+    Bench_t bench = { patients, (uint32_t)patient_count, rate_hz, speed, (uint64_t)(period_ms * 1e6) };
+    pid_t pid[MAX_SIMULATORS];
+    for (int k = 0; k < simulators; k++) {
+        uint32_t first = (uint32_t)((uint64_t)devices * (uint32_t)k / (uint32_t)simulators);
+        uint32_t count = (uint32_t)((uint64_t)devices * (uint32_t)(k + 1) / (uint32_t)simulators) - first;
+        pid[k] = fork();
+        if (pid[k] == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            for (uint32_t d = 0; d < devices; d++) {
+                if (d < first || d >= first + count) {
+                    close(master[d]);       // hung up by their own simulator alone
+                }
+            }
+            _exit(simulator_main(&bench, sh, &sh->sim[k], master, first, count));
+        }
+        if (pid[k] < 0) {
+            fprintf(stderr, "cannot start the simulators\n");
+            return 1;
+        }
+    }
+    for (uint32_t d = 0; d < devices; d++) {
+        close(master[d]);
+    }
+
+    PPGGateway_t *gw = NULL;
+    Drain_t drain;
+    memset(&drain, 0, sizeof(drain));
+    drain.seg = &seg;
+    pthread_t drain_thread;
+    if (no_gateway) {
+        if (pthread_create(&drain_thread, NULL, drain_main, &drain) != 0) {
+            fprintf(stderr, "cannot start the drain thread\n");
+            return 1;
+        }
+    } else {
+        cfg.streams = devices;
+        cfg.workers = workers;
+        cfg.sample_rate_hz = rate_hz;
+        cfg.tick_us = (uint32_t)(tick_ms * 1000.0);
+        cfg.pin = 1;
+        cfg.ingest = &seg;
+        gw = PPGGateway_Create(&cfg);
+        if (gw == NULL || PPGGateway_Start(gw) != 0) {
+            fprintf(stderr, "cannot start the gateway\n");
+            return 1;
+        }
+    }
+    if (SerialIngest_Start(in) != 0) {
+        fprintf(stderr, "cannot start the ingestion\n");
+        return 1;
+    }
+    printf("Ingest: %u devices on ptys, %d simulator processes, %.0f Hz x %.1f, %s\n", devices, simulators,
+           rate_hz, speed, no_gateway ? "rings drained (no gateway)" : "into the gateway");
+    fflush(stdout);
+
+    uint64_t start_ns = now_ns();
+    sh->start_ns = start_ns;
+    atomic_store(&sh->go, 1);
+    for (double t = 1.0; t <= seconds; t += 1.0) {
+        sleep_until(start_ns + (uint64_t)(t * 1e9));
+        if (gw != NULL) {
+            drain_events(gw);
+        }
+        if (!quiet) {
+            SerialIngest_Stats_t s;
+            SerialIngest_GetStats(in, &s);
+            printf("  %4.0f s: %llu samples, %.1f MB, %u links paused\n", t, (unsigned long long)s.samples,
+                   s.bytes / 1e6, s.paused);
+            fflush(stdout);
+        }
+    }
+    sleep_until(start_ns + (uint64_t)(seconds * 1e9));
+    SerialIngest_Stats_t run;
+    SerialIngest_GetStats(in, &run);
+    double run_s = (now_ns() - start_ns) / 1e9;
+
+    // The devices send the rest; everything they sent is decoded, then processed
+    atomic_store(&sh->stop, 1);
+    uint64_t sent = 0, overflow = 0, stalls = 0, sent_bytes = 0;
+    for (int k = 0; k < simulators; k++) {
+        while (!atomic_load(&sh->sim[k].finished) && waitpid(pid[k], NULL, WNOHANG) == 0) {
+            if (gw != NULL) {
+                drain_events(gw);
+            }
+            usleep(1000);
+        }
+        sent += sh->sim[k].samples;
+        overflow += sh->sim[k].overflow;
+        stalls += sh->sim[k].stalls;
+        sent_bytes += sh->sim[k].bytes;
+    }
+    SerialIngest_Stats_t s;
+    uint64_t deadline = now_ns() + (uint64_t)(FINISH_S * 1e9);
+    for (;;) {
+        SerialIngest_GetStats(in, &s);
+        uint64_t processed = no_gateway ? drain.taken : 0;
+        if (gw != NULL) {
+            PPGGateway_Stats_t gs;
+            PPGGateway_GetStats(gw, &gs);
+            processed = gs.samples;
+            drain_events(gw);
+        }
+        if ((s.bytes == sent_bytes && processed == s.samples) || now_ns() > deadline) {
+            break;
+        }
+        usleep(1000);
+    }
+    atomic_store(&sh->release, 1);
+    int sims_ok = 1;
+    for (int k = 0; k < simulators; k++) {
+        int status;
+        sims_ok &= (waitpid(pid[k], &status, 0) == pid[k] && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    // Hung up: every link closes
+    for (deadline = now_ns() + 1000000000ull; now_ns() < deadline; usleep(1000)) {
+        SerialIngest_GetStats(in, &s);
+        if (s.open == 0) {
+            break;
+        }
+    }
+    SerialIngest_Stop(in);
+    SerialIngest_GetStats(in, &s);
+
+    uint64_t processed = 0;
+    if (gw != NULL) {
+        PPGGateway_Stop(gw);
+        drain_events(gw);
+        PPGGateway_Stats_t gs;
+        PPGGateway_GetStats(gw, &gs);
+        processed = gs.samples;
+        printf("  gateway: %llu samples processed on %u workers, %.1f%% busy, %llu dropped; latency "
+               "(read -> published) p50 %.1f ms, p99 %.1f ms\n", (unsigned long long)gs.samples,
+               PPGGateway_GetConfig(gw)->workers, 100.0 * gs.utilisation, (unsigned long long)gs.dropped,
+               gs.latency_p50_ns / 1e6, gs.latency_p99_ns / 1e6);
+        PPGGateway_Destroy(gw);
+    } else {
+        atomic_store(&drain.stop, 1);
+        pthread_join(drain_thread, NULL);
+        processed = drain.taken;
+    }
+
+    printf("  devices: %llu samples, %.1f MB sent, %llu stalled writes, %llu bytes overflowed\n",
+           (unsigned long long)sent, sent_bytes / 1e6, (unsigned long long)stalls, (unsigned long long)overflow);
+    printf("  ingest: %llu samples in %llu frames, %llu result lines (%llu reports); %llu lost, %llu CRC "
+           "errors, %llu pauses\n", (unsigned long long)s.samples, (unsigned long long)s.frames,
+           (unsigned long long)s.lines, (unsigned long long)s.reports, (unsigned long long)s.samples_lost,
+           (unsigned long long)s.crc_errors, (unsigned long long)s.pauses);
+    printf("  throughput over %.1f s: %.2f MB/s, %.0f samples/s, %.0f reads/s (%.0f bytes, %.1f per poll)\n",
+           run_s, run.bytes / run_s / 1e6, run.samples / run_s, run.reads / run_s,
+           run.reads ? (double)run.bytes / run.reads : 0.0, run.polls ? (double)run.reads / run.polls : 0.0);
+    printf("  ingest thread: %.1f%% busy, %.2f us per read, %.1f ns per byte\n", 100.0 * run.busy_s / run_s,
+           run.reads ? run.busy_s * 1e6 / run.reads : 0.0, run.bytes ? run.busy_s * 1e9 / run.bytes : 0.0);
+    int ok = (sims_ok && s.open == 0 && s.samples == sent && processed == sent && s.samples_lost == 0 &&
+              s.crc_errors == 0 && overflow == 0 && sent > 0);
+    printf(ok ? "Ingest passed\n" : "Ingest FAILED\n");
+
+    SerialIngest_Destroy(in);
+    ShmRing_Detach(&seg);
+    for (int p = 0; p < patient_count; p++) {
+        PPGScore_FreeRecord(&patients[p]);
+    }
+    free(patients);
+    free(master);
+    munmap(sh, sizeof(Shared_t));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+/**
+ * @file ppg_rec.c
+ * @brief Inspects, verifies, exports and creates .ppgrec recordings
+ * @details Commands:
+ *
+ *            info file.ppgrec            header, chunks, gaps, bytes per sample
+ *            verify file.ppgrec          CRC of every chunk (exit 1 on damage)
+ *            csv file.ppgrec [-s from] [-n count] [-o out.csv]
+ *                                        samples from stored position -s on,
+ *                                        with the recording index and the
+ *                                        reference channels it carries
+ *            convert in.csv out.ppgrec [-r rate_hz] [-P] [-c chunk_samples] [-D device_id]
+ *                                        CSV capture (ppg_capture_decode, or
+ *                                        annotated as ppg_synth -T) to a
+ *                                        recording; -P stores plain samples
+ *
+ * Usage: ppg_rec info|verify|csv|convert ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppg_rec.h"
+#include "ppg_score.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s info|verify file.ppgrec\n"
+                    "       %s csv file.ppgrec [-s from] [-n count] [-o out.csv]\n"
+                    "       %s convert in.csv out.ppgrec [-r rate_hz] [-P] [-c chunk_samples] [-D device_id]\n",
+            argv0, argv0, argv0);
+}
+
+static int cmd_info(const PPGRec_Reader_t *r, const char *path) {
+    const PPGRec_Header_t *h = r->header;
+    uint64_t gaps = 0, lost = 0, codec = 0;
+    for (uint32_t k = 1; k < r->chunk_count; k++) {
+        uint64_t expected = r->index[k - 1].first_sample + r->index[k - 1].count;
+        if (r->index[k].first_sample != expected) {
+            gaps++;
+            lost += r->index[k].first_sample - expected;
+        }
+    }
+    for (uint32_t k = 0; k < r->chunk_count; k++) {
+        const PPGRec_ChunkHeader_t *ch = (const PPGRec_ChunkHeader_t *)(r->map + r->index[k].offset);
+        codec += (ch->encoding == PPG_REC_ENC_CODEC);
+    }
+    printf("%s: %s\n", path, r->complete ? "complete" : "no index (recording cut short or in progress), scanned");
+    printf("Device:         %s\n", h->device_id[0] ? h->device_id : "-");
+    printf("Sample rate:    %.2f Hz\n", h->sample_rate_hz);
+    printf("Start time:     %llu us\n", (unsigned long long)h->start_time_us);
+    printf("Sensor:         FIFO 0x%02X, mode 0x%02X, SpO2 0x%02X, LED red 0x%02X IR 0x%02X, %u bit\n",
+           h->sensor.fifo_config, h->sensor.mode_config, h->sensor.spo2_config,
+           h->sensor.led_red_pa, h->sensor.led_ir_pa, h->sensor.adc_bits);
+    printf("Calibration:    SpO2 = %.3f R^2 %+.3f R %+.3f, gain red %.3f IR %.3f, clock %+.1f ppm\n",
+           h->calibration.spo2_a, h->calibration.spo2_b, h->calibration.spo2_c,
+           h->calibration.red_gain, h->calibration.ir_gain, h->calibration.clock_ppm);
+    printf("Reference:      %s%s%s%s\n", h->channels ? "" : "none",
+           (h->channels & PPG_REC_CH_REF_HR) ? "hr " : "", (h->channels & PPG_REC_CH_REF_SPO2) ? "spo2 " : "",
+           (h->channels & PPG_REC_CH_FLAGS) ? "flags" : "");
+    printf("Chunks:         %u of up to %u samples, %llu compressed, %llu plain\n", r->chunk_count,
+           h->chunk_samples, (unsigned long long)codec, (unsigned long long)(r->chunk_count - codec));
+    printf("Samples:        %llu (%.1f s), %llu gaps, %llu lost\n", (unsigned long long)r->total_samples,
+           r->total_samples / h->sample_rate_hz, (unsigned long long)gaps, (unsigned long long)lost);
+    if (r->total_samples > 0) {
+        printf("Size:           %zu bytes, %.2f bytes per sample pair\n", r->size,
+               (double)r->size / (double)r->total_samples);
+    }
+    return 0;
+}
+
+static int cmd_verify(const PPGRec_Reader_t *r, const char *path) {
+    uint32_t bad = 0;
+    uint32_t *red = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    uint32_t *ir = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    if (red == NULL || ir == NULL) {
+        free(red);
+        free(ir);
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t k = 0; k < r->chunk_count; k++) {
+        PPGRec_Chunk_t c;
+        if (PPGRec_VerifyChunk(r, k) != 0 || PPGRec_GetChunk(r, k, &c, red, ir) != 0) {
+            printf("chunk %u (samples %llu..): damaged\n", k, (unsigned long long)r->index[k].first_sample);
+            bad++;
+        }
+    }
+    free(red);
+    free(ir);
+    printf("%s: %u chunks, %u damaged%s\n", path, r->chunk_count, bad, r->complete ? "" : ", no index");
+    return bad ? 1 : 0;
+}
+
+static int cmd_csv(const PPGRec_Reader_t *r, uint64_t from, uint64_t count, const char *out_path) {
+    FILE *out = (out_path != NULL) ? fopen(out_path, "w") : stdout;
+    if (out == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    uint8_t channels = r->header->channels;
+    fprintf(out, "index,red,ir%s%s%s\n", (channels & PPG_REC_CH_REF_HR) ? ",hr" : "",
+            (channels & PPG_REC_CH_REF_SPO2) ? ",spo2" : "", (channels & PPG_REC_CH_FLAGS) ? ",flags" : "");
+    uint32_t *red = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    uint32_t *ir = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    int64_t k = PPGRec_FindChunk(r, from);
+    int status = 0;
+    uint64_t done = 0;
+    while (red != NULL && ir != NULL && k >= 0 && (uint32_t)k < r->chunk_count && done < count) {
+        PPGRec_Chunk_t c;
+        if (PPGRec_GetChunk(r, (uint32_t)k, &c, red, ir) != 0) {
+            fprintf(stderr, "chunk %lld damaged\n", (long long)k);
+            status = 1;
+            break;
+        }
+        for (uint32_t i = (uint32_t)(from + done - r->index[k].position); i < c.count && done < count; i++) {
+            fprintf(out, "%llu,%u,%u", (unsigned long long)(c.first_sample + i), c.red[i], c.ir[i]);
+            if (c.ref_hr != NULL) fprintf(out, ",%.2f", c.ref_hr[i]);
+            if (c.ref_spo2 != NULL) fprintf(out, ",%.1f", c.ref_spo2[i]);
+            if (c.flags != NULL) fprintf(out, ",%u", c.flags[i]);
+            fprintf(out, "\n");
+            done++;
+        }
+        k++;
+    }
+    free(red);
+    free(ir);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return status;
+}
+
+static int cmd_convert(const char *in_path, const char *out_path, float rate_hz, int plain,
+                       uint32_t chunk_samples, const char *device_id) {
+    PPGScore_Record_t rec;
+    if (PPGScore_LoadCsv(&rec, in_path, rate_hz) != 0) {
+        fprintf(stderr, "%s: cannot read a CSV capture\n", in_path);
+        return 1;
+    }
+    // Reference channels only when the CSV has them
+    int has_hr = 0, has_spo2 = 0;
+    for (uint32_t i = 0; i < rec.count && !(has_hr && has_spo2); i++) {
+        has_hr |= (rec.ref_hr[i] > 0.0f);
+        has_spo2 |= (rec.ref_spo2[i] > 0.0f);
+    }
+    PPGRec_Header_t header;
+    PPGRec_DefaultHeader(&header, rate_hz);
+    header.encoding = plain ? PPG_REC_ENC_PLAIN : PPG_REC_ENC_CODEC;
+    if (chunk_samples > 0) {
+        header.chunk_samples = chunk_samples;
+    }
+    snprintf(header.device_id, sizeof(header.device_id), "%s", device_id);
+    if (rec.beat_count > 0) header.channels |= PPG_REC_CH_FLAGS;
+    if (has_spo2) header.channels |= PPG_REC_CH_REF_SPO2;
+    // Beats give the reference HR; a CSV hr column without beats is kept as a channel
+    if (has_hr && rec.beat_count == 0) header.channels |= PPG_REC_CH_REF_HR;
+
+    static PPGRec_Writer_t w;
+    if (PPGRec_Create(&w, out_path, &header) != 0) {
+        perror(out_path);
+        PPGScore_FreeRecord(&rec);
+        return 1;
+    }
+    uint32_t beat = 0;
+    int status = 0;
+    for (uint32_t i = 0; i < rec.count && status == 0; i++) {
+        PPGRec_Reference_t ref = { rec.ref_hr[i], rec.ref_spo2[i], 0 };
+        if (beat < rec.beat_count && rec.beats[beat] == i) {
+            ref.flags = PPG_SYNTH_FLAG_BEAT;
+            beat++;
+        }
+        status = PPGRec_Append(&w, rec.red[i], rec.ir[i], &ref);
+    }
+    uint32_t fallbacks = w.codec_fallbacks;
+    if (PPGRec_Finish(&w) != 0 || status != 0) {
+        perror(out_path);
+        PPGScore_FreeRecord(&rec);
+        return 1;
+    }
+    printf("%s: %u samples%s\n", out_path, rec.count, fallbacks ? " (some chunks plain: samples wider than 18 bit)" : "");
+    PPGScore_FreeRecord(&rec);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[1];
+    if (strcmp(cmd, "convert") == 0) {
+        if (argc < 4) {
+            usage(argv[0]);
+            return 2;
+        }
+        float rate_hz = 100.0f;
+        int plain = 0;
+        uint32_t chunk_samples = 0;
+        const char *device_id = "";
+        for (int i = 4; i < argc; i++) {
+            if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                rate_hz = (float)atof(argv[++i]);
+            } else if (strcmp(argv[i], "-P") == 0) {
+                plain = 1;
+            } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+                chunk_samples = (uint32_t)atoi(argv[++i]);
+            } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+                device_id = argv[++i];
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+        return cmd_convert(argv[2], argv[3], rate_hz, plain, chunk_samples, device_id);
+    }
+
+    uint64_t from = 0, count = UINT64_MAX;
+    const char *out_path = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            from = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    PPGRec_Reader_t r;
+    if (PPGRec_Open(&r, argv[2]) != 0) {
+        fprintf(stderr, "%s: not a readable recording\n", argv[2]);
+        return 1;
+    }
+    int status;
+    if (strcmp(cmd, "info") == 0) {
+        status = cmd_info(&r, argv[2]);
+    } else if (strcmp(cmd, "verify") == 0) {
+        status = cmd_verify(&r, argv[2]);
+    } else if (strcmp(cmd, "csv") == 0) {
+        status = cmd_csv(&r, from, count, out_path);
+    } else {
+        usage(argv[0]);
+        status = 2;
+    }
+    PPGRec_Close(&r);
+    return status;
+}
@@ -0,0 +1,346 @@
+/**
+ * @file ppg_score.c
+ * @brief Scores algorithm variants against annotated recordings
+ * @details Runs every selected variant (-v m1,m2; default all) over each
+ *          record and reports per record and pooled over all records, for
+ *          heart rate and SpO2: MAE, bias, limits of agreement, coverage,
+ *          time to first valid output and lag (see ppg_score.h).
+ *
+ *          Records are annotated CSV files (ppg_synth -T, or a capture with
+ *          reference columns added) at -r Hz, .ppgrec recordings with
+ *          reference channels (ppg_rec.h), and/or -g random synthetic
+ *          patients of -t seconds from seed -s whose heart rate ramps by
+ *          15-25 bpm in the middle third of the record.
+ *
+ *          -j / -c write the results as JSON / CSV (one row per record and
+ *          variant, record "ALL" for the pooled values). With -B they are
+ *          checked against a budget file, one gate per line:
+ *
+ *            variant quantity metric max|min value    e.g.  m2 hr mae max 4
+ *
+ *          quantity is hr or spo2; metric is mae, bias, sd, loa_low,
+ *          loa_high, coverage, first_valid or lag. A metric that cannot be
+ *          computed (never valid, no lag) fails its gate. The exit status is
+ *          1 when any gate fails.
+ *
+ * Usage: ppg_score [-v variants] [-g patients] [-t seconds] [-s seed] [-r rate_hz]
+ *                  [-j out.json] [-c out.csv] [-B budget.txt] [-q] [record ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ppg_score.h"
+
+#define MAX_VARIANTS    8
+#define MAX_RECORDS     1024
+
+typedef struct {
+    const PPGVariant_t *variant;
+    PPGScore_Result_t total;
+} VariantTotal_t;
+
+static const char *const quantity_names[2] = { "hr", "spo2" };
+
+static double summary_value(const PPGScore_Summary_t *s, const char *metric, int *known) {
+    *known = 1;
+    if (strcmp(metric, "mae") == 0) return s->mae;
+    if (strcmp(metric, "bias") == 0) return s->bias;
+    if (strcmp(metric, "sd") == 0) return s->sd;
+    if (strcmp(metric, "loa_low") == 0) return s->loa_low;
+    if (strcmp(metric, "loa_high") == 0) return s->loa_high;
+    if (strcmp(metric, "coverage") == 0) return s->coverage_pct;
+    if (strcmp(metric, "first_valid") == 0) return s->first_valid_s;
+    if (strcmp(metric, "lag") == 0) return s->lag_s;
+    *known = 0;
+    return 0.0;
+}
+
+// A metric that has no value: no valid point, never valid, lag not measured
+static int summary_missing(const PPGScore_Metric_t *m, const PPGScore_Summary_t *s, const char *metric) {
+    if (strcmp(metric, "first_valid") == 0) return s->first_valid_s < 0.0;
+    if (strcmp(metric, "lag") == 0) return s->lag_s < 0.0;
+    if (strcmp(metric, "coverage") == 0) return m->updates == 0;
+    return m->n == 0;
+}
+
+static void print_time(double t) {
+    if (t < 0.0) {
+        printf(" %6s", "--");
+    } else {
+        printf(" %6.1f", t);
+    }
+}
+
+static void print_row(const char *record, const char *variant, const PPGScore_Result_t *r) {
+    PPGScore_Summary_t hr, spo2;
+    PPGScore_Summarise(&r->hr, &hr);
+    PPGScore_Summarise(&r->spo2, &spo2);
+    printf("%-16s %-4s %6.2f %+6.2f %+7.2f %+7.2f %6.1f", record, variant,
+           hr.mae, hr.bias, hr.loa_low, hr.loa_high, hr.coverage_pct);
+    print_time(hr.first_valid_s);
+    print_time(hr.lag_s);
+    printf("   %6.2f %+6.2f %6.1f", spo2.mae, spo2.bias, spo2.coverage_pct);
+    print_time(spo2.first_valid_s);
+    printf("\n");
+}
+
+static void csv_row(FILE *f, const char *record, const char *variant, const PPGScore_Result_t *r) {
+    const PPGScore_Metric_t *metrics[2] = { &r->hr, &r->spo2 };
+    fprintf(f, "%s,%s", record, variant);
+    for (int q = 0; q < 2; q++) {
+        PPGScore_Summary_t s;
+        PPGScore_Summarise(metrics[q], &s);
+        fprintf(f, ",%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f", metrics[q]->updates, metrics[q]->n,
+                s.mae, s.bias, s.sd, s.loa_low, s.loa_high, s.coverage_pct, s.first_valid_s, s.lag_s);
+    }
+    fprintf(f, "\n");
+}
+
+static void json_result(FILE *f, const char *record, const char *variant, const PPGScore_Result_t *r, int first) {
+    const PPGScore_Metric_t *metrics[2] = { &r->hr, &r->spo2 };
+    fprintf(f, "%s    {\"record\": \"%s\", \"variant\": \"%s\"", first ? "" : ",\n", record, variant);
+    for (int q = 0; q < 2; q++) {
+        PPGScore_Summary_t s;
+        PPGScore_Summarise(metrics[q], &s);
+        fprintf(f, ", \"%s\": {\"updates\": %u, \"n\": %u, \"mae\": %.3f, \"bias\": %.3f, \"sd\": %.3f, "
+                   "\"loa\": [%.3f, %.3f], \"coverage_pct\": %.2f, ",
+                quantity_names[q], metrics[q]->updates, metrics[q]->n, s.mae, s.bias, s.sd,
+                s.loa_low, s.loa_high, s.coverage_pct);
+        if (s.first_valid_s < 0.0) fprintf(f, "\"first_valid_s\": null, ");
+        else fprintf(f, "\"first_valid_s\": %.2f, ", s.first_valid_s);
+        if (s.lag_s < 0.0) fprintf(f, "\"lag_s\": null}");
+        else fprintf(f, "\"lag_s\": %.2f}", s.lag_s);
+    }
+    fprintf(f, "}");
+}
+
+/**
+ * @return number of failed gates, -1 if the file cannot be read or is invalid
+ */
+static int check_budget(const char *path, const VariantTotal_t *totals, int variant_count) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    char line[160];
+    int failed = 0, entries = 0;
+    printf("Accuracy budget (%s):\n", path);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char variant[16], quantity[8], metric[16], op[4];
+        double limit;
+        if (line[0] == '#' || sscanf(line, "%15s %7s %15s %3s %lf", variant, quantity, metric, op, &limit) != 5) {
+            continue;
+        }
+        const VariantTotal_t *t = NULL;
+        for (int v = 0; v < variant_count; v++) {
+            if (strcmp(totals[v].variant->name, variant) == 0) {
+                t = &totals[v];
+            }
+        }
+        int q = (strcmp(quantity, "hr") == 0) ? 0 : (strcmp(quantity, "spo2") == 0) ? 1 : -1;
+        int is_max = (strcmp(op, "max") == 0);
+        int known;
+        PPGScore_Summary_t s;
+        memset(&s, 0, sizeof(s));
+        summary_value(&s, metric, &known);
+        if (q < 0 || !known || (!is_max && strcmp(op, "min") != 0)) {
+            fprintf(stderr, "%s: invalid entry: %s", path, line);
+            fclose(f);
+            return -1;
+        }
+        if (t == NULL) {
+            if (PPGVariant_Find(variant) == NULL) {
+                fprintf(stderr, "%s: unknown variant: %s", path, line);
+                fclose(f);
+                return -1;
+            }
+            continue;       // not run this time
+        }
+        const PPGScore_Metric_t *m = (q == 0) ? &t->total.hr : &t->total.spo2;
+        PPGScore_Summarise(m, &s);
+        double actual = summary_value(&s, metric, &known);
+        int missing = summary_missing(m, &s, metric);
+        int fail = missing || (is_max ? actual > limit : actual < limit);
+        failed += fail;
+        entries++;
+        printf("  %-4s %-4s %-11s %s %8.2f:", variant, quantity, metric, op, limit);
+        if (missing) {
+            printf(" %8s FAIL\n", "none");
+        } else {
+            printf(" %8.2f %s\n", actual, fail ? "FAIL" : "ok");
+        }
+    }
+    fclose(f);
+    return (entries > 0) ? failed : -1;
+}
+
+int main(int argc, char **argv) {
+    const char *variant_list = NULL;
+    int patients = 0;
+    double seconds = 300.0;
+    uint64_t seed = 1;
+    float rate_hz = 100.0f;
+    const char *json_path = NULL;
+    const char *csv_path = NULL;
+    const char *budget_path = NULL;
+    int quiet = 0;
+    static const char *files[MAX_RECORDS];
+    int file_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            variant_list = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            patients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate_hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            budget_path = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (argv[i][0] != '-' && file_count < MAX_RECORDS) {
+            files[file_count++] = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-v variants] [-g patients] [-t seconds] [-s seed] [-r rate_hz] "
+                            "[-j out.json] [-c out.csv] [-B budget.txt] [-q] [record ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (patients < 0 || file_count + patients == 0 || file_count + patients > MAX_RECORDS ||
+        seconds <= 0.0 || rate_hz <= 0.0f) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    static VariantTotal_t totals[MAX_VARIANTS];
+    int variant_count = 0;
+    if (variant_list == NULL) {
+        for (uint32_t v = 0; v < PPGVariant_Count() && variant_count < MAX_VARIANTS; v++) {
+            totals[variant_count++].variant = PPGVariant_Get(v);
+        }
+    } else {
+        char list[128];
+        snprintf(list, sizeof(list), "%s", variant_list);
+        for (char *tok = strtok(list, ","); tok != NULL && variant_count < MAX_VARIANTS; tok = strtok(NULL, ",")) {
+            const PPGVariant_t *v = PPGVariant_Find(tok);
+            if (v == NULL) {
+                fprintf(stderr, "unknown variant '%s'\n", tok);
+                return 2;
+            }
+            totals[variant_count++].variant = v;
+        }
+    }
+
+    FILE *json = NULL, *csv = NULL;
+    if (json_path != NULL && (json = fopen(json_path, "w")) == NULL) {
+        perror(json_path);
+        return 1;
+    }
+    if (csv_path != NULL && (csv = fopen(csv_path, "w")) == NULL) {
+        perror(csv_path);
+        return 1;
+    }
+    if (json != NULL) {
+        fprintf(json, "{\n  \"records\": [\n");
+    }
+    if (csv != NULL) {
+        fprintf(csv, "record,variant");
+        for (int q = 0; q < 2; q++) {
+            fprintf(csv, ",%s_updates,%s_n,%s_mae,%s_bias,%s_sd,%s_loa_low,%s_loa_high,%s_coverage_pct,"
+                         "%s_first_valid_s,%s_lag_s", quantity_names[q], quantity_names[q], quantity_names[q],
+                    quantity_names[q], quantity_names[q], quantity_names[q], quantity_names[q],
+                    quantity_names[q], quantity_names[q], quantity_names[q]);
+        }
+        fprintf(csv, "\n");
+    }
+
+    if (!quiet) {
+        printf("%-16s %-4s %6s %6s %15s %6s %6s %6s   %6s %6s %6s %6s\n", "record", "var",
+               "HR MAE", "bias", "LoA", "cov %", "first", "lag", "SpO2 MAE", "bias", "cov %", "first");
+    }
+    double total_seconds = 0.0;
+    int records = file_count + patients;
+    for (int r = 0; r < records; r++) {
+        PPGScore_Record_t rec;
+        if (r < file_count) {
+            if (PPGScore_LoadFile(&rec, files[r], rate_hz) != 0) {
+                fprintf(stderr, "%s: cannot read an annotated recording\n", files[r]);
+                return 1;
+            }
+        } else {
+            if (PPGScore_SynthesisePatient(&rec, seed + (uint64_t)(r - file_count), seconds) != 0) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        total_seconds += rec.count / rec.sample_rate_hz;
+
+        for (int v = 0; v < variant_count; v++) {
+            PPGScore_Result_t result;
+            if (PPGScore_Run(totals[v].variant, &rec, &result) != 0) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+            PPGScore_Add(&totals[v].total.hr, &result.hr);
+            PPGScore_Add(&totals[v].total.spo2, &result.spo2);
+            if (!quiet) {
+                print_row(rec.name, totals[v].variant->name, &result);
+            }
+            if (csv != NULL) {
+                csv_row(csv, rec.name, totals[v].variant->name, &result);
+            }
+            if (json != NULL) {
+                json_result(json, rec.name, totals[v].variant->name, &result, r == 0 && v == 0);
+            }
+        }
+        PPGScore_FreeRecord(&rec);
+    }
+
+    printf("\n=== %d records, %.1f h ===\n", records, total_seconds / 3600.0);
+    printf("%-16s %-4s %6s %6s %15s %6s %6s %6s   %6s %6s %6s %6s\n", "", "var",
+           "HR MAE", "bias", "LoA", "cov %", "first", "lag", "SpO2 MAE", "bias", "cov %", "first");
+    if (json != NULL) {
+        fprintf(json, "\n  ],\n  \"aggregate\": [\n");
+    }
+    for (int v = 0; v < variant_count; v++) {
+        print_row("ALL", totals[v].variant->name, &totals[v].total);
+        if (csv != NULL) {
+            csv_row(csv, "ALL", totals[v].variant->name, &totals[v].total);
+        }
+        if (json != NULL) {
+            json_result(json, "ALL", totals[v].variant->name, &totals[v].total, v == 0);
+        }
+    }
+
+    int failed = 0;
+    if (budget_path != NULL) {
+        printf("\n");
+        failed = check_budget(budget_path, totals, variant_count);
+        if (failed < 0) {
+            return 2;
+        }
+        printf("%s\n", failed ? "Accuracy budget FAILED" : "Accuracy budget met");
+    }
+    if (json != NULL) {
+        fprintf(json, "\n  ],\n  \"budget\": ");
+        if (budget_path == NULL) fprintf(json, "null\n}\n");
+        else fprintf(json, "{\"file\": \"%s\", \"failed\": %d, \"passed\": %s}\n}\n",
+                     budget_path, failed, failed ? "false" : "true");
+        fclose(json);
+    }
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+/**
+ * @file ppg_sweep.c
+ * @brief Searches the tuning constants of an algorithm variant for the accuracy / latency Pareto front
+ * @details Built with PPG_TUNABLE_PARAMS (ppg_params.h). The swept
+ *          parameters are -p name[=min:max] (repeatable; default: every
+ *          constant the variant reads, over its default range; -l lists
+ *          them). -G steps searches a grid of that many values per
+ *          parameter, otherwise -n random candidates are drawn from seed -R.
+ *          Candidate 0 is always the compiled-in defaults.
+ *
+ *          Records are annotated CSV files at -r Hz, .ppgrec recordings
+ *          and/or -g synthetic patients of -t seconds from seed -s (the
+ *          ppg_score -g corpus), all loaded once. Every candidate runs on
+ *          every record on -j threads (default: one per CPU).
+ *
+ *          Objectives: heart-rate MAE and latency, -L lag (default) or
+ *          first_valid; candidates below -C percent heart-rate coverage are
+ *          left out (see param_sweep.h). Prints the Pareto front, best
+ *          accuracy first, with the parameter values and whether the
+ *          defaults are on it; -D prints the front's most accurate point as
+ *          #defines for the firmware. -o writes every candidate as CSV.
+ *
+ * Usage: ppg_sweep [-v variant] [-p name[=min:max]] [-G steps | -n candidates] [-R seed]
+ *                  [-L lag|first_valid] [-C min_coverage_pct] [-j threads] [-g patients]
+ *                  [-t seconds] [-s seed] [-r rate_hz] [-o out.csv] [-D] [-q] [-l] [record ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "param_sweep.h"
+#include "work_pool.h"
+
+#define MAX_FILES           1024
+#define MAX_CANDIDATES      1000000
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-v variant] [-p name[=min:max]] [-G steps | -n candidates] [-R seed]\n"
+                    "       [-L lag|first_valid] [-C min_coverage_pct] [-j threads] [-g patients]\n"
+                    "       [-t seconds] [-s seed] [-r rate_hz] [-o out.csv] [-D] [-q] [-l] [record ...]\n",
+            argv0);
+}
+
+static void list_params(void) {
+    printf("%-24s %-4s %-24s %8s %8s %8s\n", "name", "var", "firmware macro", "default", "min", "max");
+    PPG_Params_t defaults;
+    ParamSweep_Defaults(&defaults);
+    for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+        const ParamSweep_Param_t *p = ParamSweep_GetParam(i);
+        printf("%-24s %-4s %-24s %8g %8g %8g\n", p->name, p->variant, p->macro,
+               ParamSweep_GetValue(&defaults, p), p->min, p->max);
+    }
+}
+
+// name or name=min:max
+static int parse_range(const char *arg, ParamSweep_Range_t *range) {
+    char name[64];
+    const char *eq = strchr(arg, '=');
+    size_t len = eq ? (size_t)(eq - arg) : strlen(arg);
+    if (len >= sizeof(name)) {
+        return -1;
+    }
+    memcpy(name, arg, len);
+    name[len] = '\0';
+    range->param = ParamSweep_FindParam(name);
+    if (range->param == NULL) {
+        return -1;
+    }
+    range->min = range->param->min;
+    range->max = range->param->max;
+    if (eq != NULL && sscanf(eq + 1, "%f:%f", &range->min, &range->max) != 2) {
+        return -1;
+    }
+    return (range->min <= range->max) ? 0 : -1;
+}
+
+static int column_width(const ParamSweep_Param_t *p) {
+    int len = (int)strlen(p->name);
+    return (len > 10) ? len : 10;
+}
+
+static void print_header(const char *latency_name, const ParamSweep_Range_t *ranges, uint32_t range_count) {
+    printf("%6s %8s %9s %7s", "cand", "HR MAE", latency_name, "cov %");
+    for (uint32_t i = 0; i < range_count; i++) {
+        printf(" %*s", column_width(ranges[i].param), ranges[i].param->name);
+    }
+    printf("\n");
+}
+
+static void print_candidate(uint32_t index, const ParamSweep_Candidate_t *c, const ParamSweep_Range_t *ranges,
+                            uint32_t range_count) {
+    printf("%6u %8.2f %9.1f %7.1f", index, c->accuracy, c->latency, c->coverage_pct);
+    for (uint32_t i = 0; i < range_count; i++) {
+        printf(" %*g", column_width(ranges[i].param), ParamSweep_GetValue(&c->params, ranges[i].param));
+    }
+    printf("%s\n", index == 0 ? "   (defaults)" : "");
+}
+
+int main(int argc, char **argv) {
+    const char *variant_name = "m2";
+    ParamSweep_Range_t ranges[PARAM_SWEEP_MAX_PARAMS];
+    uint32_t range_count = 0;
+    uint32_t grid_steps = 0;
+    uint32_t random_count = 64;
+    uint64_t search_seed = 1;
+    uint8_t latency = PARAM_SWEEP_LATENCY_LAG;
+    double min_coverage_pct = 0.0;
+    uint32_t threads = 0;
+    int patients = -1;
+    double seconds = 300.0;
+    uint64_t seed = 1;
+    float rate_hz = 100.0f;
+    const char *out_path = NULL;
+    int print_defines = 0;
+    int quiet = 0;
+    static const char *files[MAX_FILES];
+    uint32_t file_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            variant_name = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            if (range_count >= PARAM_SWEEP_MAX_PARAMS || parse_range(argv[++i], &ranges[range_count]) != 0) {
+                fprintf(stderr, "bad parameter '%s' (-l lists them)\n", argv[i]);
+                return 2;
+            }
+            range_count++;
+        } else if (strcmp(argv[i], "-G") == 0 && i + 1 < argc) {
+            grid_steps = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            random_count = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            search_seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "lag") == 0) {
+                latency = PARAM_SWEEP_LATENCY_LAG;
+            } else if (strcmp(argv[i], "first_valid") == 0) {
+                latency = PARAM_SWEEP_LATENCY_FIRST_VALID;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            min_coverage_pct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            patients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate_hz = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-D") == 0) {
+            print_defines = 1;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "-l") == 0) {
+            list_params();
+            return 0;
+        } else if (argv[i][0] != '-' && file_count < MAX_FILES) {
+            files[file_count++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    const PPGVariant_t *variant = PPGVariant_Find(variant_name);
+    if (variant == NULL) {
+        fprintf(stderr, "unknown variant '%s'\n", variant_name);
+        return 2;
+    }
+    if (patients < 0) {
+        patients = (file_count > 0) ? 0 : 8;
+    }
+    if (file_count + (uint32_t)patients == 0 || seconds <= 0.0 || rate_hz <= 0.0f ||
+        threads > WORK_POOL_MAX_WORKERS || (grid_steps == 0 && random_count == 0)) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+    // Default: every constant the variant reads
+    if (range_count == 0) {
+        for (uint32_t i = 0; i < ParamSweep_ParamCount() && range_count < PARAM_SWEEP_MAX_PARAMS; i++) {
+            const ParamSweep_Param_t *p = ParamSweep_GetParam(i);
+            if (strcmp(p->variant, variant->name) == 0) {
+                ranges[range_count++] = (ParamSweep_Range_t){ p, p->min, p->max };
+            }
+        }
+    }
+    for (uint32_t i = 0; i < range_count; i++) {
+        if (strcmp(ranges[i].param->variant, variant->name) != 0) {
+            fprintf(stderr, "warning: %s is not read by %s\n", ranges[i].param->name, variant->name);
+        }
+    }
+
+    uint64_t count64 = (grid_steps > 0) ? ParamSweep_Grid(ranges, range_count, grid_steps, NULL) : random_count;
+    if (count64 > MAX_CANDIDATES) {
+        fprintf(stderr, "%llu candidates, more than %u\n", (unsigned long long)count64, MAX_CANDIDATES);
+        return 2;
+    }
+    uint32_t count = (uint32_t)count64;
+    uint32_t records = file_count + (uint32_t)patients;
+    ParamSweep_Candidate_t *candidates = (ParamSweep_Candidate_t *)malloc(count * sizeof(ParamSweep_Candidate_t));
+    PPGScore_Record_t *recs = (PPGScore_Record_t *)calloc(records, sizeof(PPGScore_Record_t));
+    if (candidates == NULL || recs == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    if (grid_steps > 0) {
+        ParamSweep_Grid(ranges, range_count, grid_steps, candidates);
+    } else {
+        ParamSweep_Random(ranges, range_count, search_seed, candidates, count);
+    }
+
+    for (uint32_t r = 0; r < records; r++) {
+        int status = (r < file_count) ? PPGScore_LoadFile(&recs[r], files[r], rate_hz)
+                                      : PPGScore_SynthesisePatient(&recs[r], seed + (r - file_count), seconds);
+        if (status != 0) {
+            fprintf(stderr, "%s: cannot read an annotated recording\n", (r < file_count) ? files[r] : "synthesis");
+            return 1;
+        }
+    }
+
+    ParamSweep_Config_t cfg;
+    cfg.variant = variant;
+    cfg.threads = threads ? threads : WorkPool_DefaultWorkers();
+    cfg.latency = latency;
+    cfg.min_coverage_pct = min_coverage_pct;
+    ParamSweep_Stats_t stats;
+    if (ParamSweep_Evaluate(&cfg, recs, records, candidates, count, &stats) != 0) {
+        fprintf(stderr, "cannot start the worker threads\n");
+        return 1;
+    }
+    uint32_t front = ParamSweep_Pareto(candidates, count);
+    uint32_t feasible = 0;
+    for (uint32_t c = 0; c < count; c++) {
+        feasible += candidates[c].feasible;
+    }
+
+    const char *latency_name = (latency == PARAM_SWEEP_LATENCY_LAG) ? "lag s" : "first s";
+    printf("%s, %u parameters, %s: %u candidates x %u records, %u feasible (HR coverage >= %.0f %%)\n",
+           variant->name, range_count, grid_steps ? "grid" : "random", count, records, feasible, min_coverage_pct);
+    if (!quiet) {
+        printf("\n=== All candidates ===\n");
+        print_header(latency_name, ranges, range_count);
+        for (uint32_t c = 0; c < count; c++) {
+            print_candidate(c, &candidates[c], ranges, range_count);
+        }
+    }
+
+    // Front by accuracy (most accurate first); the latency falls along it
+    printf("\n=== Pareto front: %u of %u candidates (HR MAE vs %s) ===\n", front, count,
+           (latency == PARAM_SWEEP_LATENCY_LAG) ? "lag" : "time to first valid");
+    print_header(latency_name, ranges, range_count);
+    uint32_t *order = (uint32_t *)malloc((front ? front : 1) * sizeof(uint32_t));
+    uint32_t n = 0;
+    for (uint32_t c = 0; c < count && order != NULL; c++) {
+        if (!candidates[c].pareto) {
+            continue;
+        }
+        uint32_t j = n++;
+        while (j > 0 && candidates[order[j - 1]].accuracy > candidates[c].accuracy) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = c;
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        print_candidate(order[k], &candidates[order[k]], ranges, range_count);
+    }
+    const ParamSweep_Candidate_t *def = &candidates[0];
+    if (!def->feasible) {
+        printf("Defaults: infeasible\n");
+    } else if (def->pareto) {
+        printf("Defaults: on the front\n");
+    } else {
+        uint32_t better = 0;
+        for (uint32_t c = 1; c < count; c++) {
+            better += (candidates[c].feasible && candidates[c].accuracy <= def->accuracy &&
+                       candidates[c].latency <= def->latency);
+        }
+        printf("Defaults: HR MAE %.2f, %s %.1f, dominated by %u candidates\n", def->accuracy, latency_name,
+               def->latency, better);
+    }
+    if (print_defines && n > 0) {
+        const ParamSweep_Candidate_t *best = &candidates[order[0]];
+        printf("\n// Most accurate point of the front (candidate %u)\n", order[0]);
+        for (uint32_t i = 0; i < range_count; i++) {
+            const ParamSweep_Param_t *p = ranges[i].param;
+            if (p->integer) {
+                printf("#define %-24s %.0f\n", p->macro, ParamSweep_GetValue(&best->params, p));
+            } else {
+                printf("#define %-24s %.4gf\n", p->macro, ParamSweep_GetValue(&best->params, p));
+            }
+        }
+    }
+    free(order);
+
+    if (out_path != NULL) {
+        FILE *out = fopen(out_path, "w");
+        if (out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+        fprintf(out, "candidate,variant,feasible,pareto,hr_mae,hr_latency_s,hr_coverage_pct,hr_bias,spo2_mae");
+        for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+            fprintf(out, ",%s", ParamSweep_GetParam(i)->name);
+        }
+        fprintf(out, "\n");
+        for (uint32_t c = 0; c < count; c++) {
+            PPGScore_Summary_t hr, spo2;
+            PPGScore_Summarise(&candidates[c].total.hr, &hr);
+            PPGScore_Summarise(&candidates[c].total.spo2, &spo2);
+            fprintf(out, "%u,%s,%u,%u,%.3f,%.2f,%.2f,%.3f,%.3f", c, variant->name, candidates[c].feasible,
+                    candidates[c].pareto, candidates[c].accuracy, candidates[c].latency,
+                    candidates[c].coverage_pct, hr.bias, spo2.mae);
+            for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+                fprintf(out, ",%g", ParamSweep_GetValue(&candidates[c].params, ParamSweep_GetParam(i)));
+            }
+            fprintf(out, "\n");
+        }
+        fclose(out);
+    }
+
+    printf("\n%llu runs, %.1f h of signal on %u threads in %.2f s (%llu stolen)\n",
+           (unsigned long long)stats.runs, stats.signal_s / 3600.0, stats.threads, stats.wall_s,
+           (unsigned long long)stats.steals);
+    for (uint32_t r = 0; r < records; r++) {
+        PPGScore_FreeRecord(&recs[r]);
+    }
+    free(recs);
+    free(candidates);
+    return (front > 0) ? 0 : 1;
+}
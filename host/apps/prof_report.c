@@ -0,0 +1,110 @@
+/**
+ * @file prof_report.c
+ * @brief Host viewer for the on-target cycle profiler (-DENABLE_PROFILER=ON)
+ * @details Reads the UART byte stream, decodes TLM_TYPE_PROFILE frames and
+ *          prints one table per report: calls, mean/min/max cycles, mean time
+ *          in microseconds, share of the report interval and the coarse
+ *          cycle histogram. With -c the same data is written as CSV.
+ *
+ * Usage: prof_report [-c] [capture.bin]
+ *        (reads stdin when no input file is given)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+#include "profiler.h"
+
+static const char *const bin_labels[PROF_HIST_BINS] = {
+    "<256", "<1K", "<4K", "<16K", "<64K", "<256K", "<1M", ">=1M"
+};
+
+static void print_table(const PROF_Report_t *r, uint32_t index) {
+    double us_per_cycle = r->cpu_hz ? 1e6 / (double)r->cpu_hz : 0.0;
+    double interval_cycles = (double)r->interval_ms * r->cpu_hz / 1000.0;
+
+    printf("report %u: %u ms @ %.1f MHz\n", index, r->interval_ms, r->cpu_hz / 1e6);
+    printf("  %-13s %8s %10s %10s %10s %10s %6s  histogram", "stage", "calls",
+           "mean cyc", "min", "max", "mean us", "load");
+    printf("\n");
+    for (uint8_t i = 0; i < r->stage_count; i++) {
+        const PROF_StageStats_t *s = &r->stages[i];
+        double mean = s->count ? (double)s->total / s->count : 0.0;
+        printf("  %-13s %8u %10.0f %10u %10u %10.1f %5.1f%% ",
+               PROF_StageName(r->stage_id[i]), s->count, mean, s->min, s->max,
+               mean * us_per_cycle, interval_cycles > 0 ? 100.0 * s->total / interval_cycles : 0.0);
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+            if (s->hist[b]) {
+                printf(" %s:%u", bin_labels[b], s->hist[b]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+static void print_csv(const PROF_Report_t *r, uint32_t index) {
+    for (uint8_t i = 0; i < r->stage_count; i++) {
+        const PROF_StageStats_t *s = &r->stages[i];
+        printf("%u,%s,%u,%u,%u,%u,%u", index, PROF_StageName(r->stage_id[i]),
+               r->interval_ms, s->count, s->total, s->min, s->max);
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+            printf(",%u", s->hist[b]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *in_path = NULL;
+    int csv = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            csv = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "usage: %s [-c] [capture.bin]\n", argv[0]);
+            return 2;
+        } else {
+            in_path = argv[i];
+        }
+    }
+
+    FILE *in = (in_path != NULL) ? fopen(in_path, "rb") : stdin;
+    if (in == NULL) {
+        perror(in_path);
+        return 1;
+    }
+
+    if (csv) {
+        printf("report,stage,interval_ms,calls,total,min,max");
+        for (uint8_t b = 0; b < PROF_HIST_BINS; b++) {
+            printf(",hist_%s", bin_labels[b]);
+        }
+        printf("\n");
+    }
+
+    static TLM_Parser_t parser;
+    TLM_Parser_Init(&parser);
+    uint32_t reports = 0;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            PROF_Report_t report;
+            if (!TLM_Parser_Feed(&parser, buf[i]) || parser.type != TLM_TYPE_PROFILE ||
+                PROF_DecodeReport(parser.payload, parser.len, &report) != 0) {
+                continue;
+            }
+            if (csv) {
+                print_csv(&report, reports);
+            } else {
+                print_table(&report, reports);
+            }
+            reports++;
+        }
+    }
+    if (in != stdin) fclose(in);
+
+    fprintf(stderr, "%u report frames, %u crc errors\n", reports, parser.crc_errors);
+    return 0;
+}
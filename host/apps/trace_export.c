@@ -0,0 +1,189 @@
+/**
+ * @file trace_export.c
+ * @brief Convert firmware event-trace dumps to Chrome/Perfetto trace JSON
+ * @details Reads the UART byte stream (TLM_TYPE_TRACE frames written by
+ *          Trace_Dump, possibly mixed with printf text and other frame types)
+ *          and writes the Trace Event Format understood by chrome://tracing
+ *          and ui.perfetto.dev. Each dump becomes one process in the timeline,
+ *          named after its trigger (request / stall / hardfault / stack); the sensor
+ *          interrupt gets its own track. CYCCNT timestamps are unwrapped and
+ *          converted to microseconds relative to the oldest record of the dump.
+ *
+ * Usage: trace_export [-o out.json] [input]
+ *        (reads stdin when no input file is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+#include "trace.h"
+
+#define MAX_DUMP_RECORDS    4096
+#define TID_MAIN            1
+#define TID_IRQ             2
+
+typedef struct {
+    FILE *out;
+    uint32_t dumps;
+    uint32_t events;
+    uint32_t unmatched;
+    int first_event;
+} ExportContext_t;
+
+static Trace_Record_t dump_records[MAX_DUMP_RECORDS];
+
+static const char *reason_name(uint8_t reason) {
+    switch (reason) {
+        case TRACE_REASON_REQUEST:   return "request";
+        case TRACE_REASON_STALL:     return "stall";
+        case TRACE_REASON_HARDFAULT: return "hardfault";
+        case TRACE_REASON_STACK:     return "stack";
+        default:                     return "unknown";
+    }
+}
+
+static void emit(ExportContext_t *ctx, const char *fmt_line) {
+    fprintf(ctx->out, "%s\n    %s", ctx->first_event ? "" : ",", fmt_line);
+    ctx->first_event = 0;
+}
+
+static void write_dump(ExportContext_t *ctx, const Trace_DumpFrame_t *hdr, uint16_t count) {
+    char line[256];
+    uint32_t pid = ctx->dumps + 1;
+
+    snprintf(line, sizeof(line),
+             "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %u, "
+             "\"args\": {\"name\": \"dump %u (%s): %u of %u events\"}}",
+             pid, hdr->dump_id, reason_name(hdr->reason), count, hdr->written);
+    emit(ctx, line);
+    snprintf(line, sizeof(line),
+             "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, \"tid\": %d, \"args\": {\"name\": \"main loop\"}}",
+             pid, TID_MAIN);
+    emit(ctx, line);
+    snprintf(line, sizeof(line),
+             "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, \"tid\": %d, \"args\": {\"name\": \"irq\"}}",
+             pid, TID_IRQ);
+    emit(ctx, line);
+
+    // Unwrap the 32-bit cycle counter; consecutive events are far less than one wrap apart
+    double cycles_per_us = (hdr->cpu_hz ? hdr->cpu_hz : 72000000u) / 1e6;
+    uint64_t t64 = 0;
+    uint32_t open_spans[TRACE_EV_COUNT] = { 0 };
+    for (uint16_t i = 0; i < count; i++) {
+        const Trace_Record_t *r = &dump_records[i];
+        if (i > 0) {
+            t64 += (uint32_t)(r->timestamp - dump_records[i - 1].timestamp);
+        }
+        char phase = Trace_EventPhase(r->id);
+        const char *name = Trace_EventName(r->id);
+
+        // A span whose begin was overwritten by the ring cannot be drawn
+        if (phase == 'B') {
+            open_spans[r->id]++;
+        } else if (phase == 'E') {
+            uint8_t begin_id = (uint8_t)(r->id - 1);
+            if (open_spans[begin_id] == 0) {
+                ctx->unmatched++;
+                continue;
+            }
+            open_spans[begin_id]--;
+        }
+
+        int tid = (r->id == TRACE_EV_SENSOR_IRQ) ? TID_IRQ : TID_MAIN;
+        snprintf(line, sizeof(line),
+                 "{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %u, \"tid\": %d,%s "
+                 "\"args\": {\"arg\": %u}}",
+                 name, phase, (double)t64 / cycles_per_us, pid, tid,
+                 (phase == 'i') ? " \"s\": \"t\"," : "", r->arg);
+        emit(ctx, line);
+        ctx->events++;
+    }
+    ctx->dumps++;
+}
+
+static void read_stream(FILE *in, ExportContext_t *ctx) {
+    static TLM_Parser_t parser;
+    Trace_DumpFrame_t frame;
+    Trace_DumpFrame_t hdr = { 0 };
+    uint16_t have = 0;
+    int active = 0;
+    uint8_t buf[4096];
+    size_t n;
+
+    TLM_Parser_Init(&parser);
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!TLM_Parser_Feed(&parser, buf[i]) || parser.type != TLM_TYPE_TRACE ||
+                Trace_DecodeFrame(parser.payload, parser.len, &frame) != 0) {
+                continue;
+            }
+            // Frames of one dump arrive in order; a gap or a new dump id restarts assembly
+            if (frame.first == 0) {
+                hdr = frame;
+                have = 0;
+                active = 1;
+            } else if (!active || frame.dump_id != hdr.dump_id || frame.first != have) {
+                active = 0;
+                fprintf(stderr, "incomplete dump %u skipped\n", frame.dump_id);
+                continue;
+            }
+            if (have + frame.count > MAX_DUMP_RECORDS) {
+                active = 0;
+                continue;
+            }
+            memcpy(&dump_records[have], frame.records, frame.count * sizeof(Trace_Record_t));
+            have = (uint16_t)(have + frame.count);
+            if (have == frame.total) {
+                write_dump(ctx, &hdr, have);
+                active = 0;
+            }
+        }
+    }
+    fprintf(stderr, "frames: %u ok, %u crc errors, %u bytes skipped\n",
+            parser.frames_ok, parser.crc_errors, parser.bytes_skipped);
+}
+
+int main(int argc, char **argv) {
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "usage: %s [-o out.json] [input]\n", argv[0]);
+            return 2;
+        } else {
+            in_path = argv[i];
+        }
+    }
+
+    FILE *in = (in_path != NULL) ? fopen(in_path, "rb") : stdin;
+    if (in == NULL) {
+        perror(in_path);
+        return 1;
+    }
+
+    ExportContext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.first_event = 1;
+    ctx.out = stdout;
+    if (out_path != NULL) {
+        ctx.out = fopen(out_path, "w");
+        if (ctx.out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    fprintf(ctx.out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    read_stream(in, &ctx);
+    fprintf(ctx.out, "\n]}\n");
+    if (in != stdin) fclose(in);
+    if (ctx.out != stdout) fclose(ctx.out);
+
+    fprintf(stderr, "dumps: %u, events: %u, unmatched span ends: %u\n",
+            ctx.dumps, ctx.events, ctx.unmatched);
+    return 0;
+}
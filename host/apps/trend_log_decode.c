@@ -0,0 +1,169 @@
+/**
+ * @file trend_log_decode.c
+ * @brief Host decoder for the flash trend log (USE_TREND_LOG firmware mode)
+ * @details Reads either the UART byte stream produced by TrendLog_Dump
+ *          (TLM_TYPE_TREND_LOG frames, possibly mixed with printf text) or a
+ *          raw image of the TRENDLOG flash region (-r, e.g. read back with a
+ *          debugger), and writes "session,time,hr,spo2,sqi,flags" CSV in
+ *          chronological order.
+ *
+ * Usage: trend_log_decode [-r] [-p page_size] [-o out.csv] [input]
+ *        (reads stdin when no input file is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+#include "trend_log.h"
+
+#define MAX_PAGE_SIZE   4096
+#define MAX_PAGES       256
+
+typedef struct {
+    uint32_t seq;
+    uint16_t len;
+    uint8_t *data;
+} Page_t;
+
+typedef struct {
+    FILE *out;
+    uint32_t records;
+    uint32_t pages;
+    uint32_t torn;
+    uint32_t corrupt;
+} DecodeContext_t;
+
+static Page_t pages[MAX_PAGES];
+static uint32_t page_count = 0;
+
+static void print_record(const TrendLog_Record_t *rec, void *ctx) {
+    DecodeContext_t *dc = (DecodeContext_t *)ctx;
+    fprintf(dc->out, "%u,%u,%u,%u,%u,%u\n", rec->session, rec->time,
+            rec->hr, rec->spo2, rec->sqi, rec->flags);
+    dc->records++;
+}
+
+static void add_page(const uint8_t *data, uint16_t len) {
+    TrendLog_PageInfo_t info;
+    if (page_count >= MAX_PAGES || TrendLog_DecodePage(data, len, &info, NULL, NULL) != 0) {
+        return;     // erased or damaged page
+    }
+    pages[page_count].seq = info.seq;
+    pages[page_count].len = len;
+    pages[page_count].data = (uint8_t *)malloc(len);
+    if (pages[page_count].data == NULL) {
+        return;
+    }
+    memcpy(pages[page_count].data, data, len);
+    page_count++;
+}
+
+static int compare_seq(const void *a, const void *b) {
+    const Page_t *pa = (const Page_t *)a;
+    const Page_t *pb = (const Page_t *)b;
+    return (pa->seq > pb->seq) - (pa->seq < pb->seq);
+}
+
+static void read_stream(FILE *in) {
+    static TLM_Parser_t parser;
+    static uint8_t page[MAX_PAGE_SIZE];
+    uint8_t buf[4096];
+    size_t n;
+
+    TLM_Parser_Init(&parser);
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!TLM_Parser_Feed(&parser, buf[i]) || parser.type != TLM_TYPE_TREND_LOG ||
+                parser.len < TREND_LOG_DUMP_HEADER) {
+                continue;
+            }
+            const uint8_t *p = parser.payload;
+            uint16_t offset = (uint16_t)(p[4] | (p[5] << 8));
+            uint16_t total = (uint16_t)(p[6] | (p[7] << 8));
+            uint16_t len = (uint16_t)(parser.len - TREND_LOG_DUMP_HEADER);
+            if (total > MAX_PAGE_SIZE || offset + len > total) {
+                continue;
+            }
+            memcpy(&page[offset], &p[TREND_LOG_DUMP_HEADER], len);
+            if (offset + len == total) {
+                add_page(page, total);
+            }
+        }
+    }
+    fprintf(stderr, "frames: %u ok, %u crc errors, %u bytes skipped\n",
+            parser.frames_ok, parser.crc_errors, parser.bytes_skipped);
+}
+
+static void read_image(FILE *in, uint16_t page_size) {
+    static uint8_t page[MAX_PAGE_SIZE];
+    while (fread(page, 1, page_size, in) == page_size) {
+        add_page(page, page_size);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+    int raw_image = 0;
+    long page_size = 1024;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            page_size = strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            raw_image = 1;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "usage: %s [-r] [-p page_size] [-o out.csv] [input]\n", argv[0]);
+            return 2;
+        } else {
+            in_path = argv[i];
+        }
+    }
+    if (page_size <= TREND_LOG_HEADER_SIZE || page_size > MAX_PAGE_SIZE) {
+        fprintf(stderr, "invalid page size %ld\n", page_size);
+        return 2;
+    }
+
+    FILE *in = (in_path != NULL) ? fopen(in_path, "rb") : stdin;
+    if (in == NULL) {
+        perror(in_path);
+        return 1;
+    }
+    if (raw_image) {
+        read_image(in, (uint16_t)page_size);
+    } else {
+        read_stream(in);
+    }
+    if (in != stdin) fclose(in);
+
+    DecodeContext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.out = stdout;
+    if (out_path != NULL) {
+        ctx.out = fopen(out_path, "w");
+        if (ctx.out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    // Oldest page first; a raw image is stored in ring order, not in time order
+    qsort(pages, page_count, sizeof(Page_t), compare_seq);
+    fprintf(ctx.out, "session,time,hr,spo2,sqi,flags\n");
+    for (uint32_t i = 0; i < page_count; i++) {
+        TrendLog_PageInfo_t info;
+        TrendLog_DecodePage(pages[i].data, pages[i].len, &info, print_record, &ctx);
+        ctx.pages++;
+        ctx.torn += info.torn;
+        ctx.corrupt += info.corrupt;
+        free(pages[i].data);
+    }
+    if (ctx.out != stdout) fclose(ctx.out);
+
+    fprintf(stderr, "pages: %u, records: %u (%.2f hours), torn: %u, corrupt: %u\n",
+            ctx.pages, ctx.records, ctx.records / 3600.0, ctx.torn, ctx.corrupt);
+    return 0;
+}
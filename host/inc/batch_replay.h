@@ -0,0 +1,78 @@
+/**
+ * @file batch_replay.h
+ * @brief Parallel replay of many recordings through an algorithm variant
+ * @details Records are split into chunks of chunk_samples and every chunk is
+ *          a task on a work-stealing pool (work_pool.h). Two ways of
+ *          splitting a record:
+ *
+ *          - hand-off (warmup_samples 0): the chunks of a record run in order
+ *            and the variant state (ppg_variant.h: one flat block) is handed
+ *            from each chunk to the next. The next chunk is spawned on the
+ *            worker that finished the previous one and can be stolen by an
+ *            idle worker, so long records move between threads while results
+ *            stay identical to PPGScore_Run (lag excepted, see below).
+ *            Parallelism is across records.
+ *          - warm-up (warmup_samples > 0): every chunk starts from a fresh
+ *            state warmup_samples before its first sample and is scored from
+ *            its first sample on. The chunks of a record run in parallel, so
+ *            a single long record uses every core; results are approximate
+ *            where the warm-up is shorter than the algorithm's memory.
+ *            Chunk and warm-up lengths are rounded up to whole display
+ *            updates (PPG_VARIANT_UPDATE_SAMPLES) so updates fall on the same
+ *            samples as in a full run.
+ *
+ *            With filter_batch, and a variant with process_filtered (Method
+ *            1), a task takes BATCH_REPLAY_FILTER_GROUP chunks of the record
+ *            and runs them in lockstep, their red/IR filters together in a
+ *            FilterBatch (filter_batch.h, SIMD across chunks); the first and
+ *            last chunks, shorter, are masked off as they run out. Results
+ *            are identical to the unbatched warm-up. Hand-off ignores it.
+ *
+ *          Records are loaded by the caller's load function, from worker
+ *          threads (it must be thread-safe), only as workers become free:
+ *          about one record per worker is in memory at a time, whatever the
+ *          size of the archive. Each record's chunk results are merged with
+ *          PPGScore_Merge; the lag needs the whole output series and is not
+ *          measured.
+ */
+#ifndef BATCH_REPLAY_H
+#define BATCH_REPLAY_H
+
+#include <stdint.h>
+#include "ppg_score.h"
+
+#define BATCH_REPLAY_DEFAULT_CHUNK_SAMPLES  30000   // 5 min at 100 Hz
+#define BATCH_REPLAY_FILTER_GROUP           8       // chunks per filtered warm-up task: 16 channels
+
+// Fill rec with record `index` (e.g. PPGScore_LoadCsv), 0 on success; freed by the engine
+typedef int (*BatchReplay_Load_t)(void *ctx, uint32_t index, PPGScore_Record_t *rec);
+
+typedef struct {
+    const PPGVariant_t *variant;
+    uint32_t threads;               // 0: one per online CPU
+    uint32_t chunk_samples;         // 0: BATCH_REPLAY_DEFAULT_CHUNK_SAMPLES
+    uint32_t warmup_samples;        // 0: exact state hand-off between chunks
+    uint8_t filter_batch;           // warm-up: batched red/IR filters where the variant allows it
+} BatchReplay_Config_t;
+
+typedef struct {
+    PPGScore_Result_t result;
+    char name[64];
+    uint32_t samples;
+    int status;                     // 0, -1: not loaded or out of memory
+} BatchReplay_RecordResult_t;
+
+typedef struct {
+    uint64_t samples;               // record samples scored
+    uint64_t processed;             // samples run through the variant, warm-up included
+    double signal_s;                // recorded time
+    double wall_s;
+    uint64_t tasks;
+    uint64_t steals;
+    uint32_t threads;
+} BatchReplay_Stats_t;
+
+int BatchReplay_Run(const BatchReplay_Config_t *config, BatchReplay_Load_t load, void *ctx,
+                    uint32_t records, BatchReplay_RecordResult_t *results, BatchReplay_Stats_t *stats);
+
+#endif // BATCH_REPLAY_H
@@ -0,0 +1,70 @@
+/**
+ * @file dpt_batch.h
+ * @brief Sliding DPT of many streams at once, structure-of-arrays, SIMD
+ * @details The same transform as dpt_transform_process() in
+ *          ppg_algorithm_v2.c - per sample, every period of
+ *          DPT_MIN_PERIOD..DPT_MAX_PERIOD is updated with
+ *              T = e^(-j 2 pi / period) * (T - x_old + x_new)
+ *          - but for one channel of N streams together. Each array is laid
+ *          out period (or buffer position) major with one column per stream:
+ *          real[period][lane], so one vector load picks up the same period
+ *          of 8 (AVX2), 16 (AVX-512) or 4 (NEON) streams, and the rotation
+ *          of one period is a handful of vector instructions for all of
+ *          them. The basis is shared by every lane.
+ *
+ *          The streams run in lockstep: DPTBatch_Process takes one new AC
+ *          value per stream and all lanes share the circular buffer
+ *          position. A stream can join later (DPTBatch_LoadLane rotates its
+ *          buffer into place) and keeps its own fill count; lanes whose
+ *          buffer is not full yet are left untouched, as in the scalar code.
+ *
+ *          Same operations in the same order as the scalar code, with no
+ *          fused multiply-add (the file is built with -ffp-contract=off), so
+ *          the spectra and peak periods are bit-identical to
+ *          dpt_transform_process(), compute_magnitude_spectrum() and
+ *          find_peak_period() as long as those are not contracted either.
+ *
+ *          The kernel is one of simd_isa.h: portable C, AVX2 or AVX-512F on
+ *          x86, NEON on AArch64.
+ */
+#ifndef DPT_BATCH_H
+#define DPT_BATCH_H
+
+#include <stdint.h>
+#include "ppg_algorithm_v2.h"
+#include "simd_isa.h"
+
+#define DPT_BATCH_LANE_ALIGN    16          // lanes are allocated in multiples of one AVX-512 vector
+
+typedef struct {
+    uint32_t streams;
+    uint32_t lanes;                 // streams rounded up to DPT_BATCH_LANE_ALIGN (padding lanes see 0)
+    uint32_t isa;                   // SIMD_ISA_*
+    uint16_t buffer_index;          // shared write position
+    uint32_t full_lanes;            // lanes whose buffer is full
+    float *real;                    // [DPT_PERIOD_RANGE][lanes]
+    float *imag;
+    float *magnitude;
+    int32_t *buffer;                // [DPT_BUFFER_SIZE][lanes]
+    int32_t *full;                  // per lane: -1 once the buffer is full (a blend mask), else 0
+    uint16_t *sample_count;         // per lane, as DPT_Transform_t.sample_count
+    float cos_basis[DPT_PERIOD_RANGE];
+    float sin_basis[DPT_PERIOD_RANGE];
+} DPTBatch_t;
+
+// All lanes empty, as after dpt_transform_init(). 0, -1: out of memory or kernel not supported
+int DPTBatch_Init(DPTBatch_t *b, uint32_t streams, uint32_t isa);
+void DPTBatch_Free(DPTBatch_t *b);
+
+// Copy one stream in from / out to the scalar layout
+void DPTBatch_LoadLane(DPTBatch_t *b, uint32_t stream, const DPT_Transform_t *t);
+void DPTBatch_StoreLane(const DPTBatch_t *b, uint32_t stream, DPT_Transform_t *t);
+
+// One sample per stream: ac[streams]
+void DPTBatch_Process(DPTBatch_t *b, const int32_t *ac);
+// magnitude = |T| / period for every lane
+void DPTBatch_Spectrum(DPTBatch_t *b);
+// Per stream: the period of the largest magnitude, 0 below min_magnitude
+void DPTBatch_PeakPeriods(const DPTBatch_t *b, float min_magnitude, uint16_t *periods);
+
+#endif // DPT_BATCH_H
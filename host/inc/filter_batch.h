@@ -0,0 +1,97 @@
+/**
+ * @file filter_batch.h
+ * @brief PPG_Filter_Process for many channels at once, structure-of-arrays, SIMD
+ * @details Each lane is one channel (one stream's red or IR) with its own
+ *          filter state: the detrend moving average, the two Butterworth
+ *          sections (shared coefficients, ppg_filter.c) with their clamp and
+ *          the 5-point smoothing. Every state array is laid out
+ *          [row][lane], so one vector op advances the same step of 8
+ *          (AVX2), 16 (AVX-512) or 4 (NEON) channels.
+ *
+ *          The ring positions (detrend, smoothing) are kept per lane and
+ *          the rings are gathered from / scattered to, so a lane's state is
+ *          exactly its PPG_FilterState_t and lanes need not advance
+ *          together: FilterBatch_Process takes an optional active mask,
+ *          and inactive lanes are left as they are. That lets a caller feed
+ *          streams whose samples arrive unevenly (the gateway) or end at
+ *          different times (batch replay chunks).
+ *
+ *          Same operations in the same order as PPG_Filter_Process, with
+ *          no fused multiply-add (the file is built with -ffp-contract=off):
+ *          outputs and states are bit-identical to the scalar filter.
+ *
+ *          Not batched: the AC statistics of step 4 (ac_squared_sum,
+ *          sample_count, for PPG_Filter_GetACRMS). They stay with the caller
+ *          (FilterBatch_Accumulate), which usually wants them per stream
+ *          anyway; LoadLane / StoreLane leave them alone.
+ *
+ *          Device frames: with red on lane 2k and IR on lane 2k+1, one
+ *          time step of interleaved {red, IR} frames is already a row of
+ *          lanes. FilterBatch_ProcessFrames takes a block of frames per
+ *          stream ([stream][t][2], a FIFO burst each) and transposes it in
+ *          4 x 4 tiles of frames with vector shuffles, and the outputs back.
+ */
+#ifndef FILTER_BATCH_H
+#define FILTER_BATCH_H
+
+#include <stdint.h>
+#include "ppg_filter.h"
+#include "simd_isa.h"
+
+#define FILTER_BATCH_LANE_ALIGN 16          // lanes are allocated in multiples of one AVX-512 vector
+#define FILTER_BATCH_TILE       4           // frames per stream and tile in FilterBatch_ProcessFrames
+
+typedef struct {
+    uint32_t channels;
+    uint32_t lanes;                 // channels rounded up to FILTER_BATCH_LANE_ALIGN
+    uint32_t isa;                   // SIMD_ISA_*
+    float *detrend_buffer;          // [DETREND_WINDOW_SIZE][lanes]
+    float *detrend_sum;             // per lane
+    int32_t *detrend_index;
+    int32_t *detrend_filled;        // -1 / 0
+    float *biquad;                  // [NUM_SOS_SECTIONS][2][lanes]: x1, x2
+    float *smooth_buffer;           // [SIGNAL_SMOOTH_SIZE][lanes]
+    int32_t *smooth_index;
+    float *dc;                      // dc_value
+    // One padded row each, and FILTER_BATCH_TILE rows for frame tiles
+    uint32_t *raw_rows;
+    int32_t *active_row;
+    float *ac_rows;
+    float *dc_rows;
+} FilterBatch_t;
+
+// All lanes as after PPG_Filter_Init. 0, -1: out of memory or kernel not supported
+int FilterBatch_Init(FilterBatch_t *b, uint32_t channels, uint32_t isa);
+void FilterBatch_Free(FilterBatch_t *b);
+
+// Copy one channel in from / out to the scalar layout (AC statistics excluded)
+void FilterBatch_LoadLane(FilterBatch_t *b, uint32_t channel, const PPG_FilterState_t *f);
+void FilterBatch_StoreLane(const FilterBatch_t *b, uint32_t channel, PPG_FilterState_t *f);
+
+/**
+ * One sample per channel, as PPG_Filter_Process: raw[channels] in,
+ * ac[channels] (the return value) and dc[channels] (dc_value) out.
+ * active[channel] nonzero runs the channel, 0 leaves it untouched (ac / dc
+ * of that channel undefined); NULL runs them all. dc may be NULL.
+ */
+void FilterBatch_Process(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc);
+
+/**
+ * count frames of every stream, channels / 2 streams: frames, ac and dc
+ * are [stream][count][2] (red, IR), stream s on lanes 2s and 2s+1.
+ * dc may be NULL. 0, -1: odd channel count
+ */
+int FilterBatch_ProcessFrames(FilterBatch_t *b, const uint32_t *frames, uint32_t count, float *ac, float *dc);
+
+// Step 4 of PPG_Filter_Process for a sample filtered here: AC statistics and dc_value
+static inline void FilterBatch_Accumulate(PPG_FilterState_t *f, float ac, float dc) {
+    f->dc_value = dc;
+    if (f->ac_squared_sum > 1e10f) {
+        f->ac_squared_sum = 0.0f;
+        f->sample_count = 0;
+    }
+    f->ac_squared_sum += ac * ac;
+    f->sample_count++;
+}
+
+#endif // FILTER_BATCH_H
@@ -0,0 +1,38 @@
+/**
+ * @file flash_sim.h
+ * @brief NOR flash simulator backend for trend_log (host builds and tests)
+ * @details Models the STM32F1 embedded flash: page erase sets bytes to 0xFF,
+ *          halfword programming can only clear bits and is rejected on a
+ *          non-erased halfword (except writing 0x0000), and erase counts
+ *          are tracked per page. A power cut can be scheduled at the N-th
+ *          operation: that operation is left half done (a torn program
+ *          clears a random subset of the bits, a torn erase only resets part
+ *          of the page) and every later operation fails until power is restored.
+ */
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+#include <stdint.h>
+#include "trend_log.h"
+
+typedef struct {
+    uint8_t *mem;                 // page_count * page_size bytes
+    uint32_t *erase_counts;       // per page
+    uint32_t base;
+    uint16_t page_size;
+    uint16_t page_count;
+
+    uint32_t ops;                 // erase + program operations executed
+    uint32_t cut_at;              // power cut at this operation index (0 = never)
+    uint8_t powered;
+    uint32_t rng;                 // torn-write bit pattern generator
+    uint32_t program_errors;      // programming a non-erased halfword
+} FlashSim_t;
+
+int FlashSim_Init(FlashSim_t *sim, uint32_t base, uint16_t page_size, uint16_t page_count);
+void FlashSim_Free(FlashSim_t *sim);
+void FlashSim_Backend(FlashSim_t *sim, TrendLog_Flash_t *flash);
+void FlashSim_SchedulePowerCut(FlashSim_t *sim, uint32_t after_ops, uint32_t seed);
+void FlashSim_PowerOn(FlashSim_t *sim);
+
+#endif // FLASH_SIM_H
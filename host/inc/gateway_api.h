@@ -0,0 +1,50 @@
+/**
+ * @file gateway_api.h
+ * @brief Local Unix-domain socket API of the gateway (ppg_gateway.h)
+ * @details One thread serves a SOCK_STREAM socket at the given path with
+ *          poll(): it accepts clients, answers their commands and forwards
+ *          the gateway's result events to the clients subscribed to them.
+ *          It is the single consumer of PPGGateway_PollEvents.
+ *
+ *          The protocol is line based text, one command per line:
+ *              STATS           STATS key=value ... (whole gateway)
+ *              GET <id>        OUT <id> <variant> <sample> <hr> <hr_valid> <spo2> <spo2_valid>
+ *                              (one line per variant)
+ *              LAT <id>        LAT <id> key=value ... (the stream's latency, us)
+ *              SUB <id>|ALL    OK; then EV lines, same fields as OUT
+ *              UNSUB           OK
+ *              QUIT            closes the connection
+ *          Anything else, or a stream that does not exist, gets ERR <reason>.
+ *
+ *          A client that does not read fast enough loses events (counted)
+ *          rather than holding up the others; command replies are never
+ *          dropped unless the client's buffer is full of them.
+ */
+#ifndef GATEWAY_API_H
+#define GATEWAY_API_H
+
+#include <stdint.h>
+#include "ppg_gateway.h"
+
+#define GATEWAY_API_MAX_CLIENTS     64
+#define GATEWAY_API_CLIENT_BUFFER   65536       // bytes queued per client
+#define GATEWAY_API_POLL_MS         10          // event forwarding period
+
+typedef struct {
+    uint32_t clients;               // connected now
+    uint64_t connections;           // accepted in total
+    uint64_t commands;
+    uint64_t events;                // taken from the gateway
+    uint64_t events_sent;           // lines queued to subscribers
+    uint64_t events_dropped;        // subscriber too slow
+} GatewayApi_Stats_t;
+
+typedef struct GatewayApi GatewayApi_t;
+
+// Binds path (replacing a stale socket file) and starts serving. NULL on failure
+GatewayApi_t *GatewayApi_Start(PPGGateway_t *gw, const char *path);
+// Closes every connection and removes the socket file
+void GatewayApi_Stop(GatewayApi_t *api);
+void GatewayApi_GetStats(GatewayApi_t *api, GatewayApi_Stats_t *stats);
+
+#endif // GATEWAY_API_H
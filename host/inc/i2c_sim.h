@@ -0,0 +1,77 @@
+/**
+ * @file i2c_sim.h
+ * @brief Simulated I2C bus for the Linux platform backend
+ * @details Devices are modelled at register level (start / write / read /
+ *          stop callbacks). Two ways to drive a bus:
+ *
+ *          - pin level: the firmware's bit-banged soft_i2c.c toggles SCL/SDA
+ *            through Platform_GPIO_Write and I2CSim_SetScl/SetSda decode
+ *            START, STOP, address, data and ACK bits like a real slave would.
+ *            SDA is open drain: the level read back is the AND of the master
+ *            and the addressed device. The slave only changes SDA while SCL
+ *            is low, so START/STOP are always the master's.
+ *          - byte level: I2CSim_Write for a hardware I2C peripheral
+ *            (HAL_I2C_Master_Transmit on the target).
+ *
+ *          Devices may also have an update callback that the platform calls
+ *          whenever virtual time advances (sample clocks, interrupt pins).
+ */
+#ifndef I2C_SIM_H
+#define I2C_SIM_H
+
+#include <stdint.h>
+
+#define I2C_SIM_MAX_DEVICES     4
+
+typedef struct {
+    uint8_t address;                            // 7-bit address
+    void *ctx;
+    uint8_t (*start)(void *ctx, uint8_t read);  // addressed; return 1 to ACK
+    uint8_t (*write)(void *ctx, uint8_t byte);  // byte from the master; return 1 to ACK
+    uint8_t (*read)(void *ctx);                 // next byte to the master
+    void (*stop)(void *ctx);                    // STOP condition (optional)
+    void (*update)(void *ctx, uint64_t now_us); // virtual time advanced (optional)
+} I2CSim_Device_t;
+
+typedef enum {
+    I2C_SIM_IDLE = 0,
+    I2C_SIM_ADDR,               // receiving the address byte
+    I2C_SIM_WRITE,              // receiving data bytes
+    I2C_SIM_READ,               // transmitting data bytes
+    I2C_SIM_IGNORE              // not addressed (NACK) or read ended, wait for STOP/START
+} I2CSim_Phase_t;
+
+typedef struct {
+    const I2CSim_Device_t *devices[I2C_SIM_MAX_DEVICES];
+    uint8_t device_count;
+
+    // Pin-level decoder
+    uint8_t scl;
+    uint8_t master_sda;
+    uint8_t slave_sda;
+    I2CSim_Phase_t phase;
+    uint8_t bits;               // bits clocked in the current byte
+    uint8_t shift;              // byte being received
+    uint8_t tx_byte;            // byte being transmitted
+    uint8_t ack_phase;          // inside the 9th (ACK) clock
+    uint8_t master_ack;         // master ACKed the last transmitted byte
+    uint8_t first_read;         // next ACK-phase exit loads the first read byte
+    const I2CSim_Device_t *active;
+
+    // Statistics
+    uint32_t transfers;         // START conditions (including repeated START)
+    uint32_t nacks;             // address or data bytes not acknowledged
+    uint32_t bytes;             // data bytes written or read
+} I2CSim_Bus_t;
+
+void I2CSim_Init(I2CSim_Bus_t *bus);
+int I2CSim_Attach(I2CSim_Bus_t *bus, const I2CSim_Device_t *device);
+void I2CSim_Update(I2CSim_Bus_t *bus, uint64_t now_us);
+
+void I2CSim_SetScl(I2CSim_Bus_t *bus, uint8_t level);
+void I2CSim_SetSda(I2CSim_Bus_t *bus, uint8_t level);
+uint8_t I2CSim_GetSda(const I2CSim_Bus_t *bus);
+
+uint8_t I2CSim_Write(I2CSim_Bus_t *bus, uint8_t address, const uint8_t *data, uint16_t len);
+
+#endif // I2C_SIM_H
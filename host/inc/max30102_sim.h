@@ -0,0 +1,106 @@
+/**
+ * @file max30102_sim.h
+ * @brief Simulated MAX30102 on the soft I2C bus
+ * @details Register-level model of the parts of the data sheet the driver
+ *          uses or could use:
+ *          - register file with the auto-incrementing register pointer
+ *            (except at FIFO_DATA), soft reset, shutdown, REV_ID / PART_ID
+ *          - 32-sample FIFO: WR_PTR / RD_PTR / OVF_COUNTER, FIFO_ROLLOVER_EN,
+ *            3 bytes per active LED channel (HR: red, SpO2: red + IR,
+ *            multi-LED: SLOT1..4)
+ *          - interrupts: A_FULL (FIFO_A_FULL free slots left), PPG_RDY,
+ *            DIE_TEMP_RDY and the power-on PWR_RDY, cleared by reading the
+ *            status register (A_FULL / PPG_RDY also by reading FIFO_DATA);
+ *            the active-low INT pin is reported through a callback
+ *          - timing: SPO2_SR conversions per second (plus an oscillator
+ *            error), SMP_AVE averaging before the FIFO
+ *          - signal: the source gives ADC counts at the reference settings
+ *            below; they are scaled by LEDx_PA and SPO2_ADC_RGE, clipped at
+ *            full scale and truncated to the LED_PW resolution (15-18 bits,
+ *            left-justified)
+ *          - die temperature: TEMP_EN starts a 29 ms conversion
+ *          Time only moves when the platform layer advances it, so runs are
+ *          deterministic and as fast as the host allows.
+ */
+#ifndef MAX30102_SIM_H
+#define MAX30102_SIM_H
+
+#include <stdint.h>
+#include "i2c_sim.h"
+
+#define MAX30102_SIM_ADDRESS        0x57
+#define MAX30102_SIM_PART_ID        0x15
+#define MAX30102_SIM_REV_ID         0x03
+#define MAX30102_SIM_FIFO_DEPTH     32
+#define MAX30102_SIM_CHANNELS       4           // multi-LED slots
+#define MAX30102_SIM_TEMP_US        29000u      // die temperature conversion time
+#define MAX30102_SIM_LED_RED        1           // LED1 (slot code 1)
+#define MAX30102_SIM_LED_IR         2           // LED2 (slot code 2)
+
+// Source values are ADC counts at these settings (MAX30102_Init)
+#define MAX30102_SIM_REF_LED_PA     0x24
+#define MAX30102_SIM_REF_RANGE_NA   4096
+
+// Sample source: fills the red and IR ADC counts for the conversion at t_us
+typedef void (*MAX30102Sim_Source_t)(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir);
+
+// INT pin changed (active low: 0 = interrupt pending)
+typedef void (*MAX30102Sim_IntPin_t)(void *ctx, uint8_t level);
+
+typedef struct {
+    I2CSim_Device_t device;
+    uint8_t regs[256];
+    uint8_t reg_ptr;
+    uint8_t ptr_pending;            // first byte of a write transfer is the register address
+    uint32_t fifo[MAX30102_SIM_FIFO_DEPTH][MAX30102_SIM_CHANNELS];
+    uint8_t fifo_full;              // WR_PTR == RD_PTR with 32 unread samples
+    uint8_t fifo_byte;              // bytes of the current sample already read
+
+    // Conversion timing
+    uint8_t running;
+    uint64_t now_us;                // last update
+    uint64_t epoch_us;              // conversion 0 of the current configuration
+    uint64_t conversions;           // since epoch_us
+    uint64_t next_us;
+    int32_t rate_error_ppm;         // oscillator error (data sheet: +-1 %)
+    uint32_t avg_red;               // SMP_AVE accumulators
+    uint32_t avg_ir;
+    uint8_t avg_count;
+
+    uint8_t temp_pending;
+    uint64_t temp_done_us;
+    float temperature_c;            // reported die temperature
+
+    uint8_t int_level;
+    MAX30102Sim_IntPin_t int_pin;
+    void *int_ctx;
+
+    MAX30102Sim_Source_t source;
+    void *source_ctx;
+
+    uint32_t samples;               // written to the FIFO (or lost)
+    uint32_t lost;                  // dropped or overwritten because the FIFO was full
+    uint32_t popped;                // read by the host
+    uint32_t saturated;             // channel values clipped at ADC full scale
+    uint32_t interrupts;            // INT pin falling edges
+} MAX30102Sim_t;
+
+void MAX30102Sim_Init(MAX30102Sim_t *sim, MAX30102Sim_Source_t source, void *source_ctx);
+void MAX30102Sim_SetIntPin(MAX30102Sim_t *sim, MAX30102Sim_IntPin_t callback, void *ctx);
+uint8_t MAX30102Sim_FifoCount(const MAX30102Sim_t *sim);
+uint32_t MAX30102Sim_SampleRate(const MAX30102Sim_t *sim);
+uint8_t MAX30102Sim_Channels(const MAX30102Sim_t *sim, uint8_t *leds);
+
+// Recorded source: red/IR samples (ppg_capture_decode CSV) replayed in a loop
+typedef struct {
+    uint32_t *red;
+    uint32_t *ir;
+    uint32_t count;
+    uint32_t rate_hz;               // rate of the recording
+} MAX30102Sim_Recording_t;
+
+int MAX30102Sim_LoadCsv(MAX30102Sim_Recording_t *rec, const char *path, uint32_t rate_hz);
+void MAX30102Sim_FreeRecording(MAX30102Sim_Recording_t *rec);
+void MAX30102Sim_RecordingSource(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir);
+
+#endif // MAX30102_SIM_H
@@ -0,0 +1,40 @@
+/**
+ * @file oled_sim.h
+ * @brief Simulated SH1106 128x64 OLED on the hardware I2C bus
+ * @details Decodes the control byte (0x00 command, 0x40 data), page and
+ *          column address commands and skips the parameter byte of the
+ *          two-byte commands lib/oled sends. Data bytes land in the 132-column
+ *          display RAM; the visible area starts at column 2. The last frame
+ *          can be written as a PBM image for inspection.
+ */
+#ifndef OLED_SIM_H
+#define OLED_SIM_H
+
+#include <stdint.h>
+#include "i2c_sim.h"
+
+#define OLED_SIM_ADDRESS        0x3D        // OLED_ADDRESS (0x7A) >> 1
+#define OLED_SIM_WIDTH          128
+#define OLED_SIM_HEIGHT         64
+#define OLED_SIM_RAM_COLUMNS    132
+#define OLED_SIM_COLUMN_OFFSET  2
+
+typedef struct {
+    I2CSim_Device_t device;
+    uint8_t ram[OLED_SIM_HEIGHT / 8][OLED_SIM_RAM_COLUMNS];
+    uint8_t page;
+    uint8_t column;
+    uint8_t control_pending;        // next byte is the control byte
+    uint8_t data_mode;
+    uint8_t param_pending;          // next command byte is a parameter
+    uint8_t display_on;
+    uint8_t inverted;
+    uint32_t commands;
+    uint32_t frames;                // page 7 written (one full refresh)
+} OLEDSim_t;
+
+void OLEDSim_Init(OLEDSim_t *sim);
+uint8_t OLEDSim_GetPixel(const OLEDSim_t *sim, uint8_t x, uint8_t y);
+int OLEDSim_WritePBM(const OLEDSim_t *sim, const char *path);
+
+#endif // OLED_SIM_H
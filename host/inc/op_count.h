@@ -0,0 +1,282 @@
+/**
+ * @file op_count.h
+ * @brief Operation-counting float type for estimating Cortex-M3 cost on the host
+ * @details The STM32F103 has no FPU: every float add, multiply, divide,
+ *          compare and int<->float conversion in the DSP code is a libgcc
+ *          soft-float call costing tens to hundreds of cycles. Those calls
+ *          dominate the algorithm cost, so counting them on the host and
+ *          weighting them with a per-operation cycle table gives a usable
+ *          estimate of the on-target cost without the hardware.
+ *
+ *          Include this header (C++ only) before the algorithm sources: it
+ *          pulls in the C library headers the sources use and then redefines
+ *          `float` as CountedFloat, so the unmodified .c files compile as C++
+ *          with every float operation counted in op_counts.
+ *
+ *          Counted: float add/sub, mul, div, compare, int->float and
+ *          float->int conversions, sqrtf, sinf/cosf, sign operations
+ *          (fabsf, negate) and float value moves (loads/stores, an upper bound
+ *          since locals held in registers count as well).
+ *
+ *          With OP_COUNT_INTEGERS defined before the include (the counted_*.cpp
+ *          files do), the <stdint.h> types are redefined as CountedInt as well:
+ *          integer divides and remainders (UDIV/SDIV, 2-12 cycles on the M3,
+ *          e.g. ring-buffer wraps) and other integer arithmetic, bit, shift
+ *          and compare operations with a counted operand are counted too.
+ *          A `?:` mixing a literal and a counted integer does not compile
+ *          (both convert to each other); write it as an if in the source.
+ *
+ *          Not counted: integer work on plain `int`/`unsigned` (loop counters),
+ *          unary integer operators, branches (1-3 cycles to refill the
+ *          pipeline) and loop overhead. The estimate is therefore still a
+ *          lower bound. op_count_report -P compares it with the DWT profiler's
+ *          measured cycles per stage and reports the uncounted remainder.
+ */
+#ifndef OP_COUNT_H
+#define OP_COUNT_H
+
+#ifndef __cplusplus
+#error "op_count.h redefines float and must be compiled as C++"
+#endif
+
+// Everything the algorithm sources include, before `float` is redefined
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include <utility>
+
+typedef enum {
+    OP_FADD = 0,        // __aeabi_fadd / __aeabi_fsub
+    OP_FMUL,            // __aeabi_fmul
+    OP_FDIV,            // __aeabi_fdiv
+    OP_FCMP,            // __aeabi_fcmp*
+    OP_I2F,             // __aeabi_i2f / __aeabi_ui2f
+    OP_F2I,             // __aeabi_f2iz / __aeabi_f2uiz
+    OP_FSQRT,           // sqrtf
+    OP_FTRIG,           // sinf / cosf
+    OP_FSIGN,           // fabsf, negate (inline bit operations)
+    OP_LOAD,            // float read from a variable
+    OP_STORE,           // float written to a variable
+    OP_IALU,            // integer add/sub/mul, bit, shift, compare (single cycle)
+    OP_IDIV,            // integer divide / remainder (UDIV / SDIV)
+    OP_KIND_COUNT
+} OpKind_t;
+
+typedef struct {
+    uint64_t n[OP_KIND_COUNT];
+} OpCounts_t;
+
+extern OpCounts_t op_counts;                // running totals
+extern double op_cost[OP_KIND_COUNT];       // cycles per operation on the target
+
+const char *Op_Name(OpKind_t kind);
+void Op_Reset(void);
+void Op_Diff(const OpCounts_t *after, const OpCounts_t *before, OpCounts_t *out);
+double Op_Cycles(const OpCounts_t *counts);
+int Op_LoadCostTable(const char *path);
+
+class CountedFloat {
+public:
+    CountedFloat() = default;
+
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    CountedFloat(T x) : v((float)x) {}
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    CountedFloat(T x) : v((float)x) { op_counts.n[OP_I2F]++; }
+
+    // From a CountedInt (see below): an int->float conversion as well
+    template <typename T, typename T::counted_int_type = 0>
+    CountedFloat(T x) : v((float)x.v) { op_counts.n[OP_I2F]++; }
+
+    // Copying a variable is a load; moving a temporary is free
+    CountedFloat(const CountedFloat &o) : v(o.v) { op_counts.n[OP_LOAD]++; }
+    CountedFloat(CountedFloat &&o) : v(o.v) {}
+
+    CountedFloat &operator=(const CountedFloat &o) {
+        v = o.v;
+        op_counts.n[OP_STORE]++;
+        return *this;
+    }
+
+    // Only explicit casts convert back, like the (uint8_t)/(int32_t) casts in the sources
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    explicit operator T() const {
+        if (std::is_integral<T>::value) {
+            op_counts.n[OP_F2I]++;
+        }
+        return (T)v;
+    }
+
+    // Read-modify-write of a variable: load, operation, store
+    CountedFloat &operator+=(CountedFloat o) { return rmw(OP_FADD, v + o.v); }
+    CountedFloat &operator-=(CountedFloat o) { return rmw(OP_FADD, v - o.v); }
+    CountedFloat &operator*=(CountedFloat o) { return rmw(OP_FMUL, v * o.v); }
+    CountedFloat &operator/=(CountedFloat o) { return rmw(OP_FDIV, v / o.v); }
+
+    // Operands passed by value: reading a variable counts as a load, temporaries do not
+    friend CountedFloat operator+(CountedFloat a, CountedFloat b) { return result(OP_FADD, a.v + b.v); }
+    friend CountedFloat operator-(CountedFloat a, CountedFloat b) { return result(OP_FADD, a.v - b.v); }
+    friend CountedFloat operator*(CountedFloat a, CountedFloat b) { return result(OP_FMUL, a.v * b.v); }
+    friend CountedFloat operator/(CountedFloat a, CountedFloat b) { return result(OP_FDIV, a.v / b.v); }
+    friend CountedFloat operator-(CountedFloat a) { return result(OP_FSIGN, -a.v); }
+    friend CountedFloat operator+(CountedFloat a) { return a; }
+
+    friend bool operator<(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v < b.v; }
+    friend bool operator>(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v > b.v; }
+    friend bool operator<=(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v <= b.v; }
+    friend bool operator>=(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v >= b.v; }
+    friend bool operator==(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v == b.v; }
+    friend bool operator!=(CountedFloat a, CountedFloat b) { op_counts.n[OP_FCMP]++; return a.v != b.v; }
+
+    // Counts one operation and wraps its result (a register value, not a load)
+    static CountedFloat result(OpKind_t kind, float x) {
+        op_counts.n[kind]++;
+        return CountedFloat(x, Raw());
+    }
+
+    float v;
+
+private:
+    struct Raw {};
+    CountedFloat(float x, Raw) : v(x) {}
+
+    CountedFloat &rmw(OpKind_t kind, float x) {
+        op_counts.n[OP_LOAD]++;
+        op_counts.n[kind]++;
+        op_counts.n[OP_STORE]++;
+        v = x;
+        return *this;
+    }
+};
+
+// Mixed operands (float literal, int counter): convert, then use the operators above
+#define OP_COUNT_MIXED(op)                                                                        \
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>   \
+    inline auto operator op(CountedFloat a, T b) -> decltype(a op a) { return std::move(a) op CountedFloat(b); } \
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>   \
+    inline auto operator op(T a, CountedFloat b) -> decltype(b op b) { return CountedFloat(a) op std::move(b); }
+OP_COUNT_MIXED(+)
+OP_COUNT_MIXED(-)
+OP_COUNT_MIXED(*)
+OP_COUNT_MIXED(/)
+OP_COUNT_MIXED(<)
+OP_COUNT_MIXED(>)
+OP_COUNT_MIXED(<=)
+OP_COUNT_MIXED(>=)
+OP_COUNT_MIXED(==)
+OP_COUNT_MIXED(!=)
+#undef OP_COUNT_MIXED
+
+inline CountedFloat sqrtf(CountedFloat x) { return CountedFloat::result(OP_FSQRT, sqrtf(x.v)); }
+inline CountedFloat sinf(CountedFloat x) { return CountedFloat::result(OP_FTRIG, sinf(x.v)); }
+inline CountedFloat cosf(CountedFloat x) { return CountedFloat::result(OP_FTRIG, cosf(x.v)); }
+inline CountedFloat fabsf(CountedFloat x) { return CountedFloat::result(OP_FSIGN, fabsf(x.v)); }
+
+static_assert(sizeof(CountedFloat) == sizeof(float), "CountedFloat must keep the float layout");
+
+// Integer counterpart: converts implicitly to T, so indexing, calls and
+// conditions work unchanged; the operators below count an operation whenever
+// one operand is counted, and their results stay counted for the next one
+template <typename T>
+class CountedInt {
+public:
+    typedef int counted_int_type;
+
+    CountedInt() = default;
+    constexpr CountedInt(T x) : v(x) {}
+
+    template <typename U>
+    constexpr CountedInt(CountedInt<U> x) : v((T)x.v) {}
+
+    // (uint8_t)(hr + 0.5f): a float->int conversion
+    explicit CountedInt(CountedFloat x) : v((T)x) {}
+
+    constexpr operator T() const { return v; }
+
+    CountedInt &operator++() { op_counts.n[OP_IALU]++; ++v; return *this; }
+    CountedInt &operator--() { op_counts.n[OP_IALU]++; --v; return *this; }
+    CountedInt operator++(int) { op_counts.n[OP_IALU]++; return CountedInt(v++); }
+    CountedInt operator--(int) { op_counts.n[OP_IALU]++; return CountedInt(v--); }
+
+    T v;
+};
+
+template <typename T> struct op_int_value { typedef T type; static T get(T x) { return x; } };
+template <typename T> struct op_int_value<CountedInt<T>> { typedef T type; static T get(CountedInt<T> x) { return x.v; } };
+
+template <typename T> struct op_is_counted_int : std::false_type {};
+template <typename T> struct op_is_counted_int<CountedInt<T>> : std::true_type {};
+
+// Integer operand pairs with at least one CountedInt
+template <typename A, typename B>
+struct op_int_pair : std::integral_constant<bool,
+    (op_is_counted_int<A>::value || op_is_counted_int<B>::value) &&
+    std::is_integral<typename op_int_value<A>::type>::value &&
+    std::is_integral<typename op_int_value<B>::type>::value> {};
+
+#define OP_COUNT_INT_BINARY(op, kind)                                                             \
+    template <typename A, typename B, typename std::enable_if<op_int_pair<A, B>::value, int>::type = 0> \
+    inline auto operator op(A a, B b)                                                             \
+        -> CountedInt<decltype(op_int_value<A>::get(a) op op_int_value<B>::get(b))> {             \
+        op_counts.n[kind]++;                                                                      \
+        return op_int_value<A>::get(a) op op_int_value<B>::get(b);                                \
+    }                                                                                             \
+    template <typename T, typename B, typename std::enable_if<op_int_pair<CountedInt<T>, B>::value, int>::type = 0> \
+    inline CountedInt<T> &operator op##=(CountedInt<T> &a, B b) {                                 \
+        op_counts.n[kind]++;                                                                      \
+        a.v = (T)(a.v op op_int_value<B>::get(b));                                                \
+        return a;                                                                                 \
+    }
+OP_COUNT_INT_BINARY(+, OP_IALU)
+OP_COUNT_INT_BINARY(-, OP_IALU)
+OP_COUNT_INT_BINARY(*, OP_IALU)
+OP_COUNT_INT_BINARY(&, OP_IALU)
+OP_COUNT_INT_BINARY(|, OP_IALU)
+OP_COUNT_INT_BINARY(^, OP_IALU)
+OP_COUNT_INT_BINARY(<<, OP_IALU)
+OP_COUNT_INT_BINARY(>>, OP_IALU)
+OP_COUNT_INT_BINARY(/, OP_IDIV)
+OP_COUNT_INT_BINARY(%, OP_IDIV)
+#undef OP_COUNT_INT_BINARY
+
+#define OP_COUNT_INT_COMPARE(op)                                                                  \
+    template <typename A, typename B, typename std::enable_if<op_int_pair<A, B>::value, int>::type = 0> \
+    inline bool operator op(A a, B b) {                                                           \
+        op_counts.n[OP_IALU]++;                                                                   \
+        return op_int_value<A>::get(a) op op_int_value<B>::get(b);                                \
+    }
+OP_COUNT_INT_COMPARE(<)
+OP_COUNT_INT_COMPARE(>)
+OP_COUNT_INT_COMPARE(<=)
+OP_COUNT_INT_COMPARE(>=)
+OP_COUNT_INT_COMPARE(==)
+OP_COUNT_INT_COMPARE(!=)
+#undef OP_COUNT_INT_COMPARE
+
+static_assert(sizeof(CountedInt<uint32_t>) == sizeof(uint32_t), "CountedInt must keep the integer layout");
+static_assert(std::is_trivially_copyable<CountedInt<uint32_t>>::value, "CountedInt must stay memset/memcpy-able");
+
+#define float CountedFloat
+
+#ifdef OP_COUNT_INTEGERS
+typedef CountedInt<uint8_t> CountedU8;
+typedef CountedInt<int8_t> CountedI8;
+typedef CountedInt<uint16_t> CountedU16;
+typedef CountedInt<int16_t> CountedI16;
+typedef CountedInt<uint32_t> CountedU32;
+typedef CountedInt<int32_t> CountedI32;
+#define uint8_t CountedU8
+#define int8_t CountedI8
+#define uint16_t CountedU16
+#define int16_t CountedI16
+#define uint32_t CountedU32
+#define int32_t CountedI32
+#endif
+
+#endif // OP_COUNT_H
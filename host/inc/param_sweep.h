@@ -0,0 +1,110 @@
+/**
+ * @file param_sweep.h
+ * @brief Parallel search of the algorithms' tuning constants over a recording corpus
+ * @details Needs PPG_TUNABLE_PARAMS (ppg_params.h): the algorithms then read
+ *          their hand-tuned constants from a PPG_Params_t in their state,
+ *          and every candidate is a complete PPG_Params_t.
+ *
+ *          Candidates come from a grid (steps values per swept parameter,
+ *          evenly spaced over its range; integer parameters get at most one
+ *          step per value) or from uniform random draws in the ranges. The
+ *          first candidate is always the compiled-in defaults, the baseline
+ *          the others are compared with.
+ *
+ *          Every (candidate, record) pair is one PPGScore_RunParams task on
+ *          a work-stealing pool (work_pool.h); the records are loaded once
+ *          and shared read-only. Each candidate's records are pooled in
+ *          record order, so the results do not depend on the thread count.
+ *
+ *          Two objectives, both minimised:
+ *          - accuracy: pooled heart-rate MAE (bpm)
+ *          - latency: mean heart-rate lag behind the reference (s), or the
+ *            mean time to the first valid output
+ *          A candidate is feasible when both can be measured and its
+ *          heart-rate coverage reaches min_coverage_pct (a candidate that
+ *          rarely reports can have an arbitrarily small error). The Pareto
+ *          front is the set of feasible candidates that no other feasible
+ *          candidate beats on both objectives.
+ */
+#ifndef PARAM_SWEEP_H
+#define PARAM_SWEEP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ppg_score.h"
+
+#ifndef PPG_TUNABLE_PARAMS
+#error "param_sweep needs the algorithms built with PPG_TUNABLE_PARAMS"
+#endif
+
+#define PARAM_SWEEP_MAX_PARAMS      16
+
+// Latency objective
+#define PARAM_SWEEP_LATENCY_LAG         0
+#define PARAM_SWEEP_LATENCY_FIRST_VALID 1
+
+// A tunable constant
+typedef struct {
+    const char *name;               // PPG_Params_t field
+    const char *macro;              // the firmware's compile-time constant
+    const char *variant;            // the variant whose algorithm reads it
+    size_t offset;                  // in PPG_Params_t
+    uint8_t integer;                // uint8_t field, else float
+    float min;                      // default search range
+    float max;
+} ParamSweep_Param_t;
+
+// A swept parameter and its range
+typedef struct {
+    const ParamSweep_Param_t *param;
+    float min;
+    float max;
+} ParamSweep_Range_t;
+
+typedef struct {
+    const PPGVariant_t *variant;
+    uint32_t threads;
+    uint8_t latency;                // PARAM_SWEEP_LATENCY_*
+    double min_coverage_pct;
+} ParamSweep_Config_t;
+
+typedef struct {
+    PPG_Params_t params;
+    PPGScore_Result_t total;        // pooled over the corpus
+    double accuracy;                // heart-rate MAE (bpm)
+    double latency;                 // s
+    double coverage_pct;            // heart-rate coverage
+    uint32_t failed;                // records that could not be run
+    uint8_t feasible;
+    uint8_t pareto;                 // on the Pareto front
+} ParamSweep_Candidate_t;
+
+typedef struct {
+    uint64_t runs;                  // (candidate, record) tasks
+    uint64_t steals;
+    uint64_t samples;
+    double signal_s;
+    double wall_s;
+    uint32_t threads;
+} ParamSweep_Stats_t;
+
+// The tunable constants
+uint32_t ParamSweep_ParamCount(void);
+const ParamSweep_Param_t *ParamSweep_GetParam(uint32_t index);
+const ParamSweep_Param_t *ParamSweep_FindParam(const char *name);
+float ParamSweep_GetValue(const PPG_Params_t *params, const ParamSweep_Param_t *param);
+void ParamSweep_SetValue(PPG_Params_t *params, const ParamSweep_Param_t *param, float value);
+void ParamSweep_Defaults(PPG_Params_t *params);
+
+// Candidates (the defaults first); out == NULL: only count them
+uint64_t ParamSweep_Grid(const ParamSweep_Range_t *ranges, uint32_t range_count, uint32_t steps,
+                         ParamSweep_Candidate_t *out);
+void ParamSweep_Random(const ParamSweep_Range_t *ranges, uint32_t range_count, uint64_t seed,
+                       ParamSweep_Candidate_t *out, uint32_t count);
+
+int ParamSweep_Evaluate(const ParamSweep_Config_t *config, const PPGScore_Record_t *records,
+                        uint32_t record_count, ParamSweep_Candidate_t *candidates, uint32_t count,
+                        ParamSweep_Stats_t *stats);
+uint32_t ParamSweep_Pareto(ParamSweep_Candidate_t *candidates, uint32_t count);
+
+#endif // PARAM_SWEEP_H
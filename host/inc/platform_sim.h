@@ -0,0 +1,48 @@
+/**
+ * @file platform_sim.h
+ * @brief Control interface of the Linux platform backend (platform_linux.c)
+ * @details The backend implements Core/Inc/platform.h on a virtual clock:
+ *          Platform_DelayUs/DelayMs and hardware I2C transfers advance it
+ *          instead of sleeping, so firmware code runs as fast as the host
+ *          allows. CPU time spent in the application itself is not modelled.
+ *
+ *          Peripherals:
+ *          - soft I2C bus on PLATFORM_PIN_I2C_SCL/SDA, decoded at pin level
+ *          - hardware I2C bus (400 kHz) for Platform_I2C_Write
+ *          - input pins driven by devices (PlatformSim_SetPin); a falling
+ *            edge calls the EXTI handler, deferred while in a critical section
+ *          - UART: output to a FILE (stdout by default), input from a queue
+ *
+ *          Platform_Halt() flushes stdout and exits with PLATFORM_SIM_HALT_EXIT.
+ */
+#ifndef PLATFORM_SIM_H
+#define PLATFORM_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "platform.h"
+#include "i2c_sim.h"
+
+#define PLATFORM_SIM_HALT_EXIT      3
+#define PLATFORM_SIM_HW_I2C_HZ      400000u     // I2C1 clock (i2c.c)
+#define PLATFORM_SIM_UART_RX_SIZE   256
+
+typedef enum {
+    PLATFORM_SIM_SOFT_I2C = 0,      // MAX30102 (bit-banged, soft_i2c.c)
+    PLATFORM_SIM_HW_I2C,            // OLED (I2C1)
+    PLATFORM_SIM_BUS_COUNT
+} PlatformSim_Bus_t;
+
+void PlatformSim_Reset(void);
+int PlatformSim_Attach(PlatformSim_Bus_t bus, const I2CSim_Device_t *device);
+I2CSim_Bus_t *PlatformSim_GetBus(PlatformSim_Bus_t bus);
+
+uint64_t PlatformSim_GetUs(void);
+void PlatformSim_Advance(uint64_t us);
+
+void PlatformSim_SetPin(Platform_Pin_t pin, uint8_t level);
+
+void PlatformSim_SetUartOutput(FILE *out);
+int PlatformSim_UartInput(const uint8_t *data, uint16_t len);
+
+#endif // PLATFORM_SIM_H
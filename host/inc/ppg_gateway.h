@@ -0,0 +1,209 @@
+/**
+ * @file ppg_gateway.h
+ * @brief Gateway engine: many concurrent device streams on a pinned thread pool
+ * @details Every stream (one bedside unit) has its own pipeline instance:
+ *          the state of each selected variant (filter plus Method 1 and/or
+ *          Method 2, see ppg_variant.h), an input ring and the latest
+ *          outputs. Streams are split into contiguous blocks, one per
+ *          worker thread; a stream never moves, so its state stays in the
+ *          caches of one core. Workers are pinned to a core each (stream to
+ *          core affinity) and allocate and initialise their own streams, so
+ *          the memory also sits on that core's node.
+ *
+ *          Workers run on a fixed tick (tick_us, absolute deadlines). Each
+ *          tick a worker drains every one of its streams in turn, all of the
+ *          samples that arrived since its last visit in one batch: at 100 Hz
+ *          and a 100 ms tick, 10 samples per visit, so the variant state is
+ *          loaded once per 10 samples instead of once per sample. A tick
+ *          that takes longer than tick_us is an overrun; the next one starts
+ *          at once.
+ *
+ *          A worker keeps the variant states of its streams in slab pools
+ *          (state_pool.h), one per variant, and what the streams publish
+ *          (latest outputs, histograms) in a pool of its own: a tick walks
+ *          the state it runs on every sample back to back, cache-line
+ *          aligned, without stepping over bookkeeping it touches once per
+ *          batch. The streams of a block of 64 take consecutive handles, and
+ *          the next stream's states are prefetched while one runs. With
+ *          state_arena, each stream's states share one block instead and
+ *          nothing is prefetched: the earlier layout, kept for comparison.
+ *          Workers count their last-level cache misses (perf_event_open)
+ *          where the kernel offers the hardware counter.
+ *
+ *          An adaptive variant (ppg_variant.h "ad", ppg_adaptive.h) runs
+ *          Method 1 on every stream and DPT only on those whose signal is
+ *          poor, so what a worker costs follows the signals. With
+ *          escalation_load, a worker whose last tick took more than that
+ *          fraction of tick_us lets no stream escalate to DPT until a tick
+ *          is back within it (the streams keep Method 1, counted as held);
+ *          streams already on DPT stay. The statistics count the samples
+ *          each engine took, and the switches.
+ *
+ *          Devices (or whatever stands in for them) call PPGGateway_Push
+ *          with the arrival time of each sample; the ring of a stream is
+ *          single producer, single consumer, so each stream must be fed from
+ *          one thread. A full ring drops the sample and counts it.
+ *
+ *          The rings are shm_ring.h rings. With ingest, stream i takes its
+ *          samples from ring i of that shared-memory segment instead of a
+ *          private one: acquisition processes write frames straight into it
+ *          (ShmRing_Reserve / ShmRing_Commit, SPSC or MPSC) and the worker
+ *          runs the pipeline on them where they lie, then releases them; no
+ *          copy, no allocation, no system call on either side.
+ *          PPGGateway_Push writes to the same ring, as its producer (or as
+ *          one of them on an MPSC ring).
+ *
+ *          Latency of a batch: from the arrival of its oldest sample to the
+ *          moment its results are published; this includes the wait for the
+ *          tick. Service time: the processing of the batch alone. Both are
+ *          kept per stream in log-spaced histograms (four buckets per
+ *          octave, about 19% wide), from which p50 / p99 / max are read
+ *          while the gateway runs.
+ *
+ *          With filter_batch, the red/IR filters of the variants that have
+ *          process_filtered (Method 1) run for all streams of a worker at
+ *          once in a FilterBatch (filter_batch.h, SIMD across streams), in
+ *          blocks of 64 streams: up to 16 samples of every stream of a block
+ *          go through the filters together, streams with fewer samples masked
+ *          out, and then each stream's variants take the filtered samples in
+ *          turn. Results are bit-identical to the per-stream path.
+ *
+ *          Each display update (PPG_VARIANT_UPDATE_SAMPLES) is stored as the
+ *          stream's latest output (seqlock: readers never block the worker)
+ *          and queued as an event on the worker's event ring, to be taken
+ *          by PPGGateway_PollEvents (one consumer thread, e.g. the socket
+ *          API in gateway_api.h). The ring holds two updates of every
+ *          stream of the worker, so streams that started together and
+ *          update in the same tick fit; events that still find it full (no
+ *          one polling) are dropped and counted.
+ *
+ *          With a checkpoint_path, the streams' states survive a restart:
+ *          the file holds a header (variants, sample rate, filter_batch,
+ *          stream count) and one fixed-size slot per stream with its
+ *          snapshot (ppg_state.h: variant states, processed sample count and,
+ *          with filter_batch, the stream's two filter lanes). Each tick a
+ *          worker rewrites a round-robin share of its streams' slots, so that
+ *          every stream is written at least once per checkpoint_interval_ms
+ *          (0: only at Stop); on Stop each worker writes all of its streams.
+ *          On Start, a stream whose slot is valid resumes where it was (state
+ *          and sample count) instead of from Init; a slot that is empty, torn
+ *          or corrupt (CRC) cold-starts its stream only, and a header that
+ *          does not match the configuration cold-starts all and resets the
+ *          file. Slots go through the page cache (pwrite, no fsync until
+ *          Stop): a killed gateway loses nothing written, a power cut loses
+ *          what the kernel had not yet flushed.
+ */
+#ifndef PPG_GATEWAY_H
+#define PPG_GATEWAY_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "ppg_variant.h"
+#include "shm_ring.h"
+
+#define PPG_GATEWAY_MAX_VARIANTS    2
+#define PPG_GATEWAY_MAX_WORKERS     256
+#define PPG_GATEWAY_RING_SAMPLES    256         // private ring per stream, power of two: 2.56 s at 100 Hz
+#define PPG_GATEWAY_EVENT_RING      4096        // per worker, at least; power of two
+#define PPG_GATEWAY_HIST_BUCKETS    160         // 64 ns resolution up to 256 ns, last bucket from ~1.4 days
+#define PPG_GATEWAY_CHECKPOINT_HEADER 4096      // checkpoint file: slot of stream i at this + i x slot size
+
+typedef struct {
+    uint32_t streams;
+    uint32_t workers;               // 0: one per online CPU
+    const PPGVariant_t *variants[PPG_GATEWAY_MAX_VARIANTS];
+    uint32_t variant_count;
+    float sample_rate_hz;
+    uint32_t tick_us;               // batch period
+    uint8_t pin;                    // pin worker i to CPU i (modulo the online CPUs)
+    uint8_t filter_batch;           // batched red/IR filters (filter_batch.h) where a variant allows it
+    uint8_t state_arena;            // every variant state of a stream in one block, not pooled (for comparison)
+    float escalation_load;          // adaptive variants: no escalation after a tick busier than this x tick_us (0: off)
+    ShmRing_Seg_t *ingest;          // stream i reads ring i in place; NULL: private rings
+    const char *checkpoint_path;    // NULL: no checkpoints
+    uint32_t checkpoint_interval_ms;
+} PPGGateway_Config_t;
+
+typedef struct {
+    uint32_t stream;
+    uint32_t variant;               // index into PPGGateway_Config_t.variants
+    uint64_t sample;                // samples of the stream processed when it was produced
+    PPGVariant_Output_t out;
+} PPGGateway_Event_t;
+
+// Log-spaced latency histogram (ns); single writer, readers see relaxed counts
+typedef struct {
+    _Atomic uint32_t count[PPG_GATEWAY_HIST_BUCKETS];
+    _Atomic uint64_t max_ns;
+} PPGGateway_Hist_t;
+
+typedef struct {
+    uint64_t samples;               // processed
+    uint64_t dropped;               // ring full on push
+    uint64_t batches;
+    uint64_t latency_p50_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_max_ns;
+    uint64_t service_p99_ns;
+} PPGGateway_StreamStats_t;
+
+typedef struct {
+    uint32_t streams;
+    uint32_t workers;
+    uint64_t samples;
+    uint64_t dropped;
+    uint64_t events;                // queued for PPGGateway_PollEvents
+    uint64_t events_dropped;
+    uint64_t ticks;                 // summed over workers
+    uint64_t overruns;
+    uint32_t restored;              // streams resumed from the checkpoint at Start
+    uint64_t checkpoints;           // stream snapshots written
+    uint64_t checkpoint_errors;     // snapshots that did not fit or could not be written
+    double wall_s;                  // since PPGGateway_Start
+    double busy_s;                  // summed over workers
+    double utilisation;             // busy / (wall x workers)
+    uint64_t llc_misses;            // last-level cache misses of the workers, user space
+    uint8_t llc_counted;            // every worker has the hardware counter (else llc_misses is partial)
+    // Adaptive variants (ppg_adaptive.h), summed over their streams
+    uint64_t engine_samples[PPG_ADAPTIVE_ENGINES];  // samples whose heart rate came from Method 1 / DPT
+    uint64_t escalations;
+    uint64_t deescalations;
+    uint64_t escalations_held;      // updates that would have escalated but for escalation_load
+    // All batches of all streams
+    uint64_t latency_p50_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_max_ns;
+    uint64_t service_p99_ns;
+    // Distribution of the per-stream p99 latencies
+    uint64_t stream_p99_median_ns;
+    uint64_t stream_p99_max_ns;
+    uint32_t stream_p99_max_id;
+} PPGGateway_Stats_t;
+
+typedef struct PPGGateway PPGGateway_t;
+
+uint64_t PPGGateway_NowNs(void);
+
+PPGGateway_t *PPGGateway_Create(const PPGGateway_Config_t *config);
+const PPGGateway_Config_t *PPGGateway_GetConfig(const PPGGateway_t *gw);
+// Starts the workers; returns once every stream is initialised (or restored). 0, -1 on failure
+int PPGGateway_Start(PPGGateway_t *gw);
+void PPGGateway_Stop(PPGGateway_t *gw);
+void PPGGateway_Destroy(PPGGateway_t *gw);
+
+// 0, -1: ring full (dropped) or no such stream. One producer thread per stream
+int PPGGateway_Push(PPGGateway_t *gw, uint32_t stream, uint32_t red, uint32_t ir, uint64_t arrival_ns);
+// Events of all workers, up to max; one consumer thread
+uint32_t PPGGateway_PollEvents(PPGGateway_t *gw, PPGGateway_Event_t *events, uint32_t max);
+
+// Latest output of a variant of a stream (no update yet: all zero). 0, -1: no such stream / variant
+int PPGGateway_GetOutput(PPGGateway_t *gw, uint32_t stream, uint32_t variant, PPGVariant_Output_t *out,
+                         uint64_t *sample);
+int PPGGateway_GetStreamStats(PPGGateway_t *gw, uint32_t stream, PPGGateway_StreamStats_t *stats);
+void PPGGateway_GetStats(PPGGateway_t *gw, PPGGateway_Stats_t *stats);
+
+// Histograms
+void PPGGateway_HistRecord(PPGGateway_Hist_t *h, uint64_t ns);
+uint64_t PPGGateway_HistPercentile(const PPGGateway_Hist_t *h, double pct);
+
+#endif // PPG_GATEWAY_H
@@ -0,0 +1,197 @@
+/**
+ * @file ppg_rec.h
+ * @brief Chunked raw-PPG recording container (.ppgrec) with a seek index
+ * @details Layout (little-endian, every part 8-byte aligned):
+ *
+ *            header       PPGRec_Header_t: sensor registers, sample rate,
+ *                         device id, calibration, chunk size
+ *            chunk ...    PPGRec_ChunkHeader_t + payload
+ *            index        PPGRec_IndexEntry_t per chunk
+ *            footer       PPGRec_Footer_t: where the index starts
+ *
+ *          A chunk holds up to chunk_samples red/IR pairs, the index of its
+ *          first sample and its time. The samples are plain (red[count] then
+ *          ir[count], uint32) or compressed with the capture codec
+ *          (ppg_codec.h, the first block of every chunk is a keyframe so a
+ *          chunk decodes on its own); the header's encoding is used unless a
+ *          chunk cannot be compressed (a sample wider than 18 bits). Optional
+ *          reference channels (channels bits) follow the samples, plain:
+ *          ref_hr and ref_spo2 (float[count]) and flags (uint8[count], bit 0
+ *          a beat onset as in ppg_synth -T). Each payload carries a CRC-32.
+ *
+ *          Lost samples (a gap in the capture) end the chunk; the next chunk
+ *          starts at the index after the gap. Chunk times are derived from
+ *          the sample index at the nominal rate.
+ *
+ *          The writer appends chunk by chunk and flushes each one, so a file
+ *          can be read while it is being recorded; the index and footer are
+ *          written by PPGRec_Finish. The reader maps the file: plain chunks
+ *          and reference channels are returned as pointers into the map
+ *          (zero copy), compressed chunks are decoded into the caller's
+ *          buffers. The chunk holding a sample is found through the index
+ *          (directly while chunks are full, else by binary search). A file
+ *          without a footer (recording cut short) is opened by scanning its
+ *          chunks up to the first incomplete or corrupt one.
+ */
+#ifndef PPG_REC_H
+#define PPG_REC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ppg_codec.h"
+
+#define PPG_REC_MAGIC               "PPGREC\r\n"    // \r\n: text-mode transfers show up at once
+#define PPG_REC_FOOTER_MAGIC        "PPGRIDX\n"
+#define PPG_REC_CHUNK_MAGIC         0x4B4E4843u     // "CHNK"
+#define PPG_REC_VERSION             1
+#define PPG_REC_DEFAULT_CHUNK_SAMPLES   1024        // 10.24 s at 100 Hz
+#define PPG_REC_MAX_CHUNK_SAMPLES   65536
+
+// Sample encoding (header default, per chunk actual)
+#define PPG_REC_ENC_PLAIN           0
+#define PPG_REC_ENC_CODEC           1
+
+// Reference channels (header channels bits)
+#define PPG_REC_CH_REF_HR           0x01
+#define PPG_REC_CH_REF_SPO2         0x02
+#define PPG_REC_CH_FLAGS            0x04
+
+// MAX30102 configuration the recording was made with (register values)
+typedef struct {
+    uint8_t fifo_config;            // 0x08: sample averaging, rollover
+    uint8_t mode_config;            // 0x09: SpO2 mode
+    uint8_t spo2_config;            // 0x0A: ADC range, sample rate, pulse width
+    uint8_t led_red_pa;             // 0x0C
+    uint8_t led_ir_pa;              // 0x0D
+    uint8_t adc_bits;
+    uint8_t reserved[2];
+} PPGRec_Sensor_t;
+
+typedef struct {
+    float spo2_a;                   // SpO2 = a R^2 + b R + c
+    float spo2_b;
+    float spo2_c;
+    float red_gain;                 // per-device channel correction, 1: none
+    float ir_gain;
+    float clock_ppm;                // sensor clock deviation from nominal, 0: unknown
+} PPGRec_Calibration_t;
+
+typedef struct {
+    char magic[8];
+    uint16_t version;
+    uint16_t header_size;
+    uint8_t encoding;
+    uint8_t channels;
+    uint16_t reserved0;
+    uint32_t chunk_samples;         // samples in a full chunk
+    float sample_rate_hz;
+    uint64_t start_time_us;         // UNIX time of sample 0, 0: unknown
+    char device_id[24];
+    PPGRec_Sensor_t sensor;
+    PPGRec_Calibration_t calibration;
+    uint8_t reserved[40];
+} PPGRec_Header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t first_sample;          // sample index in the recording
+    uint64_t timestamp_us;          // time of the first sample since start_time_us
+    uint32_t sample_bytes;          // red/IR part of the payload, padded to 8
+    uint32_t payload_bytes;         // whole payload, padded to 8
+    uint32_t crc;                   // CRC-32 of the payload
+    uint8_t encoding;
+    uint8_t reserved[3];
+} PPGRec_ChunkHeader_t;
+
+typedef struct {
+    uint64_t offset;                // of the chunk header
+    uint64_t first_sample;
+    uint64_t position;              // samples stored before this chunk
+    uint64_t timestamp_us;
+    uint32_t count;
+    uint32_t reserved;
+} PPGRec_IndexEntry_t;
+
+typedef struct {
+    char magic[8];
+    uint64_t index_offset;
+    uint64_t total_samples;
+    uint32_t chunk_count;
+    uint32_t reserved;
+} PPGRec_Footer_t;
+
+// Reference values of one sample (writer)
+typedef struct {
+    float hr_bpm;
+    float spo2;
+    uint8_t flags;
+} PPGRec_Reference_t;
+
+typedef struct {
+    FILE *f;
+    PPGRec_Header_t header;
+    uint64_t offset;                // end of the data written so far
+    uint64_t next_sample;           // index of the next sample
+    uint64_t position;              // samples written
+    // Chunk being filled
+    uint32_t count;
+    uint32_t *red;
+    uint32_t *ir;
+    float *ref_hr;
+    float *ref_spo2;
+    uint8_t *flags;
+    uint8_t *payload;
+    uint32_t payload_capacity;
+    // Index of the chunks written
+    PPGRec_IndexEntry_t *index;
+    uint32_t chunk_count;
+    uint32_t index_capacity;
+    uint32_t codec_fallbacks;       // chunks written plain although the codec was asked for
+} PPGRec_Writer_t;
+
+typedef struct {
+    uint64_t first_sample;
+    uint64_t timestamp_us;
+    uint32_t count;
+    const uint32_t *red;            // into the map (plain) or the caller's buffers (codec)
+    const uint32_t *ir;
+    const float *ref_hr;            // NULL when the channel is absent
+    const float *ref_spo2;
+    const uint8_t *flags;
+} PPGRec_Chunk_t;
+
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t size;
+    const PPGRec_Header_t *header;
+    const PPGRec_IndexEntry_t *index;   // in the map, or scanned
+    PPGRec_IndexEntry_t *scanned;       // owned when there was no footer
+    uint32_t chunk_count;
+    uint64_t total_samples;
+    uint8_t complete;                   // footer present
+} PPGRec_Reader_t;
+
+void PPGRec_DefaultHeader(PPGRec_Header_t *header, float sample_rate_hz);
+
+// Writer
+int PPGRec_Create(PPGRec_Writer_t *w, const char *path, const PPGRec_Header_t *header);
+int PPGRec_Append(PPGRec_Writer_t *w, uint32_t red, uint32_t ir, const PPGRec_Reference_t *ref);
+int PPGRec_Gap(PPGRec_Writer_t *w, uint64_t next_sample);
+int PPGRec_Finish(PPGRec_Writer_t *w);
+
+// Reader
+int PPGRec_IsRecording(const char *path);
+int PPGRec_Open(PPGRec_Reader_t *r, const char *path);
+void PPGRec_Close(PPGRec_Reader_t *r);
+int PPGRec_GetChunk(const PPGRec_Reader_t *r, uint32_t chunk, PPGRec_Chunk_t *c,
+                    uint32_t *red_buf, uint32_t *ir_buf);
+int64_t PPGRec_FindChunk(const PPGRec_Reader_t *r, uint64_t position);
+uint32_t PPGRec_Read(const PPGRec_Reader_t *r, uint64_t position, uint32_t count, uint32_t *red, uint32_t *ir);
+int PPGRec_VerifyChunk(const PPGRec_Reader_t *r, uint32_t chunk);
+
+uint32_t PPGRec_Crc32(uint32_t crc, const void *data, size_t len);
+
+#endif // PPG_REC_H
@@ -0,0 +1,113 @@
+/**
+ * @file ppg_score.h
+ * @brief Accuracy and latency scoring of algorithm variants against annotated recordings
+ * @details A record is raw red/IR samples plus a reference: beat onsets
+ *          and/or a per-sample reference heart rate, and a per-sample
+ *          reference SpO2. Annotated recordings are CSV files with a header
+ *          naming the columns ("index,red,ir" plus any of "hr", "spo2" and
+ *          "flags", as written by ppg_synth -T; bit 0 of flags marks a beat
+ *          onset). Recording containers (ppg_rec.h) with reference
+ *          channels are read as well (PPGScore_LoadFile tells them apart).
+ *          When beat onsets are given, the reference heart rate at a
+ *          sample is 60 / mean RR of the beats in the preceding
+ *          PPG_SCORE_REF_WINDOW_S, which is what an averaging monitor can
+ *          be expected to show. PPGScore_Synthesise builds the same kind of
+ *          record from the synthesiser, annotated with its beat onsets and
+ *          SpO2.
+ *
+ *          A variant (ppg_variant.h) is run over the record and every
+ *          display update is compared with the reference at that time:
+ *          - MAE, bias and Bland-Altman limits of agreement (bias +- 1.96 SD)
+ *            over the updates where the output is valid and a reference
+ *            exists
+ *          - coverage: share of updates with a valid output
+ *          - time to first valid output
+ *          - lag: the delay of the reference that best matches the output
+ *            (minimum error SD over 0..PPG_SCORE_MAX_LAG_S), only when the
+ *            reference moves by at least PPG_SCORE_LAG_MIN_RANGE
+ *          Metrics of several records are pooled with PPGScore_Add.
+ */
+#ifndef PPG_SCORE_H
+#define PPG_SCORE_H
+
+#include <stdint.h>
+#include "ppg_variant.h"
+#include "ppg_synth.h"
+
+#define PPG_SCORE_REF_WINDOW_S      8.0     // beat-derived reference HR: trailing window
+#define PPG_SCORE_MAX_LAG_S         30.0
+#define PPG_SCORE_LAG_STEP_S        0.25
+#define PPG_SCORE_LAG_MIN_RANGE     5.0     // reference range (bpm or %) needed to measure the lag
+
+typedef struct {
+    char name[64];
+    float sample_rate_hz;
+    uint32_t count;
+    uint32_t *red;
+    uint32_t *ir;
+    float *ref_hr;                  // per sample, <= 0: no reference
+    float *ref_spo2;                // per sample, <= 0: no reference (NULL: none at all)
+    uint32_t *beats;                // beat onset sample indices (NULL: none)
+    uint32_t beat_count;
+} PPGScore_Record_t;
+
+typedef struct {
+    uint32_t updates;               // display updates
+    uint32_t valid;                 // of which with a valid output
+    uint32_t n;                     // valid and with a reference: the error statistics
+    double sum_err;
+    double sum_abs;
+    double sum_sq;
+    double first_valid_s;           // < 0: never valid
+    double lag_s;                   // < 0: not measured
+
+    // Pooled over records by PPGScore_Add
+    uint32_t records;
+    uint32_t records_valid;         // records that became valid
+    uint32_t records_lag;           // records with a lag
+    double sum_first_valid_s;
+    double sum_lag_s;
+} PPGScore_Metric_t;
+
+typedef struct {
+    PPGScore_Metric_t hr;
+    PPGScore_Metric_t spo2;
+} PPGScore_Result_t;
+
+// Summary values of a metric (pooled or single record)
+typedef struct {
+    double mae;
+    double bias;
+    double sd;
+    double loa_low;
+    double loa_high;
+    double coverage_pct;
+    double first_valid_s;           // mean over records that became valid, < 0: none
+    double lag_s;                   // mean over records with a lag, < 0: none
+} PPGScore_Summary_t;
+
+int PPGScore_LoadCsv(PPGScore_Record_t *rec, const char *path, float sample_rate_hz);
+int PPGScore_LoadRecording(PPGScore_Record_t *rec, const char *path);
+int PPGScore_LoadFile(PPGScore_Record_t *rec, const char *path, float sample_rate_hz);
+int PPGScore_AllocRecord(PPGScore_Record_t *rec, uint32_t count, uint32_t max_beats);
+void PPGScore_FreeRecord(PPGScore_Record_t *rec);
+void PPGScore_ReferenceFromBeats(PPGScore_Record_t *rec, double window_s);
+int PPGScore_Synthesise(PPGScore_Record_t *rec, const PPGSynth_Config_t *config, uint64_t seed,
+                        double seconds, float end_hr_bpm);
+int PPGScore_SynthesisePatient(PPGScore_Record_t *rec, uint64_t patient, double seconds);
+
+int PPGScore_Run(const PPGVariant_t *variant, const PPGScore_Record_t *rec, PPGScore_Result_t *result);
+#ifdef PPG_TUNABLE_PARAMS
+int PPGScore_RunParams(const PPGVariant_t *variant, const PPG_Params_t *params, const PPGScore_Record_t *rec,
+                       PPGScore_Result_t *result);
+#endif
+
+// Incremental scoring, for callers that drive the variant themselves
+void PPGScore_Begin(PPGScore_Result_t *result);
+void PPGScore_Update(PPGScore_Result_t *result, const PPGScore_Record_t *rec, uint32_t sample,
+                     const PPGVariant_Output_t *out);
+void PPGScore_Merge(PPGScore_Result_t *into, const PPGScore_Result_t *later);
+void PPGScore_Add(PPGScore_Metric_t *total, const PPGScore_Metric_t *m);
+void PPGScore_Summarise(const PPGScore_Metric_t *m, PPGScore_Summary_t *s);
+
+#endif // PPG_SCORE_H
@@ -0,0 +1,105 @@
+/**
+ * @file ppg_state.h
+ * @brief Compact, versioned serialisation of the algorithm states
+ * @details Checkpoints of running pipelines: a gateway that restarts (or
+ *          hands a stream to another process) restores each stream where it
+ *          was instead of re-warming it, 10 s of DPT buffer for Method 2 and
+ *          5 s or more for Method 1.
+ *
+ *          Encoding: every field explicitly little-endian, floats as their
+ *          IEEE-754 bit patterns, so a snapshot reads back bit for bit on any
+ *          host. Each state starts with a tag byte and PPG_STATE_VERSION; a
+ *          reader rejects other versions and truncated or overlong input.
+ *          Compact where it is free to be:
+ *
+ *          - ring buffers only up to their fill level while not yet full;
+ *          - the DPT rings as int16 when every value fits (AC values
+ *            normally do), else int32, one width byte per ring;
+ *          - DPT real / imag only once the transform runs (buffer full);
+ *          - derived data is left out: DPT magnitude[] is recomputed from
+ *            real / imag exactly as DPT_Process does, and cos / sin basis
+ *            and tuning parameters (PPG_TUNABLE_PARAMS) are those of the
+ *            state decoded into.
+ *
+ *          A state is decoded into one initialised the same way as the one
+ *          that was saved (Init, SetSampleRate and any set_params): the
+ *          fields saved are overwritten, the others kept.
+ *
+ *          A stream snapshot (PPGState_SaveStream) is the stream id, its
+ *          processed sample count and one blob per variant (ppg_variant.h
+ *          save / load), with a CRC-32; it is self-contained and can be
+ *          written to a file (the gateway's checkpoint) or sent elsewhere.
+ */
+#ifndef PPG_STATE_H
+#define PPG_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include "ppg_variant.h"
+
+#define PPG_STATE_VERSION           1
+#define PPG_STATE_STREAM_MAGIC      0x4D525453u     // "STRM"
+#define PPG_STATE_STREAM_HEADER     28              // bytes before the variant blobs
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    int error;                      // ran out of room; len stops growing
+} PPGState_Writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    int error;                      // truncated or invalid; reads return 0
+} PPGState_Reader_t;
+
+void PPGState_WriterInit(PPGState_Writer_t *w, uint8_t *buf, size_t cap);
+void PPGState_ReaderInit(PPGState_Reader_t *r, const uint8_t *buf, size_t len);
+
+// Little-endian primitives
+void PPGState_PutU8(PPGState_Writer_t *w, uint8_t v);
+void PPGState_PutU16(PPGState_Writer_t *w, uint16_t v);
+void PPGState_PutU32(PPGState_Writer_t *w, uint32_t v);
+void PPGState_PutU64(PPGState_Writer_t *w, uint64_t v);
+void PPGState_PutF32(PPGState_Writer_t *w, float v);
+uint8_t PPGState_GetU8(PPGState_Reader_t *r);
+uint16_t PPGState_GetU16(PPGState_Reader_t *r);
+uint32_t PPGState_GetU32(PPGState_Reader_t *r);
+uint64_t PPGState_GetU64(PPGState_Reader_t *r);
+float PPGState_GetF32(PPGState_Reader_t *r);
+
+// Algorithm states. Get*: 0, -1 (reader error, wrong tag or version, inconsistent fields)
+void PPGState_PutFilter(PPGState_Writer_t *w, const PPG_FilterState_t *f);
+int PPGState_GetFilter(PPGState_Reader_t *r, PPG_FilterState_t *f);
+void PPGState_PutHR(PPGState_Writer_t *w, const HR_State_t *hr);
+int PPGState_GetHR(PPGState_Reader_t *r, HR_State_t *hr);
+void PPGState_PutSpO2(PPGState_Writer_t *w, const SpO2_State_t *spo2);
+int PPGState_GetSpO2(PPGState_Reader_t *r, SpO2_State_t *spo2);
+void PPGState_PutDPT(PPGState_Writer_t *w, const DPT_State_t *dpt);
+int PPGState_GetDPT(PPGState_Reader_t *r, DPT_State_t *dpt);
+
+/**
+ * Snapshot of one stream: its variants' states (each variant must have
+ * save) and, optionally, extra bytes of the caller's (e.g. filter lanes).
+ * @return bytes written, 0 if cap is too small
+ */
+size_t PPGState_SaveStream(uint8_t *buf, size_t cap, uint32_t stream, uint64_t samples,
+                           const PPGVariant_t *const *variants, void *const *states, uint32_t count,
+                           const uint8_t *extra, uint32_t extra_len);
+
+/**
+ * Restore a snapshot into initialised states of the same variants, in the
+ * same order. extra (may be NULL) receives a pointer to the extra bytes.
+ * @return 0, -1 if corrupt (CRC), of another version or other variants;
+ *         the states may then be partly overwritten and must be re-initialised
+ */
+int PPGState_LoadStream(const uint8_t *buf, size_t len, uint32_t *stream, uint64_t *samples,
+                        const PPGVariant_t *const *variants, void *const *states, uint32_t count,
+                        const uint8_t **extra, uint32_t *extra_len);
+
+#endif // PPG_STATE_H
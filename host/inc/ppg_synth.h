@@ -0,0 +1,127 @@
+/**
+ * @file ppg_synth.h
+ * @brief Streaming PPG synthesiser for test corpora and benchmarks
+ * @details Generates raw red/IR ADC counts as the MAX30102 would deliver
+ *          them, one sample at a time, for as long as needed:
+ *          - pulse morphology: systolic wave plus a reflected (diastolic)
+ *            wave with the dicrotic notch between them, from a lookup
+ *            table over the beat phase; the tail of each beat overlaps the
+ *            next one
+ *          - beat timing: mean rate, respiratory sinus arrhythmia, a 0.1 Hz
+ *            (Mayer wave) component and random beat-to-beat variation;
+ *            ectopic beats arrive early with a smaller pulse and are
+ *            followed by a compensatory pause
+ *          - respiration: baseline wander and pulse amplitude modulation
+ *          - SpO2: red/IR modulation ratio from the firmware's calibration
+ *            curve (SpO2 = -45.06 R^2 + 30.354 R + 94.845)
+ *          - motion artifacts: random episodes of large low-frequency
+ *            disturbances on both channels
+ *          - white sensor noise, rounding, ADC saturation and 15-18 bit
+ *            resolution (left-justified, as in the FIFO)
+ *          Light reaching the photodiode drops when blood volume rises, so
+ *          the raw counts dip at each systole.
+ *
+ *          Everything is derived from the seed: the same config and seed
+ *          give the same stream on the same host, however it is chunked.
+ *          Ground truth (instantaneous rate, SpO2, beat onsets, artifact
+ *          flags) can be read alongside each sample.
+ */
+#ifndef PPG_SYNTH_H
+#define PPG_SYNTH_H
+
+#include <stdint.h>
+
+#define PPG_SYNTH_TEMPLATE_SIZE     256         // samples per beat period in the morphology table
+#define PPG_SYNTH_TEMPLATE_SPAN     2           // beat periods covered (tail overlaps the next beat)
+
+// PPGSynth_Truth_t.flags
+#define PPG_SYNTH_FLAG_BEAT         0x01        // a beat starts at this sample (pulse foot)
+#define PPG_SYNTH_FLAG_ECTOPIC      0x02        // current beat is ectopic (premature)
+#define PPG_SYNTH_FLAG_MOTION       0x04        // inside a motion artifact
+#define PPG_SYNTH_FLAG_SATURATED    0x08        // a channel was clipped at ADC full scale
+
+typedef struct {
+    float sample_rate_hz;
+    float hr_bpm;
+    float spo2;                     // percent, 70..100
+    float ir_dc;                    // ADC counts
+    float red_dc;
+    float perfusion_index;          // IR pulse (peak-to-peak) / DC
+
+    float hrv_sd;                   // random beat-to-beat RR variation, fraction of RR
+    float rsa_depth;                // respiratory sinus arrhythmia, fraction of RR
+    float mayer_depth;              // 0.1 Hz RR modulation, fraction of RR
+    float ectopic_prob;             // per beat
+
+    float resp_rate_bpm;            // breaths per minute
+    float resp_baseline;            // baseline wander, fraction of DC
+    float resp_am;                  // pulse amplitude modulation depth
+
+    float reflection;               // diastolic wave height relative to the systolic peak
+    float notch_depth;              // 0 = no notch, 1 = notch down to the diastolic baseline
+
+    float motion_per_min;           // artifact episodes per minute
+    float motion_amp;               // artifact amplitude in multiples of the IR pulse
+    float noise_sd;                 // white noise, ADC counts
+    uint8_t resolution_bits;        // 15..18
+} PPGSynth_Config_t;
+
+typedef struct {
+    float hr_bpm;                   // 60 / RR of the current beat
+    float spo2;
+    uint8_t flags;
+} PPGSynth_Truth_t;
+
+typedef struct {
+    double onset_s;
+    double rr_s;                    // to the next beat
+    double scale_s;                 // width of the pulse wave (the unshortened RR)
+    float amp;
+    uint8_t ectopic;
+} PPGSynth_Beat_t;
+
+typedef struct {
+    PPGSynth_Config_t config;
+    float template_table[PPG_SYNTH_TEMPLATE_SIZE * PPG_SYNTH_TEMPLATE_SPAN + 1];
+    uint64_t rng;
+    uint64_t index;                 // next sample
+    double dt_s;
+
+    PPGSynth_Beat_t cur;
+    PPGSynth_Beat_t prev;
+    uint8_t compensate;             // next beat follows an early one
+    double compensate_rr_s;
+
+    // Respiration phasor (cos, sin), rotated once per sample
+    double resp_c;
+    double resp_s;
+    double resp_rot_c;
+    double resp_rot_s;
+
+    // Motion episode
+    double motion_next_s;
+    double motion_end_s;
+    double motion_start_s;
+    float motion_f1;
+    float motion_f2;
+    float motion_gain;
+
+    float red_ratio;                // red perfusion / IR perfusion (R)
+    uint32_t last_red;
+    uint32_t last_ir;
+    uint64_t beats;
+} PPGSynth_t;
+
+void PPGSynth_DefaultConfig(PPGSynth_Config_t *config);
+void PPGSynth_RandomPatient(PPGSynth_Config_t *config, uint64_t seed);
+void PPGSynth_Init(PPGSynth_t *synth, const PPGSynth_Config_t *config, uint64_t seed);
+void PPGSynth_SetHeartRate(PPGSynth_t *synth, float hr_bpm);
+void PPGSynth_SetSpO2(PPGSynth_t *synth, float spo2);
+void PPGSynth_Next(PPGSynth_t *synth, uint32_t *red, uint32_t *ir, PPGSynth_Truth_t *truth);
+void PPGSynth_Generate(PPGSynth_t *synth, uint32_t *red, uint32_t *ir, PPGSynth_Truth_t *truth, uint32_t count);
+float PPGSynth_RatioForSpO2(float spo2);
+
+// MAX30102Sim_Source_t: the sample nearest to t_us (ctx = PPGSynth_t)
+void PPGSynth_Source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir);
+
+#endif // PPG_SYNTH_H
@@ -0,0 +1,85 @@
+/**
+ * @file ppg_variant.h
+ * @brief Algorithm variants behind one interface, for the host tools
+ * @details Each variant runs one algorithm the way app.c drives it: every
+ *          raw red/IR sample goes in, and every PPG_VARIANT_UPDATE_SAMPLES
+ *          samples it reports what the display would show (heart rate and
+ *          SpO2, each with its valid flag). The finger detection threshold
+ *          in app.c is not applied; the recording decides what the
+ *          algorithm sees.
+ *
+ *          The whole state lives in a caller-provided block of state_size
+ *          bytes with no pointers into itself, so it can be copied to hand a
+ *          record over between workers or to checkpoint it. A new algorithm
+ *          (or a build of an existing one with other parameters) is added by
+ *          appending an entry to the table in ppg_variant.c.
+ *
+ *          A variant whose front end is the red/IR PPG_Filter_Process pair
+ *          (Method 1) also has process_filtered: the same step with the two
+ *          filters run by the caller, e.g. for many streams at once with
+ *          filter_batch.h. It takes the filtered sample and keeps the rest
+ *          (the filters' AC statistics included) in its state; a stream is
+ *          fed through one of process and process_filtered, not both.
+ *
+ *          save / load snapshot a running state compactly (ppg_state.h),
+ *          for checkpoints and hand-over of streams; a loaded state continues
+ *          bit for bit as the saved one would have.
+ *
+ *          The adaptive variant ("ad") is app.c's USE_ALGORITHM_ADAPTIVE:
+ *          Method 1 on every sample, its heart rate from DPT while the signal
+ *          is poor (ppg_adaptive.h). Its adaptive hook gives the owner the
+ *          selector, to hold escalations under load and to count the samples
+ *          each engine took.
+ *
+ *          Built with PPG_TUNABLE_PARAMS (ppg_params.h), the state carries
+ *          the algorithm's tuning constants and set_params replaces them
+ *          after init; see param_sweep.h.
+ */
+#ifndef PPG_VARIANT_H
+#define PPG_VARIANT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ppg_params.h"
+#include "ppg_adaptive.h"
+
+#define PPG_VARIANT_UPDATE_SAMPLES  250         // app.c: HR / SpO2 / display every 2.5 s at 100 Hz
+
+typedef struct {
+    float hr_bpm;
+    float spo2;
+    uint8_t hr_valid;
+    uint8_t spo2_valid;
+} PPGVariant_Output_t;
+
+// Output of the red / IR filters for one sample: PPG_Filter_Process and dc_value
+typedef struct {
+    float ac[2];                    // red, IR
+    float dc[2];
+} PPGVariant_Filtered_t;
+
+typedef struct {
+    const char *name;               // short name used on command lines ("m1", "m2", "ad")
+    const char *description;
+    size_t state_size;
+    void (*init)(void *state, float sample_rate_hz);
+    // Returns 1 when out was updated (a display refresh), 0 otherwise
+    uint8_t (*process)(void *state, uint32_t red, uint32_t ir, PPGVariant_Output_t *out);
+    // Optional (NULL: no PPG_Filter_Process front end), as process
+    uint8_t (*process_filtered)(void *state, const PPGVariant_Filtered_t *in, PPGVariant_Output_t *out);
+    // Compact snapshot of the state (ppg_state.h): bytes written, 0 if cap is too small
+    size_t (*save)(const void *state, uint8_t *buf, size_t cap);
+    // Into a state after init (and set_params): 0, -1 if the snapshot is invalid
+    int (*load)(void *state, const uint8_t *buf, size_t len);
+    // Optional: the engine selector of an adaptive variant (ppg_adaptive.h), NULL otherwise
+    PPG_Adaptive_t *(*adaptive)(void *state);
+#ifdef PPG_TUNABLE_PARAMS
+    void (*set_params)(void *state, const PPG_Params_t *params);
+#endif
+} PPGVariant_t;
+
+uint32_t PPGVariant_Count(void);
+const PPGVariant_t *PPGVariant_Get(uint32_t index);
+const PPGVariant_t *PPGVariant_Find(const char *name);
+
+#endif // PPG_VARIANT_H
@@ -0,0 +1,47 @@
+/**
+ * @file serial_device.h
+ * @brief Stand-in for a bedside unit's serial output
+ * @details Produces the byte stream the firmware writes to its UART with raw
+ *          capture on (app.c, USE_RAW_CAPTURE): samples compressed into
+ *          TLM_TYPE_RAW_PPG telemetry frames by the same capture code
+ *          (ppg_codec.h), mixed with the printf result lines. The bytes are
+ *          appended to the device's output buffer, from which the caller
+ *          writes them to a link (pty, pipe, socket) and removes them with
+ *          SerialDevice_Consume. Bytes that do not fit are lost and counted,
+ *          like a UART transmit buffer that overflows.
+ *
+ *          The telemetry sender is global (telemetry.h): one device pushes
+ *          at a time, per thread.
+ */
+#ifndef SERIAL_DEVICE_H
+#define SERIAL_DEVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ppg_codec.h"
+
+typedef struct {
+    PPG_Capture_t capture;
+    uint8_t *out;                   // pending output
+    size_t len;
+    size_t size;
+    uint64_t samples;
+    uint64_t bytes;                 // appended in total
+    uint64_t overflow;              // bytes lost, buffer full
+} SerialDevice_t;
+
+void SerialDevice_Init(SerialDevice_t *dev, uint8_t *buf, size_t size);
+// One sample pair; a frame goes out every PPG_CAPTURE_BLOCKS_PER_FRAME blocks
+void SerialDevice_Push(SerialDevice_t *dev, uint32_t red, uint32_t ir);
+// The rest of the samples, in a last (short) frame
+void SerialDevice_Flush(SerialDevice_t *dev);
+// A display update's result lines of one method (1, 2), as the firmware prints them
+void SerialDevice_Report(SerialDevice_t *dev, int method, float hr, int hr_valid, float spo2, int spo2_valid);
+// Any text
+void SerialDevice_Print(SerialDevice_t *dev, const char *text);
+// Any telemetry frame (trend log, profile ...)
+void SerialDevice_Send(SerialDevice_t *dev, uint8_t type, const uint8_t *payload, uint16_t len);
+// The first n bytes were sent
+void SerialDevice_Consume(SerialDevice_t *dev, size_t n);
+
+#endif // SERIAL_DEVICE_H
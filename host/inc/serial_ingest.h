@@ -0,0 +1,109 @@
+/**
+ * @file serial_ingest.h
+ * @brief Ingestion of many device serial links (ttys, ptys) into per-stream rings
+ * @details Every bedside unit talks over its own serial link: the firmware's
+ *          printf lines ("[Method1] HR: 72.4 BPM (Valid)" ...) mixed with
+ *          binary telemetry frames (telemetry.h), of which the raw-capture
+ *          frames (TLM_TYPE_RAW_PPG, ppg_codec.h) carry the samples. One
+ *          thread multiplexes thousands of links with epoll (level
+ *          triggered). Each ready link gets one read into its preallocated
+ *          buffer; the bytes are then parsed incrementally, state kept across
+ *          reads: text between frames is split into lines with memchr up to
+ *          the next sync byte, frames go through the telemetry parser, and the
+ *          samples of a raw frame are decoded straight into the link's ring of
+ *          a shm_ring.h segment, which the gateway (ppg_gateway.h, ingest)
+ *          reads in place. Link i writes ring i, stamping the samples with the
+ *          time of the read. The result lines update the link's last device
+ *          report.
+ *
+ *          Backpressure: a frame is only decoded once its ring has room for
+ *          all of it. Until then the link is paused: taken out of the epoll
+ *          set with the rest of its buffer unparsed, so the kernel's tty buffer
+ *          fills and the device side's writes block. Paused links are retried
+ *          at the start of every poll (after at most 1 ms) and rejoin the set
+ *          once their buffer is parsed. Nothing is dropped on the way; gaps in
+ *          the capture indices (lost on the device or the wire) are counted.
+ *
+ *          A link ends at end of file or on an I/O error (a pty whose other
+ *          side closed); its descriptor is closed then, or by Destroy.
+ */
+#ifndef SERIAL_INGEST_H
+#define SERIAL_INGEST_H
+
+#include <stdint.h>
+#include "shm_ring.h"
+
+#define SERIAL_INGEST_READ_BYTES    1024        // per-link read buffer: 5 s of a 100 Hz device
+#define SERIAL_INGEST_LINE_MAX      96          // longer text lines are counted and skipped
+#define SERIAL_INGEST_EVENTS        256         // ready links taken per epoll_wait
+#define SERIAL_INGEST_POLL_MS       10          // Start's thread: epoll_wait timeout
+
+typedef struct {
+    uint32_t links;                 // most links SerialIngest_Add will take
+    ShmRing_Seg_t *rings;           // link i decodes into ring i (rings >= links)
+} SerialIngest_Config_t;
+
+// One link. Method 1 is [0], Method 2 [1]
+typedef struct {
+    uint8_t open;
+    uint8_t paused;                 // waiting for room in its ring
+    uint64_t bytes;
+    uint64_t samples;               // decoded into the ring
+    uint64_t samples_lost;          // capture index gaps
+    uint64_t frames;                // raw-capture frames
+    uint64_t other_frames;          // other telemetry frames (trend log, profile ...)
+    uint64_t crc_errors;
+    uint64_t lines;                 // text lines
+    uint64_t long_lines;            // over SERIAL_INGEST_LINE_MAX, skipped
+    uint64_t pauses;
+    // Last report of each method, from the result lines
+    uint32_t reports[2];
+    float hr[2];
+    uint8_t hr_valid[2];
+    float spo2[2];
+    uint8_t spo2_valid[2];
+} SerialIngest_LinkStats_t;
+
+typedef struct {
+    uint32_t links;
+    uint32_t open;
+    uint32_t paused;
+    uint64_t bytes;
+    uint64_t reads;
+    uint64_t polls;                 // epoll_wait calls that returned links
+    double busy_s;                  // servicing links (reading, parsing, decoding)
+    uint64_t samples;
+    uint64_t samples_lost;
+    uint64_t frames;
+    uint64_t other_frames;
+    uint64_t crc_errors;
+    uint64_t lines;
+    uint64_t reports;
+    uint64_t pauses;
+} SerialIngest_Stats_t;
+
+typedef struct SerialIngest SerialIngest_t;
+
+// NULL on failure (no links, too few rings, out of memory)
+SerialIngest_t *SerialIngest_Create(const SerialIngest_Config_t *config);
+// Closes every link still open
+void SerialIngest_Destroy(SerialIngest_t *in);
+
+/**
+ * Add a link (before Start): the next link id, its ring of the same index.
+ * The link takes over fd, made non-blocking and, for a tty, raw.
+ * @return link id, -1 (all links in use, epoll failure; fd is left open)
+ */
+int SerialIngest_Add(SerialIngest_t *in, int fd);
+
+// One round: the paused links, then the ready ones. Links that were ready, -1
+int SerialIngest_Poll(SerialIngest_t *in, int timeout_ms);
+// Or let a thread of its own poll until Stop. 0, -1
+int SerialIngest_Start(SerialIngest_t *in);
+void SerialIngest_Stop(SerialIngest_t *in);
+
+void SerialIngest_GetStats(SerialIngest_t *in, SerialIngest_Stats_t *stats);
+// 0, -1 no such link
+int SerialIngest_GetLink(SerialIngest_t *in, uint32_t link, SerialIngest_LinkStats_t *stats);
+
+#endif // SERIAL_INGEST_H
@@ -0,0 +1,125 @@
+/**
+ * @file shm_ring.h
+ * @brief Shared-memory rings of timestamped red/IR frames between processes
+ * @details Acquisition processes (serial / USB readers) hand samples to the
+ *          analysis process (the gateway) without a pipe: a segment created
+ *          with memfd_create holds one ring per device stream, each a power
+ *          of two of fixed 16-byte frames, mapped by both sides. Producers
+ *          write frames where the consumer will read them and the consumer
+ *          processes them where they are; nothing is copied through the
+ *          kernel and nothing is allocated per frame.
+ *
+ *          Every ring has a producer head (reserved), a producer tail
+ *          (committed) and a consumer tail, each 32-bit and free-running.
+ *          A producer reserves a batch of frames (ShmRing_Reserve), fills
+ *          them in place and commits them (ShmRing_Commit); the consumer
+ *          sees committed frames only (ShmRing_Peek) and releases them once
+ *          done (ShmRing_Release). SPSC rings: the single producer reserves
+ *          with plain stores. MPSC rings (SHM_RING_MPSC): producers reserve
+ *          with a CAS on the head and commit in reservation order, a
+ *          producer waiting for the ones that reserved before it (they are
+ *          only filling a few frames; it spins, then yields).
+ *
+ *          Wakeups: a consumer with nothing to do may sleep on the ring
+ *          (ShmRing_Wait), a futex on the committed tail in shared memory,
+ *          until a watermark of min_frames: a producer issues the wake system
+ *          call only once a sleeping consumer's watermark is reached, once per
+ *          sleep. A futex wake preempts the producer, where a pipe's does not,
+ *          so a consumer that wakes for every frame pays a context switch per
+ *          commit; consumers that can take their frames in batches wait for a
+ *          batch (the timeout bounds the latency). A consumer that polls (the
+ *          gateway, on its tick) costs producers no system call at all.
+ *
+ *          The segment reaches another process by inheritance (fork) or over
+ *          a Unix socket (ShmRing_SendFd / ShmRing_RecvFd), and is checked on
+ *          ShmRing_Attach (magic, version, sizes). The rings' contents are
+ *          not trusted beyond that: positions are masked, so a misbehaving
+ *          producer corrupts its own stream's samples only.
+ */
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define SHM_RING_MAGIC      0x474E5253u     // "SRNG"
+#define SHM_RING_VERSION    1
+#define SHM_RING_HEADER     4096            // segment header; rings follow, page aligned
+#define SHM_RING_MPSC       0x01u           // flags: several producers per ring
+
+// One sample of one device: 16 bytes
+typedef struct {
+    uint32_t red;
+    uint32_t ir;
+    uint64_t t_ns;                  // arrival, CLOCK_MONOTONIC
+} ShmRing_Frame_t;
+
+// Ring control block in the segment; the frames follow it
+typedef struct {
+    _Alignas(64) _Atomic uint32_t prod_head;        // reserved
+    _Atomic uint32_t prod_tail;                     // committed; futex word
+    _Atomic uint64_t dropped;                       // counted by ShmRing_Push / ShmRing_AddDropped
+    _Alignas(64) _Atomic uint32_t cons_tail;        // released
+    _Atomic uint32_t sleeping;                      // consumer in ShmRing_Wait
+    _Atomic uint32_t wake_at;                       // producer tail that wakes it
+} ShmRing_Ctrl_t;
+
+// Process-local handle of a ring
+typedef struct {
+    ShmRing_Ctrl_t *ctrl;
+    ShmRing_Frame_t *frames;
+    uint32_t mask;
+    uint32_t flags;
+} ShmRing_t;
+
+// Process-local handle of a mapped segment
+typedef struct {
+    int fd;
+    uint8_t *base;
+    size_t size;
+    uint32_t rings;
+    uint32_t frames;                // per ring
+    uint32_t flags;
+    ShmRing_t *ring;
+} ShmRing_Seg_t;
+
+/**
+ * Create a segment of rings, each of frames frames (power of two).
+ * @return 0, -1 (invalid sizes, memfd / mmap failure)
+ */
+int ShmRing_Create(ShmRing_Seg_t *seg, uint32_t rings, uint32_t frames, uint32_t flags);
+// Map a segment created by another process; the handle then owns fd. 0, -1 if fd is not a valid segment
+int ShmRing_Attach(ShmRing_Seg_t *seg, int fd);
+// Unmap and close the fd; the segment lives on while others have it mapped
+void ShmRing_Detach(ShmRing_Seg_t *seg);
+ShmRing_t *ShmRing_Get(ShmRing_Seg_t *seg, uint32_t ring);
+
+// Pass the segment's fd over a connected Unix socket. 0, -1
+int ShmRing_SendFd(int sock, int fd);
+// fd received, -1
+int ShmRing_RecvFd(int sock);
+
+static inline ShmRing_Frame_t *ShmRing_Frame(const ShmRing_t *r, uint32_t pos) {
+    return &r->frames[pos & r->mask];
+}
+
+// Producer: reserve up to n frames at *pos .. *pos + count - 1; returns count (0: full)
+uint32_t ShmRing_Reserve(ShmRing_t *r, uint32_t n, uint32_t *pos);
+// Producer: publish frames reserved at pos; wakes a sleeping consumer
+void ShmRing_Commit(ShmRing_t *r, uint32_t pos, uint32_t n);
+// Producer: frames a reservation would get now (exact for the producer of an SPSC ring)
+uint32_t ShmRing_Room(const ShmRing_t *r);
+// Producer: one frame. 0, -1 ring full (dropped and counted)
+int ShmRing_Push(ShmRing_t *r, uint32_t red, uint32_t ir, uint64_t t_ns);
+void ShmRing_AddDropped(ShmRing_t *r, uint64_t n);
+
+// Consumer: committed frames not yet released, from *pos
+uint32_t ShmRing_Peek(const ShmRing_t *r, uint32_t *pos);
+// Consumer: every frame before pos is done with
+void ShmRing_Release(ShmRing_t *r, uint32_t pos);
+// Consumer: sleep until min_frames are committed or timeout_ns passes.
+// 1 frames (fewer than min_frames on timeout), 0 none
+int ShmRing_Wait(ShmRing_t *r, uint32_t min_frames, uint64_t timeout_ns);
+
+#endif // SHM_RING_H
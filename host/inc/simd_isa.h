@@ -0,0 +1,26 @@
+/**
+ * @file simd_isa.h
+ * @brief Run-time choice of the vector kernels of the batched engines
+ * @details dpt_batch.c and filter_batch.c each carry a portable C kernel and
+ *          vector kernels built for a given instruction set: AVX2 and
+ *          AVX-512F on x86 (compiled with target attributes, picked at run
+ *          time from what the CPU reports), NEON on AArch64 (always there).
+ *          An engine is initialised with one of these; SimdIsa_Best() is
+ *          the widest the host supports.
+ */
+#ifndef SIMD_ISA_H
+#define SIMD_ISA_H
+
+#include <stdint.h>
+
+#define SIMD_ISA_SCALAR     0
+#define SIMD_ISA_AVX2       1
+#define SIMD_ISA_AVX512     2
+#define SIMD_ISA_NEON       3
+#define SIMD_ISA_COUNT      4
+
+uint32_t SimdIsa_Best(void);
+int SimdIsa_Supported(uint32_t isa);
+const char *SimdIsa_Name(uint32_t isa);
+
+#endif // SIMD_ISA_H
@@ -0,0 +1,80 @@
+/**
+ * @file state_pool.h
+ * @brief Slab pools of per-stream state behind stable handles
+ * @details One pool holds objects of one size (a variant's state, a stream's
+ *          bookkeeping), each on cache lines of its own: the size is rounded
+ *          up to STATE_POOL_ALIGN, so neighbours never share a line. Objects
+ *          sit in slabs of a power of two of them, page aligned and allocated
+ *          as the handles reach them; a slab never moves or shrinks, so a
+ *          handle, and the pointer StatePool_Get gives for it, stays valid
+ *          until the pool is freed, whatever is allocated or released
+ *          meanwhile.
+ *
+ *          What a pool is for is the layout: the state a loop touches on
+ *          every sample goes in one pool, what it touches now and then
+ *          (results, statistics) in another, so a pass over many streams
+ *          walks contiguous hot state instead of stepping over cold bytes.
+ *          StatePool_AllocRun hands out consecutive handles in one slab for
+ *          streams processed together (a batch), and StatePool_Prefetch
+ *          brings an object's lines in ahead of use.
+ *
+ *          Released handles are reused by StatePool_Alloc, most recent first;
+ *          runs are only taken from slots never handed out. Contents are
+ *          undefined until the caller initialises them: the first touch is
+ *          the caller's, e.g. on the core that will use the state. Not
+ *          thread safe: one owner per pool.
+ */
+#ifndef STATE_POOL_H
+#define STATE_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATE_POOL_ALIGN        64          // objects start on a cache line
+#define STATE_POOL_SLAB_ALIGN   4096        // slabs start on a page
+#define STATE_POOL_NONE         UINT32_MAX  // no handle: pool full or out of memory
+
+typedef uint32_t StatePool_Handle_t;
+
+typedef struct {
+    size_t size;                    // bytes per object, as asked
+    size_t stride;                  // size rounded up to STATE_POOL_ALIGN
+    uint32_t slab_shift;            // objects per slab: 1 << slab_shift
+    uint32_t capacity;              // most objects
+    uint32_t next;                  // slots from here on never handed out
+    uint32_t used;                  // handed out and not released
+    uint8_t **slab;                 // [capacity >> slab_shift, rounded up], NULL until reached
+    StatePool_Handle_t *free;       // released and skipped slots, a stack
+    uint32_t free_count;
+} StatePool_t;
+
+/**
+ * Empty pool of up to capacity objects of size bytes, in slabs of
+ * slab_objects (a power of two). 0, -1 (invalid sizes, out of memory)
+ */
+int StatePool_Init(StatePool_t *p, size_t size, uint32_t slab_objects, uint32_t capacity);
+// Every slab; handles and pointers of the pool are invalid from here on
+void StatePool_Free(StatePool_t *p);
+
+// One object. STATE_POOL_NONE when full or out of memory
+StatePool_Handle_t StatePool_Alloc(StatePool_t *p);
+// count objects at consecutive handles (first, first + 1 ...) in one slab;
+// the rest of a slab too short for them is left to StatePool_Alloc.
+// STATE_POOL_NONE when count exceeds a slab, the pool is full or out of memory
+StatePool_Handle_t StatePool_AllocRun(StatePool_t *p, uint32_t count);
+// The object may be handed out again; others are not affected
+void StatePool_Release(StatePool_t *p, StatePool_Handle_t h);
+
+static inline void *StatePool_Get(const StatePool_t *p, StatePool_Handle_t h) {
+    return p->slab[h >> p->slab_shift] + (size_t)(h & ((1u << p->slab_shift) - 1u)) * p->stride;
+}
+
+// All lines of an object of the pool (StatePool_Get's pointer), to be written soon
+static inline void StatePool_Prefetch(const StatePool_t *p, const void *object) {
+    const char *c = (const char *)object;
+    for (size_t off = 0; off < p->stride; off += STATE_POOL_ALIGN) {
+        __builtin_prefetch(c + off, 1, 3);
+    }
+}
+
+#endif // STATE_POOL_H
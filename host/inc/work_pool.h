@@ -0,0 +1,66 @@
+/**
+ * @file work_pool.h
+ * @brief Work-stealing thread pool for the host batch tools
+ * @details Every worker owns a deque of tasks. A worker takes its own tasks
+ *          from the bottom (newest first, so a task it just spawned - the
+ *          next chunk of the record it is working on - runs next while the
+ *          data is still in its cache) and, when it runs dry, steals the
+ *          oldest task from the top of another worker's deque. Tasks
+ *          submitted from outside the pool are dealt round-robin. Idle
+ *          workers sleep until a task is queued.
+ *
+ *          Tasks may spawn further tasks; WorkPool_Wait returns once every
+ *          submitted and spawned task has finished. Tasks are coarse (a
+ *          chunk of a recording, milliseconds of work), so each deque is
+ *          protected by a plain mutex.
+ */
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define WORK_POOL_MAX_WORKERS   256
+
+// worker: index of the worker thread running the task (for WorkPool_Spawn and per-worker scratch)
+typedef void (*WorkPool_Fn_t)(void *arg, uint32_t worker);
+
+typedef struct {
+    WorkPool_Fn_t fn;
+    void *arg;
+} WorkPool_Task_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    WorkPool_Task_t *tasks;         // ring buffer: top (oldest) .. bottom (newest)
+    uint32_t capacity;
+    uint32_t top;
+    uint32_t count;
+    uint64_t executed;              // statistics, written by the owner only
+    uint64_t stolen;                // tasks this worker took from others
+} WorkPool_Deque_t;
+
+typedef struct {
+    uint32_t workers;
+    uint32_t started;               // threads running
+    WorkPool_Deque_t *deques;
+    pthread_t *threads;
+    pthread_mutex_t idle_lock;
+    pthread_cond_t work_cond;       // a task was queued, or stop
+    pthread_cond_t done_cond;       // pending reached 0
+    atomic_uint_fast64_t queued;    // tasks sitting in deques
+    atomic_uint_fast64_t pending;   // queued or running
+    atomic_uint next_submit;
+    int stop;
+} WorkPool_t;
+
+int WorkPool_Init(WorkPool_t *pool, uint32_t workers);
+int WorkPool_Submit(WorkPool_t *pool, WorkPool_Fn_t fn, void *arg);
+int WorkPool_Spawn(WorkPool_t *pool, uint32_t worker, WorkPool_Fn_t fn, void *arg);
+void WorkPool_Wait(WorkPool_t *pool);
+void WorkPool_Destroy(WorkPool_t *pool);
+
+uint32_t WorkPool_DefaultWorkers(void);
+
+#endif // WORK_POOL_H
@@ -0,0 +1,390 @@
+/**
+ * @file batch_replay.c
+ * @brief Parallel replay of many recordings through an algorithm variant
+ */
+
+#include "batch_replay.h"
+#include "work_pool.h"
+#include "filter_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+typedef struct Engine Engine_t;
+
+typedef struct {
+    Engine_t *engine;
+    uint32_t index;
+    PPGScore_Record_t rec;
+    uint32_t chunks;
+    void *state;                    // hand-off: the record's variant state
+    PPGScore_Result_t *chunk_results;   // warm-up: one per chunk, merged in order
+    atomic_uint remaining;          // warm-up: chunk tasks still running
+    atomic_int failed;              // warm-up: a chunk could not be queued
+} Job_t;
+
+typedef struct {
+    Job_t *job;
+    uint32_t chunk;                 // filtered warm-up: the first of the group
+} Chunk_t;
+
+struct Engine {
+    const PPGVariant_t *variant;
+    uint32_t chunk_samples;
+    uint32_t warmup_samples;
+    BatchReplay_Load_t load;
+    void *ctx;
+    uint32_t records;
+    BatchReplay_RecordResult_t *results;
+    WorkPool_t pool;
+    uint32_t group;                 // warm-up: chunks per task (BATCH_REPLAY_FILTER_GROUP when filtered)
+    uint8_t *scratch;               // warm-up: group variant states per worker
+    FilterBatch_t *filters;         // filtered warm-up: one per worker, 2 * group channels
+    PPG_FilterState_t fresh_filter; // as after PPG_Filter_Init
+    atomic_uint next_record;
+    atomic_uint_fast64_t samples;
+    atomic_uint_fast64_t processed;
+    atomic_uint_fast64_t signal_ms;
+};
+
+static void load_task(void *arg, uint32_t worker);
+
+static uint32_t round_up_updates(uint32_t samples) {
+    uint32_t n = PPG_VARIANT_UPDATE_SAMPLES;
+    return (samples + n - 1) / n * n;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Record done (or failed): publish the result, release it and start loading another
+static void finish_job(Job_t *job, int status, const PPGScore_Result_t *result, uint32_t worker) {
+    Engine_t *e = job->engine;
+    BatchReplay_RecordResult_t *out = &e->results[job->index];
+    out->status = status;
+    if (status == 0) {
+        out->result = *result;
+        out->samples = job->rec.count;
+        atomic_fetch_add(&e->samples, job->rec.count);
+        atomic_fetch_add(&e->signal_ms, (uint64_t)(job->rec.count * 1000.0 / job->rec.sample_rate_hz + 0.5));
+    }
+    PPGScore_FreeRecord(&job->rec);
+    free(job->state);
+    free(job->chunk_results);
+    free(job);
+    if (atomic_load(&e->next_record) < e->records) {
+        WorkPool_Spawn(&e->pool, worker, load_task, e);
+    }
+}
+
+static void chunk_range(const Job_t *job, uint32_t chunk, uint32_t *start, uint32_t *end) {
+    uint32_t size = job->engine->chunk_samples;
+    *start = chunk * size;
+    *end = (job->rec.count - *start > size) ? *start + size : job->rec.count;
+}
+
+// Hand-off: run one chunk on the record's state, then queue the next one
+static void handoff_task(void *arg, uint32_t worker) {
+    Chunk_t *c = (Chunk_t *)arg;
+    Job_t *job = c->job;
+    Engine_t *e = job->engine;
+    PPGScore_Result_t *result = &job->chunk_results[0];
+    uint32_t start, end;
+    chunk_range(job, c->chunk, &start, &end);
+    for (uint32_t i = start; i < end; i++) {
+        PPGVariant_Output_t out;
+        if (e->variant->process(job->state, job->rec.red[i], job->rec.ir[i], &out)) {
+            PPGScore_Update(result, &job->rec, i, &out);
+        }
+    }
+    atomic_fetch_add(&e->processed, end - start);
+
+    c->chunk++;
+    if (c->chunk < job->chunks) {
+        if (WorkPool_Spawn(&e->pool, worker, handoff_task, c) != 0) {
+            free(c);
+            finish_job(job, -1, NULL, worker);
+        }
+        return;
+    }
+    free(c);
+    finish_job(job, 0, result, worker);
+}
+
+// One warm-up task of the record done; the last one merges in record order
+static void warmup_done(Job_t *job, uint32_t worker) {
+    if (atomic_fetch_sub(&job->remaining, 1) != 1) {
+        return;
+    }
+    if (atomic_load(&job->failed)) {
+        finish_job(job, -1, NULL, worker);
+        return;
+    }
+    PPGScore_Result_t total = job->chunk_results[0];
+    for (uint32_t k = 1; k < job->chunks; k++) {
+        PPGScore_Merge(&total, &job->chunk_results[k]);
+    }
+    finish_job(job, 0, &total, worker);
+}
+
+// Warm-up: run one chunk from a fresh state in this worker's scratch block
+static void warmup_task(void *arg, uint32_t worker) {
+    Chunk_t *c = (Chunk_t *)arg;
+    Job_t *job = c->job;
+    Engine_t *e = job->engine;
+    void *state = e->scratch + (size_t)worker * e->group * e->variant->state_size;
+    PPGScore_Result_t *result = &job->chunk_results[c->chunk];
+    uint32_t start, end;
+    chunk_range(job, c->chunk, &start, &end);
+    uint32_t from = (start > e->warmup_samples) ? start - e->warmup_samples : 0;
+    free(c);
+
+    PPGScore_Begin(result);
+    e->variant->init(state, job->rec.sample_rate_hz);
+    for (uint32_t i = from; i < end; i++) {
+        PPGVariant_Output_t out;
+        if (e->variant->process(state, job->rec.red[i], job->rec.ir[i], &out) && i >= start) {
+            PPGScore_Update(result, &job->rec, i, &out);
+        }
+    }
+    atomic_fetch_add(&e->processed, end - from);
+    warmup_done(job, worker);
+}
+
+// Filtered warm-up: a group of chunks in lockstep, from fresh states, with
+// their red/IR filters in this worker's FilterBatch. A chunk whose samples
+// run out is masked off; every chunk sees exactly what warmup_task feeds it.
+static void filtered_task(void *arg, uint32_t worker) {
+    Chunk_t *c = (Chunk_t *)arg;
+    Job_t *job = c->job;
+    Engine_t *e = job->engine;
+    const uint32_t first = c->chunk;
+    const uint32_t n = (job->chunks - first < e->group) ? job->chunks - first : e->group;
+    free(c);
+
+    FilterBatch_t *fb = &e->filters[worker];
+    uint8_t *states = e->scratch + (size_t)worker * e->group * e->variant->state_size;
+    uint32_t from[BATCH_REPLAY_FILTER_GROUP], start[BATCH_REPLAY_FILTER_GROUP], end[BATCH_REPLAY_FILTER_GROUP];
+    uint32_t steps = 0;
+    uint64_t processed = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        chunk_range(job, first + k, &start[k], &end[k]);
+        from[k] = (start[k] > e->warmup_samples) ? start[k] - e->warmup_samples : 0;
+        steps = (end[k] - from[k] > steps) ? end[k] - from[k] : steps;
+        processed += end[k] - from[k];
+        PPGScore_Begin(&job->chunk_results[first + k]);
+        e->variant->init(states + (size_t)k * e->variant->state_size, job->rec.sample_rate_hz);
+        FilterBatch_LoadLane(fb, 2 * k, &e->fresh_filter);
+        FilterBatch_LoadLane(fb, 2 * k + 1, &e->fresh_filter);
+    }
+
+    uint32_t raw[2 * BATCH_REPLAY_FILTER_GROUP];
+    int32_t active[2 * BATCH_REPLAY_FILTER_GROUP];
+    float ac[2 * BATCH_REPLAY_FILTER_GROUP], dc[2 * BATCH_REPLAY_FILTER_GROUP];
+    for (uint32_t j = 0; j < steps; j++) {
+        for (uint32_t k = 0; k < e->group; k++) {
+            uint32_t i = (k < n) ? from[k] + j : 0;
+            int32_t on = (k < n && i < end[k]);
+            raw[2 * k] = on ? job->rec.red[i] : 0;
+            raw[2 * k + 1] = on ? job->rec.ir[i] : 0;
+            active[2 * k] = active[2 * k + 1] = on;
+        }
+        FilterBatch_Process(fb, raw, active, ac, dc);
+        for (uint32_t k = 0; k < n; k++) {
+            uint32_t i = from[k] + j;
+            if (i >= end[k]) {
+                continue;
+            }
+            PPGVariant_Filtered_t in = { { ac[2 * k], ac[2 * k + 1] }, { dc[2 * k], dc[2 * k + 1] } };
+            PPGVariant_Output_t out;
+            if (e->variant->process_filtered(states + (size_t)k * e->variant->state_size, &in, &out) &&
+                i >= start[k]) {
+                PPGScore_Update(&job->chunk_results[first + k], &job->rec, i, &out);
+            }
+        }
+    }
+    atomic_fetch_add(&e->processed, processed);
+    warmup_done(job, worker);
+}
+
+// Load the next record and queue its chunks
+static void load_task(void *arg, uint32_t worker) {
+    Engine_t *e = (Engine_t *)arg;
+    uint32_t index = atomic_fetch_add(&e->next_record, 1);
+    if (index >= e->records) {
+        return;
+    }
+    Job_t *job = (Job_t *)calloc(1, sizeof(Job_t));
+    if (job == NULL) {
+        WorkPool_Spawn(&e->pool, worker, load_task, e);
+        return;
+    }
+    job->engine = e;
+    job->index = index;
+    if (e->load(e->ctx, index, &job->rec) != 0) {
+        free(job);
+        WorkPool_Spawn(&e->pool, worker, load_task, e);
+        return;
+    }
+    snprintf(e->results[index].name, sizeof(e->results[index].name), "%s", job->rec.name);
+    job->chunks = (job->rec.count + e->chunk_samples - 1) / e->chunk_samples;
+    if (job->chunks == 0) {
+        job->chunks = 1;
+    }
+
+    if (e->warmup_samples == 0) {
+        Chunk_t *c = (Chunk_t *)malloc(sizeof(Chunk_t));
+        job->state = malloc(e->variant->state_size);
+        job->chunk_results = (PPGScore_Result_t *)malloc(sizeof(PPGScore_Result_t));
+        if (c == NULL || job->state == NULL || job->chunk_results == NULL) {
+            free(c);
+            finish_job(job, -1, NULL, worker);
+            return;
+        }
+        e->variant->init(job->state, job->rec.sample_rate_hz);
+        PPGScore_Begin(&job->chunk_results[0]);
+        *c = (Chunk_t){ job, 0 };
+        if (WorkPool_Spawn(&e->pool, worker, handoff_task, c) != 0) {
+            free(c);
+            finish_job(job, -1, NULL, worker);
+        }
+        return;
+    }
+
+    job->chunk_results = (PPGScore_Result_t *)malloc(job->chunks * sizeof(PPGScore_Result_t));
+    if (job->chunk_results == NULL) {
+        finish_job(job, -1, NULL, worker);
+        return;
+    }
+    // One task per chunk, or per group of chunks when filtered
+    uint32_t tasks = (job->chunks + e->group - 1) / e->group;
+    WorkPool_Fn_t task = (e->filters != NULL) ? filtered_task : warmup_task;
+    atomic_init(&job->remaining, tasks);
+    atomic_init(&job->failed, 0);
+    // Pushed last-first: the owner pops the first chunk next, thieves take the last ones
+    for (uint32_t k = tasks; k-- > 0;) {
+        Chunk_t *c = (Chunk_t *)malloc(sizeof(Chunk_t));
+        if (c != NULL) {
+            *c = (Chunk_t){ job, k * e->group };
+        }
+        if (c == NULL || WorkPool_Spawn(&e->pool, worker, task, c) != 0) {
+            // Chunks already queued still run; the record fails when the last one ends
+            free(c);
+            atomic_store(&job->failed, 1);
+            if (atomic_fetch_sub(&job->remaining, 1) == 1) {
+                finish_job(job, -1, NULL, worker);
+            }
+        }
+    }
+}
+
+static void free_filters(FilterBatch_t *filters, uint32_t threads) {
+    if (filters == NULL) {
+        return;
+    }
+    for (uint32_t w = 0; w < threads; w++) {
+        FilterBatch_Free(&filters[w]);
+    }
+    free(filters);
+}
+
+// One FilterBatch per worker, with the best SIMD kernel here
+static FilterBatch_t *alloc_filters(uint32_t threads, uint32_t group) {
+    FilterBatch_t *filters = (FilterBatch_t *)calloc(threads, sizeof(FilterBatch_t));
+    if (filters == NULL) {
+        return NULL;
+    }
+    for (uint32_t w = 0; w < threads; w++) {
+        if (FilterBatch_Init(&filters[w], 2 * group, SimdIsa_Best()) != 0) {
+            free_filters(filters, threads);
+            return NULL;
+        }
+    }
+    return filters;
+}
+
+/**
+ * Replay records 0..records-1 and score them; results[i] is record i.
+ * @return number of records that failed, -1 if the pool cannot be started
+ */
+int BatchReplay_Run(const BatchReplay_Config_t *config, BatchReplay_Load_t load, void *ctx,
+                    uint32_t records, BatchReplay_RecordResult_t *results, BatchReplay_Stats_t *stats) {
+    static Engine_t zero;
+    Engine_t *e = (Engine_t *)malloc(sizeof(Engine_t));
+    if (e == NULL) {
+        return -1;
+    }
+    *e = zero;
+    e->variant = config->variant;
+    e->chunk_samples = round_up_updates(config->chunk_samples ? config->chunk_samples
+                                                              : BATCH_REPLAY_DEFAULT_CHUNK_SAMPLES);
+    e->warmup_samples = round_up_updates(config->warmup_samples);
+    e->load = load;
+    e->ctx = ctx;
+    e->records = records;
+    e->results = results;
+    atomic_init(&e->next_record, 0);
+    atomic_init(&e->samples, 0);
+    atomic_init(&e->processed, 0);
+    atomic_init(&e->signal_ms, 0);
+    memset(results, 0, records * sizeof(BatchReplay_RecordResult_t));
+    for (uint32_t i = 0; i < records; i++) {
+        results[i].status = -1;     // until the record is scored
+    }
+
+    if (WorkPool_Init(&e->pool, config->threads) != 0) {
+        free(e);
+        return -1;
+    }
+    uint32_t threads = e->pool.workers;
+    e->group = 1;
+    if (e->warmup_samples > 0) {
+        if (config->filter_batch && e->variant->process_filtered != NULL) {
+            e->group = BATCH_REPLAY_FILTER_GROUP;
+            e->filters = alloc_filters(threads, e->group);
+            PPG_Filter_Init(&e->fresh_filter);
+        }
+        e->scratch = (uint8_t *)malloc((size_t)threads * e->group * e->variant->state_size);
+        if (e->scratch == NULL || (e->group > 1 && e->filters == NULL)) {
+            free_filters(e->filters, threads);
+            free(e->scratch);
+            WorkPool_Destroy(&e->pool);
+            free(e);
+            return -1;
+        }
+    }
+
+    double t0 = now_s();
+    // One loader per worker; every finished record queues the next load
+    for (uint32_t i = 0; i < threads && i < records; i++) {
+        WorkPool_Submit(&e->pool, load_task, e);
+    }
+    WorkPool_Wait(&e->pool);
+    double wall_s = now_s() - t0;
+
+    memset(stats, 0, sizeof(BatchReplay_Stats_t));
+    stats->samples = atomic_load(&e->samples);
+    stats->processed = atomic_load(&e->processed);
+    stats->signal_s = atomic_load(&e->signal_ms) / 1000.0;
+    stats->wall_s = wall_s;
+    stats->threads = threads;
+    for (uint32_t w = 0; w < threads; w++) {
+        stats->tasks += e->pool.deques[w].executed;
+        stats->steals += e->pool.deques[w].stolen;
+    }
+    WorkPool_Destroy(&e->pool);
+
+    int failed = 0;
+    for (uint32_t i = 0; i < records; i++) {
+        failed += (results[i].status != 0);
+    }
+    free_filters(e->filters, threads);
+    free(e->scratch);
+    free(e);
+    return failed;
+}
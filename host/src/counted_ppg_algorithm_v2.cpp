@@ -0,0 +1,4 @@
+// ppg_algorithm_v2.c compiled as C++ with every float and integer operation counted (see op_count.h)
+#define OP_COUNT_INTEGERS
+#include "op_count.h"
+#include "../../Core/Src/ppg_algorithm_v2.c"
@@ -0,0 +1,456 @@
+/**
+ * @file dpt_batch.c
+ * @brief Sliding DPT of many streams at once, structure-of-arrays, SIMD
+ */
+
+#include "dpt_batch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DPT_BATCH_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DPT_BATCH_NEON
+#endif
+
+#define PI                      3.14159265358979323846f     // ppg_algorithm_v2.c
+#define TWO_PI                  (2.0f * PI)
+#define ALIGNMENT               64
+
+// Buffer row leaving the window of a period, given the row just written
+static inline uint32_t old_row(uint32_t current, uint32_t period_idx) {
+    uint32_t period = DPT_MIN_PERIOD + period_idx;
+    return (current + DPT_BUFFER_SIZE - period + 1) % DPT_BUFFER_SIZE;
+}
+
+/* ==================== Portable C ==================== */
+
+static void transform_scalar(DPTBatch_t *b, uint32_t current, int masked) {
+    const uint32_t lanes = b->lanes;
+    const int32_t *x_new = b->buffer + (size_t)current * lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const int32_t *x_old = b->buffer + (size_t)old_row(current, p) * lanes;
+        float *re = b->real + (size_t)p * lanes;
+        float *im = b->imag + (size_t)p * lanes;
+        const float c = b->cos_basis[p], s = b->sin_basis[p];
+        for (uint32_t l = 0; l < lanes; l++) {
+            if (masked && !b->full[l]) {
+                continue;
+            }
+            float real_updated = re[l] - (float)x_old[l] + (float)x_new[l];
+            float imag_updated = im[l];
+            re[l] = real_updated * c - imag_updated * s;
+            im[l] = real_updated * s + imag_updated * c;
+        }
+    }
+}
+
+static void spectrum_scalar(DPTBatch_t *b) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const float *re = b->real + (size_t)p * lanes;
+        const float *im = b->imag + (size_t)p * lanes;
+        float *mag = b->magnitude + (size_t)p * lanes;
+        const float period = (float)(DPT_MIN_PERIOD + p);
+        for (uint32_t l = 0; l < lanes; l++) {
+            mag[l] = sqrtf(re[l] * re[l] + im[l] * im[l]) / period;
+        }
+    }
+}
+
+// Per lane: the first index of the largest magnitude (strictly greater, from 0.0f)
+static void peak_scalar(const DPTBatch_t *b, float *max_out, int32_t *index_out) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t l = 0; l < lanes; l++) {
+        max_out[l] = 0.0f;
+        index_out[l] = 0;
+    }
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const float *mag = b->magnitude + (size_t)p * lanes;
+        for (uint32_t l = 0; l < lanes; l++) {
+            if (mag[l] > max_out[l]) {
+                max_out[l] = mag[l];
+                index_out[l] = (int32_t)p;
+            }
+        }
+    }
+}
+
+/* ==================== AVX2 / AVX-512 ==================== */
+
+#ifdef DPT_BATCH_X86
+
+__attribute__((target("avx2")))
+static void transform_avx2(DPTBatch_t *b, uint32_t current, int masked) {
+    const uint32_t lanes = b->lanes;
+    const int32_t *x_new = b->buffer + (size_t)current * lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const int32_t *x_old = b->buffer + (size_t)old_row(current, p) * lanes;
+        float *re = b->real + (size_t)p * lanes;
+        float *im = b->imag + (size_t)p * lanes;
+        const __m256 c = _mm256_set1_ps(b->cos_basis[p]);
+        const __m256 s = _mm256_set1_ps(b->sin_basis[p]);
+        for (uint32_t l = 0; l < lanes; l += 8) {
+            __m256 real_prev = _mm256_load_ps(re + l);
+            __m256 imag_prev = _mm256_load_ps(im + l);
+            __m256 old = _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i *)(x_old + l)));
+            __m256 x = _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i *)(x_new + l)));
+            __m256 real_updated = _mm256_add_ps(_mm256_sub_ps(real_prev, old), x);
+            __m256 real_next = _mm256_sub_ps(_mm256_mul_ps(real_updated, c), _mm256_mul_ps(imag_prev, s));
+            __m256 imag_next = _mm256_add_ps(_mm256_mul_ps(real_updated, s), _mm256_mul_ps(imag_prev, c));
+            if (masked) {
+                __m256 full = _mm256_castsi256_ps(_mm256_load_si256((const __m256i *)(b->full + l)));
+                real_next = _mm256_blendv_ps(real_prev, real_next, full);
+                imag_next = _mm256_blendv_ps(imag_prev, imag_next, full);
+            }
+            _mm256_store_ps(re + l, real_next);
+            _mm256_store_ps(im + l, imag_next);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void spectrum_avx2(DPTBatch_t *b) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const float *re = b->real + (size_t)p * lanes;
+        const float *im = b->imag + (size_t)p * lanes;
+        float *mag = b->magnitude + (size_t)p * lanes;
+        const __m256 period = _mm256_set1_ps((float)(DPT_MIN_PERIOD + p));
+        for (uint32_t l = 0; l < lanes; l += 8) {
+            __m256 r = _mm256_load_ps(re + l);
+            __m256 i = _mm256_load_ps(im + l);
+            __m256 power = _mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(i, i));
+            _mm256_store_ps(mag + l, _mm256_div_ps(_mm256_sqrt_ps(power), period));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void peak_avx2(const DPTBatch_t *b, float *max_out, int32_t *index_out) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t l = 0; l < lanes; l += 8) {
+        __m256 best = _mm256_setzero_ps();
+        __m256 index = _mm256_setzero_ps();         // int32 bits
+        for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+            __m256 m = _mm256_load_ps(b->magnitude + (size_t)p * lanes + l);
+            __m256 greater = _mm256_cmp_ps(m, best, _CMP_GT_OQ);
+            best = _mm256_blendv_ps(best, m, greater);
+            index = _mm256_blendv_ps(index, _mm256_castsi256_ps(_mm256_set1_epi32((int32_t)p)), greater);
+        }
+        _mm256_store_ps(max_out + l, best);
+        _mm256_store_si256((__m256i *)(index_out + l), _mm256_castps_si256(index));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void transform_avx512(DPTBatch_t *b, uint32_t current, int masked) {
+    const uint32_t lanes = b->lanes;
+    const int32_t *x_new = b->buffer + (size_t)current * lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const int32_t *x_old = b->buffer + (size_t)old_row(current, p) * lanes;
+        float *re = b->real + (size_t)p * lanes;
+        float *im = b->imag + (size_t)p * lanes;
+        const __m512 c = _mm512_set1_ps(b->cos_basis[p]);
+        const __m512 s = _mm512_set1_ps(b->sin_basis[p]);
+        for (uint32_t l = 0; l < lanes; l += 16) {
+            __m512 real_prev = _mm512_load_ps(re + l);
+            __m512 imag_prev = _mm512_load_ps(im + l);
+            __m512 old = _mm512_cvtepi32_ps(_mm512_load_si512(x_old + l));
+            __m512 x = _mm512_cvtepi32_ps(_mm512_load_si512(x_new + l));
+            __m512 real_updated = _mm512_add_ps(_mm512_sub_ps(real_prev, old), x);
+            __m512 real_next = _mm512_sub_ps(_mm512_mul_ps(real_updated, c), _mm512_mul_ps(imag_prev, s));
+            __m512 imag_next = _mm512_add_ps(_mm512_mul_ps(real_updated, s), _mm512_mul_ps(imag_prev, c));
+            if (masked) {
+                __mmask16 full = _mm512_cmpneq_epi32_mask(_mm512_load_si512(b->full + l), _mm512_setzero_si512());
+                real_next = _mm512_mask_blend_ps(full, real_prev, real_next);
+                imag_next = _mm512_mask_blend_ps(full, imag_prev, imag_next);
+            }
+            _mm512_store_ps(re + l, real_next);
+            _mm512_store_ps(im + l, imag_next);
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void spectrum_avx512(DPTBatch_t *b) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const float *re = b->real + (size_t)p * lanes;
+        const float *im = b->imag + (size_t)p * lanes;
+        float *mag = b->magnitude + (size_t)p * lanes;
+        const __m512 period = _mm512_set1_ps((float)(DPT_MIN_PERIOD + p));
+        for (uint32_t l = 0; l < lanes; l += 16) {
+            __m512 r = _mm512_load_ps(re + l);
+            __m512 i = _mm512_load_ps(im + l);
+            __m512 power = _mm512_add_ps(_mm512_mul_ps(r, r), _mm512_mul_ps(i, i));
+            _mm512_store_ps(mag + l, _mm512_div_ps(_mm512_sqrt_ps(power), period));
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void peak_avx512(const DPTBatch_t *b, float *max_out, int32_t *index_out) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t l = 0; l < lanes; l += 16) {
+        __m512 best = _mm512_setzero_ps();
+        __m512i index = _mm512_setzero_si512();
+        for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+            __m512 m = _mm512_load_ps(b->magnitude + (size_t)p * lanes + l);
+            __mmask16 greater = _mm512_cmp_ps_mask(m, best, _CMP_GT_OQ);
+            best = _mm512_mask_blend_ps(greater, best, m);
+            index = _mm512_mask_blend_epi32(greater, index, _mm512_set1_epi32((int32_t)p));
+        }
+        _mm512_store_ps(max_out + l, best);
+        _mm512_store_si512(index_out + l, index);
+    }
+}
+
+#endif // DPT_BATCH_X86
+
+/* ==================== NEON (AArch64) ==================== */
+
+#ifdef DPT_BATCH_NEON
+
+static void transform_neon(DPTBatch_t *b, uint32_t current, int masked) {
+    const uint32_t lanes = b->lanes;
+    const int32_t *x_new = b->buffer + (size_t)current * lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const int32_t *x_old = b->buffer + (size_t)old_row(current, p) * lanes;
+        float *re = b->real + (size_t)p * lanes;
+        float *im = b->imag + (size_t)p * lanes;
+        const float32x4_t c = vdupq_n_f32(b->cos_basis[p]);
+        const float32x4_t s = vdupq_n_f32(b->sin_basis[p]);
+        for (uint32_t l = 0; l < lanes; l += 4) {
+            float32x4_t real_prev = vld1q_f32(re + l);
+            float32x4_t imag_prev = vld1q_f32(im + l);
+            float32x4_t old = vcvtq_f32_s32(vld1q_s32(x_old + l));
+            float32x4_t x = vcvtq_f32_s32(vld1q_s32(x_new + l));
+            float32x4_t real_updated = vaddq_f32(vsubq_f32(real_prev, old), x);
+            float32x4_t real_next = vsubq_f32(vmulq_f32(real_updated, c), vmulq_f32(imag_prev, s));
+            float32x4_t imag_next = vaddq_f32(vmulq_f32(real_updated, s), vmulq_f32(imag_prev, c));
+            if (masked) {
+                uint32x4_t full = vreinterpretq_u32_s32(vld1q_s32(b->full + l));
+                real_next = vbslq_f32(full, real_next, real_prev);
+                imag_next = vbslq_f32(full, imag_next, imag_prev);
+            }
+            vst1q_f32(re + l, real_next);
+            vst1q_f32(im + l, imag_next);
+        }
+    }
+}
+
+static void spectrum_neon(DPTBatch_t *b) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        const float *re = b->real + (size_t)p * lanes;
+        const float *im = b->imag + (size_t)p * lanes;
+        float *mag = b->magnitude + (size_t)p * lanes;
+        const float32x4_t period = vdupq_n_f32((float)(DPT_MIN_PERIOD + p));
+        for (uint32_t l = 0; l < lanes; l += 4) {
+            float32x4_t r = vld1q_f32(re + l);
+            float32x4_t i = vld1q_f32(im + l);
+            float32x4_t power = vaddq_f32(vmulq_f32(r, r), vmulq_f32(i, i));
+            vst1q_f32(mag + l, vdivq_f32(vsqrtq_f32(power), period));
+        }
+    }
+}
+
+static void peak_neon(const DPTBatch_t *b, float *max_out, int32_t *index_out) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t l = 0; l < lanes; l += 4) {
+        float32x4_t best = vdupq_n_f32(0.0f);
+        int32x4_t index = vdupq_n_s32(0);
+        for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+            float32x4_t m = vld1q_f32(b->magnitude + (size_t)p * lanes + l);
+            uint32x4_t greater = vcgtq_f32(m, best);
+            best = vbslq_f32(greater, m, best);
+            index = vbslq_s32(greater, vdupq_n_s32((int32_t)p), index);
+        }
+        vst1q_f32(max_out + l, best);
+        vst1q_s32(index_out + l, index);
+    }
+}
+
+#endif // DPT_BATCH_NEON
+
+/* ==================== Dispatch ==================== */
+
+static void transform(DPTBatch_t *b, uint32_t current, int masked) {
+    switch (b->isa) {
+#ifdef DPT_BATCH_X86
+    case SIMD_ISA_AVX2:
+        transform_avx2(b, current, masked);
+        return;
+    case SIMD_ISA_AVX512:
+        transform_avx512(b, current, masked);
+        return;
+#endif
+#ifdef DPT_BATCH_NEON
+    case SIMD_ISA_NEON:
+        transform_neon(b, current, masked);
+        return;
+#endif
+    default:
+        transform_scalar(b, current, masked);
+        return;
+    }
+}
+
+/* ==================== Public interface ==================== */
+
+/**
+ * Allocate the arrays for `streams` streams, all empty.
+ * @return 0, -1 if out of memory or the kernel is not supported here
+ */
+int DPTBatch_Init(DPTBatch_t *b, uint32_t streams, uint32_t isa) {
+    memset(b, 0, sizeof(DPTBatch_t));
+    if (streams == 0 || !SimdIsa_Supported(isa)) {
+        return -1;
+    }
+    b->streams = streams;
+    b->lanes = (streams + DPT_BATCH_LANE_ALIGN - 1) / DPT_BATCH_LANE_ALIGN * DPT_BATCH_LANE_ALIGN;
+    b->isa = isa;
+    size_t spectrum_bytes = (size_t)DPT_PERIOD_RANGE * b->lanes * sizeof(float);
+    size_t buffer_bytes = (size_t)DPT_BUFFER_SIZE * b->lanes * sizeof(int32_t);
+    b->real = (float *)aligned_alloc(ALIGNMENT, spectrum_bytes);
+    b->imag = (float *)aligned_alloc(ALIGNMENT, spectrum_bytes);
+    b->magnitude = (float *)aligned_alloc(ALIGNMENT, spectrum_bytes);
+    b->buffer = (int32_t *)aligned_alloc(ALIGNMENT, buffer_bytes);
+    b->full = (int32_t *)aligned_alloc(ALIGNMENT, b->lanes * sizeof(int32_t));
+    b->sample_count = (uint16_t *)calloc(b->lanes, sizeof(uint16_t));
+    if (b->real == NULL || b->imag == NULL || b->magnitude == NULL || b->buffer == NULL ||
+        b->full == NULL || b->sample_count == NULL) {
+        DPTBatch_Free(b);
+        return -1;
+    }
+    memset(b->real, 0, spectrum_bytes);
+    memset(b->imag, 0, spectrum_bytes);
+    memset(b->magnitude, 0, spectrum_bytes);
+    memset(b->buffer, 0, buffer_bytes);
+    memset(b->full, 0, b->lanes * sizeof(int32_t));
+
+    // As precompute_basis_functions()
+    for (uint16_t period_idx = 0; period_idx < DPT_PERIOD_RANGE; period_idx++) {
+        uint16_t period = DPT_MIN_PERIOD + period_idx;
+        float phase_increment = -TWO_PI / (float)period;
+        b->cos_basis[period_idx] = cosf(phase_increment);
+        b->sin_basis[period_idx] = sinf(phase_increment);
+    }
+    return 0;
+}
+
+void DPTBatch_Free(DPTBatch_t *b) {
+    free(b->real);
+    free(b->imag);
+    free(b->magnitude);
+    free(b->buffer);
+    free(b->full);
+    free(b->sample_count);
+    memset(b, 0, sizeof(DPTBatch_t));
+}
+
+// The scalar buffer is rotated so that its write position lines up with the shared one
+void DPTBatch_LoadLane(DPTBatch_t *b, uint32_t stream, const DPT_Transform_t *t) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        b->real[(size_t)p * lanes + stream] = t->real[p];
+        b->imag[(size_t)p * lanes + stream] = t->imag[p];
+        b->magnitude[(size_t)p * lanes + stream] = t->magnitude[p];
+    }
+    for (uint32_t k = 0; k < DPT_BUFFER_SIZE; k++) {
+        uint32_t row = (b->buffer_index + k) % DPT_BUFFER_SIZE;
+        b->buffer[(size_t)row * lanes + stream] = t->recursive_buffer[(t->buffer_index + k) % DPT_BUFFER_SIZE];
+    }
+    b->sample_count[stream] = t->sample_count;
+    int32_t full = t->buffer_full ? -1 : 0;
+    if (full != b->full[stream]) {
+        b->full_lanes += full ? 1 : (uint32_t)-1;
+        b->full[stream] = full;
+    }
+}
+
+void DPTBatch_StoreLane(const DPTBatch_t *b, uint32_t stream, DPT_Transform_t *t) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) {
+        t->real[p] = b->real[(size_t)p * lanes + stream];
+        t->imag[p] = b->imag[(size_t)p * lanes + stream];
+        t->magnitude[p] = b->magnitude[(size_t)p * lanes + stream];
+    }
+    for (uint32_t row = 0; row < DPT_BUFFER_SIZE; row++) {
+        t->recursive_buffer[row] = b->buffer[(size_t)row * lanes + stream];
+    }
+    t->buffer_index = b->buffer_index;
+    t->sample_count = b->sample_count[stream];
+    t->buffer_full = b->full[stream] != 0;
+}
+
+void DPTBatch_Process(DPTBatch_t *b, const int32_t *ac) {
+    uint32_t current = b->buffer_index;
+    int32_t *row = b->buffer + (size_t)current * b->lanes;
+    memcpy(row, ac, b->streams * sizeof(int32_t));
+    b->buffer_index = (uint16_t)((current + 1) % DPT_BUFFER_SIZE);
+    for (uint32_t l = 0; l < b->streams; l++) {
+        b->sample_count[l]++;
+        if (!b->full[l] && b->sample_count[l] >= DPT_BUFFER_SIZE) {
+            b->full[l] = -1;
+            b->full_lanes++;
+        }
+    }
+    if (b->full_lanes == 0) {
+        return;
+    }
+    // Padding lanes never fill, so a full batch of real streams still needs the mask
+    transform(b, current, b->full_lanes < b->lanes);
+}
+
+void DPTBatch_Spectrum(DPTBatch_t *b) {
+    switch (b->isa) {
+#ifdef DPT_BATCH_X86
+    case SIMD_ISA_AVX2:
+        spectrum_avx2(b);
+        return;
+    case SIMD_ISA_AVX512:
+        spectrum_avx512(b);
+        return;
+#endif
+#ifdef DPT_BATCH_NEON
+    case SIMD_ISA_NEON:
+        spectrum_neon(b);
+        return;
+#endif
+    default:
+        spectrum_scalar(b);
+        return;
+    }
+}
+
+void DPTBatch_PeakPeriods(const DPTBatch_t *b, float min_magnitude, uint16_t *periods) {
+    float best[b->lanes] __attribute__((aligned(ALIGNMENT)));
+    int32_t index[b->lanes] __attribute__((aligned(ALIGNMENT)));
+    switch (b->isa) {
+#ifdef DPT_BATCH_X86
+    case SIMD_ISA_AVX2:
+        peak_avx2(b, best, index);
+        break;
+    case SIMD_ISA_AVX512:
+        peak_avx512(b, best, index);
+        break;
+#endif
+#ifdef DPT_BATCH_NEON
+    case SIMD_ISA_NEON:
+        peak_neon(b, best, index);
+        break;
+#endif
+    default:
+        peak_scalar(b, best, index);
+        break;
+    }
+    // As find_peak_period()
+    for (uint32_t l = 0; l < b->streams; l++) {
+        periods[l] = (best[l] < min_magnitude) ? 0 : (uint16_t)(DPT_MIN_PERIOD + index[l]);
+    }
+}
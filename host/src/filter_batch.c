@@ -0,0 +1,535 @@
+/**
+ * @file filter_batch.c
+ * @brief PPG_Filter_Process for many channels at once, structure-of-arrays, SIMD
+ */
+
+#include "filter_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_BATCH_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define FILTER_BATCH_NEON
+#endif
+
+#define ALIGNMENT       64
+#define ADC_MAX         262143u         // 18-bit saturation, as PPG_Filter_Process
+#define CLAMP           100000.0f       // per section, as PPG_Filter_Process
+
+// butterworth_sos in ppg_filter.c (filter_batch_test checks the outputs bit for bit)
+static const BiquadCoeff_t sos[NUM_SOS_SECTIONS] = {
+    { .b0 = 0.00743916f, .b1 = 0.0f, .b2 = -0.00743916f, .a1 = -1.86319070f, .a2 = 0.87439781f },
+    { .b0 = 1.0f,        .b1 = 0.0f, .b2 = -1.0f,        .a1 = -1.94632328f, .a2 = 0.95124514f },
+};
+
+static inline float *section_x1(const FilterBatch_t *b, uint32_t section) {
+    return b->biquad + (size_t)(2 * section) * b->lanes;
+}
+
+static inline float *section_x2(const FilterBatch_t *b, uint32_t section) {
+    return b->biquad + (size_t)(2 * section + 1) * b->lanes;
+}
+
+/* ==================== Portable C ==================== */
+
+// PPG_Filter_Process steps 1-3 on each active lane
+static void step_scalar(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t l = 0; l < lanes; l++) {
+        if (active != NULL && !active[l]) {
+            continue;
+        }
+        float value = (float)(raw[l] > ADC_MAX ? ADC_MAX : raw[l]);
+
+        float *slot = b->detrend_buffer + (size_t)b->detrend_index[l] * lanes + l;
+        if (b->detrend_filled[l]) {
+            b->detrend_sum[l] -= *slot;
+        }
+        *slot = value;
+        b->detrend_sum[l] += value;
+        if (++b->detrend_index[l] >= DETREND_WINDOW_SIZE) {
+            b->detrend_index[l] = 0;
+            b->detrend_filled[l] = -1;
+        }
+        uint16_t count = b->detrend_filled[l] ? DETREND_WINDOW_SIZE : (uint16_t)b->detrend_index[l];
+        float baseline = b->detrend_sum[l] / count;
+        b->dc[l] = baseline;
+
+        float filtered = value - baseline;
+        for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+            float *x1 = section_x1(b, s) + l;
+            float *x2 = section_x2(b, s) + l;
+            float output = sos[s].b0 * filtered + *x1;
+            *x1 = sos[s].b1 * filtered - sos[s].a1 * output + *x2;
+            *x2 = sos[s].b2 * filtered - sos[s].a2 * output;
+            filtered = output;
+            if (filtered > CLAMP) {
+                filtered = CLAMP;
+            } else if (filtered < -CLAMP) {
+                filtered = -CLAMP;
+            }
+        }
+
+        b->smooth_buffer[(size_t)b->smooth_index[l] * lanes + l] = filtered;
+        b->smooth_index[l] = (b->smooth_index[l] + 1) % SIGNAL_SMOOTH_SIZE;
+        float smoothed = 0.0f;
+        for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+            smoothed += b->smooth_buffer[(size_t)i * lanes + l];
+        }
+        smoothed /= SIGNAL_SMOOTH_SIZE;
+
+        ac[l] = smoothed;
+        dc[l] = baseline;
+    }
+}
+
+// dst[c][r] = src[r][c] for 8-byte elements (one {red, IR} frame), rows r0..r1, columns c0..c1
+static void transpose_scalar(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                             uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1) {
+    for (uint32_t r = r0; r < r1; r++) {
+        for (uint32_t c = c0; c < c1; c++) {
+            memcpy(dst + (c * dst_stride + r) * 8, src + (r * src_stride + c) * 8, 8);
+        }
+    }
+}
+
+/* ==================== AVX2 / AVX-512 ==================== */
+
+#ifdef FILTER_BATCH_X86
+
+__attribute__((target("avx2")))
+static void step_avx2(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    const uint32_t lanes = b->lanes;
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 clamp_hi = _mm256_set1_ps(CLAMP), clamp_lo = _mm256_set1_ps(-CLAMP);
+    for (uint32_t l = 0; l < lanes; l += 8) {
+        __m256i act = active ? _mm256_load_si256((const __m256i *)(active + l)) : _mm256_set1_epi32(-1);
+        int act_bits = _mm256_movemask_ps(_mm256_castsi256_ps(act));
+        if (act_bits == 0) {
+            continue;
+        }
+        __m256 actf = _mm256_castsi256_ps(act);
+        __m256i r = _mm256_min_epu32(_mm256_load_si256((const __m256i *)(raw + l)), _mm256_set1_epi32(ADC_MAX));
+        __m256 value = _mm256_cvtepi32_ps(r);
+
+        // Detrend: the slot each lane overwrites is gathered, then scattered to
+        __m256i idx = _mm256_load_si256((const __m256i *)(b->detrend_index + l));
+        __m256i filled = _mm256_load_si256((const __m256i *)(b->detrend_filled + l));
+        __m256i slot = _mm256_add_epi32(_mm256_mullo_epi32(idx, _mm256_set1_epi32((int32_t)lanes)),
+                                        _mm256_add_epi32(_mm256_set1_epi32((int32_t)l), iota));
+        __m256 old = _mm256_i32gather_ps(b->detrend_buffer, slot, 4);
+        __m256 sum = _mm256_load_ps(b->detrend_sum + l);
+        sum = _mm256_blendv_ps(sum, _mm256_sub_ps(sum, old), _mm256_castsi256_ps(filled));
+        sum = _mm256_add_ps(sum, value);
+        int32_t slots[8] __attribute__((aligned(32)));
+        float values[8] __attribute__((aligned(32)));
+        _mm256_store_si256((__m256i *)slots, slot);
+        _mm256_store_ps(values, value);
+        for (int j = 0; j < 8; j++) {
+            if (act_bits & (1 << j)) {
+                b->detrend_buffer[slots[j]] = values[j];
+            }
+        }
+        idx = _mm256_add_epi32(idx, one);
+        __m256i wrap = _mm256_cmpgt_epi32(idx, _mm256_set1_epi32(DETREND_WINDOW_SIZE - 1));
+        idx = _mm256_andnot_si256(wrap, idx);
+        filled = _mm256_or_si256(filled, wrap);
+        __m256 count = _mm256_blendv_ps(_mm256_cvtepi32_ps(idx), _mm256_set1_ps((float)DETREND_WINDOW_SIZE),
+                                        _mm256_castsi256_ps(filled));
+        __m256 baseline = _mm256_div_ps(sum, count);
+
+        // Butterworth sections, Direct Form II transposed, with the clamp
+        __m256 filtered = _mm256_sub_ps(value, baseline);
+        for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+            float *px1 = section_x1(b, s) + l;
+            float *px2 = section_x2(b, s) + l;
+            __m256 x1 = _mm256_load_ps(px1);
+            __m256 x2 = _mm256_load_ps(px2);
+            __m256 output = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sos[s].b0), filtered), x1);
+            __m256 nx1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(sos[s].b1), filtered),
+                                                     _mm256_mul_ps(_mm256_set1_ps(sos[s].a1), output)), x2);
+            __m256 nx2 = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(sos[s].b2), filtered),
+                                       _mm256_mul_ps(_mm256_set1_ps(sos[s].a2), output));
+            _mm256_store_ps(px1, _mm256_blendv_ps(x1, nx1, actf));
+            _mm256_store_ps(px2, _mm256_blendv_ps(x2, nx2, actf));
+            filtered = _mm256_max_ps(_mm256_min_ps(output, clamp_hi), clamp_lo);
+        }
+
+        // Smoothing: write the lane's slot and sum the window in slot order
+        __m256i sidx = _mm256_load_si256((const __m256i *)(b->smooth_index + l));
+        __m256 smoothed = _mm256_setzero_ps();
+        for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+            float *row = b->smooth_buffer + (size_t)i * lanes + l;
+            __m256 hit = _mm256_and_ps(actf, _mm256_castsi256_ps(_mm256_cmpeq_epi32(sidx, _mm256_set1_epi32((int32_t)i))));
+            __m256 v = _mm256_blendv_ps(_mm256_load_ps(row), filtered, hit);
+            _mm256_store_ps(row, v);
+            smoothed = _mm256_add_ps(smoothed, v);
+        }
+        smoothed = _mm256_div_ps(smoothed, _mm256_set1_ps((float)SIGNAL_SMOOTH_SIZE));
+        sidx = _mm256_add_epi32(sidx, one);
+        sidx = _mm256_andnot_si256(_mm256_cmpeq_epi32(sidx, _mm256_set1_epi32(SIGNAL_SMOOTH_SIZE)), sidx);
+
+        __m256i old_idx = _mm256_load_si256((const __m256i *)(b->detrend_index + l));
+        __m256i old_filled = _mm256_load_si256((const __m256i *)(b->detrend_filled + l));
+        __m256i old_sidx = _mm256_load_si256((const __m256i *)(b->smooth_index + l));
+        _mm256_store_si256((__m256i *)(b->detrend_index + l), _mm256_blendv_epi8(old_idx, idx, act));
+        _mm256_store_si256((__m256i *)(b->detrend_filled + l), _mm256_blendv_epi8(old_filled, filled, act));
+        _mm256_store_si256((__m256i *)(b->smooth_index + l), _mm256_blendv_epi8(old_sidx, sidx, act));
+        _mm256_store_ps(b->detrend_sum + l, _mm256_blendv_ps(_mm256_load_ps(b->detrend_sum + l), sum, actf));
+        _mm256_store_ps(b->dc + l, _mm256_blendv_ps(_mm256_load_ps(b->dc + l), baseline, actf));
+        _mm256_store_ps(ac + l, smoothed);
+        _mm256_store_ps(dc + l, baseline);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void step_avx512(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    const uint32_t lanes = b->lanes;
+    const __m512i iota = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512 clamp_hi = _mm512_set1_ps(CLAMP), clamp_lo = _mm512_set1_ps(-CLAMP);
+    for (uint32_t l = 0; l < lanes; l += 16) {
+        __mmask16 act = active ? _mm512_test_epi32_mask(_mm512_load_si512(active + l), _mm512_set1_epi32(-1))
+                               : (__mmask16)0xFFFF;
+        if (act == 0) {
+            continue;
+        }
+        __m512i r = _mm512_min_epu32(_mm512_load_si512(raw + l), _mm512_set1_epi32(ADC_MAX));
+        __m512 value = _mm512_cvtepi32_ps(r);
+
+        __m512i idx = _mm512_load_si512(b->detrend_index + l);
+        __mmask16 filled = _mm512_test_epi32_mask(_mm512_load_si512(b->detrend_filled + l), _mm512_set1_epi32(-1));
+        __m512i slot = _mm512_add_epi32(_mm512_mullo_epi32(idx, _mm512_set1_epi32((int32_t)lanes)),
+                                        _mm512_add_epi32(_mm512_set1_epi32((int32_t)l), iota));
+        __m512 old = _mm512_i32gather_ps(slot, b->detrend_buffer, 4);
+        __m512 sum = _mm512_load_ps(b->detrend_sum + l);
+        sum = _mm512_mask_sub_ps(sum, filled, sum, old);
+        sum = _mm512_add_ps(sum, value);
+        _mm512_mask_i32scatter_ps(b->detrend_buffer, act, slot, value, 4);
+        idx = _mm512_add_epi32(idx, one);
+        __mmask16 wrap = _mm512_cmpgt_epi32_mask(idx, _mm512_set1_epi32(DETREND_WINDOW_SIZE - 1));
+        idx = _mm512_mask_mov_epi32(idx, wrap, _mm512_setzero_si512());
+        filled |= wrap;
+        __m512 count = _mm512_mask_mov_ps(_mm512_cvtepi32_ps(idx), filled, _mm512_set1_ps((float)DETREND_WINDOW_SIZE));
+        __m512 baseline = _mm512_div_ps(sum, count);
+
+        __m512 filtered = _mm512_sub_ps(value, baseline);
+        for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+            float *px1 = section_x1(b, s) + l;
+            float *px2 = section_x2(b, s) + l;
+            __m512 x1 = _mm512_load_ps(px1);
+            __m512 x2 = _mm512_load_ps(px2);
+            __m512 output = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(sos[s].b0), filtered), x1);
+            __m512 nx1 = _mm512_add_ps(_mm512_sub_ps(_mm512_mul_ps(_mm512_set1_ps(sos[s].b1), filtered),
+                                                     _mm512_mul_ps(_mm512_set1_ps(sos[s].a1), output)), x2);
+            __m512 nx2 = _mm512_sub_ps(_mm512_mul_ps(_mm512_set1_ps(sos[s].b2), filtered),
+                                       _mm512_mul_ps(_mm512_set1_ps(sos[s].a2), output));
+            _mm512_store_ps(px1, _mm512_mask_mov_ps(x1, act, nx1));
+            _mm512_store_ps(px2, _mm512_mask_mov_ps(x2, act, nx2));
+            filtered = _mm512_max_ps(_mm512_min_ps(output, clamp_hi), clamp_lo);
+        }
+
+        __m512i sidx = _mm512_load_si512(b->smooth_index + l);
+        __m512 smoothed = _mm512_setzero_ps();
+        for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+            float *row = b->smooth_buffer + (size_t)i * lanes + l;
+            __mmask16 hit = act & _mm512_cmpeq_epi32_mask(sidx, _mm512_set1_epi32((int32_t)i));
+            __m512 v = _mm512_mask_mov_ps(_mm512_load_ps(row), hit, filtered);
+            _mm512_store_ps(row, v);
+            smoothed = _mm512_add_ps(smoothed, v);
+        }
+        smoothed = _mm512_div_ps(smoothed, _mm512_set1_ps((float)SIGNAL_SMOOTH_SIZE));
+        sidx = _mm512_add_epi32(sidx, one);
+        sidx = _mm512_mask_mov_epi32(sidx, _mm512_cmpeq_epi32_mask(sidx, _mm512_set1_epi32(SIGNAL_SMOOTH_SIZE)),
+                                     _mm512_setzero_si512());
+
+        _mm512_mask_store_epi32(b->detrend_index + l, act, idx);
+        _mm512_mask_store_epi32(b->detrend_filled + l, act & filled, _mm512_set1_epi32(-1));
+        _mm512_mask_store_epi32(b->smooth_index + l, act, sidx);
+        _mm512_mask_store_ps(b->detrend_sum + l, act, sum);
+        _mm512_mask_store_ps(b->dc + l, act, baseline);
+        _mm512_store_ps(ac + l, smoothed);
+        _mm512_store_ps(dc + l, baseline);
+    }
+}
+
+// dst[c][r] = src[r][c] for 8-byte elements, 4 x 4 tiles: two unpacks and a lane permute per row
+__attribute__((target("avx2")))
+static void transpose_avx2(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                           uint32_t rows, uint32_t cols) {
+    uint32_t rows4 = rows / 4 * 4, cols4 = cols / 4 * 4;
+    for (uint32_t r = 0; r < rows4; r += 4) {
+        for (uint32_t c = 0; c < cols4; c += 4) {
+            const uint8_t *s = src + ((size_t)r * src_stride + c) * 8;
+            __m256i r0 = _mm256_loadu_si256((const __m256i *)(s));
+            __m256i r1 = _mm256_loadu_si256((const __m256i *)(s + src_stride * 8));
+            __m256i r2 = _mm256_loadu_si256((const __m256i *)(s + src_stride * 16));
+            __m256i r3 = _mm256_loadu_si256((const __m256i *)(s + src_stride * 24));
+            __m256i t0 = _mm256_unpacklo_epi64(r0, r1);
+            __m256i t1 = _mm256_unpackhi_epi64(r0, r1);
+            __m256i t2 = _mm256_unpacklo_epi64(r2, r3);
+            __m256i t3 = _mm256_unpackhi_epi64(r2, r3);
+            uint8_t *d = dst + ((size_t)c * dst_stride + r) * 8;
+            _mm256_storeu_si256((__m256i *)(d), _mm256_permute2x128_si256(t0, t2, 0x20));
+            _mm256_storeu_si256((__m256i *)(d + dst_stride * 8), _mm256_permute2x128_si256(t1, t3, 0x20));
+            _mm256_storeu_si256((__m256i *)(d + dst_stride * 16), _mm256_permute2x128_si256(t0, t2, 0x31));
+            _mm256_storeu_si256((__m256i *)(d + dst_stride * 24), _mm256_permute2x128_si256(t1, t3, 0x31));
+        }
+    }
+    transpose_scalar(dst, dst_stride, src, src_stride, 0, rows4, cols4, cols);
+    transpose_scalar(dst, dst_stride, src, src_stride, rows4, rows, 0, cols);
+}
+
+#endif // FILTER_BATCH_X86
+
+/* ==================== NEON (AArch64) ==================== */
+
+#ifdef FILTER_BATCH_NEON
+
+static void step_neon(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    const uint32_t lanes = b->lanes;
+    const float32x4_t clamp_hi = vdupq_n_f32(CLAMP), clamp_lo = vdupq_n_f32(-CLAMP);
+    for (uint32_t l = 0; l < lanes; l += 4) {
+        uint32x4_t act = active ? vtstq_s32(vld1q_s32(active + l), vdupq_n_s32(-1)) : vdupq_n_u32(0xFFFFFFFFu);
+        if (vmaxvq_u32(act) == 0) {
+            continue;
+        }
+        float32x4_t value = vcvtq_f32_u32(vminq_u32(vld1q_u32(raw + l), vdupq_n_u32(ADC_MAX)));
+
+        // No gather on NEON: the ring slots are read and written one lane at a time
+        float old_v[4], value_v[4];
+        uint32_t act_v[4];
+        vst1q_f32(value_v, value);
+        vst1q_u32(act_v, act);
+        for (int j = 0; j < 4; j++) {
+            old_v[j] = b->detrend_buffer[(size_t)b->detrend_index[l + j] * lanes + l + j];
+        }
+        uint32x4_t filled = vreinterpretq_u32_s32(vld1q_s32(b->detrend_filled + l));
+        float32x4_t sum = vld1q_f32(b->detrend_sum + l);
+        sum = vbslq_f32(filled, vsubq_f32(sum, vld1q_f32(old_v)), sum);
+        sum = vaddq_f32(sum, value);
+        for (int j = 0; j < 4; j++) {
+            if (act_v[j]) {
+                b->detrend_buffer[(size_t)b->detrend_index[l + j] * lanes + l + j] = value_v[j];
+            }
+        }
+        int32x4_t idx = vaddq_s32(vld1q_s32(b->detrend_index + l), vdupq_n_s32(1));
+        uint32x4_t wrap = vcgtq_s32(idx, vdupq_n_s32(DETREND_WINDOW_SIZE - 1));
+        idx = vbslq_s32(wrap, vdupq_n_s32(0), idx);
+        filled = vorrq_u32(filled, wrap);
+        float32x4_t count = vbslq_f32(filled, vdupq_n_f32((float)DETREND_WINDOW_SIZE), vcvtq_f32_s32(idx));
+        float32x4_t baseline = vdivq_f32(sum, count);
+
+        float32x4_t filtered = vsubq_f32(value, baseline);
+        for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+            float *px1 = section_x1(b, s) + l;
+            float *px2 = section_x2(b, s) + l;
+            float32x4_t x1 = vld1q_f32(px1);
+            float32x4_t x2 = vld1q_f32(px2);
+            float32x4_t output = vaddq_f32(vmulq_n_f32(filtered, sos[s].b0), x1);
+            float32x4_t nx1 = vaddq_f32(vsubq_f32(vmulq_n_f32(filtered, sos[s].b1), vmulq_n_f32(output, sos[s].a1)), x2);
+            float32x4_t nx2 = vsubq_f32(vmulq_n_f32(filtered, sos[s].b2), vmulq_n_f32(output, sos[s].a2));
+            vst1q_f32(px1, vbslq_f32(act, nx1, x1));
+            vst1q_f32(px2, vbslq_f32(act, nx2, x2));
+            filtered = vmaxq_f32(vminq_f32(output, clamp_hi), clamp_lo);
+        }
+
+        int32x4_t sidx = vld1q_s32(b->smooth_index + l);
+        float32x4_t smoothed = vdupq_n_f32(0.0f);
+        for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+            float *row = b->smooth_buffer + (size_t)i * lanes + l;
+            uint32x4_t hit = vandq_u32(act, vceqq_s32(sidx, vdupq_n_s32((int32_t)i)));
+            float32x4_t v = vbslq_f32(hit, filtered, vld1q_f32(row));
+            vst1q_f32(row, v);
+            smoothed = vaddq_f32(smoothed, v);
+        }
+        smoothed = vdivq_f32(smoothed, vdupq_n_f32((float)SIGNAL_SMOOTH_SIZE));
+        sidx = vaddq_s32(sidx, vdupq_n_s32(1));
+        sidx = vbslq_s32(vceqq_s32(sidx, vdupq_n_s32(SIGNAL_SMOOTH_SIZE)), vdupq_n_s32(0), sidx);
+
+        vst1q_s32(b->detrend_index + l, vbslq_s32(act, idx, vld1q_s32(b->detrend_index + l)));
+        vst1q_s32(b->detrend_filled + l, vbslq_s32(act, vreinterpretq_s32_u32(filled), vld1q_s32(b->detrend_filled + l)));
+        vst1q_s32(b->smooth_index + l, vbslq_s32(act, sidx, vld1q_s32(b->smooth_index + l)));
+        vst1q_f32(b->detrend_sum + l, vbslq_f32(act, sum, vld1q_f32(b->detrend_sum + l)));
+        vst1q_f32(b->dc + l, vbslq_f32(act, baseline, vld1q_f32(b->dc + l)));
+        vst1q_f32(ac + l, smoothed);
+        vst1q_f32(dc + l, baseline);
+    }
+}
+
+#endif // FILTER_BATCH_NEON
+
+/* ==================== Dispatch ==================== */
+
+// One row: raw / active / ac / dc padded to lanes and aligned
+static void step(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    switch (b->isa) {
+#ifdef FILTER_BATCH_X86
+    case SIMD_ISA_AVX2:
+        step_avx2(b, raw, active, ac, dc);
+        return;
+    case SIMD_ISA_AVX512:
+        step_avx512(b, raw, active, ac, dc);
+        return;
+#endif
+#ifdef FILTER_BATCH_NEON
+    case SIMD_ISA_NEON:
+        step_neon(b, raw, active, ac, dc);
+        return;
+#endif
+    default:
+        step_scalar(b, raw, active, ac, dc);
+        return;
+    }
+}
+
+static void transpose(const FilterBatch_t *b, void *dst, size_t dst_stride, const void *src, size_t src_stride,
+                      uint32_t rows, uint32_t cols) {
+#ifdef FILTER_BATCH_X86
+    if (b->isa == SIMD_ISA_AVX2 || b->isa == SIMD_ISA_AVX512) {
+        transpose_avx2((uint8_t *)dst, dst_stride, (const uint8_t *)src, src_stride, rows, cols);
+        return;
+    }
+#endif
+    (void)b;
+    transpose_scalar((uint8_t *)dst, dst_stride, (const uint8_t *)src, src_stride, 0, rows, 0, cols);
+}
+
+/* ==================== Public interface ==================== */
+
+static void *alloc_zero(size_t bytes) {
+    void *p = aligned_alloc(ALIGNMENT, (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+    if (p != NULL) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+/**
+ * Allocate the state of `channels` channels, all as after PPG_Filter_Init.
+ * @return 0, -1 if out of memory or the kernel is not supported here
+ */
+int FilterBatch_Init(FilterBatch_t *b, uint32_t channels, uint32_t isa) {
+    memset(b, 0, sizeof(FilterBatch_t));
+    if (channels == 0 || !SimdIsa_Supported(isa)) {
+        return -1;
+    }
+    b->channels = channels;
+    b->lanes = (channels + FILTER_BATCH_LANE_ALIGN - 1) / FILTER_BATCH_LANE_ALIGN * FILTER_BATCH_LANE_ALIGN;
+    b->isa = isa;
+    size_t lane_bytes = b->lanes * sizeof(float);
+    b->detrend_buffer = (float *)alloc_zero(DETREND_WINDOW_SIZE * lane_bytes);
+    b->detrend_sum = (float *)alloc_zero(lane_bytes);
+    b->detrend_index = (int32_t *)alloc_zero(lane_bytes);
+    b->detrend_filled = (int32_t *)alloc_zero(lane_bytes);
+    b->biquad = (float *)alloc_zero(2 * NUM_SOS_SECTIONS * lane_bytes);
+    b->smooth_buffer = (float *)alloc_zero(SIGNAL_SMOOTH_SIZE * lane_bytes);
+    b->smooth_index = (int32_t *)alloc_zero(lane_bytes);
+    b->dc = (float *)alloc_zero(lane_bytes);
+    b->raw_rows = (uint32_t *)alloc_zero(FILTER_BATCH_TILE * lane_bytes);
+    b->active_row = (int32_t *)alloc_zero(lane_bytes);
+    b->ac_rows = (float *)alloc_zero(FILTER_BATCH_TILE * lane_bytes);
+    b->dc_rows = (float *)alloc_zero(FILTER_BATCH_TILE * lane_bytes);
+    if (b->detrend_buffer == NULL || b->detrend_sum == NULL || b->detrend_index == NULL ||
+        b->detrend_filled == NULL || b->biquad == NULL || b->smooth_buffer == NULL ||
+        b->smooth_index == NULL || b->dc == NULL || b->raw_rows == NULL || b->active_row == NULL ||
+        b->ac_rows == NULL || b->dc_rows == NULL) {
+        FilterBatch_Free(b);
+        return -1;
+    }
+    return 0;
+}
+
+void FilterBatch_Free(FilterBatch_t *b) {
+    free(b->detrend_buffer);
+    free(b->detrend_sum);
+    free(b->detrend_index);
+    free(b->detrend_filled);
+    free(b->biquad);
+    free(b->smooth_buffer);
+    free(b->smooth_index);
+    free(b->dc);
+    free(b->raw_rows);
+    free(b->active_row);
+    free(b->ac_rows);
+    free(b->dc_rows);
+    memset(b, 0, sizeof(FilterBatch_t));
+}
+
+void FilterBatch_LoadLane(FilterBatch_t *b, uint32_t channel, const PPG_FilterState_t *f) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t i = 0; i < DETREND_WINDOW_SIZE; i++) {
+        b->detrend_buffer[(size_t)i * lanes + channel] = f->detrend_buffer[i];
+    }
+    b->detrend_sum[channel] = f->detrend_sum;
+    b->detrend_index[channel] = f->detrend_index;
+    b->detrend_filled[channel] = f->detrend_filled ? -1 : 0;
+    for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+        section_x1(b, s)[channel] = f->biquad_states[s].x1;
+        section_x2(b, s)[channel] = f->biquad_states[s].x2;
+    }
+    for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+        b->smooth_buffer[(size_t)i * lanes + channel] = f->smooth_buffer[i];
+    }
+    b->smooth_index[channel] = f->smooth_index;
+    b->dc[channel] = f->dc_value;
+}
+
+void FilterBatch_StoreLane(const FilterBatch_t *b, uint32_t channel, PPG_FilterState_t *f) {
+    const uint32_t lanes = b->lanes;
+    for (uint32_t i = 0; i < DETREND_WINDOW_SIZE; i++) {
+        f->detrend_buffer[i] = b->detrend_buffer[(size_t)i * lanes + channel];
+    }
+    f->detrend_sum = b->detrend_sum[channel];
+    f->detrend_index = (uint8_t)b->detrend_index[channel];
+    f->detrend_filled = b->detrend_filled[channel] ? 1 : 0;
+    for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+        f->biquad_states[s].x1 = section_x1(b, s)[channel];
+        f->biquad_states[s].x2 = section_x2(b, s)[channel];
+    }
+    for (uint32_t i = 0; i < SIGNAL_SMOOTH_SIZE; i++) {
+        f->smooth_buffer[i] = b->smooth_buffer[(size_t)i * lanes + channel];
+    }
+    f->smooth_index = (uint8_t)b->smooth_index[channel];
+    f->dc_value = b->dc[channel];
+}
+
+void FilterBatch_Process(FilterBatch_t *b, const uint32_t *raw, const int32_t *active, float *ac, float *dc) {
+    memcpy(b->raw_rows, raw, b->channels * sizeof(uint32_t));
+    if (active != NULL) {
+        for (uint32_t c = 0; c < b->channels; c++) {
+            b->active_row[c] = active[c] ? -1 : 0;
+        }
+    }
+    step(b, b->raw_rows, active != NULL ? b->active_row : NULL, b->ac_rows, b->dc_rows);
+    memcpy(ac, b->ac_rows, b->channels * sizeof(float));
+    if (dc != NULL) {
+        memcpy(dc, b->dc_rows, b->channels * sizeof(float));
+    }
+}
+
+int FilterBatch_ProcessFrames(FilterBatch_t *b, const uint32_t *frames, uint32_t count, float *ac, float *dc) {
+    if (b->channels % 2 != 0) {
+        return -1;
+    }
+    const uint32_t streams = b->channels / 2;
+    const size_t row_frames = b->lanes / 2;         // frames per lane row
+    for (uint32_t t = 0; t < count; t += FILTER_BATCH_TILE) {
+        uint32_t n = (count - t < FILTER_BATCH_TILE) ? count - t : FILTER_BATCH_TILE;
+        // [stream][t..t+n) -> [k][stream]
+        transpose(b, b->raw_rows, row_frames, frames + (size_t)t * 2, count, streams, n);
+        for (uint32_t k = 0; k < n; k++) {
+            step(b, b->raw_rows + (size_t)k * b->lanes, NULL,
+                 b->ac_rows + (size_t)k * b->lanes, b->dc_rows + (size_t)k * b->lanes);
+        }
+        transpose(b, ac + (size_t)t * 2, count, b->ac_rows, row_frames, n, streams);
+        if (dc != NULL) {
+            transpose(b, dc + (size_t)t * 2, count, b->dc_rows, row_frames, n, streams);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file flash_sim.c
+ * @brief NOR flash simulator backend for trend_log
+ */
+
+#include "flash_sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t sim_rand(FlashSim_t *sim) {
+    // xorshift32
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+static uint8_t *sim_ptr(FlashSim_t *sim, uint32_t addr, uint32_t len) {
+    if (addr < sim->base || addr + len > sim->base + (uint32_t)sim->page_size * sim->page_count) {
+        return NULL;
+    }
+    return &sim->mem[addr - sim->base];
+}
+
+// Returns 1 when this operation is the one interrupted by the power cut
+static int sim_begin_op(FlashSim_t *sim) {
+    sim->ops++;
+    if (sim->cut_at != 0 && sim->ops == sim->cut_at) {
+        sim->powered = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static uint8_t sim_erase_page(void *ctx, uint32_t addr) {
+    FlashSim_t *sim = (FlashSim_t *)ctx;
+    uint8_t *p = sim_ptr(sim, addr, sim->page_size);
+    if (p == NULL || (addr - sim->base) % sim->page_size != 0 || !sim->powered) {
+        return 1;
+    }
+    uint32_t page = (addr - sim->base) / sim->page_size;
+    if (sim_begin_op(sim)) {
+        // Interrupted erase: only a random leading part of the page is reset
+        uint32_t n = sim_rand(sim) % sim->page_size;
+        memset(p, 0xFF, n);
+        for (uint32_t i = n; i < sim->page_size; i++) {
+            p[i] |= (uint8_t)sim_rand(sim);
+        }
+        return 1;
+    }
+    memset(p, 0xFF, sim->page_size);
+    sim->erase_counts[page]++;
+    return 0;
+}
+
+static uint8_t sim_program_halfword(void *ctx, uint32_t addr, uint16_t data) {
+    FlashSim_t *sim = (FlashSim_t *)ctx;
+    uint8_t *p = sim_ptr(sim, addr, 2);
+    if (p == NULL || (addr & 1) != 0 || !sim->powered) {
+        return 1;
+    }
+    uint16_t cur = (uint16_t)(p[0] | (p[1] << 8));
+    if (sim_begin_op(sim)) {
+        // Interrupted program: only some of the zero bits made it
+        uint16_t partial = (uint16_t)(cur & (data | (uint16_t)sim_rand(sim)));
+        p[0] = (uint8_t)partial;
+        p[1] = (uint8_t)(partial >> 8);
+        return 1;
+    }
+    if (cur != 0xFFFF && data != 0x0000) {
+        sim->program_errors++;      // STM32F1 PGERR
+        return 1;
+    }
+    cur &= data;
+    p[0] = (uint8_t)cur;
+    p[1] = (uint8_t)(cur >> 8);
+    return 0;
+}
+
+static void sim_read(void *ctx, uint32_t addr, void *dst, uint16_t len) {
+    FlashSim_t *sim = (FlashSim_t *)ctx;
+    uint8_t *p = sim_ptr(sim, addr, len);
+    if (p == NULL) {
+        memset(dst, 0xFF, len);
+        return;
+    }
+    memcpy(dst, p, len);
+}
+
+/**
+ * @brief Allocate an erased flash array
+ * @return 0 on success, -1 on allocation failure
+ */
+int FlashSim_Init(FlashSim_t *sim, uint32_t base, uint16_t page_size, uint16_t page_count) {
+    memset(sim, 0, sizeof(*sim));
+    sim->mem = (uint8_t *)malloc((size_t)page_size * page_count);
+    sim->erase_counts = (uint32_t *)calloc(page_count, sizeof(uint32_t));
+    if (sim->mem == NULL || sim->erase_counts == NULL) {
+        FlashSim_Free(sim);
+        return -1;
+    }
+    memset(sim->mem, 0xFF, (size_t)page_size * page_count);
+    sim->base = base;
+    sim->page_size = page_size;
+    sim->page_count = page_count;
+    sim->powered = 1;
+    sim->rng = 0x12345678u;
+    return 0;
+}
+
+void FlashSim_Free(FlashSim_t *sim) {
+    free(sim->mem);
+    free(sim->erase_counts);
+    sim->mem = NULL;
+    sim->erase_counts = NULL;
+}
+
+/**
+ * @brief Fill a trend_log backend descriptor that operates on this simulator
+ */
+void FlashSim_Backend(FlashSim_t *sim, TrendLog_Flash_t *flash) {
+    flash->base = sim->base;
+    flash->page_size = sim->page_size;
+    flash->page_count = sim->page_count;
+    flash->ctx = sim;
+    flash->erase_page = sim_erase_page;
+    flash->program_halfword = sim_program_halfword;
+    flash->read = sim_read;
+}
+
+/**
+ * @brief Cut power during the after_ops-th operation from now
+ * @param seed Seed for the torn bit pattern
+ */
+void FlashSim_SchedulePowerCut(FlashSim_t *sim, uint32_t after_ops, uint32_t seed) {
+    sim->cut_at = sim->ops + after_ops;
+    sim->rng = seed ? seed : 1u;
+}
+
+/**
+ * @brief Restore power (the contents keep whatever state the cut left)
+ */
+void FlashSim_PowerOn(FlashSim_t *sim) {
+    sim->powered = 1;
+    sim->cut_at = 0;
+}
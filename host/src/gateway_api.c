@@ -0,0 +1,390 @@
+/**
+ * @file gateway_api.c
+ * @brief Local Unix-domain socket API of the gateway
+ */
+
+#include "gateway_api.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LINE_MAX_LEN    256
+#define EVENT_BATCH     1024
+#define SUB_NONE        (-1)
+#define SUB_ALL         (-2)
+
+typedef struct {
+    int fd;
+    char in[LINE_MAX_LEN];
+    size_t in_len;
+    char *out;
+    size_t out_len;
+    int64_t sub;                    // stream id, SUB_NONE or SUB_ALL
+    int closing;                    // QUIT: close once the replies are out
+} Api_Client_t;
+
+struct GatewayApi {
+    PPGGateway_t *gw;
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    int listen_fd;
+    pthread_t thread;
+    _Atomic int stop;
+    Api_Client_t clients[GATEWAY_API_MAX_CLIENTS];
+    PPGGateway_Event_t events[EVENT_BATCH];
+    pthread_mutex_t stats_lock;
+    GatewayApi_Stats_t stats;
+};
+
+static void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// 0, -1: no room (nothing queued)
+static int client_printf(Api_Client_t *c, const char *fmt, ...) {
+    char line[LINE_MAX_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        return -1;
+    }
+    if ((size_t)n >= sizeof(line)) {
+        n = (int)sizeof(line) - 1;
+    }
+    if (c->out_len + (size_t)n > GATEWAY_API_CLIENT_BUFFER) {
+        return -1;
+    }
+    memcpy(c->out + c->out_len, line, (size_t)n);
+    c->out_len += (size_t)n;
+    return 0;
+}
+
+static void client_close(GatewayApi_t *api, Api_Client_t *c) {
+    close(c->fd);
+    free(c->out);
+    memset(c, 0, sizeof(Api_Client_t));
+    c->fd = -1;
+    pthread_mutex_lock(&api->stats_lock);
+    api->stats.clients--;
+    pthread_mutex_unlock(&api->stats_lock);
+}
+
+static void accept_clients(GatewayApi_t *api) {
+    for (;;) {
+        int fd = accept(api->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            return;
+        }
+        Api_Client_t *c = NULL;
+        for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+            if (api->clients[i].fd < 0) {
+                c = &api->clients[i];
+                break;
+            }
+        }
+        char *out = (c != NULL) ? (char *)malloc(GATEWAY_API_CLIENT_BUFFER) : NULL;
+        if (out == NULL) {
+            static const char full[] = "ERR too many clients\n";
+            if (write(fd, full, sizeof(full) - 1) < 0) {
+                // closing anyway
+            }
+            close(fd);
+            continue;
+        }
+        set_nonblocking(fd);
+        memset(c, 0, sizeof(Api_Client_t));
+        c->fd = fd;
+        c->out = out;
+        c->sub = SUB_NONE;
+        pthread_mutex_lock(&api->stats_lock);
+        api->stats.clients++;
+        api->stats.connections++;
+        pthread_mutex_unlock(&api->stats_lock);
+    }
+}
+
+static int parse_stream(const PPGGateway_t *gw, const char *arg, uint32_t *id) {
+    char *end;
+    if (arg == NULL) {
+        return -1;
+    }
+    unsigned long v = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || v >= PPGGateway_GetConfig(gw)->streams) {
+        return -1;
+    }
+    *id = (uint32_t)v;
+    return 0;
+}
+
+#define US(ns)  ((double)(ns) / 1000.0)
+
+static void command(GatewayApi_t *api, Api_Client_t *c, char *line) {
+    const PPGGateway_Config_t *cfg = PPGGateway_GetConfig(api->gw);
+    char *save = NULL;
+    char *cmd = strtok_r(line, " \t", &save);
+    char *arg = strtok_r(NULL, " \t", &save);
+    uint32_t id;
+    if (cmd == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&api->stats_lock);
+    api->stats.commands++;
+    pthread_mutex_unlock(&api->stats_lock);
+
+    if (strcmp(cmd, "STATS") == 0) {
+        PPGGateway_Stats_t s;
+        PPGGateway_GetStats(api->gw, &s);
+        client_printf(c, "STATS streams=%u workers=%u samples=%llu dropped=%llu util=%.3f ticks=%llu "
+                      "overruns=%llu p50_us=%.1f p99_us=%.1f max_us=%.1f service_p99_us=%.1f "
+                      "stream_p99_median_us=%.1f stream_p99_max_us=%.1f stream_p99_max_id=%u "
+                      "events_dropped=%llu\n",
+                      s.streams, s.workers, (unsigned long long)s.samples, (unsigned long long)s.dropped,
+                      s.utilisation, (unsigned long long)s.ticks, (unsigned long long)s.overruns,
+                      US(s.latency_p50_ns), US(s.latency_p99_ns), US(s.latency_max_ns), US(s.service_p99_ns),
+                      US(s.stream_p99_median_ns), US(s.stream_p99_max_ns), s.stream_p99_max_id,
+                      (unsigned long long)s.events_dropped);
+    } else if (strcmp(cmd, "GET") == 0) {
+        if (parse_stream(api->gw, arg, &id) != 0) {
+            client_printf(c, "ERR no such stream\n");
+            return;
+        }
+        for (uint32_t v = 0; v < cfg->variant_count; v++) {
+            PPGVariant_Output_t out;
+            uint64_t sample;
+            PPGGateway_GetOutput(api->gw, id, v, &out, &sample);
+            client_printf(c, "OUT %u %s %llu %.1f %u %.1f %u\n", id, cfg->variants[v]->name,
+                          (unsigned long long)sample, out.hr_bpm, out.hr_valid, out.spo2, out.spo2_valid);
+        }
+    } else if (strcmp(cmd, "LAT") == 0) {
+        PPGGateway_StreamStats_t s;
+        if (parse_stream(api->gw, arg, &id) != 0 || PPGGateway_GetStreamStats(api->gw, id, &s) != 0) {
+            client_printf(c, "ERR no such stream\n");
+            return;
+        }
+        client_printf(c, "LAT %u samples=%llu dropped=%llu batches=%llu p50_us=%.1f p99_us=%.1f "
+                      "max_us=%.1f service_p99_us=%.1f\n", id, (unsigned long long)s.samples,
+                      (unsigned long long)s.dropped, (unsigned long long)s.batches,
+                      US(s.latency_p50_ns), US(s.latency_p99_ns), US(s.latency_max_ns), US(s.service_p99_ns));
+    } else if (strcmp(cmd, "SUB") == 0) {
+        if (arg != NULL && strcmp(arg, "ALL") == 0) {
+            c->sub = SUB_ALL;
+        } else if (parse_stream(api->gw, arg, &id) == 0) {
+            c->sub = id;
+        } else {
+            client_printf(c, "ERR no such stream\n");
+            return;
+        }
+        client_printf(c, "OK\n");
+    } else if (strcmp(cmd, "UNSUB") == 0) {
+        c->sub = SUB_NONE;
+        client_printf(c, "OK\n");
+    } else if (strcmp(cmd, "QUIT") == 0) {
+        c->closing = 1;
+    } else {
+        client_printf(c, "ERR unknown command\n");
+    }
+}
+
+// 0, -1: the client has gone
+static int read_client(GatewayApi_t *api, Api_Client_t *c) {
+    for (;;) {
+        char buf[1024];
+        ssize_t n = read(c->fd, buf, sizeof(buf));
+        if (n == 0) {
+            return -1;
+        }
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            char ch = buf[i];
+            if (ch == '\n') {
+                c->in[c->in_len] = '\0';
+                if (c->in_len > 0 && c->in[c->in_len - 1] == '\r') {
+                    c->in[c->in_len - 1] = '\0';
+                }
+                command(api, c, c->in);
+                c->in_len = 0;
+            } else if (c->in_len < sizeof(c->in) - 1) {
+                c->in[c->in_len++] = ch;
+            }                       // an over-long line is truncated
+        }
+    }
+}
+
+// 0, -1: the client has gone
+static int flush_client(Api_Client_t *c) {
+    size_t done = 0;
+    while (done < c->out_len) {
+        ssize_t n = send(c->fd, c->out + done, c->out_len - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    memmove(c->out, c->out + done, c->out_len - done);
+    c->out_len -= done;
+    return 0;
+}
+
+static void forward_events(GatewayApi_t *api) {
+    const PPGGateway_Config_t *cfg = PPGGateway_GetConfig(api->gw);
+    uint32_t n;
+    while ((n = PPGGateway_PollEvents(api->gw, api->events, EVENT_BATCH)) > 0) {
+        uint64_t sent = 0, dropped = 0;
+        for (uint32_t k = 0; k < n; k++) {
+            const PPGGateway_Event_t *e = &api->events[k];
+            for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+                Api_Client_t *c = &api->clients[i];
+                if (c->fd < 0 || (c->sub != SUB_ALL && c->sub != (int64_t)e->stream)) {
+                    continue;
+                }
+                if (client_printf(c, "EV %u %s %llu %.1f %u %.1f %u\n", e->stream,
+                                  cfg->variants[e->variant]->name, (unsigned long long)e->sample,
+                                  e->out.hr_bpm, e->out.hr_valid, e->out.spo2, e->out.spo2_valid) == 0) {
+                    sent++;
+                } else {
+                    dropped++;
+                }
+            }
+        }
+        pthread_mutex_lock(&api->stats_lock);
+        api->stats.events += n;
+        api->stats.events_sent += sent;
+        api->stats.events_dropped += dropped;
+        pthread_mutex_unlock(&api->stats_lock);
+        if (n < EVENT_BATCH) {
+            break;
+        }
+    }
+}
+
+static void *api_main(void *arg) {
+    GatewayApi_t *api = (GatewayApi_t *)arg;
+    struct pollfd fds[GATEWAY_API_MAX_CLIENTS + 1];
+    Api_Client_t *owner[GATEWAY_API_MAX_CLIENTS + 1];
+
+    while (!atomic_load(&api->stop)) {
+        nfds_t nfds = 0;
+        fds[nfds].fd = api->listen_fd;
+        fds[nfds].events = POLLIN;
+        owner[nfds++] = NULL;
+        for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+            Api_Client_t *c = &api->clients[i];
+            if (c->fd >= 0) {
+                fds[nfds].fd = c->fd;
+                fds[nfds].events = (short)(POLLIN | (c->out_len ? POLLOUT : 0));
+                owner[nfds++] = c;
+            }
+        }
+        int ready = poll(fds, nfds, GATEWAY_API_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                accept_clients(api);
+            }
+            for (nfds_t k = 1; k < nfds; k++) {
+                Api_Client_t *c = owner[k];
+                if ((fds[k].revents & (POLLIN | POLLHUP | POLLERR)) && read_client(api, c) != 0) {
+                    client_close(api, c);
+                }
+            }
+        }
+
+        forward_events(api);
+        for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+            Api_Client_t *c = &api->clients[i];
+            if (c->fd >= 0 && c->out_len && flush_client(c) != 0) {
+                client_close(api, c);
+            } else if (c->fd >= 0 && c->closing && c->out_len == 0) {
+                client_close(api, c);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Bind the socket and start the API thread.
+ * @return NULL if the path is too long, cannot be bound, or out of memory
+ */
+GatewayApi_t *GatewayApi_Start(PPGGateway_t *gw, const char *path) {
+    if (strlen(path) >= sizeof(((struct sockaddr_un *)0)->sun_path)) {
+        return NULL;
+    }
+    GatewayApi_t *api = (GatewayApi_t *)calloc(1, sizeof(GatewayApi_t));
+    if (api == NULL) {
+        return NULL;
+    }
+    api->gw = gw;
+    strcpy(api->path, path);
+    for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+        api->clients[i].fd = -1;
+    }
+    pthread_mutex_init(&api->stats_lock, NULL);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    api->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (api->listen_fd < 0 ||
+        bind(api->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(api->listen_fd, GATEWAY_API_MAX_CLIENTS) != 0) {
+        goto fail;
+    }
+    set_nonblocking(api->listen_fd);
+    if (pthread_create(&api->thread, NULL, api_main, api) != 0) {
+        unlink(path);
+        goto fail;
+    }
+    return api;
+
+fail:
+    if (api->listen_fd >= 0) {
+        close(api->listen_fd);
+    }
+    pthread_mutex_destroy(&api->stats_lock);
+    free(api);
+    return NULL;
+}
+
+void GatewayApi_Stop(GatewayApi_t *api) {
+    if (api == NULL) {
+        return;
+    }
+    atomic_store(&api->stop, 1);
+    pthread_join(api->thread, NULL);
+    for (uint32_t i = 0; i < GATEWAY_API_MAX_CLIENTS; i++) {
+        if (api->clients[i].fd >= 0) {
+            flush_client(&api->clients[i]);
+            client_close(api, &api->clients[i]);
+        }
+    }
+    close(api->listen_fd);
+    unlink(api->path);
+    pthread_mutex_destroy(&api->stats_lock);
+    free(api);
+}
+
+void GatewayApi_GetStats(GatewayApi_t *api, GatewayApi_Stats_t *stats) {
+    pthread_mutex_lock(&api->stats_lock);
+    *stats = api->stats;
+    pthread_mutex_unlock(&api->stats_lock);
+}
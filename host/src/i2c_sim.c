@@ -0,0 +1,200 @@
+/**
+ * @file i2c_sim.c
+ * @brief Simulated I2C bus: pin-level slave decoder and byte-level transfers
+ */
+
+#include "i2c_sim.h"
+#include <string.h>
+
+void I2CSim_Init(I2CSim_Bus_t *bus) {
+    memset(bus, 0, sizeof(I2CSim_Bus_t));
+    bus->scl = 1;
+    bus->master_sda = 1;
+    bus->slave_sda = 1;
+    bus->phase = I2C_SIM_IDLE;
+}
+
+/**
+ * Attach a device. Returns 0, or -1 when the bus is full or the address is taken.
+ */
+int I2CSim_Attach(I2CSim_Bus_t *bus, const I2CSim_Device_t *device) {
+    if (bus->device_count >= I2C_SIM_MAX_DEVICES) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < bus->device_count; i++) {
+        if (bus->devices[i]->address == device->address) {
+            return -1;
+        }
+    }
+    bus->devices[bus->device_count++] = device;
+    return 0;
+}
+
+void I2CSim_Update(I2CSim_Bus_t *bus, uint64_t now_us) {
+    for (uint8_t i = 0; i < bus->device_count; i++) {
+        if (bus->devices[i]->update != NULL) {
+            bus->devices[i]->update(bus->devices[i]->ctx, now_us);
+        }
+    }
+}
+
+static const I2CSim_Device_t *find_device(const I2CSim_Bus_t *bus, uint8_t address) {
+    for (uint8_t i = 0; i < bus->device_count; i++) {
+        if (bus->devices[i]->address == address) {
+            return bus->devices[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t sda_line(const I2CSim_Bus_t *bus) {
+    return bus->master_sda & bus->slave_sda;
+}
+
+static void on_start(I2CSim_Bus_t *bus) {
+    // A repeated START keeps the device selected until its address byte is decoded
+    bus->phase = I2C_SIM_ADDR;
+    bus->bits = 0;
+    bus->shift = 0;
+    bus->ack_phase = 0;
+    bus->slave_sda = 1;
+    bus->transfers++;
+}
+
+static void on_stop(I2CSim_Bus_t *bus) {
+    if (bus->active != NULL && bus->active->stop != NULL) {
+        bus->active->stop(bus->active->ctx);
+    }
+    bus->active = NULL;
+    bus->phase = I2C_SIM_IDLE;
+    bus->ack_phase = 0;
+    bus->slave_sda = 1;
+}
+
+// SCL rising edge: the receiver samples SDA
+static void on_rise(I2CSim_Bus_t *bus) {
+    if (bus->ack_phase) {
+        if (bus->phase == I2C_SIM_READ) {
+            bus->master_ack = (sda_line(bus) == 0);
+        }
+        return;
+    }
+    if (bus->phase == I2C_SIM_ADDR || bus->phase == I2C_SIM_WRITE) {
+        bus->shift = (uint8_t)((bus->shift << 1) | sda_line(bus));
+        bus->bits++;
+    } else if (bus->phase == I2C_SIM_READ) {
+        bus->bits++;
+    }
+}
+
+// SCL falling edge: the slave sets up its next SDA level (data bit or ACK)
+static void on_fall(I2CSim_Bus_t *bus) {
+    if (bus->ack_phase) {
+        bus->ack_phase = 0;
+        bus->bits = 0;
+        bus->shift = 0;
+        bus->slave_sda = 1;
+        if (bus->phase == I2C_SIM_READ) {
+            if (bus->first_read || bus->master_ack) {
+                bus->first_read = 0;
+                bus->tx_byte = bus->active->read(bus->active->ctx);
+                bus->bytes++;
+                bus->slave_sda = (bus->tx_byte >> 7) & 1;
+            } else {
+                bus->phase = I2C_SIM_IGNORE;    // NACK: the master ends the read
+            }
+        }
+        return;
+    }
+
+    if (bus->bits < 8) {
+        if (bus->phase == I2C_SIM_READ && bus->bits > 0) {
+            bus->slave_sda = (bus->tx_byte >> (7 - bus->bits)) & 1;
+        }
+        return;
+    }
+
+    // Eighth bit done: ACK clock follows
+    uint8_t ack = 0;
+    if (bus->phase == I2C_SIM_ADDR) {
+        uint8_t read = bus->shift & 1;
+        bus->active = find_device(bus, bus->shift >> 1);
+        ack = (bus->active != NULL) && bus->active->start(bus->active->ctx, read);
+        if (ack) {
+            bus->phase = read ? I2C_SIM_READ : I2C_SIM_WRITE;
+            bus->first_read = read;
+        } else {
+            bus->active = NULL;
+            bus->phase = I2C_SIM_IGNORE;
+        }
+    } else if (bus->phase == I2C_SIM_WRITE) {
+        ack = bus->active->write(bus->active->ctx, bus->shift);
+        bus->bytes++;
+    } else if (bus->phase == I2C_SIM_READ) {
+        bus->ack_phase = 1;                     // released: the master drives ACK/NACK
+        bus->slave_sda = 1;
+        return;
+    }
+    if (!ack) {
+        bus->nacks++;
+    }
+    bus->ack_phase = 1;
+    bus->slave_sda = ack ? 0 : 1;
+}
+
+void I2CSim_SetScl(I2CSim_Bus_t *bus, uint8_t level) {
+    level = level ? 1 : 0;
+    if (level == bus->scl) {
+        return;
+    }
+    bus->scl = level;
+    if (level) {
+        on_rise(bus);
+    } else {
+        on_fall(bus);
+    }
+}
+
+void I2CSim_SetSda(I2CSim_Bus_t *bus, uint8_t level) {
+    uint8_t before = sda_line(bus);
+    bus->master_sda = level ? 1 : 0;
+    uint8_t after = sda_line(bus);
+    if (bus->scl && before != after) {
+        if (after == 0) {
+            on_start(bus);
+        } else {
+            on_stop(bus);
+        }
+    }
+}
+
+uint8_t I2CSim_GetSda(const I2CSim_Bus_t *bus) {
+    return sda_line(bus);
+}
+
+/**
+ * Byte-level write transfer (START, address, data..., STOP).
+ * Returns 0 on success, 1 when the address or a data byte is not acknowledged.
+ */
+uint8_t I2CSim_Write(I2CSim_Bus_t *bus, uint8_t address, const uint8_t *data, uint16_t len) {
+    const I2CSim_Device_t *device = find_device(bus, address);
+    uint8_t status = 0;
+
+    bus->transfers++;
+    if (device == NULL || !device->start(device->ctx, 0)) {
+        bus->nacks++;
+        return 1;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        bus->bytes++;
+        if (!device->write(device->ctx, data[i])) {
+            bus->nacks++;
+            status = 1;
+            break;
+        }
+    }
+    if (device->stop != NULL) {
+        device->stop(device->ctx);
+    }
+    return status;
+}
@@ -0,0 +1,457 @@
+/**
+ * @file max30102_sim.c
+ * @brief Simulated MAX30102 on the soft I2C bus
+ */
+
+#include "max30102_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define REG_INTR_STATUS_1   0x00
+#define REG_INTR_STATUS_2   0x01
+#define REG_INTR_ENABLE_1   0x02
+#define REG_INTR_ENABLE_2   0x03
+#define REG_FIFO_WR_PTR     0x04
+#define REG_OVF_COUNTER     0x05
+#define REG_FIFO_RD_PTR     0x06
+#define REG_FIFO_DATA       0x07
+#define REG_FIFO_CONFIG     0x08
+#define REG_MODE_CONFIG     0x09
+#define REG_SPO2_CONFIG     0x0A
+#define REG_LED1_PA         0x0C
+#define REG_LED2_PA         0x0D
+#define REG_SLOT_1_2        0x11
+#define REG_SLOT_3_4        0x12
+#define REG_TEMP_INT        0x1F
+#define REG_TEMP_FRAC       0x20
+#define REG_TEMP_CONFIG     0x21
+#define REG_REV_ID          0xFE
+#define REG_PART_ID         0xFF
+
+#define INT_A_FULL          0x80
+#define INT_PPG_RDY         0x40
+#define INT_ALC_OVF         0x20
+#define INT_PWR_RDY         0x01
+#define INT_DIE_TEMP_RDY    0x02
+
+#define MODE_SHDN           0x80
+#define MODE_RESET          0x40
+#define MODE_MASK           0x07
+#define MODE_HR             0x02
+#define MODE_SPO2           0x03
+#define MODE_MULTI_LED      0x07
+#define FIFO_ROLLOVER_EN    0x10
+#define TEMP_EN             0x01
+
+#define ADC_FULL_SCALE      0x3FFFFu
+
+static const uint32_t sample_rates[8] = { 50, 100, 200, 400, 800, 1000, 1600, 3200 };
+static const uint8_t sample_averages[8] = { 1, 2, 4, 8, 16, 32, 32, 32 };
+static const uint32_t adc_ranges_na[4] = { 2048, 4096, 8192, 16384 };
+
+static void update_int_pin(MAX30102Sim_t *sim) {
+    uint8_t pending = (sim->regs[REG_INTR_STATUS_1] & (sim->regs[REG_INTR_ENABLE_1] | INT_PWR_RDY)) ||
+                      (sim->regs[REG_INTR_STATUS_2] & sim->regs[REG_INTR_ENABLE_2]);
+    uint8_t level = pending ? 0 : 1;
+    if (level == sim->int_level) {
+        return;
+    }
+    sim->int_level = level;
+    if (level == 0) {
+        sim->interrupts++;
+    }
+    if (sim->int_pin != NULL) {
+        sim->int_pin(sim->int_ctx, level);
+    }
+}
+
+// RESET: every register back to its power-on value, FIFO and conversions stopped
+static void soft_reset(MAX30102Sim_t *sim) {
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->regs[REG_REV_ID] = MAX30102_SIM_REV_ID;
+    sim->regs[REG_PART_ID] = MAX30102_SIM_PART_ID;
+    sim->fifo_full = 0;
+    sim->fifo_byte = 0;
+    sim->running = 0;
+    sim->avg_count = 0;
+    sim->temp_pending = 0;
+    update_int_pin(sim);
+}
+
+uint8_t MAX30102Sim_FifoCount(const MAX30102Sim_t *sim) {
+    if (sim->fifo_full) {
+        return MAX30102_SIM_FIFO_DEPTH;
+    }
+    return (uint8_t)((sim->regs[REG_FIFO_WR_PTR] - sim->regs[REG_FIFO_RD_PTR]) & (MAX30102_SIM_FIFO_DEPTH - 1));
+}
+
+/**
+ * Conversion rate set by SPO2_SR (before averaging), nominal.
+ */
+uint32_t MAX30102Sim_SampleRate(const MAX30102Sim_t *sim) {
+    return sample_rates[(sim->regs[REG_SPO2_CONFIG] >> 2) & 0x07];
+}
+
+// FIFO channels of the configured mode (shutdown keeps the FIFO layout)
+static uint8_t mode_channels(const MAX30102Sim_t *sim, uint8_t *leds) {
+    uint8_t mode = sim->regs[REG_MODE_CONFIG] & MODE_MASK;
+    if (mode == MODE_HR) {
+        leds[0] = MAX30102_SIM_LED_RED;
+        return 1;
+    }
+    if (mode == MODE_SPO2) {
+        leds[0] = MAX30102_SIM_LED_RED;
+        leds[1] = MAX30102_SIM_LED_IR;
+        return 2;
+    }
+    if (mode != MODE_MULTI_LED) {
+        return 0;
+    }
+    // Slots run in order; the first disabled slot ends the sequence
+    uint8_t slots[4] = {
+        (uint8_t)(sim->regs[REG_SLOT_1_2] & 0x07), (uint8_t)((sim->regs[REG_SLOT_1_2] >> 4) & 0x07),
+        (uint8_t)(sim->regs[REG_SLOT_3_4] & 0x07), (uint8_t)((sim->regs[REG_SLOT_3_4] >> 4) & 0x07),
+    };
+    uint8_t count = 0;
+    while (count < MAX30102_SIM_CHANNELS && slots[count] != 0) {
+        leds[count] = (slots[count] == MAX30102_SIM_LED_RED || slots[count] == MAX30102_SIM_LED_IR) ? slots[count] : 0;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * LEDs of the FIFO channels in the current mode (MAX30102_SIM_LED_RED /
+ * MAX30102_SIM_LED_IR, 0 for a slot code without an LED on this part).
+ * Returns the channel count, 0 when not sampling.
+ */
+uint8_t MAX30102Sim_Channels(const MAX30102Sim_t *sim, uint8_t *leds) {
+    if (sim->regs[REG_MODE_CONFIG] & MODE_SHDN) {
+        return 0;
+    }
+    return mode_channels(sim, leds);
+}
+
+// Reference-setting counts to ADC counts at the current LED current and range
+static uint32_t scale_channel(MAX30102Sim_t *sim, uint32_t counts, uint8_t led_pa) {
+    double range = (double)adc_ranges_na[(sim->regs[REG_SPO2_CONFIG] >> 5) & 0x03];
+    double value = (double)counts * (double)led_pa / MAX30102_SIM_REF_LED_PA * MAX30102_SIM_REF_RANGE_NA / range;
+    if (value >= (double)ADC_FULL_SCALE) {
+        sim->saturated++;
+        return ADC_FULL_SCALE;
+    }
+    return (uint32_t)value;
+}
+
+static void push_sample(MAX30102Sim_t *sim, uint32_t red, uint32_t ir) {
+    uint8_t leds[MAX30102_SIM_CHANNELS];
+    uint8_t channels = MAX30102Sim_Channels(sim, leds);
+    uint8_t resolution = (uint8_t)(15 + (sim->regs[REG_SPO2_CONFIG] & 0x03));
+    uint32_t mask = ADC_FULL_SCALE & ~((1u << (18 - resolution)) - 1u);   // left-justified
+
+    sim->samples++;
+    if (sim->fifo_full) {
+        sim->lost++;
+        if (sim->regs[REG_OVF_COUNTER] < 0x1F) {
+            sim->regs[REG_OVF_COUNTER]++;
+        }
+        if (!(sim->regs[REG_FIFO_CONFIG] & FIFO_ROLLOVER_EN)) {
+            return;                                 // new sample dropped
+        }
+        // Rollover: the oldest sample is overwritten
+        sim->regs[REG_FIFO_RD_PTR] = (uint8_t)((sim->regs[REG_FIFO_RD_PTR] + 1) & (MAX30102_SIM_FIFO_DEPTH - 1));
+        sim->fifo_byte = 0;
+    }
+    uint8_t wr = sim->regs[REG_FIFO_WR_PTR];
+    for (uint8_t c = 0; c < channels; c++) {
+        uint32_t value = (leds[c] == MAX30102_SIM_LED_RED) ? red : (leds[c] == MAX30102_SIM_LED_IR) ? ir : 0;
+        sim->fifo[wr][c] = value & mask;
+    }
+    sim->regs[REG_FIFO_WR_PTR] = (uint8_t)((wr + 1) & (MAX30102_SIM_FIFO_DEPTH - 1));
+    if (sim->regs[REG_FIFO_WR_PTR] == sim->regs[REG_FIFO_RD_PTR]) {
+        sim->fifo_full = 1;
+    }
+
+    sim->regs[REG_INTR_STATUS_1] |= INT_PPG_RDY;
+    if (MAX30102Sim_FifoCount(sim) == MAX30102_SIM_FIFO_DEPTH - (sim->regs[REG_FIFO_CONFIG] & 0x0F)) {
+        sim->regs[REG_INTR_STATUS_1] |= INT_A_FULL;
+    }
+    update_int_pin(sim);
+}
+
+// One ADC conversion; SMP_AVE conversions make one FIFO sample
+static void convert(MAX30102Sim_t *sim, uint64_t t_us) {
+    uint32_t red = 0;
+    uint32_t ir = 0;
+    if (sim->source != NULL) {
+        sim->source(sim->source_ctx, t_us, &red, &ir);
+    }
+    sim->avg_red += scale_channel(sim, red, sim->regs[REG_LED1_PA]);
+    sim->avg_ir += scale_channel(sim, ir, sim->regs[REG_LED2_PA]);
+    uint8_t average = sample_averages[(sim->regs[REG_FIFO_CONFIG] >> 5) & 0x07];
+    if (++sim->avg_count < average) {
+        return;
+    }
+    push_sample(sim, sim->avg_red / average, sim->avg_ir / average);
+    sim->avg_red = 0;
+    sim->avg_ir = 0;
+    sim->avg_count = 0;
+}
+
+// End of conversion n of the current configuration (n >= 1)
+static uint64_t conversion_time(const MAX30102Sim_t *sim, uint64_t n) {
+    double rate = (double)MAX30102Sim_SampleRate(sim) * (1.0 + (double)sim->rate_error_ppm * 1e-6);
+    return sim->epoch_us + (uint64_t)((double)n * 1e6 / rate);
+}
+
+// One FIFO_DATA byte: channel 0 [23:16], [15:8], [7:0], channel 1 [23:16], ...
+static uint8_t read_fifo_byte(MAX30102Sim_t *sim) {
+    uint8_t leds[MAX30102_SIM_CHANNELS];
+    uint8_t channels = mode_channels(sim, leds);
+    sim->regs[REG_INTR_STATUS_1] &= (uint8_t)~(INT_A_FULL | INT_PPG_RDY);
+    update_int_pin(sim);
+    if (channels == 0 || MAX30102Sim_FifoCount(sim) == 0) {
+        return 0;
+    }
+    uint8_t rd = sim->regs[REG_FIFO_RD_PTR];
+    uint32_t value = sim->fifo[rd][sim->fifo_byte / 3];
+    uint8_t byte = (uint8_t)(value >> (8 * (2 - sim->fifo_byte % 3)));
+    if (++sim->fifo_byte == 3 * channels) {
+        // Sample popped: advance the read pointer, clear the overflow counter
+        sim->fifo_byte = 0;
+        sim->regs[REG_FIFO_RD_PTR] = (uint8_t)((rd + 1) & (MAX30102_SIM_FIFO_DEPTH - 1));
+        sim->regs[REG_OVF_COUNTER] = 0;
+        sim->fifo_full = 0;
+        sim->popped++;
+    }
+    return byte;
+}
+
+// Reading a status register returns and clears it
+static uint8_t read_reg(MAX30102Sim_t *sim, uint8_t reg) {
+    uint8_t value = sim->regs[reg];
+    if (reg == REG_INTR_STATUS_1 || reg == REG_INTR_STATUS_2) {
+        sim->regs[reg] = 0;
+        update_int_pin(sim);
+    }
+    return value;
+}
+
+static void write_reg(MAX30102Sim_t *sim, uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case REG_MODE_CONFIG:
+            if (value & MODE_RESET) {
+                soft_reset(sim);                    // RESET clears itself when done
+                return;
+            }
+            sim->regs[reg] = value & (MODE_SHDN | MODE_MASK);
+            sim->running = 0;                       // restart conversions
+            sim->avg_count = 0;
+            sim->avg_red = 0;
+            sim->avg_ir = 0;
+            break;
+        case REG_SPO2_CONFIG:
+        case REG_FIFO_CONFIG:
+            sim->regs[reg] = (reg == REG_SPO2_CONFIG) ? (value & 0x7F) : value;
+            sim->running = 0;
+            sim->avg_count = 0;
+            sim->avg_red = 0;
+            sim->avg_ir = 0;
+            break;
+        case REG_FIFO_WR_PTR:
+        case REG_FIFO_RD_PTR:
+            sim->regs[reg] = value & (MAX30102_SIM_FIFO_DEPTH - 1);
+            sim->fifo_full = 0;
+            sim->fifo_byte = 0;
+            break;
+        case REG_OVF_COUNTER:
+            sim->regs[reg] = value & 0x1F;
+            break;
+        case REG_INTR_ENABLE_1:
+            sim->regs[reg] = value & (INT_A_FULL | INT_PPG_RDY | INT_ALC_OVF);
+            update_int_pin(sim);
+            break;
+        case REG_INTR_ENABLE_2:
+            sim->regs[reg] = value & INT_DIE_TEMP_RDY;
+            update_int_pin(sim);
+            break;
+        case REG_TEMP_CONFIG:
+            if ((value & TEMP_EN) && !sim->temp_pending) {
+                sim->temp_pending = 1;
+                sim->temp_done_us = sim->now_us + MAX30102_SIM_TEMP_US;
+                sim->regs[reg] = TEMP_EN;           // cleared when the conversion is done
+            }
+            break;
+        case REG_INTR_STATUS_1:
+        case REG_INTR_STATUS_2:
+        case REG_FIFO_DATA:
+        case REG_TEMP_INT:
+        case REG_TEMP_FRAC:
+        case REG_REV_ID:
+        case REG_PART_ID:
+            break;                                  // read only
+        default:
+            sim->regs[reg] = value;
+            break;
+    }
+}
+
+static uint8_t dev_start(void *ctx, uint8_t read) {
+    MAX30102Sim_t *sim = (MAX30102Sim_t *)ctx;
+    sim->ptr_pending = !read;
+    return 1;
+}
+
+static uint8_t dev_write(void *ctx, uint8_t byte) {
+    MAX30102Sim_t *sim = (MAX30102Sim_t *)ctx;
+    if (sim->ptr_pending) {
+        sim->ptr_pending = 0;
+        sim->reg_ptr = byte;
+        return 1;
+    }
+    write_reg(sim, sim->reg_ptr, byte);
+    if (sim->reg_ptr != REG_FIFO_DATA) {
+        sim->reg_ptr++;
+    }
+    return 1;
+}
+
+static uint8_t dev_read(void *ctx) {
+    MAX30102Sim_t *sim = (MAX30102Sim_t *)ctx;
+    if (sim->reg_ptr == REG_FIFO_DATA) {
+        return read_fifo_byte(sim);                 // the pointer does not advance past FIFO_DATA
+    }
+    return read_reg(sim, sim->reg_ptr++);
+}
+
+static void dev_update(void *ctx, uint64_t now_us) {
+    MAX30102Sim_t *sim = (MAX30102Sim_t *)ctx;
+    uint8_t leds[MAX30102_SIM_CHANNELS];
+    sim->now_us = now_us;
+
+    if (sim->temp_pending && now_us >= sim->temp_done_us) {
+        // TINT: two's complement integer part, TFRAC: 1/16 degree steps
+        double whole = floor((double)sim->temperature_c);
+        sim->regs[REG_TEMP_INT] = (uint8_t)(int8_t)whole;
+        sim->regs[REG_TEMP_FRAC] = (uint8_t)((double)(sim->temperature_c - whole) * 16.0) & 0x0F;
+        sim->regs[REG_TEMP_CONFIG] = 0;
+        sim->regs[REG_INTR_STATUS_2] |= INT_DIE_TEMP_RDY;
+        sim->temp_pending = 0;
+        update_int_pin(sim);
+    }
+
+    if (MAX30102Sim_Channels(sim, leds) == 0) {
+        sim->running = 0;
+        return;
+    }
+    if (!sim->running) {
+        sim->running = 1;
+        sim->epoch_us = now_us;
+        sim->conversions = 0;
+        sim->next_us = conversion_time(sim, 1);
+        return;
+    }
+    while (sim->next_us <= now_us) {
+        convert(sim, sim->next_us);
+        sim->conversions++;
+        sim->next_us = conversion_time(sim, sim->conversions + 1);
+    }
+}
+
+/**
+ * Initialise in the power-on state (PWR_RDY pending); attach sim->device to
+ * the soft I2C bus.
+ */
+void MAX30102Sim_Init(MAX30102Sim_t *sim, MAX30102Sim_Source_t source, void *source_ctx) {
+    memset(sim, 0, sizeof(MAX30102Sim_t));
+    sim->int_level = 1;
+    sim->temperature_c = 30.0f;
+    soft_reset(sim);
+    sim->regs[REG_INTR_STATUS_1] = INT_PWR_RDY;
+    update_int_pin(sim);
+    sim->source = source;
+    sim->source_ctx = source_ctx;
+    sim->device.address = MAX30102_SIM_ADDRESS;
+    sim->device.ctx = sim;
+    sim->device.start = dev_start;
+    sim->device.write = dev_write;
+    sim->device.read = dev_read;
+    sim->device.update = dev_update;
+}
+
+/**
+ * Connect the INT pin; the callback is called once with the current level.
+ */
+void MAX30102Sim_SetIntPin(MAX30102Sim_t *sim, MAX30102Sim_IntPin_t callback, void *ctx) {
+    sim->int_pin = callback;
+    sim->int_ctx = ctx;
+    if (callback != NULL) {
+        callback(ctx, sim->int_level);
+    }
+}
+
+/**
+ * Load "index,red,ir" (ppg_capture_decode) or "red,ir" lines; other lines
+ * are skipped. Returns 0 on success, -1 if the file cannot be read or has
+ * no samples.
+ */
+int MAX30102Sim_LoadCsv(MAX30102Sim_Recording_t *rec, const char *path, uint32_t rate_hz) {
+    memset(rec, 0, sizeof(MAX30102Sim_Recording_t));
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    uint32_t capacity = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned long a, b, c;
+        int fields = sscanf(line, "%lu,%lu,%lu", &a, &b, &c);
+        if (fields < 2) {
+            continue;                               // header or blank line
+        }
+        if (rec->count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            uint32_t *red = realloc(rec->red, capacity * sizeof(uint32_t));
+            uint32_t *ir = realloc(rec->ir, capacity * sizeof(uint32_t));
+            if (red == NULL || ir == NULL) {
+                free(red != NULL ? red : rec->red);
+                free(ir != NULL ? ir : rec->ir);
+                memset(rec, 0, sizeof(MAX30102Sim_Recording_t));
+                fclose(f);
+                return -1;
+            }
+            rec->red = red;
+            rec->ir = ir;
+        }
+        rec->red[rec->count] = (uint32_t)(fields == 3 ? b : a);
+        rec->ir[rec->count] = (uint32_t)(fields == 3 ? c : b);
+        rec->count++;
+    }
+    fclose(f);
+    if (rec->count == 0) {
+        return -1;
+    }
+    rec->rate_hz = rate_hz;
+    return 0;
+}
+
+void MAX30102Sim_FreeRecording(MAX30102Sim_Recording_t *rec) {
+    free(rec->red);
+    free(rec->ir);
+    memset(rec, 0, sizeof(MAX30102Sim_Recording_t));
+}
+
+/**
+ * Source callback (ctx = MAX30102Sim_Recording_t): the recorded sample
+ * nearest to t_us, looping at the end. The recording is a function of time,
+ * so a sensor running at another rate resamples it (sample and hold).
+ */
+void MAX30102Sim_RecordingSource(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    const MAX30102Sim_Recording_t *rec = (const MAX30102Sim_Recording_t *)ctx;
+    uint64_t index = (t_us * rec->rate_hz + 500000u) / 1000000u;
+    index %= rec->count;
+    *red = rec->red[index];
+    *ir = rec->ir[index];
+}
@@ -0,0 +1,109 @@
+/**
+ * @file oled_sim.c
+ * @brief Simulated SH1106 128x64 OLED on the hardware I2C bus
+ */
+
+#include "oled_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t has_parameter(uint8_t cmd) {
+    switch (cmd) {
+        case 0x81:      // contrast
+        case 0x8D:      // charge pump (SSD1306)
+        case 0xA8:      // multiplex ratio
+        case 0xAD:      // DC-DC control
+        case 0xD3:      // display offset
+        case 0xD5:      // oscillator
+        case 0xD9:      // pre-charge period
+        case 0xDA:      // COM pins
+        case 0xDB:      // VCOMH
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void command(OLEDSim_t *sim, uint8_t cmd) {
+    sim->commands++;
+    if (sim->param_pending) {
+        sim->param_pending = 0;
+        return;
+    }
+    if (has_parameter(cmd)) {
+        sim->param_pending = 1;
+    } else if (cmd <= 0x0F) {
+        sim->column = (uint8_t)((sim->column & 0xF0) | cmd);
+    } else if (cmd >= 0x10 && cmd <= 0x1F) {
+        sim->column = (uint8_t)((sim->column & 0x0F) | ((cmd & 0x0F) << 4));
+    } else if (cmd >= 0xB0 && cmd <= 0xB7) {
+        sim->page = cmd & 0x07;
+    } else if (cmd == 0xAE || cmd == 0xAF) {
+        sim->display_on = cmd & 1;
+    } else if (cmd == 0xA6 || cmd == 0xA7) {
+        sim->inverted = cmd & 1;
+    }
+}
+
+static uint8_t dev_start(void *ctx, uint8_t read) {
+    OLEDSim_t *sim = (OLEDSim_t *)ctx;
+    sim->control_pending = 1;
+    return read ? 0 : 1;                        // write only
+}
+
+static uint8_t dev_write(void *ctx, uint8_t byte) {
+    OLEDSim_t *sim = (OLEDSim_t *)ctx;
+    if (sim->control_pending) {
+        sim->control_pending = 0;
+        sim->data_mode = (byte & 0x40) ? 1 : 0;
+        return 1;
+    }
+    if (!sim->data_mode) {
+        command(sim, byte);
+        return 1;
+    }
+    if (sim->column < OLED_SIM_RAM_COLUMNS) {
+        sim->ram[sim->page][sim->column++] = byte;
+        if (sim->page == OLED_SIM_HEIGHT / 8 - 1 && sim->column == OLED_SIM_COLUMN_OFFSET + OLED_SIM_WIDTH) {
+            sim->frames++;
+        }
+    }
+    return 1;
+}
+
+void OLEDSim_Init(OLEDSim_t *sim) {
+    memset(sim, 0, sizeof(OLEDSim_t));
+    sim->device.address = OLED_SIM_ADDRESS;
+    sim->device.ctx = sim;
+    sim->device.start = dev_start;
+    sim->device.write = dev_write;
+}
+
+/**
+ * Visible pixel (0/1, display inversion applied).
+ */
+uint8_t OLEDSim_GetPixel(const OLEDSim_t *sim, uint8_t x, uint8_t y) {
+    if (x >= OLED_SIM_WIDTH || y >= OLED_SIM_HEIGHT) {
+        return 0;
+    }
+    uint8_t on = (sim->ram[y / 8][x + OLED_SIM_COLUMN_OFFSET] >> (y % 8)) & 1;
+    return on ^ sim->inverted;
+}
+
+/**
+ * Write the visible area as a plain PBM (P1) image. Returns 0 on success.
+ */
+int OLEDSim_WritePBM(const OLEDSim_t *sim, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "P1\n%d %d\n", OLED_SIM_WIDTH, OLED_SIM_HEIGHT);
+    for (uint8_t y = 0; y < OLED_SIM_HEIGHT; y++) {
+        for (uint8_t x = 0; x < OLED_SIM_WIDTH; x++) {
+            fputc(OLEDSim_GetPixel(sim, x, y) ? '1' : '0', f);
+        }
+        fputc('\n', f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file op_count.cpp
+ * @brief Counters and Cortex-M3 cost table for op_count.h
+ */
+
+#include "op_count.h"
+
+OpCounts_t op_counts;
+
+/*
+ * Default cycles per operation: arm-none-eabi-gcc libgcc soft-float
+ * (ieee754-sf.S) and newlib sqrtf/sinf/cosf on a Cortex-M3 at 72 MHz with two
+ * flash wait states, call and argument set-up included. These are starting
+ * values, not yet measured on the board; replace them with numbers measured
+ * there (DWT profiler around a loop of each operation) via Op_LoadCostTable,
+ * and check the whole table against a profiler capture with
+ * op_count_report -P.
+ */
+double op_cost[OP_KIND_COUNT] = {
+    45.0,       // OP_FADD
+    40.0,       // OP_FMUL
+    110.0,      // OP_FDIV
+    20.0,       // OP_FCMP
+    25.0,       // OP_I2F
+    20.0,       // OP_F2I
+    450.0,      // OP_FSQRT
+    1800.0,     // OP_FTRIG
+    1.0,        // OP_FSIGN
+    2.0,        // OP_LOAD
+    1.0,        // OP_STORE
+    1.0,        // OP_IALU
+    6.0,        // OP_IDIV (UDIV 2-12 cycles; constant divisors become a multiply)
+};
+
+static const char *const op_names[OP_KIND_COUNT] = {
+    "fadd", "fmul", "fdiv", "fcmp", "i2f", "f2i", "fsqrt", "ftrig", "fsign", "load", "store", "ialu", "idiv",
+};
+
+const char *Op_Name(OpKind_t kind) {
+    return ((unsigned)kind < OP_KIND_COUNT) ? op_names[kind] : "unknown";
+}
+
+void Op_Reset(void) {
+    memset(&op_counts, 0, sizeof(op_counts));
+}
+
+void Op_Diff(const OpCounts_t *after, const OpCounts_t *before, OpCounts_t *out) {
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        out->n[k] = after->n[k] - before->n[k];
+    }
+}
+
+double Op_Cycles(const OpCounts_t *counts) {
+    double cycles = 0.0;
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        cycles += (double)counts->n[k] * op_cost[k];
+    }
+    return cycles;
+}
+
+/**
+ * @brief Override entries of the cost table from a text file
+ * @details One "name cycles" pair per line (e.g. "fdiv 96"); '#' starts a
+ *          comment. Operations not listed keep their default cost.
+ * @return 0 on success, -1 if the file cannot be read or has an unknown name
+ */
+int Op_LoadCostTable(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char line[128];
+    int err = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[32];
+        double cycles;
+        char *hash = strchr(line, '#');
+        if (hash != NULL) {
+            *hash = '\0';
+        }
+        if (sscanf(line, "%31s %lf", name, &cycles) != 2) {
+            continue;
+        }
+        int k = 0;
+        while (k < OP_KIND_COUNT && strcmp(name, op_names[k]) != 0) {
+            k++;
+        }
+        if (k == OP_KIND_COUNT) {
+            fprintf(stderr, "%s: unknown operation '%s'\n", path, name);
+            err = -1;
+            continue;
+        }
+        op_cost[k] = cycles;
+    }
+    fclose(f);
+    return err;
+}
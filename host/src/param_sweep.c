@@ -0,0 +1,308 @@
+/**
+ * @file param_sweep.c
+ * @brief Grid / random search of the tuning constants on a work-stealing pool
+ */
+
+#include "param_sweep.h"
+#include "work_pool.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// name, macro, variant, offset, integer, search range
+static const ParamSweep_Param_t params[] = {
+    { "peak_threshold_good",     "PEAK_THRESHOLD_GOOD",     "m1", offsetof(PPG_Params_t, peak_threshold_good),     0, 0.1f, 1.0f },
+    { "peak_threshold",          "PEAK_THRESHOLD",          "m1", offsetof(PPG_Params_t, peak_threshold),          0, 0.1f, 1.0f },
+    { "peak_threshold_poor",     "PEAK_THRESHOLD_POOR",     "m1", offsetof(PPG_Params_t, peak_threshold_poor),     0, 0.1f, 1.2f },
+    { "hr_ema_alpha",            "HR_EMA_ALPHA",            "m1", offsetof(PPG_Params_t, hr_ema_alpha),            0, 0.05f, 1.0f },
+    { "max_hr_change",           "MAX_HR_CHANGE",           "m1", offsetof(PPG_Params_t, max_hr_change),           0, 1.0f, 30.0f },
+    { "invalid_reset_threshold", "INVALID_RESET_THRESHOLD", "m1", offsetof(PPG_Params_t, invalid_reset_threshold), 1, 1.0f, 8.0f },
+    { "dpt_hr_ema_alpha",        "DPT_HR_EMA_ALPHA",        "m2", offsetof(PPG_Params_t, dpt_hr_ema_alpha),        0, 0.05f, 1.0f },
+    { "dpt_max_hr_change",       "DPT_MAX_HR_CHANGE",       "m2", offsetof(PPG_Params_t, dpt_max_hr_change),       0, 1.0f, 30.0f },
+    { "dpt_min_peak_magnitude",  "DPT_MIN_PEAK_MAGNITUDE",  "m2", offsetof(PPG_Params_t, dpt_min_peak_magnitude),  0, 0.05f, 5.0f },
+};
+
+uint32_t ParamSweep_ParamCount(void) {
+    return (uint32_t)(sizeof(params) / sizeof(params[0]));
+}
+
+const ParamSweep_Param_t *ParamSweep_GetParam(uint32_t index) {
+    return (index < ParamSweep_ParamCount()) ? &params[index] : NULL;
+}
+
+const ParamSweep_Param_t *ParamSweep_FindParam(const char *name) {
+    for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+        if (strcmp(params[i].name, name) == 0) {
+            return &params[i];
+        }
+    }
+    return NULL;
+}
+
+float ParamSweep_GetValue(const PPG_Params_t *p, const ParamSweep_Param_t *param) {
+    const uint8_t *field = (const uint8_t *)p + param->offset;
+    if (param->integer) {
+        return (float)*field;
+    }
+    float value;
+    memcpy(&value, field, sizeof(float));
+    return value;
+}
+
+void ParamSweep_SetValue(PPG_Params_t *p, const ParamSweep_Param_t *param, float value) {
+    uint8_t *field = (uint8_t *)p + param->offset;
+    if (param->integer) {
+        *field = (uint8_t)lroundf(value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value));
+    } else {
+        memcpy(field, &value, sizeof(float));
+    }
+}
+
+void ParamSweep_Defaults(PPG_Params_t *p) {
+    static const PPG_Params_t defaults = PPG_PARAMS_DEFAULT;
+    *p = defaults;
+}
+
+static void default_candidate(ParamSweep_Candidate_t *c) {
+    memset(c, 0, sizeof(ParamSweep_Candidate_t));
+    ParamSweep_Defaults(&c->params);
+}
+
+// Grid points of one range: integer ranges have at most one per value
+static uint32_t range_steps(const ParamSweep_Range_t *r, uint32_t steps) {
+    if (r->max <= r->min || steps < 2) {
+        return 1;
+    }
+    if (r->param->integer) {
+        uint32_t values = (uint32_t)(lroundf(r->max) - lroundf(r->min)) + 1;
+        return (values < steps) ? values : steps;
+    }
+    return steps;
+}
+
+static float range_value(const ParamSweep_Range_t *r, uint32_t step, uint32_t steps) {
+    return (steps > 1) ? r->min + (r->max - r->min) * (float)step / (float)(steps - 1) : r->min;
+}
+
+/**
+ * Every combination of steps values per range, after the defaults.
+ * @return number of candidates (the defaults included)
+ */
+uint64_t ParamSweep_Grid(const ParamSweep_Range_t *ranges, uint32_t range_count, uint32_t steps,
+                         ParamSweep_Candidate_t *out) {
+    uint64_t points = 1;
+    for (uint32_t i = 0; i < range_count; i++) {
+        points *= range_steps(&ranges[i], steps);
+    }
+    if (out == NULL) {
+        return points + 1;
+    }
+    default_candidate(&out[0]);
+    for (uint64_t k = 0; k < points; k++) {
+        ParamSweep_Candidate_t *c = &out[k + 1];
+        default_candidate(c);
+        // Mixed-radix digits of k, the first range varying slowest
+        uint64_t rest = k;
+        for (uint32_t i = range_count; i-- > 0;) {
+            uint32_t n = range_steps(&ranges[i], steps);
+            ParamSweep_SetValue(&c->params, ranges[i].param, range_value(&ranges[i], (uint32_t)(rest % n), n));
+            rest /= n;
+        }
+    }
+    return points + 1;
+}
+
+// xorshift64*, as in ppg_synth.c
+static double uniform(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * The defaults and count - 1 uniform draws in the ranges.
+ */
+void ParamSweep_Random(const ParamSweep_Range_t *ranges, uint32_t range_count, uint64_t seed,
+                       ParamSweep_Candidate_t *out, uint32_t count) {
+    uint64_t rng = seed * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+    if (rng == 0) {
+        rng = 1;
+    }
+    for (uint32_t k = 0; k < count; k++) {
+        default_candidate(&out[k]);
+        if (k == 0) {
+            continue;
+        }
+        for (uint32_t i = 0; i < range_count; i++) {
+            const ParamSweep_Range_t *r = &ranges[i];
+            float value;
+            if (r->param->integer) {
+                // Every integer in [min, max] equally likely
+                long lo = lroundf(r->min), hi = lroundf(r->max);
+                value = (float)(lo + (long)(uniform(&rng) * (double)(hi - lo + 1)));
+            } else {
+                value = (float)(r->min + (r->max - r->min) * uniform(&rng));
+            }
+            ParamSweep_SetValue(&out[k].params, r->param, value);
+        }
+    }
+}
+
+typedef struct {
+    const PPGVariant_t *variant;
+    const PPGScore_Record_t *records;
+    uint32_t record_count;
+    ParamSweep_Candidate_t *candidates;
+    PPGScore_Result_t *results;     // [candidate * record_count + record]
+    int *status;
+} Sweep_t;
+
+typedef struct {
+    Sweep_t *sweep;
+    uint32_t candidate;
+    uint32_t record;
+} Run_t;
+
+static void run_task(void *arg, uint32_t worker) {
+    (void)worker;
+    const Run_t *run = (const Run_t *)arg;
+    Sweep_t *s = run->sweep;
+    size_t k = (size_t)run->candidate * s->record_count + run->record;
+    s->status[k] = PPGScore_RunParams(s->variant, &s->candidates[run->candidate].params,
+                                      &s->records[run->record], &s->results[k]);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void objectives(const ParamSweep_Config_t *config, ParamSweep_Candidate_t *c) {
+    PPGScore_Summary_t hr;
+    PPGScore_Summarise(&c->total.hr, &hr);
+    c->accuracy = hr.mae;
+    c->latency = (config->latency == PARAM_SWEEP_LATENCY_FIRST_VALID) ? hr.first_valid_s : hr.lag_s;
+    c->coverage_pct = hr.coverage_pct;
+    c->feasible = (c->failed == 0 && c->total.hr.n > 0 && c->latency >= 0.0 &&
+                   c->coverage_pct >= config->min_coverage_pct);
+}
+
+/**
+ * Score every candidate on every record and pool the records per candidate.
+ * @return 0, -1 if out of memory or the pool cannot be started
+ */
+int ParamSweep_Evaluate(const ParamSweep_Config_t *config, const PPGScore_Record_t *records,
+                        uint32_t record_count, ParamSweep_Candidate_t *candidates, uint32_t count,
+                        ParamSweep_Stats_t *stats) {
+    size_t runs = (size_t)count * record_count;
+    Sweep_t s = { config->variant, records, record_count, candidates, NULL, NULL };
+    s.results = (PPGScore_Result_t *)malloc(runs * sizeof(PPGScore_Result_t));
+    s.status = (int *)malloc(runs * sizeof(int));
+    Run_t *tasks = (Run_t *)malloc(runs * sizeof(Run_t));
+    WorkPool_t pool;
+    if (s.results == NULL || s.status == NULL || tasks == NULL || WorkPool_Init(&pool, config->threads) != 0) {
+        free(s.results);
+        free(s.status);
+        free(tasks);
+        return -1;
+    }
+
+    double t0 = now_s();
+    // Record by record: the candidates running at the same time share the record in cache
+    for (uint32_t r = 0; r < record_count; r++) {
+        for (uint32_t c = 0; c < count; c++) {
+            size_t k = (size_t)c * record_count + r;
+            Run_t *t = &tasks[(size_t)r * count + c];
+            t->sweep = &s;
+            t->candidate = c;
+            t->record = r;
+            s.status[k] = -1;
+            WorkPool_Submit(&pool, run_task, t);
+        }
+    }
+    WorkPool_Wait(&pool);
+
+    memset(stats, 0, sizeof(ParamSweep_Stats_t));
+    stats->wall_s = now_s() - t0;
+    stats->threads = pool.workers;
+    for (uint32_t w = 0; w < pool.workers; w++) {
+        stats->runs += pool.deques[w].executed;
+        stats->steals += pool.deques[w].stolen;
+    }
+    WorkPool_Destroy(&pool);
+
+    for (uint32_t c = 0; c < count; c++) {
+        ParamSweep_Candidate_t *cand = &candidates[c];
+        memset(&cand->total, 0, sizeof(cand->total));
+        cand->failed = 0;
+        for (uint32_t r = 0; r < record_count; r++) {
+            size_t k = (size_t)c * record_count + r;
+            if (s.status[k] != 0) {
+                cand->failed++;
+                continue;
+            }
+            PPGScore_Add(&cand->total.hr, &s.results[k].hr);
+            PPGScore_Add(&cand->total.spo2, &s.results[k].spo2);
+            stats->samples += records[r].count;
+            stats->signal_s += records[r].count / records[r].sample_rate_hz;
+        }
+        objectives(config, cand);
+        cand->pareto = 0;
+    }
+    free(s.results);
+    free(s.status);
+    free(tasks);
+    return 0;
+}
+
+typedef struct {
+    double accuracy;
+    double latency;
+    uint32_t index;
+} Point_t;
+
+static int compare_points(const void *a, const void *b) {
+    const Point_t *pa = (const Point_t *)a, *pb = (const Point_t *)b;
+    if (pa->accuracy != pb->accuracy) return (pa->accuracy > pb->accuracy) - (pa->accuracy < pb->accuracy);
+    if (pa->latency != pb->latency) return (pa->latency > pb->latency) - (pa->latency < pb->latency);
+    return (pa->index > pb->index) - (pa->index < pb->index);
+}
+
+/**
+ * Mark the feasible candidates that no other feasible candidate beats on
+ * both objectives (of identical ones, the first).
+ * @return size of the front
+ */
+uint32_t ParamSweep_Pareto(ParamSweep_Candidate_t *candidates, uint32_t count) {
+    Point_t *points = (Point_t *)malloc((count ? count : 1) * sizeof(Point_t));
+    if (points == NULL) {
+        return 0;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        candidates[i].pareto = 0;
+        if (candidates[i].feasible) {
+            points[n++] = (Point_t){ candidates[i].accuracy, candidates[i].latency, i };
+        }
+    }
+    // By accuracy: a point is on the front when it is faster than every more accurate one
+    qsort(points, n, sizeof(Point_t), compare_points);
+    uint32_t front = 0;
+    double best_latency = INFINITY;
+    for (uint32_t i = 0; i < n; i++) {
+        if (points[i].latency < best_latency) {
+            best_latency = points[i].latency;
+            candidates[points[i].index].pareto = 1;
+            front++;
+        }
+    }
+    free(points);
+    return front;
+}
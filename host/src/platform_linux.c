@@ -0,0 +1,192 @@
+/**
+ * @file platform_linux.c
+ * @brief Linux backend of platform.h: virtual clock and simulated peripherals
+ */
+
+#include "platform_sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t sim_us;
+static I2CSim_Bus_t buses[PLATFORM_SIM_BUS_COUNT];
+static uint8_t pin_level[PLATFORM_PIN_COUNT];
+static Platform_IrqHandler_t exti_handlers[PLATFORM_PIN_COUNT];
+static uint8_t exti_pending[PLATFORM_PIN_COUNT];
+static uint32_t critical_depth;
+static FILE *uart_out;
+static uint8_t uart_rx[PLATFORM_SIM_UART_RX_SIZE];
+static uint16_t uart_rx_head;
+static uint16_t uart_rx_tail;
+
+/**
+ * Clear the clock, detach all devices and release every pin.
+ */
+void PlatformSim_Reset(void) {
+    sim_us = 0;
+    for (int i = 0; i < PLATFORM_SIM_BUS_COUNT; i++) {
+        I2CSim_Init(&buses[i]);
+    }
+    for (int i = 0; i < PLATFORM_PIN_COUNT; i++) {
+        pin_level[i] = 1;
+        exti_handlers[i] = NULL;
+        exti_pending[i] = 0;
+    }
+    critical_depth = 0;
+    uart_out = stdout;
+    uart_rx_head = 0;
+    uart_rx_tail = 0;
+}
+
+int PlatformSim_Attach(PlatformSim_Bus_t bus, const I2CSim_Device_t *device) {
+    return I2CSim_Attach(&buses[bus], device);
+}
+
+I2CSim_Bus_t *PlatformSim_GetBus(PlatformSim_Bus_t bus) {
+    return &buses[bus];
+}
+
+uint64_t PlatformSim_GetUs(void) {
+    return sim_us;
+}
+
+/**
+ * Advance the virtual clock and let the devices catch up.
+ */
+void PlatformSim_Advance(uint64_t us) {
+    sim_us += us;
+    for (int i = 0; i < PLATFORM_SIM_BUS_COUNT; i++) {
+        I2CSim_Update(&buses[i], sim_us);
+    }
+}
+
+/**
+ * Drive an input pin from a device. A falling edge raises the pin's EXTI
+ * handler, immediately or when the current critical section ends.
+ */
+void PlatformSim_SetPin(Platform_Pin_t pin, uint8_t level) {
+    uint8_t before = pin_level[pin];
+    pin_level[pin] = level ? 1 : 0;
+    if (before && !pin_level[pin] && exti_handlers[pin] != NULL) {
+        if (critical_depth > 0) {
+            exti_pending[pin] = 1;
+        } else {
+            exti_handlers[pin]();
+        }
+    }
+}
+
+void PlatformSim_SetUartOutput(FILE *out) {
+    uart_out = out;
+}
+
+/**
+ * Queue bytes for Platform_UART_ReadByte. Returns the number of bytes queued.
+ */
+int PlatformSim_UartInput(const uint8_t *data, uint16_t len) {
+    int queued = 0;
+    for (uint16_t i = 0; i < len; i++) {
+        uint16_t next = (uint16_t)((uart_rx_head + 1) % PLATFORM_SIM_UART_RX_SIZE);
+        if (next == uart_rx_tail) {
+            break;
+        }
+        uart_rx[uart_rx_head] = data[i];
+        uart_rx_head = next;
+        queued++;
+    }
+    return queued;
+}
+
+/* ---------------- platform.h ---------------- */
+
+void Platform_Init(void) {
+    // Devices are attached by the simulation before App_Init
+}
+
+uint32_t Platform_GetTickMs(void) {
+    return (uint32_t)(sim_us / 1000u);
+}
+
+uint64_t Platform_GetUs(void) {
+    return sim_us;
+}
+
+void Platform_DelayMs(uint32_t ms) {
+    PlatformSim_Advance((uint64_t)ms * 1000u);
+}
+
+void Platform_DelayUs(uint16_t us) {
+    PlatformSim_Advance(us);
+}
+
+void Platform_GPIO_Write(Platform_Pin_t pin, uint8_t level) {
+    switch (pin) {
+        case PLATFORM_PIN_I2C_SCL:
+            I2CSim_SetScl(&buses[PLATFORM_SIM_SOFT_I2C], level);
+            break;
+        case PLATFORM_PIN_I2C_SDA:
+            I2CSim_SetSda(&buses[PLATFORM_SIM_SOFT_I2C], level);
+            break;
+        default:
+            break;                          // input pins are driven by the devices
+    }
+}
+
+uint8_t Platform_GPIO_Read(Platform_Pin_t pin) {
+    switch (pin) {
+        case PLATFORM_PIN_I2C_SCL:
+            return buses[PLATFORM_SIM_SOFT_I2C].scl;
+        case PLATFORM_PIN_I2C_SDA:
+            return I2CSim_GetSda(&buses[PLATFORM_SIM_SOFT_I2C]);
+        default:
+            return pin_level[pin];
+    }
+}
+
+void Platform_EXTI_SetHandler(Platform_Pin_t pin, Platform_IrqHandler_t handler) {
+    exti_handlers[pin] = handler;
+}
+
+void Platform_EnterCritical(void) {
+    critical_depth++;
+}
+
+void Platform_ExitCritical(void) {
+    if (critical_depth > 0 && --critical_depth == 0) {
+        for (int i = 0; i < PLATFORM_PIN_COUNT; i++) {
+            if (exti_pending[i]) {
+                exti_pending[i] = 0;
+                if (exti_handlers[i] != NULL) {
+                    exti_handlers[i]();
+                }
+            }
+        }
+    }
+}
+
+uint8_t Platform_I2C_Write(uint8_t slave_addr, const uint8_t *data, uint16_t len, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    // Address + data bytes, 9 clocks each
+    PlatformSim_Advance(((uint64_t)len + 1u) * 9u * 1000000u / PLATFORM_SIM_HW_I2C_HZ);
+    return I2CSim_Write(&buses[PLATFORM_SIM_HW_I2C], slave_addr, data, len);
+}
+
+void Platform_UART_Write(const uint8_t *data, uint16_t len) {
+    if (uart_out != NULL) {
+        fwrite(data, 1, len, uart_out);
+    }
+}
+
+uint8_t Platform_UART_ReadByte(uint8_t *byte) {
+    if (uart_rx_tail == uart_rx_head) {
+        return 0;
+    }
+    *byte = uart_rx[uart_rx_tail];
+    uart_rx_tail = (uint16_t)((uart_rx_tail + 1) % PLATFORM_SIM_UART_RX_SIZE);
+    return 1;
+}
+
+void Platform_Halt(void) {
+    fflush(stdout);
+    fprintf(stderr, "Platform_Halt at t=%.3f s\n", (double)sim_us / 1e6);
+    exit(PLATFORM_SIM_HALT_EXIT);
+}
@@ -0,0 +1,1045 @@
+/**
+ * @file ppg_gateway.c
+ * @brief Gateway engine: many concurrent device streams on a pinned thread pool
+ */
+
+#define _GNU_SOURCE
+#include "ppg_gateway.h"
+#include "filter_batch.h"
+#include "ppg_state.h"
+#include "state_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+#define CACHE_LINE      64
+#define FILTER_STEPS    16              // samples per stream and batched filter pass
+#define FILTER_BLOCK    64              // streams per FilterBatch: a pass stays in L1/L2
+#define PRIVATE_RING_BYTES  (sizeof(ShmRing_Ctrl_t) + PPG_GATEWAY_RING_SAMPLES * sizeof(ShmRing_Frame_t))
+#define CHECKPOINT_MAGIC    "PPGCKPT\n"
+#define CHECKPOINT_SLACK    64          // per encoded state: tags, widths, counts
+#define CHECKPOINT_EXTRA    (2 * (sizeof(PPG_FilterState_t) + CHECKPOINT_SLACK))
+
+// What a stream publishes: written once per batch or update, read by others
+typedef struct {
+    _Atomic uint32_t seq;                           // seqlock over out / out_sample, odd while writing
+    PPGVariant_Output_t out[PPG_GATEWAY_MAX_VARIANTS];
+    uint64_t out_sample[PPG_GATEWAY_MAX_VARIANTS];
+    PPGGateway_Hist_t latency;
+    PPGGateway_Hist_t service;
+} Gateway_Report_t;
+
+typedef struct {
+    // Input, read in place: the worker's private ring or config.ingest's
+    ShmRing_t in;
+    uint8_t *state[PPG_GATEWAY_MAX_VARIANTS];       // in the worker's state pools (or arena)
+    Gateway_Report_t *report;                       // in the worker's report pool
+    _Alignas(CACHE_LINE) _Atomic uint64_t samples;
+    _Atomic uint64_t batches;
+} Gateway_Stream_t;
+
+typedef struct {
+    PPGGateway_t *gw;
+    uint32_t index;
+    uint32_t first;                                 // streams first .. first + count - 1
+    uint32_t count;
+    pthread_t thread;
+    int started;
+    int failed;
+    Gateway_Stream_t *streams;
+    // Variant states: one pool per variant, each batch of FILTER_BLOCK streams
+    // a run of it, or (config.state_arena) one block per stream with them all
+    StatePool_t pool[PPG_GATEWAY_MAX_VARIANTS];
+    uint8_t *arena;
+    StatePool_t reports;
+    uint8_t *rings;                                 // their private input rings (no config.ingest)
+    PPGGateway_Event_t *events;
+    uint32_t event_capacity;                        // power of two
+    // Batched filters (config.filter_batch), one FilterBatch per block of
+    // FILTER_BLOCK streams: lanes 2j / 2j+1 are the block's stream j red / IR
+    FilterBatch_t *filters;
+    uint32_t filter_blocks;
+    uint32_t *filter_raw;                           // [FILTER_STEPS][2 * FILTER_BLOCK]
+    int32_t *filter_active;
+    float *filter_ac;
+    float *filter_dc;
+    uint32_t filter_steps[FILTER_BLOCK];            // per stream of the block, this pass
+    uint32_t filter_tail[FILTER_BLOCK];
+    // Checkpoints (config.checkpoint_path)
+    uint8_t *slot;                                  // snapshot being written / read
+    uint32_t checkpoint_next;                       // round robin over the worker's streams
+    uint32_t checkpoint_quota;                      // streams per tick, 0: only at Stop
+    uint32_t restored;
+    _Atomic uint64_t checkpoints;
+    _Atomic uint64_t checkpoint_errors;
+    _Atomic uint64_t ticks;
+    _Atomic uint64_t overruns;
+    _Atomic uint64_t busy_ns;
+    _Atomic uint64_t events_queued;
+    _Atomic uint64_t events_dropped;
+    // Adaptive variants: escalations allowed (last tick within config.escalation_load),
+    // and what their selectors did
+    uint8_t may_escalate;
+    _Atomic uint64_t engine_samples[PPG_ADAPTIVE_ENGINES];
+    _Atomic uint64_t escalations;
+    _Atomic uint64_t deescalations;
+    _Atomic uint64_t escalations_held;
+    int llc_fd;                                     // the worker's last-level cache misses, -1: no counter
+    _Atomic uint64_t llc_misses;
+    _Alignas(CACHE_LINE) _Atomic uint32_t event_head;   // worker
+    _Alignas(CACHE_LINE) _Atomic uint32_t event_tail;   // PPGGateway_PollEvents
+} Gateway_Worker_t;
+
+struct PPGGateway {
+    PPGGateway_Config_t config;
+    Gateway_Worker_t *workers;
+    Gateway_Stream_t **stream;                      // by id, set by the owning worker
+    size_t state_offset[PPG_GATEWAY_MAX_VARIANTS];
+    size_t state_stride;                            // bytes of variant state per stream
+    int filter_batch;                               // config.filter_batch and a variant takes it
+    int checkpoint_fd;                              // -1: none
+    int checkpoint_valid;                           // header matched: slots may be restored
+    size_t slot_bytes;
+    uint32_t cpus;
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cond;
+    uint32_t ready;                                 // workers done initialising
+    _Atomic int stop;
+    int running;
+    uint64_t start_ns;
+    uint64_t stop_ns;
+};
+
+// ---- Helpers ----
+
+uint64_t PPGGateway_NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// Statistics counters have a single writer: no locked read-modify-write needed
+static inline void counter_add(_Atomic uint64_t *c, uint64_t n) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static inline uint64_t counter_get(_Atomic uint64_t *c) {
+    return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+static size_t align_up(size_t n) {
+    return (n + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+}
+
+// ---- Histograms: 64 ns units, four buckets per octave ----
+
+static uint32_t hist_bucket(uint64_t ns) {
+    uint64_t v = ns >> 6;
+    if (v < 4) {
+        return (uint32_t)v;
+    }
+    uint32_t k = 63u - (uint32_t)__builtin_clzll(v);
+    uint32_t b = 4 * (k - 1) + (uint32_t)((v >> (k - 2)) & 3);
+    return b < PPG_GATEWAY_HIST_BUCKETS ? b : PPG_GATEWAY_HIST_BUCKETS - 1;
+}
+
+// Upper edge of a bucket (ns)
+static uint64_t hist_upper(uint32_t b) {
+    if (b < 4) {
+        return (uint64_t)(b + 1) << 6;
+    }
+    uint32_t k = b / 4 + 1;
+    return ((uint64_t)(5 + b % 4) << (k - 2)) << 6;
+}
+
+void PPGGateway_HistRecord(PPGGateway_Hist_t *h, uint64_t ns) {
+    _Atomic uint32_t *c = &h->count[hist_bucket(ns)];
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1, memory_order_relaxed);
+    if (ns > atomic_load_explicit(&h->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_ns, ns, memory_order_relaxed);
+    }
+}
+
+static uint64_t counts_percentile(const uint64_t *counts, uint64_t max_ns, double pct) {
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < PPG_GATEWAY_HIST_BUCKETS; b++) {
+        total += counts[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // Smallest bucket holding at least pct of the values
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < PPG_GATEWAY_HIST_BUCKETS; b++) {
+        seen += counts[b];
+        if (seen >= rank) {
+            if (b == PPG_GATEWAY_HIST_BUCKETS - 1) {
+                break;                  // open-ended
+            }
+            uint64_t upper = hist_upper(b);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+static uint64_t hist_read(const PPGGateway_Hist_t *h, uint64_t *counts) {
+    for (uint32_t b = 0; b < PPG_GATEWAY_HIST_BUCKETS; b++) {
+        counts[b] = atomic_load_explicit(&h->count[b], memory_order_relaxed);
+    }
+    return atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+}
+
+uint64_t PPGGateway_HistPercentile(const PPGGateway_Hist_t *h, double pct) {
+    uint64_t counts[PPG_GATEWAY_HIST_BUCKETS];
+    uint64_t max_ns = hist_read(h, counts);
+    return counts_percentile(counts, max_ns, pct);
+}
+
+// ---- Last-level cache misses of a worker (perf_event_open) ----
+
+// The calling thread's, user space only. -1 where the kernel offers no
+// hardware counter (most containers and virtual machines)
+static int llc_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void llc_read(Gateway_Worker_t *w) {
+    uint64_t n;
+    if (w->llc_fd >= 0 && read(w->llc_fd, &n, sizeof(n)) == (ssize_t)sizeof(n)) {
+        atomic_store_explicit(&w->llc_misses, n, memory_order_relaxed);
+    }
+}
+
+// ---- Workers ----
+
+static void pin_worker(const PPGGateway_t *gw, uint32_t index) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % gw->cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);     // best effort
+}
+
+// ---- Checkpoints ----
+
+static off_t slot_offset(const PPGGateway_t *gw, uint32_t id) {
+    return (off_t)PPG_GATEWAY_CHECKPOINT_HEADER + (off_t)id * (off_t)gw->slot_bytes;
+}
+
+// Everything a slot must agree with, zero-padded to the header size
+static void checkpoint_header(const PPGGateway_t *gw, uint8_t *buf) {
+    PPGState_Writer_t h;
+    memset(buf, 0, PPG_GATEWAY_CHECKPOINT_HEADER);
+    PPGState_WriterInit(&h, buf, PPG_GATEWAY_CHECKPOINT_HEADER);
+    for (const char *c = CHECKPOINT_MAGIC; *c; c++) {
+        PPGState_PutU8(&h, (uint8_t)*c);
+    }
+    PPGState_PutU32(&h, PPG_STATE_VERSION);
+    PPGState_PutU32(&h, gw->config.streams);
+    PPGState_PutU32(&h, (uint32_t)gw->slot_bytes);
+    PPGState_PutF32(&h, gw->config.sample_rate_hz);
+    PPGState_PutU8(&h, (uint8_t)gw->filter_batch);
+    PPGState_PutU8(&h, (uint8_t)gw->config.variant_count);
+    for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+        const char *name = gw->config.variants[v]->name;
+        PPGState_PutU8(&h, (uint8_t)strlen(name));
+        for (const char *c = name; *c; c++) {
+            PPGState_PutU8(&h, (uint8_t)*c);
+        }
+    }
+}
+
+// Open the checkpoint file; slots are restored only if its header matches,
+// else it is emptied and set up for this configuration. 0, -1
+static int checkpoint_open(PPGGateway_t *gw) {
+    uint8_t expect[PPG_GATEWAY_CHECKPOINT_HEADER], found[PPG_GATEWAY_CHECKPOINT_HEADER];
+    int fd = open(gw->config.checkpoint_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    checkpoint_header(gw, expect);
+    gw->checkpoint_valid = (pread(fd, found, sizeof(found), 0) == (ssize_t)sizeof(found) &&
+                            memcmp(found, expect, sizeof(found)) == 0);
+    if (!gw->checkpoint_valid) {
+        // Old slots must not be taken for this configuration's
+        if (ftruncate(fd, 0) != 0 || pwrite(fd, expect, sizeof(expect), 0) != (ssize_t)sizeof(expect) ||
+            ftruncate(fd, slot_offset(gw, gw->config.streams)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    gw->checkpoint_fd = fd;
+    return 0;
+}
+
+// Snapshot of stream i of the worker into its slot; the worker's thread only
+static void checkpoint_save(Gateway_Worker_t *w, uint32_t i) {
+    PPGGateway_t *gw = w->gw;
+    Gateway_Stream_t *s = &w->streams[i];
+    uint8_t extra[CHECKPOINT_EXTRA];
+    PPGState_Writer_t x;
+    PPGState_WriterInit(&x, extra, sizeof(extra));
+    if (gw->filter_batch) {
+        // The stream's red / IR filters live in the block's FilterBatch lanes
+        for (uint32_t ch = 0; ch < 2; ch++) {
+            PPG_FilterState_t f;
+            PPG_Filter_Init(&f);
+            FilterBatch_StoreLane(&w->filters[i / FILTER_BLOCK], 2 * (i % FILTER_BLOCK) + ch, &f);
+            PPGState_PutFilter(&x, &f);
+        }
+    }
+    void *states[PPG_GATEWAY_MAX_VARIANTS];
+    for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+        states[v] = s->state[v];
+    }
+    size_t n = x.error ? 0 : PPGState_SaveStream(w->slot, gw->slot_bytes, w->first + i, counter_get(&s->samples),
+                                                 gw->config.variants, states, gw->config.variant_count,
+                                                 extra, (uint32_t)x.len);
+    if (n == 0 || pwrite(gw->checkpoint_fd, w->slot, n, slot_offset(gw, w->first + i)) != (ssize_t)n) {
+        counter_add(&w->checkpoint_errors, 1);
+        return;
+    }
+    counter_add(&w->checkpoints, 1);
+}
+
+// Resume stream i of the worker from its slot if it holds a valid snapshot,
+// else leave it as Init made it
+static void checkpoint_restore(Gateway_Worker_t *w, uint32_t i) {
+    PPGGateway_t *gw = w->gw;
+    Gateway_Stream_t *s = &w->streams[i];
+    ssize_t got = pread(gw->checkpoint_fd, w->slot, gw->slot_bytes, slot_offset(gw, w->first + i));
+    void *states[PPG_GATEWAY_MAX_VARIANTS];
+    for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+        states[v] = s->state[v];
+    }
+    uint32_t id;
+    uint64_t samples;
+    const uint8_t *extra;
+    uint32_t extra_len;
+    int ok = got > 0 &&
+             PPGState_LoadStream(w->slot, (size_t)got, &id, &samples, gw->config.variants, states,
+                                 gw->config.variant_count, &extra, &extra_len) == 0 &&
+             id == w->first + i;
+    PPG_FilterState_t f[2];
+    if (ok && gw->filter_batch) {
+        PPGState_Reader_t r;
+        PPGState_ReaderInit(&r, extra, extra_len);
+        for (uint32_t ch = 0; ch < 2; ch++) {
+            PPG_Filter_Init(&f[ch]);
+            ok &= (PPGState_GetFilter(&r, &f[ch]) == 0);
+        }
+        ok &= (r.pos == r.len);
+    } else if (ok) {
+        ok = (extra_len == 0);
+    }
+    if (!ok) {
+        for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+            gw->config.variants[v]->init(s->state[v], gw->config.sample_rate_hz);
+        }
+        return;
+    }
+    if (gw->filter_batch) {
+        for (uint32_t ch = 0; ch < 2; ch++) {
+            FilterBatch_LoadLane(&w->filters[i / FILTER_BLOCK], 2 * (i % FILTER_BLOCK) + ch, &f[ch]);
+        }
+    }
+    atomic_store_explicit(&s->samples, samples, memory_order_relaxed);
+    w->restored++;
+}
+
+// Variant states and reports of the worker's streams: the states of a batch
+// (the streams of a FilterBatch block) at consecutive handles of each
+// variant's pool, the reports apart from them. 0, -1
+static int worker_alloc_states(Gateway_Worker_t *w) {
+    PPGGateway_t *gw = w->gw;
+    size_t count = w->count ? w->count : 1;
+    if (StatePool_Init(&w->reports, sizeof(Gateway_Report_t), FILTER_BLOCK, (uint32_t)count) != 0) {
+        return -1;
+    }
+    if (gw->config.state_arena) {
+        w->arena = (uint8_t *)aligned_alloc(CACHE_LINE, count * gw->state_stride);
+        if (w->arena == NULL) {
+            return -1;
+        }
+    } else {
+        for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+            if (StatePool_Init(&w->pool[v], gw->config.variants[v]->state_size, FILTER_BLOCK,
+                               (uint32_t)count) != 0) {
+                return -1;
+            }
+        }
+    }
+    for (uint32_t first = 0; first < w->count; first += FILTER_BLOCK) {
+        uint32_t n = (w->count - first < FILTER_BLOCK) ? w->count - first : FILTER_BLOCK;
+        StatePool_Handle_t report = StatePool_AllocRun(&w->reports, n);
+        StatePool_Handle_t state[PPG_GATEWAY_MAX_VARIANTS];
+        for (uint32_t v = 0; v < gw->config.variant_count && !gw->config.state_arena; v++) {
+            if ((state[v] = StatePool_AllocRun(&w->pool[v], n)) == STATE_POOL_NONE) {
+                return -1;
+            }
+        }
+        if (report == STATE_POOL_NONE) {
+            return -1;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            Gateway_Stream_t *s = &w->streams[first + j];
+            s->report = (Gateway_Report_t *)StatePool_Get(&w->reports, report + j);
+            memset(s->report, 0, sizeof(Gateway_Report_t));
+            for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+                s->state[v] = gw->config.state_arena ?
+                              w->arena + (size_t)(first + j) * gw->state_stride + gw->state_offset[v] :
+                              (uint8_t *)StatePool_Get(&w->pool[v], state[v] + j);
+            }
+        }
+    }
+    return 0;
+}
+
+// Allocated and initialised on the worker's own CPU (first touch)
+static int worker_alloc(Gateway_Worker_t *w) {
+    PPGGateway_t *gw = w->gw;
+    size_t count = w->count ? w->count : 1;
+    w->streams = (Gateway_Stream_t *)aligned_alloc(CACHE_LINE, count * sizeof(Gateway_Stream_t));
+    w->events = (PPGGateway_Event_t *)malloc(w->event_capacity * sizeof(PPGGateway_Event_t));
+    if (w->streams == NULL || w->events == NULL) {
+        return -1;
+    }
+    memset(w->streams, 0, count * sizeof(Gateway_Stream_t));
+    if (worker_alloc_states(w) != 0) {
+        return -1;
+    }
+    if (gw->config.ingest == NULL) {
+        w->rings = (uint8_t *)aligned_alloc(CACHE_LINE, count * PRIVATE_RING_BYTES);
+        if (w->rings == NULL) {
+            return -1;
+        }
+        memset(w->rings, 0, count * PRIVATE_RING_BYTES);
+    }
+    if (gw->filter_batch) {
+        size_t cells = (size_t)FILTER_STEPS * 2 * FILTER_BLOCK;
+        w->filter_raw = (uint32_t *)malloc(cells * sizeof(uint32_t));
+        w->filter_active = (int32_t *)malloc(cells * sizeof(int32_t));
+        w->filter_ac = (float *)malloc(cells * sizeof(float));
+        w->filter_dc = (float *)malloc(cells * sizeof(float));
+        w->filter_blocks = (w->count + FILTER_BLOCK - 1) / FILTER_BLOCK;
+        w->filters = (FilterBatch_t *)calloc(w->filter_blocks, sizeof(FilterBatch_t));
+        if (w->filter_raw == NULL || w->filter_active == NULL || w->filter_ac == NULL ||
+            w->filter_dc == NULL || w->filters == NULL) {
+            return -1;
+        }
+        for (uint32_t b = 0; b < w->filter_blocks; b++) {
+            uint32_t streams = (w->count - b * FILTER_BLOCK < FILTER_BLOCK) ? w->count - b * FILTER_BLOCK
+                                                                            : FILTER_BLOCK;
+            if (FilterBatch_Init(&w->filters[b], 2 * streams, SimdIsa_Best()) != 0) {
+                return -1;
+            }
+        }
+    }
+    if (gw->checkpoint_fd >= 0) {
+        w->slot = (uint8_t *)malloc(gw->slot_bytes);
+        if (w->slot == NULL) {
+            return -1;
+        }
+    }
+    w->restored = 0;
+    for (uint32_t i = 0; i < w->count; i++) {
+        Gateway_Stream_t *s = &w->streams[i];
+        if (gw->config.ingest != NULL) {
+            s->in = *ShmRing_Get(gw->config.ingest, w->first + i);
+        } else {
+            uint8_t *ring = w->rings + (size_t)i * PRIVATE_RING_BYTES;
+            s->in.ctrl = (ShmRing_Ctrl_t *)ring;
+            s->in.frames = (ShmRing_Frame_t *)(ring + sizeof(ShmRing_Ctrl_t));
+            s->in.mask = PPG_GATEWAY_RING_SAMPLES - 1;
+            s->in.flags = 0;
+        }
+        for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+            gw->config.variants[v]->init(s->state[v], gw->config.sample_rate_hz);
+        }
+        if (gw->checkpoint_valid) {
+            checkpoint_restore(w, i);
+        }
+        gw->stream[w->first + i] = s;
+    }
+    return 0;
+}
+
+static void publish(Gateway_Worker_t *w, Gateway_Stream_t *s, uint32_t id, uint32_t v,
+                    const PPGVariant_Output_t *out, uint64_t sample) {
+    Gateway_Report_t *r = s->report;
+    uint32_t seq = atomic_load_explicit(&r->seq, memory_order_relaxed);
+    atomic_store_explicit(&r->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    r->out[v] = *out;
+    r->out_sample[v] = sample;
+    atomic_store_explicit(&r->seq, seq + 2, memory_order_release);
+
+    uint32_t head = atomic_load_explicit(&w->event_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&w->event_tail, memory_order_acquire);
+    if (head - tail == w->event_capacity) {
+        counter_add(&w->events_dropped, 1);
+        return;
+    }
+    PPGGateway_Event_t *e = &w->events[head & (w->event_capacity - 1)];
+    e->stream = id;
+    e->variant = v;
+    e->sample = sample;
+    e->out = *out;
+    atomic_store_explicit(&w->event_head, head + 1, memory_order_release);
+    counter_add(&w->events_queued, 1);
+}
+
+// Pooled states: the variant states of stream i of the worker on their way
+// into the cache while the one before it runs; each is one contiguous span
+static inline void prefetch_stream(const Gateway_Worker_t *w, uint32_t i) {
+    if (w->gw->config.state_arena || i >= w->count) {
+        return;
+    }
+    for (uint32_t v = 0; v < w->gw->config.variant_count; v++) {
+        StatePool_Prefetch(&w->pool[v], w->streams[i].state[v]);
+    }
+}
+
+// The worker's load decides for the adaptive variants of a stream whether they may escalate
+// in this batch; what they did in it goes to the worker's counters
+static void adaptive_begin(const Gateway_Worker_t *w, Gateway_Stream_t *s, PPG_Adaptive_t *before) {
+    const PPGGateway_Config_t *cfg = &w->gw->config;
+    for (uint32_t v = 0; v < cfg->variant_count; v++) {
+        if (cfg->variants[v]->adaptive != NULL) {
+            PPG_Adaptive_t *a = cfg->variants[v]->adaptive(s->state[v]);
+            a->may_escalate = w->may_escalate;
+            before[v] = *a;
+        }
+    }
+}
+
+static void adaptive_end(Gateway_Worker_t *w, Gateway_Stream_t *s, const PPG_Adaptive_t *before) {
+    const PPGGateway_Config_t *cfg = &w->gw->config;
+    for (uint32_t v = 0; v < cfg->variant_count; v++) {
+        if (cfg->variants[v]->adaptive != NULL) {
+            const PPG_Adaptive_t *a = cfg->variants[v]->adaptive(s->state[v]);
+            for (uint32_t e = 0; e < PPG_ADAPTIVE_ENGINES; e++) {
+                counter_add(&w->engine_samples[e], (uint32_t)(a->samples[e] - before[v].samples[e]));
+            }
+            counter_add(&w->escalations, (uint32_t)(a->escalations - before[v].escalations));
+            counter_add(&w->deescalations, (uint32_t)(a->deescalations - before[v].deescalations));
+            counter_add(&w->escalations_held, (uint32_t)(a->held - before[v].held));
+        }
+    }
+}
+
+// Everything that arrived since the last visit (at most limit samples), in one batch.
+// Batched filters: sample k of the batch is row k of the block's filter pass
+static void drain_stream(Gateway_Worker_t *w, Gateway_Stream_t *s, uint32_t id, uint32_t limit,
+                         uint64_t shared_ns) {
+    const PPGGateway_Config_t *cfg = &w->gw->config;
+    uint32_t tail;
+    uint32_t n = ShmRing_Peek(&s->in, &tail);
+    if (n == 0) {
+        return;
+    }
+    const uint32_t head = tail + (n > limit ? limit : n);
+    uint64_t t0 = PPGGateway_NowNs();
+    uint64_t oldest = ShmRing_Frame(&s->in, tail)->t_ns;
+    uint64_t processed = counter_get(&s->samples);
+    const size_t lane = 2 * (size_t)((id - w->first) % FILTER_BLOCK);
+    PPG_Adaptive_t adaptive[PPG_GATEWAY_MAX_VARIANTS];
+    adaptive_begin(w, s, adaptive);
+    for (uint32_t k = 0; tail != head; tail++, k++) {
+        const ShmRing_Frame_t *x = ShmRing_Frame(&s->in, tail);
+        PPGVariant_Filtered_t in;
+        if (w->gw->filter_batch) {
+            const size_t cell = k * 2 * FILTER_BLOCK + lane;
+            in.ac[0] = w->filter_ac[cell];
+            in.ac[1] = w->filter_ac[cell + 1];
+            in.dc[0] = w->filter_dc[cell];
+            in.dc[1] = w->filter_dc[cell + 1];
+        }
+        processed++;
+        for (uint32_t v = 0; v < cfg->variant_count; v++) {
+            const PPGVariant_t *variant = cfg->variants[v];
+            PPGVariant_Output_t out;
+            uint8_t updated = (w->gw->filter_batch && variant->process_filtered != NULL) ?
+                              variant->process_filtered(s->state[v], &in, &out) :
+                              variant->process(s->state[v], x->red, x->ir, &out);
+            if (updated) {
+                publish(w, s, id, v, &out, processed);
+            }
+        }
+    }
+    ShmRing_Release(&s->in, tail);
+    adaptive_end(w, s, adaptive);
+    atomic_store_explicit(&s->samples, processed, memory_order_relaxed);
+    counter_add(&s->batches, 1);
+
+    uint64_t t1 = PPGGateway_NowNs();
+    PPGGateway_HistRecord(&s->report->latency, t1 > oldest ? t1 - oldest : 0);
+    PPGGateway_HistRecord(&s->report->service, t1 - t0 + shared_ns);
+}
+
+// Batched filters: up to FILTER_STEPS samples of every stream of a block
+// through its FilterBatch (streams with fewer samples masked out), then the
+// rest of the variants stream by stream. Service time includes an equal
+// share of the filter pass. Returns 0 once nothing is left.
+static int drain_filtered(Gateway_Worker_t *w, uint32_t block) {
+    const uint32_t channels = 2 * FILTER_BLOCK;
+    const uint32_t first = block * FILTER_BLOCK;
+    const uint32_t count = (w->count - first < FILTER_BLOCK) ? w->count - first : FILTER_BLOCK;
+    uint64_t t0 = PPGGateway_NowNs();
+    uint32_t steps = 0, streams = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n = ShmRing_Peek(&w->streams[first + i].in, &w->filter_tail[i]);
+        n = (n > FILTER_STEPS) ? FILTER_STEPS : n;
+        w->filter_steps[i] = n;
+        steps = (n > steps) ? n : steps;
+        streams += (n > 0);
+    }
+    if (steps == 0) {
+        return 0;
+    }
+    for (uint32_t k = 0; k < steps; k++) {
+        uint32_t *raw = w->filter_raw + (size_t)k * channels;
+        int32_t *active = w->filter_active + (size_t)k * channels;
+        for (uint32_t i = 0; i < count; i++) {
+            Gateway_Stream_t *s = &w->streams[first + i];
+            int32_t on = (k < w->filter_steps[i]);
+            if (on) {
+                const ShmRing_Frame_t *x = ShmRing_Frame(&s->in, w->filter_tail[i] + k);
+                raw[2 * i] = x->red;
+                raw[2 * i + 1] = x->ir;
+            }
+            active[2 * i] = on;
+            active[2 * i + 1] = on;
+        }
+        FilterBatch_Process(&w->filters[block], raw, active, w->filter_ac + (size_t)k * channels,
+                            w->filter_dc + (size_t)k * channels);
+    }
+    uint64_t shared_ns = (PPGGateway_NowNs() - t0) / streams;
+    for (uint32_t i = 0; i < count; i++) {
+        if (w->filter_steps[i] > 0) {
+            prefetch_stream(w, first + i + 1);
+            drain_stream(w, &w->streams[first + i], w->first + first + i, w->filter_steps[i], shared_ns);
+        }
+    }
+    return 1;
+}
+
+static void *worker_main(void *arg) {
+    Gateway_Worker_t *w = (Gateway_Worker_t *)arg;
+    PPGGateway_t *gw = w->gw;
+    if (gw->config.pin) {
+        pin_worker(gw, w->index);
+    }
+    int failed = (worker_alloc(w) != 0);
+    pthread_mutex_lock(&gw->lock);
+    w->failed = failed;
+    gw->ready++;
+    pthread_cond_broadcast(&gw->ready_cond);
+    pthread_mutex_unlock(&gw->lock);
+    if (failed) {
+        return NULL;
+    }
+    w->llc_fd = llc_open();
+
+    uint64_t tick_ns = (uint64_t)gw->config.tick_us * 1000u;
+    uint64_t load_ns = (uint64_t)((double)gw->config.escalation_load * (double)tick_ns);
+    w->may_escalate = 1;
+    uint64_t next = PPGGateway_NowNs();
+    while (!atomic_load_explicit(&gw->stop, memory_order_relaxed)) {
+        uint64_t t0 = PPGGateway_NowNs();
+        if (gw->filter_batch) {
+            for (uint32_t b = 0; b < w->filter_blocks; b++) {
+                while (drain_filtered(w, b)) {
+                }
+            }
+        } else {
+            for (uint32_t i = 0; i < w->count; i++) {
+                prefetch_stream(w, i + 1);
+                drain_stream(w, &w->streams[i], w->first + i, UINT32_MAX, 0);
+            }
+        }
+        for (uint32_t k = 0; k < w->checkpoint_quota; k++) {
+            checkpoint_save(w, w->checkpoint_next);
+            w->checkpoint_next = (w->checkpoint_next + 1) % w->count;
+        }
+        uint64_t t1 = PPGGateway_NowNs();
+        counter_add(&w->busy_ns, t1 - t0);
+        counter_add(&w->ticks, 1);
+        w->may_escalate = (gw->config.escalation_load <= 0.0f || t1 - t0 <= load_ns);
+        llc_read(w);
+
+        next += tick_ns;
+        if (t1 >= next) {
+            counter_add(&w->overruns, 1);
+            next = t1;                  // start the next tick now, do not try to catch up
+            continue;
+        }
+        sleep_until(next);
+    }
+    // Samples still in the rings are not part of the state: on restore, the
+    // devices resend from the sample count
+    if (gw->checkpoint_fd >= 0) {
+        for (uint32_t i = 0; i < w->count; i++) {
+            checkpoint_save(w, i);
+        }
+    }
+    return NULL;
+}
+
+// ---- Public interface ----
+
+/**
+ * Create a gateway (not started).
+ * @return NULL if the configuration is invalid or out of memory
+ */
+PPGGateway_t *PPGGateway_Create(const PPGGateway_Config_t *config) {
+    if (config->streams == 0 || config->variant_count == 0 ||
+        config->variant_count > PPG_GATEWAY_MAX_VARIANTS ||
+        config->sample_rate_hz <= 0.0f || config->tick_us == 0 || config->escalation_load < 0.0f ||
+        (config->ingest != NULL && config->ingest->rings < config->streams)) {
+        return NULL;
+    }
+    for (uint32_t v = 0; v < config->variant_count; v++) {
+        if (config->variants[v] == NULL ||
+            (config->checkpoint_path != NULL && config->variants[v]->save == NULL)) {
+            return NULL;
+        }
+    }
+    PPGGateway_t *gw = (PPGGateway_t *)calloc(1, sizeof(PPGGateway_t));
+    if (gw == NULL) {
+        return NULL;
+    }
+    gw->config = *config;
+    gw->checkpoint_fd = -1;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    gw->cpus = (cpus < 1) ? 1u : (uint32_t)cpus;
+    if (gw->config.workers == 0) {
+        gw->config.workers = gw->cpus;
+    }
+    if (gw->config.workers > PPG_GATEWAY_MAX_WORKERS) {
+        gw->config.workers = PPG_GATEWAY_MAX_WORKERS;
+    }
+    if (gw->config.workers > gw->config.streams) {
+        gw->config.workers = gw->config.streams;
+    }
+
+    for (uint32_t v = 0; v < config->variant_count; v++) {
+        gw->filter_batch |= config->filter_batch && config->variants[v]->process_filtered != NULL;
+    }
+
+    // Each variant's state on its own cache lines
+    for (uint32_t v = 0; v < config->variant_count; v++) {
+        gw->state_offset[v] = gw->state_stride;
+        gw->state_stride += align_up(config->variants[v]->state_size);
+    }
+    // Room for the largest snapshot: an encoded state is never much larger than the state
+    gw->slot_bytes = PPG_STATE_STREAM_HEADER + sizeof(uint32_t) + (gw->filter_batch ? CHECKPOINT_EXTRA : 0);
+    for (uint32_t v = 0; v < config->variant_count; v++) {
+        gw->slot_bytes += 1 + strlen(config->variants[v]->name) + sizeof(uint32_t) +
+                          config->variants[v]->state_size + CHECKPOINT_SLACK;
+    }
+    gw->slot_bytes = (gw->slot_bytes + 511) & ~(size_t)511;
+    // Every stream written once per interval, spread over its ticks
+    uint64_t interval_ticks = (uint64_t)config->checkpoint_interval_ms * 1000u / config->tick_us;
+    if (interval_ticks == 0) {
+        interval_ticks = 1;
+    }
+
+    uint32_t n = gw->config.workers;
+    gw->workers = (Gateway_Worker_t *)aligned_alloc(CACHE_LINE, n * sizeof(Gateway_Worker_t));
+    gw->stream = (Gateway_Stream_t **)calloc(config->streams, sizeof(Gateway_Stream_t *));
+    if (gw->workers == NULL || gw->stream == NULL) {
+        free(gw->workers);
+        free(gw->stream);
+        free(gw);
+        return NULL;
+    }
+    memset(gw->workers, 0, n * sizeof(Gateway_Worker_t));
+    for (uint32_t i = 0; i < n; i++) {
+        Gateway_Worker_t *w = &gw->workers[i];
+        w->gw = gw;
+        w->index = i;
+        w->llc_fd = -1;
+        w->first = (uint32_t)((uint64_t)config->streams * i / n);
+        w->count = (uint32_t)((uint64_t)config->streams * (i + 1) / n) - w->first;
+        // Streams started together update together: room for two rounds of all of them
+        w->event_capacity = PPG_GATEWAY_EVENT_RING;
+        while (w->event_capacity < 2ull * w->count * config->variant_count) {
+            w->event_capacity *= 2;
+        }
+        if (config->checkpoint_path != NULL && config->checkpoint_interval_ms > 0) {
+            w->checkpoint_quota = (uint32_t)((w->count + interval_ticks - 1) / interval_ticks);
+        }
+    }
+    pthread_mutex_init(&gw->lock, NULL);
+    pthread_cond_init(&gw->ready_cond, NULL);
+    return gw;
+}
+
+const PPGGateway_Config_t *PPGGateway_GetConfig(const PPGGateway_t *gw) {
+    return &gw->config;
+}
+
+/**
+ * Start the workers and wait until each has set up its streams.
+ * @return 0, -1 if a thread cannot be started or a worker is out of memory
+ */
+int PPGGateway_Start(PPGGateway_t *gw) {
+    if (gw->running) {
+        return -1;
+    }
+    if (gw->config.checkpoint_path != NULL && checkpoint_open(gw) != 0) {
+        return -1;
+    }
+    atomic_store(&gw->stop, 0);
+    gw->ready = 0;
+    uint32_t started = 0;
+    for (uint32_t i = 0; i < gw->config.workers; i++) {
+        Gateway_Worker_t *w = &gw->workers[i];
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            break;
+        }
+        w->started = 1;
+        started++;
+    }
+    pthread_mutex_lock(&gw->lock);
+    while (gw->ready < started) {
+        pthread_cond_wait(&gw->ready_cond, &gw->lock);
+    }
+    pthread_mutex_unlock(&gw->lock);
+    gw->running = 1;
+    gw->start_ns = PPGGateway_NowNs();
+
+    int failed = (started < gw->config.workers);
+    for (uint32_t i = 0; i < started; i++) {
+        failed |= gw->workers[i].failed;
+    }
+    if (failed) {
+        PPGGateway_Stop(gw);
+        return -1;
+    }
+    return 0;
+}
+
+void PPGGateway_Stop(PPGGateway_t *gw) {
+    if (!gw->running) {
+        return;
+    }
+    atomic_store(&gw->stop, 1);
+    for (uint32_t i = 0; i < gw->config.workers; i++) {
+        if (gw->workers[i].started) {
+            pthread_join(gw->workers[i].thread, NULL);
+            gw->workers[i].started = 0;
+        }
+    }
+    if (gw->checkpoint_fd >= 0) {
+        fdatasync(gw->checkpoint_fd);
+        close(gw->checkpoint_fd);
+        gw->checkpoint_fd = -1;
+    }
+    gw->running = 0;
+    gw->stop_ns = PPGGateway_NowNs();
+}
+
+void PPGGateway_Destroy(PPGGateway_t *gw) {
+    if (gw == NULL) {
+        return;
+    }
+    PPGGateway_Stop(gw);
+    for (uint32_t i = 0; i < gw->config.workers; i++) {
+        free(gw->workers[i].streams);
+        for (uint32_t v = 0; v < gw->config.variant_count; v++) {
+            StatePool_Free(&gw->workers[i].pool[v]);
+        }
+        free(gw->workers[i].arena);
+        StatePool_Free(&gw->workers[i].reports);
+        if (gw->workers[i].llc_fd >= 0) {
+            close(gw->workers[i].llc_fd);
+        }
+        free(gw->workers[i].rings);
+        free(gw->workers[i].events);
+        free(gw->workers[i].slot);
+        for (uint32_t b = 0; b < gw->workers[i].filter_blocks && gw->workers[i].filters != NULL; b++) {
+            FilterBatch_Free(&gw->workers[i].filters[b]);
+        }
+        free(gw->workers[i].filters);
+        free(gw->workers[i].filter_raw);
+        free(gw->workers[i].filter_active);
+        free(gw->workers[i].filter_ac);
+        free(gw->workers[i].filter_dc);
+    }
+    pthread_cond_destroy(&gw->ready_cond);
+    pthread_mutex_destroy(&gw->lock);
+    free(gw->workers);
+    free(gw->stream);
+    free(gw);
+}
+
+int PPGGateway_Push(PPGGateway_t *gw, uint32_t stream, uint32_t red, uint32_t ir, uint64_t arrival_ns) {
+    if (stream >= gw->config.streams || gw->stream[stream] == NULL) {
+        return -1;
+    }
+    return ShmRing_Push(&gw->stream[stream]->in, red, ir, arrival_ns);
+}
+
+uint32_t PPGGateway_PollEvents(PPGGateway_t *gw, PPGGateway_Event_t *events, uint32_t max) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < gw->config.workers && n < max; i++) {
+        Gateway_Worker_t *w = &gw->workers[i];
+        if (w->events == NULL) {
+            continue;
+        }
+        uint32_t tail = atomic_load_explicit(&w->event_tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&w->event_head, memory_order_acquire);
+        while (tail != head && n < max) {
+            events[n++] = w->events[tail & (w->event_capacity - 1)];
+            tail++;
+        }
+        atomic_store_explicit(&w->event_tail, tail, memory_order_release);
+    }
+    return n;
+}
+
+int PPGGateway_GetOutput(PPGGateway_t *gw, uint32_t stream, uint32_t variant, PPGVariant_Output_t *out,
+                         uint64_t *sample) {
+    if (stream >= gw->config.streams || gw->stream[stream] == NULL ||
+        variant >= gw->config.variant_count) {
+        return -1;
+    }
+    const Gateway_Report_t *r = gw->stream[stream]->report;
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&r->seq, memory_order_acquire);
+        *out = r->out[variant];
+        if (sample != NULL) {
+            *sample = r->out_sample[variant];
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&r->seq, memory_order_relaxed);
+    } while ((before & 1u) || before != after);
+    return 0;
+}
+
+int PPGGateway_GetStreamStats(PPGGateway_t *gw, uint32_t stream, PPGGateway_StreamStats_t *stats) {
+    if (stream >= gw->config.streams || gw->stream[stream] == NULL) {
+        return -1;
+    }
+    Gateway_Stream_t *s = gw->stream[stream];
+    stats->samples = counter_get(&s->samples);
+    stats->dropped = atomic_load_explicit(&s->in.ctrl->dropped, memory_order_relaxed);
+    stats->batches = counter_get(&s->batches);
+    stats->latency_p50_ns = PPGGateway_HistPercentile(&s->report->latency, 50.0);
+    stats->latency_p99_ns = PPGGateway_HistPercentile(&s->report->latency, 99.0);
+    stats->latency_max_ns = atomic_load_explicit(&s->report->latency.max_ns, memory_order_relaxed);
+    stats->service_p99_ns = PPGGateway_HistPercentile(&s->report->service, 99.0);
+    return 0;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+void PPGGateway_GetStats(PPGGateway_t *gw, PPGGateway_Stats_t *stats) {
+    memset(stats, 0, sizeof(PPGGateway_Stats_t));
+    stats->streams = gw->config.streams;
+    stats->workers = gw->config.workers;
+    uint64_t end_ns = gw->running ? PPGGateway_NowNs() : gw->stop_ns;
+    stats->wall_s = (gw->start_ns && end_ns > gw->start_ns) ? (end_ns - gw->start_ns) * 1e-9 : 0.0;
+
+    uint64_t busy_ns = 0;
+    stats->llc_counted = (gw->start_ns != 0);
+    for (uint32_t i = 0; i < gw->config.workers; i++) {
+        Gateway_Worker_t *w = &gw->workers[i];
+        stats->llc_counted &= (w->llc_fd >= 0);
+        stats->llc_misses += counter_get(&w->llc_misses);
+        stats->ticks += counter_get(&w->ticks);
+        stats->overruns += counter_get(&w->overruns);
+        stats->restored += w->restored;
+        stats->checkpoints += counter_get(&w->checkpoints);
+        stats->checkpoint_errors += counter_get(&w->checkpoint_errors);
+        stats->events += counter_get(&w->events_queued);
+        stats->events_dropped += counter_get(&w->events_dropped);
+        for (uint32_t e = 0; e < PPG_ADAPTIVE_ENGINES; e++) {
+            stats->engine_samples[e] += counter_get(&w->engine_samples[e]);
+        }
+        stats->escalations += counter_get(&w->escalations);
+        stats->deescalations += counter_get(&w->deescalations);
+        stats->escalations_held += counter_get(&w->escalations_held);
+        busy_ns += counter_get(&w->busy_ns);
+    }
+    stats->busy_s = busy_ns * 1e-9;
+    if (stats->wall_s > 0.0) {
+        stats->utilisation = stats->busy_s / (stats->wall_s * gw->config.workers);
+    }
+
+    uint64_t latency[PPG_GATEWAY_HIST_BUCKETS], service[PPG_GATEWAY_HIST_BUCKETS];
+    uint64_t counts[PPG_GATEWAY_HIST_BUCKETS];
+    memset(latency, 0, sizeof(latency));
+    memset(service, 0, sizeof(service));
+    uint64_t service_max = 0;
+    uint64_t *p99 = (uint64_t *)malloc(gw->config.streams * sizeof(uint64_t));
+    uint32_t measured = 0;
+
+    for (uint32_t id = 0; id < gw->config.streams; id++) {
+        Gateway_Stream_t *s = gw->stream[id];
+        if (s == NULL) {
+            continue;
+        }
+        stats->samples += counter_get(&s->samples);
+        stats->dropped += atomic_load_explicit(&s->in.ctrl->dropped, memory_order_relaxed);
+
+        uint64_t max_ns = hist_read(&s->report->service, counts);
+        for (uint32_t b = 0; b < PPG_GATEWAY_HIST_BUCKETS; b++) {
+            service[b] += counts[b];
+        }
+        if (max_ns > service_max) service_max = max_ns;
+
+        max_ns = hist_read(&s->report->latency, counts);
+        for (uint32_t b = 0; b < PPG_GATEWAY_HIST_BUCKETS; b++) {
+            latency[b] += counts[b];
+        }
+        if (max_ns > stats->latency_max_ns) stats->latency_max_ns = max_ns;
+        if (counter_get(&s->batches) == 0) {
+            continue;
+        }
+        uint64_t q = counts_percentile(counts, max_ns, 99.0);
+        if (q >= stats->stream_p99_max_ns) {
+            stats->stream_p99_max_ns = q;
+            stats->stream_p99_max_id = id;
+        }
+        if (p99 != NULL) {
+            p99[measured++] = q;
+        }
+    }
+    stats->latency_p50_ns = counts_percentile(latency, stats->latency_max_ns, 50.0);
+    stats->latency_p99_ns = counts_percentile(latency, stats->latency_max_ns, 99.0);
+    stats->service_p99_ns = counts_percentile(service, service_max, 99.0);
+    if (measured > 0) {
+        qsort(p99, measured, sizeof(uint64_t), compare_u64);
+        stats->stream_p99_median_ns = p99[measured / 2];
+    }
+    free(p99);
+}
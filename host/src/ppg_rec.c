@@ -0,0 +1,556 @@
+/**
+ * @file ppg_rec.c
+ * @brief Chunked raw-PPG recording container (.ppgrec) with a seek index
+ */
+
+#include "ppg_rec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(PPGRec_Header_t) == 128, "header layout");
+_Static_assert(sizeof(PPGRec_ChunkHeader_t) == 40, "chunk header layout");
+_Static_assert(sizeof(PPGRec_IndexEntry_t) == 40, "index entry layout");
+_Static_assert(sizeof(PPGRec_Footer_t) == 32, "footer layout");
+
+#define ALIGN8(n)   (((n) + 7u) & ~7u)
+
+// CRC-32 tables for slicing by 8: crc_table[0] the byte-at-a-time table,
+// crc_table[k] a byte followed by k zero bytes. Built once, before main
+static uint32_t crc_table[8][256];
+
+__attribute__((constructor))
+static void crc_tables(void) {
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t c = b;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+        }
+        crc_table[0][b] = c;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) {
+            crc_table[k][b] = (crc_table[k - 1][b] >> 8) ^ crc_table[0][crc_table[k - 1][b] & 0xFF];
+        }
+    }
+}
+
+/**
+ * CRC-32 (IEEE 802.3, reflected 0xEDB88320), eight bytes per step.
+ * Start with crc = 0; chain by passing the previous result.
+ */
+uint32_t PPGRec_Crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][p[4]] ^ crc_table[2][p[5]] ^ crc_table[1][p[6]] ^ crc_table[0][p[7]];
+    }
+    for (; len > 0; p++, len--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p) & 0xFF];
+    }
+    return ~crc;
+}
+
+/**
+ * Header of a recording made by this firmware (max30102.c register values,
+ * ppg_algorithm.c SpO2 calibration), compressed samples, no reference.
+ */
+void PPGRec_DefaultHeader(PPGRec_Header_t *header, float sample_rate_hz) {
+    memset(header, 0, sizeof(PPGRec_Header_t));
+    memcpy(header->magic, PPG_REC_MAGIC, sizeof(header->magic));
+    header->version = PPG_REC_VERSION;
+    header->header_size = sizeof(PPGRec_Header_t);
+    header->encoding = PPG_REC_ENC_CODEC;
+    header->chunk_samples = PPG_REC_DEFAULT_CHUNK_SAMPLES;
+    header->sample_rate_hz = sample_rate_hz;
+    header->sensor.fifo_config = 0x0F;
+    header->sensor.mode_config = 0x03;
+    header->sensor.spo2_config = 0x27;
+    header->sensor.led_red_pa = 0x24;
+    header->sensor.led_ir_pa = 0x24;
+    header->sensor.adc_bits = PPG_CODEC_SAMPLE_BITS;
+    header->calibration.spo2_a = -45.060f;
+    header->calibration.spo2_b = 30.354f;
+    header->calibration.spo2_c = 94.845f;
+    header->calibration.red_gain = 1.0f;
+    header->calibration.ir_gain = 1.0f;
+}
+
+// ---------------------------------------------------------------- writer
+
+static uint32_t channel_bytes(uint8_t channels, uint32_t count) {
+    uint32_t bytes = 0;
+    if (channels & PPG_REC_CH_REF_HR) bytes += count * sizeof(float);
+    if (channels & PPG_REC_CH_REF_SPO2) bytes += count * sizeof(float);
+    if (channels & PPG_REC_CH_FLAGS) bytes += count;
+    return bytes;
+}
+
+// Compressed samples into out; 0 if a sample does not fit the codec
+static uint32_t encode_samples(const uint32_t *red, const uint32_t *ir, uint32_t count, uint8_t *out) {
+    PPG_Encoder_t enc;
+    PPG_Encoder_Init(&enc);             // the first block is a keyframe
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (red[i] > PPG_CODEC_SAMPLE_MASK || ir[i] > PPG_CODEC_SAMPLE_MASK) {
+            return 0;
+        }
+        if (PPG_Encoder_Push(&enc, red[i], ir[i])) {
+            pos += PPG_Encoder_Flush(&enc, &out[pos], PPG_CODEC_MAX_BLOCK_BYTES);
+        }
+    }
+    pos += PPG_Encoder_Flush(&enc, &out[pos], PPG_CODEC_MAX_BLOCK_BYTES);
+    return pos;
+}
+
+static int write_chunk(PPGRec_Writer_t *w) {
+    if (w->count == 0) {
+        return 0;
+    }
+    uint32_t n = w->count;
+    PPGRec_ChunkHeader_t ch;
+    memset(&ch, 0, sizeof(ch));
+    memset(w->payload, 0, w->payload_capacity);
+
+    uint32_t pos = 0;
+    ch.encoding = PPG_REC_ENC_PLAIN;
+    if (w->header.encoding == PPG_REC_ENC_CODEC) {
+        pos = encode_samples(w->red, w->ir, n, w->payload);
+        if (pos > 0) {
+            ch.encoding = PPG_REC_ENC_CODEC;
+        } else {
+            w->codec_fallbacks++;
+        }
+    }
+    if (ch.encoding == PPG_REC_ENC_PLAIN) {
+        memcpy(w->payload, w->red, n * sizeof(uint32_t));
+        memcpy(w->payload + n * sizeof(uint32_t), w->ir, n * sizeof(uint32_t));
+        pos = 2 * n * sizeof(uint32_t);
+    }
+    ch.sample_bytes = ALIGN8(pos);
+    pos = ch.sample_bytes;
+    if (w->header.channels & PPG_REC_CH_REF_HR) {
+        memcpy(&w->payload[pos], w->ref_hr, n * sizeof(float));
+        pos += n * sizeof(float);
+    }
+    if (w->header.channels & PPG_REC_CH_REF_SPO2) {
+        memcpy(&w->payload[pos], w->ref_spo2, n * sizeof(float));
+        pos += n * sizeof(float);
+    }
+    if (w->header.channels & PPG_REC_CH_FLAGS) {
+        memcpy(&w->payload[pos], w->flags, n);
+        pos += n;
+    }
+    ch.magic = PPG_REC_CHUNK_MAGIC;
+    ch.count = n;
+    ch.first_sample = w->next_sample - n;
+    ch.timestamp_us = (uint64_t)((double)ch.first_sample * 1e6 / w->header.sample_rate_hz + 0.5);
+    ch.payload_bytes = ALIGN8(pos);
+    ch.crc = PPGRec_Crc32(0, w->payload, ch.payload_bytes);
+
+    if (w->chunk_count == w->index_capacity) {
+        uint32_t capacity = w->index_capacity ? w->index_capacity * 2 : 256;
+        PPGRec_IndexEntry_t *index = (PPGRec_IndexEntry_t *)realloc(w->index, capacity * sizeof(PPGRec_IndexEntry_t));
+        if (index == NULL) {
+            return -1;
+        }
+        w->index = index;
+        w->index_capacity = capacity;
+    }
+    PPGRec_IndexEntry_t *e = &w->index[w->chunk_count];
+    memset(e, 0, sizeof(PPGRec_IndexEntry_t));
+    e->offset = w->offset;
+    e->first_sample = ch.first_sample;
+    e->position = w->position - n;
+    e->timestamp_us = ch.timestamp_us;
+    e->count = n;
+
+    // Whole chunks only, flushed: a reader of the growing file sees complete chunks
+    if (fwrite(&ch, sizeof(ch), 1, w->f) != 1 ||
+        fwrite(w->payload, 1, ch.payload_bytes, w->f) != ch.payload_bytes || fflush(w->f) != 0) {
+        return -1;
+    }
+    w->offset += sizeof(ch) + ch.payload_bytes;
+    w->chunk_count++;
+    w->count = 0;
+    return 0;
+}
+
+static void free_writer(PPGRec_Writer_t *w) {
+    free(w->red);
+    free(w->ir);
+    free(w->ref_hr);
+    free(w->ref_spo2);
+    free(w->flags);
+    free(w->payload);
+    free(w->index);
+}
+
+/**
+ * Start a recording. header: PPGRec_DefaultHeader and changes; magic,
+ * version and size are filled in.
+ * @return 0, -1 if the file cannot be created or the header is invalid
+ */
+int PPGRec_Create(PPGRec_Writer_t *w, const char *path, const PPGRec_Header_t *header) {
+    memset(w, 0, sizeof(PPGRec_Writer_t));
+    uint32_t n = header->chunk_samples;
+    if (n == 0 || n > PPG_REC_MAX_CHUNK_SAMPLES || header->sample_rate_hz <= 0.0f ||
+        header->encoding > PPG_REC_ENC_CODEC) {
+        return -1;
+    }
+    w->header = *header;
+    memcpy(w->header.magic, PPG_REC_MAGIC, sizeof(w->header.magic));
+    w->header.version = PPG_REC_VERSION;
+    w->header.header_size = sizeof(PPGRec_Header_t);
+
+    uint32_t codec_bytes = (n / PPG_CODEC_BLOCK_SIZE + 1) * PPG_CODEC_MAX_BLOCK_BYTES;
+    uint32_t sample_bytes = (codec_bytes > 2 * n * sizeof(uint32_t)) ? codec_bytes : 2 * n * sizeof(uint32_t);
+    w->payload_capacity = ALIGN8(sample_bytes) + ALIGN8(channel_bytes(w->header.channels, n));
+    w->red = (uint32_t *)malloc(n * sizeof(uint32_t));
+    w->ir = (uint32_t *)malloc(n * sizeof(uint32_t));
+    w->ref_hr = (float *)malloc(n * sizeof(float));
+    w->ref_spo2 = (float *)malloc(n * sizeof(float));
+    w->flags = (uint8_t *)malloc(n);
+    w->payload = (uint8_t *)malloc(w->payload_capacity);
+    if (w->red == NULL || w->ir == NULL || w->ref_hr == NULL || w->ref_spo2 == NULL ||
+        w->flags == NULL || w->payload == NULL) {
+        free_writer(w);
+        return -1;
+    }
+    w->f = fopen(path, "wb");
+    if (w->f == NULL || fwrite(&w->header, sizeof(PPGRec_Header_t), 1, w->f) != 1 || fflush(w->f) != 0) {
+        if (w->f != NULL) fclose(w->f);
+        free_writer(w);
+        return -1;
+    }
+    w->offset = sizeof(PPGRec_Header_t);
+    return 0;
+}
+
+/**
+ * Append one sample; ref may be NULL (reference channels then get 0).
+ * A full chunk is written out at once.
+ * @return 0, -1 on a write error
+ */
+int PPGRec_Append(PPGRec_Writer_t *w, uint32_t red, uint32_t ir, const PPGRec_Reference_t *ref) {
+    uint32_t i = w->count;
+    w->red[i] = red;
+    w->ir[i] = ir;
+    w->ref_hr[i] = (ref != NULL) ? ref->hr_bpm : 0.0f;
+    w->ref_spo2[i] = (ref != NULL) ? ref->spo2 : 0.0f;
+    w->flags[i] = (ref != NULL) ? ref->flags : 0;
+    w->count++;
+    w->next_sample++;
+    w->position++;
+    return (w->count == w->header.chunk_samples) ? write_chunk(w) : 0;
+}
+
+/**
+ * Samples were lost: the next appended sample has index next_sample.
+ * @return 0, -1 on a write error or if next_sample goes backwards
+ */
+int PPGRec_Gap(PPGRec_Writer_t *w, uint64_t next_sample) {
+    if (next_sample < w->next_sample || write_chunk(w) != 0) {
+        return -1;
+    }
+    w->next_sample = next_sample;
+    return 0;
+}
+
+/**
+ * Write the last chunk, the index and the footer, and close the file.
+ * @return 0, -1 on a write error
+ */
+int PPGRec_Finish(PPGRec_Writer_t *w) {
+    int status = write_chunk(w);
+    PPGRec_Footer_t footer;
+    memset(&footer, 0, sizeof(footer));
+    memcpy(footer.magic, PPG_REC_FOOTER_MAGIC, sizeof(footer.magic));
+    footer.index_offset = w->offset;
+    footer.total_samples = w->position;
+    footer.chunk_count = w->chunk_count;
+    if (status == 0 &&
+        (fwrite(w->index, sizeof(PPGRec_IndexEntry_t), w->chunk_count, w->f) != w->chunk_count ||
+         fwrite(&footer, sizeof(footer), 1, w->f) != 1)) {
+        status = -1;
+    }
+    if (fclose(w->f) != 0) {
+        status = -1;
+    }
+    free_writer(w);
+    memset(w, 0, sizeof(PPGRec_Writer_t));
+    return status;
+}
+
+// ---------------------------------------------------------------- reader
+
+/**
+ * @return 1 if the file starts with the container magic
+ */
+int PPGRec_IsRecording(const char *path) {
+    char magic[8];
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return 0;
+    }
+    int is = (fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, PPG_REC_MAGIC, sizeof(magic)) == 0);
+    fclose(f);
+    return is;
+}
+
+static const PPGRec_ChunkHeader_t *chunk_at(const PPGRec_Reader_t *r, uint64_t offset) {
+    if (offset + sizeof(PPGRec_ChunkHeader_t) > r->size) {
+        return NULL;
+    }
+    const PPGRec_ChunkHeader_t *ch = (const PPGRec_ChunkHeader_t *)(r->map + offset);
+    if (ch->magic != PPG_REC_CHUNK_MAGIC || ch->count == 0 || ch->count > r->header->chunk_samples ||
+        ch->sample_bytes > ch->payload_bytes ||
+        ch->payload_bytes > r->size - offset - sizeof(PPGRec_ChunkHeader_t)) {
+        return NULL;
+    }
+    return ch;
+}
+
+// No footer: index the complete chunks, stopping at the first bad one
+static int scan_chunks(PPGRec_Reader_t *r) {
+    uint64_t offset = r->header->header_size;
+    uint32_t capacity = 0;
+    const PPGRec_ChunkHeader_t *ch;
+    while ((ch = chunk_at(r, offset)) != NULL &&
+           PPGRec_Crc32(0, (const uint8_t *)(ch + 1), ch->payload_bytes) == ch->crc) {
+        if (r->chunk_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            PPGRec_IndexEntry_t *index = (PPGRec_IndexEntry_t *)realloc(r->scanned, capacity * sizeof(PPGRec_IndexEntry_t));
+            if (index == NULL) {
+                return -1;
+            }
+            r->scanned = index;
+        }
+        PPGRec_IndexEntry_t *e = &r->scanned[r->chunk_count++];
+        memset(e, 0, sizeof(PPGRec_IndexEntry_t));
+        e->offset = offset;
+        e->first_sample = ch->first_sample;
+        e->position = r->total_samples;
+        e->timestamp_us = ch->timestamp_us;
+        e->count = ch->count;
+        r->total_samples += ch->count;
+        offset += sizeof(PPGRec_ChunkHeader_t) + ch->payload_bytes;
+    }
+    r->index = r->scanned;
+    return 0;
+}
+
+/**
+ * Map a recording. A complete file is indexed through its footer; a file
+ * still being written or cut short is scanned.
+ * @return 0, -1 if it cannot be read or is not a recording
+ */
+int PPGRec_Open(PPGRec_Reader_t *r, const char *path) {
+    memset(r, 0, sizeof(PPGRec_Reader_t));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(r->fd, &st) != 0 || (size_t)st.st_size < sizeof(PPGRec_Header_t)) {
+        close(r->fd);
+        return -1;
+    }
+    r->size = (size_t)st.st_size;
+    void *map = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+    if (map == MAP_FAILED) {
+        close(r->fd);
+        return -1;
+    }
+    r->map = (const uint8_t *)map;
+    r->header = (const PPGRec_Header_t *)r->map;
+    const PPGRec_Header_t *h = r->header;
+    if (memcmp(h->magic, PPG_REC_MAGIC, sizeof(h->magic)) != 0 || h->version != PPG_REC_VERSION ||
+        h->header_size < sizeof(PPGRec_Header_t) || h->header_size % 8 != 0 || h->header_size > r->size ||
+        h->chunk_samples == 0 || h->chunk_samples > PPG_REC_MAX_CHUNK_SAMPLES || h->sample_rate_hz <= 0.0f) {
+        PPGRec_Close(r);
+        return -1;
+    }
+
+    const PPGRec_Footer_t *footer = (const PPGRec_Footer_t *)(r->map + r->size - sizeof(PPGRec_Footer_t));
+    if (r->size >= h->header_size + sizeof(PPGRec_Footer_t) &&
+        memcmp(footer->magic, PPG_REC_FOOTER_MAGIC, sizeof(footer->magic)) == 0 &&
+        footer->index_offset % 8 == 0 &&
+        footer->index_offset + (uint64_t)footer->chunk_count * sizeof(PPGRec_IndexEntry_t) ==
+            r->size - sizeof(PPGRec_Footer_t)) {
+        r->index = (const PPGRec_IndexEntry_t *)(r->map + footer->index_offset);
+        r->chunk_count = footer->chunk_count;
+        r->total_samples = footer->total_samples;
+        r->complete = 1;
+        return 0;
+    }
+    if (scan_chunks(r) != 0) {
+        PPGRec_Close(r);
+        return -1;
+    }
+    return 0;
+}
+
+void PPGRec_Close(PPGRec_Reader_t *r) {
+    if (r->map != NULL) {
+        munmap((void *)r->map, r->size);
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+    free(r->scanned);
+    memset(r, 0, sizeof(PPGRec_Reader_t));
+    r->fd = -1;
+}
+
+/**
+ * Chunk `chunk`. Plain samples point into the map; compressed ones are
+ * decoded into red_buf / ir_buf (chunk_samples each, may be NULL for a
+ * file known to be plain). The pointers stay valid until PPGRec_Close (or
+ * the next call with the same buffers).
+ * @return 0, -1 if the chunk is damaged or needs buffers
+ */
+int PPGRec_GetChunk(const PPGRec_Reader_t *r, uint32_t chunk, PPGRec_Chunk_t *c,
+                    uint32_t *red_buf, uint32_t *ir_buf) {
+    if (chunk >= r->chunk_count) {
+        return -1;
+    }
+    const PPGRec_IndexEntry_t *e = &r->index[chunk];
+    const PPGRec_ChunkHeader_t *ch = chunk_at(r, e->offset);
+    if (ch == NULL || ch->count != e->count) {
+        return -1;
+    }
+    uint32_t n = ch->count;
+    const uint8_t *payload = (const uint8_t *)(ch + 1);
+    if (ch->sample_bytes + (uint64_t)channel_bytes(r->header->channels, n) > ch->payload_bytes) {
+        return -1;
+    }
+    c->first_sample = ch->first_sample;
+    c->timestamp_us = ch->timestamp_us;
+    c->count = n;
+
+    if (ch->encoding == PPG_REC_ENC_PLAIN) {
+        if (ch->sample_bytes < 2 * n * sizeof(uint32_t)) {
+            return -1;
+        }
+        c->red = (const uint32_t *)payload;
+        c->ir = (const uint32_t *)(payload + n * sizeof(uint32_t));
+    } else if (ch->encoding == PPG_REC_ENC_CODEC && red_buf != NULL && ir_buf != NULL) {
+        PPG_Decoder_t dec;
+        PPG_Decoder_Init(&dec);
+        uint32_t pos = 0, done = 0;
+        while (done < n) {
+            uint32_t red[PPG_CODEC_BLOCK_SIZE], ir[PPG_CODEC_BLOCK_SIZE];
+            uint8_t got = 0;
+            uint32_t left = ch->sample_bytes - pos;
+            int16_t used = PPG_Decoder_DecodeBlock(&dec, &payload[pos], (uint16_t)(left > 0xFFFF ? 0xFFFF : left),
+                                                   red, ir, &got);
+            if (used < 0 || !dec.synced || done + got > n) {
+                return -1;
+            }
+            memcpy(&red_buf[done], red, got * sizeof(uint32_t));
+            memcpy(&ir_buf[done], ir, got * sizeof(uint32_t));
+            done += got;
+            pos += (uint32_t)used;
+        }
+        c->red = red_buf;
+        c->ir = ir_buf;
+    } else {
+        return -1;
+    }
+
+    uint32_t pos = ch->sample_bytes;
+    c->ref_hr = NULL;
+    c->ref_spo2 = NULL;
+    c->flags = NULL;
+    if (r->header->channels & PPG_REC_CH_REF_HR) {
+        c->ref_hr = (const float *)(payload + pos);
+        pos += n * sizeof(float);
+    }
+    if (r->header->channels & PPG_REC_CH_REF_SPO2) {
+        c->ref_spo2 = (const float *)(payload + pos);
+        pos += n * sizeof(float);
+    }
+    if (r->header->channels & PPG_REC_CH_FLAGS) {
+        c->flags = payload + pos;
+    }
+    return 0;
+}
+
+/**
+ * Chunk holding the stored sample at `position` (0..total_samples-1).
+ * @return chunk number, -1 if past the end
+ */
+int64_t PPGRec_FindChunk(const PPGRec_Reader_t *r, uint64_t position) {
+    if (position >= r->total_samples) {
+        return -1;
+    }
+    // Full chunks: the index entry follows from the position
+    uint64_t guess = position / r->header->chunk_samples;
+    if (guess < r->chunk_count && r->index[guess].position <= position &&
+        position < r->index[guess].position + r->index[guess].count) {
+        return (int64_t)guess;
+    }
+    uint32_t lo = 0, hi = r->chunk_count - 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (r->index[mid].position <= position) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Copy count stored samples from `position` on (gaps are not filled).
+ * @return samples copied (fewer at the end of the file or on a damaged chunk)
+ */
+uint32_t PPGRec_Read(const PPGRec_Reader_t *r, uint64_t position, uint32_t count, uint32_t *red, uint32_t *ir) {
+    int64_t chunk = PPGRec_FindChunk(r, position);
+    if (chunk < 0) {
+        return 0;
+    }
+    uint32_t *red_buf = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    uint32_t *ir_buf = (uint32_t *)malloc(r->header->chunk_samples * sizeof(uint32_t));
+    uint32_t done = 0;
+    while (red_buf != NULL && ir_buf != NULL && done < count && (uint32_t)chunk < r->chunk_count) {
+        PPGRec_Chunk_t c;
+        if (PPGRec_GetChunk(r, (uint32_t)chunk, &c, red_buf, ir_buf) != 0) {
+            break;
+        }
+        uint32_t skip = (uint32_t)(position + done - r->index[chunk].position);
+        uint32_t n = c.count - skip;
+        if (n > count - done) {
+            n = count - done;
+        }
+        memcpy(&red[done], &c.red[skip], n * sizeof(uint32_t));
+        memcpy(&ir[done], &c.ir[skip], n * sizeof(uint32_t));
+        done += n;
+        chunk++;
+    }
+    free(red_buf);
+    free(ir_buf);
+    return done;
+}
+
+/**
+ * @return 0 if the chunk's payload matches its CRC, -1 otherwise
+ */
+int PPGRec_VerifyChunk(const PPGRec_Reader_t *r, uint32_t chunk) {
+    if (chunk >= r->chunk_count) {
+        return -1;
+    }
+    const PPGRec_ChunkHeader_t *ch = chunk_at(r, r->index[chunk].offset);
+    if (ch == NULL || PPGRec_Crc32(0, (const uint8_t *)(ch + 1), ch->payload_bytes) != ch->crc) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,499 @@
+/**
+ * @file ppg_score.c
+ * @brief Accuracy and latency scoring of algorithm variants against annotated recordings
+ */
+
+#include "ppg_score.h"
+#include "ppg_rec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CSV_LINE_MAX    256
+#define CSV_COLUMNS     8
+
+typedef struct {
+    uint32_t sample;
+    float value;
+} Point_t;
+
+int PPGScore_AllocRecord(PPGScore_Record_t *rec, uint32_t count, uint32_t max_beats) {
+    memset(rec, 0, sizeof(PPGScore_Record_t));
+    rec->sample_rate_hz = 100.0f;
+    rec->red = (uint32_t *)malloc(count * sizeof(uint32_t));
+    rec->ir = (uint32_t *)malloc(count * sizeof(uint32_t));
+    rec->ref_hr = (float *)calloc(count, sizeof(float));
+    rec->ref_spo2 = (float *)calloc(count, sizeof(float));
+    rec->beats = (max_beats > 0) ? (uint32_t *)malloc(max_beats * sizeof(uint32_t)) : NULL;
+    if (rec->red == NULL || rec->ir == NULL || rec->ref_hr == NULL || rec->ref_spo2 == NULL ||
+        (max_beats > 0 && rec->beats == NULL)) {
+        PPGScore_FreeRecord(rec);
+        return -1;
+    }
+    rec->count = count;
+    return 0;
+}
+
+void PPGScore_FreeRecord(PPGScore_Record_t *rec) {
+    free(rec->red);
+    free(rec->ir);
+    free(rec->ref_hr);
+    free(rec->ref_spo2);
+    free(rec->beats);
+    memset(rec, 0, sizeof(PPGScore_Record_t));
+}
+
+static int column_index(char names[CSV_COLUMNS][16], int columns, const char *name) {
+    for (int i = 0; i < columns; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Annotated CSV: header line with the column names, then one sample per line.
+ * red and ir are required; hr, spo2 and flags (beat onsets) are optional.
+ */
+int PPGScore_LoadCsv(PPGScore_Record_t *rec, const char *path, float sample_rate_hz) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char line[CSV_LINE_MAX];
+    char names[CSV_COLUMNS][16];
+    int columns = 0;
+    if (fgets(line, sizeof(line), f) == NULL) {
+        fclose(f);
+        return -1;
+    }
+    // Column names (no strtok: records are loaded from several threads)
+    for (const char *p = line; *p != '\0' && *p != '\r' && *p != '\n' && columns < CSV_COLUMNS; ) {
+        size_t len = strcspn(p, ",\r\n");
+        snprintf(names[columns++], sizeof(names[0]), "%.*s", (int)len, p);
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    int col_red = column_index(names, columns, "red");
+    int col_ir = column_index(names, columns, "ir");
+    int col_hr = column_index(names, columns, "hr");
+    int col_spo2 = column_index(names, columns, "spo2");
+    int col_flags = column_index(names, columns, "flags");
+    if (col_red < 0 || col_ir < 0) {
+        fclose(f);
+        return -1;
+    }
+
+    // Size the arrays from the line count, then parse
+    uint32_t lines = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lines++;
+    }
+    if (lines == 0 || PPGScore_AllocRecord(rec, lines, (col_flags >= 0) ? lines : 0) != 0) {
+        fclose(f);
+        return -1;
+    }
+    rewind(f);
+    if (fgets(line, sizeof(line), f) == NULL) {
+        fclose(f);
+        PPGScore_FreeRecord(rec);
+        return -1;
+    }
+    uint32_t n = 0;
+    while (n < lines && fgets(line, sizeof(line), f) != NULL) {
+        double values[CSV_COLUMNS] = { 0 };
+        int got = 0;
+        char *p = line;
+        while (got < columns) {
+            char *end;
+            values[got++] = strtod(p, &end);
+            if (end == p || *end != ',') {
+                break;
+            }
+            p = end + 1;
+        }
+        if (got <= col_red || got <= col_ir) {
+            continue;
+        }
+        rec->red[n] = (uint32_t)values[col_red];
+        rec->ir[n] = (uint32_t)values[col_ir];
+        if (col_hr >= 0 && got > col_hr) rec->ref_hr[n] = (float)values[col_hr];
+        if (col_spo2 >= 0 && got > col_spo2) rec->ref_spo2[n] = (float)values[col_spo2];
+        if (col_flags >= 0 && got > col_flags && ((uint32_t)values[col_flags] & PPG_SYNTH_FLAG_BEAT)) {
+            rec->beats[rec->beat_count++] = n;
+        }
+        n++;
+    }
+    fclose(f);
+    if (n == 0) {
+        PPGScore_FreeRecord(rec);
+        return -1;
+    }
+    rec->count = n;
+    rec->sample_rate_hz = sample_rate_hz;
+    const char *base = strrchr(path, '/');
+    snprintf(rec->name, sizeof(rec->name), "%s", base != NULL ? base + 1 : path);
+    if (rec->beat_count >= 2) {
+        PPGScore_ReferenceFromBeats(rec, PPG_SCORE_REF_WINDOW_S);
+    }
+    return 0;
+}
+
+/**
+ * Recording container (ppg_rec.h): every stored sample in order (gaps are
+ * closed up), with the reference channels it carries. Beat onsets in the
+ * flags channel take precedence over the ref_hr channel.
+ */
+int PPGScore_LoadRecording(PPGScore_Record_t *rec, const char *path) {
+    PPGRec_Reader_t r;
+    if (PPGRec_Open(&r, path) != 0) {
+        return -1;
+    }
+    uint8_t channels = r.header->channels;
+    uint32_t count = (r.total_samples > UINT32_MAX) ? UINT32_MAX : (uint32_t)r.total_samples;
+    uint32_t *red_buf = (uint32_t *)malloc(r.header->chunk_samples * sizeof(uint32_t));
+    uint32_t *ir_buf = (uint32_t *)malloc(r.header->chunk_samples * sizeof(uint32_t));
+    if (count == 0 || red_buf == NULL || ir_buf == NULL ||
+        PPGScore_AllocRecord(rec, count, (channels & PPG_REC_CH_FLAGS) ? count : 0) != 0) {
+        free(red_buf);
+        free(ir_buf);
+        PPGRec_Close(&r);
+        return -1;
+    }
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < r.chunk_count && n < count; k++) {
+        PPGRec_Chunk_t c;
+        if (PPGRec_GetChunk(&r, k, &c, red_buf, ir_buf) != 0) {
+            break;                          // damaged: keep what was read
+        }
+        uint32_t take = (c.count < count - n) ? c.count : count - n;
+        memcpy(&rec->red[n], c.red, take * sizeof(uint32_t));
+        memcpy(&rec->ir[n], c.ir, take * sizeof(uint32_t));
+        if (c.ref_hr != NULL) memcpy(&rec->ref_hr[n], c.ref_hr, take * sizeof(float));
+        if (c.ref_spo2 != NULL) memcpy(&rec->ref_spo2[n], c.ref_spo2, take * sizeof(float));
+        for (uint32_t i = 0; c.flags != NULL && i < take; i++) {
+            if (c.flags[i] & PPG_SYNTH_FLAG_BEAT) {
+                rec->beats[rec->beat_count++] = n + i;
+            }
+        }
+        n += take;
+    }
+    rec->sample_rate_hz = r.header->sample_rate_hz;
+    free(red_buf);
+    free(ir_buf);
+    PPGRec_Close(&r);
+    if (n == 0) {
+        PPGScore_FreeRecord(rec);
+        return -1;
+    }
+    rec->count = n;
+    const char *base = strrchr(path, '/');
+    snprintf(rec->name, sizeof(rec->name), "%s", base != NULL ? base + 1 : path);
+    if (rec->beat_count >= 2) {
+        PPGScore_ReferenceFromBeats(rec, PPG_SCORE_REF_WINDOW_S);
+    }
+    return 0;
+}
+
+/**
+ * A recording container or an annotated CSV file (at sample_rate_hz),
+ * told apart by the container's magic.
+ */
+int PPGScore_LoadFile(PPGScore_Record_t *rec, const char *path, float sample_rate_hz) {
+    if (PPGRec_IsRecording(path)) {
+        return PPGScore_LoadRecording(rec, path);
+    }
+    return PPGScore_LoadCsv(rec, path, sample_rate_hz);
+}
+
+/**
+ * Reference HR at each sample: 60 / mean RR of the beats in the trailing
+ * window (at least two beats); no reference before the second beat.
+ */
+void PPGScore_ReferenceFromBeats(PPGScore_Record_t *rec, double window_s) {
+    uint32_t window = (uint32_t)(window_s * rec->sample_rate_hz);
+    uint32_t first = 0, last = 0;           // beats[first..last) are at or before sample i
+    for (uint32_t i = 0; i < rec->count; i++) {
+        while (last < rec->beat_count && rec->beats[last] <= i) {
+            last++;
+        }
+        while (first < last && rec->beats[first] + window < i) {
+            first++;
+        }
+        // Keep at least one interval even when the beats are further apart than the window
+        if (last >= 2 && last - first < 2) {
+            first = last - 2;
+        }
+        if (last - first >= 2) {
+            double span = (double)(rec->beats[last - 1] - rec->beats[first]) / rec->sample_rate_hz;
+            rec->ref_hr[i] = (float)(60.0 * (last - first - 1) / span);
+        } else {
+            rec->ref_hr[i] = 0.0f;
+        }
+    }
+}
+
+/**
+ * Record from the synthesiser: its samples, beat onsets and SpO2. With
+ * end_hr_bpm > 0 the rate ramps from config->hr_bpm to end_hr_bpm over the
+ * middle third of the record, which gives the lag estimate something to
+ * follow.
+ */
+int PPGScore_Synthesise(PPGScore_Record_t *rec, const PPGSynth_Config_t *config, uint64_t seed,
+                        double seconds, float end_hr_bpm) {
+    uint32_t count = (uint32_t)(seconds * config->sample_rate_hz);
+    uint32_t max_beats = (uint32_t)(seconds * 4.0) + 2;     // RR >= 0.25 s
+    PPGSynth_t *synth = (PPGSynth_t *)malloc(sizeof(PPGSynth_t));
+    if (synth == NULL || count == 0 || PPGScore_AllocRecord(rec, count, max_beats) != 0) {
+        free(synth);
+        return -1;
+    }
+    rec->sample_rate_hz = config->sample_rate_hz;
+    snprintf(rec->name, sizeof(rec->name), "synth-%llu", (unsigned long long)seed);
+    PPGSynth_Init(synth, config, seed);
+    uint32_t ramp_start = count / 3, ramp_end = 2 * count / 3;
+    for (uint32_t i = 0; i < count; i++) {
+        PPGSynth_Truth_t truth;
+        if (end_hr_bpm > 0.0f && i >= ramp_start && i <= ramp_end && i % 10 == 0) {
+            float progress = (float)(i - ramp_start) / (float)(ramp_end - ramp_start);
+            PPGSynth_SetHeartRate(synth, config->hr_bpm + progress * (end_hr_bpm - config->hr_bpm));
+        }
+        PPGSynth_Next(synth, &rec->red[i], &rec->ir[i], &truth);
+        rec->ref_spo2[i] = truth.spo2;
+        if ((truth.flags & PPG_SYNTH_FLAG_BEAT) && rec->beat_count < max_beats) {
+            rec->beats[rec->beat_count++] = i;
+        }
+    }
+    free(synth);
+    PPGScore_ReferenceFromBeats(rec, PPG_SCORE_REF_WINDOW_S);
+    return 0;
+}
+
+/**
+ * Synthetic corpus record `patient`: a random patient (PPGSynth_RandomPatient)
+ * whose rate ramps up or down by 15-25 bpm in the middle third.
+ */
+int PPGScore_SynthesisePatient(PPGScore_Record_t *rec, uint64_t patient, double seconds) {
+    PPGSynth_Config_t cfg;
+    PPGSynth_RandomPatient(&cfg, patient);
+    float delta = 15.0f + (float)(patient % 11);
+    float end_hr = (patient % 2) ? cfg.hr_bpm + delta : cfg.hr_bpm - delta;
+    if (end_hr < 45.0f) {
+        end_hr = cfg.hr_bpm + delta;
+    }
+    return PPGScore_Synthesise(rec, &cfg, patient, seconds, end_hr);
+}
+
+/**
+ * Reference delay that best explains the output: the lag with the smallest
+ * error spread (SD, so a constant bias does not pull it), over lags that
+ * still pair most of the outputs with a reference. A minimum on the edge of
+ * the range is not a measurement.
+ */
+static double estimate_lag(const Point_t *points, uint32_t count, const float *ref, const PPGScore_Record_t *rec) {
+    float lo = 1e9f, hi = -1e9f;
+    for (uint32_t i = 0; i < rec->count; i++) {
+        if (ref[i] > 0.0f) {
+            if (ref[i] < lo) lo = ref[i];
+            if (ref[i] > hi) hi = ref[i];
+        }
+    }
+    if (count < 4 || hi - lo < PPG_SCORE_LAG_MIN_RANGE) {
+        return -1.0;
+    }
+    double best_sd = INFINITY, best_lag = -1.0;
+    for (double lag = 0.0; lag <= PPG_SCORE_MAX_LAG_S + 1e-9; lag += PPG_SCORE_LAG_STEP_S) {
+        int64_t shift = (int64_t)(lag * rec->sample_rate_hz + 0.5);
+        double sum = 0.0, sum_sq = 0.0;
+        uint32_t n = 0;
+        for (uint32_t k = 0; k < count; k++) {
+            int64_t j = (int64_t)points[k].sample - shift;
+            if (j >= 0 && ref[j] > 0.0f) {
+                double err = points[k].value - ref[j];
+                sum += err;
+                sum_sq += err * err;
+                n++;
+            }
+        }
+        if (n * 2 < count) {
+            continue;
+        }
+        double mean = sum / n;
+        double sd = sqrt(fmax(sum_sq / n - mean * mean, 0.0));
+        if (sd < best_sd) {
+            best_sd = sd;
+            best_lag = lag;
+        }
+    }
+    if (best_lag >= PPG_SCORE_MAX_LAG_S - 1e-9) {
+        return -1.0;
+    }
+    return best_lag;
+}
+
+static void score_point(PPGScore_Metric_t *m, uint8_t valid, float value, float ref, uint32_t sample, float rate) {
+    m->updates++;
+    if (!valid) {
+        return;
+    }
+    if (m->valid++ == 0) {
+        m->first_valid_s = sample / rate;
+    }
+    if (ref > 0.0f) {
+        double err = (double)value - ref;
+        m->n++;
+        m->sum_err += err;
+        m->sum_abs += fabs(err);
+        m->sum_sq += err * err;
+    }
+}
+
+void PPGScore_Begin(PPGScore_Result_t *result) {
+    memset(result, 0, sizeof(PPGScore_Result_t));
+    result->hr.first_valid_s = result->spo2.first_valid_s = -1.0;
+    result->hr.lag_s = result->spo2.lag_s = -1.0;
+}
+
+/**
+ * Score one display update (variant output after sample `sample`).
+ */
+void PPGScore_Update(PPGScore_Result_t *result, const PPGScore_Record_t *rec, uint32_t sample,
+                     const PPGVariant_Output_t *out) {
+    score_point(&result->hr, out->hr_valid, out->hr_bpm, rec->ref_hr[sample], sample, rec->sample_rate_hz);
+    score_point(&result->spo2, out->spo2_valid, out->spo2,
+                (rec->ref_spo2 != NULL) ? rec->ref_spo2[sample] : 0.0f, sample, rec->sample_rate_hz);
+}
+
+static void merge_metric(PPGScore_Metric_t *into, const PPGScore_Metric_t *later) {
+    into->updates += later->updates;
+    into->valid += later->valid;
+    into->n += later->n;
+    into->sum_err += later->sum_err;
+    into->sum_abs += later->sum_abs;
+    into->sum_sq += later->sum_sq;
+    if (into->first_valid_s < 0.0) {
+        into->first_valid_s = later->first_valid_s;
+    }
+    into->lag_s = -1.0;
+}
+
+/**
+ * Append the result of a later stretch of the same record (chunked runs).
+ * The lag needs the whole output series and is not kept.
+ */
+void PPGScore_Merge(PPGScore_Result_t *into, const PPGScore_Result_t *later) {
+    merge_metric(&into->hr, &later->hr);
+    merge_metric(&into->spo2, &later->spo2);
+}
+
+// params: tuning constants to run with, NULL for the defaults
+static int run_variant(const PPGVariant_t *variant, const void *params, const PPGScore_Record_t *rec,
+                       PPGScore_Result_t *result) {
+    uint32_t max_points = rec->count / PPG_VARIANT_UPDATE_SAMPLES + 1;
+    void *state = malloc(variant->state_size);
+    Point_t *hr_points = (Point_t *)malloc(max_points * sizeof(Point_t));
+    Point_t *spo2_points = (Point_t *)malloc(max_points * sizeof(Point_t));
+    if (state == NULL || hr_points == NULL || spo2_points == NULL) {
+        free(state);
+        free(hr_points);
+        free(spo2_points);
+        return -1;
+    }
+
+    PPGScore_Begin(result);
+    uint32_t hr_count = 0, spo2_count = 0;
+    variant->init(state, rec->sample_rate_hz);
+#ifdef PPG_TUNABLE_PARAMS
+    if (params != NULL) {
+        variant->set_params(state, (const PPG_Params_t *)params);
+    }
+#else
+    (void)params;
+#endif
+    for (uint32_t i = 0; i < rec->count; i++) {
+        PPGVariant_Output_t out;
+        if (!variant->process(state, rec->red[i], rec->ir[i], &out)) {
+            continue;
+        }
+        PPGScore_Update(result, rec, i, &out);
+        if (out.hr_valid) {
+            hr_points[hr_count++] = (Point_t){ i, out.hr_bpm };
+        }
+        if (out.spo2_valid) {
+            spo2_points[spo2_count++] = (Point_t){ i, out.spo2 };
+        }
+    }
+    result->hr.lag_s = estimate_lag(hr_points, hr_count, rec->ref_hr, rec);
+    if (rec->ref_spo2 != NULL) {
+        result->spo2.lag_s = estimate_lag(spo2_points, spo2_count, rec->ref_spo2, rec);
+    }
+
+    free(state);
+    free(hr_points);
+    free(spo2_points);
+    return 0;
+}
+
+/**
+ * Run the variant over the record from a fresh state.
+ * @return 0, -1 if out of memory
+ */
+int PPGScore_Run(const PPGVariant_t *variant, const PPGScore_Record_t *rec, PPGScore_Result_t *result) {
+    return run_variant(variant, NULL, rec, result);
+}
+
+#ifdef PPG_TUNABLE_PARAMS
+/**
+ * PPGScore_Run with the variant's tuning constants replaced by params.
+ */
+int PPGScore_RunParams(const PPGVariant_t *variant, const PPG_Params_t *params, const PPGScore_Record_t *rec,
+                       PPGScore_Result_t *result) {
+    return run_variant(variant, params, rec, result);
+}
+#endif
+
+/**
+ * Pool a record's metric into total (zero-initialised): error statistics
+ * over all points, first valid time and lag averaged over records.
+ */
+void PPGScore_Add(PPGScore_Metric_t *total, const PPGScore_Metric_t *m) {
+    total->updates += m->updates;
+    total->valid += m->valid;
+    total->n += m->n;
+    total->sum_err += m->sum_err;
+    total->sum_abs += m->sum_abs;
+    total->sum_sq += m->sum_sq;
+    total->records++;
+    if (m->first_valid_s >= 0.0) {
+        total->records_valid++;
+        total->sum_first_valid_s += m->first_valid_s;
+    }
+    if (m->lag_s >= 0.0) {
+        total->records_lag++;
+        total->sum_lag_s += m->lag_s;
+    }
+}
+
+void PPGScore_Summarise(const PPGScore_Metric_t *m, PPGScore_Summary_t *s) {
+    memset(s, 0, sizeof(PPGScore_Summary_t));
+    if (m->n > 0) {
+        s->mae = m->sum_abs / m->n;
+        s->bias = m->sum_err / m->n;
+        double var = m->sum_sq / m->n - s->bias * s->bias;
+        s->sd = (var > 0.0) ? sqrt(var) : 0.0;
+    }
+    s->loa_low = s->bias - 1.96 * s->sd;
+    s->loa_high = s->bias + 1.96 * s->sd;
+    s->coverage_pct = (m->updates > 0) ? 100.0 * m->valid / m->updates : 0.0;
+    if (m->records == 0) {
+        s->first_valid_s = m->first_valid_s;
+        s->lag_s = m->lag_s;
+    } else {
+        s->first_valid_s = (m->records_valid > 0) ? m->sum_first_valid_s / m->records_valid : -1.0;
+        s->lag_s = (m->records_lag > 0) ? m->sum_lag_s / m->records_lag : -1.0;
+    }
+}
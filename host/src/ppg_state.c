@@ -0,0 +1,535 @@
+/**
+ * @file ppg_state.c
+ * @brief Compact, versioned serialisation of the algorithm states
+ */
+
+#include "ppg_state.h"
+#include "ppg_rec.h"
+#include <math.h>
+#include <string.h>
+
+#define TAG_FILTER      'F'
+#define TAG_HR          'H'
+#define TAG_SPO2        'S'
+#define TAG_DPT         'D'
+
+// ---- Primitives ----
+
+void PPGState_WriterInit(PPGState_Writer_t *w, uint8_t *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->error = 0;
+}
+
+void PPGState_ReaderInit(PPGState_Reader_t *r, const uint8_t *buf, size_t len) {
+    r->buf = buf;
+    r->len = len;
+    r->pos = 0;
+    r->error = 0;
+}
+
+static uint8_t *reserve(PPGState_Writer_t *w, size_t n) {
+    if (w->error || w->cap - w->len < n) {
+        w->error = 1;
+        return NULL;
+    }
+    uint8_t *p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+static const uint8_t *take(PPGState_Reader_t *r, size_t n) {
+    if (r->error || r->len - r->pos < n) {
+        r->error = 1;
+        return NULL;
+    }
+    const uint8_t *p = r->buf + r->pos;
+    r->pos += n;
+    return p;
+}
+
+void PPGState_PutU8(PPGState_Writer_t *w, uint8_t v) {
+    uint8_t *p = reserve(w, 1);
+    if (p != NULL) {
+        p[0] = v;
+    }
+}
+
+void PPGState_PutU16(PPGState_Writer_t *w, uint16_t v) {
+    uint8_t *p = reserve(w, 2);
+    if (p != NULL) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+}
+
+void PPGState_PutU32(PPGState_Writer_t *w, uint32_t v) {
+    uint8_t *p = reserve(w, 4);
+    if (p != NULL) {
+        for (int i = 0; i < 4; i++) {
+            p[i] = (uint8_t)(v >> (8 * i));
+        }
+    }
+}
+
+void PPGState_PutU64(PPGState_Writer_t *w, uint64_t v) {
+    PPGState_PutU32(w, (uint32_t)v);
+    PPGState_PutU32(w, (uint32_t)(v >> 32));
+}
+
+void PPGState_PutF32(PPGState_Writer_t *w, float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    PPGState_PutU32(w, u);
+}
+
+uint8_t PPGState_GetU8(PPGState_Reader_t *r) {
+    const uint8_t *p = take(r, 1);
+    return (p != NULL) ? p[0] : 0;
+}
+
+uint16_t PPGState_GetU16(PPGState_Reader_t *r) {
+    const uint8_t *p = take(r, 2);
+    return (p != NULL) ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+uint32_t PPGState_GetU32(PPGState_Reader_t *r) {
+    const uint8_t *p = take(r, 4);
+    if (p == NULL) {
+        return 0;
+    }
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t PPGState_GetU64(PPGState_Reader_t *r) {
+    uint64_t lo = PPGState_GetU32(r);
+    return lo | ((uint64_t)PPGState_GetU32(r) << 32);
+}
+
+float PPGState_GetF32(PPGState_Reader_t *r) {
+    uint32_t u = PPGState_GetU32(r);
+    float v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+static void put_floats(PPGState_Writer_t *w, const float *v, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        PPGState_PutF32(w, v[i]);
+    }
+}
+
+static void get_floats(PPGState_Reader_t *r, float *v, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        v[i] = PPGState_GetF32(r);
+    }
+}
+
+// Ring filled up to n of size entries: n values, the rest zero as after Init
+static void get_ring(PPGState_Reader_t *r, float *v, uint32_t n, uint32_t size) {
+    get_floats(r, v, n);
+    memset(v + n, 0, (size - n) * sizeof(float));
+}
+
+static void put_header(PPGState_Writer_t *w, uint8_t tag) {
+    PPGState_PutU8(w, tag);
+    PPGState_PutU8(w, PPG_STATE_VERSION);
+}
+
+static int get_header(PPGState_Reader_t *r, uint8_t tag) {
+    uint8_t t = PPGState_GetU8(r);
+    uint8_t version = PPGState_GetU8(r);
+    return (!r->error && t == tag && version == PPG_STATE_VERSION) ? 0 : -1;
+}
+
+// ---- PPG_FilterState_t ----
+
+void PPGState_PutFilter(PPGState_Writer_t *w, const PPG_FilterState_t *f) {
+    put_header(w, TAG_FILTER);
+    PPGState_PutU8(w, f->detrend_index);
+    PPGState_PutU8(w, f->detrend_filled);
+    PPGState_PutF32(w, f->detrend_sum);
+    put_floats(w, f->detrend_buffer, f->detrend_filled ? DETREND_WINDOW_SIZE : f->detrend_index);
+    for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+        PPGState_PutF32(w, f->biquad_states[s].x1);
+        PPGState_PutF32(w, f->biquad_states[s].x2);
+        PPGState_PutF32(w, f->biquad_states[s].y1);
+        PPGState_PutF32(w, f->biquad_states[s].y2);
+    }
+    put_floats(w, f->smooth_buffer, SIGNAL_SMOOTH_SIZE);
+    PPGState_PutU8(w, f->smooth_index);
+    PPGState_PutF32(w, f->dc_value);
+    PPGState_PutF32(w, f->ac_squared_sum);
+    PPGState_PutU32(w, f->sample_count);
+}
+
+int PPGState_GetFilter(PPGState_Reader_t *r, PPG_FilterState_t *f) {
+    if (get_header(r, TAG_FILTER) != 0) {
+        return -1;
+    }
+    f->detrend_index = PPGState_GetU8(r);
+    f->detrend_filled = PPGState_GetU8(r);
+    if (f->detrend_index >= DETREND_WINDOW_SIZE) {
+        return -1;
+    }
+    f->detrend_sum = PPGState_GetF32(r);
+    get_ring(r, f->detrend_buffer, f->detrend_filled ? DETREND_WINDOW_SIZE : f->detrend_index,
+             DETREND_WINDOW_SIZE);
+    for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+        f->biquad_states[s].x1 = PPGState_GetF32(r);
+        f->biquad_states[s].x2 = PPGState_GetF32(r);
+        f->biquad_states[s].y1 = PPGState_GetF32(r);
+        f->biquad_states[s].y2 = PPGState_GetF32(r);
+    }
+    get_floats(r, f->smooth_buffer, SIGNAL_SMOOTH_SIZE);
+    f->smooth_index = PPGState_GetU8(r);
+    f->dc_value = PPGState_GetF32(r);
+    f->ac_squared_sum = PPGState_GetF32(r);
+    f->sample_count = PPGState_GetU32(r);
+    return (r->error || f->smooth_index >= SIGNAL_SMOOTH_SIZE) ? -1 : 0;
+}
+
+// ---- HR_State_t ----
+
+void PPGState_PutHR(PPGState_Writer_t *w, const HR_State_t *hr) {
+    put_header(w, TAG_HR);
+    PPGState_PutU16(w, hr->buffer_index);
+    PPGState_PutU8(w, hr->buffer_full);
+    put_floats(w, hr->buffer, hr->buffer_full ? HR_BUFFER_SIZE : hr->buffer_index);
+    PPGState_PutU16(w, hr->last_peak_index);
+    PPGState_PutU16(w, hr->global_index);
+    PPGState_PutF32(w, hr->rolling_mean);
+    PPGState_PutF32(w, hr->rolling_variance);
+    PPGState_PutU16(w, hr->rolling_count);
+    PPGState_PutF32(w, hr->recent_dc_value);
+    PPGState_PutF32(w, hr->peak_amplitude);
+    PPGState_PutF32(w, hr->ac_dc_ratio);
+    PPGState_PutU8(w, hr->signal_quality);
+    PPGState_PutU8(w, hr->consecutive_invalid);
+    put_floats(w, hr->hr_history, HR_MEDIAN_FILTER_SIZE);
+    PPGState_PutU8(w, hr->hr_history_index);
+    PPGState_PutU8(w, hr->hr_history_count);
+    PPGState_PutF32(w, hr->last_hr);
+    PPGState_PutF32(w, hr->raw_hr);
+    PPGState_PutF32(w, hr->median_hr);
+    PPGState_PutF32(w, hr->limited_hr);
+    PPGState_PutF32(w, hr->ema_hr);
+    PPGState_PutU8(w, hr->hr_valid);
+    PPGState_PutU8(w, hr->stable_count);
+    PPGState_PutF32(w, hr->sample_rate_hz);
+}
+
+int PPGState_GetHR(PPGState_Reader_t *r, HR_State_t *hr) {
+    if (get_header(r, TAG_HR) != 0) {
+        return -1;
+    }
+    hr->buffer_index = PPGState_GetU16(r);
+    hr->buffer_full = PPGState_GetU8(r);
+    if (hr->buffer_index >= HR_BUFFER_SIZE) {
+        return -1;
+    }
+    get_ring(r, hr->buffer, hr->buffer_full ? HR_BUFFER_SIZE : hr->buffer_index, HR_BUFFER_SIZE);
+    hr->last_peak_index = PPGState_GetU16(r);
+    hr->global_index = PPGState_GetU16(r);
+    hr->rolling_mean = PPGState_GetF32(r);
+    hr->rolling_variance = PPGState_GetF32(r);
+    hr->rolling_count = PPGState_GetU16(r);
+    hr->recent_dc_value = PPGState_GetF32(r);
+    hr->peak_amplitude = PPGState_GetF32(r);
+    hr->ac_dc_ratio = PPGState_GetF32(r);
+    hr->signal_quality = PPGState_GetU8(r);
+    hr->consecutive_invalid = PPGState_GetU8(r);
+    get_floats(r, hr->hr_history, HR_MEDIAN_FILTER_SIZE);
+    hr->hr_history_index = PPGState_GetU8(r);
+    hr->hr_history_count = PPGState_GetU8(r);
+    hr->last_hr = PPGState_GetF32(r);
+    hr->raw_hr = PPGState_GetF32(r);
+    hr->median_hr = PPGState_GetF32(r);
+    hr->limited_hr = PPGState_GetF32(r);
+    hr->ema_hr = PPGState_GetF32(r);
+    hr->hr_valid = PPGState_GetU8(r);
+    hr->stable_count = PPGState_GetU8(r);
+    hr->sample_rate_hz = PPGState_GetF32(r);
+    return (r->error || hr->hr_history_index >= HR_MEDIAN_FILTER_SIZE ||
+            hr->hr_history_count > HR_MEDIAN_FILTER_SIZE) ? -1 : 0;
+}
+
+// ---- SpO2_State_t ----
+
+#define SPO2_R_HISTORY  (sizeof(((SpO2_State_t *)0)->r_history) / sizeof(float))
+
+void PPGState_PutSpO2(PPGState_Writer_t *w, const SpO2_State_t *spo2) {
+    put_header(w, TAG_SPO2);
+    put_floats(w, spo2->r_history, SPO2_R_HISTORY);
+    PPGState_PutU8(w, spo2->r_history_index);
+    PPGState_PutU8(w, spo2->r_history_count);
+    PPGState_PutF32(w, spo2->last_spo2);
+    PPGState_PutU8(w, spo2->spo2_valid);
+}
+
+int PPGState_GetSpO2(PPGState_Reader_t *r, SpO2_State_t *spo2) {
+    if (get_header(r, TAG_SPO2) != 0) {
+        return -1;
+    }
+    get_floats(r, spo2->r_history, SPO2_R_HISTORY);
+    spo2->r_history_index = PPGState_GetU8(r);
+    spo2->r_history_count = PPGState_GetU8(r);
+    spo2->last_spo2 = PPGState_GetF32(r);
+    spo2->spo2_valid = PPGState_GetU8(r);
+    return (r->error || spo2->r_history_index >= SPO2_R_HISTORY ||
+            spo2->r_history_count > SPO2_R_HISTORY) ? -1 : 0;
+}
+
+// ---- DPT_State_t ----
+
+static void put_iir(PPGState_Writer_t *w, const DPT_IIR_State_t *f) {
+    PPGState_PutF32(w, f->w_n);
+    PPGState_PutF32(w, f->y_n);
+    PPGState_PutF32(w, f->x_n);
+    PPGState_PutF32(w, f->z_n);
+    PPGState_PutU32(w, (uint32_t)f->ac_value);
+    PPGState_PutU32(w, (uint32_t)f->dc_value);
+}
+
+static void get_iir(PPGState_Reader_t *r, DPT_IIR_State_t *f) {
+    f->w_n = PPGState_GetF32(r);
+    f->y_n = PPGState_GetF32(r);
+    f->x_n = PPGState_GetF32(r);
+    f->z_n = PPGState_GetF32(r);
+    f->ac_value = (int32_t)PPGState_GetU32(r);
+    f->dc_value = (int32_t)PPGState_GetU32(r);
+}
+
+// Filled part of the ring: int16 when every value fits, else int32
+static void put_transform(PPGState_Writer_t *w, const DPT_Transform_t *t) {
+    uint32_t n = t->buffer_full ? DPT_BUFFER_SIZE : t->buffer_index;
+    uint8_t width = 2;
+    for (uint32_t i = 0; i < n; i++) {
+        if (t->recursive_buffer[i] < INT16_MIN || t->recursive_buffer[i] > INT16_MAX) {
+            width = 4;
+            break;
+        }
+    }
+    PPGState_PutU16(w, t->buffer_index);
+    PPGState_PutU16(w, t->sample_count);
+    PPGState_PutU8(w, t->buffer_full);
+    PPGState_PutU8(w, width);
+    for (uint32_t i = 0; i < n; i++) {
+        if (width == 2) {
+            PPGState_PutU16(w, (uint16_t)(int16_t)t->recursive_buffer[i]);
+        } else {
+            PPGState_PutU32(w, (uint32_t)t->recursive_buffer[i]);
+        }
+    }
+    // Zero until the transform runs
+    if (t->buffer_full) {
+        put_floats(w, t->real, DPT_PERIOD_RANGE);
+        put_floats(w, t->imag, DPT_PERIOD_RANGE);
+    }
+}
+
+static int get_transform(PPGState_Reader_t *r, DPT_Transform_t *t) {
+    t->buffer_index = PPGState_GetU16(r);
+    t->sample_count = PPGState_GetU16(r);
+    t->buffer_full = PPGState_GetU8(r) != 0;
+    uint8_t width = PPGState_GetU8(r);
+    if (r->error || t->buffer_index >= DPT_BUFFER_SIZE || (width != 2 && width != 4)) {
+        return -1;
+    }
+    uint32_t n = t->buffer_full ? DPT_BUFFER_SIZE : t->buffer_index;
+    for (uint32_t i = 0; i < n; i++) {
+        t->recursive_buffer[i] = (width == 2) ? (int16_t)PPGState_GetU16(r) : (int32_t)PPGState_GetU32(r);
+    }
+    memset(t->recursive_buffer + n, 0, (DPT_BUFFER_SIZE - n) * sizeof(int32_t));
+    if (t->buffer_full) {
+        get_floats(r, t->real, DPT_PERIOD_RANGE);
+        get_floats(r, t->imag, DPT_PERIOD_RANGE);
+    } else {
+        memset(t->real, 0, sizeof(t->real));
+        memset(t->imag, 0, sizeof(t->imag));
+    }
+    return r->error ? -1 : 0;
+}
+
+// compute_magnitude_spectrum (ppg_algorithm_v2.c), the same expression
+static void magnitude_spectrum(DPT_Transform_t *t) {
+    for (uint16_t i = 0; i < DPT_PERIOD_RANGE; i++) {
+        float real = t->real[i];
+        float imag = t->imag[i];
+        uint16_t period = DPT_MIN_PERIOD + i;
+        float magnitude_raw = sqrtf(real * real + imag * imag);
+        t->magnitude[i] = magnitude_raw / (float)period;
+    }
+}
+
+void PPGState_PutDPT(PPGState_Writer_t *w, const DPT_State_t *dpt) {
+    put_header(w, TAG_DPT);
+    put_iir(w, &dpt->red_filter);
+    put_iir(w, &dpt->ir_filter);
+    put_transform(w, &dpt->red_dpt);
+    put_transform(w, &dpt->ir_dpt);
+    PPGState_PutF32(w, dpt->heart_rate);
+    PPGState_PutF32(w, dpt->spo2);
+    PPGState_PutU16(w, dpt->peak_period);
+    PPGState_PutF32(w, dpt->sample_rate_hz);
+    PPGState_PutF32(w, dpt->raw_hr);
+    PPGState_PutF32(w, dpt->median_hr);
+    PPGState_PutF32(w, dpt->limited_hr);
+    PPGState_PutF32(w, dpt->ema_hr);
+    PPGState_PutF32(w, dpt->last_valid_hr);
+    PPGState_PutU8(w, dpt->stable_count);
+    put_floats(w, dpt->r_history, DPT_R_SMOOTH_SIZE);
+    PPGState_PutU8(w, dpt->r_index);
+    put_floats(w, dpt->hr_history, DPT_HR_SMOOTH_SIZE);
+    PPGState_PutU8(w, dpt->hr_index);
+    put_floats(w, dpt->hr_median_buffer, DPT_MEDIAN_SIZE);
+    PPGState_PutU8(w, dpt->hr_median_index);
+    PPGState_PutU8(w, dpt->hr_valid);
+    PPGState_PutU8(w, dpt->spo2_valid);
+}
+
+int PPGState_GetDPT(PPGState_Reader_t *r, DPT_State_t *dpt) {
+    if (get_header(r, TAG_DPT) != 0) {
+        return -1;
+    }
+    get_iir(r, &dpt->red_filter);
+    get_iir(r, &dpt->ir_filter);
+    if (get_transform(r, &dpt->red_dpt) != 0 || get_transform(r, &dpt->ir_dpt) != 0) {
+        return -1;
+    }
+    dpt->heart_rate = PPGState_GetF32(r);
+    dpt->spo2 = PPGState_GetF32(r);
+    dpt->peak_period = PPGState_GetU16(r);
+    dpt->sample_rate_hz = PPGState_GetF32(r);
+    dpt->raw_hr = PPGState_GetF32(r);
+    dpt->median_hr = PPGState_GetF32(r);
+    dpt->limited_hr = PPGState_GetF32(r);
+    dpt->ema_hr = PPGState_GetF32(r);
+    dpt->last_valid_hr = PPGState_GetF32(r);
+    dpt->stable_count = PPGState_GetU8(r);
+    get_floats(r, dpt->r_history, DPT_R_SMOOTH_SIZE);
+    dpt->r_index = PPGState_GetU8(r);
+    get_floats(r, dpt->hr_history, DPT_HR_SMOOTH_SIZE);
+    dpt->hr_index = PPGState_GetU8(r);
+    get_floats(r, dpt->hr_median_buffer, DPT_MEDIAN_SIZE);
+    dpt->hr_median_index = PPGState_GetU8(r);
+    dpt->hr_valid = PPGState_GetU8(r) != 0;
+    dpt->spo2_valid = PPGState_GetU8(r) != 0;
+    if (r->error || dpt->r_index >= DPT_R_SMOOTH_SIZE || dpt->hr_index >= DPT_HR_SMOOTH_SIZE ||
+        dpt->hr_median_index >= DPT_MEDIAN_SIZE) {
+        return -1;
+    }
+    // DPT_Process computes the spectra on every sample once both buffers are full
+    if (dpt->red_dpt.buffer_full && dpt->ir_dpt.buffer_full) {
+        magnitude_spectrum(&dpt->red_dpt);
+        magnitude_spectrum(&dpt->ir_dpt);
+    } else {
+        memset(dpt->red_dpt.magnitude, 0, sizeof(dpt->red_dpt.magnitude));
+        memset(dpt->ir_dpt.magnitude, 0, sizeof(dpt->ir_dpt.magnitude));
+    }
+    return 0;
+}
+
+// ---- Stream snapshots ----
+
+/**
+ * Layout: magic, version, variant count, 2 reserved, stream, samples,
+ * payload bytes, payload CRC-32 (PPG_STATE_STREAM_HEADER bytes); payload:
+ * per variant its name (length byte + chars) and blob (length + bytes),
+ * then the extra bytes (length + bytes).
+ */
+size_t PPGState_SaveStream(uint8_t *buf, size_t cap, uint32_t stream, uint64_t samples,
+                           const PPGVariant_t *const *variants, void *const *states, uint32_t count,
+                           const uint8_t *extra, uint32_t extra_len) {
+    if (cap < PPG_STATE_STREAM_HEADER || count > UINT8_MAX) {
+        return 0;
+    }
+    PPGState_Writer_t w;
+    PPGState_WriterInit(&w, buf + PPG_STATE_STREAM_HEADER, cap - PPG_STATE_STREAM_HEADER);
+    for (uint32_t v = 0; v < count; v++) {
+        size_t name_len = strlen(variants[v]->name);
+        PPGState_PutU8(&w, (uint8_t)name_len);
+        uint8_t *name = reserve(&w, name_len);
+        if (name != NULL) {
+            memcpy(name, variants[v]->name, name_len);
+        }
+        size_t at = w.len;
+        PPGState_PutU32(&w, 0);
+        if (w.error) {
+            return 0;
+        }
+        size_t n = variants[v]->save(states[v], w.buf + w.len, w.cap - w.len);
+        if (n == 0) {
+            return 0;
+        }
+        w.len += n;
+        PPGState_Writer_t len_w;
+        PPGState_WriterInit(&len_w, w.buf + at, 4);
+        PPGState_PutU32(&len_w, (uint32_t)n);
+    }
+    PPGState_PutU32(&w, extra_len);
+    uint8_t *p = reserve(&w, extra_len);
+    if (w.error) {
+        return 0;
+    }
+    if (extra_len > 0) {
+        memcpy(p, extra, extra_len);
+    }
+
+    PPGState_Writer_t h;
+    PPGState_WriterInit(&h, buf, PPG_STATE_STREAM_HEADER);
+    PPGState_PutU32(&h, PPG_STATE_STREAM_MAGIC);
+    PPGState_PutU8(&h, PPG_STATE_VERSION);
+    PPGState_PutU8(&h, (uint8_t)count);
+    PPGState_PutU16(&h, 0);
+    PPGState_PutU32(&h, stream);
+    PPGState_PutU64(&h, samples);
+    PPGState_PutU32(&h, (uint32_t)w.len);
+    PPGState_PutU32(&h, PPGRec_Crc32(0, w.buf, w.len));
+    return PPG_STATE_STREAM_HEADER + w.len;
+}
+
+int PPGState_LoadStream(const uint8_t *buf, size_t len, uint32_t *stream, uint64_t *samples,
+                        const PPGVariant_t *const *variants, void *const *states, uint32_t count,
+                        const uint8_t **extra, uint32_t *extra_len) {
+    PPGState_Reader_t h;
+    PPGState_ReaderInit(&h, buf, len);
+    uint32_t magic = PPGState_GetU32(&h);
+    uint8_t version = PPGState_GetU8(&h);
+    uint8_t n = PPGState_GetU8(&h);
+    PPGState_GetU16(&h);
+    uint32_t id = PPGState_GetU32(&h);
+    uint64_t processed = PPGState_GetU64(&h);
+    uint32_t payload = PPGState_GetU32(&h);
+    uint32_t crc = PPGState_GetU32(&h);
+    if (h.error || magic != PPG_STATE_STREAM_MAGIC || version != PPG_STATE_VERSION || n != count ||
+        payload > len - PPG_STATE_STREAM_HEADER ||
+        PPGRec_Crc32(0, buf + PPG_STATE_STREAM_HEADER, payload) != crc) {
+        return -1;
+    }
+    PPGState_Reader_t r;
+    PPGState_ReaderInit(&r, buf + PPG_STATE_STREAM_HEADER, payload);
+    for (uint32_t v = 0; v < count; v++) {
+        uint8_t name_len = PPGState_GetU8(&r);
+        const uint8_t *name = take(&r, name_len);
+        uint32_t blob_len = PPGState_GetU32(&r);
+        const uint8_t *blob = take(&r, blob_len);
+        if (r.error || name_len != strlen(variants[v]->name) || memcmp(name, variants[v]->name, name_len) != 0 ||
+            variants[v]->load(states[v], blob, blob_len) != 0) {
+            return -1;
+        }
+    }
+    uint32_t extra_bytes = PPGState_GetU32(&r);
+    const uint8_t *extra_data = take(&r, extra_bytes);
+    if (r.error || r.pos != r.len) {
+        return -1;
+    }
+    *stream = id;
+    *samples = processed;
+    if (extra != NULL) {
+        *extra = extra_data;
+        *extra_len = extra_bytes;
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+/**
+ * @file ppg_synth.c
+ * @brief Streaming PPG synthesiser for test corpora and benchmarks
+ */
+
+#include "ppg_synth.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ADC_FULL_SCALE      0x3FFFFu
+#define MAYER_HZ            0.1
+#define ECTOPIC_PREMATURITY 0.65        // premature beat arrives after 65 % of the RR
+#define ECTOPIC_AMPLITUDE   0.55f       // smaller stroke volume
+#define RR_MIN_S            0.25
+#define RR_MAX_S            3.0
+
+// xorshift64*: 64 random bits per call
+static uint64_t next_random(PPGSynth_t *synth) {
+    uint64_t x = synth->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    synth->rng = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double uniform(PPGSynth_t *synth) {
+    return (double)(next_random(synth) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Approximately standard normal: four 16-bit uniforms (Irwin-Hall), one call
+static float gaussian(PPGSynth_t *synth) {
+    uint64_t r = next_random(synth);
+    uint32_t sum = (uint32_t)(r & 0xFFFF) + (uint32_t)((r >> 16) & 0xFFFF) +
+                   (uint32_t)((r >> 32) & 0xFFFF) + (uint32_t)(r >> 48);
+    return ((float)sum * (1.0f / 65536.0f) - 2.0f) * 1.7320508f;
+}
+
+/**
+ * Default patient: 72 bpm, 98 % SpO2, 2.5 % perfusion, mild HRV and
+ * respiration, no ectopic beats or motion, 18-bit samples at 100 Hz.
+ */
+void PPGSynth_DefaultConfig(PPGSynth_Config_t *config) {
+    memset(config, 0, sizeof(PPGSynth_Config_t));
+    config->sample_rate_hz = 100.0f;
+    config->hr_bpm = 72.0f;
+    config->spo2 = 98.0f;
+    config->ir_dc = 120000.0f;
+    config->red_dc = 110000.0f;
+    config->perfusion_index = 0.025f;
+    config->hrv_sd = 0.02f;
+    config->rsa_depth = 0.03f;
+    config->mayer_depth = 0.02f;
+    config->ectopic_prob = 0.0f;
+    config->resp_rate_bpm = 15.0f;
+    config->resp_baseline = 0.005f;
+    config->resp_am = 0.1f;
+    config->reflection = 0.45f;
+    config->notch_depth = 0.5f;
+    config->motion_per_min = 0.0f;
+    config->motion_amp = 3.0f;
+    config->noise_sd = 20.0f;
+    config->resolution_bits = 18;
+}
+
+/**
+ * A plausible random patient (rate, SpO2, perfusion, variability, breathing,
+ * morphology, occasional ectopics), the same for the same seed.
+ */
+void PPGSynth_RandomPatient(PPGSynth_Config_t *config, uint64_t seed) {
+    PPGSynth_t rng;
+    rng.rng = seed * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+    if (rng.rng == 0) {
+        rng.rng = 1;
+    }
+    PPGSynth_DefaultConfig(config);
+    config->hr_bpm = (float)(50.0 + 70.0 * uniform(&rng));
+    config->spo2 = (float)(90.0 + 9.5 * uniform(&rng));
+    config->ir_dc = (float)(60000.0 + 120000.0 * uniform(&rng));
+    config->red_dc = config->ir_dc * (float)(0.7 + 0.3 * uniform(&rng));
+    config->perfusion_index = (float)(0.005 + 0.045 * uniform(&rng));
+    config->hrv_sd = (float)(0.005 + 0.04 * uniform(&rng));
+    config->rsa_depth = (float)(0.01 + 0.05 * uniform(&rng));
+    config->resp_rate_bpm = (float)(10.0 + 10.0 * uniform(&rng));
+    config->resp_am = (float)(0.05 + 0.2 * uniform(&rng));
+    config->reflection = (float)(0.2 + 0.5 * uniform(&rng));
+    config->notch_depth = (float)(0.8 * uniform(&rng));
+    config->ectopic_prob = (uniform(&rng) < 0.2) ? (float)(0.01 + 0.04 * uniform(&rng)) : 0.0f;
+    config->noise_sd = (float)(5.0 + 40.0 * uniform(&rng));
+}
+
+/**
+ * R = (AC_red / DC_red) / (AC_ir / DC_ir) that the firmware's calibration
+ * curve maps to spo2 (the branch where R rises as SpO2 falls).
+ */
+float PPGSynth_RatioForSpO2(float spo2) {
+    double a = 45.06, b = 30.354, c = 94.845 - (double)spo2;
+    double d = b * b + 4.0 * a * c;             // of -a R^2 + b R + c = 0
+    if (d < 0.0) {
+        d = 0.0;                                // above the curve's maximum (~99.96 %)
+    }
+    return (float)((b + sqrt(d)) / (2.0 * a));
+}
+
+// One pulse, peak 1, foot 0: asymmetric systolic wave, dicrotic notch, reflected wave
+static void build_template(PPGSynth_t *synth) {
+    const PPGSynth_Config_t *cfg = &synth->config;
+    float peak = 0.0f;
+    for (uint32_t i = 0; i <= PPG_SYNTH_TEMPLATE_SIZE * PPG_SYNTH_TEMPLATE_SPAN; i++) {
+        double phase = (double)i / PPG_SYNTH_TEMPLATE_SIZE;
+        double sigma = (phase < 0.16) ? 0.055 : 0.10;
+        double systolic = exp(-0.5 * pow((phase - 0.16) / sigma, 2.0));
+        double diastolic = cfg->reflection * exp(-0.5 * pow((phase - 0.46) / 0.11, 2.0));
+        double notch = cfg->notch_depth * cfg->reflection * 0.6 * exp(-0.5 * pow((phase - 0.33) / 0.035, 2.0));
+        double foot = (phase < 0.08) ? sin(0.5 * M_PI * phase / 0.08) : 1.0;   // starts at exactly 0
+        double value = foot * (systolic + diastolic - notch);
+        synth->template_table[i] = (float)(value > 0.0 ? value : 0.0);
+        if (synth->template_table[i] > peak) {
+            peak = synth->template_table[i];
+        }
+    }
+    for (uint32_t i = 0; i <= PPG_SYNTH_TEMPLATE_SIZE * PPG_SYNTH_TEMPLATE_SPAN; i++) {
+        synth->template_table[i] /= peak;
+    }
+}
+
+static float pulse_at(const PPGSynth_t *synth, const PPGSynth_Beat_t *beat, double t_s) {
+    double pos = (t_s - beat->onset_s) / beat->scale_s * PPG_SYNTH_TEMPLATE_SIZE;
+    if (pos < 0.0 || pos >= (double)(PPG_SYNTH_TEMPLATE_SIZE * PPG_SYNTH_TEMPLATE_SPAN)) {
+        return 0.0f;
+    }
+    uint32_t i = (uint32_t)pos;
+    float frac = (float)(pos - (double)i);
+    return beat->amp * (synth->template_table[i] + frac * (synth->template_table[i + 1] - synth->template_table[i]));
+}
+
+// Beat after synth->cur: RR from the mean rate, RSA, Mayer wave, random variation, ectopics
+static void next_beat(PPGSynth_t *synth) {
+    const PPGSynth_Config_t *cfg = &synth->config;
+    PPGSynth_Beat_t beat;
+    beat.onset_s = synth->cur.onset_s + synth->cur.rr_s;
+
+    double rr = 60.0 / cfg->hr_bpm;
+    rr *= 1.0 + cfg->rsa_depth * synth->resp_s +
+          cfg->mayer_depth * sin(2.0 * M_PI * MAYER_HZ * beat.onset_s) +
+          cfg->hrv_sd * gaussian(synth);
+    if (rr < RR_MIN_S) rr = RR_MIN_S;
+    if (rr > RR_MAX_S) rr = RR_MAX_S;
+    beat.scale_s = rr;
+    beat.amp = 1.0f + 0.03f * gaussian(synth);
+    beat.ectopic = 0;
+    beat.rr_s = rr;
+
+    if (synth->compensate) {
+        // This beat came early: smaller pulse, then the compensatory pause
+        synth->compensate = 0;
+        beat.ectopic = 1;
+        beat.amp *= ECTOPIC_AMPLITUDE;
+        beat.rr_s = synth->compensate_rr_s;
+    } else if (cfg->ectopic_prob > 0.0f && uniform(synth) < cfg->ectopic_prob) {
+        // The next beat is premature; the two intervals add up to two normal ones
+        beat.rr_s = ECTOPIC_PREMATURITY * rr;
+        synth->compensate = 1;
+        synth->compensate_rr_s = (2.0 - ECTOPIC_PREMATURITY) * rr;
+    }
+
+    synth->prev = synth->cur;
+    synth->cur = beat;
+    synth->beats++;
+}
+
+static void schedule_motion(PPGSynth_t *synth, double after_s) {
+    if (synth->config.motion_per_min <= 0.0f) {
+        synth->motion_next_s = INFINITY;
+        return;
+    }
+    double mean_gap_s = 60.0 / synth->config.motion_per_min;
+    synth->motion_next_s = after_s - mean_gap_s * log(1.0 - uniform(synth));
+}
+
+static float motion_at(PPGSynth_t *synth, double t_s, uint8_t *flags) {
+    if (t_s >= synth->motion_next_s) {
+        // New episode: 1-4 s of 0.5-3 Hz movement
+        synth->motion_start_s = t_s;
+        synth->motion_end_s = t_s + 1.0 + 3.0 * uniform(synth);
+        synth->motion_f1 = (float)(0.5 + 2.5 * uniform(synth));
+        synth->motion_f2 = synth->motion_f1 * (float)(1.5 + uniform(synth));
+        synth->motion_gain = synth->config.motion_amp * (float)(0.5 + uniform(synth));
+        if (uniform(synth) < 0.5) {
+            synth->motion_gain = -synth->motion_gain;
+        }
+        schedule_motion(synth, synth->motion_end_s);
+    }
+    if (t_s >= synth->motion_end_s) {
+        return 0.0f;
+    }
+    *flags |= PPG_SYNTH_FLAG_MOTION;
+    double tau = t_s - synth->motion_start_s;
+    double env = sin(M_PI * tau / (synth->motion_end_s - synth->motion_start_s));
+    return synth->motion_gain * (float)(env * env *
+           (sin(2.0 * M_PI * synth->motion_f1 * tau) + 0.5 * sin(2.0 * M_PI * synth->motion_f2 * tau + 1.0)));
+}
+
+static uint32_t quantise(const PPGSynth_t *synth, float value, uint8_t *flags) {
+    uint32_t counts;
+    if (value <= 0.0f) {
+        counts = 0;
+    } else if (value >= (float)ADC_FULL_SCALE - 0.5f) {
+        counts = ADC_FULL_SCALE;
+        *flags |= PPG_SYNTH_FLAG_SATURATED;
+    } else {
+        counts = (uint32_t)(value + 0.5f);
+    }
+    return counts & (ADC_FULL_SCALE & ~((1u << (18 - synth->config.resolution_bits)) - 1u));
+}
+
+void PPGSynth_Init(PPGSynth_t *synth, const PPGSynth_Config_t *config, uint64_t seed) {
+    memset(synth, 0, sizeof(PPGSynth_t));
+    synth->config = *config;
+    if (synth->config.resolution_bits < 15 || synth->config.resolution_bits > 18) {
+        synth->config.resolution_bits = 18;
+    }
+    synth->rng = seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+    if (synth->rng == 0) {
+        synth->rng = 1;
+    }
+    synth->dt_s = 1.0 / synth->config.sample_rate_hz;
+    synth->red_ratio = PPGSynth_RatioForSpO2(synth->config.spo2);
+    build_template(synth);
+
+    double w = 2.0 * M_PI * synth->config.resp_rate_bpm / 60.0 * synth->dt_s;
+    double resp_phase = 2.0 * M_PI * uniform(synth);
+    synth->resp_c = cos(resp_phase);
+    synth->resp_s = sin(resp_phase);
+    synth->resp_rot_c = cos(w);
+    synth->resp_rot_s = sin(w);
+
+    // Start somewhere inside a beat
+    double rr = 60.0 / synth->config.hr_bpm;
+    synth->cur.onset_s = -rr * uniform(synth);
+    synth->cur.rr_s = rr;
+    synth->cur.scale_s = rr;
+    synth->cur.amp = 1.0f;
+    synth->prev = synth->cur;
+    synth->prev.onset_s -= rr;
+    schedule_motion(synth, 0.0);
+}
+
+/**
+ * Takes effect from the next beat.
+ */
+void PPGSynth_SetHeartRate(PPGSynth_t *synth, float hr_bpm) {
+    synth->config.hr_bpm = hr_bpm;
+}
+
+void PPGSynth_SetSpO2(PPGSynth_t *synth, float spo2) {
+    synth->config.spo2 = spo2;
+    synth->red_ratio = PPGSynth_RatioForSpO2(spo2);
+}
+
+/**
+ * Next red/IR sample (18-bit ADC counts); truth may be NULL.
+ */
+void PPGSynth_Next(PPGSynth_t *synth, uint32_t *red, uint32_t *ir, PPGSynth_Truth_t *truth) {
+    const PPGSynth_Config_t *cfg = &synth->config;
+    double t_s = (double)synth->index * synth->dt_s;
+    uint8_t flags = 0;
+
+    while (t_s >= synth->cur.onset_s + synth->cur.rr_s) {
+        next_beat(synth);
+        flags |= PPG_SYNTH_FLAG_BEAT;
+    }
+    if (synth->cur.ectopic) {
+        flags |= PPG_SYNTH_FLAG_ECTOPIC;
+    }
+
+    // Respiration: rotate the phasor, renormalise now and then against rounding drift
+    double c = synth->resp_c * synth->resp_rot_c - synth->resp_s * synth->resp_rot_s;
+    double s = synth->resp_s * synth->resp_rot_c + synth->resp_c * synth->resp_rot_s;
+    if ((synth->index & 0x3FF) == 0) {
+        double norm = 1.0 / sqrt(c * c + s * s);
+        c *= norm;
+        s *= norm;
+    }
+    synth->resp_c = c;
+    synth->resp_s = s;
+
+    float pulse = pulse_at(synth, &synth->cur, t_s) + pulse_at(synth, &synth->prev, t_s);
+    pulse *= 1.0f + cfg->resp_am * (float)s;
+    float baseline = 1.0f + cfg->resp_baseline * (float)c;
+    float motion = motion_at(synth, t_s, &flags);
+
+    float ir_ac = cfg->perfusion_index * cfg->ir_dc;
+    float red_ac = cfg->perfusion_index * synth->red_ratio * cfg->red_dc;
+    float ir_value = cfg->ir_dc * baseline - ir_ac * pulse + motion * ir_ac;
+    float red_value = cfg->red_dc * baseline - red_ac * pulse + 0.9f * motion * ir_ac * cfg->red_dc / cfg->ir_dc;
+    if (cfg->noise_sd > 0.0f) {
+        ir_value += cfg->noise_sd * gaussian(synth);
+        red_value += cfg->noise_sd * gaussian(synth);
+    }
+
+    synth->last_ir = quantise(synth, ir_value, &flags);
+    synth->last_red = quantise(synth, red_value, &flags);
+    synth->index++;
+    *red = synth->last_red;
+    *ir = synth->last_ir;
+    if (truth != NULL) {
+        truth->hr_bpm = (float)(60.0 / synth->cur.rr_s);
+        truth->spo2 = cfg->spo2;
+        truth->flags = flags;
+    }
+}
+
+/**
+ * count samples into the arrays (truth may be NULL).
+ */
+void PPGSynth_Generate(PPGSynth_t *synth, uint32_t *red, uint32_t *ir, PPGSynth_Truth_t *truth, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        PPGSynth_Next(synth, &red[i], &ir[i], truth != NULL ? &truth[i] : NULL);
+    }
+}
+
+/**
+ * Source for MAX30102Sim: the stream is advanced to the sample nearest to
+ * t_us (sample 0 at t = 0), so a sensor faster than the synthesiser holds
+ * values and a slower one skips them.
+ */
+void PPGSynth_Source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    PPGSynth_t *synth = (PPGSynth_t *)ctx;
+    uint64_t target = (uint64_t)((double)t_us * 1e-6 * synth->config.sample_rate_hz + 0.5);
+    uint32_t r, i;
+    while (synth->index <= target) {
+        PPGSynth_Next(synth, &r, &i, NULL);
+    }
+    *red = synth->last_red;
+    *ir = synth->last_ir;
+}
@@ -0,0 +1,297 @@
+/**
+ * @file ppg_variant.c
+ * @brief Method 1, Method 2 and the adaptive selection behind the PPGVariant_t interface
+ */
+
+#include "ppg_variant.h"
+#include <string.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include "ppg_adaptive.h"
+#include "filter_batch.h"
+#include "ppg_state.h"
+
+#define DPT_DISPLAY_SPO2_ALPHA  0.15f           // app.c, Method 2 SpO2 display smoothing
+
+typedef struct {
+    PPG_FilterState_t red_filter;
+    PPG_FilterState_t ir_filter;
+    HR_State_t hr;
+    SpO2_State_t spo2;
+    uint32_t sample_counter;
+    float displayed_hr;
+    float displayed_spo2;
+} Method1_State_t;
+
+typedef struct {
+    DPT_State_t dpt;
+    uint32_t sample_counter;
+    float displayed_spo2;
+} Method2_State_t;
+
+// Method 1 with a DPT kept warm behind it (ppg_adaptive.h)
+typedef struct {
+    Method1_State_t m1;
+    PPG_Adaptive_t selector;
+    DPT_State_t dpt;
+} Adaptive_State_t;
+
+static void method1_init(void *state, float sample_rate_hz) {
+    Method1_State_t *s = (Method1_State_t *)state;
+    memset(s, 0, sizeof(Method1_State_t));
+    PPG_Filter_Init(&s->red_filter);
+    PPG_Filter_Init(&s->ir_filter);
+    HR_Init(&s->hr);
+    SpO2_Init(&s->spo2);
+    HR_SetSampleRate(&s->hr, sample_rate_hz);
+}
+
+// app.c, USE_ALGORITHM_METHOD1 (and USE_ALGORITHM_ADAPTIVE: ad), after the filters
+static uint8_t method1_update(Method1_State_t *s, Adaptive_State_t *ad, PPGVariant_Output_t *out) {
+    if (++s->sample_counter < PPG_VARIANT_UPDATE_SAMPLES) {
+        return 0;
+    }
+    s->sample_counter = 0;
+
+    float heart_rate = HR_Calculate(&s->hr);
+    uint8_t hr_valid = HR_IsValid(&s->hr);
+    if (ad != NULL && PPG_Adaptive_Update(&ad->selector, &s->hr, &ad->dpt) == PPG_ADAPTIVE_DPT) {
+        heart_rate = DPT_GetHeartRate(&ad->dpt);
+        hr_valid = DPT_IsHeartRateValid(&ad->dpt);
+    }
+    float spo2 = SpO2_Calculate(&s->spo2,
+                                PPG_Filter_GetACRMS(&s->red_filter), PPG_Filter_GetDC(&s->red_filter),
+                                PPG_Filter_GetACRMS(&s->ir_filter), PPG_Filter_GetDC(&s->ir_filter));
+    if (hr_valid) {
+        s->displayed_hr = HR_DisplaySmooth(s->displayed_hr, heart_rate);
+    }
+    if (SpO2_IsValid(&s->spo2)) {
+        s->displayed_spo2 = (s->displayed_spo2 == 0.0f) ? spo2 :
+                            DISPLAY_EMA_ALPHA * spo2 + (1.0f - DISPLAY_EMA_ALPHA) * s->displayed_spo2;
+    }
+    out->hr_bpm = s->displayed_hr;
+    out->hr_valid = hr_valid && s->displayed_hr > 0.0f;
+    out->spo2 = s->displayed_spo2;
+    out->spo2_valid = SpO2_IsValid(&s->spo2) && s->displayed_spo2 > 0.0f;
+    return 1;
+}
+
+static uint8_t method1_process(void *state, uint32_t red, uint32_t ir, PPGVariant_Output_t *out) {
+    Method1_State_t *s = (Method1_State_t *)state;
+    PPG_Filter_Process(&s->red_filter, red);
+    float ac_ir = PPG_Filter_Process(&s->ir_filter, ir);
+    HR_AddSample(&s->hr, ac_ir, PPG_Filter_GetDC(&s->ir_filter));
+    return method1_update(s, NULL, out);
+}
+
+// The filter states only keep their AC statistics and dc_value here
+static uint8_t method1_process_filtered(void *state, const PPGVariant_Filtered_t *in, PPGVariant_Output_t *out) {
+    Method1_State_t *s = (Method1_State_t *)state;
+    FilterBatch_Accumulate(&s->red_filter, in->ac[0], in->dc[0]);
+    FilterBatch_Accumulate(&s->ir_filter, in->ac[1], in->dc[1]);
+    HR_AddSample(&s->hr, in->ac[1], in->dc[1]);
+    return method1_update(s, NULL, out);
+}
+
+static void method1_put(PPGState_Writer_t *w, const Method1_State_t *s) {
+    PPGState_PutFilter(w, &s->red_filter);
+    PPGState_PutFilter(w, &s->ir_filter);
+    PPGState_PutHR(w, &s->hr);
+    PPGState_PutSpO2(w, &s->spo2);
+    PPGState_PutU32(w, s->sample_counter);
+    PPGState_PutF32(w, s->displayed_hr);
+    PPGState_PutF32(w, s->displayed_spo2);
+}
+
+static int method1_get(PPGState_Reader_t *r, Method1_State_t *s) {
+    if (PPGState_GetFilter(r, &s->red_filter) != 0 || PPGState_GetFilter(r, &s->ir_filter) != 0 ||
+        PPGState_GetHR(r, &s->hr) != 0 || PPGState_GetSpO2(r, &s->spo2) != 0) {
+        return -1;
+    }
+    s->sample_counter = PPGState_GetU32(r);
+    s->displayed_hr = PPGState_GetF32(r);
+    s->displayed_spo2 = PPGState_GetF32(r);
+    return (r->error || s->sample_counter >= PPG_VARIANT_UPDATE_SAMPLES) ? -1 : 0;
+}
+
+static size_t method1_save(const void *state, uint8_t *buf, size_t cap) {
+    PPGState_Writer_t w;
+    PPGState_WriterInit(&w, buf, cap);
+    method1_put(&w, (const Method1_State_t *)state);
+    return w.error ? 0 : w.len;
+}
+
+static int method1_load(void *state, const uint8_t *buf, size_t len) {
+    PPGState_Reader_t r;
+    PPGState_ReaderInit(&r, buf, len);
+    return (method1_get(&r, (Method1_State_t *)state) != 0 || r.pos != r.len) ? -1 : 0;
+}
+
+#ifdef PPG_TUNABLE_PARAMS
+static void method1_set_params(void *state, const PPG_Params_t *params) {
+    HR_SetParams(&((Method1_State_t *)state)->hr, params);
+}
+#endif
+
+static void method2_init(void *state, float sample_rate_hz) {
+    Method2_State_t *s = (Method2_State_t *)state;
+    memset(s, 0, sizeof(Method2_State_t));
+    DPT_Init(&s->dpt);
+    DPT_SetSampleRate(&s->dpt, sample_rate_hz);
+}
+
+// app.c, USE_ALGORITHM_METHOD2
+static uint8_t method2_process(void *state, uint32_t red, uint32_t ir, PPGVariant_Output_t *out) {
+    Method2_State_t *s = (Method2_State_t *)state;
+    DPT_Process(&s->dpt, red, ir);
+
+    if (++s->sample_counter < PPG_VARIANT_UPDATE_SAMPLES) {
+        return 0;
+    }
+    s->sample_counter = 0;
+
+    float heart_rate = DPT_GetHeartRate(&s->dpt);
+    float spo2 = DPT_GetSpO2(&s->dpt);
+    if (DPT_IsSpO2Valid(&s->dpt)) {
+        s->displayed_spo2 = (s->displayed_spo2 == 0.0f) ? spo2 :
+                            DPT_DISPLAY_SPO2_ALPHA * spo2 + (1.0f - DPT_DISPLAY_SPO2_ALPHA) * s->displayed_spo2;
+    }
+    out->hr_bpm = heart_rate;
+    out->hr_valid = DPT_IsHeartRateValid(&s->dpt) && heart_rate > 0.0f;
+    out->spo2 = s->displayed_spo2;
+    out->spo2_valid = DPT_IsSpO2Valid(&s->dpt) && s->displayed_spo2 > 0.0f;
+    return 1;
+}
+
+static size_t method2_save(const void *state, uint8_t *buf, size_t cap) {
+    const Method2_State_t *s = (const Method2_State_t *)state;
+    PPGState_Writer_t w;
+    PPGState_WriterInit(&w, buf, cap);
+    PPGState_PutDPT(&w, &s->dpt);
+    PPGState_PutU32(&w, s->sample_counter);
+    PPGState_PutF32(&w, s->displayed_spo2);
+    return w.error ? 0 : w.len;
+}
+
+static int method2_load(void *state, const uint8_t *buf, size_t len) {
+    Method2_State_t *s = (Method2_State_t *)state;
+    PPGState_Reader_t r;
+    PPGState_ReaderInit(&r, buf, len);
+    if (PPGState_GetDPT(&r, &s->dpt) != 0) {
+        return -1;
+    }
+    s->sample_counter = PPGState_GetU32(&r);
+    s->displayed_spo2 = PPGState_GetF32(&r);
+    return (r.error || r.pos != r.len || s->sample_counter >= PPG_VARIANT_UPDATE_SAMPLES) ? -1 : 0;
+}
+
+#ifdef PPG_TUNABLE_PARAMS
+static void method2_set_params(void *state, const PPG_Params_t *params) {
+    DPT_SetParams(&((Method2_State_t *)state)->dpt, params);
+}
+#endif
+
+static void adaptive_init(void *state, float sample_rate_hz) {
+    Adaptive_State_t *s = (Adaptive_State_t *)state;
+    memset(s, 0, sizeof(Adaptive_State_t));
+    method1_init(&s->m1, sample_rate_hz);
+    PPG_Adaptive_Init(&s->selector);
+    DPT_Init(&s->dpt);
+    DPT_SetSampleRate(&s->dpt, sample_rate_hz);
+}
+
+// app.c, USE_ALGORITHM_ADAPTIVE: Method 1 on every sample, DPT in full or as a shadow
+static uint8_t adaptive_process(void *state, uint32_t red, uint32_t ir, PPGVariant_Output_t *out) {
+    Adaptive_State_t *s = (Adaptive_State_t *)state;
+    PPG_Filter_Process(&s->m1.red_filter, red);
+    float ac_ir = PPG_Filter_Process(&s->m1.ir_filter, ir);
+    HR_AddSample(&s->m1.hr, ac_ir, PPG_Filter_GetDC(&s->m1.ir_filter));
+    PPG_Adaptive_Process(&s->selector, &s->dpt, red, ir);
+    return method1_update(&s->m1, s, out);
+}
+
+static size_t adaptive_save(const void *state, uint8_t *buf, size_t cap) {
+    const Adaptive_State_t *s = (const Adaptive_State_t *)state;
+    PPGState_Writer_t w;
+    PPGState_WriterInit(&w, buf, cap);
+    method1_put(&w, &s->m1);
+    PPGState_PutU8(&w, s->selector.engine);
+    PPGState_PutU8(&w, s->selector.may_escalate);
+    PPGState_PutU8(&w, s->selector.noisy_votes);
+    PPGState_PutU8(&w, s->selector.invalid_votes);
+    PPGState_PutU8(&w, s->selector.recover_votes);
+    for (uint32_t e = 0; e < PPG_ADAPTIVE_ENGINES; e++) {
+        PPGState_PutU32(&w, s->selector.samples[e]);
+    }
+    PPGState_PutU32(&w, s->selector.escalations);
+    PPGState_PutU32(&w, s->selector.deescalations);
+    PPGState_PutU32(&w, s->selector.held);
+    PPGState_PutDPT(&w, &s->dpt);
+    return w.error ? 0 : w.len;
+}
+
+static int adaptive_load(void *state, const uint8_t *buf, size_t len) {
+    Adaptive_State_t *s = (Adaptive_State_t *)state;
+    PPGState_Reader_t r;
+    PPGState_ReaderInit(&r, buf, len);
+    if (method1_get(&r, &s->m1) != 0) {
+        return -1;
+    }
+    s->selector.engine = PPGState_GetU8(&r);
+    s->selector.may_escalate = PPGState_GetU8(&r);
+    s->selector.noisy_votes = PPGState_GetU8(&r);
+    s->selector.invalid_votes = PPGState_GetU8(&r);
+    s->selector.recover_votes = PPGState_GetU8(&r);
+    for (uint32_t e = 0; e < PPG_ADAPTIVE_ENGINES; e++) {
+        s->selector.samples[e] = PPGState_GetU32(&r);
+    }
+    s->selector.escalations = PPGState_GetU32(&r);
+    s->selector.deescalations = PPGState_GetU32(&r);
+    s->selector.held = PPGState_GetU32(&r);
+    if (r.error || s->selector.engine >= PPG_ADAPTIVE_ENGINES || PPGState_GetDPT(&r, &s->dpt) != 0) {
+        return -1;
+    }
+    return (r.error || r.pos != r.len) ? -1 : 0;
+}
+
+static PPG_Adaptive_t *adaptive_selector(void *state) {
+    return &((Adaptive_State_t *)state)->selector;
+}
+
+#ifdef PPG_TUNABLE_PARAMS
+static void adaptive_set_params(void *state, const PPG_Params_t *params) {
+    Adaptive_State_t *s = (Adaptive_State_t *)state;
+    HR_SetParams(&s->m1.hr, params);
+    DPT_SetParams(&s->dpt, params);
+}
+#define SET_PARAMS(fn)  , fn
+#else
+#define SET_PARAMS(fn)
+#endif
+
+static const PPGVariant_t variants[] = {
+    { "m1", "Method 1: time-domain peak detection", sizeof(Method1_State_t), method1_init, method1_process,
+      method1_process_filtered, method1_save, method1_load, NULL SET_PARAMS(method1_set_params) },
+    { "m2", "Method 2: DPT (period transform)",     sizeof(Method2_State_t), method2_init, method2_process,
+      NULL, method2_save, method2_load, NULL SET_PARAMS(method2_set_params) },
+    { "ad", "Adaptive: Method 1, DPT on poor signal", sizeof(Adaptive_State_t), adaptive_init, adaptive_process,
+      NULL, adaptive_save, adaptive_load, adaptive_selector SET_PARAMS(adaptive_set_params) },
+};
+
+uint32_t PPGVariant_Count(void) {
+    return (uint32_t)(sizeof(variants) / sizeof(variants[0]));
+}
+
+const PPGVariant_t *PPGVariant_Get(uint32_t index) {
+    return (index < PPGVariant_Count()) ? &variants[index] : NULL;
+}
+
+const PPGVariant_t *PPGVariant_Find(const char *name) {
+    for (uint32_t i = 0; i < PPGVariant_Count(); i++) {
+        if (strcmp(variants[i].name, name) == 0) {
+            return &variants[i];
+        }
+    }
+    return NULL;
+}
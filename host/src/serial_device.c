@@ -0,0 +1,84 @@
+/**
+ * @file serial_device.c
+ * @brief Stand-in for a bedside unit's serial output
+ */
+
+#include "serial_device.h"
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+
+static SerialDevice_t *sending;     // the device TLM_Send writes for
+
+static void append(SerialDevice_t *dev, const uint8_t *data, size_t n) {
+    dev->bytes += n;
+    size_t fit = (dev->size - dev->len < n) ? dev->size - dev->len : n;
+    memcpy(&dev->out[dev->len], data, fit);
+    dev->len += fit;
+    dev->overflow += n - fit;
+}
+
+static void device_tx(const uint8_t *data, uint16_t len) {
+    append(sending, data, len);
+}
+
+void SerialDevice_Init(SerialDevice_t *dev, uint8_t *buf, size_t size) {
+    memset(dev, 0, sizeof(SerialDevice_t));
+    dev->out = buf;
+    dev->size = size;
+    PPG_Capture_Init(&dev->capture);
+}
+
+void SerialDevice_Push(SerialDevice_t *dev, uint32_t red, uint32_t ir) {
+    sending = dev;
+    TLM_Init(device_tx);
+    PPG_Capture_Push(&dev->capture, red, ir);
+    dev->samples++;
+}
+
+void SerialDevice_Flush(SerialDevice_t *dev) {
+    sending = dev;
+    TLM_Init(device_tx);
+    PPG_Capture_Flush(&dev->capture);
+}
+
+void SerialDevice_Report(SerialDevice_t *dev, int method, float hr, int hr_valid, float spo2, int spo2_valid) {
+    char line[128];
+    int n;
+    if (!hr_valid) {
+        n = snprintf(line, sizeof(line), "[Method%d] HR: %.1f BPM (Acquiring...)\r\n", method, hr);
+    } else if (method == 2) {
+        // Method 2 adds the DPT peak period, in samples at 100 Hz
+        unsigned period = hr > 0.0f ? (unsigned)(6000.0f / hr + 0.5f) : 0u;
+        n = snprintf(line, sizeof(line), "[Method2] HR: %.1f BPM | Peak Period: %u samples (Valid)\r\n", hr,
+                     period);
+    } else {
+        n = snprintf(line, sizeof(line), "[Method%d] HR: %.1f BPM (Valid)\r\n", method, hr);
+    }
+    append(dev, (const uint8_t *)line, (size_t)n);
+    if (spo2_valid) {
+        n = snprintf(line, sizeof(line), "[Method%d] SpO2: %.1f %%\r\n", method, spo2);
+    } else {
+        n = snprintf(line, sizeof(line), "[Method%d] SpO2: --\r\n", method);
+    }
+    append(dev, (const uint8_t *)line, (size_t)n);
+}
+
+void SerialDevice_Print(SerialDevice_t *dev, const char *text) {
+    append(dev, (const uint8_t *)text, strlen(text));
+}
+
+void SerialDevice_Send(SerialDevice_t *dev, uint8_t type, const uint8_t *payload, uint16_t len) {
+    sending = dev;
+    TLM_Init(device_tx);
+    TLM_Send(type, payload, len);
+}
+
+void SerialDevice_Consume(SerialDevice_t *dev, size_t n) {
+    if (n >= dev->len) {
+        dev->len = 0;
+        return;
+    }
+    memmove(dev->out, &dev->out[n], dev->len - n);
+    dev->len -= n;
+}
@@ -0,0 +1,446 @@
+/**
+ * @file serial_ingest.c
+ * @brief Ingestion of many device serial links into per-stream rings
+ */
+
+#define _GNU_SOURCE
+#include "serial_ingest.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "telemetry.h"
+#include "ppg_codec.h"
+
+typedef struct {
+    int fd;
+    uint8_t frame_ready;            // a raw frame is parsed, waiting for room in the ring
+    uint8_t have_index;
+    uint8_t skipping;               // inside a line too long to keep
+    uint16_t rpos;                  // buf[rpos .. rlen) not parsed yet
+    uint16_t rlen;
+    uint16_t line_len;
+    uint32_t expected_index;        // capture index of the next sample
+    uint64_t t_ns;                  // time of the read the buffer holds
+    uint8_t *buf;
+    ShmRing_t ring;
+    PPG_Decoder_t dec;
+    TLM_Parser_t tlm;
+    char line[SERIAL_INGEST_LINE_MAX];
+    SerialIngest_LinkStats_t stats;
+} Ingest_Link_t;
+
+struct SerialIngest {
+    SerialIngest_Config_t config;
+    int epoll_fd;
+    uint32_t count;                 // links added
+    Ingest_Link_t *link;
+    uint8_t *buffers;               // the links' read buffers, one allocation
+    uint32_t *paused;               // ids of the paused links
+    uint32_t paused_count;
+    struct epoll_event events[SERIAL_INGEST_EVENTS];
+    pthread_t thread;
+    int running;
+    _Atomic int stop;
+    // Held while links are serviced; GetStats / GetLink read under it
+    pthread_mutex_t lock;
+    uint64_t reads;
+    uint64_t polls;
+    uint64_t busy_ns;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// A result line of the firmware: "[Method1] HR: 72.4 BPM (Valid)", "[Method2] SpO2: --" ...
+static void link_line(Ingest_Link_t *l, const char *line) {
+    if (strncmp(line, "[Method", 7) != 0 || (line[7] != '1' && line[7] != '2') || line[8] != ']' ||
+        line[9] != ' ') {
+        return;
+    }
+    int m = line[7] - '1';
+    const char *rest = &line[10];
+    char *end;
+    if (strncmp(rest, "HR: ", 4) == 0) {
+        float hr = strtof(rest + 4, &end);
+        if (end != rest + 4) {
+            l->stats.hr[m] = hr;
+            l->stats.hr_valid[m] = (strstr(end, "(Valid)") != NULL);
+            l->stats.reports[m]++;
+        }
+    } else if (strncmp(rest, "SpO2: ", 6) == 0) {
+        float spo2 = strtof(rest + 6, &end);
+        l->stats.spo2_valid[m] = (end != rest + 6);
+        l->stats.spo2[m] = l->stats.spo2_valid[m] ? spo2 : 0.0f;
+    }
+}
+
+// Text between frames: whole lines to link_line, the rest kept for the next read
+static void link_text(Ingest_Link_t *l, const uint8_t *p, uint32_t n) {
+    while (n > 0) {
+        const uint8_t *nl = (const uint8_t *)memchr(p, '\n', n);
+        uint32_t take = nl ? (uint32_t)(nl - p) : n;
+        if (!l->skipping) {
+            if (l->line_len + take < SERIAL_INGEST_LINE_MAX) {
+                memcpy(&l->line[l->line_len], p, take);
+                l->line_len = (uint16_t)(l->line_len + take);
+            } else {
+                l->skipping = 1;
+                l->stats.long_lines++;
+            }
+        }
+        if (nl == NULL) {
+            return;
+        }
+        if (!l->skipping) {
+            if (l->line_len > 0 && l->line[l->line_len - 1] == '\r') {
+                l->line_len--;
+            }
+            l->line[l->line_len] = '\0';
+            link_line(l, l->line);
+        }
+        l->stats.lines++;
+        l->skipping = 0;
+        l->line_len = 0;
+        p += take + 1;
+        n -= take + 1;
+    }
+}
+
+// Decode the parsed raw frame into the ring. 0, -1 no room for it yet
+static int link_deliver(Ingest_Link_t *l) {
+    const uint8_t *payload = l->tlm.payload;
+    uint16_t len = l->tlm.len;
+    if (len < PPG_CAPTURE_FRAME_HEADER) {
+        l->frame_ready = 0;
+        return 0;
+    }
+    uint32_t index = read_le32(payload);
+    uint8_t blocks = payload[4];
+    uint32_t most = (uint32_t)blocks * PPG_CODEC_BLOCK_SIZE;
+    if (most > l->ring.mask + 1) {
+        most = l->ring.mask + 1;        // more than a ring holds: only from a corrupt count
+    }
+    if (ShmRing_Room(&l->ring) < most) {
+        return -1;
+    }
+    l->frame_ready = 0;
+    l->stats.frames++;
+
+    if (l->have_index && index != l->expected_index) {
+        // Gap: the predictor history is gone until the next keyframe
+        if (index > l->expected_index) {
+            l->stats.samples_lost += index - l->expected_index;
+        }
+        PPG_Decoder_Init(&l->dec);
+    }
+    l->have_index = 1;
+
+    // Block by block into the frames reserved for it, committed together
+    uint32_t first = 0, total = 0;
+    uint16_t pos = PPG_CAPTURE_FRAME_HEADER;
+    for (uint8_t b = 0; b < blocks; b++) {
+        uint32_t red[PPG_CODEC_BLOCK_SIZE], ir[PPG_CODEC_BLOCK_SIZE];
+        uint8_t count = 0;
+        int16_t used = PPG_Decoder_DecodeBlock(&l->dec, &payload[pos], (uint16_t)(len - pos), red, ir, &count);
+        if (used < 0) {
+            PPG_Decoder_Init(&l->dec);
+            break;
+        }
+        pos = (uint16_t)(pos + used);
+        if (count == 0) {
+            continue;
+        }
+        uint32_t at = 0;
+        if (!l->dec.synced || total + count > most || ShmRing_Reserve(&l->ring, count, &at) != count) {
+            l->stats.samples_lost += count;
+            index += count;
+            continue;
+        }
+        first = total ? first : at;
+        for (uint8_t i = 0; i < count; i++) {
+            ShmRing_Frame_t *f = ShmRing_Frame(&l->ring, at + i);
+            f->red = red[i];
+            f->ir = ir[i];
+            f->t_ns = l->t_ns;
+        }
+        total += count;
+        index += count;
+    }
+    if (total > 0) {
+        ShmRing_Commit(&l->ring, first, total);
+        l->stats.samples += total;
+    }
+    l->expected_index = index;
+    return 0;
+}
+
+// Parse the rest of the buffer. 0 all of it, -1 stopped at a frame its ring has no room for
+static int link_parse(Ingest_Link_t *l) {
+    for (;;) {
+        if (l->frame_ready && link_deliver(l) != 0) {
+            return -1;
+        }
+        if (l->rpos == l->rlen) {
+            return 0;
+        }
+        if (TLM_Parser_Idle(&l->tlm)) {
+            // Text up to the next sync byte
+            const uint8_t *p = &l->buf[l->rpos];
+            const uint8_t *sync = (const uint8_t *)memchr(p, TLM_SYNC0, (size_t)(l->rlen - l->rpos));
+            uint32_t n = sync ? (uint32_t)(sync - p) : (uint32_t)(l->rlen - l->rpos);
+            link_text(l, p, n);
+            l->rpos = (uint16_t)(l->rpos + n);
+            if (sync == NULL) {
+                return 0;
+            }
+        }
+        // A frame, until it completes or turns out to be a false sync
+        while (l->rpos < l->rlen) {
+            if (TLM_Parser_Feed(&l->tlm, l->buf[l->rpos++])) {
+                if (l->tlm.type == TLM_TYPE_RAW_PPG) {
+                    l->frame_ready = 1;
+                } else {
+                    l->stats.other_frames++;
+                }
+                break;
+            }
+            if (TLM_Parser_Idle(&l->tlm)) {
+                break;
+            }
+        }
+    }
+}
+
+static void link_close(SerialIngest_t *in, Ingest_Link_t *l) {
+    epoll_ctl(in->epoll_fd, EPOLL_CTL_DEL, l->fd, NULL);
+    close(l->fd);
+    l->fd = -1;
+    l->stats.open = 0;
+}
+
+static void link_pause(SerialIngest_t *in, Ingest_Link_t *l) {
+    epoll_ctl(in->epoll_fd, EPOLL_CTL_DEL, l->fd, NULL);
+    in->paused[in->paused_count++] = (uint32_t)(l - in->link);
+    l->stats.paused = 1;
+    l->stats.pauses++;
+}
+
+static int link_arm(SerialIngest_t *in, uint32_t id) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = id;
+    return epoll_ctl(in->epoll_fd, EPOLL_CTL_ADD, in->link[id].fd, &ev);
+}
+
+// One read of a ready link, parsed at once
+static void link_service(SerialIngest_t *in, Ingest_Link_t *l) {
+    ssize_t n = read(l->fd, l->buf, SERIAL_INGEST_READ_BYTES);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (n <= 0) {
+        link_close(in, l);          // end of file; EIO: the other side of a pty closed
+        return;
+    }
+    in->reads++;
+    l->t_ns = now_ns();
+    l->rpos = 0;
+    l->rlen = (uint16_t)n;
+    l->stats.bytes += (uint64_t)n;
+    if (link_parse(l) != 0) {
+        link_pause(in, l);
+    }
+    l->stats.crc_errors = l->tlm.crc_errors;
+}
+
+SerialIngest_t *SerialIngest_Create(const SerialIngest_Config_t *config) {
+    if (config->links == 0 || config->rings == NULL || config->rings->rings < config->links) {
+        return NULL;
+    }
+    SerialIngest_t *in = (SerialIngest_t *)calloc(1, sizeof(SerialIngest_t));
+    if (in == NULL) {
+        return NULL;
+    }
+    in->config = *config;
+    in->link = (Ingest_Link_t *)calloc(config->links, sizeof(Ingest_Link_t));
+    in->buffers = (uint8_t *)malloc((size_t)config->links * SERIAL_INGEST_READ_BYTES);
+    in->paused = (uint32_t *)malloc(config->links * sizeof(uint32_t));
+    in->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (in->link == NULL || in->buffers == NULL || in->paused == NULL || in->epoll_fd < 0) {
+        if (in->epoll_fd >= 0) {
+            close(in->epoll_fd);
+        }
+        free(in->link);
+        free(in->buffers);
+        free(in->paused);
+        free(in);
+        return NULL;
+    }
+    pthread_mutex_init(&in->lock, NULL);
+    return in;
+}
+
+void SerialIngest_Destroy(SerialIngest_t *in) {
+    if (in == NULL) {
+        return;
+    }
+    SerialIngest_Stop(in);
+    for (uint32_t i = 0; i < in->count; i++) {
+        if (in->link[i].fd >= 0) {
+            close(in->link[i].fd);
+        }
+    }
+    close(in->epoll_fd);
+    pthread_mutex_destroy(&in->lock);
+    free(in->link);
+    free(in->buffers);
+    free(in->paused);
+    free(in);
+}
+
+int SerialIngest_Add(SerialIngest_t *in, int fd) {
+    if (in->count == in->config.links) {
+        return -1;
+    }
+    // A serial port or pty passes bytes as they are: no echo, no line editing, no CR/LF mapping
+    struct termios tio;
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    uint32_t id = in->count;
+    Ingest_Link_t *l = &in->link[id];
+    memset(l, 0, sizeof(Ingest_Link_t));
+    l->fd = fd;
+    l->buf = &in->buffers[(size_t)id * SERIAL_INGEST_READ_BYTES];
+    l->ring = *ShmRing_Get(in->config.rings, id);
+    TLM_Parser_Init(&l->tlm);
+    PPG_Decoder_Init(&l->dec);
+    l->stats.open = 1;
+    if (link_arm(in, id) != 0) {
+        l->fd = -1;
+        return -1;
+    }
+    in->count++;
+    return (int)id;
+}
+
+int SerialIngest_Poll(SerialIngest_t *in, int timeout_ms) {
+    // Paused links first: their rings may have room now
+    uint64_t t0 = now_ns();
+    uint32_t still = 0;
+    for (uint32_t k = 0; k < in->paused_count; k++) {
+        Ingest_Link_t *l = &in->link[in->paused[k]];
+        pthread_mutex_lock(&in->lock);
+        if (link_parse(l) != 0) {
+            in->paused[still++] = in->paused[k];
+        } else {
+            l->stats.paused = 0;
+            l->stats.crc_errors = l->tlm.crc_errors;
+            if (link_arm(in, in->paused[k]) != 0) {
+                link_close(in, l);
+            }
+        }
+        pthread_mutex_unlock(&in->lock);
+    }
+    in->paused_count = still;
+    uint64_t t1 = now_ns();
+    if (still > 0 && (timeout_ms < 0 || timeout_ms > 1)) {
+        timeout_ms = 1;
+    }
+
+    int n = epoll_wait(in->epoll_fd, in->events, SERIAL_INGEST_EVENTS, timeout_ms);
+    if (n < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    uint64_t t2 = now_ns();
+    pthread_mutex_lock(&in->lock);
+    for (int i = 0; i < n; i++) {
+        link_service(in, &in->link[in->events[i].data.u32]);
+    }
+    in->polls += (n > 0);
+    in->busy_ns += (t1 - t0) + (n > 0 ? now_ns() - t2 : 0);
+    pthread_mutex_unlock(&in->lock);
+    return n;
+}
+
+static void *ingest_main(void *arg) {
+    SerialIngest_t *in = (SerialIngest_t *)arg;
+    while (!atomic_load_explicit(&in->stop, memory_order_relaxed)) {
+        if (SerialIngest_Poll(in, SERIAL_INGEST_POLL_MS) < 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+int SerialIngest_Start(SerialIngest_t *in) {
+    if (in->running) {
+        return -1;
+    }
+    atomic_store(&in->stop, 0);
+    if (pthread_create(&in->thread, NULL, ingest_main, in) != 0) {
+        return -1;
+    }
+    in->running = 1;
+    return 0;
+}
+
+void SerialIngest_Stop(SerialIngest_t *in) {
+    if (!in->running) {
+        return;
+    }
+    atomic_store(&in->stop, 1);
+    pthread_join(in->thread, NULL);
+    in->running = 0;
+}
+
+void SerialIngest_GetStats(SerialIngest_t *in, SerialIngest_Stats_t *stats) {
+    memset(stats, 0, sizeof(SerialIngest_Stats_t));
+    pthread_mutex_lock(&in->lock);
+    stats->links = in->count;
+    stats->reads = in->reads;
+    stats->polls = in->polls;
+    stats->busy_s = in->busy_ns / 1e9;
+    for (uint32_t i = 0; i < in->count; i++) {
+        const SerialIngest_LinkStats_t *ls = &in->link[i].stats;
+        stats->open += ls->open;
+        stats->paused += ls->paused;
+        stats->bytes += ls->bytes;
+        stats->samples += ls->samples;
+        stats->samples_lost += ls->samples_lost;
+        stats->frames += ls->frames;
+        stats->other_frames += ls->other_frames;
+        stats->crc_errors += ls->crc_errors;
+        stats->lines += ls->lines;
+        stats->reports += ls->reports[0] + ls->reports[1];
+        stats->pauses += ls->pauses;
+    }
+    pthread_mutex_unlock(&in->lock);
+}
+
+int SerialIngest_GetLink(SerialIngest_t *in, uint32_t link, SerialIngest_LinkStats_t *stats) {
+    if (link >= in->count) {
+        return -1;
+    }
+    pthread_mutex_lock(&in->lock);
+    *stats = in->link[link].stats;
+    pthread_mutex_unlock(&in->lock);
+    return 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * @file shm_ring.c
+ * @brief Shared-memory rings of timestamped red/IR frames between processes
+ */
+
+#define _GNU_SOURCE
+#include "shm_ring.h"
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+_Static_assert(sizeof(ShmRing_Frame_t) == 16, "frame layout");
+_Static_assert(sizeof(ShmRing_Ctrl_t) == 128, "ring control layout");
+
+#define SPINS_BEFORE_YIELD  64
+
+// Start of the segment
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rings;
+    uint32_t frames;
+    uint32_t flags;
+    uint32_t ctrl_bytes;
+    uint64_t ring_bytes;
+} Seg_Header_t;
+
+static uint64_t ring_bytes(uint32_t frames) {
+    return sizeof(ShmRing_Ctrl_t) + (uint64_t)frames * sizeof(ShmRing_Frame_t);
+}
+
+static int futex(_Atomic uint32_t *word, int op, uint32_t val, const struct timespec *timeout) {
+    // Shared (not FUTEX_PRIVATE_FLAG): the word is in memory mapped by other processes
+    return (int)syscall(SYS_futex, (uint32_t *)word, op, val, timeout, NULL, 0);
+}
+
+// Process-local handles of the rings of a mapped segment
+static int seg_map(ShmRing_Seg_t *seg) {
+    seg->ring = (ShmRing_t *)malloc(seg->rings * sizeof(ShmRing_t));
+    if (seg->ring == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < seg->rings; i++) {
+        uint8_t *at = seg->base + SHM_RING_HEADER + (size_t)i * ring_bytes(seg->frames);
+        seg->ring[i].ctrl = (ShmRing_Ctrl_t *)at;
+        seg->ring[i].frames = (ShmRing_Frame_t *)(at + sizeof(ShmRing_Ctrl_t));
+        seg->ring[i].mask = seg->frames - 1;
+        seg->ring[i].flags = seg->flags;
+    }
+    return 0;
+}
+
+// ---- Segments ----
+
+/**
+ * Create a segment (memfd, zero-filled: every ring empty) and map it.
+ * @return 0, -1 (frames not a power of two from 2 to 2^24, no memory)
+ */
+int ShmRing_Create(ShmRing_Seg_t *seg, uint32_t rings, uint32_t frames, uint32_t flags) {
+    memset(seg, 0, sizeof(ShmRing_Seg_t));
+    seg->fd = -1;
+    if (rings == 0 || frames < 2 || frames > (1u << 24) || (frames & (frames - 1)) != 0 ||
+        (flags & ~SHM_RING_MPSC) != 0) {
+        return -1;
+    }
+    seg->rings = rings;
+    seg->frames = frames;
+    seg->flags = flags;
+    seg->size = SHM_RING_HEADER + (size_t)rings * ring_bytes(frames);
+    seg->fd = memfd_create("ppg-shm-ring", MFD_CLOEXEC);
+    if (seg->fd < 0 || ftruncate(seg->fd, (off_t)seg->size) != 0) {
+        ShmRing_Detach(seg);
+        return -1;
+    }
+    seg->base = (uint8_t *)mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, seg->fd, 0);
+    if (seg->base == MAP_FAILED) {
+        seg->base = NULL;
+        ShmRing_Detach(seg);
+        return -1;
+    }
+    Seg_Header_t *h = (Seg_Header_t *)seg->base;
+    h->version = SHM_RING_VERSION;
+    h->rings = rings;
+    h->frames = frames;
+    h->flags = flags;
+    h->ctrl_bytes = sizeof(ShmRing_Ctrl_t);
+    h->ring_bytes = ring_bytes(frames);
+    atomic_thread_fence(memory_order_release);
+    h->magic = SHM_RING_MAGIC;
+    if (seg_map(seg) != 0) {
+        ShmRing_Detach(seg);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Map a segment from its fd (inherited or received); the handle then owns fd.
+ * @return 0, -1 if it is not a segment of this version or its size is wrong
+ *         (fd left to the caller)
+ */
+int ShmRing_Attach(ShmRing_Seg_t *seg, int fd) {
+    memset(seg, 0, sizeof(ShmRing_Seg_t));
+    seg->fd = -1;
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (uint64_t)st.st_size < SHM_RING_HEADER) {
+        return -1;
+    }
+    seg->size = (size_t)st.st_size;
+    seg->base = (uint8_t *)mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (seg->base == MAP_FAILED) {
+        seg->base = NULL;
+        return -1;
+    }
+    Seg_Header_t h;
+    memcpy(&h, seg->base, sizeof(h));
+    if (h.magic != SHM_RING_MAGIC || h.version != SHM_RING_VERSION || h.rings == 0 || h.frames < 2 ||
+        h.frames > (1u << 24) || (h.frames & (h.frames - 1)) != 0 || (h.flags & ~SHM_RING_MPSC) != 0 ||
+        h.ctrl_bytes != sizeof(ShmRing_Ctrl_t) || h.ring_bytes != ring_bytes(h.frames) ||
+        seg->size != SHM_RING_HEADER + (uint64_t)h.rings * h.ring_bytes) {
+        munmap(seg->base, seg->size);
+        seg->base = NULL;
+        return -1;
+    }
+    seg->rings = h.rings;
+    seg->frames = h.frames;
+    seg->flags = h.flags;
+    if (seg_map(seg) != 0) {
+        ShmRing_Detach(seg);
+        return -1;
+    }
+    seg->fd = fd;
+    return 0;
+}
+
+void ShmRing_Detach(ShmRing_Seg_t *seg) {
+    if (seg->base != NULL) {
+        munmap(seg->base, seg->size);
+    }
+    if (seg->fd >= 0) {
+        close(seg->fd);
+    }
+    free(seg->ring);
+    memset(seg, 0, sizeof(ShmRing_Seg_t));
+    seg->fd = -1;
+}
+
+ShmRing_t *ShmRing_Get(ShmRing_Seg_t *seg, uint32_t ring) {
+    return ring < seg->rings ? &seg->ring[ring] : NULL;
+}
+
+int ShmRing_SendFd(int sock, int fd) {
+    char byte = 'S';
+    struct iovec iov = { &byte, 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    ssize_t n;
+    while ((n = sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    return n == 1 ? 0 : -1;
+}
+
+int ShmRing_RecvFd(int sock) {
+    char byte;
+    struct iovec iov = { &byte, 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n;
+    while ((n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (n != 1 || cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+// ---- Producers ----
+
+uint32_t ShmRing_Reserve(ShmRing_t *r, uint32_t n, uint32_t *pos) {
+    ShmRing_Ctrl_t *c = r->ctrl;
+    const uint32_t capacity = r->mask + 1;
+    uint32_t head = atomic_load_explicit(&c->prod_head, memory_order_relaxed);
+    for (;;) {
+        // Acquire: the consumer is done with the frames it released
+        uint32_t used = head - atomic_load_explicit(&c->cons_tail, memory_order_acquire);
+        uint32_t room = (used < capacity) ? capacity - used : 0;
+        uint32_t count = (n < room) ? n : room;
+        if (count == 0) {
+            return 0;
+        }
+        if (!(r->flags & SHM_RING_MPSC)) {
+            atomic_store_explicit(&c->prod_head, head + count, memory_order_relaxed);
+            *pos = head;
+            return count;
+        }
+        if (atomic_compare_exchange_weak_explicit(&c->prod_head, &head, head + count, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            *pos = head;
+            return count;
+        }
+    }
+}
+
+void ShmRing_Commit(ShmRing_t *r, uint32_t pos, uint32_t n) {
+    ShmRing_Ctrl_t *c = r->ctrl;
+    if (r->flags & SHM_RING_MPSC) {
+        // In reservation order; acquire, so the earlier producers' frames go out with ours
+        for (uint32_t spin = 0; atomic_load_explicit(&c->prod_tail, memory_order_acquire) != pos; spin++) {
+            if (spin >= SPINS_BEFORE_YIELD) {
+                sched_yield();
+            }
+        }
+    }
+    atomic_store_explicit(&c->prod_tail, pos + n, memory_order_release);
+    // Against ShmRing_Wait: either it sees the new tail, or we see it sleeping.
+    // Woken once its watermark is reached; the first producer there takes the
+    // flag: one wake per sleep, not one per commit
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&c->sleeping, memory_order_relaxed) &&
+        (int32_t)(pos + n - atomic_load_explicit(&c->wake_at, memory_order_relaxed)) >= 0 &&
+        atomic_exchange_explicit(&c->sleeping, 0, memory_order_relaxed)) {
+        futex(&c->prod_tail, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+uint32_t ShmRing_Room(const ShmRing_t *r) {
+    uint32_t used = atomic_load_explicit(&r->ctrl->prod_head, memory_order_relaxed) -
+                    atomic_load_explicit(&r->ctrl->cons_tail, memory_order_acquire);
+    return (used < r->mask + 1) ? r->mask + 1 - used : 0;
+}
+
+int ShmRing_Push(ShmRing_t *r, uint32_t red, uint32_t ir, uint64_t t_ns) {
+    uint32_t pos;
+    if (ShmRing_Reserve(r, 1, &pos) == 0) {
+        ShmRing_AddDropped(r, 1);
+        return -1;
+    }
+    ShmRing_Frame_t *f = ShmRing_Frame(r, pos);
+    f->red = red;
+    f->ir = ir;
+    f->t_ns = t_ns;
+    ShmRing_Commit(r, pos, 1);
+    return 0;
+}
+
+void ShmRing_AddDropped(ShmRing_t *r, uint64_t n) {
+    atomic_fetch_add_explicit(&r->ctrl->dropped, n, memory_order_relaxed);
+}
+
+// ---- Consumer ----
+
+uint32_t ShmRing_Peek(const ShmRing_t *r, uint32_t *pos) {
+    const ShmRing_Ctrl_t *c = r->ctrl;
+    uint32_t tail = atomic_load_explicit(&c->cons_tail, memory_order_relaxed);
+    uint32_t n = atomic_load_explicit(&c->prod_tail, memory_order_acquire) - tail;
+    *pos = tail;
+    return (n <= r->mask + 1) ? n : r->mask + 1;   // a producer gone wrong cannot send us past the ring
+}
+
+void ShmRing_Release(ShmRing_t *r, uint32_t pos) {
+    atomic_store_explicit(&r->ctrl->cons_tail, pos, memory_order_release);
+}
+
+int ShmRing_Wait(ShmRing_t *r, uint32_t min_frames, uint64_t timeout_ns) {
+    ShmRing_Ctrl_t *c = r->ctrl;
+    uint32_t tail = atomic_load_explicit(&c->cons_tail, memory_order_relaxed);
+    if (min_frames == 0 || min_frames > r->mask + 1) {
+        min_frames = (min_frames == 0) ? 1 : r->mask + 1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t deadline = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec + timeout_ns;
+    uint32_t head;
+    for (;;) {
+        // Re-armed every round: a producer that woke us has cleared the flag
+        atomic_store_explicit(&c->wake_at, tail + min_frames, memory_order_relaxed);
+        atomic_store_explicit(&c->sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        head = atomic_load_explicit(&c->prod_tail, memory_order_acquire);
+        if (head - tail >= min_frames) {
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t t = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+        if (t >= deadline) {
+            break;
+        }
+        struct timespec ts = { (time_t)((deadline - t) / 1000000000ull), (long)((deadline - t) % 1000000000ull) };
+        futex(&c->prod_tail, FUTEX_WAIT, head, &ts);        // returns at once if the tail moved
+    }
+    atomic_store_explicit(&c->sleeping, 0, memory_order_relaxed);
+    return head != tail;
+}
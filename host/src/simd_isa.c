@@ -0,0 +1,40 @@
+/**
+ * @file simd_isa.c
+ * @brief Run-time choice of the vector kernels of the batched engines
+ */
+
+#include "simd_isa.h"
+
+int SimdIsa_Supported(uint32_t isa) {
+    switch (isa) {
+    case SIMD_ISA_SCALAR:
+        return 1;
+#if defined(__x86_64__) || defined(__i386__)
+    case SIMD_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case SIMD_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef __aarch64__
+    case SIMD_ISA_NEON:
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+uint32_t SimdIsa_Best(void) {
+    static const uint32_t order[] = { SIMD_ISA_AVX512, SIMD_ISA_AVX2, SIMD_ISA_NEON };
+    for (uint32_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        if (SimdIsa_Supported(order[i])) {
+            return order[i];
+        }
+    }
+    return SIMD_ISA_SCALAR;
+}
+
+const char *SimdIsa_Name(uint32_t isa) {
+    static const char *const names[SIMD_ISA_COUNT] = { "scalar", "avx2", "avx512", "neon" };
+    return isa < SIMD_ISA_COUNT ? names[isa] : "?";
+}
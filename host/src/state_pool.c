@@ -0,0 +1,99 @@
+/**
+ * @file state_pool.c
+ * @brief Slab pools of per-stream state behind stable handles
+ */
+
+#include "state_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t slab_objects(const StatePool_t *p) {
+    return 1u << p->slab_shift;
+}
+
+// The slab of slot h, allocated on first use. 0, -1
+static int slab_ready(StatePool_t *p, StatePool_Handle_t h) {
+    uint8_t **slab = &p->slab[h >> p->slab_shift];
+    if (*slab == NULL) {
+        size_t bytes = p->stride * slab_objects(p);
+        bytes = (bytes + STATE_POOL_SLAB_ALIGN - 1) & ~(size_t)(STATE_POOL_SLAB_ALIGN - 1);
+        *slab = (uint8_t *)aligned_alloc(STATE_POOL_SLAB_ALIGN, bytes);
+    }
+    return *slab != NULL ? 0 : -1;
+}
+
+int StatePool_Init(StatePool_t *p, size_t size, uint32_t slab_objects, uint32_t capacity) {
+    memset(p, 0, sizeof(StatePool_t));
+    if (size == 0 || capacity == 0 || capacity == STATE_POOL_NONE || slab_objects == 0 ||
+        (slab_objects & (slab_objects - 1)) != 0) {
+        return -1;
+    }
+    p->size = size;
+    p->stride = (size + STATE_POOL_ALIGN - 1) & ~(size_t)(STATE_POOL_ALIGN - 1);
+    p->slab_shift = (uint32_t)__builtin_ctz(slab_objects);
+    p->capacity = capacity;
+    uint32_t slabs = (uint32_t)(((uint64_t)capacity + slab_objects - 1) >> p->slab_shift);
+    p->slab = (uint8_t **)calloc(slabs, sizeof(uint8_t *));
+    p->free = (StatePool_Handle_t *)malloc(capacity * sizeof(StatePool_Handle_t));
+    if (p->slab == NULL || p->free == NULL) {
+        StatePool_Free(p);
+        return -1;
+    }
+    return 0;
+}
+
+void StatePool_Free(StatePool_t *p) {
+    if (p->slab != NULL) {
+        uint32_t slabs = (uint32_t)(((uint64_t)p->capacity + slab_objects(p) - 1) >> p->slab_shift);
+        for (uint32_t s = 0; s < slabs; s++) {
+            free(p->slab[s]);
+        }
+    }
+    free(p->slab);
+    free(p->free);
+    memset(p, 0, sizeof(StatePool_t));
+}
+
+StatePool_Handle_t StatePool_Alloc(StatePool_t *p) {
+    StatePool_Handle_t h;
+    if (p->free_count > 0) {
+        h = p->free[p->free_count - 1];
+        if (slab_ready(p, h) != 0) {
+            return STATE_POOL_NONE;
+        }
+        p->free_count--;
+    } else {
+        if (p->next == p->capacity || slab_ready(p, p->next) != 0) {
+            return STATE_POOL_NONE;
+        }
+        h = p->next++;
+    }
+    p->used++;
+    return h;
+}
+
+StatePool_Handle_t StatePool_AllocRun(StatePool_t *p, uint32_t count) {
+    if (count == 0 || count > slab_objects(p)) {
+        return STATE_POOL_NONE;
+    }
+    // From the start of the next slab if the current one is too short
+    uint32_t first = p->next;
+    uint32_t left = slab_objects(p) - (first & (slab_objects(p) - 1));
+    if (left < count) {
+        first += left;
+    }
+    if (first > p->capacity || p->capacity - first < count || slab_ready(p, first) != 0) {
+        return STATE_POOL_NONE;
+    }
+    for (uint32_t h = p->next; h < first; h++) {
+        p->free[p->free_count++] = h;
+    }
+    p->next = first + count;
+    p->used += count;
+    return first;
+}
+
+void StatePool_Release(StatePool_t *p, StatePool_Handle_t h) {
+    p->free[p->free_count++] = h;
+    p->used--;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file work_pool.c
+ * @brief Work-stealing thread pool for the host batch tools
+ */
+
+#include "work_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEQUE_INITIAL_CAPACITY  64
+
+typedef struct {
+    WorkPool_t *pool;
+    uint32_t index;
+} Worker_Arg_t;
+
+static int deque_push(WorkPool_Deque_t *d, WorkPool_Fn_t fn, void *arg) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count == d->capacity) {
+        uint32_t capacity = d->capacity ? d->capacity * 2 : DEQUE_INITIAL_CAPACITY;
+        WorkPool_Task_t *tasks = (WorkPool_Task_t *)malloc(capacity * sizeof(WorkPool_Task_t));
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&d->lock);
+            return -1;
+        }
+        for (uint32_t i = 0; i < d->count; i++) {
+            tasks[i] = d->tasks[(d->top + i) % d->capacity];
+        }
+        free(d->tasks);
+        d->tasks = tasks;
+        d->capacity = capacity;
+        d->top = 0;
+    }
+    d->tasks[(d->top + d->count) % d->capacity] = (WorkPool_Task_t){ fn, arg };
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+// Owner end: newest task
+static int deque_pop_bottom(WorkPool_Deque_t *d, WorkPool_Task_t *task) {
+    int got = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        d->count--;
+        *task = d->tasks[(d->top + d->count) % d->capacity];
+        got = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return got;
+}
+
+// Thief end: oldest task
+static int deque_pop_top(WorkPool_Deque_t *d, WorkPool_Task_t *task) {
+    int got = 0;
+    if (pthread_mutex_trylock(&d->lock) != 0) {
+        return 0;                   // busy: try another victim
+    }
+    if (d->count > 0) {
+        *task = d->tasks[d->top];
+        d->top = (d->top + 1) % d->capacity;
+        d->count--;
+        got = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return got;
+}
+
+// Counted before the push so that queued never drops below the deque contents
+static int queue_task(WorkPool_t *pool, uint32_t worker, WorkPool_Fn_t fn, void *arg) {
+    atomic_fetch_add(&pool->pending, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    if (deque_push(&pool->deques[worker], fn, arg) != 0) {
+        atomic_fetch_sub(&pool->queued, 1);
+        atomic_fetch_sub(&pool->pending, 1);
+        return -1;
+    }
+    pthread_mutex_lock(&pool->idle_lock);
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+    return 0;
+}
+
+static int find_task(WorkPool_t *pool, uint32_t self, WorkPool_Task_t *task) {
+    if (deque_pop_bottom(&pool->deques[self], task)) {
+        return 1;
+    }
+    for (uint32_t k = 1; k < pool->workers; k++) {
+        uint32_t victim = (self + k) % pool->workers;
+        if (deque_pop_top(&pool->deques[victim], task)) {
+            pool->deques[self].stolen++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    Worker_Arg_t *w = (Worker_Arg_t *)arg;
+    WorkPool_t *pool = w->pool;
+    uint32_t self = w->index;
+    free(w);
+
+    for (;;) {
+        WorkPool_Task_t task;
+        if (find_task(pool, self, &task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            task.fn(task.arg, self);
+            pool->deques[self].executed++;
+            if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+                pthread_mutex_lock(&pool->idle_lock);
+                pthread_cond_broadcast(&pool->done_cond);
+                pthread_mutex_unlock(&pool->idle_lock);
+            }
+            continue;
+        }
+        // Nothing found: sleep until something is queued (a trylock miss retries at once)
+        pthread_mutex_lock(&pool->idle_lock);
+        while (!pool->stop && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->work_cond, &pool->idle_lock);
+        }
+        int stop = pool->stop;
+        pthread_mutex_unlock(&pool->idle_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+uint32_t WorkPool_DefaultWorkers(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > WORK_POOL_MAX_WORKERS) n = WORK_POOL_MAX_WORKERS;
+    return (uint32_t)n;
+}
+
+/**
+ * Start workers threads (0: one per online CPU).
+ * @return 0, -1 on failure
+ */
+int WorkPool_Init(WorkPool_t *pool, uint32_t workers) {
+    memset(pool, 0, sizeof(WorkPool_t));
+    if (workers == 0) {
+        workers = WorkPool_DefaultWorkers();
+    }
+    if (workers > WORK_POOL_MAX_WORKERS) {
+        workers = WORK_POOL_MAX_WORKERS;
+    }
+    pool->deques = (WorkPool_Deque_t *)calloc(workers, sizeof(WorkPool_Deque_t));
+    pool->threads = (pthread_t *)calloc(workers, sizeof(pthread_t));
+    if (pool->deques == NULL || pool->threads == NULL) {
+        free(pool->deques);
+        free(pool->threads);
+        return -1;
+    }
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->next_submit, 0);
+    for (uint32_t i = 0; i < workers; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    }
+    pool->workers = workers;
+    for (uint32_t i = 0; i < workers; i++) {
+        Worker_Arg_t *w = (Worker_Arg_t *)malloc(sizeof(Worker_Arg_t));
+        if (w != NULL) {
+            w->pool = pool;
+            w->index = i;
+        }
+        if (w == NULL || pthread_create(&pool->threads[i], NULL, worker_main, w) != 0) {
+            free(w);
+            WorkPool_Destroy(pool);
+            return -1;
+        }
+        pool->started++;
+    }
+    return 0;
+}
+
+/**
+ * Queue a task from outside the pool (round-robin over the workers).
+ */
+int WorkPool_Submit(WorkPool_t *pool, WorkPool_Fn_t fn, void *arg) {
+    uint32_t worker = atomic_fetch_add(&pool->next_submit, 1) % pool->workers;
+    return queue_task(pool, worker, fn, arg);
+}
+
+/**
+ * Queue a task from inside a task running on `worker`: it goes to the
+ * bottom of that worker's deque and runs next unless stolen first.
+ */
+int WorkPool_Spawn(WorkPool_t *pool, uint32_t worker, WorkPool_Fn_t fn, void *arg) {
+    return queue_task(pool, worker, fn, arg);
+}
+
+void WorkPool_Wait(WorkPool_t *pool) {
+    pthread_mutex_lock(&pool->idle_lock);
+    while (atomic_load(&pool->pending) != 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->idle_lock);
+    }
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+void WorkPool_Destroy(WorkPool_t *pool) {
+    pthread_mutex_lock(&pool->idle_lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+    for (uint32_t i = 0; i < pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (uint32_t i = 0; i < pool->workers; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->idle_lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->deques);
+    free(pool->threads);
+    memset(pool, 0, sizeof(WorkPool_t));
+}
@@ -6,7 +6,7 @@
 #define DELAY_H
 
 
-#include "main.h" // 包含 main.h 以获取 htim2 的定义
+#include "platform.h"
 
 void delay_us(uint16_t us);
 
@@ -5,7 +5,7 @@
 #ifndef MAX30102_H
 #define MAX30102_H
 
-#include "main.h"
+#include <stdint.h>
 #include "soft_i2c.h"
 
 // MAX30102 I2C 7位地址
@@ -28,12 +28,16 @@
 #define REG_LED2_PA         0x0D // IR
 #define REG_PART_ID         0xFF
 
+#define MAX30102_FIFO_DEPTH 32   // FIFO可容纳的样本数
+
 // 函数声明
 uint8_t MAX30102_Init(void);
 uint8_t MAX30102_Reset(void);
 uint8_t MAX30102_ReadPartID(void);
 void MAX30102_ReadFifo(uint32_t *pun_red_led, uint32_t *pun_ir_led);
 void MAX30102_ReadInterruptStatus(uint8_t *status1, uint8_t *status2);
+uint8_t MAX30102_GetFifoCount(uint8_t *lost);
+uint8_t MAX30102_ReadFifoBurst(uint32_t *red, uint32_t *ir, uint8_t count);
 
 
 
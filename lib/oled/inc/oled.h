@@ -1,14 +1,13 @@
 #ifndef __OLED_H__
 #define __OLED_H__
 
-#include "../../../Core/Inc/main.h"
-#include "../../../Core/Inc/i2c.h"
+#include "platform.h"
 #include "string.h"
 #include "font.h"
 
 #define OLED_CMD  0	//写命令
 #define OLED_DATA 1	//写数据
-#define OLED_ADDRESS 0x7A //OLED器件地址
+#define OLED_ADDRESS 0x7A //OLED器件地址（8位写地址，Platform_I2C_Write 使用7位地址 0x3D）
 
 typedef enum {
 	OLED_TRANSMIT_CMD = 0,
@@ -75,22 +74,28 @@ void OLED_DrawRectangleFilled(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, OL
 void OLED_DrawRectangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, OLED_ColorMode mode);
 
 // 空心圆辅助函数
-void _OLED_DrawCircleSection(uint8_t x, uint8_t y, uint8_t x0, uint8_t y0, uint8_t option, OLED_ColorMode mode);
+void _OLED_DrawCircleSection(uint8_t x, uint8_t y, uint8_t x0, uint8_t y0, OLED_DrawCircleOption option, OLED_ColorMode mode);
 
 // 实心圆辅助函数
 void _OLED_DrawCircleSectionFilled(uint8_t x, uint8_t y, uint8_t x0, uint8_t y0, OLED_ColorMode mode);
 
 // 画一个空心圆形
-void OLED_DrawCircle(uint8_t x0, uint8_t y0, uint8_t rad, uint8_t option, OLED_ColorMode mode);
+void OLED_DrawCircle(uint8_t x0, uint8_t y0, uint8_t rad, OLED_DrawCircleOption option, OLED_ColorMode mode);
 
 // 画一个实心圆形
 void OLED_DrawCircleFilled(uint8_t x0, uint8_t y0, uint8_t rad, OLED_ColorMode mode);
 
 // 显示ASCII字符
-void OLED_PrintChar(uint8_t x, uint8_t y, char _char, uint8_t size1, uint8_t mode);
+void OLED_PrintChar(uint8_t x, uint8_t y, char _char, uint8_t size1, OLED_ColorMode mode);
 
 // 显示字符串
-void OLED_PrintString(uint8_t x, uint8_t y, char *_string, uint8_t size1, uint8_t mode);
+void OLED_PrintString(uint8_t x, uint8_t y, char *_string, uint8_t size1, OLED_ColorMode mode);
+
+// 显示整数（右对齐到 width 个字符宽度）
+void OLED_PrintNumber(uint8_t x, uint8_t y, int32_t num, uint8_t width, uint8_t font, OLED_ColorMode mode);
+
+// 显示定点小数（保留 decimals 位小数，右对齐到 width 个字符宽度）
+void OLED_PrintFixed(uint8_t x, uint8_t y, float value, uint8_t decimals, uint8_t width, uint8_t font, OLED_ColorMode mode);
 
 // 显示汉字
 OLED_Ret OLED_PrintChineseChar(uint8_t x, uint8_t y, char c[2], uint8_t font, OLED_ColorMode mode);
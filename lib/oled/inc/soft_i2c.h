@@ -5,17 +5,13 @@
 #ifndef SOFT_I2C_H
 #define SOFT_I2C_H
 
-#include "../../../Core/Inc/main.h"
+#include "platform.h"
 
 /*==================================================================================
  * 1. 用户配置区 (User Configuration)
  *================================================================================*/
 
-// 定义SCL和SDA引脚
-#define I2C_SCL_PORT      GPIOA
-#define I2C_SCL_PIN       GPIO_PIN_10
-#define I2C_SDA_PORT      GPIOA
-#define I2C_SDA_PIN       GPIO_PIN_11
+// SCL和SDA引脚: PLATFORM_PIN_I2C_SCL / PLATFORM_PIN_I2C_SDA（STM32 上为 PA10 / PA11）
 
 // I2C通信速率控制 (单位: 微秒 us)
 // 通过调整半周期延时来控制SCL频率。
@@ -3,6 +3,7 @@
 //
 
 #include "../inc/max30102.h"
+#include "trace.h"
 
 
 
@@ -21,7 +22,7 @@ uint8_t MAX30102_Reset(void) {
     uint8_t reg_val;
     uint32_t timeout = 100; // 设置超时
     do {
-        HAL_Delay(1); // 延时1ms
+        Platform_DelayMs(1); // 延时1ms
         if (Soft_I2C_Read_Reg(MAX30102_I2C_ADDR, REG_MODE_CONFIG, &reg_val) != 0) {
             return 1; // I2C读取失败
         }
@@ -77,16 +78,58 @@ uint8_t MAX30102_Init(void) {
     Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, REG_MODE_CONFIG, 0x03);
 
     // 4. SpO2 ADC 配置
-    // SpO2 ADC Range=16384nA, Sample Rate=100Hz, Pulse Width=411us (18-bit)
-    Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, REG_SPO2_CONFIG, 0x27); // SPO2_ADC_RGE=0, SPO2_SR=1, LED_PW=3
+    // SpO2 ADC Range=4096nA, Sample Rate=100Hz, Pulse Width=411us (18-bit)
+    Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, REG_SPO2_CONFIG, 0x27); // SPO2_ADC_RGE=1, SPO2_SR=1, LED_PW=3
 
     // 5. LED电流配置 (0x24 约等于 7.6mA, 这是一个比较安全的起始值)
     Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, REG_LED1_PA, 0x24); // Red LED
     Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, REG_LED2_PA, 0x24); // IR LED
+    TRACE_EVENT(TRACE_EV_AGC_STEP, (0x24 << 8) | 0x24);
 
     return 0;
 }
 
+/**
+ * @brief 查询FIFO中未读的样本数
+ * @param lost 输出: FIFO满后丢失的样本数（溢出计数器，最大31，读出样本后芯片自动清零）
+ * @return 未读样本数 (0 ~ MAX30102_FIFO_DEPTH)，读取失败时返回0
+ */
+uint8_t MAX30102_GetFifoCount(uint8_t *lost) {
+    // WR_PTR / OVF_COUNTER / RD_PTR 地址连续，一次读出
+    uint8_t ptr[3];
+    *lost = 0;
+    if (Soft_I2C_Read_Regs(MAX30102_I2C_ADDR, REG_FIFO_WR_PTR, ptr, 3) != 0) {
+        return 0;
+    }
+    *lost = ptr[1] & 0x1F;
+    uint8_t count = (uint8_t)((ptr[0] - ptr[2]) & (MAX30102_FIFO_DEPTH - 1));
+    if (count == 0 && *lost != 0) {
+        count = MAX30102_FIFO_DEPTH;    // 写指针追上读指针: FIFO已满
+    }
+    return count;
+}
+
+/**
+ * @brief 连续读出 count 个样本（count 由 MAX30102_GetFifoCount 得到）
+ * @param red 红光数据数组
+ * @param ir 红外数据数组
+ * @param count 要读取的样本数
+ * @return 实际读出的样本数
+ */
+uint8_t MAX30102_ReadFifoBurst(uint32_t *red, uint32_t *ir, uint8_t count) {
+    // FIFO_DATA 地址不自增，每次读取弹出一个样本（红3 + 红外3 字节）；
+    // 逐个样本读取，软件I2C每次传输的关中断时间较短
+    uint8_t buffer[6];
+    for (uint8_t i = 0; i < count; i++) {
+        if (Soft_I2C_Read_Regs(MAX30102_I2C_ADDR, REG_FIFO_DATA, buffer, 6) != 0) {
+            return i;
+        }
+        red[i] = (((uint32_t)buffer[0] << 16) | ((uint32_t)buffer[1] << 8) | buffer[2]) & 0x03FFFF;
+        ir[i]  = (((uint32_t)buffer[3] << 16) | ((uint32_t)buffer[4] << 8) | buffer[5]) & 0x03FFFF;
+    }
+    return count;
+}
+
 /**
  * @brief 从FIFO中读取一组Red和IR数据 (3+3=6字节)
  * @param pun_red_led: 存储Red ADC值的指针
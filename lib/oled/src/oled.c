@@ -1,4 +1,6 @@
 #include "../inc/oled.h"
+#include "fmt.h"
+#include "trace.h"
 
 uint8_t OLED_GRAM[129][8];
 
@@ -12,7 +14,7 @@ void OLED_TransmitByte(uint8_t data, OLED_TransmitMode mode) {
 	else
 		send_buf[0] = 0x00;
 	send_buf[1] = data;
-	HAL_I2C_Master_Transmit(&hi2c1, OLED_ADDRESS, send_buf, 2, 1);
+	Platform_I2C_Write(OLED_ADDRESS >> 1, send_buf, 2, 1);
 }
 
 /**
@@ -121,7 +123,8 @@ void OLED_Refresh(void) {
 		for (n = 0; n < 128; n++) {
 			send_buf[n + 1] = OLED_GRAM[n][i];
 		}
-		HAL_I2C_Master_Transmit(&hi2c1, OLED_ADDRESS, send_buf, 129, 20);
+		Platform_I2C_Write(OLED_ADDRESS >> 1, send_buf, 129, 20);
+		TRACE_EVENT(TRACE_EV_OLED_PAGE, i);
 	}
 }
 
@@ -455,6 +458,43 @@ void OLED_PrintString(uint8_t x, uint8_t y, char *s, uint8_t font, OLED_ColorMod
 	}
 }
 
+/**
+ * @brief: 在指定位置显示整数
+ *
+ * @param x X坐标 [0,127]
+ * @param y Y坐标 [0,63]
+ * @param num 要显示的整数
+ * @param width 最小字符宽度（右对齐，0表示不填充）
+ * @param font 字体 8/12/16/24
+ * @param mode 颜色模式
+ *
+ * */
+void OLED_PrintNumber(uint8_t x, uint8_t y, int32_t num, uint8_t width, uint8_t font, OLED_ColorMode mode) {
+	char buf[16];
+	if (width > 12) width = 12;
+	fmt_i32(buf, num, width, ' ');
+	OLED_PrintString(x, y, buf, font, mode);
+}
+
+/**
+ * @brief: 在指定位置显示定点小数（不依赖 printf 浮点支持）
+ *
+ * @param x X坐标 [0,127]
+ * @param y Y坐标 [0,63]
+ * @param value 要显示的数值
+ * @param decimals 小数位数 [0,4]
+ * @param width 最小字符宽度（右对齐，含符号和小数点，0表示不填充）
+ * @param font 字体 8/12/16/24
+ * @param mode 颜色模式
+ *
+ * */
+void OLED_PrintFixed(uint8_t x, uint8_t y, float value, uint8_t decimals, uint8_t width, uint8_t font, OLED_ColorMode mode) {
+	char buf[24];
+	if (width > 16) width = 16;
+	fmt_fixed(buf, value, decimals, width, ' ');
+	OLED_PrintString(x, y, buf, font, mode);
+}
+
 /**
  * @brief: 在指定位置显示中文字符
  * 
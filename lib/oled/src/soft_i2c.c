@@ -11,13 +11,13 @@
  *================================================================================*/
 
 // 宏定义简化GPIO操作
-#define I2C_SCL_SET()     HAL_GPIO_WritePin(I2C_SCL_PORT, I2C_SCL_PIN, GPIO_PIN_SET)
-#define I2C_SCL_CLR()     HAL_GPIO_WritePin(I2C_SCL_PORT, I2C_SCL_PIN, GPIO_PIN_RESET)
+#define I2C_SCL_SET()     Platform_GPIO_Write(PLATFORM_PIN_I2C_SCL, 1)
+#define I2C_SCL_CLR()     Platform_GPIO_Write(PLATFORM_PIN_I2C_SCL, 0)
 
-#define I2C_SDA_SET()     HAL_GPIO_WritePin(I2C_SDA_PORT, I2C_SDA_PIN, GPIO_PIN_SET)
-#define I2C_SDA_CLR()     HAL_GPIO_WritePin(I2C_SDA_PORT, I2C_SDA_PIN, GPIO_PIN_RESET)
+#define I2C_SDA_SET()     Platform_GPIO_Write(PLATFORM_PIN_I2C_SDA, 1)
+#define I2C_SDA_CLR()     Platform_GPIO_Write(PLATFORM_PIN_I2C_SDA, 0)
 
-#define I2C_SDA_READ()    HAL_GPIO_ReadPin(I2C_SDA_PORT, I2C_SDA_PIN)
+#define I2C_SDA_READ()    Platform_GPIO_Read(PLATFORM_PIN_I2C_SDA)
 
 // 更严谨的做法：SDA输入/输出模式切换
 // private static inline void SDA_Mode_Out(void) {
@@ -86,7 +86,7 @@ static uint8_t i2c_read_byte(void) {
         byte <<= 1;
         I2C_SCL_SET();
         delay_us(I2C_HALF_PERIOD_DELAY);
-        if (I2C_SDA_READ() == GPIO_PIN_SET) {
+        if (I2C_SDA_READ()) {
             byte |= 0x01;
         }
         I2C_SCL_CLR();
@@ -148,7 +148,7 @@ void Soft_I2C_Init(void) {
 uint8_t Soft_I2C_Write_Reg(uint8_t slave_addr, uint8_t reg_addr, uint8_t data) {
     uint8_t status = 0;
 
-    __disable_irq(); // 关键操作期间屏蔽中断，保证时序完整
+    Platform_EnterCritical(); // 关键操作期间屏蔽中断，保证时序完整
 
     i2c_start();
 
@@ -175,14 +175,14 @@ uint8_t Soft_I2C_Write_Reg(uint8_t slave_addr, uint8_t reg_addr, uint8_t data) {
 
 write_fail:
     i2c_stop();
-    __enable_irq(); // 恢复中断
+    Platform_ExitCritical(); // 恢复中断
     return status;
 }
 
 uint8_t Soft_I2C_Read_Reg(uint8_t slave_addr, uint8_t reg_addr, uint8_t* p_data) {
     uint8_t status = 0;
 
-    __disable_irq();
+    Platform_EnterCritical();
 
     i2c_start();
 
@@ -214,7 +214,7 @@ uint8_t Soft_I2C_Read_Reg(uint8_t slave_addr, uint8_t reg_addr, uint8_t* p_data)
 
 read_fail:
     i2c_stop();
-    __enable_irq();
+    Platform_ExitCritical();
     return status;
 }
 
@@ -225,7 +225,7 @@ uint8_t Soft_I2C_Read_Regs(uint8_t slave_addr, uint8_t reg_addr, uint8_t* p_data
 
     if (count == 0) return 0;
 
-    __disable_irq();
+    Platform_EnterCritical();
 
     i2c_start();
 
@@ -255,7 +255,7 @@ uint8_t Soft_I2C_Read_Regs(uint8_t slave_addr, uint8_t reg_addr, uint8_t* p_data
 
 read_multi_fail:
     i2c_stop();
-    __enable_irq();
+    Platform_ExitCritical();
     return status;
 }
 
@@ -272,7 +272,7 @@ uint8_t Soft_I2C_Write_Byte(uint8_t slave_addr, uint8_t data) {
     // 确保slave_addr是7位，并将读写位设置为写(0)
     uint8_t device_write_addr = (slave_addr << 1) | 0x00;
 
-    __disable_irq(); // 屏蔽中断，保证时序的完整性
+    Platform_EnterCritical(); // 屏蔽中断，保证时序的完整性
 
     i2c_start();
 
@@ -291,7 +291,7 @@ uint8_t Soft_I2C_Write_Byte(uint8_t slave_addr, uint8_t data) {
 
     write_byte_fail:
         i2c_stop();
-    __enable_irq(); // 恢复中断
+    Platform_ExitCritical(); // 恢复中断
     return status;
 }
 
@@ -307,7 +307,7 @@ uint8_t Soft_I2C_Read_Byte(uint8_t slave_addr, uint8_t* p_data) {
     // 确保slave_addr是7位，并将读写位设置为读(1)
     uint8_t device_read_addr = (slave_addr << 1) | 0x01;
 
-    __disable_irq();
+    Platform_EnterCritical();
 
     i2c_start();
 
@@ -326,6 +326,6 @@ uint8_t Soft_I2C_Read_Byte(uint8_t slave_addr, uint8_t* p_data) {
 
     read_byte_fail:
         i2c_stop();
-    __enable_irq();
+    Platform_ExitCritical();
     return status;
 }
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Per-module static RAM / flash usage from a GNU ld map file.
+
+Run after every firmware build (POST_BUILD step in CMakeLists.txt) so memory
+growth is visible per object file, not just as the total printed by
+arm-none-eabi-size. Sections are attributed by address using the map's
+"Memory Configuration" table: a section counts as RAM when it lives in RAM,
+and as flash when it lives in or is loaded from flash (.data counts as both).
+Archive members are grouped per library (libc_nano.a, libgcc.a, ...).
+
+Usage: map_report.py [--csv] [--top N] [--ram-budget BYTES] firmware.map
+
+With --ram-budget the script exits with 1 when static RAM (.data + .bss,
+excluding the heap/stack reservation) exceeds BYTES.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# "Memory Configuration" table: name origin length [attributes]
+REGION_RE = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+# Output section: ".bss  0x20000010  0x3650" (the numbers may be on the next line)
+OUTPUT_RE = re.compile(r'^(\.\S+|/DISCARD/)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$')
+# Input section: " .text.HR_Calculate  0x08001234  0x4a8 path/ppg_algorithm.c.obj"
+INPUT_RE = re.compile(r'^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+# Address/size/file continuation of a section whose name was too long for one line
+CONT_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?(?:\s+(\S.*))?$')
+ARCHIVE_RE = re.compile(r'^(.*\.a)\((.*)\)$')
+
+STATIC_SECTION = '.bss.ram_static'
+RESERVE_SECTION = '._user_heap_stack'
+
+
+def module_name(path):
+    m = ARCHIVE_RE.match(path)
+    if m:
+        return os.path.basename(m.group(1))
+    name = os.path.basename(path)
+    for ext in ('.obj', '.o'):
+        if name.endswith(ext):
+            return name[:-len(ext)]
+    return name
+
+
+class MapReport:
+    def __init__(self):
+        self.regions = {}           # name -> (origin, length)
+        self.region_used = {}       # name -> bytes (output sections)
+        self.modules = {}           # name -> {'flash': n, 'ram': n, 'static': n}
+        self.static_total = 0
+        self.reserve = 0
+
+    def region_of(self, addr):
+        for name, (origin, length) in self.regions.items():
+            if origin <= addr < origin + length:
+                return name
+        return None
+
+    def add_input(self, section, out, addr, size, path):
+        if size == 0 or out is None or out[0] == '/DISCARD/':
+            return
+        vma_region = self.region_of(addr)
+        lma_region = self.region_of(out[2]) if out[2] is not None else vma_region
+        if vma_region is None:
+            return                  # debug info and other non-allocated sections
+        entry = self.modules.setdefault(module_name(path), {'flash': 0, 'ram': 0, 'static': 0})
+        if vma_region == 'RAM':
+            entry['ram'] += size
+            if section == STATIC_SECTION:
+                entry['static'] += size
+                self.static_total += size
+        if 'FLASH' in (vma_region, lma_region):
+            entry['flash'] += size
+
+    def add_output(self, name, addr, size, load):
+        region = self.region_of(addr)
+        if region is not None:
+            self.region_used[region] = self.region_used.get(region, 0) + size
+        if load is not None and region != self.region_of(load):
+            load_region = self.region_of(load)
+            if load_region is not None:
+                self.region_used[load_region] = self.region_used.get(load_region, 0) + size
+        if name == RESERVE_SECTION:
+            self.reserve = size
+
+    def parse(self, lines):
+        state = 'head'
+        out = None                  # (name, vma, lma) of the current output section
+        pending = None              # input section name waiting for its address line
+        pending_out = None          # output section name waiting for its address line
+        for line in lines:
+            line = line.rstrip('\n')
+            if line.startswith('Memory Configuration'):
+                state = 'regions'
+                continue
+            if line.startswith('Linker script and memory map'):
+                state = 'map'
+                continue
+            if state == 'regions':
+                m = REGION_RE.match(line)
+                if m and m.group(1) != 'Name' and m.group(1) != '*default*':
+                    self.regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+                continue
+            if state != 'map':
+                continue
+
+            if pending_out is not None:
+                m = CONT_RE.match(line)
+                pending_name, pending_out = pending_out, None
+                if m:
+                    load = int(m.group(3), 16) if m.group(3) else None
+                    out = (pending_name, int(m.group(1), 16), load)
+                    self.add_output(pending_name, out[1], int(m.group(2), 16), load)
+                    continue
+            if pending is not None:
+                m = CONT_RE.match(line)
+                section, pending = pending, None
+                if m and m.group(4):
+                    self.add_input(section, out, int(m.group(1), 16), int(m.group(2), 16), m.group(4))
+                    continue
+
+            m = OUTPUT_RE.match(line)
+            if m:
+                if m.group(2) is None:
+                    pending_out = m.group(1)
+                    out = (m.group(1), 0, None)
+                else:
+                    load = int(m.group(4), 16) if m.group(4) else None
+                    out = (m.group(1), int(m.group(2), 16), load)
+                    self.add_output(m.group(1), out[1], int(m.group(3), 16), load)
+                continue
+
+            m = INPUT_RE.match(line)
+            # Skip input patterns ("*(.text*)"), padding ("*fill*") and assignments
+            if m and not m.group(1).startswith(('*', '0x')):
+                if m.group(2) is None:
+                    pending = m.group(1)
+                else:
+                    self.add_input(m.group(1), out, int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+
+    def static_ram(self):
+        return sum(entry['ram'] for entry in self.modules.values())
+
+
+def print_table(report, top):
+    for name in sorted(report.regions):
+        origin, length = report.regions[name]
+        used = report.region_used.get(name, 0)
+        if length == 0:
+            continue
+        print('%-10s %7d / %7d bytes (%5.1f%%)' % (name, used, length, 100.0 * used / length))
+    print('Static RAM: %d bytes (.data + .bss), of which RAM_STATIC %d; heap+stack reserve %d'
+          % (report.static_ram(), report.static_total, report.reserve))
+    print()
+    print('%-28s %8s %8s %10s' % ('module', 'flash', 'RAM', 'RAM_STATIC'))
+    rows = sorted(report.modules.items(), key=lambda kv: (-kv[1]['ram'], -kv[1]['flash'], kv[0]))
+    for name, entry in rows[:top] if top > 0 else rows:
+        print('%-28s %8d %8d %10d' % (name, entry['flash'], entry['ram'], entry['static']))
+
+
+def print_csv(report):
+    print('module,flash,ram,ram_static')
+    for name, entry in sorted(report.modules.items()):
+        print('%s,%d,%d,%d' % (name, entry['flash'], entry['ram'], entry['static']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per-module RAM/flash usage from a GNU ld map file')
+    parser.add_argument('map_file')
+    parser.add_argument('--csv', action='store_true', help='CSV output')
+    parser.add_argument('--top', type=int, default=0, help='only the N largest modules by RAM')
+    parser.add_argument('--ram-budget', type=int, default=0,
+                        help='exit with 1 when static RAM exceeds this many bytes')
+    args = parser.parse_args()
+
+    try:
+        with open(args.map_file) as f:
+            lines = f.readlines()
+    except OSError as e:
+        print(e, file=sys.stderr)
+        return 1
+
+    report = MapReport()
+    report.parse(lines)
+    if not report.regions:
+        print('%s: no memory configuration found, not a GNU ld map file?' % args.map_file, file=sys.stderr)
+        return 1
+
+    if args.csv:
+        print_csv(report)
+    else:
+        print_table(report, args.top)
+
+    if args.ram_budget > 0:
+        used = report.static_ram()
+        if used > args.ram_budget:
+            print('Static RAM %d bytes exceeds the budget of %d bytes' % (used, args.ram_budget), file=sys.stderr)
+            return 1
+        print('Static RAM within budget (%d / %d bytes)' % (used, args.ram_budget))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
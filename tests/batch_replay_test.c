@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "check.h"
+#include "batch_replay.h"
+#include "work_pool.h"
+
+#define RECORDS     4
+#define SECONDS     240.0
+
+// ---- Pool: every submitted and spawned task runs once, idle workers steal ----
+
+typedef struct {
+    WorkPool_t *pool;
+    atomic_uint runs;
+    atomic_uint children;
+} PoolCtx_t;
+
+static PoolCtx_t pool_ctx;
+
+static void busy(void) {
+    volatile double x = 0.0;
+    for (int i = 0; i < 20000; i++) {
+        x += sqrt((double)i);
+    }
+}
+
+static void child_task(void *arg, uint32_t worker) {
+    (void)arg;
+    (void)worker;
+    busy();
+    atomic_fetch_add(&pool_ctx.children, 1);
+}
+
+static void parent_task(void *arg, uint32_t worker) {
+    (void)arg;
+    atomic_fetch_add(&pool_ctx.runs, 1);
+    // All children land on this worker's deque: the others must steal them
+    for (int i = 0; i < 100; i++) {
+        CHECK(WorkPool_Spawn(pool_ctx.pool, worker, child_task, NULL) == 0);
+    }
+}
+
+static void test_pool(void) {
+    printf("=== Work-Stealing Pool Test ===\n");
+    WorkPool_t pool;
+    CHECK(WorkPool_Init(&pool, 4) == 0);
+    assert(pool.workers == 4);
+    pool_ctx.pool = &pool;
+    atomic_init(&pool_ctx.runs, 0);
+    atomic_init(&pool_ctx.children, 0);
+
+    for (int i = 0; i < 3; i++) {
+        CHECK(WorkPool_Submit(&pool, parent_task, NULL) == 0);
+    }
+    WorkPool_Wait(&pool);
+    assert(atomic_load(&pool_ctx.runs) == 3);
+    assert(atomic_load(&pool_ctx.children) == 300);
+
+    // The pool is reusable after Wait
+    CHECK(WorkPool_Submit(&pool, parent_task, NULL) == 0);
+    WorkPool_Wait(&pool);
+    assert(atomic_load(&pool_ctx.children) == 400);
+
+    uint64_t executed = 0, stolen = 0;
+    for (uint32_t w = 0; w < pool.workers; w++) {
+        executed += pool.deques[w].executed;
+        stolen += pool.deques[w].stolen;
+    }
+    printf("  %llu tasks, %llu stolen\n", (unsigned long long)executed, (unsigned long long)stolen);
+    assert(executed == 404);
+    assert(stolen > 0);
+    WorkPool_Destroy(&pool);
+    printf("  PASSED\n\n");
+}
+
+// ---- Engine ----
+
+static int load_patient(void *ctx, uint32_t index, PPGScore_Record_t *rec) {
+    (void)ctx;
+    return PPGScore_SynthesisePatient(rec, 10 + index, SECONDS);
+}
+
+static int load_with_gap(void *ctx, uint32_t index, PPGScore_Record_t *rec) {
+    return (index == 1) ? -1 : load_patient(ctx, index, rec);
+}
+
+static void assert_same_metric(const PPGScore_Metric_t *a, const PPGScore_Metric_t *b) {
+    assert(a->updates == b->updates && a->valid == b->valid && a->n == b->n);
+    assert(a->sum_err == b->sum_err && a->sum_abs == b->sum_abs && a->sum_sq == b->sum_sq);
+    assert(a->first_valid_s == b->first_valid_s);
+}
+
+static void test_handoff(void) {
+    printf("=== State Hand-off Test ===\n");
+    // Reference: every record in one piece
+    static PPGScore_Result_t expected[2][RECORDS];
+    for (uint32_t v = 0; v < 2; v++) {
+        for (uint32_t r = 0; r < RECORDS; r++) {
+            PPGScore_Record_t rec;
+            CHECK(load_patient(NULL, r, &rec) == 0);
+            CHECK(PPGScore_Run(PPGVariant_Get(v), &rec, &expected[v][r]) == 0);
+            PPGScore_FreeRecord(&rec);
+        }
+    }
+
+    // Chunks of 37 s (rounded up to whole updates), on 1 and 3 threads: identical sums
+    const uint32_t threads[2] = { 1, 3 };
+    for (uint32_t v = 0; v < 2; v++) {
+        for (int t = 0; t < 2; t++) {
+            BatchReplay_Config_t cfg = { PPGVariant_Get(v), threads[t], 3700, 0, 0 };
+            BatchReplay_RecordResult_t results[RECORDS];
+            BatchReplay_Stats_t stats;
+            CHECK(BatchReplay_Run(&cfg, load_patient, NULL, RECORDS, results, &stats) == 0);
+            assert(stats.threads == threads[t]);
+            assert(stats.samples == RECORDS * (uint64_t)(SECONDS * 100));
+            assert(stats.processed == stats.samples);
+            assert(fabs(stats.signal_s - RECORDS * SECONDS) < 0.01);
+            // Per record: a loader and 7 chunks of 3750 samples (the last one short)
+            assert(stats.tasks == RECORDS * 8);
+            for (uint32_t r = 0; r < RECORDS; r++) {
+                assert(results[r].status == 0 && results[r].samples == 24000);
+                assert(strcmp(results[r].name, "synth-") > 0);
+                assert_same_metric(&results[r].result.hr, &expected[v][r].hr);
+                assert_same_metric(&results[r].result.spo2, &expected[v][r].spo2);
+                assert(results[r].result.hr.lag_s < 0.0);
+            }
+            printf("  %s, %u thread(s): %.1f M samples/s, x%.0f real time, %llu steals\n",
+                   PPGVariant_Get(v)->name, stats.threads, stats.samples / stats.wall_s / 1e6,
+                   stats.signal_s / stats.wall_s, (unsigned long long)stats.steals);
+        }
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_warmup(void) {
+    printf("=== Warm-up Chunks Test ===\n");
+    // Method 1: the averaged rate settles within the 22.5 s warm-up (Method 2 can lock
+    // onto a period multiple and stay there, so restarting it changes its errors)
+    const PPGVariant_t *variant = PPGVariant_Find("m1");
+    BatchReplay_Config_t exact = { variant, 2, 3000, 0, 0 };
+    BatchReplay_Config_t warm = { variant, 2, 3000, 2100, 0 };
+    BatchReplay_RecordResult_t a[RECORDS], b[RECORDS];
+    BatchReplay_Stats_t sa, sb;
+    CHECK(BatchReplay_Run(&exact, load_patient, NULL, RECORDS, a, &sa) == 0);
+    CHECK(BatchReplay_Run(&warm, load_patient, NULL, RECORDS, b, &sb) == 0);
+    // 2100 rounds up to 2250 samples of warm-up before every chunk but the first
+    assert(sb.processed == sb.samples + RECORDS * 7ull * 2250);
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        PPGScore_Summary_t sx, sw;
+        PPGScore_Summarise(&a[r].result.hr, &sx);
+        PPGScore_Summarise(&b[r].result.hr, &sw);
+        printf("  %s: HR MAE %.2f exact, %.2f warm-up; coverage %.1f / %.1f %%\n",
+               a[r].name, sx.mae, sw.mae, sx.coverage_pct, sw.coverage_pct);
+        assert(b[r].result.hr.updates == a[r].result.hr.updates);
+        assert(b[r].result.hr.first_valid_s == a[r].result.hr.first_valid_s);
+        assert(fabs(sw.mae - sx.mae) < 2.0);
+        assert(fabs(sw.coverage_pct - sx.coverage_pct) < 5.0);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_filtered_warmup(void) {
+    printf("=== Filtered Warm-up Test ===\n");
+    // 12 chunks of 2100 samples a record: a full group of 8 and a group of 4 ending short
+    const PPGVariant_t *variant = PPGVariant_Find("m1");
+    BatchReplay_Config_t plain = { variant, 2, 2000, 2100, 0 };
+    BatchReplay_Config_t filtered = { variant, 2, 2000, 2100, 1 };
+    BatchReplay_RecordResult_t a[RECORDS], b[RECORDS];
+    BatchReplay_Stats_t sa, sb;
+    CHECK(BatchReplay_Run(&plain, load_patient, NULL, RECORDS, a, &sa) == 0);
+    CHECK(BatchReplay_Run(&filtered, load_patient, NULL, RECORDS, b, &sb) == 0);
+    assert(sb.processed == sa.processed);
+    assert(sa.tasks == RECORDS * 13 && sb.tasks == RECORDS * 3);
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        assert(b[r].status == 0 && b[r].samples == a[r].samples);
+        assert_same_metric(&b[r].result.hr, &a[r].result.hr);
+        assert_same_metric(&b[r].result.spo2, &a[r].result.spo2);
+    }
+    printf("  %s: identical to the unbatched warm-up, %llu tasks instead of %llu\n", variant->name,
+           (unsigned long long)sb.tasks, (unsigned long long)sa.tasks);
+
+    // Method 2 has no filtered path and is replayed as without the flag
+    filtered.variant = plain.variant = PPGVariant_Find("m2");
+    CHECK(BatchReplay_Run(&plain, load_patient, NULL, RECORDS, a, &sa) == 0);
+    CHECK(BatchReplay_Run(&filtered, load_patient, NULL, RECORDS, b, &sb) == 0);
+    assert(sb.tasks == sa.tasks);
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        assert_same_metric(&b[r].result.hr, &a[r].result.hr);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_load_failure(void) {
+    printf("=== Load Failure Test ===\n");
+    BatchReplay_Config_t cfg = { PPGVariant_Get(0), 2, 0, 0, 0 };
+    BatchReplay_RecordResult_t results[RECORDS];
+    BatchReplay_Stats_t stats;
+    CHECK(BatchReplay_Run(&cfg, load_with_gap, NULL, RECORDS, results, &stats) == 1);
+    assert(results[1].status == -1 && results[1].samples == 0);
+    assert(results[0].status == 0 && results[2].status == 0 && results[3].status == 0);
+    assert(stats.samples == (RECORDS - 1) * (uint64_t)(SECONDS * 100));
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Batch Replay Test ===\n\n");
+
+    test_pool();
+    test_handoff();
+    test_warmup();
+    test_filtered_warmup();
+    test_load_failure();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+// Compiles ppg_algorithm_v2.c into this translation unit to reach its static helpers
+#include "../../Core/Src/ppg_algorithm_v2.c"
+#include "bench_shims.h"
+
+void bench_dpt_transform_process(DPT_State_t *state, int32_t ac_value) {
+    dpt_transform_process(&state->ir_dpt, ac_value, state->cos_basis, state->sin_basis);
+}
+
+void bench_compute_magnitude_spectrum(DPT_State_t *state) {
+    compute_magnitude_spectrum(&state->ir_dpt);
+}
+
+float bench_median_filter_dpt(float *data, uint8_t size) {
+    return median_filter(data, size);
+}
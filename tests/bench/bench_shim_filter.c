@@ -0,0 +1,7 @@
+// Compiles ppg_filter.c into this translation unit to reach its static helpers
+#include "../../Core/Src/ppg_filter.c"
+#include "bench_shims.h"
+
+float bench_biquad_filter(float input, BiquadState_t *state) {
+    return biquad_filter(input, &butterworth_sos[0], state);
+}
@@ -0,0 +1,7 @@
+// Compiles ppg_algorithm.c into this translation unit to reach its static helpers
+#include "../../Core/Src/ppg_algorithm.c"
+#include "bench_shims.h"
+
+float bench_median_filter_method1(float *data, uint8_t size) {
+    return median_filter(data, size);
+}
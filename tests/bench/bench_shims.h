@@ -0,0 +1,29 @@
+/**
+ * @file bench_shims.h
+ * @brief Entry points into the static DSP helpers for ppg_bench
+ * @details biquad_filter, median_filter, dpt_transform_process and
+ *          compute_magnitude_spectrum are file-static in Core/Src. Each
+ *          bench_shim_*.c file compiles one of those sources verbatim (by
+ *          #include) and exports thin wrappers, so the benchmark times exactly
+ *          the code the firmware runs. The bench target links the shims
+ *          instead of the original .c files.
+ */
+#ifndef BENCH_SHIMS_H
+#define BENCH_SHIMS_H
+
+#include <stdint.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm_v2.h"
+
+// ppg_filter.c: first Butterworth section
+float bench_biquad_filter(float input, BiquadState_t *state);
+
+// ppg_algorithm.c: HR median (size <= HR_MEDIAN_FILTER_SIZE)
+float bench_median_filter_method1(float *data, uint8_t size);
+
+// ppg_algorithm_v2.c: one IR-channel DPT update, spectrum and median (size <= DPT_MEDIAN_SIZE)
+void bench_dpt_transform_process(DPT_State_t *state, int32_t ac_value);
+void bench_compute_magnitude_spectrum(DPT_State_t *state);
+float bench_median_filter_dpt(float *data, uint8_t size);
+
+#endif // BENCH_SHIMS_H
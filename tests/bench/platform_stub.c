@@ -0,0 +1,11 @@
+// Minimal platform stand-in so lib/oled links on the host. The I2C transfer is a
+// no-op: OLED benchmarks measure frame-buffer work, not bus time.
+#include "platform.h"
+
+uint8_t Platform_I2C_Write(uint8_t slave_addr, const uint8_t *data, uint16_t len, uint32_t timeout_ms) {
+    (void)slave_addr;
+    (void)data;
+    (void)len;
+    (void)timeout_ms;
+    return 0;
+}
@@ -0,0 +1,651 @@
+/**
+ * @file ppg_bench.c
+ * @brief Host micro-benchmarks for every DSP stage and the OLED primitives
+ * @details Each benchmark runs a fixed synthetic workload (deterministic PPG
+ *          signal, no randomness between runs) in batches of `ops` calls.
+ *          After a warmup, every batch is timed separately and converted to
+ *          ns/op; the report gives min, p50, p90, p99 and mean over all
+ *          batches.
+ *
+ *          -o writes the results as JSON (one benchmark per line). -b compares
+ *          this run with such a file and exits with status 1 if any benchmark
+ *          is slower than the baseline by more than the threshold (-t,
+ *          percent). The compared statistic is p50 by default; -m min is more
+ *          robust on a busy machine. Typical use:
+ *
+ *              ppg_bench -o base.json            # before a change
+ *              ppg_bench -b base.json -t 5       # after it
+ *
+ *          The dpt_batch_* entries time the batched engine (dpt_batch.h) on
+ *          BATCH_STREAMS streams per step, one op per stream-sample (or
+ *          stream-spectrum), once per kernel this CPU supports; the summary
+ *          after the table gives their speed-up over the scalar functions.
+ *          The filter_batch_* entries do the same for the batched front end
+ *          (filter_batch.h): blocks of FILTER_BATCH_FRAMES {red, IR} frames
+ *          of BATCH_STREAMS streams, one op per channel-sample, against
+ *          PPG_Filter_Process.
+ *
+ *          Host timings say nothing absolute about the Cortex-M3, but relative
+ *          changes in the float and memory work carry over well enough to
+ *          accept or reject an optimisation; confirm on target with the
+ *          profiler (ENABLE_PROFILER).
+ *
+ * Usage: ppg_bench [-q] [-n reps] [-w warmup] [-f filter] [-o out.json]
+ *                  [-b baseline.json] [-t threshold_pct] [-m min|p50|p90|p99|mean]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include "../../lib/oled/inc/oled.h"
+#include "bench_shims.h"
+#include "dpt_batch.h"
+#include "filter_batch.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_JSON_VERSION  1
+#define MAX_BENCHES         32
+#define MAX_REPS            10000
+#define DEFAULT_REPS        200
+#define DEFAULT_WARMUP      20
+#define DEFAULT_THRESHOLD   10.0
+
+// Workload: 40 s at 100 Hz, 75 bpm (80-sample period) so the loop wraps seamlessly
+#define WORKLOAD_SIZE       4000
+#define WORKLOAD_RATE       100.0
+#define WORKLOAD_HR_HZ      1.25
+#define WORKLOAD_RESP_HZ    0.25
+
+#define BATCH_STREAMS       64      // lanes of the batched DPT benchmarks, streams of the filter ones
+#define FILTER_BATCH_FRAMES 8       // frames per stream and FilterBatch_ProcessFrames call
+
+typedef struct {
+    const char *name;
+    uint32_t ops;                   // calls per timed batch
+    void (*setup)(void);
+    void (*run)(uint32_t ops);
+    int (*available)(void);         // NULL: always runs
+    const char *reference;          // scalar benchmark for the speed-up summary
+} Bench_t;
+
+typedef struct {
+    double min, p50, p90, p99, mean;    // ns/op
+} BenchResult_t;
+
+static const char *const metric_names[] = { "min", "p50", "p90", "p99", "mean" };
+#define METRIC_COUNT (sizeof(metric_names) / sizeof(metric_names[0]))
+
+// Fixed synthetic workload
+static uint32_t raw_red[WORKLOAD_SIZE];
+static uint32_t raw_ir[WORKLOAD_SIZE];
+static float ac_ir[WORKLOAD_SIZE];
+static float dc_ir[WORKLOAD_SIZE];
+static float hr_track[WORKLOAD_SIZE];
+static uint32_t cursor = 0;
+
+// Benchmark state
+static BiquadState_t biquad_state;
+static PPG_FilterState_t filter_state;
+static HR_State_t hr_state;
+static DPT_State_t dpt_state;
+static float median_buf[DPT_MEDIAN_SIZE];
+static DPTBatch_t dpt_batch;
+static int32_t batch_ac[BATCH_STREAMS];
+static FilterBatch_t filter_batch;
+static uint32_t batch_frames[BATCH_STREAMS * FILTER_BATCH_FRAMES * 2];
+static float batch_filtered[BATCH_STREAMS * FILTER_BATCH_FRAMES * 2];
+
+volatile float bench_sink;          // keeps results observable to the optimiser
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t next_index(void) {
+    uint32_t i = cursor;
+    cursor = (cursor + 1 == WORKLOAD_SIZE) ? 0 : cursor + 1;
+    return i;
+}
+
+// Deterministic noise (LCG) so every run sees the same bytes
+static uint32_t lcg_state = 12345u;
+static float noise(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (float)((lcg_state >> 8) & 0xFFFF) / 65535.0f - 0.5f;
+}
+
+static void make_workload(void) {
+    PPG_FilterState_t f;
+    PPG_Filter_Init(&f);
+
+    // Run the filter over the loop twice so the stored AC/DC is in steady state
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        lcg_state = 12345u;
+        for (uint32_t i = 0; i < WORKLOAD_SIZE; i++) {
+            double t = i / WORKLOAD_RATE;
+            double pulse = sin(2.0 * M_PI * WORKLOAD_HR_HZ * t) +
+                           0.3 * sin(4.0 * M_PI * WORKLOAD_HR_HZ * t + 0.8);
+            double resp = sin(2.0 * M_PI * WORKLOAD_RESP_HZ * t);
+            raw_ir[i] = (uint32_t)(120000.0 + 1500.0 * pulse + 400.0 * resp + 60.0 * noise());
+            raw_red[i] = (uint32_t)(90000.0 + 700.0 * pulse + 300.0 * resp + 60.0 * noise());
+            ac_ir[i] = PPG_Filter_Process(&f, raw_ir[i]);
+            dc_ir[i] = PPG_Filter_GetDC(&f);
+            hr_track[i] = (float)(75.0 + 3.0 * sin(2.0 * M_PI * t / 20.0) + 2.0 * noise());
+        }
+    }
+}
+
+/* ---------------- ppg_filter.c ---------------- */
+
+static void setup_biquad(void) {
+    memset(&biquad_state, 0, sizeof(biquad_state));
+}
+
+static void run_biquad(uint32_t ops) {
+    float acc = 0.0f;
+    for (uint32_t n = 0; n < ops; n++) {
+        acc += bench_biquad_filter((float)raw_ir[next_index()], &biquad_state);
+    }
+    bench_sink = acc;
+}
+
+static void setup_filter(void) {
+    PPG_Filter_Init(&filter_state);
+    for (uint32_t i = 0; i < WORKLOAD_SIZE; i++) {
+        PPG_Filter_Process(&filter_state, raw_ir[i]);
+    }
+}
+
+static void run_filter(uint32_t ops) {
+    float acc = 0.0f;
+    for (uint32_t n = 0; n < ops; n++) {
+        acc += PPG_Filter_Process(&filter_state, raw_ir[next_index()]);
+    }
+    bench_sink = acc;
+}
+
+/* ---------------- ppg_algorithm.c (Method 1) ---------------- */
+
+static void setup_hr(void) {
+    HR_Init(&hr_state);
+    for (uint32_t i = 0; i < 2 * HR_BUFFER_SIZE; i++) {
+        HR_AddSample(&hr_state, ac_ir[i], dc_ir[i]);
+    }
+}
+
+static void run_hr_add(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        uint32_t i = next_index();
+        HR_AddSample(&hr_state, ac_ir[i], dc_ir[i]);
+    }
+    bench_sink = hr_state.rolling_mean;
+}
+
+static void run_hr_calc(uint32_t ops) {
+    float acc = 0.0f;
+    for (uint32_t n = 0; n < ops; n++) {
+        acc += HR_Calculate(&hr_state);
+    }
+    bench_sink = acc;
+}
+
+static void run_median_method1(uint32_t ops) {
+    float acc = 0.0f;
+    for (uint32_t n = 0; n < ops; n++) {
+        uint32_t i = next_index();
+        for (uint8_t k = 0; k < HR_MEDIAN_FILTER_SIZE; k++) {
+            median_buf[k] = hr_track[(i + k) % WORKLOAD_SIZE];
+        }
+        acc += bench_median_filter_method1(median_buf, HR_MEDIAN_FILTER_SIZE);
+    }
+    bench_sink = acc;
+}
+
+/* ---------------- ppg_algorithm_v2.c (DPT) ---------------- */
+
+static void setup_dpt(void) {
+    DPT_Init(&dpt_state);
+    for (uint32_t i = 0; i < DPT_BUFFER_SIZE + 100; i++) {
+        DPT_Process(&dpt_state, raw_red[i], raw_ir[i]);
+    }
+}
+
+static void run_dpt_transform(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        bench_dpt_transform_process(&dpt_state, (int32_t)ac_ir[next_index()]);
+    }
+    bench_sink = dpt_state.ir_dpt.real[0];
+}
+
+static void run_dpt_spectrum(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        bench_compute_magnitude_spectrum(&dpt_state);
+    }
+    bench_sink = dpt_state.ir_dpt.magnitude[0];
+}
+
+static void run_median_dpt(uint32_t ops) {
+    float acc = 0.0f;
+    for (uint32_t n = 0; n < ops; n++) {
+        uint32_t i = next_index();
+        for (uint8_t k = 0; k < DPT_MEDIAN_SIZE; k++) {
+            median_buf[k] = hr_track[(i + k) % WORKLOAD_SIZE];
+        }
+        acc += bench_median_filter_dpt(median_buf, DPT_MEDIAN_SIZE);
+    }
+    bench_sink = acc;
+}
+
+static void run_dpt_process(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        uint32_t i = next_index();
+        DPT_Process(&dpt_state, raw_red[i], raw_ir[i]);
+    }
+    bench_sink = dpt_state.heart_rate;
+}
+
+/* ---------------- dpt_batch.c (batched DPT) ---------------- */
+
+// Every lane starts from the warmed-up scalar state, at its own workload offset
+static void setup_batch(uint32_t isa) {
+    setup_dpt();
+    DPTBatch_Free(&dpt_batch);
+    if (DPTBatch_Init(&dpt_batch, BATCH_STREAMS, isa) != 0) {
+        fprintf(stderr, "DPTBatch_Init(%s) failed\n", SimdIsa_Name(isa));
+        exit(1);
+    }
+    for (uint32_t l = 0; l < BATCH_STREAMS; l++) {
+        DPTBatch_LoadLane(&dpt_batch, l, &dpt_state.ir_dpt);
+    }
+}
+
+// ops = stream-samples
+static void run_batch_transform(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n += BATCH_STREAMS) {
+        uint32_t i = next_index();
+        for (uint32_t l = 0; l < BATCH_STREAMS; l++) {
+            batch_ac[l] = (int32_t)ac_ir[(i + l * 61) % WORKLOAD_SIZE];
+        }
+        DPTBatch_Process(&dpt_batch, batch_ac);
+    }
+    bench_sink = dpt_batch.real[0];
+}
+
+// ops = stream-spectra
+static void run_batch_spectrum(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n += BATCH_STREAMS) {
+        DPTBatch_Spectrum(&dpt_batch);
+    }
+    bench_sink = dpt_batch.magnitude[0];
+}
+
+/* ---------------- filter_batch.c (batched PPG filter) ---------------- */
+
+// Every channel starts from the warmed-up scalar filter
+static void setup_filter_batch(uint32_t isa) {
+    setup_filter();
+    FilterBatch_Free(&filter_batch);
+    if (FilterBatch_Init(&filter_batch, 2 * BATCH_STREAMS, isa) != 0) {
+        fprintf(stderr, "FilterBatch_Init(%s) failed\n", SimdIsa_Name(isa));
+        exit(1);
+    }
+    for (uint32_t c = 0; c < 2 * BATCH_STREAMS; c++) {
+        FilterBatch_LoadLane(&filter_batch, c, &filter_state);
+    }
+}
+
+// ops = channel-samples
+static void run_filter_batch(uint32_t ops) {
+    const uint32_t block = 2 * BATCH_STREAMS * FILTER_BATCH_FRAMES;
+    for (uint32_t n = 0; n < ops; n += block) {
+        uint32_t i = next_index();
+        for (uint32_t s = 0; s < BATCH_STREAMS; s++) {
+            for (uint32_t t = 0; t < FILTER_BATCH_FRAMES; t++) {
+                uint32_t k = (i + s * 61 + t) % WORKLOAD_SIZE;
+                batch_frames[(s * FILTER_BATCH_FRAMES + t) * 2] = raw_red[k];
+                batch_frames[(s * FILTER_BATCH_FRAMES + t) * 2 + 1] = raw_ir[k];
+            }
+        }
+        FilterBatch_ProcessFrames(&filter_batch, batch_frames, FILTER_BATCH_FRAMES, batch_filtered, NULL);
+    }
+    bench_sink = batch_filtered[0];
+}
+
+#define BATCH_KERNEL(tag, isa) \
+    static void setup_batch_##tag(void) { setup_batch(isa); } \
+    static void setup_filter_batch_##tag(void) { setup_filter_batch(isa); } \
+    static int has_##tag(void) { return SimdIsa_Supported(isa); }
+BATCH_KERNEL(scalar, SIMD_ISA_SCALAR)
+BATCH_KERNEL(avx2, SIMD_ISA_AVX2)
+BATCH_KERNEL(avx512, SIMD_ISA_AVX512)
+BATCH_KERNEL(neon, SIMD_ISA_NEON)
+
+/* ---------------- OLED primitives (I2C stubbed) ---------------- */
+
+static void run_oled_clear(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        OLED_ClearBuffer();
+    }
+}
+
+static void run_oled_string(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        OLED_PrintString(64, 0, "SpO2:", 12, OLED_COLOR_NORMAL);
+    }
+}
+
+static void run_oled_fixed(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        OLED_PrintFixed(18, 0, hr_track[next_index()], 0, 3, 12, OLED_COLOR_NORMAL);
+    }
+}
+
+// Maps an AC sample to a panel row in [16, 62]; the remainder is normalised
+// so negative samples stay inside the 64-row GRAM
+static uint8_t wave_row(float ac) {
+    int32_t v = (int32_t)(ac / 40.0f + 24.0f);
+    return (uint8_t)(16 + ((v % 47) + 47) % 47);
+}
+
+static void run_oled_line(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        uint32_t i = next_index();
+        uint8_t x = (uint8_t)(i % 126);
+        uint8_t y1 = wave_row(ac_ir[i]);
+        uint8_t y2 = wave_row(ac_ir[(i + 1) % WORKLOAD_SIZE]);
+        OLED_DrawLine(x, y1, (uint8_t)(x + 1), y2, OLED_COLOR_NORMAL);
+    }
+}
+
+static void run_oled_refresh(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        OLED_Refresh();
+    }
+}
+
+// One complete display frame the way main.c draws it
+static void run_oled_frame(uint32_t ops) {
+    for (uint32_t n = 0; n < ops; n++) {
+        OLED_ClearBuffer();
+        OLED_PrintString(0, 0, "HR:", 12, OLED_COLOR_NORMAL);
+        OLED_PrintFixed(18, 0, hr_track[next_index()], 0, 3, 12, OLED_COLOR_NORMAL);
+        OLED_PrintString(64, 0, "SpO2:", 12, OLED_COLOR_NORMAL);
+        OLED_PrintFixed(94, 0, 97.0f, 0, 3, 12, OLED_COLOR_NORMAL);
+        OLED_PrintString(112, 0, "%", 12, OLED_COLOR_NORMAL);
+        OLED_DrawRectangle(0, 15, 127, 63, OLED_COLOR_NORMAL);
+        run_oled_line(126);
+        OLED_Refresh();
+    }
+}
+
+static const Bench_t benches[] = {
+    { "biquad_filter",              1000, setup_biquad, run_biquad,          NULL, NULL },
+    { "PPG_Filter_Process",         1000, setup_filter, run_filter,          NULL, NULL },
+    { "HR_AddSample",               1000, setup_hr,     run_hr_add,          NULL, NULL },
+    { "HR_Calculate",               20,   setup_hr,     run_hr_calc,         NULL, NULL },
+    { "median_filter_method1",      1000, NULL,         run_median_method1,  NULL, NULL },
+    { "dpt_transform_process",      100,  setup_dpt,    run_dpt_transform,   NULL, NULL },
+    { "compute_magnitude_spectrum", 20,   setup_dpt,    run_dpt_spectrum,    NULL, NULL },
+    { "median_filter_dpt",          1000, NULL,         run_median_dpt,      NULL, NULL },
+    { "DPT_Process",                100,  setup_dpt,    run_dpt_process,     NULL, NULL },
+    { "dpt_batch_transform_scalar", 6400, setup_batch_scalar, run_batch_transform, has_scalar, "dpt_transform_process" },
+    { "dpt_batch_transform_avx2",   6400, setup_batch_avx2,   run_batch_transform, has_avx2,   "dpt_transform_process" },
+    { "dpt_batch_transform_avx512", 6400, setup_batch_avx512, run_batch_transform, has_avx512, "dpt_transform_process" },
+    { "dpt_batch_transform_neon",   6400, setup_batch_neon,   run_batch_transform, has_neon,   "dpt_transform_process" },
+    { "dpt_batch_spectrum_scalar",  1280, setup_batch_scalar, run_batch_spectrum,  has_scalar, "compute_magnitude_spectrum" },
+    { "dpt_batch_spectrum_avx2",    1280, setup_batch_avx2,   run_batch_spectrum,  has_avx2,   "compute_magnitude_spectrum" },
+    { "dpt_batch_spectrum_avx512",  1280, setup_batch_avx512, run_batch_spectrum,  has_avx512, "compute_magnitude_spectrum" },
+    { "dpt_batch_spectrum_neon",    1280, setup_batch_neon,   run_batch_spectrum,  has_neon,   "compute_magnitude_spectrum" },
+    { "filter_batch_scalar",        8192, setup_filter_batch_scalar, run_filter_batch, has_scalar, "PPG_Filter_Process" },
+    { "filter_batch_avx2",          8192, setup_filter_batch_avx2,   run_filter_batch, has_avx2,   "PPG_Filter_Process" },
+    { "filter_batch_avx512",        8192, setup_filter_batch_avx512, run_filter_batch, has_avx512, "PPG_Filter_Process" },
+    { "filter_batch_neon",          8192, setup_filter_batch_neon,   run_filter_batch, has_neon,   "PPG_Filter_Process" },
+    { "OLED_ClearBuffer",           200,  NULL,         run_oled_clear,      NULL, NULL },
+    { "OLED_PrintString",           200,  NULL,         run_oled_string,     NULL, NULL },
+    { "OLED_PrintFixed",            200,  NULL,         run_oled_fixed,      NULL, NULL },
+    { "OLED_DrawLine",              200,  NULL,         run_oled_line,       NULL, NULL },
+    { "OLED_Refresh",               20,   NULL,         run_oled_refresh,    NULL, NULL },
+    { "oled_frame",                 5,    NULL,         run_oled_frame,      NULL, NULL },
+};
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of a sorted array
+static double percentile(const double *sorted, uint32_t n, double q) {
+    uint32_t rank = (uint32_t)ceil(q * n);
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+static void run_bench(const Bench_t *b, uint32_t reps, uint32_t warmup, BenchResult_t *res) {
+    static double samples[MAX_REPS];
+
+    cursor = 0;
+    if (b->setup != NULL) {
+        b->setup();
+    }
+    for (uint32_t i = 0; i < warmup; i++) {
+        b->run(b->ops);
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < reps; i++) {
+        double t0 = now_ns();
+        b->run(b->ops);
+        double t1 = now_ns();
+        samples[i] = (t1 - t0) / b->ops;
+        sum += samples[i];
+    }
+    qsort(samples, reps, sizeof(double), compare_double);
+    res->min = samples[0];
+    res->p50 = percentile(samples, reps, 0.50);
+    res->p90 = percentile(samples, reps, 0.90);
+    res->p99 = percentile(samples, reps, 0.99);
+    res->mean = sum / reps;
+}
+
+static int write_json(const char *path, const uint8_t *selected, const BenchResult_t *results,
+                      uint32_t reps, uint32_t warmup) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    fprintf(f, "{\n  \"version\": %d,\n  \"unit\": \"ns/op\",\n", BENCH_JSON_VERSION);
+    fprintf(f, "  \"repetitions\": %u,\n  \"warmup\": %u,\n  \"benchmarks\": [\n", reps, warmup);
+    int first = 1;
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        if (!selected[i]) {
+            continue;
+        }
+        const BenchResult_t *r = &results[i];
+        fprintf(f, "%s    {\"name\": \"%s\", \"ops\": %u, \"min\": %.3f, \"p50\": %.3f, "
+                "\"p90\": %.3f, \"p99\": %.3f, \"mean\": %.3f}",
+                first ? "" : ",\n", benches[i].name, benches[i].ops,
+                r->min, r->p50, r->p90, r->p99, r->mean);
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+static double metric_value(const BenchResult_t *r, uint32_t metric) {
+    const double values[METRIC_COUNT] = { r->min, r->p50, r->p90, r->p99, r->mean };
+    return values[metric];
+}
+
+// Looks up one statistic of `name` in a file written by write_json (one benchmark per line)
+static int baseline_value(FILE *f, const char *name, uint32_t metric, double *value) {
+    char line[512];
+    char key[96];
+    char field[16];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    snprintf(field, sizeof(field), "\"%s\":", metric_names[metric]);
+    rewind(f);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strstr(line, key) == NULL) {
+            continue;
+        }
+        const char *p = strstr(line, field);
+        if (p == NULL) {
+            return 0;
+        }
+        *value = strtod(p + strlen(field), NULL);
+        return *value > 0.0;
+    }
+    return 0;
+}
+
+static int compare_baseline(const char *path, double threshold, uint32_t metric,
+                            const uint8_t *selected, const BenchResult_t *results) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    int regressions = 0;
+    printf("\nBaseline %s (%s, threshold +%.1f%%):\n", path, metric_names[metric], threshold);
+    printf("  %-28s %12s %12s %9s\n", "benchmark", "base ns/op", "now ns/op", "change");
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        double base;
+        if (!selected[i]) {
+            continue;
+        }
+        double now = metric_value(&results[i], metric);
+        if (!baseline_value(f, benches[i].name, metric, &base)) {
+            printf("  %-28s %12s %12.1f %9s\n", benches[i].name, "-", now, "new");
+            continue;
+        }
+        double change = (now / base - 1.0) * 100.0;
+        int regressed = change > threshold;
+        regressions += regressed;
+        printf("  %-28s %12.1f %12.1f %+8.1f%%%s\n", benches[i].name, base, now,
+               change, regressed ? "  REGRESSION" : "");
+    }
+    fclose(f);
+    return regressions;
+}
+
+// Batched benchmarks against the scalar function they replace (both must have run)
+static void print_speedups(const uint8_t *selected, const BenchResult_t *results) {
+    int header = 0;
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        if (!selected[i] || benches[i].reference == NULL) {
+            continue;
+        }
+        for (uint32_t j = 0; j < BENCH_COUNT; j++) {
+            if (!selected[j] || strcmp(benches[j].name, benches[i].reference) != 0) {
+                continue;
+            }
+            if (!header) {
+                printf("\nSpeed-up per stream (p50):\n");
+                header = 1;
+            }
+            printf("  %-28s %6.2fx  %s\n", benches[i].name, results[j].p50 / results[i].p50, benches[j].name);
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-q] [-n reps] [-w warmup] [-f filter] [-o out.json] "
+            "[-b baseline.json] [-t threshold_pct] [-m min|p50|p90|p99|mean]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    const char *filter = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    uint32_t metric = 1;    // p50
+    long reps = DEFAULT_REPS;
+    long warmup = DEFAULT_WARMUP;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            for (metric = 0; metric < METRIC_COUNT && strcmp(name, metric_names[metric]) != 0; metric++) {
+            }
+            if (metric == METRIC_COUNT) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            reps = strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup = strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            reps = 10;          // smoke run: checks that every benchmark executes
+            warmup = 1;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (reps < 1 || reps > MAX_REPS || warmup < 0) {
+        fprintf(stderr, "invalid repetition count\n");
+        return 2;
+    }
+
+    make_workload();
+
+    static BenchResult_t results[MAX_BENCHES];
+    uint8_t selected[MAX_BENCHES] = { 0 };
+    printf("=== PPG DSP Benchmarks (%ld reps, %ld warmup batches) ===\n\n", reps, warmup);
+    printf("  %-28s %6s %10s %10s %10s %10s %10s\n", "benchmark", "ops", "min", "p50", "p90", "p99", "mean");
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        if (filter != NULL && strstr(benches[i].name, filter) == NULL) {
+            continue;
+        }
+        if (benches[i].available != NULL && !benches[i].available()) {
+            printf("  %-28s %6s (not supported on this CPU)\n", benches[i].name, "-");
+            continue;
+        }
+        selected[i] = 1;
+        run_bench(&benches[i], (uint32_t)reps, (uint32_t)warmup, &results[i]);
+        const BenchResult_t *r = &results[i];
+        printf("  %-28s %6u %10.1f %10.1f %10.1f %10.1f %10.1f\n", benches[i].name, benches[i].ops,
+               r->min, r->p50, r->p90, r->p99, r->mean);
+    }
+    printf("  (ns/op)\n");
+    print_speedups(selected, results);
+
+    int status = 0;
+    if (json_path != NULL && write_json(json_path, selected, results, (uint32_t)reps, (uint32_t)warmup) != 0) {
+        status = 1;
+    }
+    if (baseline_path != NULL) {
+        int regressions = compare_baseline(baseline_path, threshold, metric, selected, results);
+        if (regressions > 0) {
+            printf("\n%d benchmark(s) regressed\n", regressions);
+        }
+        if (regressions != 0) {
+            status = 1;
+        }
+    }
+
+    printf("\n=== Benchmark Complete ===\n");
+    return status;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file check.h
+ * @brief CHECK: an assert() that survives NDEBUG
+ * @details assert() and its expression compile to nothing in a Release
+ *          (NDEBUG) build, so a call under test written inside one never
+ *          runs there. CHECK always evaluates its expression and aborts
+ *          with the location when it is false. Tests use it wherever the
+ *          expression does something; assert() stays for checks on values
+ *          already computed.
+ */
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #expr); \
+            abort(); \
+        } \
+    } while (0)
+
+#endif
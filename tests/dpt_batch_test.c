@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "dpt_batch.h"
+#include "ppg_algorithm_v2.h"
+#include "ppg_synth.h"
+
+#define MAX_STREAMS     40
+#define STEPS           2600        // 26 s at 100 Hz
+#define CHECK_EVERY     100
+#define JOIN_EARLY      300         // joins with a part-filled buffer
+#define JOIN_LATE       1500        // joins with a full buffer
+
+static PPGSynth_t synth[MAX_STREAMS];
+static DPT_State_t state[MAX_STREAMS];
+static DPT_Transform_t lane;
+
+// Step at which a stream is copied into the batch (0: from the start)
+static uint32_t join_step(uint32_t stream, uint32_t streams) {
+    if (stream == streams - 1) return JOIN_LATE;
+    if (stream == streams - 2) return JOIN_EARLY;
+    return 0;
+}
+
+static void compare_lane(const DPTBatch_t *b, uint32_t stream) {
+    const DPT_Transform_t *ref = &state[stream].ir_dpt;
+    DPTBatch_StoreLane(b, stream, &lane);
+    assert(memcmp(lane.real, ref->real, sizeof(ref->real)) == 0);
+    assert(memcmp(lane.imag, ref->imag, sizeof(ref->imag)) == 0);
+    assert(lane.sample_count == ref->sample_count);
+    assert(lane.buffer_full == ref->buffer_full);
+    // Same window, each at its own write position
+    for (uint32_t k = 0; k < DPT_BUFFER_SIZE; k++) {
+        assert(lane.recursive_buffer[(lane.buffer_index + k) % DPT_BUFFER_SIZE] ==
+               ref->recursive_buffer[(ref->buffer_index + k) % DPT_BUFFER_SIZE]);
+    }
+    if (ref->buffer_full) {
+        assert(memcmp(lane.magnitude, ref->magnitude, sizeof(ref->magnitude)) == 0);
+    }
+}
+
+// Every stream through DPT_Process and the IR AC values through the batch:
+// spectra and peak periods must match bit for bit
+static void run_equivalence(uint32_t streams, uint32_t isa) {
+    static int32_t ac[MAX_STREAMS];
+    static uint16_t periods[MAX_STREAMS];
+    DPTBatch_t b;
+    CHECK(DPTBatch_Init(&b, streams, isa) == 0);
+    assert(b.lanes % DPT_BATCH_LANE_ALIGN == 0 && b.lanes >= streams);
+
+    for (uint32_t s = 0; s < streams; s++) {
+        PPGSynth_Config_t cfg;
+        PPGSynth_RandomPatient(&cfg, 100 + s);
+        PPGSynth_Init(&synth[s], &cfg, 100 + s);
+        DPT_Init(&state[s]);
+    }
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        for (uint32_t s = 0; s < streams; s++) {
+            if (step > 0 && join_step(s, streams) == step) {
+                DPTBatch_LoadLane(&b, s, &state[s].ir_dpt);
+            }
+            uint32_t red, ir;
+            PPGSynth_Next(&synth[s], &red, &ir, NULL);
+            DPT_Process(&state[s], red, ir);
+            ac[s] = state[s].ir_filter.ac_value;
+        }
+        DPTBatch_Process(&b, ac);
+        if (b.full_lanes > 0) {
+            DPTBatch_Spectrum(&b);
+        }
+        if ((step + 1) % CHECK_EVERY != 0) {
+            continue;
+        }
+        DPTBatch_PeakPeriods(&b, DPT_MIN_PEAK_MAGNITUDE, periods);
+        for (uint32_t s = 0; s < streams; s++) {
+            if (join_step(s, streams) > step) {
+                continue;
+            }
+            compare_lane(&b, s);
+            if (state[s].ir_dpt.buffer_full) {
+                assert(periods[s] == state[s].peak_period);
+            }
+        }
+    }
+    // Every lane has been full for a while by now
+    assert(b.full_lanes == streams);
+    DPTBatch_Free(&b);
+}
+
+static void test_equivalence(void) {
+    printf("=== Batch vs Scalar DPT Test ===\n");
+    for (uint32_t isa = 0; isa < SIMD_ISA_COUNT; isa++) {
+        if (!SimdIsa_Supported(isa)) {
+            printf("  %-8s not supported here, skipped\n", SimdIsa_Name(isa));
+            continue;
+        }
+        run_equivalence(MAX_STREAMS, isa);      // padding lanes, masked kernel
+        run_equivalence(16, isa);               // whole vectors
+        printf("  %-8s bit-identical\n", SimdIsa_Name(isa));
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_init(void) {
+    printf("=== Batch Init Test ===\n");
+    DPTBatch_t b;
+    CHECK(DPTBatch_Init(&b, 0, SIMD_ISA_SCALAR) == -1);
+    CHECK(DPTBatch_Init(&b, 5, SIMD_ISA_COUNT) == -1);
+    assert(SimdIsa_Supported(SimdIsa_Best()));
+    CHECK(DPTBatch_Init(&b, 17, SimdIsa_Best()) == 0);
+    assert(b.lanes == 32 && b.full_lanes == 0 && b.buffer_index == 0);
+
+    // Basis identical to the scalar state's
+    DPT_Init(&state[0]);
+    assert(memcmp(b.cos_basis, state[0].cos_basis, sizeof(b.cos_basis)) == 0);
+    assert(memcmp(b.sin_basis, state[0].sin_basis, sizeof(b.sin_basis)) == 0);
+
+    // Load/store round trip at a different write position
+    for (uint32_t k = 0; k < 7; k++) {
+        static const int32_t zero[17];
+        DPTBatch_Process(&b, zero);
+    }
+    DPT_Transform_t *t = &state[0].ir_dpt;
+    for (uint32_t k = 0; k < DPT_BUFFER_SIZE; k++) t->recursive_buffer[k] = (int32_t)k - 500;
+    for (uint32_t p = 0; p < DPT_PERIOD_RANGE; p++) t->real[p] = (float)p;
+    t->buffer_index = 123;
+    t->sample_count = 1200;
+    t->buffer_full = true;
+    DPTBatch_LoadLane(&b, 3, t);
+    assert(b.full_lanes == 1);
+    DPTBatch_StoreLane(&b, 3, &lane);
+    assert(lane.buffer_index == 7 && lane.sample_count == 1200 && lane.buffer_full);
+    assert(memcmp(lane.real, t->real, sizeof(t->real)) == 0);
+    for (uint32_t k = 0; k < DPT_BUFFER_SIZE; k++) {
+        assert(lane.recursive_buffer[(7 + k) % DPT_BUFFER_SIZE] == t->recursive_buffer[(123 + k) % DPT_BUFFER_SIZE]);
+    }
+    // Replacing a full lane with an empty one
+    DPT_Init(&state[1]);
+    DPTBatch_LoadLane(&b, 3, &state[1].ir_dpt);
+    assert(b.full_lanes == 0);
+    DPTBatch_Free(&b);
+    printf("  PASSED\n\n");
+}
+
+int main(void) {
+    test_init();
+    test_equivalence();
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
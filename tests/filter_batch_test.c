@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "filter_batch.h"
+#include "ppg_synth.h"
+
+#define MAX_STREAMS     21          // 42 channels: padding lanes, streams % 4 != 0
+#define STEPS           1500
+#define CHECK_EVERY     50
+#define JOIN_STEP       700         // the last stream joins with a filled filter
+#define FRAME_BLOCK     7           // frames per ProcessFrames call, count % 4 != 0
+
+static PPGSynth_t synth[MAX_STREAMS];
+static PPG_FilterState_t state[2 * MAX_STREAMS];
+static PPG_FilterState_t lane;
+
+static uint32_t bits(float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+// Lane state against the scalar filter, field by field (AC statistics excluded)
+static void compare_lane(const FilterBatch_t *b, uint32_t channel) {
+    const PPG_FilterState_t *ref = &state[channel];
+    FilterBatch_StoreLane(b, channel, &lane);
+    assert(memcmp(lane.detrend_buffer, ref->detrend_buffer, sizeof(ref->detrend_buffer)) == 0);
+    assert(lane.detrend_index == ref->detrend_index);
+    assert(bits(lane.detrend_sum) == bits(ref->detrend_sum));
+    assert(lane.detrend_filled == ref->detrend_filled);
+    for (uint32_t s = 0; s < NUM_SOS_SECTIONS; s++) {
+        assert(bits(lane.biquad_states[s].x1) == bits(ref->biquad_states[s].x1));
+        assert(bits(lane.biquad_states[s].x2) == bits(ref->biquad_states[s].x2));
+    }
+    assert(memcmp(lane.smooth_buffer, ref->smooth_buffer, sizeof(ref->smooth_buffer)) == 0);
+    assert(lane.smooth_index == ref->smooth_index);
+    assert(bits(lane.dc_value) == bits(ref->dc_value));
+}
+
+static void start_streams(uint32_t streams) {
+    for (uint32_t s = 0; s < streams; s++) {
+        PPGSynth_Config_t cfg;
+        PPGSynth_RandomPatient(&cfg, 300 + s);
+        PPGSynth_Init(&synth[s], &cfg, 300 + s);
+        PPG_Filter_Init(&state[2 * s]);
+        PPG_Filter_Init(&state[2 * s + 1]);
+    }
+}
+
+// One sample per channel under a random active mask; the last stream is
+// filtered scalar-only until JOIN_STEP and then loaded into the batch
+static void run_masked(uint32_t streams, uint32_t isa) {
+    static uint32_t raw[2 * MAX_STREAMS];
+    static int32_t active[2 * MAX_STREAMS];
+    static float ac[2 * MAX_STREAMS], dc[2 * MAX_STREAMS], expect[2 * MAX_STREAMS];
+    const uint32_t late = streams - 1;
+    FilterBatch_t b;
+    CHECK(FilterBatch_Init(&b, 2 * streams, isa) == 0);
+    start_streams(streams);
+    srand(7 + isa);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        if (step == JOIN_STEP) {
+            FilterBatch_LoadLane(&b, 2 * late, &state[2 * late]);
+            FilterBatch_LoadLane(&b, 2 * late + 1, &state[2 * late + 1]);
+        }
+        for (uint32_t s = 0; s < streams; s++) {
+            // A stream has a sample about three steps in four
+            int32_t on = (rand() % 4) != 0;
+            raw[2 * s] = raw[2 * s + 1] = 0xDEAD;     // ignored when inactive
+            if (on) {
+                PPGSynth_Next(&synth[s], &raw[2 * s], &raw[2 * s + 1], NULL);
+                expect[2 * s] = PPG_Filter_Process(&state[2 * s], raw[2 * s]);
+                expect[2 * s + 1] = PPG_Filter_Process(&state[2 * s + 1], raw[2 * s + 1]);
+            }
+            active[2 * s] = active[2 * s + 1] = on && (s != late || step >= JOIN_STEP);
+        }
+        FilterBatch_Process(&b, raw, active, ac, dc);
+        for (uint32_t c = 0; c < 2 * streams; c++) {
+            if (active[c]) {
+                assert(bits(ac[c]) == bits(expect[c]));
+                assert(bits(dc[c]) == bits(state[c].dc_value));
+            }
+        }
+        if ((step + 1) % CHECK_EVERY == 0) {
+            for (uint32_t c = 0; c < 2 * streams; c++) {
+                if (c / 2 != late || step >= JOIN_STEP) {
+                    compare_lane(&b, c);
+                }
+            }
+        }
+    }
+    FilterBatch_Free(&b);
+}
+
+// Blocks of interleaved {red, IR} frames per stream through the tile transpose
+static void run_frames(uint32_t streams, uint32_t isa) {
+    static uint32_t frames[MAX_STREAMS * FRAME_BLOCK * 2];
+    static float ac[MAX_STREAMS * FRAME_BLOCK * 2], dc[MAX_STREAMS * FRAME_BLOCK * 2];
+    FilterBatch_t b;
+    CHECK(FilterBatch_Init(&b, 2 * streams, isa) == 0);
+    start_streams(streams);
+
+    for (uint32_t block = 0; block < STEPS / FRAME_BLOCK; block++) {
+        for (uint32_t s = 0; s < streams; s++) {
+            for (uint32_t t = 0; t < FRAME_BLOCK; t++) {
+                uint32_t *frame = &frames[((size_t)s * FRAME_BLOCK + t) * 2];
+                PPGSynth_Next(&synth[s], &frame[0], &frame[1], NULL);
+            }
+        }
+        CHECK(FilterBatch_ProcessFrames(&b, frames, FRAME_BLOCK, ac, dc) == 0);
+        for (uint32_t s = 0; s < streams; s++) {
+            for (uint32_t t = 0; t < FRAME_BLOCK; t++) {
+                for (uint32_t ch = 0; ch < 2; ch++) {
+                    size_t i = ((size_t)s * FRAME_BLOCK + t) * 2 + ch;
+                    float expect = PPG_Filter_Process(&state[2 * s + ch], frames[i]);
+                    assert(bits(ac[i]) == bits(expect));
+                    assert(bits(dc[i]) == bits(state[2 * s + ch].dc_value));
+                }
+            }
+        }
+    }
+    for (uint32_t c = 0; c < 2 * streams; c++) {
+        compare_lane(&b, c);
+    }
+    // Short blocks and no dc output
+    CHECK(FilterBatch_ProcessFrames(&b, frames, 1, ac, NULL) == 0);
+    for (uint32_t s = 0; s < streams; s++) {
+        CHECK(bits(ac[2 * s]) == bits(PPG_Filter_Process(&state[2 * s], frames[(size_t)s * 2])));
+    }
+    FilterBatch_Free(&b);
+}
+
+static void test_equivalence(void) {
+    printf("=== Batch vs Scalar Filter Test ===\n");
+    for (uint32_t isa = 0; isa < SIMD_ISA_COUNT; isa++) {
+        if (!SimdIsa_Supported(isa)) {
+            printf("  %-8s not supported here, skipped\n", SimdIsa_Name(isa));
+            continue;
+        }
+        run_masked(MAX_STREAMS, isa);       // padding lanes, masked gathers
+        run_masked(8, isa);                 // whole vectors
+        run_frames(MAX_STREAMS, isa);
+        run_frames(8, isa);
+        printf("  %-8s bit-identical\n", SimdIsa_Name(isa));
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_init(void) {
+    printf("=== Batch Filter Init Test ===\n");
+    FilterBatch_t b;
+    CHECK(FilterBatch_Init(&b, 0, SIMD_ISA_SCALAR) == -1);
+    CHECK(FilterBatch_Init(&b, 4, SIMD_ISA_COUNT) == -1);
+    CHECK(FilterBatch_Init(&b, 17, SimdIsa_Best()) == 0);
+    assert(b.lanes == 32);
+    // Odd channel counts have no frame layout
+    static const uint32_t frame[2] = { 100000, 100000 };
+    float ac[2];
+    CHECK(FilterBatch_ProcessFrames(&b, frame, 1, ac, NULL) == -1);
+
+    // Every lane starts as PPG_Filter_Init
+    for (uint32_t c = 0; c < 17; c++) {
+        PPG_Filter_Init(&state[c]);
+        compare_lane(&b, c);
+    }
+    // Load/store round trip of a part-filled state
+    for (uint32_t k = 0; k < 13; k++) {
+        PPG_Filter_Process(&state[9], 120000 + 37 * k);
+    }
+    FilterBatch_LoadLane(&b, 9, &state[9]);
+    compare_lane(&b, 9);
+    FilterBatch_Free(&b);
+    printf("  PASSED\n\n");
+}
+
+int main(void) {
+    test_init();
+    test_equivalence();
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <math.h>
+#include "../Core/Inc/fmt.h"
+
+#define BENCH_CALLS 1000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t rand_u32(void) {
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void test_integers(void) {
+    printf("=== Integer Format Test ===\n");
+
+    char buf[32], ref[32];
+    const int32_t fixed[] = { 0, 1, -1, 9, 10, -10, 99, 100, 2147483647, -2147483647 - 1 };
+    for (int i = 0; i < (int)(sizeof(fixed) / sizeof(fixed[0])); i++) {
+        fmt_i32(buf, fixed[i], 0, ' ');
+        snprintf(ref, sizeof(ref), "%d", (int)fixed[i]);
+        assert(strcmp(buf, ref) == 0);
+    }
+
+    for (int i = 0; i < 100000; i++) {
+        uint32_t u = rand_u32() >> (rand() % 32);
+        int32_t s = (int32_t)rand_u32() >> (rand() % 32);
+        uint8_t width = (uint8_t)(rand() % 14);
+
+        char *end = fmt_u32(buf, u, width, ' ');
+        snprintf(ref, sizeof(ref), "%*u", width, u);
+        assert(strcmp(buf, ref) == 0);
+        assert(end == buf + strlen(buf));
+
+        fmt_u32(buf, u, width, '0');
+        snprintf(ref, sizeof(ref), "%0*u", width, u);
+        assert(strcmp(buf, ref) == 0);
+
+        fmt_i32(buf, s, width, ' ');
+        snprintf(ref, sizeof(ref), "%*d", width, (int)s);
+        assert(strcmp(buf, ref) == 0);
+
+        fmt_i32(buf, s, width, '0');
+        snprintf(ref, sizeof(ref), "%0*d", width, (int)s);
+        assert(strcmp(buf, ref) == 0);
+
+        fmt_hex(buf, u, 8);
+        snprintf(ref, sizeof(ref), "%08X", u);
+        assert(strcmp(buf, ref) == 0);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_q16(void) {
+    printf("=== Q16.16 Format Test ===\n");
+
+    static const uint32_t pow10[FMT_MAX_DECIMALS + 1] = { 1u, 10u, 100u, 1000u, 10000u };
+
+    char buf[32], ref[32];
+    for (int i = 0; i < 100000; i++) {
+        int32_t q = (int32_t)rand_u32() >> (rand() % 24);
+        uint8_t decimals = (uint8_t)(rand() % (FMT_MAX_DECIMALS + 1));
+        uint32_t magnitude = (q < 0) ? (uint32_t)0 - (uint32_t)q : (uint32_t)q;
+
+        // Exact halfway cases: fmt rounds half away from zero, printf to even
+        if ((((magnitude & 0xFFFFu) * pow10[decimals]) & 0xFFFFu) == 0x8000u) {
+            continue;
+        }
+
+        fmt_q16(buf, q, decimals, 0, ' ');
+        snprintf(ref, sizeof(ref), "%.*f", decimals, (double)q / 65536.0);
+        if (strcmp(ref, "-0") == 0 || strncmp(ref, "-0.", 3) == 0) {
+            // printf keeps the sign of values that round to zero
+            if (strspn(ref + 1, "0.") == strlen(ref + 1)) {
+                memmove(ref, ref + 1, strlen(ref));
+            }
+        }
+        assert(strcmp(buf, ref) == 0);
+    }
+
+    fmt_q16(buf, 72 << 16 | 0x8000, 0, 0, ' ');
+    assert(strcmp(buf, "73") == 0);
+    fmt_q16(buf, -(1 << 15), 1, 6, ' ');
+    assert(strcmp(buf, "  -0.5") == 0);
+    fmt_q16(buf, 0xFFFF, 2, 0, ' ');       // 0.99998 carries into the integer part
+    assert(strcmp(buf, "1.00") == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_fixed(void) {
+    printf("=== Float Fixed-Point Format Test ===\n");
+
+    char buf[32], ref[32];
+    uint32_t mismatches = 0;
+    uint32_t total = 0;
+
+    // Display range of HR/SpO2/signal values; float scaling may differ from
+    // printf's exact decimal conversion by one unit in the last digit
+    for (int i = 0; i < 200000; i++) {
+        float v = ((float)rand() / (float)RAND_MAX - 0.2f) * 400.0f;
+        uint8_t decimals = (uint8_t)(rand() % 3);
+
+        fmt_fixed(buf, v, decimals, 0, ' ');
+        snprintf(ref, sizeof(ref), "%.*f", decimals, (double)v);
+        total++;
+        if (strcmp(buf, ref) != 0) {
+            double diff = atof(buf) - atof(ref);
+            double ulp = decimals == 0 ? 1.0 : decimals == 1 ? 0.1 : 0.01;
+            assert(diff < ulp * 1.001 && diff > -ulp * 1.001);
+            mismatches++;
+        }
+    }
+    printf("  %u / %u values differ from printf by one last digit\n", mismatches, total);
+    assert(mismatches * 1000u < total);
+
+    fmt_fixed(buf, 72.46f, 1, 0, ' ');
+    assert(strcmp(buf, "72.5") == 0);
+    fmt_fixed(buf, 98.0f, 0, 3, ' ');
+    assert(strcmp(buf, " 98") == 0);
+    fmt_fixed(buf, -0.01f, 1, 0, ' ');
+    assert(strcmp(buf, "0.0") == 0);
+    fmt_fixed(buf, -3.25f, 2, 7, '0');
+    assert(strcmp(buf, "-003.25") == 0);
+
+    // NaN, infinities and values past 2^31 after scaling: placeholder, no conversion
+    fmt_fixed(buf, NAN, 1, 0, ' ');
+    assert(strcmp(buf, FMT_PLACEHOLDER) == 0);
+    fmt_fixed(buf, INFINITY, 0, 4, '0');
+    assert(strcmp(buf, "  " FMT_PLACEHOLDER) == 0);
+    fmt_fixed(buf, -INFINITY, 2, 0, ' ');
+    assert(strcmp(buf, FMT_PLACEHOLDER) == 0);
+    fmt_fixed(buf, 3.0e9f, 0, 0, ' ');
+    assert(strcmp(buf, FMT_PLACEHOLDER) == 0);
+    fmt_fixed(buf, -300000.0f, 4, 0, ' ');
+    assert(strcmp(buf, FMT_PLACEHOLDER) == 0);
+    fmt_fixed(buf, 200000.0f, 4, 0, ' ');
+    assert(strcmp(buf, "200000.0000") == 0);
+
+    char line[64];
+    char *p = fmt_str(line, "[Method1] HR: ");
+    p = fmt_fixed(p, 72.44f, 1, 0, ' ');
+    p = fmt_str(p, " BPM");
+    p = fmt_char(p, '!');
+    assert(strcmp(line, "[Method1] HR: 72.4 BPM!") == 0);
+    assert(p == line + strlen(line));
+
+    // Method 2 log line with the widest peak period (app.c log_dpt_hr)
+    char suffix[48];
+    p = fmt_str(suffix, " BPM | Peak Period: ");
+    p = fmt_u32(p, 65535u, 0, ' ');
+    p = fmt_str(p, " samples (Valid)\r\n");
+    assert(strcmp(suffix, " BPM | Peak Period: 65535 samples (Valid)\r\n") == 0);
+    assert((size_t)(p - suffix) < sizeof(suffix));
+    p = fmt_str(line, "[Method2] HR: ");
+    p = fmt_fixed(p, 240.0f, 1, 0, ' ');
+    p = fmt_str(p, suffix);
+    assert((size_t)(p - line) < sizeof(line));
+    printf("  PASSED\n\n");
+}
+
+static void bench_against_snprintf(void) {
+    printf("=== Host Benchmark (fmt vs snprintf) ===\n");
+
+    static float values[1024];
+    for (int i = 0; i < 1024; i++) {
+        values[i] = 40.0f + (float)rand() / (float)RAND_MAX * 160.0f;
+    }
+
+    char buf[32];
+    volatile char sink = 0;
+
+    double t0 = now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        fmt_fixed(buf, values[i & 1023], 1, 0, ' ');
+        sink ^= buf[0];
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        snprintf(buf, sizeof(buf), "%.1f", values[i & 1023]);
+        sink ^= buf[0];
+    }
+    double t2 = now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        fmt_u32(buf, (uint32_t)i, 0, ' ');
+        sink ^= buf[0];
+    }
+    double t3 = now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        snprintf(buf, sizeof(buf), "%u", (unsigned)i);
+        sink ^= buf[0];
+    }
+    double t4 = now_ns();
+    (void)sink;
+
+    printf("  fmt_fixed  %%.1f : %6.1f ns/call\n", (t1 - t0) / BENCH_CALLS);
+    printf("  snprintf   %%.1f : %6.1f ns/call\n", (t2 - t1) / BENCH_CALLS);
+    printf("  fmt_u32    %%u   : %6.1f ns/call\n", (t3 - t2) / BENCH_CALLS);
+    printf("  snprintf   %%u   : %6.1f ns/call\n", (t4 - t3) / BENCH_CALLS);
+    printf("\n");
+}
+
+int main() {
+    printf("=== Fixed-Point Formatter Test Harness ===\n\n");
+    srand(42);
+
+    test_integers();
+    test_q16();
+    test_fixed();
+    bench_against_snprintf();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
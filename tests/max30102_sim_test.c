@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <math.h>
+#include "check.h"
+#include "platform_sim.h"
+#include "max30102_sim.h"
+#include "../lib/oled/inc/max30102.h"
+
+// Constant source: ADC counts at the reference LED current / range
+typedef struct {
+    uint32_t red;
+    uint32_t ir;
+    uint32_t calls;
+} Constant_t;
+
+static void constant_source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    Constant_t *c = (Constant_t *)ctx;
+    (void)t_us;
+    *red = c->red;
+    *ir = c->ir;
+    c->calls++;
+}
+
+// Counter source: every conversion gets the next value
+static void counter_source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    uint32_t *n = (uint32_t *)ctx;
+    (void)t_us;
+    *red = 1000u + *n;
+    *ir = 2000u + *n;
+    (*n)++;
+}
+
+static int irq_count = 0;
+
+static void irq_handler(void) {
+    irq_count++;
+}
+
+static void int_to_pin(void *ctx, uint8_t level) {
+    (void)ctx;
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, level);
+}
+
+static MAX30102Sim_t sensor;
+
+static void setup(MAX30102Sim_Source_t source, void *ctx) {
+    PlatformSim_Reset();
+    MAX30102Sim_Init(&sensor, source, ctx);
+    PlatformSim_Attach(PLATFORM_SIM_SOFT_I2C, &sensor.device);
+    MAX30102Sim_SetIntPin(&sensor, int_to_pin, NULL);
+    Platform_EXTI_SetHandler(PLATFORM_PIN_SENSOR_INT, irq_handler);
+    irq_count = 0;
+    Soft_I2C_Init();
+}
+
+static uint8_t read_reg(uint8_t reg) {
+    uint8_t value = 0;
+    CHECK(Soft_I2C_Read_Reg(MAX30102_I2C_ADDR, reg, &value) == 0);
+    return value;
+}
+
+static void write_reg(uint8_t reg, uint8_t value) {
+    CHECK(Soft_I2C_Write_Reg(MAX30102_I2C_ADDR, reg, value) == 0);
+}
+
+static void test_power_on_and_reset(void) {
+    printf("=== Power-on / Reset Test ===\n");
+    Constant_t c = { 50000, 80000, 0 };
+    setup(constant_source, &c);
+
+    // PWR_RDY is pending after power-up and cannot be masked
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 0);
+    CHECK(read_reg(REG_INTR_STATUS_1) == 0x01);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 1);
+    CHECK(read_reg(REG_INTR_STATUS_1) == 0x00);
+    CHECK(read_reg(0xFE) == MAX30102_SIM_REV_ID);
+
+    write_reg(REG_LED1_PA, 0x55);
+    write_reg(REG_SPO2_CONFIG, 0x27);
+    CHECK(MAX30102_Reset() == 0);
+    CHECK(read_reg(REG_LED1_PA) == 0x00);
+    CHECK(read_reg(REG_SPO2_CONFIG) == 0x00);
+    CHECK(MAX30102_ReadPartID() == 0x15);
+
+    // Read-only registers ignore writes; SPO2_CONFIG bit 7 is reserved
+    write_reg(REG_PART_ID, 0x00);
+    CHECK(MAX30102_ReadPartID() == 0x15);
+    write_reg(REG_SPO2_CONFIG, 0xFF);
+    CHECK(read_reg(REG_SPO2_CONFIG) == 0x7F);
+    printf("  PASSED\n\n");
+}
+
+static void test_ppg_rdy_interrupt(void) {
+    printf("=== PPG_RDY Interrupt Test ===\n");
+    Constant_t c = { 50000, 80000, 0 };
+    setup(constant_source, &c);
+    read_reg(REG_INTR_STATUS_1);                    // clear PWR_RDY
+    CHECK(MAX30102_Init() == 0);                   // A_FULL + PPG_RDY enabled, 100 Hz
+    int before = irq_count;
+
+    Platform_DelayMs(15);
+    assert(irq_count == before + 1);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 0);
+
+    // The pin stays low until the status is read: no further edges meanwhile
+    Platform_DelayMs(30);
+    assert(irq_count == before + 1);
+    uint8_t status1 = 0, status2 = 0;
+    MAX30102_ReadInterruptStatus(&status1, &status2);
+    assert(status1 == 0x40 && status2 == 0x00);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 1);
+
+    // Reading FIFO_DATA clears PPG_RDY as well
+    Platform_DelayMs(10);
+    assert(irq_count == before + 2);
+    uint32_t red, ir;
+    MAX30102_ReadFifo(&red, &ir);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 1);
+    assert(red == 50000 && ir == 80000);
+    printf("  PASSED\n\n");
+}
+
+static void test_a_full_interrupt(void) {
+    printf("=== A_FULL Interrupt Test ===\n");
+    Constant_t c = { 50000, 80000, 0 };
+    setup(constant_source, &c);
+    read_reg(REG_INTR_STATUS_1);
+    CHECK(MAX30102_Init() == 0);                   // FIFO_A_FULL = 15: 17 unread samples
+    write_reg(REG_INTR_ENABLE_1, 0x80);             // A_FULL only
+    int before = irq_count;
+
+    Platform_DelayMs(165);                          // 16 samples
+    uint8_t lost;
+    CHECK(MAX30102_GetFifoCount(&lost) == 16);
+    assert(irq_count == before);
+    Platform_DelayMs(10);                           // 17th sample
+    assert(irq_count == before + 1);
+    CHECK((read_reg(REG_INTR_STATUS_1) & 0x80) != 0);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 1);
+
+    static uint32_t red[MAX30102_FIFO_DEPTH];
+    static uint32_t ir[MAX30102_FIFO_DEPTH];
+    uint8_t count = MAX30102_GetFifoCount(&lost);
+    CHECK(MAX30102_ReadFifoBurst(red, ir, count) == count);
+
+    // Next threshold crossing after draining the FIFO
+    Platform_DelayMs(175);
+    assert(irq_count == before + 2);
+    printf("  PASSED\n\n");
+}
+
+static uint32_t drain(uint32_t *last_red, uint32_t *last_ir) {
+    static uint32_t red[MAX30102_FIFO_DEPTH];
+    static uint32_t ir[MAX30102_FIFO_DEPTH];
+    uint8_t lost;
+    uint8_t count = MAX30102_GetFifoCount(&lost);
+    assert(lost == 0);
+    if (count > 0) {
+        CHECK(MAX30102_ReadFifoBurst(red, ir, count) == count);
+        if (last_red != NULL) {
+            *last_red = red[count - 1];
+            *last_ir = ir[count - 1];
+        }
+    }
+    return count;
+}
+
+static void test_sample_rate(void) {
+    printf("=== Sample Rate / Averaging Test ===\n");
+    Constant_t c = { 50000, 80000, 0 };
+    setup(constant_source, &c);
+    CHECK(MAX30102_Init() == 0);
+
+    // 400 Hz conversions, 4-sample average: 100 samples/s into the FIFO
+    write_reg(REG_SPO2_CONFIG, 0x2F);
+    write_reg(REG_FIFO_CONFIG, 0x4F);
+    assert(MAX30102Sim_SampleRate(&sensor) == 400);
+    c.calls = 0;
+    uint32_t total = 0;
+    uint64_t start = PlatformSim_GetUs();
+    for (int i = 0; i < 100; i++) {
+        Platform_DelayMs(100);
+        total += drain(NULL, NULL);
+    }
+    // Reading takes time too: compare against the virtual time that passed
+    double seconds = (double)(PlatformSim_GetUs() - start) / 1e6;
+    printf("  400 Hz / 4: %u samples, %u conversions in %.3f s\n", total, c.calls, seconds);
+    assert(fabs(total - seconds * 100.0) <= 2.0);
+    assert(fabs(c.calls - seconds * 400.0) <= 4.0);
+
+    // Oscillator 1 % fast
+    sensor.rate_error_ppm = 10000;
+    write_reg(REG_FIFO_CONFIG, 0x0F);
+    write_reg(REG_SPO2_CONFIG, 0x27);               // 100 Hz, restarts the conversions
+    drain(NULL, NULL);
+    total = 0;
+    start = PlatformSim_GetUs();
+    for (int i = 0; i < 100; i++) {
+        Platform_DelayMs(100);
+        total += drain(NULL, NULL);
+    }
+    seconds = (double)(PlatformSim_GetUs() - start) / 1e6;
+    printf("  100 Hz +1%%: %u samples in %.3f s\n", total, seconds);
+    assert(fabs(total - seconds * 101.0) <= 2.0);
+
+    // Shutdown stops sampling
+    write_reg(REG_MODE_CONFIG, 0x83);
+    drain(NULL, NULL);
+    Platform_DelayMs(200);
+    CHECK(drain(NULL, NULL) == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_signal_scaling(void) {
+    printf("=== LED Current / ADC Range Scaling Test ===\n");
+    Constant_t c = { 50001, 80003, 0 };
+    setup(constant_source, &c);
+    CHECK(MAX30102_Init() == 0);
+    uint32_t red = 0, ir = 0;
+
+    // Reference settings: the source values unchanged
+    Platform_DelayMs(20);
+    drain(&red, &ir);
+    assert(red == 50001 && ir == 80003);
+
+    // Twice the red LED current, IR LED off
+    write_reg(REG_LED1_PA, 0x48);
+    write_reg(REG_LED2_PA, 0x00);
+    Platform_DelayMs(20);
+    drain(&red, &ir);
+    assert(red == 100002 && ir == 0);
+
+    // 16384 nA range, 69 us pulses: a quarter of the counts at 15-bit resolution
+    write_reg(REG_LED1_PA, 0x24);
+    write_reg(REG_LED2_PA, 0x24);
+    write_reg(REG_SPO2_CONFIG, 0x64);
+    drain(NULL, NULL);
+    Platform_DelayMs(20);
+    drain(&red, &ir);
+    assert(red == ((50001u / 4) & ~7u) && ir == ((80003u / 4) & ~7u));
+
+    // Saturation at full scale
+    write_reg(REG_SPO2_CONFIG, 0x07);               // 2048 nA: double the counts
+    write_reg(REG_LED2_PA, 0xFF);
+    drain(NULL, NULL);
+    uint32_t saturated = sensor.saturated;
+    Platform_DelayMs(50);
+    drain(&red, &ir);
+    assert(red == 100002 && ir == 0x3FFFF);
+    assert(sensor.saturated > saturated);
+    printf("  PASSED\n\n");
+}
+
+static void test_modes(void) {
+    printf("=== HR / Multi-LED Mode Test ===\n");
+    uint32_t n = 0;
+    setup(counter_source, &n);
+    CHECK(MAX30102_Init() == 0);
+
+    // HR mode: red only, 3 bytes per sample
+    write_reg(REG_MODE_CONFIG, 0x02);
+    write_reg(REG_FIFO_WR_PTR, 0);
+    write_reg(REG_FIFO_RD_PTR, 0);
+    n = 0;
+    Platform_DelayMs(35);
+    uint8_t buf[6];
+    uint32_t popped = sensor.popped;
+    CHECK(Soft_I2C_Read_Regs(MAX30102_I2C_ADDR, REG_FIFO_DATA, buf, 6) == 0);
+    assert(sensor.popped == popped + 2);
+    assert((((uint32_t)buf[0] << 16) | ((uint32_t)buf[1] << 8) | buf[2]) == 1000);
+    assert((((uint32_t)buf[3] << 16) | ((uint32_t)buf[4] << 8) | buf[5]) == 1001);
+
+    // Multi-LED: SLOT1 = IR, SLOT2 = red
+    uint8_t leds[MAX30102_SIM_CHANNELS];
+    write_reg(0x11, 0x12);
+    write_reg(0x12, 0x00);
+    write_reg(REG_MODE_CONFIG, 0x07);
+    CHECK(MAX30102Sim_Channels(&sensor, leds) == 2);
+    assert(leds[0] == MAX30102_SIM_LED_IR && leds[1] == MAX30102_SIM_LED_RED);
+    write_reg(REG_FIFO_WR_PTR, 0);
+    write_reg(REG_FIFO_RD_PTR, 0);
+    n = 0;
+    Platform_DelayMs(15);
+    uint32_t first = 0, second = 0;
+    MAX30102_ReadFifo(&first, &second);
+    assert(first == 2000 && second == 1000);
+    printf("  PASSED\n\n");
+}
+
+static void test_rollover(void) {
+    printf("=== FIFO Rollover Test ===\n");
+    uint32_t n = 0;
+    setup(counter_source, &n);
+    CHECK(MAX30102_Init() == 0);
+    write_reg(REG_FIFO_CONFIG, 0x1F);               // FIFO_ROLLOVER_EN
+    write_reg(REG_FIFO_WR_PTR, 0);
+    write_reg(REG_OVF_COUNTER, 0);
+    write_reg(REG_FIFO_RD_PTR, 0);
+    n = 0;
+
+    Platform_DelayMs(405);                          // 40 samples into 32 slots
+    uint8_t lost;
+    uint8_t count = MAX30102_GetFifoCount(&lost);
+    printf("  %u in FIFO, %u overwritten\n", count, lost);
+    assert(count == MAX30102_FIFO_DEPTH && lost == 8);
+
+    // The oldest samples were overwritten: the FIFO holds the newest 32
+    static uint32_t red[MAX30102_FIFO_DEPTH];
+    static uint32_t ir[MAX30102_FIFO_DEPTH];
+    CHECK(MAX30102_ReadFifoBurst(red, ir, 1) == 1);
+    assert(red[0] >= 1000 + 8);
+    assert(ir[0] == red[0] + 1000);
+    printf("  PASSED\n\n");
+}
+
+static void test_die_temperature(void) {
+    printf("=== Die Temperature Test ===\n");
+    setup(NULL, NULL);
+    read_reg(REG_INTR_STATUS_1);
+    sensor.temperature_c = -5.5f;
+    write_reg(REG_INTR_ENABLE_2, 0x02);
+    write_reg(0x21, 0x01);
+    CHECK(read_reg(0x21) == 0x01);                 // conversion running
+    Platform_DelayMs(20);
+    assert(irq_count == 0);
+    Platform_DelayMs(10);
+    assert(irq_count == 1);
+    CHECK(read_reg(REG_INTR_STATUS_2) == 0x02);
+    CHECK(read_reg(0x21) == 0x00);
+    int8_t whole = (int8_t)read_reg(0x1F);
+    uint8_t frac = read_reg(0x20);
+    assert(whole == -6 && frac == 8);               // -6 + 8/16
+    printf("  PASSED\n\n");
+}
+
+static void test_recorded_source(void) {
+    printf("=== Recorded Source Test ===\n");
+    const char *path = "max30102_sim_test.csv";
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fprintf(f, "index,red,ir\n");
+    for (int i = 0; i < 50; i++) {
+        fprintf(f, "%d,%d,%d\n", i, 60000 + 10 * i, 90000 + 10 * i);
+    }
+    fclose(f);
+
+    MAX30102Sim_Recording_t rec;
+    CHECK(MAX30102Sim_LoadCsv(&rec, "does_not_exist.csv", 100) != 0);
+    CHECK(MAX30102Sim_LoadCsv(&rec, path, 100) == 0);
+    assert(rec.count == 50);
+    remove(path);
+
+    setup(MAX30102Sim_RecordingSource, &rec);
+    CHECK(MAX30102_Init() == 0);
+    Platform_DelayMs(150);
+
+    // Consecutive samples step through the recording, wrapping after 50
+    static uint32_t red[MAX30102_FIFO_DEPTH];
+    static uint32_t ir[MAX30102_FIFO_DEPTH];
+    uint32_t previous = 0;
+    for (int round = 0; round < 6; round++) {
+        uint8_t lost;
+        uint8_t count = MAX30102_GetFifoCount(&lost);
+        CHECK(MAX30102_ReadFifoBurst(red, ir, count) == count);
+        for (uint8_t i = 0; i < count; i++) {
+            assert(red[i] >= 60000 && red[i] < 60500);
+            assert(ir[i] == red[i] + 30000);
+            if (previous != 0) {
+                assert(red[i] == previous + 10 || (previous == 60490 && red[i] == 60000));
+            }
+            previous = red[i];
+        }
+        Platform_DelayMs(150);
+    }
+    MAX30102Sim_FreeRecording(&rec);
+    printf("  PASSED\n\n");
+}
+
+static void test_speed(void) {
+    printf("=== Virtual Time Speed Test ===\n");
+    Constant_t c = { 50000, 80000, 0 };
+    setup(constant_source, &c);
+    CHECK(MAX30102_Init() == 0);
+
+    // Driver polling loop: burst read every 100 ms for 10 minutes of sensor time
+    clock_t start = clock();
+    uint32_t total = 0;
+    for (int i = 0; i < 6000; i++) {
+        Platform_DelayMs(100);
+        total += drain(NULL, NULL);
+    }
+    double wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+    double sim_s = (double)PlatformSim_GetUs() / 1e6;
+    printf("  %u samples, %.0f s virtual in %.3f s (%.0fx real time)\n",
+           total, sim_s, wall, wall > 0.0 ? sim_s / wall : 0.0);
+    assert(fabs(total - sim_s * 100.0) <= 2.0);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== MAX30102 Emulator Test Harness ===\n\n");
+
+    test_power_on_and_reset();
+    test_ppg_rdy_interrupt();
+    test_a_full_interrupt();
+    test_sample_rate();
+    test_signal_scaling();
+    test_modes();
+    test_rollover();
+    test_die_temperature();
+    test_recorded_source();
+    test_speed();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
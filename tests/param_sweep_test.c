@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "check.h"
+#include "param_sweep.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+
+#define RECORDS     3
+#define SECONDS     240.0
+
+static PPGScore_Record_t records[RECORDS];
+
+static void load_records(void) {
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        CHECK(PPGScore_SynthesisePatient(&records[r], 1 + r, SECONDS) == 0);
+    }
+}
+
+static void assert_same_result(const PPGScore_Result_t *a, const PPGScore_Result_t *b) {
+    assert(a->hr.updates == b->hr.updates && a->hr.valid == b->hr.valid && a->hr.n == b->hr.n);
+    assert(a->hr.sum_abs == b->hr.sum_abs && a->hr.sum_sq == b->hr.sum_sq);
+    assert(a->hr.first_valid_s == b->hr.first_valid_s && a->hr.lag_s == b->hr.lag_s);
+    assert(a->spo2.n == b->spo2.n && a->spo2.sum_abs == b->spo2.sum_abs);
+}
+
+static int same_params(const PPG_Params_t *a, const PPG_Params_t *b) {
+    for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+        const ParamSweep_Param_t *param = ParamSweep_GetParam(i);
+        if (ParamSweep_GetValue(a, param) != ParamSweep_GetValue(b, param)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ---- The defaults reproduce the compiled-in constants; other values change the output ----
+
+static void test_defaults(void) {
+    printf("=== Default Parameters Test ===\n");
+    PPG_Params_t defaults;
+    ParamSweep_Defaults(&defaults);
+    assert(defaults.hr_ema_alpha == HR_EMA_ALPHA);
+    assert(defaults.peak_threshold == PEAK_THRESHOLD);
+    assert(defaults.invalid_reset_threshold == INVALID_RESET_THRESHOLD);
+    assert(defaults.dpt_min_peak_magnitude == DPT_MIN_PEAK_MAGNITUDE);
+
+    // No smoothing, no rate limit: a different output series
+    PPG_Params_t raw = defaults;
+    raw.hr_ema_alpha = raw.dpt_hr_ema_alpha = 1.0f;
+    raw.max_hr_change = raw.dpt_max_hr_change = 1000.0f;
+    for (uint32_t v = 0; v < PPGVariant_Count(); v++) {
+        const PPGVariant_t *variant = PPGVariant_Get(v);
+        PPGScore_Metric_t plain_hr, raw_hr;
+        memset(&plain_hr, 0, sizeof(plain_hr));
+        memset(&raw_hr, 0, sizeof(raw_hr));
+        for (uint32_t r = 0; r < RECORDS; r++) {
+            PPGScore_Result_t plain, tuned;
+            CHECK(PPGScore_Run(variant, &records[r], &plain) == 0);
+            CHECK(PPGScore_RunParams(variant, &defaults, &records[r], &tuned) == 0);
+            assert_same_result(&plain, &tuned);
+            PPGScore_Add(&plain_hr, &plain.hr);
+            CHECK(PPGScore_RunParams(variant, &raw, &records[r], &tuned) == 0);
+            PPGScore_Add(&raw_hr, &tuned.hr);
+        }
+        assert(plain_hr.n > 0 && raw_hr.n > 0);
+        assert(raw_hr.sum_abs != plain_hr.sum_abs);
+        printf("  %s: defaults identical, unsmoothed HR MAE %.2f -> %.2f\n", variant->name,
+               plain_hr.sum_abs / plain_hr.n, raw_hr.sum_abs / raw_hr.n);
+    }
+
+    // Every parameter reads back what was set
+    PPG_Params_t p = defaults;
+    for (uint32_t i = 0; i < ParamSweep_ParamCount(); i++) {
+        const ParamSweep_Param_t *param = ParamSweep_GetParam(i);
+        assert(ParamSweep_FindParam(param->name) == param);
+        ParamSweep_SetValue(&p, param, 3.0f);
+        assert(ParamSweep_GetValue(&p, param) == 3.0f);
+    }
+    assert(ParamSweep_FindParam("no_such_param") == NULL);
+    printf("  PASSED\n\n");
+}
+
+// ---- Grid and random candidates ----
+
+static void test_candidates(void) {
+    printf("=== Candidate Generation Test ===\n");
+    ParamSweep_Range_t ranges[2] = {
+        { ParamSweep_FindParam("hr_ema_alpha"), 0.1f, 0.5f },
+        { ParamSweep_FindParam("invalid_reset_threshold"), 1.0f, 2.0f },
+    };
+    // 3 x 2 (two integer values) plus the defaults
+    uint64_t count = ParamSweep_Grid(ranges, 2, 3, NULL);
+    assert(count == 7);
+    ParamSweep_Candidate_t grid[7];
+    CHECK(ParamSweep_Grid(ranges, 2, 3, grid) == 7);
+    PPG_Params_t defaults;
+    ParamSweep_Defaults(&defaults);
+    assert(same_params(&grid[0].params, &defaults));
+    assert(grid[1].params.hr_ema_alpha == 0.1f && grid[1].params.invalid_reset_threshold == 1);
+    assert(grid[2].params.hr_ema_alpha == 0.1f && grid[2].params.invalid_reset_threshold == 2);
+    assert(fabsf(grid[3].params.hr_ema_alpha - 0.3f) < 1e-6f);
+    assert(grid[6].params.hr_ema_alpha == 0.5f && grid[6].params.invalid_reset_threshold == 2);
+    // Parameters not swept keep their defaults
+    assert(grid[6].params.max_hr_change == MAX_HR_CHANGE);
+
+    ParamSweep_Candidate_t a[50], b[50], c[50];
+    ParamSweep_Random(ranges, 2, 7, a, 50);
+    ParamSweep_Random(ranges, 2, 7, b, 50);
+    ParamSweep_Random(ranges, 2, 8, c, 50);
+    assert(same_params(&a[0].params, &defaults));
+    int differs = 0, seen[3] = { 0, 0, 0 };
+    for (int k = 1; k < 50; k++) {
+        assert(same_params(&a[k].params, &b[k].params));
+        differs |= (a[k].params.hr_ema_alpha != c[k].params.hr_ema_alpha);
+        assert(a[k].params.hr_ema_alpha >= 0.1f && a[k].params.hr_ema_alpha <= 0.5f);
+        assert(a[k].params.invalid_reset_threshold >= 1 && a[k].params.invalid_reset_threshold <= 2);
+        seen[a[k].params.invalid_reset_threshold]++;
+    }
+    assert(differs);
+    assert(seen[1] > 0 && seen[2] > 0);
+    printf("  PASSED\n\n");
+}
+
+// ---- Pareto front ----
+
+static void test_pareto(void) {
+    printf("=== Pareto Front Test ===\n");
+    // accuracy, latency, feasible
+    static const double points[][3] = {
+        { 3.0, 10.0, 1 },   // 0 front
+        { 2.0, 12.0, 1 },   // 1 front
+        { 2.5, 12.0, 1 },   // 2 dominated by 1
+        { 4.0,  8.0, 1 },   // 3 front
+        { 4.0,  9.0, 1 },   // 4 dominated by 3
+        { 1.0,  1.0, 0 },   // 5 infeasible
+        { 5.0,  8.0, 1 },   // 6 dominated by 3 (equal latency)
+        { 2.0, 12.0, 1 },   // 7 equal to 1: only the first is on the front
+    };
+    static const uint8_t expected[] = { 1, 1, 0, 1, 0, 0, 0, 0 };
+    uint32_t n = sizeof(points) / sizeof(points[0]);
+    ParamSweep_Candidate_t cands[8];
+    memset(cands, 0, sizeof(cands));
+    for (uint32_t i = 0; i < n; i++) {
+        cands[i].accuracy = points[i][0];
+        cands[i].latency = points[i][1];
+        cands[i].feasible = (uint8_t)points[i][2];
+    }
+    CHECK(ParamSweep_Pareto(cands, n) == 3);
+    for (uint32_t i = 0; i < n; i++) {
+        assert(cands[i].pareto == expected[i]);
+    }
+    printf("  PASSED\n\n");
+}
+
+// ---- Parallel evaluation: independent of the thread count, candidate 0 = ppg_score ----
+
+static void test_evaluate(void) {
+    printf("=== Parallel Evaluation Test ===\n");
+    ParamSweep_Range_t ranges[2] = {
+        { ParamSweep_FindParam("hr_ema_alpha"), 0.05f, 1.0f },
+        { ParamSweep_FindParam("max_hr_change"), 2.0f, 30.0f },
+    };
+    uint32_t count = (uint32_t)ParamSweep_Grid(ranges, 2, 3, NULL);
+    ParamSweep_Candidate_t *one = (ParamSweep_Candidate_t *)malloc(count * sizeof(ParamSweep_Candidate_t));
+    ParamSweep_Candidate_t *many = (ParamSweep_Candidate_t *)malloc(count * sizeof(ParamSweep_Candidate_t));
+    assert(one != NULL && many != NULL);
+    ParamSweep_Grid(ranges, 2, 3, one);
+    ParamSweep_Grid(ranges, 2, 3, many);
+
+    ParamSweep_Config_t cfg = { PPGVariant_Find("m1"), 1, PARAM_SWEEP_LATENCY_LAG, 20.0 };
+    ParamSweep_Stats_t stats;
+    CHECK(ParamSweep_Evaluate(&cfg, records, RECORDS, one, count, &stats) == 0);
+    assert(stats.runs == (uint64_t)count * RECORDS);
+    cfg.threads = 3;
+    CHECK(ParamSweep_Evaluate(&cfg, records, RECORDS, many, count, &stats) == 0);
+    assert(stats.threads == 3 && stats.runs == (uint64_t)count * RECORDS);
+    for (uint32_t c = 0; c < count; c++) {
+        assert(one[c].failed == 0);
+        assert_same_result(&one[c].total, &many[c].total);
+        assert(one[c].accuracy == many[c].accuracy && one[c].latency == many[c].latency);
+    }
+
+    // The defaults score as in ppg_score
+    PPGScore_Result_t total;
+    memset(&total, 0, sizeof(total));
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        PPGScore_Result_t res;
+        CHECK(PPGScore_Run(cfg.variant, &records[r], &res) == 0);
+        PPGScore_Add(&total.hr, &res.hr);
+        PPGScore_Add(&total.spo2, &res.spo2);
+    }
+    assert_same_result(&total, &many[0].total);
+
+    // Less smoothing follows the reference sooner
+    const ParamSweep_Candidate_t *slow = &many[1], *fast = &many[count - 1];
+    assert(slow->params.hr_ema_alpha == 0.05f && fast->params.hr_ema_alpha == 1.0f);
+    printf("  alpha 0.05 / limit 2: MAE %.2f lag %.1f s, alpha 1 / limit 30: MAE %.2f lag %.1f s\n",
+           slow->accuracy, slow->latency, fast->accuracy, fast->latency);
+    assert(slow->feasible && fast->feasible);
+    assert(fast->latency < slow->latency);
+
+    uint32_t front = ParamSweep_Pareto(many, count);
+    printf("  %u candidates, %u on the front, %llu runs on %u threads in %.2f s (%llu stolen)\n", count, front,
+           (unsigned long long)stats.runs, stats.threads, stats.wall_s, (unsigned long long)stats.steals);
+    assert(front >= 1);
+    free(one);
+    free(many);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Parameter Sweep Test ===\n\n");
+
+    load_records();
+    test_defaults();
+    test_candidates();
+    test_pareto();
+    test_evaluate();
+
+    for (uint32_t r = 0; r < RECORDS; r++) {
+        PPGScore_FreeRecord(&records[r]);
+    }
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
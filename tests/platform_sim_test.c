@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "platform_sim.h"
+#include "max30102_sim.h"
+#include "oled_sim.h"
+#include "../lib/oled/inc/max30102.h"
+
+// Register-file device for the bus decoder tests
+typedef struct {
+    I2CSim_Device_t device;
+    uint8_t regs[16];
+    uint8_t ptr;
+    uint8_t ptr_pending;
+    uint32_t stops;
+} RegDevice_t;
+
+static uint8_t reg_start(void *ctx, uint8_t read) {
+    RegDevice_t *dev = (RegDevice_t *)ctx;
+    dev->ptr_pending = !read;
+    return 1;
+}
+
+static uint8_t reg_write(void *ctx, uint8_t byte) {
+    RegDevice_t *dev = (RegDevice_t *)ctx;
+    if (dev->ptr_pending) {
+        dev->ptr_pending = 0;
+        dev->ptr = byte & 0x0F;
+    } else {
+        dev->regs[dev->ptr] = byte;
+        dev->ptr = (dev->ptr + 1) & 0x0F;
+    }
+    return 1;
+}
+
+static uint8_t reg_read(void *ctx) {
+    RegDevice_t *dev = (RegDevice_t *)ctx;
+    uint8_t value = dev->regs[dev->ptr];
+    dev->ptr = (dev->ptr + 1) & 0x0F;
+    return value;
+}
+
+static void reg_stop(void *ctx) {
+    ((RegDevice_t *)ctx)->stops++;
+}
+
+static void reg_device_init(RegDevice_t *dev, uint8_t address) {
+    memset(dev, 0, sizeof(RegDevice_t));
+    dev->device.address = address;
+    dev->device.ctx = dev;
+    dev->device.start = reg_start;
+    dev->device.write = reg_write;
+    dev->device.read = reg_read;
+    dev->device.stop = reg_stop;
+}
+
+// Sample source: a counter, so the order and bit layout of FIFO data can be checked
+static void counter_source(void *ctx, uint64_t t_us, uint32_t *red, uint32_t *ir) {
+    uint32_t *n = (uint32_t *)ctx;
+    (void)t_us;
+    *red = 0x10000u + *n;
+    *ir = 0x3FFFFu - *n;
+    (*n)++;
+}
+
+static void test_soft_i2c_decoder(void) {
+    printf("=== Soft I2C Decoder Test ===\n");
+    static RegDevice_t dev;
+    PlatformSim_Reset();
+    reg_device_init(&dev, 0x42);
+    CHECK(PlatformSim_Attach(PLATFORM_SIM_SOFT_I2C, &dev.device) == 0);
+    CHECK(PlatformSim_Attach(PLATFORM_SIM_SOFT_I2C, &dev.device) != 0);   // address taken
+    Soft_I2C_Init();
+
+    CHECK(Soft_I2C_Write_Reg(0x42, 0x03, 0xA5) == 0);
+    assert(dev.regs[3] == 0xA5);
+    assert(dev.stops == 1);
+
+    uint8_t value = 0;
+    CHECK(Soft_I2C_Read_Reg(0x42, 0x03, &value) == 0);
+    assert(value == 0xA5);
+
+    for (uint8_t i = 0; i < 16; i++) {
+        dev.regs[i] = (uint8_t)(0x80 | i);
+    }
+    uint8_t buf[6];
+    CHECK(Soft_I2C_Read_Regs(0x42, 0x05, buf, 6) == 0);
+    for (uint8_t i = 0; i < 6; i++) {
+        assert(buf[i] == (0x80 | (5 + i)));
+    }
+
+    // Single-byte transfers without a register address
+    CHECK(Soft_I2C_Write_Byte(0x42, 0x07) == 0);
+    CHECK(Soft_I2C_Read_Byte(0x42, &value) == 0);
+    assert(value == 0x87);
+
+    // Nobody at this address: NACK, and the bus is idle again afterwards
+    I2CSim_Bus_t *bus = PlatformSim_GetBus(PLATFORM_SIM_SOFT_I2C);
+    uint32_t nacks = bus->nacks;
+    CHECK(Soft_I2C_Write_Reg(0x21, 0x00, 0x00) == 1);
+    CHECK(Soft_I2C_Read_Reg(0x21, 0x00, &value) == 1);
+    assert(bus->nacks == nacks + 2);
+    assert(bus->phase == I2C_SIM_IDLE);
+    CHECK(Soft_I2C_Read_Reg(0x42, 0x03, &value) == 0 && value == 0x83);
+
+    // Bit-banged at 5 us per half period: time advances with every transfer
+    assert(PlatformSim_GetUs() > 0);
+    printf("  %u transfers, %u bytes, %.2f ms virtual time\n",
+           bus->transfers, bus->bytes, (double)PlatformSim_GetUs() / 1000.0);
+    printf("  PASSED\n\n");
+}
+
+static void test_max30102_driver(void) {
+    printf("=== MAX30102 Driver Test ===\n");
+    static MAX30102Sim_t sensor;
+    uint32_t counter = 0;
+    PlatformSim_Reset();
+    MAX30102Sim_Init(&sensor, counter_source, &counter);
+    PlatformSim_Attach(PLATFORM_SIM_SOFT_I2C, &sensor.device);
+    Soft_I2C_Init();
+
+    CHECK(MAX30102_ReadPartID() == 0x15);
+    CHECK(MAX30102_Init() == 0);
+    assert(sensor.regs[REG_MODE_CONFIG] == 0x03);
+    assert(sensor.regs[REG_SPO2_CONFIG] == 0x27);
+
+    // 200 ms at 100 Hz, plus the time of the pointer read itself
+    Platform_DelayMs(200);
+    uint8_t lost = 0;
+    uint8_t count = MAX30102_GetFifoCount(&lost);
+    printf("  after 200 ms: %u samples in FIFO\n", count);
+    assert(count >= 19 && count <= 21);
+    assert(lost == 0);
+
+    static uint32_t red[MAX30102_FIFO_DEPTH];
+    static uint32_t ir[MAX30102_FIFO_DEPTH];
+    CHECK(MAX30102_ReadFifoBurst(red, ir, count) == count);
+    for (uint8_t i = 0; i < count; i++) {
+        assert(red[i] == 0x10000u + i);
+        assert(ir[i] == 0x3FFFFu - i);
+    }
+    assert(sensor.popped == count);
+
+    // Overflow: the FIFO holds 32 samples, the rest are counted as lost
+    Platform_DelayMs(500);
+    count = MAX30102_GetFifoCount(&lost);
+    printf("  after 500 ms more: %u in FIFO, %u lost\n", count, lost);
+    assert(count == MAX30102_FIFO_DEPTH);
+    assert(lost > 0 && lost == sensor.lost);
+
+    // Popping one sample clears the overflow counter
+    CHECK(MAX30102_ReadFifoBurst(red, ir, 1) == 1);
+    count = MAX30102_GetFifoCount(&lost);
+    assert(lost == 0);
+    assert(count >= MAX30102_FIFO_DEPTH - 1);
+    printf("  PASSED\n\n");
+}
+
+static volatile int irq_count = 0;
+
+static void irq_handler(void) {
+    irq_count++;
+}
+
+static void test_time_and_exti(void) {
+    printf("=== Virtual Time and EXTI Test ===\n");
+    PlatformSim_Reset();
+    Platform_DelayUs(1500);
+    assert(Platform_GetUs() == 1500);
+    assert(Platform_GetTickMs() == 1);
+    Platform_DelayMs(10);
+    assert(Platform_GetUs() == 11500);
+    assert(Platform_GetTickMs() == 11);
+
+    Platform_EXTI_SetHandler(PLATFORM_PIN_SENSOR_INT, irq_handler);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 1);
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, 0);     // falling edge
+    assert(irq_count == 1);
+    CHECK(Platform_GPIO_Read(PLATFORM_PIN_SENSOR_INT) == 0);
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, 0);     // still low: no edge
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, 1);     // rising edge: no interrupt
+    assert(irq_count == 1);
+
+    // Deferred while interrupts are masked, delivered when the critical section ends
+    Platform_EnterCritical();
+    Platform_EnterCritical();
+    PlatformSim_SetPin(PLATFORM_PIN_SENSOR_INT, 0);
+    assert(irq_count == 1);
+    Platform_ExitCritical();
+    assert(irq_count == 1);
+    Platform_ExitCritical();
+    assert(irq_count == 2);
+    printf("  PASSED\n\n");
+}
+
+static void test_hw_i2c_oled(void) {
+    printf("=== Hardware I2C / OLED Test ===\n");
+    static OLEDSim_t oled;
+    PlatformSim_Reset();
+    OLEDSim_Init(&oled);
+    PlatformSim_Attach(PLATFORM_SIM_HW_I2C, &oled.device);
+
+    // Contrast (two-byte command) must not be taken as a column address
+    const uint8_t contrast[] = { 0x00, 0x81 };
+    const uint8_t contrast_value[] = { 0x00, 0x05 };
+    const uint8_t page[] = { 0x00, 0xB3 };
+    const uint8_t col_lo[] = { 0x00, 0x02 };
+    const uint8_t col_hi[] = { 0x00, 0x10 };
+    const uint8_t data[] = { 0x40, 0x01, 0x80 };
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, contrast, 2, 1) == 0);
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, contrast_value, 2, 1) == 0);
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, page, 2, 1) == 0);
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, col_lo, 2, 1) == 0);
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, col_hi, 2, 1) == 0);
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, data, 3, 1) == 0);
+    assert(OLEDSim_GetPixel(&oled, 0, 24) == 1);        // page 3, bit 0
+    assert(OLEDSim_GetPixel(&oled, 1, 31) == 1);        // page 3, bit 7
+    assert(OLEDSim_GetPixel(&oled, 0, 25) == 0);
+
+    // 400 kHz: address byte plus payload, 9 clocks each
+    uint64_t before = PlatformSim_GetUs();
+    CHECK(Platform_I2C_Write(OLED_SIM_ADDRESS, data, 3, 1) == 0);
+    assert(PlatformSim_GetUs() - before == 90);         // (1 + 3) * 9 / 400 kHz
+
+    // No device at this address
+    CHECK(Platform_I2C_Write(0x3C, data, 3, 1) == 1);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Platform Simulation Test Harness ===\n\n");
+
+    test_soft_i2c_decoder();
+    test_max30102_driver();
+    test_time_and_exti();
+    test_hw_i2c_oled();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
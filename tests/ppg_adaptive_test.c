@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "ppg_filter.h"
+#include "ppg_algorithm.h"
+#include "ppg_algorithm_v2.h"
+#include "ppg_adaptive.h"
+#include "ppg_synth.h"
+
+#define UPDATE          250             // samples per display update, 2.5 s at 100 Hz
+#define NOISY_FROM      9000            // 90 s clean, 90 s motion, 120 s clean
+#define NOISY_TO        18000
+#define SAMPLES         30000
+
+// Method 1 as the device runs it, the selector and its DPT, and a DPT that
+// always transforms, to check the shadow against
+typedef struct {
+    PPGSynth_t clean;
+    PPGSynth_t noisy;
+    PPG_FilterState_t red_filter;
+    PPG_FilterState_t ir_filter;
+    HR_State_t hr;
+    PPG_Adaptive_t selector;
+    DPT_State_t dpt;
+    DPT_State_t reference;
+} Pipeline_t;
+
+static Pipeline_t p;
+
+// Same patient twice, one with motion artifacts and heavy noise; the input
+// switches between them, both running all the time
+static void pipeline_init(float hr_bpm) {
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.hr_bpm = hr_bpm;
+    PPGSynth_Init(&p.clean, &cfg, 7);
+    cfg.motion_per_min = 20.0f;
+    cfg.motion_amp = 5.0f;
+    cfg.noise_sd = 200.0f;
+    PPGSynth_Init(&p.noisy, &cfg, 7);
+    PPG_Filter_Init(&p.red_filter);
+    PPG_Filter_Init(&p.ir_filter);
+    HR_Init(&p.hr);
+    PPG_Adaptive_Init(&p.selector);
+    DPT_Init(&p.dpt);
+    DPT_Init(&p.reference);
+}
+
+// One sample; at the end of an update, the engine for the next one
+static int pipeline_step(uint32_t i, uint8_t noisy_phase, uint8_t *engine) {
+    uint32_t red, ir, red2, ir2;
+    PPGSynth_Truth_t truth;
+    PPGSynth_Next(&p.clean, &red, &ir, &truth);
+    PPGSynth_Next(&p.noisy, &red2, &ir2, &truth);
+    if (noisy_phase && i >= NOISY_FROM && i < NOISY_TO) {
+        red = red2;
+        ir = ir2;
+    }
+    PPG_Filter_Process(&p.red_filter, red);
+    float ac = PPG_Filter_Process(&p.ir_filter, ir);
+    HR_AddSample(&p.hr, ac, PPG_Filter_GetDC(&p.ir_filter));
+    PPG_Adaptive_Process(&p.selector, &p.dpt, red, ir);
+    DPT_Process(&p.reference, red, ir);
+    if ((i + 1) % UPDATE != 0) {
+        return 0;
+    }
+    HR_Calculate(&p.hr);
+    *engine = PPG_Adaptive_Update(&p.selector, &p.hr, &p.dpt);
+    return 1;
+}
+
+// The shadow fills the buffer exactly as DPT_Process does
+static void assert_same_buffer(const DPT_Transform_t *a, const DPT_Transform_t *b) {
+    assert(a->buffer_index == b->buffer_index && a->buffer_full == b->buffer_full);
+    assert(memcmp(a->recursive_buffer, b->recursive_buffer, sizeof(a->recursive_buffer)) == 0);
+}
+
+// Clean, motion, clean: Method 1 by default, DPT through the motion, back after
+static void test_phases(void) {
+    printf("=== Phases Test ===\n");
+    pipeline_init(90.0f);
+    uint8_t engine = PPG_ADAPTIVE_METHOD1, previous = PPG_ADAPTIVE_METHOD1;
+    uint32_t dpt_updates_clean = 0, dpt_updates_noisy = 0, escalated_at = 0;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        if (!pipeline_step(i, 1, &engine)) {
+            continue;
+        }
+        if (engine == PPG_ADAPTIVE_DPT && previous == PPG_ADAPTIVE_METHOD1) {
+            // Warm: the buffer is the reference's, and a rate comes with the next update
+            assert_same_buffer(&p.dpt.ir_dpt, &p.reference.ir_dpt);
+            assert_same_buffer(&p.dpt.red_dpt, &p.reference.red_dpt);
+            escalated_at = i + 1;
+        }
+        if (escalated_at != 0 && i + 1 == escalated_at + UPDATE && engine == PPG_ADAPTIVE_DPT) {
+            assert(DPT_IsHeartRateValid(&p.dpt));
+        }
+        if (engine == PPG_ADAPTIVE_DPT) {
+            if (i >= NOISY_FROM + 2 * UPDATE && i < NOISY_TO) {
+                dpt_updates_noisy++;
+            } else if (i >= 3000 && i < NOISY_FROM) {
+                dpt_updates_clean++;        // after the start, before the motion
+            }
+        }
+        previous = engine;
+    }
+    const PPG_Adaptive_t *a = &p.selector;
+    printf("  %.1f%% of samples on DPT, %u escalations, %u back; DPT on %u of %u motion updates\n",
+           100.0 * a->samples[PPG_ADAPTIVE_DPT] / SAMPLES, a->escalations, a->deescalations,
+           dpt_updates_noisy, (NOISY_TO - NOISY_FROM) / UPDATE - 2);
+    assert(a->samples[PPG_ADAPTIVE_METHOD1] + a->samples[PPG_ADAPTIVE_DPT] == SAMPLES);
+    assert(dpt_updates_clean == 0);
+    assert(dpt_updates_noisy >= (NOISY_TO - NOISY_FROM) / UPDATE / 4);   // the gaps between artifacts go back
+    assert(a->escalations >= 1 && a->deescalations == a->escalations);
+    assert(PPG_Adaptive_GetEngine(a) == PPG_ADAPTIVE_METHOD1);
+    assert(a->samples[PPG_ADAPTIVE_METHOD1] > SAMPLES / 2);
+    assert(a->held == 0);
+    printf("  PASSED\n\n");
+}
+
+// Below ~80 bpm Method 1 has no rate: DPT as soon as its buffer is full, for good
+static void test_low_rate(void) {
+    printf("=== Low Rate Test ===\n");
+    pipeline_init(60.0f);
+    uint8_t engine = PPG_ADAPTIVE_METHOD1;
+    uint32_t first_dpt = 0;
+    for (uint32_t i = 0; i < SAMPLES / 5; i++) {
+        if (pipeline_step(i, 0, &engine) && engine == PPG_ADAPTIVE_DPT && first_dpt == 0) {
+            first_dpt = i + 1;
+        }
+        if (first_dpt != 0 && i + 1 == first_dpt + UPDATE) {
+            assert(DPT_IsHeartRateValid(&p.dpt));
+            printf("  DPT from %.1f s, %.1f bpm at %.1f s\n", first_dpt / 100.0, DPT_GetHeartRate(&p.dpt),
+                   (i + 1) / 100.0);
+        }
+    }
+    assert(first_dpt == DPT_BUFFER_SIZE);
+    assert(p.selector.escalations == 1 && p.selector.deescalations == 0);
+    printf("  PASSED\n\n");
+}
+
+// No escalation while the caller says no; the first update allowed escalates
+static void test_held(void) {
+    printf("=== Held Test ===\n");
+    pipeline_init(60.0f);
+    p.selector.may_escalate = 0;
+    uint8_t engine = PPG_ADAPTIVE_METHOD1;
+    uint32_t i = 0;
+    for (; i < 2000; i++) {
+        if (pipeline_step(i, 0, &engine)) {
+            assert(engine == PPG_ADAPTIVE_METHOD1);
+        }
+    }
+    assert(p.selector.held == (2000 - DPT_BUFFER_SIZE) / UPDATE + 1);
+    assert(p.selector.escalations == 0 && p.selector.samples[PPG_ADAPTIVE_DPT] == 0);
+    p.selector.may_escalate = 1;
+    while (!pipeline_step(i++, 0, &engine)) {
+    }
+    assert(engine == PPG_ADAPTIVE_DPT && p.selector.escalations == 1);
+    printf("  %u updates held\n", p.selector.held);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Adaptive Selection Test ===\n\n");
+
+    test_phases();
+    test_low_rate();
+    test_held();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
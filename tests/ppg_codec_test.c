@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "../Core/Inc/ppg_codec.h"
+#include "../Core/Inc/telemetry.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_SAMPLES      60000      // 10 minutes @ 100Hz
+#define STREAM_CAPACITY   (TEST_SAMPLES * 8)
+
+// Captured UART byte stream
+static uint8_t stream[STREAM_CAPACITY];
+static size_t stream_len = 0;
+
+static uint32_t src_red[TEST_SAMPLES];
+static uint32_t src_ir[TEST_SAMPLES];
+static uint32_t out_red[TEST_SAMPLES];
+static uint32_t out_ir[TEST_SAMPLES];
+static uint8_t out_valid[TEST_SAMPLES];
+
+static void capture_tx(const uint8_t *data, uint16_t len) {
+    assert(stream_len + len <= STREAM_CAPACITY);
+    memcpy(&stream[stream_len], data, len);
+    stream_len += len;
+}
+
+static float gauss_noise(void) {
+    float u1 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+    float u2 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+// Finger-on-sensor style signal: large DC, ~1% pulsatile AC, slow wander, ADC noise
+static void generate_signal(uint32_t n, float noise_lsb) {
+    float phase = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float t = i / 100.0f;
+        float hr_hz = (72.0f + 6.0f * sinf(2.0f * (float)M_PI * 0.01f * t)) / 60.0f;
+        phase += 2.0f * (float)M_PI * hr_hz / 100.0f;
+        float pulse = sinf(phase) + 0.35f * sinf(2.0f * phase + 0.8f);
+        float wander = 300.0f * sinf(2.0f * (float)M_PI * 0.2f * t);
+
+        float red = 110000.0f + wander - 900.0f * pulse + noise_lsb * gauss_noise();
+        float ir = 140000.0f + 1.2f * wander - 1400.0f * pulse + noise_lsb * gauss_noise();
+        src_red[i] = (uint32_t)fmaxf(0.0f, fminf(262143.0f, red));
+        src_ir[i] = (uint32_t)fmaxf(0.0f, fminf(262143.0f, ir));
+    }
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Decode the captured stream the same way host/apps/ppg_capture_decode.c does
+static uint32_t decode_stream(uint32_t n) {
+    static TLM_Parser_t parser;
+    PPG_Decoder_t dec;
+    uint32_t expected = 0;
+    uint32_t decoded = 0;
+
+    TLM_Parser_Init(&parser);
+    PPG_Decoder_Init(&dec);
+    memset(out_valid, 0, sizeof(out_valid));
+
+    for (size_t i = 0; i < stream_len; i++) {
+        if (!TLM_Parser_Feed(&parser, stream[i]) || parser.type != TLM_TYPE_RAW_PPG) {
+            continue;
+        }
+        uint32_t index = read_le32(parser.payload);
+        uint8_t blocks = parser.payload[4];
+        if (index != expected) {
+            PPG_Decoder_Init(&dec);
+        }
+        uint16_t pos = PPG_CAPTURE_FRAME_HEADER;
+        for (uint8_t b = 0; b < blocks; b++) {
+            uint32_t red[PPG_CODEC_BLOCK_SIZE], ir[PPG_CODEC_BLOCK_SIZE];
+            uint8_t count = 0;
+            int16_t used = PPG_Decoder_DecodeBlock(&dec, &parser.payload[pos],
+                                                   (uint16_t)(parser.len - pos), red, ir, &count);
+            assert(used > 0);
+            pos = (uint16_t)(pos + used);
+            if (dec.synced) {
+                for (uint8_t s = 0; s < count; s++) {
+                    assert(index + s < n);
+                    out_red[index + s] = red[s];
+                    out_ir[index + s] = ir[s];
+                    out_valid[index + s] = 1;
+                    decoded++;
+                }
+            }
+            index += count;
+        }
+        assert(pos == parser.len);
+        expected = index;
+    }
+    return decoded;
+}
+
+static void capture_all(uint32_t n) {
+    PPG_Capture_t cap;
+    stream_len = 0;
+    TLM_Init(capture_tx);
+    PPG_Capture_Init(&cap);
+    for (uint32_t i = 0; i < n; i++) {
+        PPG_Capture_Push(&cap, src_red[i], src_ir[i]);
+    }
+    PPG_Capture_Flush(&cap);
+    assert(cap.samples_out == n);
+}
+
+static void test_lossless_roundtrip(void) {
+    printf("=== Lossless Round-Trip Test ===\n");
+
+    const float noise_levels[] = { 2.0f, 8.0f, 30.0f };
+    for (int k = 0; k < 3; k++) {
+        generate_signal(TEST_SAMPLES, noise_levels[k]);
+        capture_all(TEST_SAMPLES);
+
+        uint32_t decoded = decode_stream(TEST_SAMPLES);
+        assert(decoded == TEST_SAMPLES);
+        for (uint32_t i = 0; i < TEST_SAMPLES; i++) {
+            assert(out_red[i] == src_red[i]);
+            assert(out_ir[i] == src_ir[i]);
+        }
+
+        double packed_bytes = TEST_SAMPLES * 2.0 * PPG_CODEC_SAMPLE_BITS / 8.0;
+        double fifo_bytes = TEST_SAMPLES * 2.0 * 3.0;   // MAX30102 FIFO format, 3 bytes/sample
+        double ratio_fifo = fifo_bytes / (double)stream_len;
+        printf("  noise %5.1f LSB: %zu bytes on the wire, %.2f bits/sample, "
+               "%.2fx vs packed 18-bit, %.2fx vs 3-byte FIFO samples\n",
+               noise_levels[k], stream_len, stream_len * 8.0 / (2.0 * TEST_SAMPLES),
+               packed_bytes / (double)stream_len, ratio_fifo);
+        // Clean finger signals must shrink at least 3x including framing
+        if (noise_levels[k] <= 2.0f) {
+            assert(ratio_fifo >= 3.0);
+        }
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_extreme_values(void) {
+    printf("=== Extreme Value Test ===\n");
+
+    // Full-scale random samples and rail-to-rail steps force the escape path
+    for (uint32_t i = 0; i < 4096; i++) {
+        if (i < 2048) {
+            src_red[i] = (uint32_t)rand() & PPG_CODEC_SAMPLE_MASK;
+            src_ir[i] = (uint32_t)rand() & PPG_CODEC_SAMPLE_MASK;
+        } else {
+            src_red[i] = (i & 1) ? PPG_CODEC_SAMPLE_MASK : 0;
+            src_ir[i] = (i & 2) ? 0 : PPG_CODEC_SAMPLE_MASK;
+        }
+    }
+    capture_all(4096);
+    CHECK(decode_stream(4096) == 4096);
+    for (uint32_t i = 0; i < 4096; i++) {
+        assert(out_red[i] == src_red[i]);
+        assert(out_ir[i] == src_ir[i]);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_resync_after_corruption(void) {
+    printf("=== Resync After Corruption Test ===\n");
+
+    generate_signal(TEST_SAMPLES, 8.0f);
+    capture_all(TEST_SAMPLES);
+
+    // Corrupt one byte in the middle and insert some text noise: one frame
+    // fails CRC, the decoder must resume at the next keyframe
+    stream[stream_len / 2] ^= 0x5A;
+
+    uint32_t decoded = decode_stream(TEST_SAMPLES);
+    uint32_t lost = TEST_SAMPLES - decoded;
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++) {
+        if (out_valid[i]) {
+            assert(out_red[i] == src_red[i]);
+            assert(out_ir[i] == src_ir[i]);
+        }
+    }
+    printf("  lost %u samples after one corrupt byte\n", lost);
+    assert(lost > 0);
+    assert(lost <= (PPG_CODEC_KEYFRAME_INTERVAL + PPG_CAPTURE_BLOCKS_PER_FRAME) * PPG_CODEC_BLOCK_SIZE);
+    printf("  PASSED\n\n");
+}
+
+static void test_partial_block(void) {
+    printf("=== Partial Block Test ===\n");
+
+    generate_signal(37, 4.0f);
+    capture_all(37);
+    CHECK(decode_stream(37) == 37);
+    for (uint32_t i = 0; i < 37; i++) {
+        assert(out_red[i] == src_red[i]);
+        assert(out_ir[i] == src_ir[i]);
+    }
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== PPG Codec Test Harness ===\n\n");
+    srand(1234);
+
+    test_lossless_roundtrip();
+    test_extreme_values();
+    test_resync_after_corruption();
+    test_partial_block();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
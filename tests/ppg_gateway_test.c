@@ -0,0 +1,610 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "check.h"
+#include "ppg_gateway.h"
+#include "gateway_api.h"
+#include "ppg_score.h"
+
+#define STREAMS         6
+#define SECONDS         60.0
+#define ROUND_SAMPLES   200         // pushed per stream before waiting for the workers
+#define MAX_EVENTS      64          // per stream and variant
+#define SOCKET_PATH     "ppg_gateway_test.sock"
+#define CHECKPOINT_PATH "ppg_gateway_test.ckpt"
+#define RESTART_SAMPLES 3123        // per stream before the restart, mid update and mid DPT window
+
+typedef struct {
+    uint32_t count;
+    uint64_t sample[MAX_EVENTS];
+    PPGVariant_Output_t out[MAX_EVENTS];
+} Events_t;
+
+static PPGScore_Record_t records[STREAMS];
+static Events_t serial[STREAMS][PPG_GATEWAY_MAX_VARIANTS];
+static Events_t gateway[STREAMS][PPG_GATEWAY_MAX_VARIANTS];
+static Events_t adaptive_serial[STREAMS];
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static PPGGateway_t *create_from(uint32_t workers, uint8_t filter_batch, const char *checkpoint,
+                                 ShmRing_Seg_t *ingest, uint8_t state_arena) {
+    PPGGateway_Config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.streams = STREAMS;
+    cfg.workers = workers;
+    cfg.variants[0] = PPGVariant_Find("m1");
+    cfg.variants[1] = PPGVariant_Find("m2");
+    cfg.variant_count = 2;
+    cfg.sample_rate_hz = 100.0f;
+    cfg.tick_us = 2000;
+    cfg.pin = 1;
+    cfg.filter_batch = filter_batch;
+    cfg.checkpoint_path = checkpoint;
+    cfg.checkpoint_interval_ms = 20;
+    cfg.ingest = ingest;
+    cfg.state_arena = state_arena;
+    PPGGateway_t *gw = PPGGateway_Create(&cfg);
+    assert(gw != NULL);
+    CHECK(PPGGateway_Start(gw) == 0);
+    return gw;
+}
+
+static PPGGateway_t *create(uint32_t workers, uint8_t filter_batch, const char *checkpoint) {
+    return create_from(workers, filter_batch, checkpoint, NULL, 0);
+}
+
+static void wait_processed(PPGGateway_t *gw, uint32_t stream, uint64_t samples) {
+    PPGGateway_StreamStats_t s;
+    for (int k = 0; k < 10000; k++) {
+        CHECK(PPGGateway_GetStreamStats(gw, stream, &s) == 0);
+        if (s.samples == samples) {
+            return;
+        }
+        sleep_ms(1);
+    }
+    assert(0 && "workers did not drain the stream");
+}
+
+static void collect(PPGGateway_t *gw) {
+    PPGGateway_Event_t ev[256];
+    uint32_t n;
+    while ((n = PPGGateway_PollEvents(gw, ev, 256)) > 0) {
+        for (uint32_t k = 0; k < n; k++) {
+            Events_t *e = &gateway[ev[k].stream][ev[k].variant];
+            assert(e->count < MAX_EVENTS);
+            e->sample[e->count] = ev[k].sample;
+            e->out[e->count++] = ev[k].out;
+        }
+    }
+}
+
+// Field by field: the padding of an output is not part of it
+static int same_output(const PPGVariant_Output_t *a, const PPGVariant_Output_t *b) {
+    return memcmp(&a->hr_bpm, &b->hr_bpm, sizeof(float)) == 0 && memcmp(&a->spo2, &b->spo2, sizeof(float)) == 0 &&
+           a->hr_valid == b->hr_valid && a->spo2_valid == b->spo2_valid;
+}
+
+// ---- Histogram buckets and percentiles ----
+
+static void test_histogram(void) {
+    printf("=== Latency Histogram Test ===\n");
+    static PPGGateway_Hist_t h;
+    memset(&h, 0, sizeof(h));
+    assert(PPGGateway_HistPercentile(&h, 99.0) == 0);
+    // 1 .. 1000 us
+    for (uint64_t us = 1; us <= 1000; us++) {
+        PPGGateway_HistRecord(&h, us * 1000);
+    }
+    uint64_t p50 = PPGGateway_HistPercentile(&h, 50.0);
+    uint64_t p99 = PPGGateway_HistPercentile(&h, 99.0);
+    uint64_t p100 = PPGGateway_HistPercentile(&h, 100.0);
+    printf("  p50 %.1f us, p99 %.1f us, max %.1f us\n", p50 / 1e3, p99 / 1e3, p100 / 1e3);
+    // Upper bucket edge: never below the true value, at most one bucket (~19%) above
+    assert(p50 >= 500000 && p50 <= 500000 * 1.2);
+    assert(p99 >= 990000 && p99 <= 1000000);
+    assert(p100 == 1000000);
+
+    // Tiny and huge values land in the first and last buckets
+    memset(&h, 0, sizeof(h));
+    PPGGateway_HistRecord(&h, 0);
+    assert(PPGGateway_HistPercentile(&h, 50.0) == 0);
+    PPGGateway_HistRecord(&h, UINT64_MAX / 2);
+    assert(PPGGateway_HistPercentile(&h, 100.0) == UINT64_MAX / 2);
+    printf("  PASSED\n\n");
+}
+
+// ---- Every stream gives what the variant gives on its own ----
+
+static void run_streams(uint8_t filter_batch, uint8_t state_arena) {
+    memset(gateway, 0, sizeof(gateway));
+    PPGGateway_t *gw = create_from(2, filter_batch, NULL, NULL, state_arena);
+    assert(PPGGateway_GetConfig(gw)->workers == 2);
+    CHECK(PPGGateway_Push(gw, STREAMS, 0, 0, 0) == -1);
+    // Interleaved across streams, in rounds that fit the rings; stream s runs
+    // 5 x s samples ahead, so the batched filters see uneven streams
+    uint32_t pushed[STREAMS] = { 0 };
+    for (uint32_t first = 0; first < records[0].count; first += ROUND_SAMPLES) {
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            uint64_t now = PPGGateway_NowNs();
+            for (; pushed[s] < first + ROUND_SAMPLES + 5 * s && pushed[s] < records[s].count; pushed[s]++) {
+                uint32_t i = pushed[s];
+                CHECK(PPGGateway_Push(gw, s, records[s].red[i], records[s].ir[i], now) == 0);
+            }
+        }
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            wait_processed(gw, s, pushed[s]);
+        }
+        collect(gw);
+    }
+
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        for (uint32_t v = 0; v < 2; v++) {
+            const Events_t *a = &serial[s][v], *b = &gateway[s][v];
+            assert(a->count == SECONDS * 100 / PPG_VARIANT_UPDATE_SAMPLES && b->count == a->count);
+            for (uint32_t k = 0; k < a->count; k++) {
+                assert(a->sample[k] == b->sample[k]);
+                assert(same_output(&a->out[k], &b->out[k]));
+            }
+            PPGVariant_Output_t latest;
+            uint64_t sample;
+            CHECK(PPGGateway_GetOutput(gw, s, v, &latest, &sample) == 0);
+            assert(sample == a->sample[a->count - 1]);
+            assert(same_output(&latest, &a->out[a->count - 1]));
+        }
+    }
+    CHECK(PPGGateway_GetOutput(gw, 0, 2, NULL, NULL) == -1);
+
+    PPGGateway_Stats_t st;
+    PPGGateway_GetStats(gw, &st);
+    printf("  %u streams on %u workers%s%s: %llu samples, %llu events, %.1f%% busy, p99 %.1f us, "
+           "worst stream p99 %.1f us\n", st.streams, st.workers, filter_batch ? " (batched filters)" : "",
+           state_arena ? " (state arena)" : "", (unsigned long long)st.samples,
+           (unsigned long long)st.events, 100.0 * st.utilisation, st.latency_p99_ns / 1e3,
+           st.stream_p99_max_ns / 1e3);
+    assert(st.samples == STREAMS * records[0].count);
+    assert(st.dropped == 0 && st.events_dropped == 0);
+    assert(st.events == STREAMS * 2 * serial[0][0].count);
+    assert(st.latency_p99_ns > 0 && st.stream_p99_median_ns <= st.stream_p99_max_ns);
+    assert(st.ticks > 0);
+    assert(st.llc_counted || st.llc_misses == 0);
+
+    // A full ring drops (and counts) instead of blocking the device
+    PPGGateway_Stop(gw);
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < PPG_GATEWAY_RING_SAMPLES + 10; i++) {
+        accepted += (PPGGateway_Push(gw, 0, 1000, 1000, PPGGateway_NowNs()) == 0);
+    }
+    PPGGateway_StreamStats_t ss;
+    CHECK(PPGGateway_GetStreamStats(gw, 0, &ss) == 0);
+    assert(accepted == PPG_GATEWAY_RING_SAMPLES && ss.dropped == 10);
+    PPGGateway_Destroy(gw);
+}
+
+static void test_streams(void) {
+    printf("=== Independent Streams Test ===\n");
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        CHECK(PPGScore_SynthesisePatient(&records[s], 1 + s, SECONDS) == 0);
+        for (uint32_t v = 0; v < 2; v++) {
+            const PPGVariant_t *variant = PPGVariant_Get(v);
+            void *state = malloc(variant->state_size);
+            assert(state != NULL);
+            variant->init(state, records[s].sample_rate_hz);
+            Events_t *e = &serial[s][v];
+            for (uint32_t i = 0; i < records[s].count; i++) {
+                PPGVariant_Output_t out;
+                if (variant->process(state, records[s].red[i], records[s].ir[i], &out)) {
+                    e->sample[e->count] = i + 1;
+                    e->out[e->count++] = out;
+                }
+            }
+            free(state);
+        }
+    }
+
+    for (uint8_t filter_batch = 0; filter_batch <= 1; filter_batch++) {
+        run_streams(filter_batch, 0);
+    }
+    // The layout before the state pools gives the same
+    run_streams(0, 1);
+    printf("  PASSED\n\n");
+}
+
+// ---- Checkpoint and restart ----
+
+// Push stream s up to sample until[s], in rounds that fit the rings, collecting events
+static void feed(PPGGateway_t *gw, uint32_t *pushed, const uint32_t *until) {
+    for (;;) {
+        int more = 0;
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            uint64_t now = PPGGateway_NowNs();
+            for (uint32_t k = 0; k < ROUND_SAMPLES && pushed[s] < until[s]; k++, pushed[s]++) {
+                uint32_t i = pushed[s];
+                CHECK(PPGGateway_Push(gw, s, records[s].red[i], records[s].ir[i], now) == 0);
+            }
+            more |= (pushed[s] < until[s]);
+        }
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            wait_processed(gw, s, pushed[s]);
+        }
+        collect(gw);
+        if (!more) {
+            return;
+        }
+    }
+}
+
+static void run_restart(uint8_t filter_batch) {
+    memset(gateway, 0, sizeof(gateway));
+    unlink(CHECKPOINT_PATH);
+    uint32_t pushed[STREAMS] = { 0 }, until[STREAMS];
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        until[s] = RESTART_SAMPLES;
+    }
+    PPGGateway_t *gw = create(2, filter_batch, CHECKPOINT_PATH);
+    PPGGateway_Stats_t st;
+    PPGGateway_GetStats(gw, &st);
+    assert(st.restored == 0);
+    feed(gw, pushed, until);
+    PPGGateway_Stop(gw);
+    PPGGateway_GetStats(gw, &st);
+    // Periodic snapshots (every 20 ms) plus one of every stream at Stop
+    assert(st.checkpoint_errors == 0 && st.checkpoints > STREAMS);
+    uint64_t checkpoints = st.checkpoints;
+    PPGGateway_Destroy(gw);
+
+    // The last stream's slot torn: that stream alone starts over
+    int fd = open(CHECKPOINT_PATH, O_RDWR);
+    assert(fd >= 0);
+    off_t size = lseek(fd, 0, SEEK_END);
+    off_t slot = (size - PPG_GATEWAY_CHECKPOINT_HEADER) / STREAMS;
+    uint8_t byte;
+    off_t at = PPG_GATEWAY_CHECKPOINT_HEADER + (STREAMS - 1) * slot + 100;
+    CHECK(pread(fd, &byte, 1, at) == 1);
+    byte ^= 0x40;
+    CHECK(pwrite(fd, &byte, 1, at) == 1);
+    close(fd);
+
+    // Restarted, every stream resumes: the events of both runs are those of one
+    gw = create(2, filter_batch, CHECKPOINT_PATH);
+    PPGGateway_GetStats(gw, &st);
+    assert(st.restored == STREAMS - 1);
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        PPGGateway_StreamStats_t ss;
+        CHECK(PPGGateway_GetStreamStats(gw, s, &ss) == 0);
+        assert(ss.samples == (s < STREAMS - 1 ? RESTART_SAMPLES : 0));
+        until[s] = records[s].count;
+    }
+    pushed[STREAMS - 1] = 0;
+    memset(gateway[STREAMS - 1], 0, sizeof(gateway[STREAMS - 1]));
+    feed(gw, pushed, until);
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        for (uint32_t v = 0; v < 2; v++) {
+            const Events_t *a = &serial[s][v], *b = &gateway[s][v];
+            assert(b->count == a->count);
+            for (uint32_t k = 0; k < a->count; k++) {
+                assert(a->sample[k] == b->sample[k]);
+                assert(same_output(&a->out[k], &b->out[k]));
+            }
+        }
+    }
+    PPGGateway_Destroy(gw);
+
+    // A checkpoint of another configuration is not restored
+    gw = create(2, !filter_batch, CHECKPOINT_PATH);
+    PPGGateway_GetStats(gw, &st);
+    assert(st.restored == 0);
+    PPGGateway_Destroy(gw);
+    unlink(CHECKPOINT_PATH);
+    printf("  restart%s: %u of %u streams resumed at sample %u, %llu snapshots written before it\n",
+           filter_batch ? " (batched filters)" : "", STREAMS - 1, STREAMS, RESTART_SAMPLES,
+           (unsigned long long)checkpoints);
+}
+
+static void test_checkpoint(void) {
+    printf("=== Checkpoint Restart Test ===\n");
+    for (uint8_t filter_batch = 0; filter_batch <= 1; filter_batch++) {
+        run_restart(filter_batch);
+    }
+    printf("  PASSED\n\n");
+}
+
+// ---- Adaptive variant: what it gives on its own, engine shares, escalations held by load ----
+
+static void run_adaptive(float escalation_load, PPG_Adaptive_t *expected) {
+    memset(gateway, 0, sizeof(gateway));
+    PPGGateway_Config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.streams = STREAMS;
+    cfg.workers = 2;
+    cfg.variants[0] = PPGVariant_Find("ad");
+    cfg.variant_count = 1;
+    cfg.sample_rate_hz = 100.0f;
+    cfg.tick_us = 2000;
+    cfg.escalation_load = escalation_load;
+    PPGGateway_t *gw = PPGGateway_Create(&cfg);
+    CHECK(gw != NULL && PPGGateway_Start(gw) == 0);
+    uint32_t pushed[STREAMS] = { 0 }, until[STREAMS];
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        until[s] = records[s].count;
+    }
+    feed(gw, pushed, until);
+
+    PPGGateway_Stats_t st;
+    PPGGateway_GetStats(gw, &st);
+    printf("  escalation load %.2g: %.1f%% of samples on DPT, %llu escalations, %llu back, %llu held\n",
+           escalation_load, 100.0 * st.engine_samples[PPG_ADAPTIVE_DPT] / st.samples,
+           (unsigned long long)st.escalations, (unsigned long long)st.deescalations,
+           (unsigned long long)st.escalations_held);
+    assert(st.engine_samples[PPG_ADAPTIVE_METHOD1] + st.engine_samples[PPG_ADAPTIVE_DPT] == st.samples);
+    if (expected != NULL) {
+        // No load limit: every stream as the variant runs it alone
+        uint64_t dpt = 0, escalations = 0;
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            const Events_t *a = &adaptive_serial[s], *b = &gateway[s][0];
+            assert(b->count == a->count);
+            for (uint32_t k = 0; k < a->count; k++) {
+                assert(a->sample[k] == b->sample[k] && same_output(&a->out[k], &b->out[k]));
+            }
+            dpt += expected[s].samples[PPG_ADAPTIVE_DPT];
+            escalations += expected[s].escalations;
+        }
+        assert(st.engine_samples[PPG_ADAPTIVE_DPT] == dpt && st.escalations == escalations);
+        assert(st.escalations_held == 0);
+    } else {
+        // Every tick over the limit: nothing escalates
+        assert(st.engine_samples[PPG_ADAPTIVE_DPT] == 0 && st.escalations == 0);
+        assert(st.escalations_held > 0);
+    }
+    PPGGateway_Destroy(gw);
+}
+
+static void test_adaptive(void) {
+    printf("=== Adaptive Variant Test ===\n");
+    const PPGVariant_t *variant = PPGVariant_Find("ad");
+    assert(variant != NULL && variant->adaptive != NULL && PPGVariant_Find("m1")->adaptive == NULL);
+    PPG_Adaptive_t expected[STREAMS];
+    uint64_t dpt = 0;
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        void *state = malloc(variant->state_size);
+        assert(state != NULL);
+        variant->init(state, records[s].sample_rate_hz);
+        Events_t *e = &adaptive_serial[s];
+        for (uint32_t i = 0; i < records[s].count; i++) {
+            PPGVariant_Output_t out;
+            if (variant->process(state, records[s].red[i], records[s].ir[i], &out)) {
+                e->sample[e->count] = i + 1;
+                e->out[e->count++] = out;
+            }
+        }
+        expected[s] = *variant->adaptive(state);
+        dpt += expected[s].samples[PPG_ADAPTIVE_DPT];
+        free(state);
+    }
+    assert(dpt > 0);                // some of the patients need DPT
+
+    run_adaptive(0.0f, expected);
+    run_adaptive(1e-9f, NULL);
+    printf("  PASSED\n\n");
+}
+
+// ---- Shared-memory ingestion from another process ----
+
+// The acquisition process: every stream's record into its ring, in batches
+// written in place, interleaved across streams, waiting whenever a ring is full
+static void acquisition_main(ShmRing_Seg_t *seg) {
+    uint32_t sent[STREAMS] = { 0 };
+    for (int more = 1; more;) {
+        more = 0;
+        for (uint32_t s = 0; s < STREAMS; s++) {
+            ShmRing_t *r = ShmRing_Get(seg, s);
+            uint32_t pos;
+            uint32_t n = (records[s].count - sent[s] < 25) ? records[s].count - sent[s] : 25;
+            n = ShmRing_Reserve(r, n, &pos);
+            for (uint32_t k = 0; k < n; k++) {
+                ShmRing_Frame_t *f = ShmRing_Frame(r, pos + k);
+                f->red = records[s].red[sent[s] + k];
+                f->ir = records[s].ir[sent[s] + k];
+                f->t_ns = PPGGateway_NowNs();
+            }
+            if (n > 0) {
+                ShmRing_Commit(r, pos, n);
+            }
+            sent[s] += n;
+            more |= (sent[s] < records[s].count);
+        }
+        sleep_ms(1);
+    }
+}
+
+static void run_ingest(uint8_t filter_batch) {
+    memset(gateway, 0, sizeof(gateway));
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, STREAMS, 512, 0) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        acquisition_main(&seg);
+        _exit(0);
+    }
+    PPGGateway_t *gw = create_from(2, filter_batch, NULL, &seg, 0);
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        PPGGateway_StreamStats_t ss;
+        for (int k = 0; k < 20000; k++) {
+            collect(gw);
+            CHECK(PPGGateway_GetStreamStats(gw, s, &ss) == 0);
+            if (ss.samples == records[s].count) {
+                break;
+            }
+            sleep_ms(1);
+        }
+        assert(ss.samples == records[s].count && ss.dropped == 0);
+    }
+    collect(gw);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        for (uint32_t v = 0; v < 2; v++) {
+            const Events_t *a = &serial[s][v], *b = &gateway[s][v];
+            assert(b->count == a->count);
+            for (uint32_t k = 0; k < a->count; k++) {
+                assert(a->sample[k] == b->sample[k]);
+                assert(same_output(&a->out[k], &b->out[k]));
+            }
+        }
+    }
+    PPGGateway_Stats_t st;
+    PPGGateway_GetStats(gw, &st);
+    printf("  shared memory%s: %llu samples from another process, %llu events, p99 %.1f us\n",
+           filter_batch ? " (batched filters)" : "", (unsigned long long)st.samples,
+           (unsigned long long)st.events, st.latency_p99_ns / 1e3);
+    PPGGateway_Destroy(gw);
+    ShmRing_Detach(&seg);
+}
+
+static void test_ingest(void) {
+    printf("=== Shared-memory Ingestion Test ===\n");
+    ShmRing_Seg_t small;
+    CHECK(ShmRing_Create(&small, STREAMS - 1, 64, 0) == 0);
+    PPGGateway_Config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.streams = STREAMS;
+    cfg.variants[0] = PPGVariant_Find("m1");
+    cfg.variant_count = 1;
+    cfg.sample_rate_hz = 100.0f;
+    cfg.tick_us = 2000;
+    cfg.ingest = &small;
+    CHECK(PPGGateway_Create(&cfg) == NULL);         // a ring per stream
+    ShmRing_Detach(&small);
+    for (uint8_t filter_batch = 0; filter_batch <= 1; filter_batch++) {
+        run_ingest(filter_batch);
+    }
+    printf("  PASSED\n\n");
+}
+
+// ---- Socket API ----
+
+static int read_line(int fd, char *line, size_t size) {
+    size_t n = 0;
+    while (n + 1 < size) {
+        char ch;
+        ssize_t r = read(fd, &ch, 1);
+        if (r <= 0) {
+            return -1;
+        }
+        if (ch == '\n') {
+            break;
+        }
+        line[n++] = ch;
+    }
+    line[n] = '\0';
+    return 0;
+}
+
+static void send_line(int fd, const char *line) {
+    CHECK(write(fd, line, strlen(line)) == (ssize_t)strlen(line));
+}
+
+static void test_socket_api(void) {
+    printf("=== Socket API Test ===\n");
+    PPGGateway_t *gw = create(1, 0, NULL);
+    GatewayApi_t *api = GatewayApi_Start(gw, SOCKET_PATH);
+    assert(api != NULL);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_PATH);
+    CHECK(fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    char line[512];
+
+    // No output yet
+    send_line(fd, "GET 2\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strcmp(line, "OUT 2 m1 0 0.0 0 0.0 0") == 0);
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strncmp(line, "OUT 2 m2 0 ", 11) == 0);
+    send_line(fd, "GET 6\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strcmp(line, "ERR no such stream") == 0);
+    send_line(fd, "HELLO\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strcmp(line, "ERR unknown command") == 0);
+
+    // Subscribe to one stream and feed two: only its events arrive
+    send_line(fd, "SUB 2\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strcmp(line, "OK") == 0);
+    uint32_t samples = 2 * PPG_VARIANT_UPDATE_SAMPLES;
+    for (uint32_t first = 0; first < samples; first += ROUND_SAMPLES) {
+        for (uint32_t s = 1; s <= 2; s++) {
+            for (uint32_t i = first; i < first + ROUND_SAMPLES && i < samples; i++) {
+                CHECK(PPGGateway_Push(gw, s, records[s].red[i], records[s].ir[i], PPGGateway_NowNs()) == 0);
+            }
+            wait_processed(gw, s, first + ROUND_SAMPLES < samples ? first + ROUND_SAMPLES : samples);
+        }
+    }
+    uint32_t ev = 0;
+    while (ev < 4) {
+        CHECK(read_line(fd, line, sizeof(line)) == 0);
+        assert(strncmp(line, "EV 2 m", 6) == 0);
+        ev++;
+    }
+    printf("  last event: %s\n", line);
+    assert(strstr(line, " 500 ") != NULL);
+    send_line(fd, "UNSUB\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strcmp(line, "OK") == 0);
+
+    send_line(fd, "GET 2\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strncmp(line, "OUT 2 m1 500 ", 13) == 0);
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    send_line(fd, "LAT 2\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    printf("  %s\n", line);
+    assert(strncmp(line, "LAT 2 samples=500 dropped=0 ", 28) == 0);
+    send_line(fd, "STATS\n");
+    CHECK(read_line(fd, line, sizeof(line)) == 0);
+    assert(strncmp(line, "STATS streams=6 workers=1 samples=1000 dropped=0 ", 49) == 0);
+    send_line(fd, "QUIT\n");
+    CHECK(read_line(fd, line, sizeof(line)) == -1);
+    close(fd);
+
+    GatewayApi_Stats_t stats;
+    GatewayApi_GetStats(api, &stats);
+    assert(stats.connections == 1 && stats.events_sent == 4 && stats.events_dropped == 0);
+    assert(stats.events == 8);
+    GatewayApi_Stop(api);
+    assert(access(SOCKET_PATH, F_OK) != 0);
+    PPGGateway_Destroy(gw);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Gateway Test ===\n\n");
+
+    test_histogram();
+    test_streams();
+    test_checkpoint();
+    test_adaptive();
+    test_ingest();
+    test_socket_api();
+
+    for (uint32_t s = 0; s < STREAMS; s++) {
+        PPGScore_FreeRecord(&records[s]);
+    }
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
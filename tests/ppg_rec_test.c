@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include "check.h"
+#include "ppg_rec.h"
+#include "ppg_score.h"
+#include "ppg_synth.h"
+
+#define PATH        "ppg_rec_test.ppgrec"
+#define SAMPLES     10000
+#define CHUNK       1000
+
+static uint32_t red_at(uint64_t i) { return 100000u + (uint32_t)((i * 37u) % 5000u); }
+static uint32_t ir_at(uint64_t i) { return 120000u + (uint32_t)((i * 53u) % 7000u); }
+
+static void test_crc(void) {
+    printf("=== CRC-32 Test ===\n");
+    assert(PPGRec_Crc32(0, "123456789", 9) == 0xCBF43926u);
+    // Chained in two parts
+    assert(PPGRec_Crc32(PPGRec_Crc32(0, "1234", 4), "56789", 5) == 0xCBF43926u);
+    printf("  PASSED\n\n");
+}
+
+static void write_file(uint8_t encoding, uint8_t channels, int finish) {
+    PPGRec_Header_t h;
+    PPGRec_DefaultHeader(&h, 100.0f);
+    h.encoding = encoding;
+    h.channels = channels;
+    h.chunk_samples = CHUNK;
+    snprintf(h.device_id, sizeof(h.device_id), "unit-7");
+    static PPGRec_Writer_t w;
+    CHECK(PPGRec_Create(&w, PATH, &h) == 0);
+    for (uint64_t i = 0; i < SAMPLES; i++) {
+        PPGRec_Reference_t ref = { 60.0f + (float)(i % 100), 97.0f, (uint8_t)(i % 100 == 0) };
+        CHECK(PPGRec_Append(&w, red_at(i), ir_at(i), &ref) == 0);
+    }
+    if (finish) {
+        CHECK(PPGRec_Finish(&w) == 0);
+    } else {
+        // Recording still running: full chunks are on disk, the tail is not
+        fclose(w.f);
+        free(w.red); free(w.ir); free(w.ref_hr); free(w.ref_spo2); free(w.flags); free(w.payload); free(w.index);
+    }
+}
+
+static void check_all(const PPGRec_Reader_t *r, int zero_copy) {
+    static uint32_t red_buf[CHUNK], ir_buf[CHUNK];
+    uint64_t pos = 0;
+    for (uint32_t k = 0; k < r->chunk_count; k++) {
+        PPGRec_Chunk_t c;
+        CHECK(PPGRec_GetChunk(r, k, &c, red_buf, ir_buf) == 0);
+        assert(PPGRec_VerifyChunk(r, k) == 0);
+        assert(c.first_sample == pos && c.count == CHUNK);
+        assert(c.timestamp_us == pos * 10000u);
+        if (zero_copy) {
+            assert((const uint8_t *)c.red > r->map && (const uint8_t *)c.red < r->map + r->size);
+        } else {
+            assert(c.red == red_buf);
+        }
+        for (uint32_t i = 0; i < c.count; i++) {
+            assert(c.red[i] == red_at(pos + i) && c.ir[i] == ir_at(pos + i));
+        }
+        pos += c.count;
+    }
+}
+
+static void test_round_trip(void) {
+    printf("=== Round Trip Test ===\n");
+    const uint8_t encodings[2] = { PPG_REC_ENC_PLAIN, PPG_REC_ENC_CODEC };
+    for (int e = 0; e < 2; e++) {
+        write_file(encodings[e], PPG_REC_CH_REF_HR | PPG_REC_CH_REF_SPO2 | PPG_REC_CH_FLAGS, 1);
+        PPGRec_Reader_t r;
+        assert(PPGRec_IsRecording(PATH));
+        CHECK(PPGRec_Open(&r, PATH) == 0);
+        assert(r.complete && r.chunk_count == SAMPLES / CHUNK && r.total_samples == SAMPLES);
+        assert(strcmp(r.header->device_id, "unit-7") == 0);
+        assert(r.header->sensor.spo2_config == 0x27 && r.header->calibration.spo2_c > 94.0f);
+        check_all(&r, encodings[e] == PPG_REC_ENC_PLAIN);
+
+        PPGRec_Chunk_t c;
+        static uint32_t red_buf[CHUNK], ir_buf[CHUNK];
+        CHECK(PPGRec_GetChunk(&r, 3, &c, red_buf, ir_buf) == 0);
+        assert(c.ref_hr[5] == 65.0f && c.ref_spo2[0] == 97.0f && c.flags[0] == 1 && c.flags[1] == 0);
+        printf("  %s: %zu bytes, %.2f bytes per sample pair (with references)\n",
+               e ? "codec" : "plain", r.size, (double)r.size / SAMPLES);
+        PPGRec_Close(&r);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_seek_and_gaps(void) {
+    printf("=== Seek / Gap Test ===\n");
+    PPGRec_Header_t h;
+    PPGRec_DefaultHeader(&h, 100.0f);
+    h.chunk_samples = CHUNK;
+    static PPGRec_Writer_t w;
+    CHECK(PPGRec_Create(&w, PATH, &h) == 0);
+    // 0..2499, lost 2500..2999, 3000..5999, lost 6000..6009, 6010..9009
+    for (uint64_t i = 0; i < 2500; i++) CHECK(PPGRec_Append(&w, red_at(i), ir_at(i), NULL) == 0);
+    CHECK(PPGRec_Gap(&w, 3000) == 0);
+    for (uint64_t i = 3000; i < 6000; i++) CHECK(PPGRec_Append(&w, red_at(i), ir_at(i), NULL) == 0);
+    CHECK(PPGRec_Gap(&w, 6010) == 0);
+    CHECK(PPGRec_Gap(&w, 6005) != 0);              // backwards
+    for (uint64_t i = 6010; i < 9010; i++) CHECK(PPGRec_Append(&w, red_at(i), ir_at(i), NULL) == 0);
+    CHECK(PPGRec_Finish(&w) == 0);
+
+    PPGRec_Reader_t r;
+    CHECK(PPGRec_Open(&r, PATH) == 0);
+    assert(r.total_samples == 8500);
+    // 1000 1000 500 | 1000 1000 1000 | 1000 1000 1000
+    assert(r.chunk_count == 9);
+    assert(r.index[2].count == 500 && r.index[3].first_sample == 3000 && r.index[6].first_sample == 6010);
+    assert(r.index[3].timestamp_us == 30000000u);
+
+    // Position -> chunk: direct while chunks are full, searched after the short one
+    assert(PPGRec_FindChunk(&r, 0) == 0);
+    assert(PPGRec_FindChunk(&r, 1999) == 1);
+    assert(PPGRec_FindChunk(&r, 2499) == 2);
+    assert(PPGRec_FindChunk(&r, 2500) == 3);
+    assert(PPGRec_FindChunk(&r, 8499) == 8);
+    assert(PPGRec_FindChunk(&r, 8500) == -1);
+
+    // Range read across the gap: stored samples back to back
+    uint32_t red[600], ir[600];
+    CHECK(PPGRec_Read(&r, 2200, 600, red, ir) == 600);
+    assert(red[0] == red_at(2200) && red[299] == red_at(2499) && red[300] == red_at(3000));
+    assert(ir[599] == ir_at(3299));
+    CHECK(PPGRec_Read(&r, 8400, 600, red, ir) == 100);
+    PPGRec_Close(&r);
+    printf("  PASSED\n\n");
+}
+
+static void test_recovery(void) {
+    printf("=== Cut-Short Recording Test ===\n");
+    // Writer still running: no index yet, the full chunks are readable
+    write_file(PPG_REC_ENC_CODEC, 0, 0);
+    PPGRec_Reader_t r;
+    CHECK(PPGRec_Open(&r, PATH) == 0);
+    assert(!r.complete && r.chunk_count == SAMPLES / CHUNK && r.total_samples == SAMPLES);
+    check_all(&r, 0);
+    PPGRec_Close(&r);
+
+    // Torn last chunk: dropped
+    write_file(PPG_REC_ENC_PLAIN, 0, 0);
+    FILE *f = fopen(PATH, "rb");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    CHECK(truncate(PATH, size - 100) == 0);
+    CHECK(PPGRec_Open(&r, PATH) == 0);
+    assert(!r.complete && r.chunk_count == SAMPLES / CHUNK - 1);
+    check_all(&r, 1);
+    PPGRec_Close(&r);
+
+    // Flipped payload byte in a complete file: found by verify
+    write_file(PPG_REC_ENC_PLAIN, 0, 1);
+    CHECK(PPGRec_Open(&r, PATH) == 0);
+    uint64_t offset = r.index[4].offset + sizeof(PPGRec_ChunkHeader_t) + 10;
+    PPGRec_Close(&r);
+    f = fopen(PATH, "r+b");
+    fseek(f, (long)offset, SEEK_SET);
+    fputc(0x5A, f);
+    fclose(f);
+    CHECK(PPGRec_Open(&r, PATH) == 0 && r.complete);
+    assert(PPGRec_VerifyChunk(&r, 3) == 0 && PPGRec_VerifyChunk(&r, 4) != 0);
+    PPGRec_Close(&r);
+
+    // Not a recording
+    f = fopen(PATH, "w");
+    fprintf(f, "index,red,ir\n0,1,2\n");
+    fclose(f);
+    assert(!PPGRec_IsRecording(PATH));
+    CHECK(PPGRec_Open(&r, PATH) != 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_wide_samples(void) {
+    printf("=== Codec Fallback Test ===\n");
+    PPGRec_Header_t h;
+    PPGRec_DefaultHeader(&h, 50.0f);
+    h.chunk_samples = 100;
+    static PPGRec_Writer_t w;
+    CHECK(PPGRec_Create(&w, PATH, &h) == 0);
+    for (uint32_t i = 0; i < 300; i++) {
+        // Second chunk does not fit 18 bits: stored plain
+        uint32_t red = (i >= 100 && i < 200) ? 0x40000u + i : 1000u + i;
+        CHECK(PPGRec_Append(&w, red, 2000u + i, NULL) == 0);
+    }
+    assert(w.codec_fallbacks == 1);
+    CHECK(PPGRec_Finish(&w) == 0);
+    PPGRec_Reader_t r;
+    CHECK(PPGRec_Open(&r, PATH) == 0);
+    uint32_t red[300], ir[300];
+    CHECK(PPGRec_Read(&r, 0, 300, red, ir) == 300);
+    assert(red[99] == 1099 && red[150] == 0x40000u + 150 && red[299] == 1299 && ir[299] == 2299);
+    assert(r.index[1].timestamp_us == 2000000u);
+    PPGRec_Close(&r);
+    printf("  PASSED\n\n");
+}
+
+static void test_score_load(void) {
+    printf("=== Scoring Load Test ===\n");
+    // Synthetic record with its beats, through a container and back
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    PPGScore_Record_t src;
+    CHECK(PPGScore_Synthesise(&src, &cfg, 5, 60.0, 0.0f) == 0);
+    PPGRec_Header_t h;
+    PPGRec_DefaultHeader(&h, src.sample_rate_hz);
+    h.channels = PPG_REC_CH_REF_SPO2 | PPG_REC_CH_FLAGS;
+    static PPGRec_Writer_t w;
+    CHECK(PPGRec_Create(&w, PATH, &h) == 0);
+    uint32_t beat = 0;
+    for (uint32_t i = 0; i < src.count; i++) {
+        PPGRec_Reference_t ref = { 0.0f, src.ref_spo2[i], 0 };
+        if (beat < src.beat_count && src.beats[beat] == i) {
+            ref.flags = PPG_SYNTH_FLAG_BEAT;
+            beat++;
+        }
+        CHECK(PPGRec_Append(&w, src.red[i], src.ir[i], &ref) == 0);
+    }
+    CHECK(PPGRec_Finish(&w) == 0);
+
+    PPGScore_Record_t rec;
+    CHECK(PPGScore_LoadFile(&rec, PATH, 1.0f) == 0);
+    assert(rec.count == src.count && rec.sample_rate_hz == 100.0f && rec.beat_count == src.beat_count);
+    assert(memcmp(rec.red, src.red, src.count * sizeof(uint32_t)) == 0);
+    assert(memcmp(rec.ir, src.ir, src.count * sizeof(uint32_t)) == 0);
+    assert(memcmp(rec.ref_hr, src.ref_hr, src.count * sizeof(float)) == 0);
+    assert(rec.ref_spo2[src.count - 1] == src.ref_spo2[src.count - 1]);
+    assert(strcmp(rec.name, PATH) == 0);
+    PPGScore_FreeRecord(&rec);
+    PPGScore_FreeRecord(&src);
+    remove(PATH);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Recording Container Test ===\n\n");
+
+    test_crc();
+    test_round_trip();
+    test_seek_and_gaps();
+    test_recovery();
+    test_wide_samples();
+    test_score_load();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "check.h"
+#include "ppg_score.h"
+
+#define RATE_HZ 100
+
+// Fake variant: shows the record's reference HR from delay_s ago plus a bias
+static const PPGScore_Record_t *fake_rec;
+static double fake_delay_s;
+static float fake_bias;
+static uint32_t fake_valid_from;
+
+typedef struct {
+    uint32_t index;
+} Fake_State_t;
+
+static void fake_init(void *state, float sample_rate_hz) {
+    (void)sample_rate_hz;
+    ((Fake_State_t *)state)->index = 0;
+}
+
+static uint8_t fake_process(void *state, uint32_t red, uint32_t ir, PPGVariant_Output_t *out) {
+    Fake_State_t *s = (Fake_State_t *)state;
+    (void)red;
+    (void)ir;
+    uint32_t i = s->index++;
+    if ((i + 1) % PPG_VARIANT_UPDATE_SAMPLES != 0) {
+        return 0;
+    }
+    int64_t j = (int64_t)i - (int64_t)(fake_delay_s * RATE_HZ);
+    out->hr_bpm = (j >= 0 ? fake_rec->ref_hr[j] : 0.0f) + fake_bias;
+    out->hr_valid = (i >= fake_valid_from) && j >= 0 && fake_rec->ref_hr[j] > 0.0f;
+    out->spo2 = 97.0f;
+    out->spo2_valid = 1;
+    return 1;
+}
+
+static const PPGVariant_t fake_variant = {
+    .name = "fake",
+    .description = "delayed reference",
+    .state_size = sizeof(Fake_State_t),
+    .init = fake_init,
+    .process = fake_process,
+};
+
+// Beats at a rate ramping from 60 to 90 bpm between 100 s and 200 s
+static void ramp_record(PPGScore_Record_t *rec, uint32_t seconds) {
+    CHECK(PPGScore_AllocRecord(rec, seconds * RATE_HZ, seconds * 4) == 0);
+    double t = 0.5;
+    while (t * RATE_HZ < rec->count) {
+        rec->beats[rec->beat_count++] = (uint32_t)(t * RATE_HZ + 0.5);
+        double hr = (t < 100.0) ? 60.0 : (t < 200.0) ? 60.0 + 30.0 * (t - 100.0) / 100.0 : 90.0;
+        t += 60.0 / hr;
+    }
+    for (uint32_t i = 0; i < rec->count; i++) {
+        rec->red[i] = 100000;
+        rec->ir[i] = 120000;
+        rec->ref_spo2[i] = 97.5f;
+    }
+    PPGScore_ReferenceFromBeats(rec, PPG_SCORE_REF_WINDOW_S);
+}
+
+static void test_reference(void) {
+    printf("=== Beat Reference Test ===\n");
+    PPGScore_Record_t rec;
+    ramp_record(&rec, 300);
+    assert(rec.ref_hr[0] == 0.0f);                  // before the second beat
+    assert(fabsf(rec.ref_hr[50 * RATE_HZ] - 60.0f) < 0.5f);
+    assert(fabsf(rec.ref_hr[290 * RATE_HZ] - 90.0f) < 0.5f);
+    // Trailing window: lags the instantaneous rate by about half the window
+    float mid = rec.ref_hr[150 * RATE_HZ];
+    printf("  ref at 150 s: %.2f bpm (instantaneous 75)\n", mid);
+    assert(mid > 72.0f && mid < 75.0f);
+    PPGScore_FreeRecord(&rec);
+    printf("  PASSED\n\n");
+}
+
+static void test_fake_variant(void) {
+    printf("=== Metrics Test ===\n");
+    PPGScore_Record_t rec;
+    ramp_record(&rec, 300);
+    fake_rec = &rec;
+
+    // Exact copy: no error, full coverage from the first update, no lag
+    PPGScore_Result_t r;
+    PPGScore_Summary_t s;
+    fake_delay_s = 0.0;
+    fake_bias = 0.0f;
+    fake_valid_from = 0;
+    CHECK(PPGScore_Run(&fake_variant, &rec, &r) == 0);
+    PPGScore_Summarise(&r.hr, &s);
+    assert(r.hr.updates == 300 * RATE_HZ / PPG_VARIANT_UPDATE_SAMPLES);
+    assert(s.mae < 1e-6 && fabs(s.bias) < 1e-6 && s.coverage_pct == 100.0);
+    assert(s.first_valid_s >= 2.0 && s.first_valid_s < 3.0);
+    assert(s.lag_s >= 0.0 && s.lag_s < 0.3);
+
+    // 12 s late and 2 bpm high: lag, bias and limits of agreement
+    fake_delay_s = 12.0;
+    fake_bias = 2.0f;
+    fake_valid_from = 30 * RATE_HZ;
+    CHECK(PPGScore_Run(&fake_variant, &rec, &r) == 0);
+    PPGScore_Summarise(&r.hr, &s);
+    printf("  delayed 12 s +2 bpm: MAE %.2f, bias %+.2f, LoA %+.2f..%+.2f, cov %.1f %%, first %.1f s, lag %.2f s\n",
+           s.mae, s.bias, s.loa_low, s.loa_high, s.coverage_pct, s.first_valid_s, s.lag_s);
+    assert(fabs(s.lag_s - 12.0) <= 0.5);
+    assert(s.bias > 0.3 && s.bias < 1.2);           // on the rising ramp the delay pulls it down
+    assert(s.loa_low < s.bias && s.loa_high > s.bias);
+    assert(fabs(s.first_valid_s - 30.0) < 2.6);
+    assert(fabs(s.coverage_pct - 90.0) < 1.0);
+
+    // SpO2 is constant: no lag can be measured
+    PPGScore_Summarise(&r.spo2, &s);
+    assert(fabs(s.bias + 0.5) < 1e-3 && s.lag_s < 0.0);
+
+    // Pooling two records: errors over all points, times averaged over records
+    PPGScore_Metric_t total;
+    memset(&total, 0, sizeof(total));
+    PPGScore_Add(&total, &r.hr);
+    fake_delay_s = 0.0;
+    fake_bias = 0.0f;
+    fake_valid_from = 0;
+    CHECK(PPGScore_Run(&fake_variant, &rec, &r) == 0);
+    PPGScore_Add(&total, &r.hr);
+    PPGScore_Summarise(&total, &s);
+    assert(total.records == 2 && total.records_lag == 2);
+    assert(s.bias > 0.1 && s.bias < 0.6);
+    assert(s.lag_s > 5.5 && s.lag_s < 6.5);
+    PPGScore_FreeRecord(&rec);
+    printf("  PASSED\n\n");
+}
+
+static void test_csv(void) {
+    printf("=== Annotated CSV Test ===\n");
+    const char *path = "ppg_score_test.csv";
+    FILE *f = fopen(path, "w");
+    assert(f != NULL);
+    fprintf(f, "index,red,ir,hr,spo2,flags\n");
+    for (int i = 0; i < 3000; i++) {
+        int beat = (i % 75 == 10);                  // 80 bpm
+        fprintf(f, "%d,%d,%d,%.2f,%.1f,%d\n", i, 100000 + i, 120000 + i, 80.0, 96.0, beat ? 5 : 4);
+    }
+    fclose(f);
+
+    PPGScore_Record_t rec;
+    CHECK(PPGScore_LoadCsv(&rec, "does_not_exist.csv", RATE_HZ) != 0);
+    CHECK(PPGScore_LoadCsv(&rec, path, RATE_HZ) == 0);
+    remove(path);
+    assert(rec.count == 3000 && rec.red[2999] == 102999 && rec.ir[0] == 120000);
+    assert(rec.beat_count == 40 && rec.beats[1] == 85);
+    assert(rec.ref_spo2[100] == 96.0f);
+    assert(fabsf(rec.ref_hr[2000] - 80.0f) < 0.01f);
+    assert(strcmp(rec.name, "ppg_score_test.csv") == 0);
+    PPGScore_FreeRecord(&rec);
+
+    // Without beat flags the hr column is the reference
+    f = fopen(path, "w");
+    fprintf(f, "red,ir,hr\n1,2,70\n3,4,71\n");
+    fclose(f);
+    CHECK(PPGScore_LoadCsv(&rec, path, RATE_HZ) == 0);
+    remove(path);
+    assert(rec.count == 2 && rec.beat_count == 0 && rec.ref_hr[1] == 71.0f && rec.ref_spo2[0] == 0.0f);
+    PPGScore_FreeRecord(&rec);
+    printf("  PASSED\n\n");
+}
+
+static void test_real_variants(void) {
+    printf("=== Method 1 / Method 2 Test ===\n");
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.hr_bpm = 90.0f;
+    PPGScore_Record_t rec;
+    CHECK(PPGScore_Synthesise(&rec, &cfg, 3, 300.0, 110.0f) == 0);
+    assert(rec.beat_count > 400);
+
+    assert(PPGVariant_Count() >= 2);
+    assert(PPGVariant_Find("nope") == NULL);
+    for (uint32_t v = 0; v < PPGVariant_Count(); v++) {
+        const PPGVariant_t *variant = PPGVariant_Get(v);
+        PPGScore_Result_t r;
+        PPGScore_Summary_t hr, spo2;
+        CHECK(PPGScore_Run(variant, &rec, &r) == 0);
+        PPGScore_Summarise(&r.hr, &hr);
+        PPGScore_Summarise(&r.spo2, &spo2);
+        printf("  %s: HR MAE %.2f bias %+.2f cov %.1f %% first %.1f s lag %.1f s | SpO2 MAE %.2f cov %.1f %%\n",
+               variant->name, hr.mae, hr.bias, hr.coverage_pct, hr.first_valid_s, hr.lag_s,
+               spo2.mae, spo2.coverage_pct);
+        assert(hr.coverage_pct > 50.0 && hr.mae < 5.0);
+        assert(spo2.coverage_pct > 50.0 && spo2.mae < 2.0);
+    }
+    PPGScore_FreeRecord(&rec);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Scoring Harness Test ===\n\n");
+
+    test_reference();
+    test_fake_variant();
+    test_csv();
+    test_real_variants();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "ppg_state.h"
+#include "ppg_variant.h"
+#include "ppg_synth.h"
+
+#define RATE_HZ         100.0f
+#define CONTINUE        3000        // samples after the restore, 12 updates
+#define MAX_STATE       (64 * 1024)
+#define MAX_SNAPSHOT    (128 * 1024)
+
+static uint8_t state_a[MAX_STATE], state_b[MAX_STATE];
+static uint8_t blob[MAX_SNAPSHOT], blob2[MAX_SNAPSHOT];
+
+static void start_synth(PPGSynth_t *synth, uint64_t seed) {
+    PPGSynth_Config_t cfg;
+    PPGSynth_RandomPatient(&cfg, seed);
+    PPGSynth_Init(synth, &cfg, seed);
+}
+
+// Run a state for `skip` samples, save, load into a fresh state: the two must
+// be identical byte for byte and stay identical, output for output
+static size_t check_restore(const PPGVariant_t *v, uint32_t skip, uint64_t seed) {
+    PPGSynth_t synth;
+    start_synth(&synth, seed);
+    memset(state_a, 0xA5, v->state_size);
+    memset(state_b, 0x5A, v->state_size);
+    v->init(state_a, RATE_HZ);
+    v->init(state_b, RATE_HZ);
+    PPGVariant_Output_t out_a, out_b;
+    for (uint32_t i = 0; i < skip; i++) {
+        uint32_t red, ir;
+        PPGSynth_Next(&synth, &red, &ir, NULL);
+        v->process(state_a, red, ir, &out_a);
+    }
+    size_t n = v->save(state_a, blob, sizeof(blob));
+    assert(n > 0 && n < v->state_size);
+    CHECK(v->load(state_b, blob, n) == 0);
+    assert(memcmp(state_a, state_b, v->state_size) == 0);
+
+    uint32_t updates = 0;
+    for (uint32_t i = 0; i < CONTINUE; i++) {
+        uint32_t red, ir;
+        PPGSynth_Next(&synth, &red, &ir, NULL);
+        memset(&out_a, 0, sizeof(out_a));
+        memset(&out_b, 0, sizeof(out_b));
+        uint8_t ua = v->process(state_a, red, ir, &out_a);
+        uint8_t ub = v->process(state_b, red, ir, &out_b);
+        assert(ua == ub);
+        assert(memcmp(&out_a, &out_b, sizeof(out_a)) == 0);
+        updates += ua;
+    }
+    assert(updates == CONTINUE / PPG_VARIANT_UPDATE_SAMPLES);
+    assert(memcmp(state_a, state_b, v->state_size) == 0);
+    // And the snapshots of the two agree
+    CHECK(v->save(state_a, blob, sizeof(blob)) == v->save(state_b, blob2, sizeof(blob2)));
+    assert(memcmp(blob, blob2, v->save(state_a, blob, sizeof(blob))) == 0);
+    return n;
+}
+
+static void test_restore(void) {
+    printf("=== Restore Bit-identical Test ===\n");
+    // Empty, part-filled rings, DPT buffer one short of / just full, steady state
+    static const uint32_t points[] = { 0, 137, 999, 1000, 1234, 4321 };
+    for (uint32_t k = 0; k < PPGVariant_Count(); k++) {
+        const PPGVariant_t *v = PPGVariant_Get(k);
+        assert(v->state_size <= MAX_STATE && v->save != NULL && v->load != NULL);
+        for (uint32_t p = 0; p < sizeof(points) / sizeof(points[0]); p++) {
+            size_t n = check_restore(v, points[p], 40 + p);
+            printf("  %s after %4u samples: %5zu bytes (state %zu)\n", v->name, points[p], n, v->state_size);
+        }
+    }
+    printf("  PASSED\n\n");
+}
+
+// AC values beyond int16 (a step in the raw signal) fall back to int32 rings
+static void test_wide_ring(void) {
+    printf("=== Wide DPT Ring Test ===\n");
+    const PPGVariant_t *v = PPGVariant_Find("m2");
+    PPGVariant_Output_t out;
+    v->init(state_a, RATE_HZ);
+    for (uint32_t i = 0; i < 1500; i++) {
+        v->process(state_a, 100000, 100000, &out);
+    }
+    size_t flat = v->save(state_a, blob, sizeof(blob));
+    for (uint32_t i = 0; i < 50; i++) {
+        v->process(state_a, 250000, 250000, &out);     // +150000 step
+    }
+    size_t wide = v->save(state_a, blob, sizeof(blob));
+    assert(wide > flat + 2 * 1000 * 2 - 64);
+    v->init(state_b, RATE_HZ);
+    CHECK(v->load(state_b, blob, wide) == 0);
+    assert(memcmp(state_a, state_b, v->state_size) == 0);
+    printf("  %zu bytes with int16 rings, %zu with int32\n", flat, wide);
+    printf("  PASSED\n\n");
+}
+
+static void test_encoding(void) {
+    printf("=== Little-endian Encoding Test ===\n");
+    uint8_t buf[32];
+    PPGState_Writer_t w;
+    PPGState_WriterInit(&w, buf, sizeof(buf));
+    PPGState_PutU16(&w, 0x1122);
+    PPGState_PutU32(&w, 0x33445566u);
+    PPGState_PutF32(&w, 1.0f);
+    PPGState_PutU64(&w, 0x0102030405060708ull);
+    static const uint8_t expect[] = { 0x22, 0x11, 0x66, 0x55, 0x44, 0x33, 0x00, 0x00, 0x80, 0x3F,
+                                      0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+    assert(!w.error && w.len == sizeof(expect) && memcmp(buf, expect, sizeof(expect)) == 0);
+    PPGState_Reader_t r;
+    PPGState_ReaderInit(&r, buf, w.len);
+    CHECK(PPGState_GetU16(&r) == 0x1122 && PPGState_GetU32(&r) == 0x33445566u);
+    CHECK(PPGState_GetF32(&r) == 1.0f && PPGState_GetU64(&r) == 0x0102030405060708ull);
+    CHECK(!r.error && PPGState_GetU8(&r) == 0 && r.error);
+    // Out of room: nothing past the end, error set
+    PPGState_WriterInit(&w, buf, 3);
+    PPGState_PutU16(&w, 1);
+    PPGState_PutU16(&w, 2);
+    assert(w.error && w.len == 2);
+    printf("  PASSED\n\n");
+}
+
+static void test_invalid(void) {
+    printf("=== Invalid Snapshot Test ===\n");
+    const PPGVariant_t *v = PPGVariant_Find("m1");
+    PPGVariant_Output_t out;
+    v->init(state_a, RATE_HZ);
+    for (uint32_t i = 0; i < 700; i++) {
+        v->process(state_a, 100000 + (i % 97) * 13, 120000 + (i % 89) * 11, &out);
+    }
+    size_t n = v->save(state_a, blob, sizeof(blob));
+    CHECK(v->save(state_a, blob2, n - 1) == 0);                // too small
+    for (size_t cut = 0; cut < n; cut++) {                      // every truncation
+        v->init(state_b, RATE_HZ);
+        CHECK(v->load(state_b, blob, cut) == -1);
+    }
+    blob[1] = PPG_STATE_VERSION + 1;                            // another version
+    CHECK(v->load(state_b, blob, n) == -1);
+    blob[1] = PPG_STATE_VERSION;
+    blob[0] = 'H';                                              // another state
+    CHECK(v->load(state_b, blob, n) == -1);
+    printf("  PASSED\n\n");
+}
+
+static void test_stream(void) {
+    printf("=== Stream Snapshot Test ===\n");
+    const PPGVariant_t *variants[2] = { PPGVariant_Find("m1"), PPGVariant_Find("m2") };
+    static uint8_t m1_a[MAX_STATE], m2_a[MAX_STATE], m1_b[MAX_STATE], m2_b[MAX_STATE];
+    void *a[2] = { m1_a, m2_a }, *b[2] = { m1_b, m2_b };
+    PPGSynth_t synth;
+    start_synth(&synth, 7);
+    for (uint32_t k = 0; k < 2; k++) {
+        variants[k]->init(a[k], RATE_HZ);
+        variants[k]->init(b[k], RATE_HZ);
+    }
+    PPGVariant_Output_t out;
+    for (uint32_t i = 0; i < 1800; i++) {
+        uint32_t red, ir;
+        PPGSynth_Next(&synth, &red, &ir, NULL);
+        variants[0]->process(a[0], red, ir, &out);
+        variants[1]->process(a[1], red, ir, &out);
+    }
+    static const uint8_t extra[5] = { 1, 2, 3, 4, 5 };
+    size_t n = PPGState_SaveStream(blob, sizeof(blob), 42, 1800, variants, a, 2, extra, sizeof(extra));
+    assert(n > PPG_STATE_STREAM_HEADER);
+    CHECK(PPGState_SaveStream(blob2, n - 1, 42, 1800, variants, a, 2, extra, sizeof(extra)) == 0);
+
+    uint32_t id;
+    uint64_t samples;
+    const uint8_t *x;
+    uint32_t x_len;
+    CHECK(PPGState_LoadStream(blob, n, &id, &samples, variants, b, 2, &x, &x_len) == 0);
+    assert(id == 42 && samples == 1800 && x_len == 5 && memcmp(x, extra, 5) == 0);
+    assert(memcmp(m1_a, m1_b, variants[0]->state_size) == 0);
+    assert(memcmp(m2_a, m2_b, variants[1]->state_size) == 0);
+
+    // Variants in another order, a flipped bit, a short read
+    const PPGVariant_t *swapped[2] = { variants[1], variants[0] };
+    void *b_swapped[2] = { b[1], b[0] };
+    CHECK(PPGState_LoadStream(blob, n, &id, &samples, swapped, b_swapped, 2, NULL, NULL) == -1);
+    CHECK(PPGState_LoadStream(blob, n, &id, &samples, variants, b, 1, NULL, NULL) == -1);
+    blob[n / 2] ^= 0x10;
+    CHECK(PPGState_LoadStream(blob, n, &id, &samples, variants, b, 2, NULL, NULL) == -1);
+    blob[n / 2] ^= 0x10;
+    CHECK(PPGState_LoadStream(blob, n - 1, &id, &samples, variants, b, 2, NULL, NULL) == -1);
+    CHECK(PPGState_LoadStream(blob, n, &id, &samples, variants, b, 2, NULL, NULL) == 0);
+    printf("  m1 + m2 after 1800 samples: %zu bytes (states %zu)\n", n,
+           variants[0]->state_size + variants[1]->state_size);
+    printf("  PASSED\n\n");
+}
+
+int main(void) {
+    test_encoding();
+    test_restore();
+    test_wide_ring();
+    test_invalid();
+    test_stream();
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <math.h>
+#include "ppg_synth.h"
+#include "ppg_algorithm_v2.h"
+
+#define RATE_HZ 100
+
+static PPGSynth_t synth_a;
+static PPGSynth_t synth_b;
+
+// Clean signal: no variability, respiration, motion or noise
+static void quiet_config(PPGSynth_Config_t *cfg) {
+    PPGSynth_DefaultConfig(cfg);
+    cfg->hrv_sd = 0.0f;
+    cfg->rsa_depth = 0.0f;
+    cfg->mayer_depth = 0.0f;
+    cfg->resp_baseline = 0.0f;
+    cfg->resp_am = 0.0f;
+    cfg->noise_sd = 0.0f;
+}
+
+static float spo2_from_ratio(float r) {
+    return -45.06f * r * r + 30.354f * r + 94.845f;
+}
+
+static void test_determinism(void) {
+    printf("=== Determinism Test ===\n");
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.ectopic_prob = 0.05f;
+    cfg.motion_per_min = 4.0f;
+
+    // Sample by sample vs odd-sized chunks: identical streams
+    static uint32_t red[1000], ir[1000];
+    static PPGSynth_Truth_t truth[1000];
+    PPGSynth_Init(&synth_a, &cfg, 42);
+    PPGSynth_Init(&synth_b, &cfg, 42);
+    uint32_t done = 0;
+    while (done < 200000) {
+        uint32_t n = 1 + (done * 7) % 997;
+        PPGSynth_Generate(&synth_b, red, ir, truth, n);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t r, x;
+            PPGSynth_Truth_t t;
+            PPGSynth_Next(&synth_a, &r, &x, &t);
+            assert(r == red[i] && x == ir[i] && t.flags == truth[i].flags);
+        }
+        done += n;
+    }
+
+    // Another seed gives another stream
+    PPGSynth_Init(&synth_a, &cfg, 42);
+    PPGSynth_Init(&synth_b, &cfg, 43);
+    uint32_t same = 0;
+    for (int i = 0; i < 1000; i++) {
+        uint32_t r1, x1, r2, x2;
+        PPGSynth_Next(&synth_a, &r1, &x1, NULL);
+        PPGSynth_Next(&synth_b, &r2, &x2, NULL);
+        same += (x1 == x2);
+    }
+    assert(same < 50);
+
+    // Random patients are reproducible and plausible
+    PPGSynth_Config_t p1, p2;
+    PPGSynth_RandomPatient(&p1, 7);
+    PPGSynth_RandomPatient(&p2, 7);
+    assert(memcmp(&p1, &p2, sizeof(p1)) == 0);
+    for (uint64_t seed = 0; seed < 100; seed++) {
+        PPGSynth_RandomPatient(&p1, seed);
+        assert(p1.hr_bpm >= 50.0f && p1.hr_bpm <= 120.0f);
+        assert(p1.spo2 >= 90.0f && p1.spo2 <= 100.0f);
+        assert(p1.perfusion_index > 0.0f && p1.perfusion_index < 0.06f);
+    }
+    printf("  200000 samples match across chunkings\n");
+    printf("  PASSED\n\n");
+}
+
+static void test_morphology(void) {
+    printf("=== Pulse Morphology Test ===\n");
+    PPGSynth_Config_t cfg;
+    quiet_config(&cfg);
+    PPGSynth_Init(&synth_a, &cfg, 1);
+
+    // Template: foot at 0, systolic peak ~0.16, notch, then the diastolic wave
+    const float *t = synth_a.template_table;
+    int peak = 0;
+    for (int i = 0; i < PPG_SYNTH_TEMPLATE_SIZE; i++) {
+        if (t[i] > t[peak]) peak = i;
+    }
+    assert(t[0] == 0.0f);
+    assert(fabsf(t[peak] - 1.0f) < 1e-6f);
+    assert(peak > 0.10 * PPG_SYNTH_TEMPLATE_SIZE && peak < 0.22 * PPG_SYNTH_TEMPLATE_SIZE);
+    int notch = -1, diastolic = -1;
+    for (int i = peak + 1; i < PPG_SYNTH_TEMPLATE_SIZE - 1; i++) {
+        if (notch < 0 && t[i] < t[i - 1] && t[i] <= t[i + 1]) {
+            notch = i;
+        } else if (notch >= 0 && t[i] > t[i - 1] && t[i] >= t[i + 1]) {
+            diastolic = i;
+            break;
+        }
+    }
+    assert(notch > 0 && diastolic > notch);
+    assert(t[diastolic] > t[notch] && t[diastolic] < t[peak]);
+    printf("  peak %.2f, notch %.2f (%.2f), diastolic %.2f (%.2f)\n",
+           (double)peak / PPG_SYNTH_TEMPLATE_SIZE, (double)notch / PPG_SYNTH_TEMPLATE_SIZE, t[notch],
+           (double)diastolic / PPG_SYNTH_TEMPLATE_SIZE, t[diastolic]);
+
+    // Raw counts dip by perfusion_index * DC at systole and stay within it
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (int i = 0; i < 10 * RATE_HZ; i++) {
+        uint32_t r, x;
+        PPGSynth_Next(&synth_a, &r, &x, NULL);
+        if (x < lo) lo = x;
+        if (x > hi) hi = x;
+    }
+    float pp = cfg.perfusion_index * cfg.ir_dc;
+    assert(hi <= cfg.ir_dc + 1.0f);
+    assert(fabsf((float)(hi - lo) - pp) < 0.1f * pp);
+    printf("  PASSED\n\n");
+}
+
+static void test_heart_rate(void) {
+    printf("=== Beat Timing Test ===\n");
+    const float rates[] = { 45.0f, 72.0f, 130.0f, 180.0f };
+    for (unsigned k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        PPGSynth_Config_t cfg;
+        PPGSynth_DefaultConfig(&cfg);
+        cfg.hr_bpm = rates[k];
+        PPGSynth_Init(&synth_a, &cfg, 100 + k);
+
+        // 10 minutes: beat count and the RR variation around the mean
+        uint32_t beats = 0;
+        int64_t last = -1;
+        double sum = 0.0, sum_sq = 0.0;
+        for (int64_t i = 0; i < 600 * RATE_HZ; i++) {
+            uint32_t r, x;
+            PPGSynth_Truth_t truth;
+            PPGSynth_Next(&synth_a, &r, &x, &truth);
+            if (truth.flags & PPG_SYNTH_FLAG_BEAT) {
+                if (last >= 0) {
+                    double rr = (double)(i - last) / RATE_HZ;
+                    sum += rr;
+                    sum_sq += rr * rr;
+                    beats++;
+                }
+                last = i;
+            }
+        }
+        double mean = sum / beats;
+        double sd = sqrt(sum_sq / beats - mean * mean);
+        printf("  %.0f bpm: %u beats, mean RR %.3f s, SD %.1f ms\n", rates[k], beats, mean, sd * 1000.0);
+        assert(fabs(60.0 / mean - rates[k]) < 0.02 * rates[k]);
+        assert(sd > 0.005 * mean && sd < 0.1 * mean);
+    }
+
+    // Rate change takes effect from the next beat
+    PPGSynth_Config_t cfg;
+    quiet_config(&cfg);
+    PPGSynth_Init(&synth_a, &cfg, 5);
+    uint32_t beats_before = 0, beats_after = 0;
+    for (int i = 0; i < 120 * RATE_HZ; i++) {
+        uint32_t r, x;
+        PPGSynth_Truth_t truth;
+        if (i == 60 * RATE_HZ) {
+            PPGSynth_SetHeartRate(&synth_a, 120.0f);
+        }
+        PPGSynth_Next(&synth_a, &r, &x, &truth);
+        if (truth.flags & PPG_SYNTH_FLAG_BEAT) {
+            if (i < 60 * RATE_HZ) beats_before++; else beats_after++;
+        }
+    }
+    assert(abs((int)beats_before - 72) <= 1);
+    assert(abs((int)beats_after - 120) <= 1);
+    printf("  PASSED\n\n");
+}
+
+static void test_spo2(void) {
+    printf("=== SpO2 Ratio Test ===\n");
+    const float levels[] = { 99.0f, 97.0f, 93.0f, 88.0f, 80.0f };
+    for (unsigned k = 0; k < sizeof(levels) / sizeof(levels[0]); k++) {
+        float r = PPGSynth_RatioForSpO2(levels[k]);
+        assert(fabsf(spo2_from_ratio(r) - levels[k]) < 0.01f);
+
+        // Ratio of ratios from the raw counts, as the firmware measures it
+        PPGSynth_Config_t cfg;
+        quiet_config(&cfg);
+        cfg.spo2 = levels[k];
+        PPGSynth_Init(&synth_a, &cfg, 9);
+        uint32_t red_lo = UINT32_MAX, red_hi = 0, ir_lo = UINT32_MAX, ir_hi = 0;
+        double red_sum = 0.0, ir_sum = 0.0;
+        for (int i = 0; i < 20 * RATE_HZ; i++) {
+            uint32_t red, ir;
+            PPGSynth_Next(&synth_a, &red, &ir, NULL);
+            if (red < red_lo) red_lo = red;
+            if (red > red_hi) red_hi = red;
+            if (ir < ir_lo) ir_lo = ir;
+            if (ir > ir_hi) ir_hi = ir;
+            red_sum += red;
+            ir_sum += ir;
+        }
+        float measured = (float)(((red_hi - red_lo) / red_sum) / ((ir_hi - ir_lo) / ir_sum));
+        printf("  SpO2 %.0f %%: R %.3f, measured %.3f -> %.1f %%\n",
+               levels[k], r, measured, spo2_from_ratio(measured));
+        assert(fabsf(spo2_from_ratio(measured) - levels[k]) < 0.5f);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_ectopic(void) {
+    printf("=== Ectopic Beat Test ===\n");
+    PPGSynth_Config_t cfg;
+    quiet_config(&cfg);
+    cfg.hr_bpm = 60.0f;
+    cfg.ectopic_prob = 0.1f;
+    PPGSynth_Init(&synth_a, &cfg, 11);
+
+    // Premature beat after 0.65 RR, compensatory pause of 1.35 RR, smaller pulse
+    int64_t onsets[2048];
+    uint8_t ectopic[2048];
+    uint32_t n = 0;
+    for (int64_t i = 0; i < 1200 * RATE_HZ && n < 2048; i++) {
+        uint32_t r, x;
+        PPGSynth_Truth_t truth;
+        PPGSynth_Next(&synth_a, &r, &x, &truth);
+        if (truth.flags & PPG_SYNTH_FLAG_BEAT) {
+            onsets[n] = i;
+            ectopic[n] = (truth.flags & PPG_SYNTH_FLAG_ECTOPIC) != 0;
+            n++;
+        }
+    }
+    uint32_t count = 0;
+    for (uint32_t k = 1; k + 1 < n; k++) {
+        if (!ectopic[k]) {
+            continue;
+        }
+        assert(!ectopic[k - 1] && !ectopic[k + 1]);
+        int64_t before = onsets[k] - onsets[k - 1];
+        int64_t after = onsets[k + 1] - onsets[k];
+        assert(llabs(before - 65) <= 1);
+        assert(llabs(after - 135) <= 1);
+        count++;
+    }
+    printf("  %u ectopic beats in %u\n", count, n);
+    assert(count > 0.05 * n && count < 0.15 * n);
+    printf("  PASSED\n\n");
+}
+
+static void test_motion(void) {
+    printf("=== Motion Artifact Test ===\n");
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.motion_per_min = 6.0f;
+    PPGSynth_Init(&synth_a, &cfg, 21);
+
+    // Episodes start at random, last 1-4 s and are much larger than the pulse
+    uint32_t episodes = 0, flagged = 0;
+    double dev_in = 0.0, dev_out = 0.0;
+    uint8_t previous = 0;
+    const uint32_t total = 1200 * RATE_HZ;
+    for (uint32_t i = 0; i < total; i++) {
+        uint32_t r, x;
+        PPGSynth_Truth_t truth;
+        PPGSynth_Next(&synth_a, &r, &x, &truth);
+        uint8_t motion = (truth.flags & PPG_SYNTH_FLAG_MOTION) != 0;
+        double dev = fabs((double)x - cfg.ir_dc);
+        if (motion) {
+            flagged++;
+            dev_in = fmax(dev_in, dev);
+        } else {
+            dev_out = fmax(dev_out, dev);
+        }
+        episodes += (motion && !previous);
+        previous = motion;
+    }
+    printf("  %u episodes, %.1f %% of samples, peak deviation %.0f (clean %.0f)\n",
+           episodes, 100.0 * flagged / total, dev_in, dev_out);
+    assert(episodes > 60 && episodes < 140);
+    assert(flagged > 0.1 * total && flagged < 0.4 * total);
+    assert(dev_in > 2.0 * dev_out);
+
+    // Without motion_per_min nothing is flagged
+    PPGSynth_DefaultConfig(&cfg);
+    PPGSynth_Init(&synth_a, &cfg, 21);
+    for (uint32_t i = 0; i < 600 * RATE_HZ; i++) {
+        uint32_t r, x;
+        PPGSynth_Truth_t truth;
+        PPGSynth_Next(&synth_a, &r, &x, &truth);
+        assert((truth.flags & PPG_SYNTH_FLAG_MOTION) == 0);
+    }
+    printf("  PASSED\n\n");
+}
+
+static void test_adc(void) {
+    printf("=== ADC Saturation and Resolution Test ===\n");
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.ir_dc = 260000.0f;
+    cfg.motion_per_min = 20.0f;
+    PPGSynth_Init(&synth_a, &cfg, 31);
+    uint32_t saturated = 0, at_full_scale = 0;
+    for (int i = 0; i < 300 * RATE_HZ; i++) {
+        uint32_t r, x;
+        PPGSynth_Truth_t truth;
+        PPGSynth_Next(&synth_a, &r, &x, &truth);
+        assert(x <= 0x3FFFF && r <= 0x3FFFF);
+        saturated += (truth.flags & PPG_SYNTH_FLAG_SATURATED) != 0;
+        at_full_scale += (x == 0x3FFFF);
+    }
+    assert(saturated > 0 && saturated == at_full_scale);
+
+    // 16-bit pulse width: the two low bits of the 18-bit value are always 0
+    PPGSynth_DefaultConfig(&cfg);
+    cfg.resolution_bits = 16;
+    PPGSynth_Init(&synth_a, &cfg, 31);
+    uint32_t odd = 0;
+    for (int i = 0; i < 10 * RATE_HZ; i++) {
+        uint32_t r, x;
+        PPGSynth_Next(&synth_a, &r, &x, NULL);
+        odd |= (r | x) & 0x3;
+    }
+    assert(odd == 0);
+    printf("  %u saturated samples\n", saturated);
+    printf("  PASSED\n\n");
+}
+
+static void test_source(void) {
+    printf("=== Sensor Source Test ===\n");
+    PPGSynth_Config_t cfg;
+    PPGSynth_DefaultConfig(&cfg);
+    PPGSynth_Init(&synth_a, &cfg, 51);
+    PPGSynth_Init(&synth_b, &cfg, 51);
+
+    // Conversions at the synthesiser's rate (with jitter) get consecutive samples
+    for (uint64_t k = 0; k < 1000; k++) {
+        uint32_t r1, x1, r2, x2;
+        PPGSynth_Next(&synth_a, &r1, &x1, NULL);
+        PPGSynth_Source(&synth_b, k * 10000u + (k % 7) * 500u, &r2, &x2);
+        assert(r1 == r2 && x1 == x2);
+    }
+
+    // A faster sensor holds values: 400 Hz sees each sample about 4 times
+    PPGSynth_Init(&synth_b, &cfg, 51);
+    for (uint64_t k = 0; k < 4000; k++) {
+        uint32_t r, x;
+        PPGSynth_Source(&synth_b, k * 2500u, &r, &x);
+    }
+    assert(synth_b.index == 1001);
+    printf("  PASSED\n\n");
+}
+
+static void test_dpt_accuracy(void) {
+    printf("=== DPT On Synthetic Patients Test ===\n");
+    static DPT_State_t dpt;
+    uint32_t checked = 0;
+    for (uint64_t seed = 1; seed <= 6; seed++) {
+        PPGSynth_Config_t cfg;
+        PPGSynth_RandomPatient(&cfg, seed);
+        cfg.ectopic_prob = 0.0f;
+        if (cfg.hr_bpm < 60.0f || cfg.perfusion_index < 0.01f) {
+            continue;       // below DPT's period range / too weak a pulse for a fixed tolerance
+        }
+        PPGSynth_Init(&synth_a, &cfg, seed);
+        DPT_Init(&dpt);
+        double truth_sum = 0.0;
+        uint32_t truth_n = 0;
+        for (int i = 0; i < 60 * RATE_HZ; i++) {
+            uint32_t r, x;
+            PPGSynth_Truth_t truth;
+            PPGSynth_Next(&synth_a, &r, &x, &truth);
+            DPT_Process(&dpt, r, x);
+            if (i >= 40 * RATE_HZ) {
+                truth_sum += truth.hr_bpm;
+                truth_n++;
+            }
+        }
+        float expected = (float)(truth_sum / truth_n);
+        printf("  patient %llu: %.1f bpm -> DPT %.1f bpm (%s)\n", (unsigned long long)seed,
+               expected, DPT_GetHeartRate(&dpt), DPT_IsHeartRateValid(&dpt) ? "valid" : "not valid");
+        assert(DPT_IsHeartRateValid(&dpt));
+        // DPT's period is in whole samples: about 1 bpm per sample at 60 bpm, 5 at 120
+        assert(fabsf(DPT_GetHeartRate(&dpt) - expected) < 0.07f * expected);
+        checked++;
+    }
+    assert(checked >= 2);
+    printf("  PASSED\n\n");
+}
+
+static void test_throughput(void) {
+    printf("=== Throughput Test ===\n");
+    // 8 random patients, one hour each, in 1000-sample blocks
+    static uint32_t red[1000], ir[1000];
+    static PPGSynth_Truth_t truth[1000];
+    uint64_t total = 0;
+    uint32_t checksum = 0;
+    clock_t start = clock();
+    for (uint64_t patient = 0; patient < 8; patient++) {
+        PPGSynth_Config_t cfg;
+        PPGSynth_RandomPatient(&cfg, patient);
+        cfg.motion_per_min = 1.0f;
+        PPGSynth_Init(&synth_a, &cfg, patient);
+        for (int block = 0; block < 3600 * RATE_HZ / 1000; block++) {
+            PPGSynth_Generate(&synth_a, red, ir, truth, 1000);
+            checksum += red[0] ^ ir[999];
+            total += 1000;
+        }
+    }
+    double wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+    double hours = (double)total / RATE_HZ / 3600.0;
+    printf("  %llu samples (%.0f h) in %.3f s: %.1f M samples/s, %.0fx real time (checksum %08x)\n",
+           (unsigned long long)total, hours, wall, wall > 0.0 ? total / wall / 1e6 : 0.0,
+           wall > 0.0 ? hours * 3600.0 / wall : 0.0, checksum);
+    assert(wall < hours);       // at least an hour of signal per second
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== PPG Synthesiser Test Harness ===\n\n");
+
+    test_determinism();
+    test_morphology();
+    test_heart_rate();
+    test_spo2();
+    test_ectopic();
+    test_motion();
+    test_adc();
+    test_source();
+    test_dpt_accuracy();
+    test_throughput();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "../Core/Inc/profiler.h"
+#include "../Core/Inc/telemetry.h"
+
+// Simulated DWT->CYCCNT: every read advances the counter by a fixed cost
+static uint32_t fake_cycles = 0xFFFFF000u;      // start close to wraparound
+static uint32_t read_cost = 3;
+
+uint32_t PROF_HostCycles(void) {
+    fake_cycles += read_cost;
+    return fake_cycles;
+}
+
+static uint8_t stream[4096];
+static size_t stream_len = 0;
+
+static void capture_tx(const uint8_t *data, uint16_t len) {
+    assert(stream_len + len <= sizeof(stream));
+    memcpy(&stream[stream_len], data, len);
+    stream_len += len;
+}
+
+static void work(uint32_t cycles) {
+    fake_cycles += cycles;
+}
+
+static void test_histogram_bins(void) {
+    printf("=== Histogram Bin Test ===\n");
+    assert(PROF_HistBin(0) == 0);
+    assert(PROF_HistBin(255) == 0);
+    assert(PROF_HistBin(256) == 1);
+    assert(PROF_HistBin(1023) == 1);
+    assert(PROF_HistBin(1024) == 2);
+    assert(PROF_HistBin(4095) == 2);
+    assert(PROF_HistBin(65536) == 5);
+    assert(PROF_HistBin(1u << 20) == 7);
+    assert(PROF_HistBin(0xFFFFFFFFu) == 7);
+    printf("  PASSED\n\n");
+}
+
+static void test_stage_stats(void) {
+    printf("=== Stage Statistics Test ===\n");
+
+    PROF_Init();
+    assert(PROF_GetOverhead() == read_cost);
+
+    // Measured cycles must exclude the marker overhead, even across CYCCNT wraparound
+    for (uint32_t i = 0; i < 100; i++) {
+        PROF_BEGIN(PROF_STAGE_FILTER);
+        work(400 + i);
+        PROF_END(PROF_STAGE_FILTER);
+    }
+    PROF_BEGIN(PROF_STAGE_HR_CALC);
+    work(50000);
+    PROF_END(PROF_STAGE_HR_CALC);
+
+    const PROF_StageStats_t *f = PROF_GetStats(PROF_STAGE_FILTER);
+    assert(f->count == 100);
+    assert(f->min == 400 && f->max == 499);
+    assert(f->total == 100 * 400 + 99 * 100 / 2);
+    assert(f->hist[1] == 100);
+
+    const PROF_StageStats_t *h = PROF_GetStats(PROF_STAGE_HR_CALC);
+    assert(h->count == 1 && h->min == 50000 && h->max == 50000);
+    assert(h->hist[PROF_HistBin(50000)] == 1);
+    assert(PROF_GetStats(PROF_STAGE_DPT_PROCESS)->count == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_report_roundtrip(void) {
+    printf("=== Telemetry Report Test ===\n");
+
+    PROF_Init();
+    for (uint8_t stage = 0; stage < PROF_STAGE_COUNT; stage++) {
+        for (uint32_t i = 0; i <= stage; i++) {
+            PROF_Record((PROF_Stage_t)stage, 100u * (stage + 1) + read_cost);
+        }
+    }
+
+    stream_len = 0;
+    TLM_Init(capture_tx);
+    PROF_POLL(PROF_REPORT_INTERVAL_MS);        // first interval elapsed: report and reset
+    assert(stream_len > 0);
+    assert(PROF_GetStats(PROF_STAGE_LOOP)->count == 0);
+
+    static TLM_Parser_t parser;
+    TLM_Parser_Init(&parser);
+    uint32_t seen = 0;
+    uint32_t frames = 0;
+    for (size_t i = 0; i < stream_len; i++) {
+        PROF_Report_t report;
+        if (!TLM_Parser_Feed(&parser, stream[i])) {
+            continue;
+        }
+        assert(parser.type == TLM_TYPE_PROFILE);
+        assert(parser.len <= TLM_MAX_PAYLOAD);
+        CHECK(PROF_DecodeReport(parser.payload, parser.len, &report) == 0);
+        assert(report.interval_ms == PROF_REPORT_INTERVAL_MS);
+        frames++;
+        for (uint8_t k = 0; k < report.stage_count; k++) {
+            uint8_t stage = report.stage_id[k];
+            const PROF_StageStats_t *s = &report.stages[k];
+            assert(s->count == stage + 1u);
+            assert(s->min == 100u * (stage + 1) && s->max == s->min);
+            assert(s->total == s->count * s->min);
+            seen |= 1u << stage;
+        }
+    }
+    assert(seen == (1u << PROF_STAGE_COUNT) - 1);
+    printf("  %u stages in %u frames\n", PROF_STAGE_COUNT, frames);
+
+    // Nothing more until the next interval has elapsed
+    stream_len = 0;
+    PROF_POLL(PROF_REPORT_INTERVAL_MS + 10);
+    assert(stream_len == 0);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Profiler Test Harness ===\n\n");
+
+    test_histogram_bins();
+    test_stage_stats();
+    test_report_roundtrip();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
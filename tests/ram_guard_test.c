@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../Core/Inc/ram_guard.h"
+
+#define STACK_WORDS 512
+
+// Simulated stack region; the "current SP" at setup is 64 words below the top
+static uint32_t fake_stack[STACK_WORDS];
+
+static void setup(void) {
+    memset(fake_stack, 0, sizeof(fake_stack));
+    RamGuard_Setup(fake_stack, fake_stack + STACK_WORDS, fake_stack + STACK_WORDS - 64);
+}
+
+// Simulate a call chain reaching down to the given depth (bytes below the top)
+static void use_stack(uint32_t depth_bytes) {
+    for (uint32_t i = 0; i < depth_bytes / 4; i++) {
+        fake_stack[STACK_WORDS - 1 - i] = 0x12345678u + i;
+    }
+}
+
+static void test_uninitialized(void) {
+    printf("=== Uninitialized Test ===\n");
+    // Before setup the check must not report a false overflow
+    assert(RamGuard_CanaryIntact());
+    assert(RamGuard_StackPeak() == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_paint(void) {
+    printf("=== Paint Test ===\n");
+    setup();
+    assert(RamGuard_StackSize() == STACK_WORDS * 4);
+    for (uint32_t i = 0; i < RAM_GUARD_CANARY_WORDS; i++) {
+        assert(fake_stack[i] == RAM_GUARD_CANARY);
+    }
+    for (uint32_t i = RAM_GUARD_CANARY_WORDS; i < STACK_WORDS - 64; i++) {
+        assert(fake_stack[i] == RAM_GUARD_PAINT);
+    }
+    // The words above the setup SP are in use and are not painted
+    assert(fake_stack[STACK_WORDS - 64] == 0);
+    assert(RamGuard_CanaryIntact());
+    // Everything above the paint counts as used
+    assert(RamGuard_StackPeak() == 64 * 4);
+    printf("  PASSED\n\n");
+}
+
+static void test_high_watermark(void) {
+    printf("=== High Watermark Test ===\n");
+    setup();
+    use_stack(1000);
+    assert(RamGuard_StackPeak() == 1000);
+
+    // The stack unwinds (values left behind), the peak stays
+    use_stack(300);
+    assert(RamGuard_StackPeak() == 1000);
+    use_stack(1600);
+    printf("  peak %u of %u bytes\n", RamGuard_StackPeak(), RamGuard_StackSize());
+    assert(RamGuard_StackPeak() == 1600);
+    assert(RamGuard_CanaryIntact());
+    printf("  PASSED\n\n");
+}
+
+static void test_canary(void) {
+    printf("=== Canary Test ===\n");
+    setup();
+    // Using the whole paint area but not the guard words is still fine
+    use_stack((STACK_WORDS - RAM_GUARD_CANARY_WORDS) * 4);
+    assert(RamGuard_CanaryIntact());
+    assert(RamGuard_StackPeak() == (STACK_WORDS - RAM_GUARD_CANARY_WORDS) * 4);
+
+    // A single overwritten guard word is detected
+    fake_stack[RAM_GUARD_CANARY_WORDS - 1] = 0;
+    assert(!RamGuard_CanaryIntact());
+    assert(RamGuard_StackPeak() == RamGuard_StackSize());
+
+    setup();
+    fake_stack[0] ^= 1u;
+    assert(!RamGuard_CanaryIntact());
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== RAM Guard Test Harness ===\n\n");
+
+    test_uninitialized();
+    test_paint();
+    test_high_watermark();
+    test_canary();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,299 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "check.h"
+#include "serial_ingest.h"
+#include "serial_device.h"
+#include "telemetry.h"
+
+#define SAMPLES         3000
+#define DEVICE_BUFFER   (256 * 1024)
+#define LINKS           64
+#define LINK_SAMPLES    2000
+#define RING_FRAMES     256
+
+static uint8_t device_buf[DEVICE_BUFFER];
+
+static void open_pty(int *master, int *slave) {
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    CHECK(*master >= 0 && grantpt(*master) == 0 && unlockpt(*master) == 0);
+    *slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+    assert(*slave >= 0);
+}
+
+// Sample i of a device: its index can be read back from red
+static uint32_t red_of(uint32_t i) { return 100000 + i; }
+static uint32_t ir_of(uint32_t i) { return 120000 + 3 * i + (i % 7); }
+
+// Everything committed to the ring, checked in order; returns the frames taken
+static uint32_t drain(ShmRing_t *r, uint32_t *next, uint32_t *missing) {
+    uint32_t pos;
+    uint32_t n = ShmRing_Peek(r, &pos);
+    for (uint32_t k = 0; k < n; k++) {
+        const ShmRing_Frame_t *f = ShmRing_Frame(r, pos + k);
+        uint32_t i = f->red - red_of(0);
+        assert(i >= *next && f->ir == ir_of(i) && f->t_ns > 0);
+        *missing += i - *next;
+        *next = i + 1;
+    }
+    ShmRing_Release(r, pos + n);
+    return n;
+}
+
+// Write the device's pending bytes in pieces of 1 .. 300; 0 if the link would block
+static int send_some(SerialDevice_t *dev, int fd, uint32_t *piece) {
+    while (dev->len > 0) {
+        size_t n = 1 + (*piece * 7919u) % 300;
+        n = (n > dev->len) ? dev->len : n;
+        ssize_t w = write(fd, dev->out, n);
+        if (w < 0) {
+            assert(errno == EAGAIN);
+            return 0;
+        }
+        SerialDevice_Consume(dev, (size_t)w);
+        (*piece)++;
+    }
+    return 1;
+}
+
+static void test_parse(void) {
+    printf("=== Text + Frame Parsing Test ===\n");
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, 1, RING_FRAMES, 0) == 0);
+    SerialIngest_Config_t cfg = { 1, &seg };
+    SerialIngest_t *in = SerialIngest_Create(&cfg);
+    assert(in != NULL);
+    int master, slave;
+    open_pty(&master, &slave);
+    CHECK(SerialIngest_Add(in, slave) == 0);
+    CHECK(SerialIngest_Add(in, slave) == -1);           // all links in use
+
+    // The firmware's output: a banner, capture frames, results every 250 samples,
+    // a profile frame, a line too long, and one frame corrupted on the wire
+    SerialDevice_t dev;
+    SerialDevice_Init(&dev, device_buf, sizeof(device_buf));
+    SerialDevice_Print(&dev, "MAX30102 Init Success!\r\nStarting PPG signal processing...\r\n");
+    size_t corrupt_at = 0;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        SerialDevice_Push(&dev, red_of(i), ir_of(i));
+        if (i % 250 == 249) {
+            SerialDevice_Report(&dev, 1, 60.0f + i / 250, i >= 1000, 97.5f, i >= 1500);
+            SerialDevice_Report(&dev, 2, 61.5f, i >= 2000, 98.0f, 0);
+        }
+        if (i == 1200) {
+            static const uint8_t profile[12] = { 1, 2, 3 };
+            SerialDevice_Send(&dev, TLM_TYPE_PROFILE, profile, sizeof(profile));
+            char junk[200];
+            memset(junk, 'x', sizeof(junk) - 3);
+            strcpy(&junk[sizeof(junk) - 3], "\r\n");
+            SerialDevice_Print(&dev, junk);
+        }
+        if (i == 2100) {
+            corrupt_at = dev.len;               // the next frame
+        }
+    }
+    SerialDevice_Flush(&dev);
+    assert(dev.overflow == 0 && corrupt_at > 0);
+    device_buf[corrupt_at + TLM_HEADER_SIZE + 20] ^= 0x40;
+
+    uint32_t next = 0, missing = 0, taken = 0, piece = 0;
+    while (dev.len > 0) {
+        send_some(&dev, master, &piece);
+        while (SerialIngest_Poll(in, 0) > 0) {
+        }
+        taken += drain(ShmRing_Get(&seg, 0), &next, &missing);
+    }
+    for (int k = 0; k < 10; k++) {
+        SerialIngest_Poll(in, 1);
+        taken += drain(ShmRing_Get(&seg, 0), &next, &missing);
+    }
+    SerialIngest_LinkStats_t ls;
+    CHECK(SerialIngest_GetLink(in, 0, &ls) == 0 && SerialIngest_GetLink(in, 1, &ls) == -1);
+    SerialIngest_GetLink(in, 0, &ls);
+    // The corrupt frame and the frames up to the next keyframe are lost, nothing else
+    assert(ls.crc_errors == 1 && ls.other_frames == 1 && ls.long_lines == 1);
+    assert(next == SAMPLES && taken == ls.samples && missing == ls.samples_lost);
+    assert(ls.samples_lost >= 128 && ls.samples_lost <= 4 * 128);
+    assert(ls.lines == 2 + 1 + 4 * (SAMPLES / 250));
+    assert(ls.reports[0] == SAMPLES / 250 && ls.reports[1] == SAMPLES / 250);
+    assert(ls.hr[0] == 71.0f && ls.hr_valid[0] && ls.spo2[0] == 97.5f && ls.spo2_valid[0]);
+    assert(ls.hr[1] == 61.5f && ls.hr_valid[1] && !ls.spo2_valid[1]);
+    printf("  %u samples in %llu frames, %llu lost to one corrupt frame, %llu lines\n", taken,
+           (unsigned long long)ls.frames, (unsigned long long)ls.samples_lost, (unsigned long long)ls.lines);
+
+    // The device side hangs up: the link closes
+    close(master);
+    SerialIngest_Poll(in, 10);
+    SerialIngest_Stats_t st;
+    SerialIngest_GetStats(in, &st);
+    assert(st.links == 1 && st.open == 0 && st.samples == taken);
+    SerialIngest_Destroy(in);
+    ShmRing_Detach(&seg);
+    printf("  PASSED\n\n");
+}
+
+// A consumer that stops: the link pauses, the pty fills, the device's writes
+// block; once the consumer resumes every sample arrives
+static void test_backpressure(void) {
+    printf("=== Backpressure Test ===\n");
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, 1, RING_FRAMES, 0) == 0);
+    SerialIngest_Config_t cfg = { 1, &seg };
+    SerialIngest_t *in = SerialIngest_Create(&cfg);
+    int master, slave;
+    open_pty(&master, &slave);
+    CHECK(SerialIngest_Add(in, slave) == 0);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+
+    const uint32_t total = 40000;
+    SerialDevice_t dev;
+    SerialDevice_Init(&dev, device_buf, sizeof(device_buf));
+    for (uint32_t i = 0; i < total; i++) {
+        SerialDevice_Push(&dev, red_of(i), ir_of(i));
+    }
+    SerialDevice_Flush(&dev);
+    size_t stream = dev.len;
+
+    // Nobody consumes: the ring fills, the link pauses, the writes stop
+    // (the pty hands bytes to the reading side asynchronously)
+    uint32_t piece = 0;
+    int blocked = 0;
+    SerialIngest_LinkStats_t ls;
+    memset(&ls, 0, sizeof(ls));
+    for (int k = 0; k < 1000 && !(blocked && ls.paused); k++) {
+        blocked = !send_some(&dev, master, &piece);
+        SerialIngest_Poll(in, 1);
+        SerialIngest_GetLink(in, 0, &ls);
+    }
+    assert(blocked && ls.paused && ls.samples <= RING_FRAMES);
+    size_t parked = stream - dev.len;
+    printf("  consumer stopped: %llu samples in the ring, %zu of %zu bytes taken by the pty\n",
+           (unsigned long long)ls.samples, parked, stream);
+
+    // The consumer resumes
+    uint32_t next = 0, missing = 0;
+    for (int k = 0; k < 100000 && next < total; k++) {
+        send_some(&dev, master, &piece);
+        SerialIngest_Poll(in, 0);
+        drain(ShmRing_Get(&seg, 0), &next, &missing);
+    }
+    SerialIngest_GetLink(in, 0, &ls);
+    assert(next == total && missing == 0 && ls.samples == total && ls.samples_lost == 0);
+    assert(ls.pauses > 0 && !ls.paused && ls.crc_errors == 0);
+    printf("  resumed: %u samples, none lost, %llu pauses\n", next, (unsigned long long)ls.pauses);
+    close(master);
+    SerialIngest_Destroy(in);
+    ShmRing_Detach(&seg);
+    printf("  PASSED\n\n");
+}
+
+// A device process writing LINKS ptys, the ingestion thread reading them
+static void test_links(void) {
+    printf("=== Many Links Test ===\n");
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, LINKS, RING_FRAMES, 0) == 0);
+    SerialIngest_Config_t cfg = { LINKS, &seg };
+    SerialIngest_t *in = SerialIngest_Create(&cfg);
+    int master[LINKS];
+    for (uint32_t d = 0; d < LINKS; d++) {
+        int slave;
+        open_pty(&master[d], &slave);
+        CHECK(SerialIngest_Add(in, slave) == (int)d);
+    }
+    int done[2];
+    CHECK(pipe(done) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        // Round robin, a block of samples per device at a time, blocking writes
+        static SerialDevice_t devs[LINKS];
+        static uint8_t bufs[LINKS][4096];
+        for (uint32_t d = 0; d < LINKS; d++) {
+            SerialDevice_Init(&devs[d], bufs[d], sizeof(bufs[d]));
+        }
+        for (uint32_t i = 0; i < LINK_SAMPLES; i += 16) {
+            for (uint32_t d = 0; d < LINKS; d++) {
+                for (uint32_t k = i; k < i + 16; k++) {
+                    SerialDevice_Push(&devs[d], red_of(k), ir_of(k + d));
+                }
+                if (i % 256 == 240) {
+                    SerialDevice_Report(&devs[d], 1, (float)d, 1, 95.0f, 1);
+                }
+                for (size_t off = 0; off < devs[d].len;) {
+                    ssize_t w = write(master[d], devs[d].out + off, devs[d].len - off);
+                    if (w <= 0) {
+                        _exit(1);
+                    }
+                    off += (size_t)w;
+                }
+                devs[d].len = 0;
+            }
+        }
+        for (uint32_t d = 0; d < LINKS; d++) {
+            SerialDevice_Flush(&devs[d]);
+            if (write(master[d], devs[d].out, devs[d].len) != (ssize_t)devs[d].len) {
+                _exit(1);
+            }
+        }
+        // Closing the masters hangs the links up: only once everything is read
+        char c;
+        _exit(read(done[0], &c, 1) == 1 ? 0 : 1);
+    }
+    for (uint32_t d = 0; d < LINKS; d++) {
+        close(master[d]);
+    }
+    CHECK(SerialIngest_Start(in) == 0);
+    uint32_t next[LINKS] = { 0 }, got = 0;
+    SerialIngest_Stats_t st;
+    for (int k = 0; k < 20000; k++) {
+        for (uint32_t d = 0; d < LINKS; d++) {
+            ShmRing_t *r = ShmRing_Get(&seg, d);
+            uint32_t pos;
+            uint32_t n = ShmRing_Peek(r, &pos);
+            for (uint32_t j = 0; j < n; j++, next[d]++) {
+                const ShmRing_Frame_t *f = ShmRing_Frame(r, pos + j);
+                assert(f->red == red_of(next[d]) && f->ir == ir_of(next[d] + d));
+            }
+            ShmRing_Release(r, pos + n);
+            got += n;
+        }
+        SerialIngest_GetStats(in, &st);
+        if (got == LINKS * LINK_SAMPLES && st.open == LINKS) {
+            CHECK(write(done[1], "x", 1) == 1);
+        }
+        if (st.open == 0) {
+            break;
+        }
+        usleep(500);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(done[0]);
+    close(done[1]);
+    SerialIngest_Stop(in);
+    assert(got == LINKS * LINK_SAMPLES && st.open == 0 && st.samples_lost == 0 && st.crc_errors == 0);
+    assert(st.reports == LINKS * (LINK_SAMPLES / 256));
+    SerialIngest_LinkStats_t ls;
+    SerialIngest_GetLink(in, 17, &ls);
+    assert(ls.hr[0] == 17.0f && ls.spo2[0] == 95.0f);
+    printf("  %u links: %u samples, %llu bytes in %llu reads over %llu polls, %llu pauses\n", LINKS, got,
+           (unsigned long long)st.bytes, (unsigned long long)st.reads, (unsigned long long)st.polls,
+           (unsigned long long)st.pauses);
+    SerialIngest_Destroy(in);
+    ShmRing_Detach(&seg);
+    printf("  PASSED\n\n");
+}
+
+int main(void) {
+    test_parse();
+    test_backpressure();
+    test_links();
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,283 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "check.h"
+#include "shm_ring.h"
+
+#define SPSC_FRAMES     2000000
+#define MPSC_PRODUCERS  4
+#define MPSC_FRAMES     200000      // per producer
+#define RING_FRAMES     1024
+#define WAIT_NS         1000000ull
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Batches of 1 .. 37 frames: wrap-around at every offset
+static uint32_t batch_size(uint32_t i) {
+    return 1 + (i * 7919u) % 37;
+}
+
+// Producer: frames first .. first + count - 1 tagged with tag, reserve / fill / commit
+static void produce(ShmRing_t *r, uint32_t tag, uint32_t count) {
+    uint32_t sent = 0;
+    for (uint32_t b = 0; sent < count; b++) {
+        uint32_t want = batch_size(b + tag);
+        if (want > count - sent) {
+            want = count - sent;
+        }
+        uint32_t pos;
+        uint32_t got = ShmRing_Reserve(r, want, &pos);
+        if (got == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t k = 0; k < got; k++) {
+            ShmRing_Frame_t *f = ShmRing_Frame(r, pos + k);
+            f->red = tag;
+            f->ir = sent + k;
+            f->t_ns = ((uint64_t)tag << 32) | (sent + k);
+        }
+        ShmRing_Commit(r, pos, got);
+        sent += got;
+    }
+}
+
+static void test_segment(void) {
+    printf("=== Segment Test ===\n");
+    ShmRing_Seg_t seg, other;
+    CHECK(ShmRing_Create(&seg, 0, 64, 0) == -1);
+    CHECK(ShmRing_Create(&seg, 2, 100, 0) == -1);          // not a power of two
+    CHECK(ShmRing_Create(&seg, 2, 64, 0x80) == -1);
+    CHECK(ShmRing_Create(&seg, 3, 64, 0) == 0);
+    assert(ShmRing_Get(&seg, 3) == NULL);
+
+    // A second mapping of the same fd sees the same rings
+    CHECK(ShmRing_Attach(&other, dup(seg.fd)) == 0);
+    assert(other.rings == 3 && other.frames == 64 && other.flags == 0);
+    CHECK(ShmRing_Push(ShmRing_Get(&seg, 2), 11, 22, 33) == 0);
+    uint32_t pos;
+    CHECK(ShmRing_Peek(ShmRing_Get(&other, 2), &pos) == 1 && pos == 0);
+    assert(ShmRing_Frame(ShmRing_Get(&other, 2), pos)->ir == 22);
+    CHECK(ShmRing_Peek(ShmRing_Get(&other, 1), &pos) == 0);
+    ShmRing_Detach(&other);
+
+    // Not a segment: a pipe, an empty memfd, a resized segment
+    int p[2];
+    CHECK(pipe(p) == 0);
+    CHECK(ShmRing_Attach(&other, p[0]) == -1);
+    close(p[0]);
+    close(p[1]);
+    int fd = memfd_create("not-a-segment", 0);
+    CHECK(ftruncate(fd, 8192) == 0);
+    CHECK(ShmRing_Attach(&other, fd) == -1);
+    close(fd);
+    CHECK(ftruncate(seg.fd, SHM_RING_HEADER + 100) == 0);
+    fd = dup(seg.fd);
+    CHECK(ShmRing_Attach(&other, fd) == -1);
+    close(fd);
+    ShmRing_Detach(&seg);
+    printf("  PASSED\n\n");
+}
+
+static void test_reserve(void) {
+    printf("=== Reserve / Commit Test ===\n");
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, 1, 8, 0) == 0);
+    ShmRing_t *r = ShmRing_Get(&seg, 0);
+    uint32_t pos, got;
+    // Reserved but not committed: invisible
+    CHECK(ShmRing_Reserve(r, 10, &pos) == 8 && pos == 0);
+    CHECK(ShmRing_Peek(r, &pos) == 0);
+    for (uint32_t k = 0; k < 8; k++) {
+        ShmRing_Frame(r, k)->red = k;
+    }
+    ShmRing_Commit(r, 0, 8);
+    CHECK(ShmRing_Reserve(r, 1, &pos) == 0);
+    CHECK(ShmRing_Push(r, 1, 1, 1) == -1 && r->ctrl->dropped == 1);
+
+    // Release some, the next batch wraps round
+    CHECK(ShmRing_Peek(r, &pos) == 8 && pos == 0);
+    ShmRing_Release(r, 3);
+    got = ShmRing_Reserve(r, 5, &pos);
+    assert(got == 3 && pos == 8 && ShmRing_Frame(r, pos) == ShmRing_Frame(r, 0));
+    ShmRing_Commit(r, pos, got);
+    CHECK(ShmRing_Peek(r, &pos) == 8 && pos == 3);
+
+    // Nothing committed: Wait times out
+    ShmRing_Release(r, 11);
+    double t0 = now_s();
+    CHECK(ShmRing_Wait(r, 1, 2 * WAIT_NS) == 0);
+    assert(now_s() - t0 >= 0.0015);
+    assert(r->ctrl->sleeping == 0);
+
+    // Below the watermark: Wait keeps sleeping until the timeout, at it: returns at once
+    CHECK(ShmRing_Push(r, 1, 1, 1) == 0 && ShmRing_Push(r, 2, 2, 2) == 0);
+    t0 = now_s();
+    CHECK(ShmRing_Wait(r, 4, 2 * WAIT_NS) == 1);
+    assert(now_s() - t0 >= 0.0015);
+    CHECK(ShmRing_Push(r, 3, 3, 3) == 0 && ShmRing_Push(r, 4, 4, 4) == 0);
+    CHECK(ShmRing_Wait(r, 4, 1000 * WAIT_NS) == 1);
+    CHECK(ShmRing_Peek(r, &pos) == 4 && pos == 11);
+    ShmRing_Detach(&seg);
+    printf("  PASSED\n\n");
+}
+
+// Consume count frames of one producer; the consumer sleeps when it is ahead
+static double consume_spsc(ShmRing_t *r, uint32_t count) {
+    double t0 = now_s();
+    uint32_t seen = 0;
+    while (seen < count) {
+        uint32_t pos;
+        uint32_t n = ShmRing_Peek(r, &pos);
+        if (n == 0) {
+            ShmRing_Wait(r, RING_FRAMES / 4, WAIT_NS);
+            continue;
+        }
+        for (uint32_t k = 0; k < n; k++, seen++) {
+            const ShmRing_Frame_t *f = ShmRing_Frame(r, pos + k);
+            assert(f->red == 0 && f->ir == seen && f->t_ns == seen);
+        }
+        ShmRing_Release(r, pos + n);
+    }
+    return now_s() - t0;
+}
+
+// The same frames through a pipe, for comparison
+static double consume_pipe(int fd, uint32_t count) {
+    static ShmRing_Frame_t buf[64];
+    double t0 = now_s();
+    uint32_t seen = 0;
+    size_t partial = 0;
+    while (seen < count) {
+        ssize_t n = read(fd, (uint8_t *)buf + partial, sizeof(buf) - partial);
+        assert(n > 0);
+        partial += (size_t)n;
+        for (size_t k = 0; k < partial / sizeof(ShmRing_Frame_t); k++, seen++) {
+            assert(buf[k].ir == seen);
+        }
+        size_t whole = partial / sizeof(ShmRing_Frame_t) * sizeof(ShmRing_Frame_t);
+        memmove(buf, (uint8_t *)buf + whole, partial - whole);
+        partial -= whole;
+    }
+    return now_s() - t0;
+}
+
+static void test_processes(void) {
+    printf("=== Cross-process SPSC / MPSC Test ===\n");
+    // SPSC: the segment goes to the producer over a Unix socket
+    ShmRing_Seg_t seg;
+    CHECK(ShmRing_Create(&seg, 1, RING_FRAMES, 0) == 0);
+    int sv[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        close(sv[0]);
+        ShmRing_Seg_t mine;
+        int fd = ShmRing_RecvFd(sv[1]);
+        if (fd < 0 || ShmRing_Attach(&mine, fd) != 0) {
+            _exit(1);
+        }
+        produce(ShmRing_Get(&mine, 0), 0, SPSC_FRAMES);
+        _exit(0);
+    }
+    close(sv[1]);
+    CHECK(ShmRing_SendFd(sv[0], seg.fd) == 0);
+    double shm_s = consume_spsc(ShmRing_Get(&seg, 0), SPSC_FRAMES);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(sv[0]);
+    ShmRing_Detach(&seg);
+
+    int p[2];
+    CHECK(pipe(p) == 0);
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        close(p[0]);
+        static ShmRing_Frame_t buf[37];
+        for (uint32_t sent = 0, b = 0; sent < SPSC_FRAMES; b++) {
+            uint32_t n = batch_size(b);
+            n = (n > SPSC_FRAMES - sent) ? SPSC_FRAMES - sent : n;
+            for (uint32_t k = 0; k < n; k++) {
+                buf[k].red = 0;
+                buf[k].ir = sent + k;
+                buf[k].t_ns = sent + k;
+            }
+            if (write(p[1], buf, n * sizeof(ShmRing_Frame_t)) != (ssize_t)(n * sizeof(ShmRing_Frame_t))) {
+                _exit(1);
+            }
+            sent += n;
+        }
+        _exit(0);
+    }
+    close(p[1]);
+    double pipe_s = consume_pipe(p[0], SPSC_FRAMES);
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(p[0]);
+    printf("  SPSC %u frames: shared memory %.1f M frames/s, pipe %.1f M frames/s\n", SPSC_FRAMES,
+           SPSC_FRAMES / shm_s / 1e6, SPSC_FRAMES / pipe_s / 1e6);
+
+    // MPSC: producers inherit the segment; each one's frames arrive in order
+    CHECK(ShmRing_Create(&seg, 1, RING_FRAMES, SHM_RING_MPSC) == 0);
+    pid_t producers[MPSC_PRODUCERS];
+    for (uint32_t k = 0; k < MPSC_PRODUCERS; k++) {
+        producers[k] = fork();
+        assert(producers[k] >= 0);
+        if (producers[k] == 0) {
+            produce(ShmRing_Get(&seg, 0), k, MPSC_FRAMES);
+            _exit(0);
+        }
+    }
+    ShmRing_t *r = ShmRing_Get(&seg, 0);
+    uint32_t next[MPSC_PRODUCERS] = { 0 };
+    uint64_t seen = 0;
+    double t0 = now_s();
+    while (seen < (uint64_t)MPSC_PRODUCERS * MPSC_FRAMES) {
+        uint32_t pos;
+        uint32_t n = ShmRing_Peek(r, &pos);
+        if (n == 0) {
+            ShmRing_Wait(r, RING_FRAMES / 4, WAIT_NS);
+            continue;
+        }
+        for (uint32_t k = 0; k < n; k++) {
+            const ShmRing_Frame_t *f = ShmRing_Frame(r, pos + k);
+            assert(f->red < MPSC_PRODUCERS && f->ir == next[f->red]);
+            assert(f->t_ns == (((uint64_t)f->red << 32) | f->ir));
+            next[f->red]++;
+        }
+        ShmRing_Release(r, pos + n);
+        seen += n;
+    }
+    double mpsc_s = now_s() - t0;
+    for (uint32_t k = 0; k < MPSC_PRODUCERS; k++) {
+        CHECK(waitpid(producers[k], &status, 0) == producers[k] && WIFEXITED(status) &&
+               WEXITSTATUS(status) == 0);
+        assert(next[k] == MPSC_FRAMES);
+    }
+    assert(r->ctrl->dropped == 0);
+    ShmRing_Detach(&seg);
+    printf("  MPSC %u producers x %u frames: %.1f M frames/s\n", MPSC_PRODUCERS, MPSC_FRAMES,
+           seen / mpsc_s / 1e6);
+    printf("  PASSED\n\n");
+}
+
+int main(void) {
+    test_segment();
+    test_reserve();
+    test_processes();
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "check.h"
+#include "state_pool.h"
+
+#define SLAB        16
+#define CAPACITY    100             // six full slabs and a partial one
+#define SIZE        1208            // Method 1's state: not a multiple of a line
+
+static void test_init(void) {
+    printf("=== Init Test ===\n");
+    StatePool_t p;
+    CHECK(StatePool_Init(&p, 0, SLAB, CAPACITY) == -1);
+    CHECK(StatePool_Init(&p, SIZE, 0, CAPACITY) == -1);
+    CHECK(StatePool_Init(&p, SIZE, 12, CAPACITY) == -1);   // not a power of two
+    CHECK(StatePool_Init(&p, SIZE, SLAB, 0) == -1);
+    StatePool_Free(&p);                                     // after a failed Init too
+
+    CHECK(StatePool_Init(&p, SIZE, SLAB, CAPACITY) == 0);
+    assert(p.size == SIZE && p.stride == 1216 && p.used == 0);
+    StatePool_Free(&p);
+    CHECK(StatePool_Init(&p, 64, 1, 1) == 0);
+    assert(p.stride == 64);
+    StatePool_Free(&p);
+    printf("  PASSED\n\n");
+}
+
+// Every object on its own lines, slabs on pages; pointers never change
+static void test_alloc(void) {
+    printf("=== Alloc Test ===\n");
+    StatePool_t p;
+    CHECK(StatePool_Init(&p, SIZE, SLAB, CAPACITY) == 0);
+    uint8_t *ptr[CAPACITY];
+    StatePool_Handle_t h[CAPACITY];
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        h[i] = StatePool_Alloc(&p);
+        assert(h[i] == i);
+        ptr[i] = (uint8_t *)StatePool_Get(&p, h[i]);
+        assert(((uintptr_t)ptr[i] % STATE_POOL_ALIGN) == 0);
+        if (i % SLAB == 0) {
+            assert(((uintptr_t)ptr[i] % STATE_POOL_SLAB_ALIGN) == 0);
+        } else {
+            assert(ptr[i] == ptr[i - 1] + p.stride);
+        }
+        memset(ptr[i], (int)i, SIZE);
+    }
+    assert(p.used == CAPACITY);
+    CHECK(StatePool_Alloc(&p) == STATE_POOL_NONE);
+    CHECK(StatePool_AllocRun(&p, 1) == STATE_POOL_NONE);
+
+    // Release: the same slot comes back, most recent first; the rest stay put
+    StatePool_Release(&p, 40);
+    StatePool_Release(&p, 7);
+    assert(p.used == CAPACITY - 2);
+    CHECK(StatePool_Alloc(&p) == 7);
+    CHECK(StatePool_Alloc(&p) == 40);
+    CHECK(StatePool_Alloc(&p) == STATE_POOL_NONE);
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        assert(StatePool_Get(&p, h[i]) == ptr[i]);
+        assert(ptr[i][0] == (uint8_t)i && ptr[i][SIZE - 1] == (uint8_t)i);
+    }
+    StatePool_Prefetch(&p, ptr[CAPACITY - 1]);              // the last object: stays inside its slab
+    StatePool_Free(&p);
+    printf("  PASSED\n\n");
+}
+
+// A batch's objects are contiguous in one slab; what a run skips is not lost
+static void test_runs(void) {
+    printf("=== Run Test ===\n");
+    StatePool_t p;
+    CHECK(StatePool_Init(&p, SIZE, SLAB, CAPACITY) == 0);
+    CHECK(StatePool_AllocRun(&p, 0) == STATE_POOL_NONE);
+    CHECK(StatePool_AllocRun(&p, SLAB + 1) == STATE_POOL_NONE);
+    CHECK(StatePool_AllocRun(&p, 10) == 0);
+    // 6 left in the first slab: the next run of 10 starts on the second
+    StatePool_Handle_t run = StatePool_AllocRun(&p, 10);
+    assert(run == SLAB);
+    uint8_t *first = (uint8_t *)StatePool_Get(&p, run);
+    for (uint32_t j = 0; j < 10; j++) {
+        assert((uint8_t *)StatePool_Get(&p, run + j) == first + j * p.stride);
+    }
+    assert(p.used == 20);
+    // The six skipped slots go to single allocations
+    int seen[SLAB] = { 0 };
+    for (uint32_t k = 0; k < 6; k++) {
+        StatePool_Handle_t h = StatePool_Alloc(&p);
+        assert(h >= 10 && h < SLAB && !seen[h]);
+        seen[h] = 1;
+    }
+    CHECK(StatePool_Alloc(&p) == SLAB + 10);               // then fresh slots again
+
+    // Runs up to the end: the last slab holds CAPACITY % SLAB = 4
+    StatePool_Free(&p);
+    CHECK(StatePool_Init(&p, SIZE, SLAB, CAPACITY) == 0);
+    for (uint32_t r = 0; r < CAPACITY / SLAB; r++) {
+        CHECK(StatePool_AllocRun(&p, SLAB) == r * SLAB);
+    }
+    CHECK(StatePool_AllocRun(&p, 5) == STATE_POOL_NONE);
+    CHECK(StatePool_AllocRun(&p, 4) == (CAPACITY / SLAB) * SLAB);
+    assert(p.used == CAPACITY);
+    StatePool_Free(&p);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== State Pool Test ===\n\n");
+
+    test_init();
+    test_alloc();
+    test_runs();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
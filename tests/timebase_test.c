@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "../Core/Inc/timebase.h"
+#include "../Core/Inc/ppg_filter.h"
+#include "../Core/Inc/ppg_algorithm.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static uint32_t lcg_state = 12345u;
+
+static uint32_t lcg_next(uint32_t range) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (lcg_state >> 8) % range;
+}
+
+static void test_compose(void) {
+    printf("=== Timebase Compose Test ===\n");
+    assert(Timebase_Compose(0, 0, 0) == 0);
+    assert(Timebase_Compose(3, 1234, 0) == 3u * 65536u + 1234u);
+    // Counter wrapped before the ISR ran: count is small, overflow must be added
+    assert(Timebase_Compose(3, 5, 1) == 4u * 65536u + 5u);
+    // Counter read just before the wrap, flag set afterwards: no extra overflow
+    assert(Timebase_Compose(3, 65530, 1) == 3u * 65536u + 65530u);
+    // Past the 32-bit microsecond range (71.6 minutes)
+    assert(Timebase_Compose(0x20000u, 0, 0) == 0x200000000ull);
+    printf("  PASSED\n\n");
+}
+
+/*
+ * Simulated sensor: samples are produced every 1e6/true_hz us; the main loop
+ * polls the FIFO at irregular intervals (a busy loop iteration, or an OLED
+ * refresh of up to 60 ms) and reads the pointers with some extra latency.
+ */
+typedef struct {
+    double true_hz;
+    uint64_t now_us;
+    uint64_t produced;              // samples produced so far
+    uint64_t consumed;              // samples read so far
+    uint64_t first_sample_us;       // time of sample 0
+} SensorSim_t;
+
+static uint8_t sim_poll(SensorSim_t *sim, uint64_t *arrival_us, uint8_t *lost) {
+    sim->now_us += 2000 + lcg_next(60000);
+    double period = 1e6 / sim->true_hz;
+    sim->produced = (uint64_t)((double)(sim->now_us - sim->first_sample_us) / period) + 1;
+    uint64_t pending = sim->produced - sim->consumed;
+    *lost = 0;
+    if (pending > 32) {
+        *lost = (uint8_t)(pending - 32);
+        sim->consumed += pending - 32;
+        pending = 32;
+    }
+    *arrival_us = sim->now_us + lcg_next(500);      // pointer read latency
+    sim->consumed += pending;
+    return (uint8_t)pending;
+}
+
+static void test_rate_estimate(void) {
+    printf("=== Sample Rate Estimate Test ===\n");
+
+    SensorSim_t sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.true_hz = 99.2;             // -0.8% oscillator error
+    sim.first_sample_us = 1000;
+
+    SampleClock_t clk;
+    SampleClock_Init(&clk);
+    assert(!SampleClock_IsValid(&clk));
+    assert(SampleClock_GetRate(&clk) == SAMPLE_CLOCK_NOMINAL_HZ);
+
+    uint32_t updates = 0;
+    uint64_t last_ts = 0;
+    double max_ts_error = 0.0;
+    while (sim.now_us < 180000000ull) {
+        uint64_t arrival;
+        uint8_t lost;
+        uint64_t first_index = sim.consumed;
+        uint8_t count = sim_poll(&sim, &arrival, &lost);
+        first_index += lost;
+        if (count == 0) {
+            continue;
+        }
+        updates += SampleClock_AddBurst(&clk, arrival, count, lost);
+        for (uint8_t i = 0; i < count; i++) {
+            uint64_t ts = SampleClock_SampleTime(&clk, arrival, count, i);
+            assert(ts > last_ts);
+            last_ts = ts;
+            if (SampleClock_IsValid(&clk)) {
+                double truth = sim.first_sample_us + (double)(first_index + i) * 1e6 / sim.true_hz;
+                double err = fabs((double)ts - truth);
+                if (err > max_ts_error) max_ts_error = err;
+            }
+        }
+    }
+
+    float rate = SampleClock_GetRate(&clk);
+    printf("  estimated %.3f Hz (true %.3f Hz), %u window updates, max timestamp error %.2f ms\n",
+           rate, sim.true_hz, updates, max_ts_error / 1000.0);
+    assert(SampleClock_IsValid(&clk));
+    assert(updates >= 4);
+    assert(fabs(rate - sim.true_hz) / sim.true_hz < 0.002);
+    // Timestamps are arrival-based: off by at most the poll latency and a sample period
+    assert(max_ts_error < 15000.0);
+    printf("  PASSED\n\n");
+}
+
+static void test_overflow_counted(void) {
+    printf("=== Lost Samples Test ===\n");
+
+    // Same clock, but the loop is slow enough that the FIFO overflows regularly
+    SampleClock_t clk;
+    SampleClock_Init(&clk);
+    uint64_t t = 0;
+    uint32_t lost_total = 0;
+    for (uint32_t burst = 0; burst < 200; burst++) {
+        t += 400000;                                // 40 samples per 400 ms at 100 Hz
+        uint8_t lost = (burst == 0) ? 0 : 8;
+        lost_total += lost;
+        SampleClock_AddBurst(&clk, t, 32, lost);
+    }
+    printf("  %u lost samples, estimated %.3f Hz\n", lost_total, SampleClock_GetRate(&clk));
+    assert(SampleClock_IsValid(&clk));
+    assert(fabsf(SampleClock_GetRate(&clk) - 100.0f) < 0.01f);
+    printf("  PASSED\n\n");
+}
+
+static void test_implausible_rate_rejected(void) {
+    printf("=== Implausible Rate Test ===\n");
+
+    // Every burst 25 samples per 250 ms, except far too few: 80 Hz
+    SampleClock_t clk;
+    SampleClock_Init(&clk);
+    uint64_t t = 0;
+    for (uint32_t burst = 0; burst < 500; burst++) {
+        t += 250000;
+        SampleClock_AddBurst(&clk, t, 20, 0);
+    }
+    assert(!SampleClock_IsValid(&clk));
+    assert(SampleClock_GetRate(&clk) == SAMPLE_CLOCK_NOMINAL_HZ);
+    printf("  PASSED\n\n");
+}
+
+/**
+ * Final Method 1 heart rate for a fixed 120 bpm signal that the sensor
+ * actually samples at true_hz, with the algorithm told told_hz (0 = default).
+ */
+static float run_method1(double true_hz, float told_hz) {
+    static PPG_FilterState_t ir_filter;
+    static HR_State_t hr_state;
+    PPG_Filter_Init(&ir_filter);
+    HR_Init(&hr_state);
+    if (told_hz > 0.0f) {
+        HR_SetSampleRate(&hr_state, told_hz);
+    }
+
+    float hr = 0.0f;
+    for (uint32_t i = 0; i < 12000; i++) {
+        double t = (double)i / true_hz;
+        double pulse = sin(2.0 * M_PI * 2.0 * t) + 0.3 * sin(4.0 * M_PI * 2.0 * t + 0.8);
+        uint32_t raw_ir = (uint32_t)(120000.0 + 3000.0 * pulse);
+        float ac_ir = PPG_Filter_Process(&ir_filter, raw_ir);
+        HR_AddSample(&hr_state, ac_ir, PPG_Filter_GetDC(&ir_filter));
+        if ((i + 1) % 250 == 0) {
+            hr = HR_Calculate(&hr_state);
+        }
+    }
+    assert(HR_IsValid(&hr_state));
+    return hr;
+}
+
+static void test_hr_uses_sample_rate(void) {
+    printf("=== HR Sample Rate Correction Test ===\n");
+
+    // Identical samples: only the interval -> bpm conversion differs, so the
+    // settled heart rate scales with the sample rate the algorithm is given
+    const double true_hz = 97.0;
+    float nominal = run_method1(true_hz, 0.0f);
+    float corrected = run_method1(true_hz, (float)true_hz);
+    float ratio = corrected / nominal;
+    printf("  sampled at %.1f Hz: assuming 100 Hz %.2f bpm, with measured rate %.2f bpm (ratio %.4f)\n",
+           true_hz, nominal, corrected, ratio);
+    assert(fabsf(ratio - (float)true_hz / HR_SAMPLE_RATE_HZ) < 0.003f);
+
+    // Non-positive rates are ignored
+    HR_State_t hr_state;
+    HR_Init(&hr_state);
+    assert(hr_state.sample_rate_hz == HR_SAMPLE_RATE_HZ);
+    HR_SetSampleRate(&hr_state, 0.0f);
+    assert(hr_state.sample_rate_hz == HR_SAMPLE_RATE_HZ);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Timebase Test Harness ===\n\n");
+
+    test_compose();
+    test_rate_estimate();
+    test_overflow_counted();
+    test_implausible_rate_rejected();
+    test_hr_uses_sample_rate();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
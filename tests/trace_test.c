@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "../Core/Inc/trace.h"
+#include "../Core/Inc/telemetry.h"
+
+// Simulated DWT->CYCCNT: every read advances the counter by a fixed step
+static uint32_t fake_cycles = 0xFFFFFF00u;      // start close to wraparound
+static const uint32_t step = 40;
+
+uint32_t Trace_HostCycles(void) {
+    fake_cycles += step;
+    return fake_cycles;
+}
+
+static uint8_t stream[8192];
+static size_t stream_len = 0;
+
+static void capture_tx(const uint8_t *data, uint16_t len) {
+    assert(stream_len + len <= sizeof(stream));
+    memcpy(&stream[stream_len], data, len);
+    stream_len += len;
+}
+
+// Reassembled dump
+static Trace_Record_t dumped[TRACE_BUFFER_SIZE];
+static Trace_DumpFrame_t dump_header;
+static uint32_t dump_frames;
+static uint16_t dumped_count;
+
+static void parse_dump(void) {
+    static TLM_Parser_t parser;
+    Trace_DumpFrame_t frame;
+
+    TLM_Parser_Init(&parser);
+    dump_frames = 0;
+    dumped_count = 0;
+    for (size_t i = 0; i < stream_len; i++) {
+        if (!TLM_Parser_Feed(&parser, stream[i])) {
+            continue;
+        }
+        assert(parser.type == TLM_TYPE_TRACE);
+        assert(parser.len <= TLM_MAX_PAYLOAD);
+        CHECK(Trace_DecodeFrame(parser.payload, parser.len, &frame) == 0);
+        if (dump_frames == 0) {
+            dump_header = frame;
+        }
+        assert(frame.dump_id == dump_header.dump_id);
+        assert(frame.total == dump_header.total);
+        assert(frame.first == dumped_count);
+        memcpy(&dumped[dumped_count], frame.records, frame.count * sizeof(Trace_Record_t));
+        dumped_count = (uint16_t)(dumped_count + frame.count);
+        dump_frames++;
+    }
+    assert(parser.crc_errors == 0);
+    assert(dumped_count == dump_header.total);
+}
+
+static void test_event_tables(void) {
+    printf("=== Event Table Test ===\n");
+    for (uint8_t id = 0; id < TRACE_EV_COUNT; id++) {
+        char ph = Trace_EventPhase(id);
+        assert(ph == 'B' || ph == 'E' || ph == 'i');
+        assert(strcmp(Trace_EventName(id), "unknown") != 0);
+        // A span end directly follows its begin and shares the name
+        if (ph == 'E') {
+            assert(Trace_EventPhase(id - 1) == 'B');
+            assert(strcmp(Trace_EventName(id), Trace_EventName(id - 1)) == 0);
+        }
+    }
+    assert(strcmp(Trace_EventName(TRACE_EV_COUNT), "unknown") == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_dump_in_order(void) {
+    printf("=== Dump Order Test ===\n");
+
+    Trace_Init();
+    TLM_Init(capture_tx);
+    for (uint32_t i = 0; i < 10; i++) {
+        TRACE_EVENT(TRACE_EV_MARK, i);
+    }
+
+    stream_len = 0;
+    CHECK(Trace_Dump(TRACE_REASON_REQUEST) == 0);
+    parse_dump();
+    assert(dump_frames == 1);
+    assert(dump_header.reason == TRACE_REASON_REQUEST);
+    assert(dump_header.total == 10 && dump_header.written == 10);
+    assert(dump_header.cpu_hz == 72000000u);
+    for (uint16_t i = 0; i < 10; i++) {
+        assert(dumped[i].id == TRACE_EV_MARK && dumped[i].arg == i);
+        // Timestamps cross the 32-bit wrap; differences stay exact
+        if (i > 0) {
+            assert((uint32_t)(dumped[i].timestamp - dumped[i - 1].timestamp) == step);
+        }
+    }
+
+    // Recording resumes after the dump, with the next dump id
+    TRACE_EVENT(TRACE_EV_BEAT, 99);
+    assert(trace_buffer.written == 11);
+    stream_len = 0;
+    Trace_Dump(TRACE_REASON_REQUEST);
+    parse_dump();
+    assert(dump_header.dump_id == 1);
+    assert(dumped[10].id == TRACE_EV_BEAT && dumped[10].arg == 99);
+    printf("  PASSED\n\n");
+}
+
+static void test_wraparound(void) {
+    printf("=== Ring Wraparound Test ===\n");
+
+    Trace_Init();
+    const uint32_t n = 3 * TRACE_BUFFER_SIZE + 5;
+    for (uint32_t i = 0; i < n; i++) {
+        TRACE_EVENT((i & 1) ? TRACE_EV_FIFO_READ_END : TRACE_EV_FIFO_READ_BEGIN, i);
+    }
+
+    stream_len = 0;
+    Trace_Dump(TRACE_REASON_STALL);
+    parse_dump();
+    assert(dump_header.reason == TRACE_REASON_STALL);
+    assert(dump_header.total == TRACE_BUFFER_SIZE);
+    assert(dump_header.written == n);
+    // Only the newest TRACE_BUFFER_SIZE records, oldest first
+    for (uint16_t i = 0; i < TRACE_BUFFER_SIZE; i++) {
+        assert(dumped[i].arg == n - TRACE_BUFFER_SIZE + i);
+    }
+    uint32_t expected_frames = (TRACE_BUFFER_SIZE + TRACE_RECORDS_PER_FRAME - 1) / TRACE_RECORDS_PER_FRAME;
+    assert(dump_frames == expected_frames);
+    printf("  %u records in %u frames\n", dumped_count, dump_frames);
+    printf("  PASSED\n\n");
+}
+
+static void test_empty_dump(void) {
+    printf("=== Empty Dump Test ===\n");
+
+    Trace_Init();
+    stream_len = 0;
+    Trace_Dump(TRACE_REASON_REQUEST);
+    parse_dump();
+    assert(dump_frames == 1);
+    assert(dump_header.total == 0 && dump_header.written == 0);
+    printf("  PASSED\n\n");
+}
+
+static void test_fault_freezes(void) {
+    printf("=== Fault Freeze Test ===\n");
+
+    Trace_Init();
+    TRACE_EVENT(TRACE_EV_HR_UPDATE, 723);
+    stream_len = 0;
+    Trace_Fault(TRACE_REASON_HARDFAULT);
+    parse_dump();
+    assert(dump_header.reason == TRACE_REASON_HARDFAULT);
+    assert(dump_header.total == 2);
+    assert(dumped[1].id == TRACE_EV_FAULT && dumped[1].arg == TRACE_REASON_HARDFAULT);
+
+    // Frozen: later events are dropped and a second dump shows the same state
+    TRACE_EVENT(TRACE_EV_MARK, 1);
+    assert(trace_buffer.written == 2);
+    stream_len = 0;
+    Trace_Dump(TRACE_REASON_REQUEST);
+    parse_dump();
+    assert(dump_header.total == 2 && dumped[0].arg == 723);
+    assert(trace_buffer.frozen);
+    printf("  PASSED\n\n");
+}
+
+static void test_decode_rejects(void) {
+    printf("=== Decode Validation Test ===\n");
+
+    uint8_t payload[TRACE_DUMP_HEADER + TRACE_WIRE_RECORD_SIZE];
+    Trace_DumpFrame_t frame;
+    memset(payload, 0, sizeof(payload));
+    payload[0] = TRACE_DUMP_VERSION;
+    payload[8] = 1;                                         // total = 1
+    CHECK(Trace_DecodeFrame(payload, sizeof(payload), &frame) == 0);
+    assert(frame.count == 1);
+
+    CHECK(Trace_DecodeFrame(payload, sizeof(payload) - 1, &frame) != 0);  // partial record
+    CHECK(Trace_DecodeFrame(payload, TRACE_DUMP_HEADER - 1, &frame) != 0);
+    payload[10] = 1;                                        // first + count > total
+    CHECK(Trace_DecodeFrame(payload, sizeof(payload), &frame) != 0);
+    payload[10] = 0;
+    payload[0] = TRACE_DUMP_VERSION + 1;
+    CHECK(Trace_DecodeFrame(payload, sizeof(payload), &frame) != 0);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Event Trace Test Harness ===\n\n");
+
+    test_event_tables();
+    test_dump_in_order();
+    test_wraparound();
+    test_empty_dump();
+    test_fault_freezes();
+    test_decode_rejects();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}
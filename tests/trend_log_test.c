@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "check.h"
+#include "../Core/Inc/trend_log.h"
+#include "../Core/Inc/telemetry.h"
+#include "../host/inc/flash_sim.h"
+
+#define FLASH_BASE      0x0800C000u
+#define PAGE_SIZE       1024
+#define PAGE_COUNT      16          // same 16KB region as the firmware linker script
+#define MAX_RECORDS     40000
+#define STREAM_CAPACITY (PAGE_SIZE * PAGE_COUNT * 2)
+
+// Records handed to TrendLog_Append (reference) and records read back
+static TrendLog_Record_t written[MAX_RECORDS];
+static uint32_t written_count = 0;
+static TrendLog_Record_t readback[MAX_RECORDS];
+static uint32_t readback_count = 0;
+static uint32_t pages_torn = 0;
+static uint32_t pages_corrupt = 0;
+
+// Captured telemetry stream of TrendLog_Dump
+static uint8_t stream[STREAM_CAPACITY];
+static size_t stream_len = 0;
+
+static void capture_tx(const uint8_t *data, uint16_t len) {
+    assert(stream_len + len <= STREAM_CAPACITY);
+    memcpy(&stream[stream_len], data, len);
+    stream_len += len;
+}
+
+// Slowly varying vital signs with occasional jumps, dropouts and gaps
+static void make_record(TrendLog_Record_t *rec, uint16_t session, uint32_t t) {
+    rec->session = session;
+    rec->time = t;
+    rec->hr = (uint8_t)(72.0f + 15.0f * sinf((float)t / 300.0f) + (float)(t % 3));
+    rec->spo2 = (uint8_t)(97 - (t / 7) % 3);
+    rec->sqi = (uint8_t)((t / 50) % 4);
+    rec->flags = TREND_FLAG_HR_VALID | TREND_FLAG_SPO2_VALID;
+    if (t % 211 == 0) {
+        rec->hr = (uint8_t)(rec->hr + 45);      // motion artefact: forces a full record
+    }
+    if (t % 600 < 4) {
+        rec->hr = 0;                            // finger lifted
+        rec->spo2 = 0;
+        rec->sqi = 0;
+        rec->flags = TREND_FLAG_NO_FINGER;
+    }
+}
+
+static uint8_t append(TrendLog_t *log, uint16_t session, uint32_t t) {
+    TrendLog_Record_t rec;
+    make_record(&rec, session, t);
+    uint8_t err = TrendLog_Append(log, t, rec.hr, rec.spo2, rec.sqi, rec.flags);
+    if (err == 0) {
+        assert(written_count < MAX_RECORDS);
+        written[written_count++] = rec;
+    }
+    return err;
+}
+
+static void collect_record(const TrendLog_Record_t *rec, void *ctx) {
+    (void)ctx;
+    assert(readback_count < MAX_RECORDS);
+    readback[readback_count++] = *rec;
+}
+
+// Read the log out over telemetry and decode it the way host/apps/trend_log_decode.c does
+static void dump_and_decode(TrendLog_t *log) {
+    static TLM_Parser_t parser;
+    static uint8_t page[PAGE_SIZE];
+
+    stream_len = 0;
+    TLM_Init(capture_tx);
+    CHECK(TrendLog_Dump(log) == 0);
+
+    readback_count = 0;
+    pages_torn = 0;
+    pages_corrupt = 0;
+    TLM_Parser_Init(&parser);
+    uint32_t last_seq = 0;
+    for (size_t i = 0; i < stream_len; i++) {
+        if (!TLM_Parser_Feed(&parser, stream[i]) || parser.type != TLM_TYPE_TREND_LOG) {
+            continue;
+        }
+        const uint8_t *p = parser.payload;
+        uint32_t seq = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        uint16_t offset = (uint16_t)(p[4] | (p[5] << 8));
+        uint16_t total = (uint16_t)(p[6] | (p[7] << 8));
+        uint16_t n = (uint16_t)(parser.len - TREND_LOG_DUMP_HEADER);
+        assert(total <= PAGE_SIZE && offset + n <= total);
+        memcpy(&page[offset], &p[TREND_LOG_DUMP_HEADER], n);
+
+        if (offset + n == total) {
+            TrendLog_PageInfo_t info;
+            assert(seq > last_seq);     // pages arrive oldest first
+            last_seq = seq;
+            CHECK(TrendLog_DecodePage(page, total, &info, collect_record, NULL) == 0);
+            assert(info.seq == seq);
+            assert(info.used == total || info.torn || info.corrupt);
+            pages_torn += info.torn;
+            pages_corrupt += info.corrupt;
+        }
+    }
+    assert(parser.crc_errors == 0);
+}
+
+static int same_record(const TrendLog_Record_t *a, const TrendLog_Record_t *b) {
+    return a->session == b->session && a->time == b->time && a->hr == b->hr &&
+           a->spo2 == b->spo2 && a->sqi == b->sqi && a->flags == b->flags;
+}
+
+static void test_roundtrip(void) {
+    printf("=== Round-Trip Test ===\n");
+
+    FlashSim_t sim;
+    TrendLog_Flash_t flash;
+    TrendLog_t log;
+    CHECK(FlashSim_Init(&sim, FLASH_BASE, PAGE_SIZE, PAGE_COUNT) == 0);
+    FlashSim_Backend(&sim, &flash);
+    written_count = 0;
+
+    CHECK(TrendLog_Mount(&log, &flash) == 0);
+    assert(log.session == 1);
+    for (uint32_t t = 0; t < 3000; t++) {
+        CHECK(append(&log, log.session, t) == 0);
+    }
+    // A gap longer than the delta field starts a new page with its own base time
+    for (uint32_t t = 6000; t < 6100; t++) {
+        CHECK(append(&log, log.session, t) == 0);
+    }
+
+    dump_and_decode(&log);
+    assert(readback_count == written_count);
+    for (uint32_t i = 0; i < written_count; i++) {
+        assert(same_record(&readback[i], &written[i]));
+    }
+    assert(pages_torn == 0 && pages_corrupt == 0);
+    assert(sim.program_errors == 0);
+    printf("  %u records in %u pages, %.2f bytes/record\n", written_count, log.erases,
+           (double)(log.erases * (PAGE_SIZE - TREND_LOG_HEADER_SIZE)) / written_count);
+
+    FlashSim_Free(&sim);
+    printf("  PASSED\n\n");
+}
+
+static void test_sessions(void) {
+    printf("=== Reboot / Session Test ===\n");
+
+    FlashSim_t sim;
+    TrendLog_Flash_t flash;
+    TrendLog_t log;
+    CHECK(FlashSim_Init(&sim, FLASH_BASE, PAGE_SIZE, PAGE_COUNT) == 0);
+    FlashSim_Backend(&sim, &flash);
+    written_count = 0;
+
+    for (uint16_t boot = 1; boot <= 5; boot++) {
+        CHECK(TrendLog_Mount(&log, &flash) == 0);
+        assert(log.session == boot);
+        for (uint32_t t = 0; t < 200; t++) {
+            CHECK(append(&log, log.session, t) == 0);
+        }
+    }
+
+    dump_and_decode(&log);
+    assert(readback_count == written_count);
+    for (uint32_t i = 0; i < written_count; i++) {
+        assert(same_record(&readback[i], &written[i]));
+    }
+
+    // Format wipes everything and restarts the session numbering
+    CHECK(TrendLog_Format(&log) == 0);
+    assert(log.session == 1);
+    dump_and_decode(&log);
+    assert(readback_count == 0);
+
+    FlashSim_Free(&sim);
+    printf("  PASSED\n\n");
+}
+
+static void test_wraparound(void) {
+    printf("=== Wraparound / Wear Levelling Test ===\n");
+
+    FlashSim_t sim;
+    TrendLog_Flash_t flash;
+    TrendLog_t log;
+    CHECK(FlashSim_Init(&sim, FLASH_BASE, PAGE_SIZE, PAGE_COUNT) == 0);
+    FlashSim_Backend(&sim, &flash);
+    written_count = 0;
+
+    // 10 hours at one record per second
+    CHECK(TrendLog_Mount(&log, &flash) == 0);
+    for (uint32_t t = 0; t < 36000; t++) {
+        CHECK(append(&log, log.session, t) == 0);
+    }
+
+    dump_and_decode(&log);
+    assert(readback_count > 0 && readback_count < written_count);
+
+    // What survives is exactly the newest part of the history, without holes
+    uint32_t first = written_count - readback_count;
+    for (uint32_t i = 0; i < readback_count; i++) {
+        assert(same_record(&readback[i], &written[first + i]));
+    }
+
+    double hours = readback_count / 3600.0;
+    printf("  retained %u records = %.2f hours in %u KB (capacity estimate %u)\n",
+           readback_count, hours, PAGE_SIZE * PAGE_COUNT / 1024, TrendLog_Capacity(&flash));
+    assert(hours >= 2.0);
+
+    uint32_t min_erase = sim.erase_counts[0], max_erase = sim.erase_counts[0];
+    for (uint16_t p = 1; p < PAGE_COUNT; p++) {
+        if (sim.erase_counts[p] < min_erase) min_erase = sim.erase_counts[p];
+        if (sim.erase_counts[p] > max_erase) max_erase = sim.erase_counts[p];
+    }
+    printf("  erase counts per page: min %u, max %u\n", min_erase, max_erase);
+    assert(max_erase - min_erase <= 1);
+
+    // Remount after wraparound continues after the newest page
+    uint32_t next_seq = log.next_seq;
+    CHECK(TrendLog_Mount(&log, &flash) == 0);
+    assert(log.next_seq == next_seq);
+    assert(log.session == 2);
+
+    FlashSim_Free(&sim);
+    printf("  PASSED\n\n");
+}
+
+static void test_power_cut(void) {
+    printf("=== Power Cut / Torn Write Test ===\n");
+
+    uint32_t torn_seen = 0;
+    for (uint32_t iter = 0; iter < 400; iter++) {
+        FlashSim_t sim;
+        TrendLog_Flash_t flash;
+        TrendLog_t log;
+        // Small region so that cuts also hit page erases and header writes
+        CHECK(FlashSim_Init(&sim, FLASH_BASE, 256, 4) == 0);
+        FlashSim_Backend(&sim, &flash);
+        written_count = 0;
+
+        CHECK(TrendLog_Mount(&log, &flash) == 0);
+        uint32_t t = 0;
+        uint32_t prefill = (uint32_t)(rand() % 300);
+        for (; t < prefill; t++) {
+            CHECK(append(&log, 1, t) == 0);
+        }
+
+        // Power fails somewhere in the next 200 flash operations
+        FlashSim_SchedulePowerCut(&sim, 1 + (uint32_t)(rand() % 200), (uint32_t)rand() + 1);
+        while (append(&log, 1, t) == 0) {
+            t++;
+        }
+        uint32_t committed = written_count;     // appends that completed before the cut
+
+        FlashSim_PowerOn(&sim);
+        CHECK(TrendLog_Mount(&log, &flash) == 0);
+        assert(log.session == 2);
+        for (uint32_t t2 = 0; t2 < 40; t2++) {
+            CHECK(append(&log, 2, t2) == 0);
+        }
+
+        dump_and_decode(&log);
+        torn_seen += pages_torn;
+
+        // Session 2 must be complete and intact
+        uint32_t s1 = 0;
+        while (s1 < readback_count && readback[s1].session == 1) {
+            s1++;
+        }
+        assert(readback_count - s1 == 40);
+        for (uint32_t i = 0; i < 40; i++) {
+            assert(same_record(&readback[s1 + i], &written[committed + i]));
+        }
+
+        // Session 1: a hole-free run ending with the last committed record;
+        // only the record being written at the cut may follow it (possibly damaged)
+        uint32_t k = s1;
+        if (k > 0 && committed > 0 && !same_record(&readback[k - 1], &written[committed - 1])) {
+            k--;
+        }
+        assert(committed == 0 || k > 0);
+        assert(k <= committed);
+        for (uint32_t i = 0; i < k; i++) {
+            assert(same_record(&readback[i], &written[committed - k + i]));
+        }
+        FlashSim_Free(&sim);
+    }
+    printf("  400 power cuts survived, %u torn records detected\n", torn_seen);
+    printf("  PASSED\n\n");
+}
+
+int main() {
+    printf("=== Trend Log Test Harness ===\n\n");
+    srand(2024);
+
+    test_roundtrip();
+    test_sessions();
+    test_wraparound();
+    test_power_cut();
+
+    printf("=== All Tests Passed! ===\n");
+    return 0;
+}